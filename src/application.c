@@ -24,6 +24,7 @@
 #include <stdlib.h>
 
 #include "about.h"
+#include "batch.h"
 #include "charset.h"
 #include "easytag.h"
 #include "log.h"
@@ -42,6 +43,9 @@ static const GOptionEntry entries[] =
 {
     { "version", 'v', 0, G_OPTION_ARG_NONE, NULL,
       N_("Print the version and exit"), NULL },
+    { "batch", 0, 0, G_OPTION_ARG_NONE, NULL,
+      N_("Tag and rename files without the user interface, see --batch --help"),
+      NULL },
     { NULL }
 };
 
@@ -302,6 +306,14 @@ et_application_local_command_line (GApplication *application,
     guint n_args;
     gchar **argv;
 
+    /* Batch mode runs in the local instance, before registering, as it must
+     * not need a display. */
+    if (et_batch_is_requested (*arguments))
+    {
+        *exit_status = et_batch_run (*arguments);
+        return TRUE;
+    }
+
     /* Try to register. */
     if (!g_application_register (application, NULL, &error))
     {
@@ -507,6 +519,7 @@ static void
 et_application_shutdown (GApplication *application)
 {
     Charset_Insert_Locales_Destroy ();
+    et_log_shutdown ();
 
     G_APPLICATION_CLASS (et_application_parent_class)->shutdown (application);
 }
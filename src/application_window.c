@@ -331,8 +331,7 @@ delete_file (ET_File *ETFile, gboolean multiple_files, GError **error)
 {
     GtkWidget *msgdialog;
     GtkWidget *msgdialog_check_button = NULL;
-    const gchar *cur_filename;
-    const gchar *cur_filename_utf8;
+    const File_Name *FileNameCur;
     gchar *basename_utf8;
     gint response;
     gint stop_loop;
@@ -341,9 +340,8 @@ delete_file (ET_File *ETFile, gboolean multiple_files, GError **error)
     g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
     /* Filename of the file to delete. */
-    cur_filename      = ((File_Name *)(ETFile->FileNameCur)->data)->value;
-    cur_filename_utf8 = ((File_Name *)(ETFile->FileNameCur)->data)->value_utf8;
-    basename_utf8 = g_path_get_basename (cur_filename_utf8);
+    FileNameCur = (File_Name *)ETFile->FileNameCur->data;
+    basename_utf8 = g_strdup (FileNameCur->name_utf8);
 
     /*
      * Remove the file
@@ -401,8 +399,11 @@ delete_file (ET_File *ETFile, gboolean multiple_files, GError **error)
     {
         case GTK_RESPONSE_YES:
         {
+            gchar *cur_filename = et_file_name_get_path (FileNameCur);
             GFile *cur_file = g_file_new_for_path (cur_filename);
 
+            g_free (cur_filename);
+
             if (g_file_delete (cur_file, NULL, error))
             {
                 gchar *msg = g_strdup_printf(_("File ‘%s’ deleted"), basename_utf8);
@@ -572,6 +573,7 @@ on_delete (GSimpleAction *action,
                 /* Remove file in the browser (corresponding line in the
                  * clist). */
                 et_browser_remove_file (ET_BROWSER (priv->browser), ETFile);
+                et_application_window_search_dialog_remove_file (self, ETFile);
                 /* Remove file from file list. */
                 ET_Remove_File_From_File_List (ETFile);
                 break;
@@ -1449,8 +1451,9 @@ run_audio_player_using_directory (GError **error)
     for (l = ETCore->ETFileList; l != NULL; l = g_list_next (l))
     {
         ET_File *etfile = (ET_File *)l->data;
-        const gchar *path = ((File_Name *)etfile->FileNameCur->data)->value;
+        gchar *path = et_file_name_get_path ((File_Name *)etfile->FileNameCur->data);
         file_list = g_list_prepend (file_list, g_file_new_for_path (path));
+        g_free (path);
     }
 
     file_list = g_list_reverse (file_list);
@@ -1762,6 +1765,38 @@ et_application_window_scan_dialog_update_previews (EtApplicationWindow *self)
     }
 }
 
+void
+et_application_window_search_dialog_clear (EtApplicationWindow *self)
+{
+    EtApplicationWindowPrivate *priv;
+
+    g_return_if_fail (self != NULL);
+
+    priv = et_application_window_get_instance_private (self);
+
+    if (priv->search_dialog)
+    {
+        et_search_dialog_clear (ET_SEARCH_DIALOG (priv->search_dialog));
+    }
+}
+
+void
+et_application_window_search_dialog_remove_file (EtApplicationWindow *self,
+                                                 const ET_File *ETFile)
+{
+    EtApplicationWindowPrivate *priv;
+
+    g_return_if_fail (self != NULL);
+
+    priv = et_application_window_get_instance_private (self);
+
+    if (priv->search_dialog)
+    {
+        et_search_dialog_remove_file (ET_SEARCH_DIALOG (priv->search_dialog),
+                                      ETFile);
+    }
+}
+
 void
 et_application_window_progress_set_fraction (EtApplicationWindow *self,
                                              gdouble fraction)
@@ -1999,7 +2034,7 @@ et_application_window_update_file_name_from_ui (EtApplicationWindow *self,
     }
 
     /* Get the current path to the file. */
-    dirname = g_path_get_dirname (((File_Name *)ETFile->FileNameNew->data)->value);
+    dirname = et_file_name_get_dirname ((File_Name *)ETFile->FileNameNew->data);
 
     /* Convert filename extension (lower or upper). */
     extension = ET_File_Format_File_Extension (ETFile);
@@ -2017,7 +2052,7 @@ et_application_window_update_file_name_from_ui (EtApplicationWindow *self,
     {
         /* Keep the 'last' filename (if a 'blank' filename was entered in the
          * fileentry for example). */
-        filename_new = g_path_get_basename (((File_Name *)ETFile->FileNameNew->data)->value);
+        filename_new = g_strdup (((File_Name *)ETFile->FileNameNew->data)->name);
     }
 
     g_free (filename);
@@ -2039,7 +2074,6 @@ et_application_window_update_et_file_from_ui (EtApplicationWindow *self)
     ET_File *et_file;
     File_Name *FileName;
     File_Tag  *FileTag;
-    const gchar *cur_filename_utf8;
 
     if (!ETCore->ETFileDisplayed)
     {
@@ -2052,7 +2086,6 @@ et_application_window_update_et_file_from_ui (EtApplicationWindow *self)
                       && et_file->FileNameCur->data != NULL);
 
     /* Save the current displayed data */
-    cur_filename_utf8 = ((File_Name *)((GList *)et_file->FileNameCur)->data)->value_utf8;
     description = et_file->ETFileDescription;
 
     /* Save filename and generate undo for filename. */
@@ -2103,11 +2136,16 @@ et_application_window_update_et_file_from_ui (EtApplicationWindow *self)
 #endif
         case UNKNOWN_TAG:
         default:
+        {
+            gchar *cur_filename_utf8 = et_file_name_get_path_utf8 ((File_Name *)et_file->FileNameCur->data);
+
             FileTag = et_file_tag_new ();
             Log_Print (LOG_ERROR,
                        "FileTag: Undefined tag type %d for file %s.",
                        (gint)description->TagType, cur_filename_utf8);
+            g_free (cur_filename_utf8);
             break;
+        }
     }
 
     /*
@@ -2136,18 +2174,15 @@ static void
 et_application_window_display_file_name (EtApplicationWindow *self,
                                          const ET_File *ETFile)
 {
-    const gchar *new_filename_utf8;
     gchar *dirname_utf8;
     gchar *text;
 
     g_return_if_fail (ETFile != NULL);
 
-    new_filename_utf8 = ((File_Name *)((GList *)ETFile->FileNameNew)->data)->value_utf8;
-
     /*
      * Set the path to the file into BrowserEntry (dirbrowser)
      */
-    dirname_utf8 = g_path_get_dirname (new_filename_utf8);
+    dirname_utf8 = et_file_name_get_dirname_utf8 ((File_Name *)ETFile->FileNameNew->data);
     et_application_window_browser_entry_set_text (self, dirname_utf8);
 
     // And refresh the number of files in this directory
@@ -2157,8 +2192,8 @@ et_application_window_display_file_name (EtApplicationWindow *self,
                             et_file_list_get_n_files_in_path (ETCore->ETFileList,
                                                               dirname_utf8));
     et_application_window_browser_label_set_text (self, text);
-    g_free(dirname_utf8);
     g_free(text);
+    g_free (dirname_utf8);
 }
 
 /*
@@ -2218,7 +2253,7 @@ et_application_window_display_et_file (EtApplicationWindow *self,
                                        ET_File *ETFile)
 {
     const ET_File_Description *description;
-    const gchar *cur_filename_utf8;
+    gchar *cur_filename_utf8;
     gchar *msg;
     EtFileHeaderFields *fields;
 
@@ -2226,7 +2261,7 @@ et_application_window_display_et_file (EtApplicationWindow *self,
                       ((GList *)ETFile->FileNameCur)->data != NULL);
                       /* For the case where ETFile is an "empty" structure. */
 
-    cur_filename_utf8 = ((File_Name *)((GList *)ETFile->FileNameCur)->data)->value_utf8;
+    cur_filename_utf8 = et_file_name_get_path_utf8 ((File_Name *)ETFile->FileNameCur->data);
     description = ETFile->ETFileDescription;
 
     /* Save the current displayed file */
@@ -2247,7 +2282,7 @@ et_application_window_display_et_file (EtApplicationWindow *self,
     /* Display file data, header data and file type */
     switch (description->FileType)
     {
-#if defined ENABLE_MP3 && defined ENABLE_ID3LIB
+#ifdef ENABLE_MP3
         case MP3_FILE:
         case MP2_FILE:
             fields = et_mpeg_header_display_file_info_to_ui (ETFile);
@@ -2308,7 +2343,7 @@ et_application_window_display_et_file (EtApplicationWindow *self,
             break;
 #endif
         case OFR_FILE:
-#if !defined ENABLE_MP3 && !defined ENABLE_ID3LIB
+#ifndef ENABLE_MP3
         case MP3_FILE:
         case MP2_FILE:
 #endif
@@ -2345,6 +2380,7 @@ et_application_window_display_et_file (EtApplicationWindow *self,
     msg = g_strdup_printf (_("File: ‘%s’"), cur_filename_utf8);
     et_application_window_status_bar_message (self, msg, FALSE);
     g_free (msg);
+    g_free (cur_filename_utf8);
 }
 
 GFile *
@@ -2904,20 +2940,6 @@ et_application_window_browser_select_file_by_et_file (EtApplicationWindow *self,
                                               select);
 }
 
-GtkTreePath *
-et_application_window_browser_select_file_by_et_file2 (EtApplicationWindow *self,
-                                                       const ET_File *file,
-                                                       gboolean select,
-                                                       GtkTreePath *start_path)
-{
-    EtApplicationWindowPrivate *priv;
-
-    priv = et_application_window_get_instance_private (self);
-
-    return et_browser_select_file_by_et_file2 (ET_BROWSER (priv->browser),
-                                               file, select, start_path);
-}
-
 ET_File *
 et_application_window_browser_select_file_by_dlm (EtApplicationWindow *self,
                                                   const gchar *string,
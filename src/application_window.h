@@ -82,12 +82,13 @@ void et_application_window_browser_select_file_by_iter_string (EtApplicationWind
 void et_application_window_update_et_file_from_ui (EtApplicationWindow *self);
 void et_application_window_display_et_file (EtApplicationWindow *self, ET_File *ETFile);
 void et_application_window_browser_select_file_by_et_file (EtApplicationWindow *self, const ET_File *file, gboolean select);
-GtkTreePath * et_application_window_browser_select_file_by_et_file2 (EtApplicationWindow *self, const ET_File *file, gboolean select, GtkTreePath *start_path);
 ET_File * et_application_window_browser_select_file_by_dlm (EtApplicationWindow *self, const gchar *string, gboolean select);
 void et_application_window_browser_unselect_all (EtApplicationWindow *self);
 void et_application_window_browser_refresh_list (EtApplicationWindow *self);
 void et_application_window_browser_refresh_file_in_list (EtApplicationWindow *self, const ET_File *file);
 void et_application_window_scan_dialog_update_previews (EtApplicationWindow *self);
+void et_application_window_search_dialog_clear (EtApplicationWindow *self);
+void et_application_window_search_dialog_remove_file (EtApplicationWindow *self, const ET_File *ETFile);
 void et_application_window_progress_set_fraction (EtApplicationWindow *self, gdouble fraction);
 void et_application_window_progress_set_text (EtApplicationWindow *self, const gchar *text);
 void et_application_window_status_bar_message (EtApplicationWindow *self, const gchar *message, gboolean with_timer);
@@ -0,0 +1,739 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include "batch.h"
+
+#include <glib/gi18n.h>
+#include <gio/gio.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "file.h"
+#include "file_description.h"
+#include "file_list.h"
+#include "log.h"
+#include "misc.h"
+#include "scan_dialog.h"
+#include "setting.h"
+
+typedef void (*EtBatchFieldSetter) (File_Tag *file_tag, const gchar *value);
+
+/*
+ * The tag fields which may be set with --set, named as in the GSettings keys.
+ */
+static const struct
+{
+    const gchar *name;
+    EtBatchFieldSetter set;
+} batch_fields[] =
+{
+    { "title", et_file_tag_set_title },
+    { "artist", et_file_tag_set_artist },
+    { "album-artist", et_file_tag_set_album_artist },
+    { "album", et_file_tag_set_album },
+    { "disc-number", et_file_tag_set_disc_number },
+    { "disc-total", et_file_tag_set_disc_total },
+    { "year", et_file_tag_set_year },
+    { "track", et_file_tag_set_track_number },
+    { "track-total", et_file_tag_set_track_total },
+    { "genre", et_file_tag_set_genre },
+    { "comment", et_file_tag_set_comment },
+    { "composer", et_file_tag_set_composer },
+    { "orig-artist", et_file_tag_set_orig_artist },
+    { "copyright", et_file_tag_set_copyright },
+    { "url", et_file_tag_set_url },
+    { "encoded-by", et_file_tag_set_encoded_by }
+};
+
+typedef struct
+{
+    EtBatchFieldSetter set;
+    gchar *value;
+} EtBatchField;
+
+typedef struct
+{
+    /* Options. */
+    gchar *fill_mask;
+    gchar *rename_mask;
+    GArray *fields;
+    gboolean dry_run;
+    gboolean show_hidden;
+
+    /* Serializes the lines written to standard output. */
+    GMutex output_lock;
+
+    /* Counters, updated atomically by the worker threads. */
+    gint n_files;
+    gint n_updated;
+    gint n_unchanged;
+    gint n_failed;
+} EtBatch;
+
+/*
+ * batch_append_json_string:
+ * @json: the string to append to
+ * @string: a UTF-8 string
+ *
+ * Append @string to @json as a quoted JSON string.
+ */
+static void
+batch_append_json_string (GString *json,
+                          const gchar *string)
+{
+    const gchar *p;
+
+    g_string_append_c (json, '"');
+
+    for (p = string; *p != '\0'; p++)
+    {
+        switch (*p)
+        {
+            case '"':
+                g_string_append (json, "\\\"");
+                break;
+            case '\\':
+                g_string_append (json, "\\\\");
+                break;
+            case '\n':
+                g_string_append (json, "\\n");
+                break;
+            case '\r':
+                g_string_append (json, "\\r");
+                break;
+            case '\t':
+                g_string_append (json, "\\t");
+                break;
+            default:
+                if ((guchar)*p < 0x20)
+                {
+                    g_string_append_printf (json, "\\u%04x", (guint)*p);
+                }
+                else
+                {
+                    g_string_append_c (json, *p);
+                }
+                break;
+        }
+    }
+
+    g_string_append_c (json, '"');
+}
+
+/*
+ * batch_append_json_member:
+ * @json: the object being built, without its closing brace
+ * @name: the name of the member
+ * @value: (allow-none): a UTF-8 string, or %NULL to skip the member
+ *
+ * Append a string member to the JSON object in @json.
+ */
+static void
+batch_append_json_member (GString *json,
+                          const gchar *name,
+                          const gchar *value)
+{
+    if (value == NULL)
+    {
+        return;
+    }
+
+    g_string_append_printf (json, ",\"%s\":", name);
+    batch_append_json_string (json, value);
+}
+
+/*
+ * batch_print_json:
+ * @batch: the batch
+ * @json: (transfer full): a JSON object, without its closing brace
+ *
+ * Close the object and print it on its own line on standard output. Each line
+ * is flushed, so that the progress can be followed by the calling program.
+ */
+static void
+batch_print_json (EtBatch *batch,
+                  GString *json)
+{
+    g_string_append (json, "}\n");
+
+    g_mutex_lock (&batch->output_lock);
+    fputs (json->str, stdout);
+    fflush (stdout);
+    g_mutex_unlock (&batch->output_lock);
+
+    g_string_free (json, TRUE);
+}
+
+static GString *
+batch_json_new (const gchar *event)
+{
+    GString *json;
+
+    json = g_string_new ("{\"event\":");
+    batch_append_json_string (json, event);
+
+    return json;
+}
+
+/*
+ * batch_report_error:
+ * @batch: the batch
+ * @file: the file or directory which could not be processed
+ * @error: the error
+ *
+ * Print an error which occurred before a file could be loaded.
+ */
+static void
+batch_report_error (EtBatch *batch,
+                    GFile *file,
+                    const GError *error)
+{
+    GString *json;
+    gchar *path;
+    gchar *display_path;
+
+    path = g_file_get_path (file);
+    display_path = g_filename_display_name (path);
+
+    json = batch_json_new ("error");
+    batch_append_json_member (json, "path", display_path);
+    batch_append_json_member (json, "error", error->message);
+    batch_print_json (batch, json);
+
+    g_atomic_int_inc (&batch->n_failed);
+
+    g_free (display_path);
+    g_free (path);
+}
+
+/*
+ * batch_apply_fields:
+ * @batch: the batch
+ * @ETFile: the file to change
+ *
+ * Set the tag fields given with --set, as a single change of the tag.
+ */
+static void
+batch_apply_fields (EtBatch *batch,
+                    ET_File *ETFile)
+{
+    File_Tag *FileTag;
+    guint i;
+
+    if (batch->fields->len == 0)
+    {
+        return;
+    }
+
+    FileTag = et_file_tag_new ();
+    et_file_tag_copy_into (FileTag, ETFile->FileTag->data);
+
+    for (i = 0; i < batch->fields->len; i++)
+    {
+        const EtBatchField *field = &g_array_index (batch->fields,
+                                                    EtBatchField, i);
+
+        field->set (FileTag, field->value);
+    }
+
+    ET_Manage_Changes_Of_File_Data (ETFile, NULL, FileTag);
+}
+
+/*
+ * batch_process_file:
+ * @data: (transfer full): the #GFile to process
+ * @user_data: the batch
+ *
+ * Load a file with the same readers as the user interface, apply the
+ * changes, and save the file. Run in the thread pool.
+ */
+static void
+batch_process_file (gpointer data,
+                    gpointer user_data)
+{
+    GFile *file = data;
+    EtBatch *batch = user_data;
+    GList *list;
+    ET_File *ETFile;
+    File_Tag *FileTag;
+    File_Name *FileNameCur;
+    File_Name *FileNameNew;
+    gboolean tag_changed;
+    gboolean name_changed;
+    gchar *path;
+    const gchar *status;
+    GString *json;
+    const EtSettingsSnapshot *snapshot;
+    GError *error = NULL;
+
+    /* The readers and writers of the files read the settings snapshot. */
+    snapshot = et_settings_snapshot_ref ();
+    et_settings_set_thread_snapshot (snapshot);
+
+    list = et_file_list_add (NULL, file);
+    ETFile = list->data;
+    g_list_free (list);
+
+    g_atomic_int_inc (&batch->n_files);
+
+    if (batch->fill_mask)
+    {
+        et_scan_tag_with_mask (ETFile, batch->fill_mask);
+    }
+
+    batch_apply_fields (batch, ETFile);
+
+    /* The new filename is generated from the changed tag. */
+    if (batch->rename_mask)
+    {
+        et_scan_rename_file_with_mask (ETFile, batch->rename_mask, &error);
+    }
+
+    FileTag = ETFile->FileTag->data;
+    FileNameCur = ETFile->FileNameCur->data;
+    FileNameNew = ETFile->FileNameNew->data;
+    tag_changed = !FileTag->saved;
+    name_changed = !FileNameNew->saved;
+
+    json = batch_json_new ("file");
+    path = et_file_name_get_path_utf8 (FileNameCur);
+    batch_append_json_member (json, "path", path);
+    g_free (path);
+
+    if (name_changed)
+    {
+        path = et_file_name_get_path_utf8 (FileNameNew);
+        batch_append_json_member (json, "new_path", path);
+        g_free (path);
+    }
+
+    g_string_append_printf (json, ",\"tag_changed\":%s",
+                            tag_changed ? "true" : "false");
+
+    if (!error && !batch->dry_run && tag_changed)
+    {
+        ET_Save_File_Tag_To_HD (ETFile, &error);
+    }
+
+    if (!error && !batch->dry_run && name_changed)
+    {
+        gchar *new_path;
+        gboolean renamed;
+
+        path = et_file_name_get_path (FileNameCur);
+        new_path = et_file_name_get_path (FileNameNew);
+        renamed = et_rename_file (path, new_path, &error);
+        g_free (new_path);
+        g_free (path);
+
+        if (renamed)
+        {
+            /* Mark after renaming files. */
+            ETFile->FileNameCur = ETFile->FileNameNew;
+            ET_Mark_File_Name_As_Saved (ETFile);
+        }
+    }
+
+    if (error)
+    {
+        status = "failed";
+        g_atomic_int_inc (&batch->n_failed);
+    }
+    else if (!tag_changed && !name_changed)
+    {
+        status = "unchanged";
+        g_atomic_int_inc (&batch->n_unchanged);
+    }
+    else
+    {
+        status = batch->dry_run ? "planned" : "updated";
+        g_atomic_int_inc (&batch->n_updated);
+    }
+
+    batch_append_json_member (json, "status", status);
+
+    if (error)
+    {
+        batch_append_json_member (json, "error", error->message);
+        g_error_free (error);
+    }
+
+    batch_print_json (batch, json);
+
+    ET_Free_File_List_Item (ETFile);
+    g_object_unref (file);
+
+    et_settings_set_thread_snapshot (NULL);
+    et_settings_snapshot_unref (snapshot);
+}
+
+/*
+ * batch_walk_directory:
+ * @batch: the batch
+ * @pool: the thread pool which processes the files
+ * @dir: the directory to walk
+ *
+ * Push the supported files in @dir and its subdirectories to @pool, as they
+ * are found, so that the files are processed while the tree is walked.
+ */
+static void
+batch_walk_directory (EtBatch *batch,
+                      GThreadPool *pool,
+                      GFile *dir)
+{
+    GFileEnumerator *enumerator;
+    GFileInfo *info;
+    GError *error = NULL;
+
+    enumerator = g_file_enumerate_children (dir,
+                                            G_FILE_ATTRIBUTE_STANDARD_NAME ","
+                                            G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+                                            G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN,
+                                            G_FILE_QUERY_INFO_NONE, NULL,
+                                            &error);
+
+    if (!enumerator)
+    {
+        batch_report_error (batch, dir, error);
+        g_error_free (error);
+        return;
+    }
+
+    while ((info = g_file_enumerator_next_file (enumerator, NULL, &error))
+           != NULL)
+    {
+        GFile *child;
+
+        /* Hidden files are handled as in the browser. */
+        if (g_file_info_get_is_hidden (info) && !batch->show_hidden)
+        {
+            g_object_unref (info);
+            continue;
+        }
+
+        child = g_file_enumerator_get_child (enumerator, info);
+
+        switch (g_file_info_get_file_type (info))
+        {
+            case G_FILE_TYPE_DIRECTORY:
+                batch_walk_directory (batch, pool, child);
+                g_object_unref (child);
+                break;
+            case G_FILE_TYPE_REGULAR:
+                if (et_file_is_supported (g_file_info_get_name (info)))
+                {
+                    /* The pool takes the reference. */
+                    g_thread_pool_push (pool, child, NULL);
+                }
+                else
+                {
+                    g_object_unref (child);
+                }
+                break;
+            default:
+                g_object_unref (child);
+                break;
+        }
+
+        g_object_unref (info);
+    }
+
+    if (error)
+    {
+        batch_report_error (batch, dir, error);
+        g_error_free (error);
+    }
+
+    g_file_enumerator_close (enumerator, NULL, NULL);
+    g_object_unref (enumerator);
+}
+
+/*
+ * batch_add_path:
+ * @batch: the batch
+ * @pool: the thread pool which processes the files
+ * @path: a path given on the command line
+ *
+ * Process a file given on the command line, or the files in a directory
+ * given on the command line.
+ */
+static void
+batch_add_path (EtBatch *batch,
+                GThreadPool *pool,
+                const gchar *path)
+{
+    GFile *file;
+    GFileInfo *info;
+    GError *error = NULL;
+
+    file = g_file_new_for_commandline_arg (path);
+    info = g_file_query_info (file, G_FILE_ATTRIBUTE_STANDARD_NAME ","
+                                    G_FILE_ATTRIBUTE_STANDARD_TYPE,
+                              G_FILE_QUERY_INFO_NONE, NULL, &error);
+
+    if (!info)
+    {
+        batch_report_error (batch, file, error);
+        g_error_free (error);
+        g_object_unref (file);
+        return;
+    }
+
+    if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
+    {
+        batch_walk_directory (batch, pool, file);
+        g_object_unref (file);
+    }
+    else if (et_file_is_supported (g_file_info_get_name (info)))
+    {
+        g_thread_pool_push (pool, file, NULL);
+    }
+    else
+    {
+        g_set_error (&error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                     _("The file format is not supported"));
+        batch_report_error (batch, file, error);
+        g_error_free (error);
+        g_object_unref (file);
+    }
+
+    g_object_unref (info);
+}
+
+/*
+ * batch_parse_field:
+ * @batch: the batch
+ * @field: a FIELD=VALUE argument of --set
+ * @error: a #GError to provide information on errors, or %NULL to ignore
+ *
+ * Add the field to set to @batch.
+ *
+ * Returns: %TRUE on success, %FALSE if the field is unknown
+ */
+static gboolean
+batch_parse_field (EtBatch *batch,
+                   const gchar *field,
+                   GError **error)
+{
+    const gchar *separator;
+    gsize name_length;
+    gsize i;
+
+    separator = strchr (field, '=');
+
+    if (separator == NULL)
+    {
+        g_set_error (error, G_OPTION_ERROR, G_OPTION_ERROR_BAD_VALUE,
+                     _("Invalid field ‘%s’, expected FIELD=VALUE"), field);
+        return FALSE;
+    }
+
+    name_length = separator - field;
+
+    for (i = 0; i < G_N_ELEMENTS (batch_fields); i++)
+    {
+        if (strlen (batch_fields[i].name) == name_length
+            && strncmp (batch_fields[i].name, field, name_length) == 0)
+        {
+            EtBatchField batch_field;
+
+            batch_field.set = batch_fields[i].set;
+            batch_field.value = g_strdup (separator + 1);
+            g_array_append_val (batch->fields, batch_field);
+
+            return TRUE;
+        }
+    }
+
+    g_set_error (error, G_OPTION_ERROR, G_OPTION_ERROR_BAD_VALUE,
+                 _("Unknown tag field ‘%.*s’"), (gint)name_length, field);
+    return FALSE;
+}
+
+static void
+batch_field_clear (EtBatchField *field)
+{
+    g_free (field->value);
+}
+
+/*
+ * et_batch_is_requested:
+ * @argv: the command-line arguments
+ *
+ * Check whether batch mode was requested with --batch.
+ *
+ * Returns: %TRUE if @argv contains --batch, %FALSE otherwise
+ */
+gboolean
+et_batch_is_requested (gchar **argv)
+{
+    gsize i;
+
+    g_return_val_if_fail (argv != NULL, FALSE);
+
+    for (i = 1; argv[0] != NULL && argv[i] != NULL; i++)
+    {
+        if (strcmp (argv[i], "--") == 0)
+        {
+            break;
+        }
+
+        if (strcmp (argv[i], "--batch") == 0)
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/*
+ * et_batch_run:
+ * @argv: the command-line arguments
+ *
+ * Tag and rename the files given in @argv without the user interface, so
+ * without a display. The files are loaded, changed and saved in parallel, with
+ * the same readers and writers as the user interface, and with the same
+ * scanner settings. The result for each file, and a summary, are printed as
+ * JSON objects on standard output, one per line. The log messages are printed
+ * on standard error.
+ *
+ * Returns: the exit status of the process
+ */
+EtBatchExitStatus
+et_batch_run (gchar **argv)
+{
+    EtBatch batch = { NULL, };
+    gboolean batch_mode = FALSE;
+    gchar **fields = NULL;
+    gchar **paths = NULL;
+    gint n_jobs = 0;
+    gchar **args;
+    GOptionContext *context;
+    GThreadPool *pool;
+    GString *json;
+    EtBatchExitStatus status;
+    gsize i;
+    GError *error = NULL;
+    const GOptionEntry entries[] =
+    {
+        { "batch", 0, 0, G_OPTION_ARG_NONE, &batch_mode,
+          N_("Tag and rename files without the user interface"), NULL },
+        { "fill-mask", 0, 0, G_OPTION_ARG_STRING, &batch.fill_mask,
+          N_("Fill the tags from the filenames with the scanner mask MASK"),
+          N_("MASK") },
+        { "set", 0, 0, G_OPTION_ARG_STRING_ARRAY, &fields,
+          N_("Set the tag field FIELD to VALUE, may be repeated"),
+          N_("FIELD=VALUE") },
+        { "rename-mask", 0, 0, G_OPTION_ARG_STRING, &batch.rename_mask,
+          N_("Rename the files from their tags with the scanner mask MASK"),
+          N_("MASK") },
+        { "dry-run", 'n', 0, G_OPTION_ARG_NONE, &batch.dry_run,
+          N_("Report the changes without saving them"), NULL },
+        { "jobs", 'j', 0, G_OPTION_ARG_INT, &n_jobs,
+          N_("Process N files at the same time"), N_("N") },
+        { G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &paths,
+          NULL, N_("[FILE|DIRECTORY…]") },
+        { NULL }
+    };
+
+    g_return_val_if_fail (argv != NULL, ET_BATCH_EXIT_USAGE);
+
+    context = g_option_context_new (_("- Tag and rename audio files without the user interface"));
+    g_option_context_set_summary (context,
+                                  _("Tag fields: title, artist, album-artist, album, disc-number, disc-total, year, track, track-total, genre, comment, composer, orig-artist, copyright, url, encoded-by"));
+    g_option_context_add_main_entries (context, entries, GETTEXT_PACKAGE);
+
+    args = g_strdupv (argv);
+    batch.fields = g_array_new (FALSE, FALSE, sizeof (EtBatchField));
+    g_array_set_clear_func (batch.fields, (GDestroyNotify)batch_field_clear);
+    status = ET_BATCH_EXIT_USAGE;
+
+    if (!g_option_context_parse_strv (context, &args, &error))
+    {
+        goto out;
+    }
+
+    for (i = 0; fields != NULL && fields[i] != NULL; i++)
+    {
+        if (!batch_parse_field (&batch, fields[i], &error))
+        {
+            goto out;
+        }
+    }
+
+    if (paths == NULL)
+    {
+        g_set_error (&error, G_OPTION_ERROR, G_OPTION_ERROR_FAILED,
+                     _("No files or directories given"));
+        goto out;
+    }
+
+    if (n_jobs <= 0)
+    {
+        n_jobs = g_get_num_processors ();
+    }
+
+    Init_Config_Variables ();
+    batch.show_hidden = et_settings_get_snapshot ()->browse_show_hidden;
+    g_mutex_init (&batch.output_lock);
+
+    pool = g_thread_pool_new (batch_process_file, &batch, n_jobs, FALSE,
+                              NULL);
+
+    for (i = 0; paths[i] != NULL; i++)
+    {
+        batch_add_path (&batch, pool, paths[i]);
+    }
+
+    /* Wait for all the files to be processed. */
+    g_thread_pool_free (pool, FALSE, TRUE);
+
+    json = batch_json_new ("summary");
+    g_string_append_printf (json,
+                            ",\"files\":%d,\"updated\":%d,\"unchanged\":%d,"
+                            "\"failed\":%d,\"dry_run\":%s",
+                            batch.n_files, batch.n_updated, batch.n_unchanged,
+                            batch.n_failed, batch.dry_run ? "true" : "false");
+    batch_print_json (&batch, json);
+
+    g_mutex_clear (&batch.output_lock);
+    et_log_shutdown ();
+
+    status = batch.n_failed > 0 ? ET_BATCH_EXIT_FAILED
+                                : ET_BATCH_EXIT_SUCCESS;
+
+out:
+    if (error)
+    {
+        g_printerr ("%s\n", error->message);
+        g_error_free (error);
+    }
+
+    g_array_free (batch.fields, TRUE);
+    g_strfreev (paths);
+    g_strfreev (fields);
+    g_free (batch.rename_mask);
+    g_free (batch.fill_mask);
+    g_strfreev (args);
+    g_option_context_free (context);
+
+    return status;
+}
@@ -0,0 +1,46 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ET_BATCH_H_
+#define ET_BATCH_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * EtBatchExitStatus:
+ * @ET_BATCH_EXIT_SUCCESS: all the files were processed
+ * @ET_BATCH_EXIT_FAILED: some files or directories could not be processed
+ * @ET_BATCH_EXIT_USAGE: the command line was invalid
+ *
+ * The exit status of easytag --batch.
+ */
+typedef enum
+{
+    ET_BATCH_EXIT_SUCCESS = 0,
+    ET_BATCH_EXIT_FAILED = 1,
+    ET_BATCH_EXIT_USAGE = 2
+} EtBatchExitStatus;
+
+gboolean et_batch_is_requested (gchar **argv);
+EtBatchExitStatus et_batch_run (gchar **argv);
+
+G_END_DECLS
+
+#endif /* !ET_BATCH_H_ */
@@ -36,6 +36,7 @@
 
 #include "application_window.h"
 #include "charset.h"
+#include "directory_cache.h"
 #include "dlm.h"
 #include "easytag.h"
 #include "et_core.h"
@@ -62,6 +63,11 @@ typedef struct
     GtkWidget *file_menu;
     guint file_selected_handler;
     EtSortMode file_sort_mode;
+    gboolean file_changed_bold;
+
+    /* The row of each file of the list, by ETFileKey. The iters of a
+     * GtkListStore persist while their row exists, also when it is sorted. */
+    GHashTable *file_rows;
 
     GtkWidget *album_view;
     GtkWidget *album_menu;
@@ -93,8 +99,65 @@ typedef struct
     GtkWidget *rename_directory_preview_label;
 
     GFile *current_path;
+
+    /* Casefolded strings of the file list rows, for et_browser_select_file_by_dlm(). */
+    EtDlmCorpus *dlm_corpus;
+    GArray *dlm_items;
+
+    /* Subdirectory listings for the directory tree, and the directories being
+     * expanded in the background, by path. */
+    EtDirectoryCache *directory_cache;
+    GCancellable *directory_cancellable;
+    GHashTable *directory_loads;
+    gboolean expand_synchronously;
 } EtBrowserPrivate;
 
+/*
+ * EtBrowserDlmItem:
+ * @ETFile: the file of the row
+ * @name_key: the key of the current filename of @ETFile
+ * @tag_key: the key of the current tag of @ETFile
+ *
+ * The file and versions for which the string at the same position in the DLM
+ * corpus was computed.
+ */
+typedef struct
+{
+    const ET_File *ETFile;
+    guint name_key;
+    guint tag_key;
+} EtBrowserDlmItem;
+
+/*
+ * EtBrowserDirectoryLoad:
+ * @browser: the browser
+ * @row: the row of the directory being expanded
+ * @path: (type filename): the path of the directory, the key in the
+ * directory_loads table
+ * @listing: (allow-none): the subdirectories, once listed
+ * @next: the index in @listing of the next subdirectory to insert
+ * @show_hidden: whether hidden subdirectories are inserted
+ * @probe_rows: the inserted rows which must be probed for subdirectories
+ *
+ * A directory tree row which is being expanded in the background. The load is
+ * stale, and frees itself, once it is no longer in the directory_loads table.
+ */
+typedef struct
+{
+    EtBrowser *browser;
+    GtkTreeRowReference *row;
+    gchar *path;
+    GPtrArray *listing;
+    guint next;
+    gboolean show_hidden;
+    GPtrArray *probe_rows;
+} EtBrowserDirectoryLoad;
+
+/* Number of rows inserted in the directory tree per main loop iteration, and
+ * number of directories to probe for subdirectories per thread. */
+#define DIRECTORY_LOAD_BATCH_SIZE 256
+#define DIRECTORY_PROBE_BATCH_SIZE 64
+
 G_DEFINE_TYPE_WITH_PRIVATE (EtBrowser, et_browser, GTK_TYPE_BIN)
 
 /*
@@ -184,6 +247,10 @@ static void Browser_Tree_Handle_Rename (EtBrowser *self,
                                         const gchar *new_path);
 
 static void Browser_List_Set_Row_Appearance (EtBrowser *self, GtkTreeIter *iter);
+static void Browser_List_Refresh_Row (EtBrowser *self, GtkTreeIter *iter);
+static gboolean Browser_List_Get_Iter_For_File (EtBrowser *self,
+                                                const ET_File *ETFile,
+                                                GtkTreeIter *iter);
 static gint Browser_List_Sort_Func (GtkTreeModel *model, GtkTreeIter *a,
                                     GtkTreeIter *b, gpointer data);
 static void Browser_List_Select_File_By_Iter (EtBrowser *self,
@@ -200,11 +267,10 @@ static void Browser_Album_List_Row_Selected (EtBrowser *self,
                                              GtkTreeSelection *selection);
 static void Browser_Album_List_Set_Row_Appearance (EtBrowser *self, GtkTreeIter *row);
 
-static gboolean check_for_subdir (const gchar *path);
-
 static GtkTreePath *Find_Child_Node (EtBrowser *self, GtkTreeIter *parent, gchar *searchtext);
 
 static GIcon *get_gicon_for_path (const gchar *path, EtPathState path_state);
+static void expand_to_path_synchronously (EtBrowser *self, GtkTreePath *path);
 
 /* For window to rename a directory */
 static void Destroy_Rename_Directory_Window (EtBrowser *self);
@@ -349,8 +415,9 @@ et_browser_run_player_for_album_list (EtBrowser *self)
     for (; l != NULL; l = g_list_next (l))
     {
         ET_File *etfile = (ET_File *)l->data;
-        const gchar *path = ((File_Name *)etfile->FileNameCur->data)->value;
+        gchar *path = et_file_name_get_path ((File_Name *)etfile->FileNameCur->data);
         file_list = g_list_prepend (file_list, g_file_new_for_path (path));
+        g_free (path);
     }
 
     file_list = g_list_reverse (file_list);
@@ -391,8 +458,9 @@ et_browser_run_player_for_artist_list (EtBrowser *self)
         for (m = l->data; m != NULL; m = g_list_next (m))
         {
             ET_File *etfile = (ET_File *)m->data;
-            const gchar *path = ((File_Name *)etfile->FileNameCur->data)->value;
+            gchar *path = et_file_name_get_path ((File_Name *)etfile->FileNameCur->data);
             file_list = g_list_prepend (file_list, g_file_new_for_path (path));
+            g_free (path);
         }
     }
 
@@ -426,8 +494,9 @@ et_browser_run_player_for_selection (EtBrowser *self)
     for (l = selfilelist; l != NULL; l = g_list_next (l))
     {
         ET_File *etfile = et_browser_get_et_file_from_path (self, l->data);
-        const gchar *path = ((File_Name *)etfile->FileNameCur->data)->value;
+        gchar *path = et_file_name_get_path ((File_Name *)etfile->FileNameCur->data);
         file_list = g_list_prepend (file_list, g_file_new_for_path (path));
+        g_free (path);
     }
 
     file_list = g_list_reverse (file_list);
@@ -576,8 +645,22 @@ et_browser_reload_directory (EtBrowser *self)
 
     if (priv->directory_view && priv->current_path != NULL)
     {
+        GtkTreeSelection *selection;
+        gchar *path;
+        gboolean reloaded;
+
+        /* Read again only the files which changed, if possible. */
+        path = g_file_get_path (priv->current_path);
+        reloaded = path != NULL && et_read_directory_changes (path);
+        g_free (path);
+
+        if (reloaded)
+        {
+            return;
+        }
+
         /* Unselect files, to automatically reload the file of the directory. */
-        GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (priv->directory_view));
+        selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (priv->directory_view));
 
         if (selection)
         {
@@ -1056,7 +1139,8 @@ et_browser_win32_get_drive_root (EtBrowser *self,
  * et_browser_select_dir:
  *
  * Select the directory corresponding to the 'path' in the tree browser, but it
- * doesn't read it! Check if path is correct before selecting it.
+ * doesn't read it! Check if path is correct before selecting it. The nodes on
+ * the way are expanded synchronously, so that they can be searched.
  */
 void
 et_browser_select_dir (EtBrowser *self,
@@ -1103,8 +1187,7 @@ et_browser_select_dir (EtBrowser *self,
 #endif /* !G_OS_WIN32 */
     if (rootPath)
     {
-        gtk_tree_view_expand_to_path (GTK_TREE_VIEW (priv->directory_view),
-                                      rootPath);
+        expand_to_path_synchronously (self, rootPath);
         gtk_tree_path_free(rootPath);
     }
 
@@ -1145,7 +1228,7 @@ et_browser_select_dir (EtBrowser *self,
                                                    &iter, &parentNode, 0,
                                                    TREE_COLUMN_DIR_NAME, parts[index],
                                                    TREE_COLUMN_FULL_PATH, path,
-                                                   TREE_COLUMN_HAS_SUBDIR, check_for_subdir (current_path),
+                                                   TREE_COLUMN_HAS_SUBDIR, FALSE,
                                                    TREE_COLUMN_SCANNED, TRUE,
                                                    TREE_COLUMN_ICON, icon, -1);
 
@@ -1194,8 +1277,7 @@ et_browser_select_dir (EtBrowser *self,
         rootPath = gtk_tree_model_get_path(GTK_TREE_MODEL(priv->directory_model), &parentNode);
         if (rootPath)
         {
-            gtk_tree_view_expand_to_path (GTK_TREE_VIEW (priv->directory_view),
-                                          rootPath);
+            expand_to_path_synchronously (self, rootPath);
             gtk_tree_path_free(rootPath);
         }
         index++;
@@ -1204,8 +1286,7 @@ et_browser_select_dir (EtBrowser *self,
     rootPath = gtk_tree_model_get_path(GTK_TREE_MODEL(priv->directory_model), &parentNode);
     if (rootPath)
     {
-        gtk_tree_view_expand_to_path (GTK_TREE_VIEW (priv->directory_view),
-                                      rootPath);
+        expand_to_path_synchronously (self, rootPath);
         Browser_Tree_Set_Node_Visible (priv->directory_view, rootPath);
         /* Select the node to load the corresponding directory. */
         gtk_tree_selection_select_path (gtk_tree_view_get_selection (GTK_TREE_VIEW (priv->directory_view)),
@@ -1292,6 +1373,7 @@ et_browser_clear_file_model (EtBrowser *self)
     g_signal_handler_block (selection, priv->file_selected_handler);
 
     gtk_list_store_clear (priv->file_model);
+    g_hash_table_remove_all (priv->file_rows);
     gtk_tree_view_columns_autosize (GTK_TREE_VIEW (priv->file_view));
 
     g_signal_handler_unblock (selection, priv->file_selected_handler);
@@ -1321,8 +1403,8 @@ et_browser_load_file_list (EtBrowser *self,
     for (l = g_list_first (etfilelist); l != NULL; l = g_list_next (l))
     {
         guint fileKey = ((ET_File *)l->data)->ETFileKey;
-        const gchar *current_filename_utf8 = ((File_Name *)((ET_File *)l->data)->FileNameCur->data)->value_utf8;
-        gchar *basename_utf8 = g_path_get_basename (current_filename_utf8);
+        const File_Name *current_filename = (File_Name *)((ET_File *)l->data)->FileNameCur->data;
+        gchar *basename_utf8 = g_strdup (current_filename->name_utf8);
         File_Tag *FileTag = ((File_Tag *)((ET_File *)l->data)->FileTag->data);
         gchar *track;
         gchar *disc;
@@ -1332,16 +1414,16 @@ et_browser_load_file_list (EtBrowser *self,
         {
             gchar *dir1_utf8;
             gchar *dir2_utf8;
-            const gchar *previous_filename_utf8 = ((File_Name *)((ET_File *)l->prev->data)->FileNameCur->data)->value_utf8;
+            const File_Name *previous_filename = (File_Name *)((ET_File *)l->prev->data)->FileNameCur->data;
 
-            dir1_utf8 = g_path_get_dirname(previous_filename_utf8);
-            dir2_utf8 = g_path_get_dirname(current_filename_utf8);
+            dir1_utf8 = et_file_name_get_dirname_utf8 (previous_filename);
+            dir2_utf8 = et_file_name_get_dirname_utf8 (current_filename);
 
             if (g_utf8_collate(dir1_utf8, dir2_utf8) != 0)
                 activate_bg_color = !activate_bg_color;
 
-            g_free(dir1_utf8);
-            g_free(dir2_utf8);
+            g_free (dir2_utf8);
+            g_free (dir1_utf8);
         }
 
         /* File list displays the current filename (name on disc) and tag
@@ -1381,6 +1463,9 @@ et_browser_load_file_list (EtBrowser *self,
         g_free(track);
         g_free (disc);
 
+        g_hash_table_insert (priv->file_rows, GUINT_TO_POINTER (fileKey),
+                             gtk_tree_iter_copy (&rowIter));
+
         if (etfile_to_select == l->data)
         {
             Browser_List_Select_File_By_Iter (self, &rowIter, TRUE);
@@ -1397,19 +1482,16 @@ et_browser_load_file_list (EtBrowser *self,
  * Update state of files in the list after changes (without clearing the list model!)
  *  - Refresh 'filename' is file saved,
  *  - Change color is something changed on the file
+ * Only the rows of the files marked with et_core_mark_file_changed() since the
+ * last refresh are updated.
  */
 void
 et_browser_refresh_list (EtBrowser *self)
 {
     EtBrowserPrivate *priv;
-    //GtkTreeIter iter;
-    GtkTreePath *currentPath = NULL;
     GtkTreeIter iter;
-    gint row;
-    gchar *current_basename_utf8;
-    gchar *track;
-    gchar *disc;
-    gboolean valid;
+    GHashTableIter changed_iter;
+    gpointer key;
     GVariant *variant;
 
     g_return_if_fail (ET_BROWSER (self));
@@ -1422,57 +1504,28 @@ et_browser_refresh_list (EtBrowser *self)
         return;
     }
 
-    // Browse the full list for changes
-    //gtk_tree_model_get_iter_first(GTK_TREE_MODEL(priv->file_model), &iter);
-    //    g_print("above worked %d rows\n", gtk_tree_model_iter_n_children(GTK_TREE_MODEL(priv->file_model), NULL));
-
-    currentPath = gtk_tree_path_new_first();
-
-    valid = gtk_tree_model_get_iter(GTK_TREE_MODEL(priv->file_model), &iter, currentPath);
-    while (valid)
+    if (g_hash_table_size (ETCore->ETFileChangedKeys) == 0)
     {
-        const ET_File *ETFile;
-        const File_Tag *FileTag;
-        const File_Name *FileName;
-        // Refresh filename and other fields
-        gtk_tree_model_get(GTK_TREE_MODEL(priv->file_model), &iter,
-                           LIST_FILE_POINTER, &ETFile, -1);
-
-        FileName = (File_Name *)ETFile->FileNameCur->data;
-        FileTag  = (File_Tag *)ETFile->FileTag->data;
+        return;
+    }
 
-        current_basename_utf8 = g_path_get_basename(FileName->value_utf8);
-        track = g_strconcat(FileTag->track ? FileTag->track : "",FileTag->track_total ? "/" : NULL,FileTag->track_total,NULL);
-        disc  = g_strconcat (FileTag->disc_number ? FileTag->disc_number : "",
-                             FileTag->disc_total ? "/" : NULL,
-                             FileTag->disc_total, NULL);
+    /* Look up the row of each changed file, rather than refreshing the whole
+     * list. Files which are not displayed have no row. */
+    g_hash_table_iter_init (&changed_iter, ETCore->ETFileChangedKeys);
 
-        gtk_list_store_set(priv->file_model, &iter,
-                           LIST_FILE_NAME,          current_basename_utf8,
-                           LIST_FILE_TITLE,         FileTag->title,
-                           LIST_FILE_ARTIST,        FileTag->artist,
-                           LIST_FILE_ALBUM_ARTIST,  FileTag->album_artist,
-						   LIST_FILE_ALBUM,         FileTag->album,
-                           LIST_FILE_YEAR,          FileTag->year,
-                           LIST_FILE_DISCNO, disc,
-                           LIST_FILE_TRACK,         track,
-                           LIST_FILE_GENRE,         FileTag->genre,
-                           LIST_FILE_COMMENT,       FileTag->comment,
-                           LIST_FILE_COMPOSER,      FileTag->composer,
-                           LIST_FILE_ORIG_ARTIST,   FileTag->orig_artist,
-                           LIST_FILE_COPYRIGHT,     FileTag->copyright,
-                           LIST_FILE_URL,           FileTag->url,
-                           LIST_FILE_ENCODED_BY,    FileTag->encoded_by,
-                           -1);
-        g_free(current_basename_utf8);
-        g_free(track);
-        g_free (disc);
+    while (g_hash_table_iter_next (&changed_iter, &key, NULL))
+    {
+        GtkTreeIter *file_iter;
 
-        Browser_List_Set_Row_Appearance (self, &iter);
+        file_iter = g_hash_table_lookup (priv->file_rows, key);
 
-        valid = gtk_tree_model_iter_next(GTK_TREE_MODEL(priv->file_model), &iter);
+        if (file_iter)
+        {
+            Browser_List_Refresh_Row (self, file_iter);
+        }
     }
-    gtk_tree_path_free(currentPath);
+
+    g_hash_table_remove_all (ETCore->ETFileChangedKeys);
 
     variant = g_action_group_get_action_state (G_ACTION_GROUP (MainWindow),
                                                "file-artist-view");
@@ -1480,31 +1533,25 @@ et_browser_refresh_list (EtBrowser *self)
     // When displaying Artist + Album lists => refresh also rows color
     if (strcmp (g_variant_get_string (variant, NULL), "artist") == 0)
     {
+        gboolean valid;
 
-        for (row = 0; row < gtk_tree_model_iter_n_children (GTK_TREE_MODEL (priv->artist_model), NULL); row++)
+        for (valid = gtk_tree_model_get_iter_first (GTK_TREE_MODEL (priv->artist_model),
+                                                    &iter);
+             valid;
+             valid = gtk_tree_model_iter_next (GTK_TREE_MODEL (priv->artist_model),
+                                               &iter))
         {
-            if (row == 0)
-                currentPath = gtk_tree_path_new_first();
-            else
-                gtk_tree_path_next(currentPath);
-
-            gtk_tree_model_get_iter(GTK_TREE_MODEL(priv->artist_model), &iter, currentPath);
             Browser_Artist_List_Set_Row_Appearance (self, &iter);
         }
-        gtk_tree_path_free(currentPath);
 
-
-        for (row=0; row < gtk_tree_model_iter_n_children(GTK_TREE_MODEL(priv->album_model), NULL); row++)
+        for (valid = gtk_tree_model_get_iter_first (GTK_TREE_MODEL (priv->album_model),
+                                                    &iter);
+             valid;
+             valid = gtk_tree_model_iter_next (GTK_TREE_MODEL (priv->album_model),
+                                               &iter))
         {
-            if (row == 0)
-                currentPath = gtk_tree_path_new_first();
-            else
-                gtk_tree_path_next(currentPath);
-
-            gtk_tree_model_get_iter(GTK_TREE_MODEL(priv->album_model), &iter, currentPath);
             Browser_Album_List_Set_Row_Appearance (self, &iter);
         }
-        gtk_tree_path_free(currentPath);
     }
 
     g_variant_unref (variant);
@@ -1521,17 +1568,9 @@ et_browser_refresh_file_in_list (EtBrowser *self,
                                  const ET_File *ETFile)
 {
     EtBrowserPrivate *priv;
-    GList *selectedRow = NULL;
+    GtkTreeIter *selectedRow;
     GVariant *variant;
-    GtkTreeSelection *selection;
     GtkTreeIter selectedIter;
-    const ET_File *etfile;
-    const File_Tag *FileTag;
-    const File_Name *FileName;
-    gboolean row_found = FALSE;
-    gchar *current_basename_utf8;
-    gchar *track;
-    gchar *disc;
     gboolean valid;
     gchar *artist, *album;
 
@@ -1545,101 +1584,18 @@ et_browser_refresh_file_in_list (EtBrowser *self,
         return;
     }
 
-    // Search the row of the modified file to update it (when found: row_found=TRUE)
-    // 1/3. Get position of ETFile in ETFileList
-    if (row_found == FALSE)
-    {
-        valid = gtk_tree_model_iter_nth_child (GTK_TREE_MODEL(priv->file_model), &selectedIter, NULL, ETFile->IndexKey-1);
-        if (valid)
-        {
-            gtk_tree_model_get(GTK_TREE_MODEL(priv->file_model), &selectedIter,
-                           LIST_FILE_POINTER, &etfile, -1);
-            if (ETFile->ETFileKey == etfile->ETFileKey)
-            {
-                row_found = TRUE;
-            }
-        }
-    }
-
-    // 2/3. Try with the selected file in list (works only if we select the same file)
-    if (row_found == FALSE)
-    {
-        selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (priv->file_view));
-        selectedRow = gtk_tree_selection_get_selected_rows(selection, NULL);
-        if (selectedRow && selectedRow->data != NULL)
-        {
-            valid = gtk_tree_model_get_iter(GTK_TREE_MODEL(priv->file_model), &selectedIter,
-                                    (GtkTreePath*) selectedRow->data);
-            if (valid)
-            {
-                gtk_tree_model_get(GTK_TREE_MODEL(priv->file_model), &selectedIter,
-                                   LIST_FILE_POINTER, &etfile, -1);
-                if (ETFile->ETFileKey == etfile->ETFileKey)
-                {
-                    row_found = TRUE;
-                }
-            }
-        }
-
-        g_list_free_full (selectedRow, (GDestroyNotify)gtk_tree_path_free);
-    }
-
-    // 3/3. Fails, now we browse the full list to find it
-    if (row_found == FALSE)
-    {
-        valid = gtk_tree_model_get_iter_first(GTK_TREE_MODEL(priv->file_model), &selectedIter);
-        while (valid)
-        {
-            gtk_tree_model_get(GTK_TREE_MODEL(priv->file_model), &selectedIter,
-                               LIST_FILE_POINTER, &etfile, -1);
-            if (ETFile->ETFileKey == etfile->ETFileKey)
-            {
-                row_found = TRUE;
-                break;
-            } else
-            {
-                valid = gtk_tree_model_iter_next(GTK_TREE_MODEL(priv->file_model), &selectedIter);
-            }
-        }
-    }
+    selectedRow = g_hash_table_lookup (priv->file_rows,
+                                       GUINT_TO_POINTER (ETFile->ETFileKey));
 
     // Error somewhere...
-    if (row_found == FALSE)
+    if (selectedRow == NULL)
         return;
 
-    // Displayed the filename and refresh other fields
-    FileName = (File_Name *)etfile->FileNameCur->data;
-    FileTag  = (File_Tag *)etfile->FileTag->data;
-
-    current_basename_utf8 = g_path_get_basename(FileName->value_utf8);
-    track = g_strconcat(FileTag->track ? FileTag->track : "",FileTag->track_total ? "/" : NULL,FileTag->track_total,NULL);
-    disc  = g_strconcat (FileTag->disc_number ? FileTag->disc_number : "",
-                         FileTag->disc_total ? "/" : NULL, FileTag->disc_total,
-                         NULL);
-
-    gtk_list_store_set(priv->file_model, &selectedIter,
-                       LIST_FILE_NAME,          current_basename_utf8,
-                       LIST_FILE_TITLE,         FileTag->title,
-                       LIST_FILE_ARTIST,        FileTag->artist,
-                       LIST_FILE_ALBUM_ARTIST,  FileTag->album_artist,
-					   LIST_FILE_ALBUM,         FileTag->album,
-                       LIST_FILE_YEAR,          FileTag->year,
-                       LIST_FILE_DISCNO, disc,
-                       LIST_FILE_TRACK,         track,
-                       LIST_FILE_GENRE,         FileTag->genre,
-                       LIST_FILE_COMMENT,       FileTag->comment,
-                       LIST_FILE_COMPOSER,      FileTag->composer,
-                       LIST_FILE_ORIG_ARTIST,   FileTag->orig_artist,
-                       LIST_FILE_COPYRIGHT,     FileTag->copyright,
-                       LIST_FILE_URL,           FileTag->url,
-                       LIST_FILE_ENCODED_BY,    FileTag->encoded_by,
-                       -1);
-    g_free(current_basename_utf8);
-    g_free(track);
-    g_free (disc);
-
-    /* Change appearance (line to red) if filename changed. */
-    Browser_List_Set_Row_Appearance (self, &selectedIter);
+    /* Displayed the filename and refresh other fields, and change appearance
+     * (line to red) if filename changed. */
+    Browser_List_Refresh_Row (self, selectedRow);
+    g_hash_table_remove (ETCore->ETFileChangedKeys,
+                         GUINT_TO_POINTER (ETFile->ETFileKey));
 
     variant = g_action_group_get_action_state (G_ACTION_GROUP (MainWindow),
                                                "file-artist-view");
@@ -1711,6 +1667,62 @@ et_browser_refresh_file_in_list (EtBrowser *self,
 }
 
 
+/*
+ * Browser_List_Refresh_Row:
+ * @self: the browser
+ * @iter: the row of the file list to refresh
+ *
+ * Display the current filename and tag fields of the file of @iter, and
+ * update the appearance of the row.
+ */
+static void
+Browser_List_Refresh_Row (EtBrowser *self,
+                          GtkTreeIter *iter)
+{
+    EtBrowserPrivate *priv;
+    const ET_File *ETFile;
+    const File_Name *FileName;
+    const File_Tag *FileTag;
+    gchar *track;
+    gchar *disc;
+
+    priv = et_browser_get_instance_private (self);
+
+    gtk_tree_model_get (GTK_TREE_MODEL (priv->file_model), iter,
+                        LIST_FILE_POINTER, &ETFile, -1);
+
+    FileName = (File_Name *)ETFile->FileNameCur->data;
+    FileTag  = (File_Tag *)ETFile->FileTag->data;
+
+    track = g_strconcat(FileTag->track ? FileTag->track : "",FileTag->track_total ? "/" : NULL,FileTag->track_total,NULL);
+    disc  = g_strconcat (FileTag->disc_number ? FileTag->disc_number : "",
+                         FileTag->disc_total ? "/" : NULL, FileTag->disc_total,
+                         NULL);
+
+    gtk_list_store_set(priv->file_model, iter,
+                       LIST_FILE_NAME,          FileName->name_utf8,
+                       LIST_FILE_TITLE,         FileTag->title,
+                       LIST_FILE_ARTIST,        FileTag->artist,
+                       LIST_FILE_ALBUM_ARTIST,  FileTag->album_artist,
+                       LIST_FILE_ALBUM,         FileTag->album,
+                       LIST_FILE_YEAR,          FileTag->year,
+                       LIST_FILE_DISCNO,        disc,
+                       LIST_FILE_TRACK,         track,
+                       LIST_FILE_GENRE,         FileTag->genre,
+                       LIST_FILE_COMMENT,       FileTag->comment,
+                       LIST_FILE_COMPOSER,      FileTag->composer,
+                       LIST_FILE_ORIG_ARTIST,   FileTag->orig_artist,
+                       LIST_FILE_COPYRIGHT,     FileTag->copyright,
+                       LIST_FILE_URL,           FileTag->url,
+                       LIST_FILE_ENCODED_BY,    FileTag->encoded_by,
+                       -1);
+    g_free(track);
+    g_free (disc);
+
+    /* Change appearance (line to red) if filename changed. */
+    Browser_List_Set_Row_Appearance (self, iter);
+}
+
 /*
  * Set the appearance of the row
  *  - change background according LIST_FILE_OTHERDIR
@@ -1753,7 +1765,7 @@ Browser_List_Set_Row_Appearance (EtBrowser *self, GtkTreeIter *iter)
     // Set text to bold/red if 'filename' or 'tag' changed
     if (!et_file_check_saved (rowETFile))
     {
-        if (g_settings_get_boolean (MainSettings, "file-changed-bold"))
+        if (priv->file_changed_bold)
         {
             gtk_list_store_set(priv->file_model, iter,
                                LIST_FONT_WEIGHT,    PANGO_WEIGHT_BOLD,
@@ -1802,6 +1814,42 @@ Browser_List_Set_Row_Appearance (EtBrowser *self, GtkTreeIter *iter)
 }
 
 
+/*
+ * Browser_List_Get_Iter_For_File:
+ * @self: the browser
+ * @ETFile: the file to find the row of
+ * @iter: (out): the row of @ETFile
+ *
+ * Look up the row of @ETFile in the file list, in constant time.
+ *
+ * Returns: %TRUE if @ETFile has a row, %FALSE otherwise
+ */
+static gboolean
+Browser_List_Get_Iter_For_File (EtBrowser *self,
+                                const ET_File *ETFile,
+                                GtkTreeIter *iter)
+{
+    EtBrowserPrivate *priv;
+    const GtkTreeIter *row;
+    const ET_File *rowETFile;
+
+    priv = et_browser_get_instance_private (self);
+
+    row = g_hash_table_lookup (priv->file_rows,
+                               GUINT_TO_POINTER (ETFile->ETFileKey));
+
+    if (row == NULL)
+    {
+        return FALSE;
+    }
+
+    *iter = *row;
+    gtk_tree_model_get (GTK_TREE_MODEL (priv->file_model), iter,
+                        LIST_FILE_POINTER, &rowETFile, -1);
+
+    return rowETFile == ETFile;
+}
+
 /*
  * Remove a file from the list, by ETFile
  */
@@ -1810,40 +1858,19 @@ et_browser_remove_file (EtBrowser *self,
                         const ET_File *searchETFile)
 {
     EtBrowserPrivate *priv;
-    gint row;
-    GtkTreePath *currentPath = NULL;
     GtkTreeIter currentIter;
-    ET_File *currentETFile;
-    gboolean valid;
 
     if (searchETFile == NULL)
         return;
 
     priv = et_browser_get_instance_private (self);
 
-    // Go through the file list until it is found
-    for (row=0; row < gtk_tree_model_iter_n_children(GTK_TREE_MODEL(priv->file_model), NULL); row++)
+    if (Browser_List_Get_Iter_For_File (self, searchETFile, &currentIter))
     {
-        if (row == 0)
-            currentPath = gtk_tree_path_new_first();
-        else
-            gtk_tree_path_next(currentPath);
-
-        valid = gtk_tree_model_get_iter(GTK_TREE_MODEL(priv->file_model), &currentIter, currentPath);
-        if (valid)
-        {
-            gtk_tree_model_get(GTK_TREE_MODEL(priv->file_model), &currentIter,
-                               LIST_FILE_POINTER, &currentETFile, -1);
-
-            if (currentETFile == searchETFile)
-            {
-                gtk_list_store_remove(priv->file_model, &currentIter);
-                break;
-            }
-        }
+        gtk_list_store_remove (priv->file_model, &currentIter);
+        g_hash_table_remove (priv->file_rows,
+                             GUINT_TO_POINTER (searchETFile->ETFileKey));
     }
-
-    gtk_tree_path_free (currentPath);
 }
 
 /*
@@ -1895,83 +1922,14 @@ et_browser_select_file_by_et_file (EtBrowser *self,
                                    const ET_File *file,
                                    gboolean select_it)
 {
-    GtkTreePath *currentPath = NULL;
-
-    currentPath = et_browser_select_file_by_et_file2 (self, file, select_it,
-                                                      NULL);
-
-    if (currentPath)
-    {
-        gtk_tree_path_free (currentPath);
-    }
-}
-/*
- * Select the specified file in the list, by its ETFile
- *  - startPath : if set : starting path to try increase speed
- *  - returns allocated "currentPath" to free
- */
-GtkTreePath *
-et_browser_select_file_by_et_file2 (EtBrowser *self,
-                                    const ET_File *searchETFile,
-                                    gboolean select_it,
-                                    GtkTreePath *startPath)
-{
-    EtBrowserPrivate *priv;
-    gint row;
-    GtkTreePath *currentPath = NULL;
-    GtkTreeIter currentIter;
-    ET_File *currentETFile;
-    gboolean valid;
-
-    g_return_val_if_fail (searchETFile != NULL, NULL);
-
-    priv = et_browser_get_instance_private (self);
+    GtkTreeIter iter;
 
-    // If the path is used, we try the next item (to increase speed), as it is correct in many cases...
-    if (startPath)
-    {
-        // Try the next path
-        gtk_tree_path_next(startPath);
-        valid = gtk_tree_model_get_iter (GTK_TREE_MODEL (priv->file_model),
-                                         &currentIter, startPath);
-        if (valid)
-        {
-            gtk_tree_model_get(GTK_TREE_MODEL(priv->file_model), &currentIter,
-                               LIST_FILE_POINTER, &currentETFile, -1);
-            // It is the good file?
-            if (currentETFile == searchETFile)
-            {
-                Browser_List_Select_File_By_Iter (self, &currentIter,
-                                                  select_it);
-                return startPath;
-            }
-        }
-    }
+    g_return_if_fail (file != NULL);
 
-    // Else, we try the whole list...
-    // Go through the file list until it is found
-    currentPath = gtk_tree_path_new_first();
-    for (row=0; row < gtk_tree_model_iter_n_children(GTK_TREE_MODEL(priv->file_model), NULL); row++)
+    if (Browser_List_Get_Iter_For_File (self, file, &iter))
     {
-        valid = gtk_tree_model_get_iter(GTK_TREE_MODEL(priv->file_model), &currentIter, currentPath);
-        if (valid)
-        {
-            gtk_tree_model_get(GTK_TREE_MODEL(priv->file_model), &currentIter,
-                               LIST_FILE_POINTER, &currentETFile, -1);
-
-            if (currentETFile == searchETFile)
-            {
-                Browser_List_Select_File_By_Iter (self, &currentIter,
-                                                  select_it);
-                return currentPath;
-                //break;
-            }
-        }
-        gtk_tree_path_next(currentPath);
+        Browser_List_Select_File_By_Iter (self, &iter, select_it);
     }
-    gtk_tree_path_free(currentPath);
-
-    return NULL;
 }
 
 
@@ -2038,6 +1996,10 @@ et_browser_select_file_by_iter_string (EtBrowser *self,
 /*
  * Select the specified file in the list, by fuzzy string matching based on
  * the Damerau-Levenshtein Metric (patch from Santtu Lakkala - 23/08/2004)
+ *
+ * The title of each file (or the filename, if there is no title) is
+ * casefolded once and kept in a corpus, in which only the rows whose file,
+ * filename or tag changed since the previous call are updated.
  */
 ET_File *
 et_browser_select_file_by_dlm (EtBrowser *self,
@@ -2045,36 +2007,69 @@ et_browser_select_file_by_dlm (EtBrowser *self,
                                gboolean select_it)
 {
     EtBrowserPrivate *priv;
+    GtkTreeModel *model;
     GtkTreeIter iter;
-    GtkTreeIter iter2;
     GtkTreeSelection *selection;
-    ET_File *current_etfile = NULL, *retval = NULL;
-    gchar *current_filename = NULL, *current_title = NULL;
-    int max = 0, this;
+    ET_File *retval = NULL;
+    gboolean valid;
+    guint n_rows = 0;
+    gint best;
 
     priv = et_browser_get_instance_private (self);
 
     g_return_val_if_fail (priv->file_model != NULL || priv->file_view != NULL, NULL);
 
-    if (gtk_tree_model_get_iter_first (GTK_TREE_MODEL (priv->file_model),
-                                       &iter))
+    model = GTK_TREE_MODEL (priv->file_model);
+
+    for (valid = gtk_tree_model_get_iter_first (model, &iter); valid;
+         valid = gtk_tree_model_iter_next (model, &iter), n_rows++)
     {
-        do
+        ET_File *current_etfile;
+        const File_Name *FileName;
+        const File_Tag *FileTag;
+        EtBrowserDlmItem *item;
+
+        gtk_tree_model_get (model, &iter, LIST_FILE_POINTER, &current_etfile,
+                            -1);
+        FileName = (File_Name *)current_etfile->FileNameCur->data;
+        FileTag = (File_Tag *)current_etfile->FileTag->data;
+
+        if (n_rows >= priv->dlm_items->len)
         {
-            gtk_tree_model_get(GTK_TREE_MODEL(priv->file_model), &iter,
-                               LIST_FILE_NAME,    &current_filename,
-                               LIST_FILE_POINTER, &current_etfile, -1);
-            current_title = ((File_Tag *)current_etfile->FileTag->data)->title;
+            g_array_set_size (priv->dlm_items, n_rows + 1);
+        }
 
-            if ((this = dlm((current_title ? current_title : current_filename), string)) > max) // See "dlm.c"
-            {
-                max = this;
-                iter2 = iter;
-                retval = current_etfile;
-            }
+        item = &g_array_index (priv->dlm_items, EtBrowserDlmItem, n_rows);
+
+        if (item->ETFile == current_etfile && item->name_key == FileName->key
+            && item->tag_key == FileTag->key)
+        {
+            continue;
+        }
+
+        if (FileTag->title)
+        {
+            et_dlm_corpus_set (priv->dlm_corpus, n_rows, FileTag->title);
+        }
+        else
+        {
+            et_dlm_corpus_set (priv->dlm_corpus, n_rows, FileName->name_utf8);
+        }
+
+        item->ETFile = current_etfile;
+        item->name_key = FileName->key;
+        item->tag_key = FileTag->key;
+    }
+
+    g_array_set_size (priv->dlm_items, n_rows);
+    et_dlm_corpus_set_size (priv->dlm_corpus, n_rows);
 
-            g_free (current_filename);
-        } while (gtk_tree_model_iter_next(GTK_TREE_MODEL(priv->file_model), &iter));
+    best = et_dlm_corpus_find_best (priv->dlm_corpus, string, NULL); // See "dlm.c"
+
+    if (best >= 0
+        && gtk_tree_model_iter_nth_child (model, &iter, NULL, best))
+    {
+        gtk_tree_model_get (model, &iter, LIST_FILE_POINTER, &retval, -1);
 
         if (select_it)
         {
@@ -2083,13 +2078,14 @@ et_browser_select_file_by_dlm (EtBrowser *self,
             {
                 g_signal_handler_block (selection,
                                         priv->file_selected_handler);
-                gtk_tree_selection_select_iter(selection, &iter2);
+                gtk_tree_selection_select_iter (selection, &iter);
                 g_signal_handler_unblock (selection,
                                           priv->file_selected_handler);
             }
         }
-        et_browser_set_row_visible (self, &iter2);
+        et_browser_set_row_visible (self, &iter);
     }
+
     return retval;
 }
 
@@ -3051,9 +3047,8 @@ on_file_tree_button_press_event (GtkWidget *widget,
          * when browsing sub-directories). */
         GdkWindow *bin_window;
         GList *l;
-        gchar *path_ref = NULL;
-        gchar *patch_check = NULL;
-        GtkTreePath *currentPath = NULL;
+        gchar *path_ref;
+        gchar *patch_check;
 
         if (!ETCore->ETFileDisplayed)
         {
@@ -3070,24 +3065,19 @@ on_file_tree_button_press_event (GtkWidget *widget,
         }
 
         /* File taken as reference. */
-        path_ref = g_path_get_dirname (((File_Name *)ETCore->ETFileDisplayed->FileNameCur->data)->value);
+        path_ref = et_file_name_get_dirname ((File_Name *)ETCore->ETFileDisplayed->FileNameCur->data);
 
         /* Search and select files of the same directory. */
         for (l = g_list_first (ETCore->ETFileDisplayedList); l != NULL;
              l = g_list_next (l))
         {
             /* Path of the file to check if it is in the same directory. */
-            patch_check = g_path_get_dirname (((File_Name *)((ET_File *)l->data)->FileNameCur->data)->value);
+            patch_check = et_file_name_get_dirname ((File_Name *)((ET_File *)l->data)->FileNameCur->data);
 
-            if (path_ref && patch_check && strcmp (path_ref, patch_check) == 0)
+            if (strcmp (path_ref, patch_check) == 0)
             {
-                /* Use of 'currentPath' to try to increase speed. Indeed, in
-                 * many cases, the next file to select, is the next in the
-                 * list. */
-                currentPath = et_browser_select_file_by_et_file2 (self,
-                                                                  (ET_File *)l->data,
-                                                                  TRUE,
-                                                                  currentPath);
+                et_browser_select_file_by_et_file (self, (ET_File *)l->data,
+                                                   TRUE);
             }
 
             g_free (patch_check);
@@ -3095,11 +3085,6 @@ on_file_tree_button_press_event (GtkWidget *widget,
 
         g_free (path_ref);
 
-        if (currentPath)
-        {
-            gtk_tree_path_free (currentPath);
-        }
-
         return GDK_EVENT_STOP;
     }
     else if (event->type == GDK_3BUTTON_PRESS
@@ -3134,6 +3119,13 @@ Browser_Tree_Initialize (EtBrowser *self)
 
     g_return_if_fail (priv->directory_model != NULL);
 
+    /* Abandon the expansions in progress, and read the directories again. */
+    g_cancellable_cancel (priv->directory_cancellable);
+    g_object_unref (priv->directory_cancellable);
+    priv->directory_cancellable = g_cancellable_new ();
+    g_hash_table_remove_all (priv->directory_loads);
+    et_directory_cache_clear (priv->directory_cache);
+
     gtk_tree_store_clear (priv->directory_model);
 
 #ifdef G_OS_WIN32
@@ -3425,53 +3417,59 @@ Find_Child_Node (EtBrowser *self, GtkTreeIter *parentnode, gchar *childtext)
 }
 
 /*
- * check_for_subdir:
- * @path: (type filename): the path to test
- *
- * Check if @path has any subdirectories.
+ * get_gicon:
+ * @path_state: whether the icon should be shown open or closed
+ * @can_read: whether the directory can be read
+ * @can_write: whether the directory can be written to
  *
- * Returns: %TRUE if subdirectories exist, %FALSE otherwise
+ * Returns: an icon corresponding to a directory with the given permissions
  */
-static gboolean
-check_for_subdir (const gchar *path)
+static GIcon *
+get_gicon (EtPathState path_state, gboolean can_read, gboolean can_write)
 {
-    GFile *dir;
-    GFileEnumerator *enumerator;
-
-    dir = g_file_new_for_path (path);
-    enumerator = g_file_enumerate_children (dir,
-                                            G_FILE_ATTRIBUTE_STANDARD_TYPE ","
-                                            G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN,
-                                            G_FILE_QUERY_INFO_NONE,
-                                            NULL, NULL);
-    g_object_unref (dir);
+    GIcon *folder_icon;
+    GIcon *emblem_icon;
+    GIcon *emblemed_icon;
+    GEmblem *emblem;
 
-    if (enumerator)
+    switch (path_state)
     {
-        GFileInfo *childinfo;
+        case ET_PATH_STATE_OPEN:
+            folder_icon = g_themed_icon_new ("folder-open");
+            break;
+        case ET_PATH_STATE_CLOSED:
+            folder_icon = g_themed_icon_new ("folder");
+            break;
+        default:
+            g_assert_not_reached ();
+    }
 
-        while ((childinfo = g_file_enumerator_next_file (enumerator,
-                                                         NULL, NULL)))
-        {
-            if ((g_file_info_get_file_type (childinfo) ==
-                 G_FILE_TYPE_DIRECTORY) &&
-                (g_settings_get_boolean (MainSettings, "browse-show-hidden")
-                 || !g_file_info_get_is_hidden (childinfo)))
-            {
-                g_object_unref (childinfo);
-                g_file_enumerator_close (enumerator, NULL, NULL);
-                g_object_unref (enumerator);
-                return TRUE;
-            }
+    if (!can_read)
+    {
+        emblem_icon = g_themed_icon_new ("emblem-unreadable");
+        emblem = g_emblem_new_with_origin (emblem_icon,
+                                           G_EMBLEM_ORIGIN_LIVEMETADATA);
+        emblemed_icon = g_emblemed_icon_new (folder_icon, emblem);
+        g_object_unref (folder_icon);
+        g_object_unref (emblem_icon);
+        g_object_unref (emblem);
 
-            g_object_unref (childinfo);
-        }
+        folder_icon = emblemed_icon;
+    }
+    else if (!can_write)
+    {
+        emblem_icon = g_themed_icon_new ("emblem-readonly");
+        emblem = g_emblem_new_with_origin (emblem_icon,
+                                           G_EMBLEM_ORIGIN_LIVEMETADATA);
+        emblemed_icon = g_emblemed_icon_new (folder_icon, emblem);
+        g_object_unref (folder_icon);
+        g_object_unref (emblem_icon);
+        g_object_unref (emblem);
 
-        g_file_enumerator_close (enumerator, NULL, NULL);
-        g_object_unref (enumerator);
+        folder_icon = emblemed_icon;
     }
 
-    return FALSE;
+    return folder_icon;
 }
 
 /*
@@ -3488,25 +3486,10 @@ static GIcon *
 get_gicon_for_path (const gchar *path, EtPathState path_state)
 {
     GIcon *folder_icon;
-    GIcon *emblem_icon;
-    GIcon *emblemed_icon;
-    GEmblem *emblem;
     GFile *file;
     GFileInfo *info;
     GError *error = NULL;
 
-    switch (path_state)
-    {
-        case ET_PATH_STATE_OPEN:
-            folder_icon = g_themed_icon_new ("folder-open");
-            break;
-        case ET_PATH_STATE_CLOSED:
-            folder_icon = g_themed_icon_new ("folder");
-            break;
-        default:
-            g_assert_not_reached ();
-    }
-
     file = g_file_new_for_path (path);
     info = g_file_query_info (file, G_FILE_ATTRIBUTE_ACCESS_CAN_READ ","
                               G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE,
@@ -3523,31 +3506,11 @@ get_gicon_for_path (const gchar *path, EtPathState path_state)
                                            FALSE);
     }
 
-    if (!g_file_info_get_attribute_boolean (info,
-                                            G_FILE_ATTRIBUTE_ACCESS_CAN_READ))
-    {
-        emblem_icon = g_themed_icon_new ("emblem-unreadable");
-        emblem = g_emblem_new_with_origin (emblem_icon,
-                                           G_EMBLEM_ORIGIN_LIVEMETADATA);
-        emblemed_icon = g_emblemed_icon_new (folder_icon, emblem);
-        g_object_unref (folder_icon);
-        g_object_unref (emblem_icon);
-        g_object_unref (emblem);
-
-        folder_icon = emblemed_icon;
-    }
-    else if (!g_file_info_get_attribute_boolean (info, G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE))
-    {
-        emblem_icon = g_themed_icon_new ("emblem-readonly");
-        emblem = g_emblem_new_with_origin (emblem_icon,
-                                           G_EMBLEM_ORIGIN_LIVEMETADATA);
-        emblemed_icon = g_emblemed_icon_new (folder_icon, emblem);
-        g_object_unref (folder_icon);
-        g_object_unref (emblem_icon);
-        g_object_unref (emblem);
-
-        folder_icon = emblemed_icon;
-    }
+    folder_icon = get_gicon (path_state,
+                             g_file_info_get_attribute_boolean (info,
+                                                                G_FILE_ATTRIBUTE_ACCESS_CAN_READ),
+                             g_file_info_get_attribute_boolean (info,
+                                                                G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE));
 
     g_object_unref (file);
     g_object_unref (info);
@@ -3556,112 +3519,295 @@ get_gicon_for_path (const gchar *path, EtPathState path_state)
 }
 
 /*
- * Open up a node on the browser tree
- * Scanning and showing all subdirectories
+ * Remove the dummy node, which has no path, giving @parent an expander until
+ * its subdirectories are inserted.
  */
 static void
-expand_cb (EtBrowser *self, GtkTreeIter *iter, GtkTreePath *gtreePath, GtkTreeView *tree)
+remove_dummy_node (EtBrowser *self, GtkTreeIter *parent)
 {
     EtBrowserPrivate *priv;
-    GFile *dir;
-    GFileEnumerator *enumerator;
-    gchar *fullpath_file;
-    gchar *parentPath;
-    gboolean treeScanned;
-    gboolean has_subdir = FALSE;
-    GtkTreeIter currentIter;
-    GtkTreeIter subNodeIter;
-    GIcon *icon;
+    GtkTreeIter child;
+    gchar *path;
 
     priv = et_browser_get_instance_private (self);
 
-    g_return_if_fail (priv->directory_model != NULL);
+    /* The dummy node sorts first, as it has no name. */
+    if (!gtk_tree_model_iter_children (GTK_TREE_MODEL (priv->directory_model),
+                                       &child, parent))
+    {
+        return;
+    }
 
-    gtk_tree_model_get(GTK_TREE_MODEL(priv->directory_model), iter,
-                       TREE_COLUMN_FULL_PATH, &parentPath,
-                       TREE_COLUMN_SCANNED,   &treeScanned, -1);
+    gtk_tree_model_get (GTK_TREE_MODEL (priv->directory_model), &child,
+                        TREE_COLUMN_FULL_PATH, &path, -1);
 
-    if (treeScanned)
-        return;
+    if (path == NULL)
+    {
+        gtk_tree_store_remove (priv->directory_model, &child);
+    }
 
-    dir = g_file_new_for_path (parentPath);
-    enumerator = g_file_enumerate_children (dir,
-                                            G_FILE_ATTRIBUTE_STANDARD_TYPE ","
-                                            G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME ","
-                                            G_FILE_ATTRIBUTE_STANDARD_NAME ","
-                                            G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN,
-                                            G_FILE_QUERY_INFO_NONE,
-                                            NULL, NULL);
+    g_free (path);
+}
 
-    if (enumerator)
+/*
+ * insert_directory_entries:
+ * @self: the browser
+ * @parent: the row of the listed directory
+ * @listing: the #EtDirectoryEntry of each subdirectory
+ * @start: the index of the first entry to insert
+ * @end: the index after the last entry to insert
+ * @show_hidden: whether to insert hidden subdirectories
+ * @probe_rows: the rows of the subdirectories which must be probed for
+ * subdirectories are added here
+ *
+ * Insert rows for some subdirectories of the directory of @parent, with a
+ * dummy node for those which may have subdirectories themselves. No I/O is
+ * done, so that large directories do not block the interface.
+ */
+static void
+insert_directory_entries (EtBrowser *self,
+                          GtkTreeIter *parent,
+                          GPtrArray *listing,
+                          guint start,
+                          guint end,
+                          gboolean show_hidden,
+                          GPtrArray *probe_rows)
+{
+    EtBrowserPrivate *priv;
+    gchar *parent_path;
+    guint i;
+
+    priv = et_browser_get_instance_private (self);
+
+    gtk_tree_model_get (GTK_TREE_MODEL (priv->directory_model), parent,
+                        TREE_COLUMN_FULL_PATH, &parent_path, -1);
+
+    for (i = start; i < end; i++)
     {
-        GFileInfo *childinfo;
+        const EtDirectoryEntry *entry = g_ptr_array_index (listing, i);
+        gchar *path;
+        GIcon *icon;
+        GtkTreeIter iter;
+        GtkTreeIter dummy_iter;
+
+        if (entry->is_hidden && !show_hidden)
+        {
+            continue;
+        }
+
+        path = g_build_filename (parent_path, entry->name, NULL);
+        icon = get_gicon (ET_PATH_STATE_CLOSED, entry->can_read,
+                          entry->can_write);
+
+        gtk_tree_store_insert_with_values (priv->directory_model, &iter,
+                                           parent, G_MAXINT,
+                                           TREE_COLUMN_DIR_NAME,
+                                           entry->display_name,
+                                           TREE_COLUMN_FULL_PATH, path,
+                                           TREE_COLUMN_HAS_SUBDIR,
+                                           entry->subdirs != ET_DIRECTORY_SUBDIRS_NONE,
+                                           TREE_COLUMN_SCANNED, FALSE,
+                                           TREE_COLUMN_ICON, icon, -1);
 
-        while ((childinfo = g_file_enumerator_next_file (enumerator,
-                                                         NULL, NULL))
-               != NULL)
+        /* The subdirectories may all be hidden, in which case the dummy node
+         * is removed by the probe. */
+        if (entry->subdirs == ET_DIRECTORY_SUBDIRS_UNKNOWN
+            || (entry->subdirs == ET_DIRECTORY_SUBDIRS_SOME && !show_hidden))
         {
-            GFile *child;
-            gboolean isdir;
+            GtkTreePath *tree_path;
 
-            child = g_file_enumerator_get_child (enumerator, childinfo);
-            fullpath_file = g_file_get_path (child);
-            isdir = g_file_info_get_file_type (childinfo) == G_FILE_TYPE_DIRECTORY;
+            tree_path = gtk_tree_model_get_path (GTK_TREE_MODEL (priv->directory_model),
+                                                 &iter);
+            g_ptr_array_add (probe_rows,
+                             gtk_tree_row_reference_new (GTK_TREE_MODEL (priv->directory_model),
+                                                         tree_path));
+            gtk_tree_path_free (tree_path);
+        }
 
-            if (isdir &&
-                (g_settings_get_boolean (MainSettings, "browse-show-hidden")
-                 || !g_file_info_get_is_hidden (childinfo)))
-            {
-                const gchar *dirname_utf8;
-                dirname_utf8 = g_file_info_get_display_name (childinfo);
-
-                has_subdir = check_for_subdir (fullpath_file);
-
-                /* Select pixmap according permissions for the directory. */
-                icon = get_gicon_for_path (fullpath_file,
-                                           ET_PATH_STATE_CLOSED);
-
-                gtk_tree_store_insert_with_values (priv->directory_model,
-                                                   &currentIter, iter,
-                                                   G_MAXINT,
-                                                   TREE_COLUMN_DIR_NAME,
-                                                   dirname_utf8,
-                                                   TREE_COLUMN_FULL_PATH,
-                                                   fullpath_file,
-                                                   TREE_COLUMN_HAS_SUBDIR,
-                                                   !has_subdir,
-                                                   TREE_COLUMN_SCANNED, FALSE,
-                                                   TREE_COLUMN_ICON, icon, -1);
+        if (entry->subdirs != ET_DIRECTORY_SUBDIRS_NONE)
+        {
+            gtk_tree_store_append (priv->directory_model, &dummy_iter, &iter);
+        }
 
-                if (has_subdir)
-                {
-                    /* Insert a dummy node. */
-                    gtk_tree_store_append(priv->directory_model, &subNodeIter, &currentIter);
-                }
+        g_object_unref (icon);
+        g_free (path);
+    }
 
-                g_object_unref (icon);
-            }
+    g_free (parent_path);
+}
+
+/*
+ * EtBrowserDirectoryProbe:
+ * @browser: the browser
+ * @rows: the rows of the probed directories
+ *
+ * Rows of the directory tree which are being checked for subdirectories.
+ */
+typedef struct
+{
+    EtBrowser *browser;
+    GPtrArray *rows;
+} EtBrowserDirectoryProbe;
+
+static void
+directory_probe_free (EtBrowserDirectoryProbe *probe)
+{
+    g_object_unref (probe->browser);
+    g_ptr_array_unref (probe->rows);
+    g_slice_free (EtBrowserDirectoryProbe, probe);
+}
+
+static void
+on_directory_probed (GObject *source_object,
+                     GAsyncResult *result,
+                     gpointer user_data)
+{
+    EtBrowserDirectoryProbe *probe = user_data;
+    EtBrowserPrivate *priv;
+    GArray *results;
+    guint i;
+
+    priv = et_browser_get_instance_private (probe->browser);
+    results = et_directory_probe_finish (result, NULL);
+
+    /* Cancelled, as the tree was reinitialized. */
+    if (results == NULL)
+    {
+        directory_probe_free (probe);
+        return;
+    }
+
+    for (i = 0; i < results->len; i++)
+    {
+        GtkTreePath *tree_path;
+        GtkTreeIter iter;
+        gchar *path;
+        gboolean scanned;
+
+        if (g_array_index (results, gboolean, i))
+        {
+            continue;
+        }
+
+        tree_path = gtk_tree_row_reference_get_path (g_ptr_array_index (probe->rows,
+                                                                        i));
+
+        /* The row was removed, by collapsing its parent. */
+        if (tree_path == NULL)
+        {
+            continue;
+        }
+
+        gtk_tree_model_get_iter (GTK_TREE_MODEL (priv->directory_model),
+                                 &iter, tree_path);
+        gtk_tree_path_free (tree_path);
+        gtk_tree_model_get (GTK_TREE_MODEL (priv->directory_model), &iter,
+                            TREE_COLUMN_FULL_PATH, &path,
+                            TREE_COLUMN_SCANNED, &scanned, -1);
 
-            g_free (fullpath_file);
-            g_object_unref (childinfo);
-            g_object_unref (child);
+        /* Leave rows which were expanded meanwhile. */
+        if (!scanned && !g_hash_table_contains (priv->directory_loads, path))
+        {
+            remove_dummy_node (probe->browser, &iter);
+            gtk_tree_store_set (priv->directory_model, &iter,
+                                TREE_COLUMN_HAS_SUBDIR, FALSE, -1);
         }
 
-        g_file_enumerator_close (enumerator, NULL, NULL);
-        g_object_unref (enumerator);
+        g_free (path);
+    }
+
+    g_array_unref (results);
+    directory_probe_free (probe);
+}
+
+/*
+ * Check, in the background, whether the directories of @rows have
+ * subdirectories, removing the dummy node of those which do not.
+ */
+static void
+start_directory_probes (EtBrowser *self,
+                        GPtrArray *rows,
+                        gboolean show_hidden)
+{
+    EtBrowserPrivate *priv;
+    guint i;
+
+    priv = et_browser_get_instance_private (self);
+
+    for (i = 0; i < rows->len; i += DIRECTORY_PROBE_BATCH_SIZE)
+    {
+        EtBrowserDirectoryProbe *probe;
+        GPtrArray *directories;
+        guint j;
+
+        probe = g_slice_new (EtBrowserDirectoryProbe);
+        probe->browser = g_object_ref (self);
+        probe->rows = g_ptr_array_new_with_free_func ((GDestroyNotify)gtk_tree_row_reference_free);
+        directories = g_ptr_array_new_with_free_func (g_object_unref);
+
+        for (j = i; j < MIN (i + DIRECTORY_PROBE_BATCH_SIZE, rows->len); j++)
+        {
+            GtkTreeRowReference *row = g_ptr_array_index (rows, j);
+            GtkTreePath *tree_path;
+            GtkTreeIter iter;
+            gchar *path;
+
+            tree_path = gtk_tree_row_reference_get_path (row);
+
+            if (tree_path == NULL)
+            {
+                continue;
+            }
+
+            gtk_tree_model_get_iter (GTK_TREE_MODEL (priv->directory_model),
+                                     &iter, tree_path);
+            gtk_tree_path_free (tree_path);
+            gtk_tree_model_get (GTK_TREE_MODEL (priv->directory_model),
+                                &iter, TREE_COLUMN_FULL_PATH, &path, -1);
+
+            g_ptr_array_add (directories, g_file_new_for_path (path));
+            g_ptr_array_add (probe->rows, gtk_tree_row_reference_copy (row));
+            g_free (path);
+        }
 
-        /* Remove dummy node. */
-        gtk_tree_model_iter_children (GTK_TREE_MODEL (priv->directory_model),
-                                      &subNodeIter, iter);
-        gtk_tree_store_remove (priv->directory_model, &subNodeIter);
+        et_directory_probe_async (directories, show_hidden,
+                                  priv->directory_cancellable,
+                                  on_directory_probed, probe);
+        g_ptr_array_unref (directories);
     }
+}
 
-    g_object_unref (dir);
-    icon = get_gicon_for_path (parentPath, ET_PATH_STATE_OPEN);
+/*
+ * Mark the directory of @iter as scanned, once its subdirectories were all
+ * inserted, and probe those for which it is not known whether they have
+ * subdirectories.
+ */
+static void
+finish_directory_expansion (EtBrowser *self,
+                            GtkTreeIter *iter,
+                            GPtrArray *probe_rows,
+                            gboolean show_hidden)
+{
+    EtBrowserPrivate *priv;
+    gchar *path;
+    GIcon *icon;
+#ifdef G_OS_WIN32
+    GtkTreePath *tree_path;
+#endif /* G_OS_WIN32 */
+
+    priv = et_browser_get_instance_private (self);
+
+    gtk_tree_model_get (GTK_TREE_MODEL (priv->directory_model), iter,
+                        TREE_COLUMN_FULL_PATH, &path, -1);
+    icon = get_gicon_for_path (path, ET_PATH_STATE_OPEN);
+    g_free (path);
 
 #ifdef G_OS_WIN32
     // set open folder pixmap except on drive (depth == 0)
-    if (gtk_tree_path_get_depth(gtreePath) > 1)
+    tree_path = gtk_tree_model_get_path (GTK_TREE_MODEL (priv->directory_model),
+                                         iter);
+
+    if (gtk_tree_path_get_depth (tree_path) > 1)
     {
         // update the icon of the node to opened folder :-)
         gtk_tree_store_set(priv->directory_model, iter,
@@ -3669,6 +3815,8 @@ expand_cb (EtBrowser *self, GtkTreeIter *iter, GtkTreePath *gtreePath, GtkTreeVi
                            TREE_COLUMN_ICON, icon,
                            -1);
     }
+
+    gtk_tree_path_free (tree_path);
 #else /* !G_OS_WIN32 */
     // update the icon of the node to opened folder :-)
     gtk_tree_store_set(priv->directory_model, iter,
@@ -3680,8 +3828,297 @@ expand_cb (EtBrowser *self, GtkTreeIter *iter, GtkTreePath *gtreePath, GtkTreeVi
     gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(priv->directory_model),
                                          TREE_COLUMN_DIR_NAME, GTK_SORT_ASCENDING);
 
+    start_directory_probes (self, probe_rows, show_hidden);
+
     g_object_unref (icon);
-    g_free(parentPath);
+}
+
+static void
+directory_load_free (EtBrowserDirectoryLoad *load)
+{
+    g_object_unref (load->browser);
+    gtk_tree_row_reference_free (load->row);
+    g_free (load->path);
+
+    if (load->listing)
+    {
+        g_ptr_array_unref (load->listing);
+    }
+
+    g_ptr_array_unref (load->probe_rows);
+    g_slice_free (EtBrowserDirectoryLoad, load);
+}
+
+/*
+ * directory_load_is_current:
+ * @load: the load to check
+ * @iter: (out caller-allocates): the row of the directory being loaded
+ *
+ * Check whether @load is still the expansion in progress for its row, rather
+ * than having been cancelled by collapsing the row, by a synchronous
+ * expansion or by reinitializing the tree.
+ *
+ * Returns: %TRUE, with @iter set, if @load is current, %FALSE otherwise
+ */
+static gboolean
+directory_load_is_current (EtBrowserDirectoryLoad *load,
+                           GtkTreeIter *iter)
+{
+    EtBrowserPrivate *priv;
+    GtkTreePath *tree_path;
+
+    priv = et_browser_get_instance_private (load->browser);
+
+    if (g_hash_table_lookup (priv->directory_loads, load->path) != load)
+    {
+        return FALSE;
+    }
+
+    tree_path = gtk_tree_row_reference_get_path (load->row);
+
+    /* The row was removed, by collapsing its parent. */
+    if (tree_path == NULL)
+    {
+        g_hash_table_remove (priv->directory_loads, load->path);
+        return FALSE;
+    }
+
+    gtk_tree_model_get_iter (GTK_TREE_MODEL (priv->directory_model), iter,
+                             tree_path);
+    gtk_tree_path_free (tree_path);
+
+    return TRUE;
+}
+
+static gboolean
+on_directory_load_idle (gpointer user_data)
+{
+    EtBrowserDirectoryLoad *load = user_data;
+    EtBrowserPrivate *priv;
+    GtkTreeIter iter;
+    guint end;
+
+    if (!directory_load_is_current (load, &iter))
+    {
+        directory_load_free (load);
+        return G_SOURCE_REMOVE;
+    }
+
+    priv = et_browser_get_instance_private (load->browser);
+    end = MIN (load->next + DIRECTORY_LOAD_BATCH_SIZE, load->listing->len);
+    insert_directory_entries (load->browser, &iter, load->listing, load->next,
+                              end, load->show_hidden, load->probe_rows);
+
+    /* Only once there are other children, so that the row stays expanded. */
+    if (load->next == 0)
+    {
+        remove_dummy_node (load->browser, &iter);
+    }
+
+    load->next = end;
+
+    if (load->next < load->listing->len)
+    {
+        return G_SOURCE_CONTINUE;
+    }
+
+    g_hash_table_remove (priv->directory_loads, load->path);
+    finish_directory_expansion (load->browser, &iter, load->probe_rows,
+                                load->show_hidden);
+    directory_load_free (load);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+on_directory_listed (GObject *source_object,
+                     GAsyncResult *result,
+                     gpointer user_data)
+{
+    EtBrowserDirectoryLoad *load = user_data;
+    EtBrowserPrivate *priv;
+    GtkTreeIter iter;
+
+    priv = et_browser_get_instance_private (load->browser);
+    load->listing = et_directory_cache_list_finish (result, NULL);
+
+    if (!directory_load_is_current (load, &iter))
+    {
+        directory_load_free (load);
+        return;
+    }
+
+    /* An unreadable directory keeps its dummy node, as it may still have
+     * subdirectories which can be entered. */
+    if (load->listing == NULL)
+    {
+        g_hash_table_remove (priv->directory_loads, load->path);
+        finish_directory_expansion (load->browser, &iter, load->probe_rows,
+                                    load->show_hidden);
+        directory_load_free (load);
+        return;
+    }
+
+    g_idle_add (on_directory_load_idle, load);
+}
+
+/*
+ * Insert the subdirectories of the directory of @iter immediately, finishing
+ * an expansion which was in progress in the background, if any.
+ */
+static void
+load_directory_synchronously (EtBrowser *self, GtkTreeIter *iter)
+{
+    EtBrowserPrivate *priv;
+    EtBrowserDirectoryLoad *load;
+    gchar *path;
+    GPtrArray *listing;
+    GPtrArray *probe_rows;
+    guint start = 0;
+    gboolean show_hidden;
+
+    priv = et_browser_get_instance_private (self);
+
+    gtk_tree_model_get (GTK_TREE_MODEL (priv->directory_model), iter,
+                        TREE_COLUMN_FULL_PATH, &path, -1);
+    load = g_hash_table_lookup (priv->directory_loads, path);
+
+    if (load && load->listing)
+    {
+        listing = g_ptr_array_ref (load->listing);
+        start = load->next;
+        show_hidden = load->show_hidden;
+    }
+    else
+    {
+        GFile *directory;
+
+        directory = g_file_new_for_path (path);
+        listing = et_directory_cache_list (priv->directory_cache, directory,
+                                           NULL, NULL);
+        show_hidden = g_settings_get_boolean (MainSettings,
+                                              "browse-show-hidden");
+        g_object_unref (directory);
+    }
+
+    if (load)
+    {
+        probe_rows = g_ptr_array_ref (load->probe_rows);
+
+        /* The load is now stale, and frees itself. */
+        g_hash_table_remove (priv->directory_loads, path);
+    }
+    else
+    {
+        probe_rows = g_ptr_array_new_with_free_func ((GDestroyNotify)gtk_tree_row_reference_free);
+    }
+
+    if (listing)
+    {
+        insert_directory_entries (self, iter, listing, start, listing->len,
+                                  show_hidden, probe_rows);
+        remove_dummy_node (self, iter);
+        g_ptr_array_unref (listing);
+    }
+
+    finish_directory_expansion (self, iter, probe_rows, show_hidden);
+
+    g_ptr_array_unref (probe_rows);
+    g_free (path);
+}
+
+/*
+ * expand_to_path_synchronously:
+ * @self: the browser
+ * @path: the row to expand
+ *
+ * Expand @path and its parents, inserting the subdirectories immediately
+ * rather than in the background, so that they can be searched straight away.
+ */
+static void
+expand_to_path_synchronously (EtBrowser *self, GtkTreePath *path)
+{
+    EtBrowserPrivate *priv;
+    GtkTreeIter iter;
+    gboolean scanned;
+
+    priv = et_browser_get_instance_private (self);
+
+    priv->expand_synchronously = TRUE;
+    gtk_tree_view_expand_to_path (GTK_TREE_VIEW (priv->directory_view), path);
+    priv->expand_synchronously = FALSE;
+
+    /* A row which was already being expanded in the background is not
+     * expanded again. */
+    if (gtk_tree_model_get_iter (GTK_TREE_MODEL (priv->directory_model),
+                                 &iter, path))
+    {
+        gtk_tree_model_get (GTK_TREE_MODEL (priv->directory_model), &iter,
+                            TREE_COLUMN_SCANNED, &scanned, -1);
+
+        if (!scanned)
+        {
+            load_directory_synchronously (self, &iter);
+        }
+    }
+}
+
+/*
+ * Open up a node on the browser tree
+ * Showing all subdirectories, which are listed and inserted in the background
+ */
+static void
+expand_cb (EtBrowser *self, GtkTreeIter *iter, GtkTreePath *gtreePath, GtkTreeView *tree)
+{
+    EtBrowserPrivate *priv;
+    EtBrowserDirectoryLoad *load;
+    GFile *directory;
+    gchar *parentPath;
+    gboolean treeScanned;
+
+    priv = et_browser_get_instance_private (self);
+
+    g_return_if_fail (priv->directory_model != NULL);
+
+    gtk_tree_model_get(GTK_TREE_MODEL(priv->directory_model), iter,
+                       TREE_COLUMN_FULL_PATH, &parentPath,
+                       TREE_COLUMN_SCANNED,   &treeScanned, -1);
+
+    if (treeScanned)
+    {
+        g_free (parentPath);
+        return;
+    }
+
+    if (priv->expand_synchronously)
+    {
+        g_free (parentPath);
+        load_directory_synchronously (self, iter);
+        return;
+    }
+
+    /* Already being expanded. */
+    if (g_hash_table_contains (priv->directory_loads, parentPath))
+    {
+        g_free (parentPath);
+        return;
+    }
+
+    load = g_slice_new0 (EtBrowserDirectoryLoad);
+    load->browser = g_object_ref (self);
+    load->row = gtk_tree_row_reference_new (GTK_TREE_MODEL (priv->directory_model),
+                                            gtreePath);
+    load->path = parentPath;
+    load->show_hidden = g_settings_get_boolean (MainSettings,
+                                                "browse-show-hidden");
+    load->probe_rows = g_ptr_array_new_with_free_func ((GDestroyNotify)gtk_tree_row_reference_free);
+    g_hash_table_insert (priv->directory_loads, load->path, load);
+
+    directory = g_file_new_for_path (parentPath);
+    et_directory_cache_list_async (priv->directory_cache, directory,
+                                   priv->directory_cancellable,
+                                   on_directory_listed, load);
+    g_object_unref (directory);
 }
 
 static void
@@ -3702,6 +4139,9 @@ collapse_cb (EtBrowser *self, GtkTreeIter *iter, GtkTreePath *treePath, GtkTreeV
     gtk_tree_model_get (GTK_TREE_MODEL (priv->directory_model), iter,
                         TREE_COLUMN_FULL_PATH, &path, -1);
 
+    /* Abandon the expansion, if still in progress. */
+    g_hash_table_remove (priv->directory_loads, path);
+
     /* If the directory is not readable, do not delete its children. */
     file = g_file_new_for_path (path);
     g_free (path);
@@ -3768,6 +4208,33 @@ collapse_cb (EtBrowser *self, GtkTreeIter *iter, GtkTreePath *treePath, GtkTreeV
     g_object_unref (icon);
 }
 
+/*
+ * The style of the rows of changed files depends on the setting, so restyle
+ * all the rows.
+ */
+static void
+on_file_changed_bold_changed (EtBrowser *self,
+                              gchar *key,
+                              GSettings *settings)
+{
+    EtBrowserPrivate *priv;
+    GtkTreeIter iter;
+    gboolean valid;
+
+    priv = et_browser_get_instance_private (self);
+
+    priv->file_changed_bold = g_settings_get_boolean (settings, key);
+
+    for (valid = gtk_tree_model_get_iter_first (GTK_TREE_MODEL (priv->file_model),
+                                                &iter);
+         valid;
+         valid = gtk_tree_model_iter_next (GTK_TREE_MODEL (priv->file_model),
+                                           &iter))
+    {
+        Browser_List_Set_Row_Appearance (self, &iter);
+    }
+}
+
 static void
 on_sort_mode_changed (EtBrowser *self, gchar *key, GSettings *settings)
 {
@@ -3978,6 +4445,10 @@ create_browser (EtBrowser *self)
 
     g_signal_connect_swapped (MainSettings, "changed::sort-mode",
                               G_CALLBACK (on_sort_mode_changed), self);
+    priv->file_changed_bold = g_settings_get_boolean (MainSettings,
+                                                      "file-changed-bold");
+    g_signal_connect_swapped (MainSettings, "changed::file-changed-bold",
+                              G_CALLBACK (on_file_changed_bold_changed), self);
     // To sort list
     gtk_tree_sortable_set_sort_func (GTK_TREE_SORTABLE (priv->file_model), 0,
                                       Browser_List_Sort_Func, NULL, NULL);
@@ -4462,8 +4933,7 @@ Rename_Directory (EtBrowser *self)
         return;
     }
 
-    et_file_list_update_directory_name (ETCore->ETFileList, last_path,
-                                        new_path);
+    et_file_name_rename_directory (last_path, new_path);
     Browser_Tree_Rename_Directory (self, last_path, new_path);
 
     // To update file path in the browser entry
@@ -4685,8 +5155,7 @@ Run_Program_With_Selected_Files (EtBrowser *self)
                                 LIST_FILE_POINTER, &ETFile, -1);
 
             args_list = g_list_prepend (args_list,
-                                        ((File_Name *)ETFile->FileNameCur->data)->value);
-            //args_list = g_list_append(args_list,((File_Name *)ETFile->FileNameCur->data)->value_utf8);
+                                        et_file_name_get_path ((File_Name *)ETFile->FileNameCur->data));
         }
     }
 
@@ -4694,7 +5163,7 @@ Run_Program_With_Selected_Files (EtBrowser *self)
     program_ran = et_run_program (program_name, args_list, &error);
 
     g_list_free_full (selected_paths, (GDestroyNotify)gtk_tree_path_free);
-    g_list_free(args_list);
+    g_list_free_full (args_list, g_free);
 
     if (program_ran)
     {
@@ -4970,6 +5439,10 @@ et_browser_destroy (GtkWidget *widget)
         /* The model is disposed when the combo box is disposed. */
     }
 
+    /* Pending expansions and probes free themselves once cancelled. */
+    g_cancellable_cancel (priv->directory_cancellable);
+    g_hash_table_remove_all (priv->directory_loads);
+
     GTK_WIDGET_CLASS (et_browser_parent_class)->destroy (widget);
 }
 
@@ -4982,6 +5455,12 @@ et_browser_finalize (GObject *object)
 
     g_clear_object (&priv->current_path);
     g_clear_object (&priv->run_program_model);
+    g_clear_pointer (&priv->dlm_corpus, et_dlm_corpus_free);
+    g_clear_pointer (&priv->dlm_items, g_array_unref);
+    g_clear_pointer (&priv->directory_cache, et_directory_cache_free);
+    g_clear_object (&priv->directory_cancellable);
+    g_clear_pointer (&priv->directory_loads, g_hash_table_unref);
+    g_clear_pointer (&priv->file_rows, g_hash_table_unref);
 
     G_OBJECT_CLASS (et_browser_parent_class)->finalize (object);
 }
@@ -4989,6 +5468,17 @@ et_browser_finalize (GObject *object)
 static void
 et_browser_init (EtBrowser *self)
 {
+    EtBrowserPrivate *priv;
+
+    priv = et_browser_get_instance_private (self);
+    priv->dlm_corpus = et_dlm_corpus_new ();
+    priv->dlm_items = g_array_new (FALSE, TRUE, sizeof (EtBrowserDlmItem));
+    priv->directory_cache = et_directory_cache_new ();
+    priv->directory_cancellable = g_cancellable_new ();
+    priv->directory_loads = g_hash_table_new (g_str_hash, g_str_equal);
+    priv->file_rows = g_hash_table_new_full (NULL, NULL, NULL,
+                                             (GDestroyNotify)gtk_tree_iter_free);
+
     gtk_widget_init_template (GTK_WIDGET (self));
     create_browser (self);
 }
@@ -78,7 +78,6 @@ void et_browser_refresh_list (EtBrowser *self);
 void et_browser_refresh_file_in_list (EtBrowser *self, const ET_File *ETFile);
 void et_browser_clear (EtBrowser *self);
 void et_browser_select_file_by_et_file (EtBrowser *self, const ET_File *ETFile, gboolean select_it);
-GtkTreePath * et_browser_select_file_by_et_file2 (EtBrowser *self, const ET_File *searchETFile, gboolean select_it, GtkTreePath *startPath);
 void et_browser_select_file_by_iter_string (EtBrowser *self, const gchar* stringiter, gboolean select_it);
 ET_File *et_browser_select_file_by_dlm (EtBrowser *self, const gchar* string, gboolean select_it);
 void et_browser_refresh_sort (EtBrowser *self);
@@ -0,0 +1,660 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include "cddb_client.h"
+
+#include <errno.h>
+#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+
+/*
+ * EtCddbClient:
+ * @session: the session used to send the requests
+ * @cache_path: the directory of the response cache, or %NULL
+ * @cache_max_age: the time, in seconds, for which a cached response is used,
+ *                 or -1 to use cached responses regardless of their age
+ * @max_requests: the maximum number of requests sent at the same time
+ * @pending: the #GTask of the requests waiting for a free slot
+ * @active: the #GTask of the requests which were sent
+ *
+ * Sends the HTTP requests of the CDDB dialog, reading each response fully
+ * into memory. Successful responses are stored in @cache_path, named after a
+ * checksum of the request URI, which contains the query or the disc ID.
+ */
+struct _EtCddbClient
+{
+    SoupSession *session;
+    gchar *cache_path;
+    gint64 cache_max_age;
+    guint max_requests;
+    GQueue pending;
+    GList *active;
+};
+
+/*
+ * CddbRequest:
+ * @client: the client, or %NULL if it was freed while the request was active
+ * @uri: the request URI
+ * @io_priority: the priority of the request in the queue
+ * @cache_file: the file in the response cache for @uri, or %NULL
+ * @message: the message, once it was sent
+ * @cancellable: cancelled when either the caller's cancellable is cancelled,
+ *               or the client is freed
+ * @cancelled_source: (allow-none): watches the caller's cancellable, from
+ *                    when the request is queued until it completes
+ *
+ * The task data of a fetch.
+ */
+typedef struct
+{
+    EtCddbClient *client;
+    gchar *uri;
+    gint io_priority;
+    gchar *cache_file;
+    SoupMessage *message;
+    GCancellable *cancellable;
+    GSource *cancelled_source;
+} CddbRequest;
+
+static void cddb_client_process_queue (EtCddbClient *client);
+
+static gchar *
+cache_file_for_uri (EtCddbClient *client,
+                    const gchar *uri)
+{
+    gchar *checksum;
+    gchar *path;
+
+    if (client->cache_path == NULL)
+    {
+        return NULL;
+    }
+
+    checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, uri, -1);
+    path = g_build_filename (client->cache_path, checksum, NULL);
+    g_free (checksum);
+
+    return path;
+}
+
+static void
+cddb_request_clear_cancelled_source (CddbRequest *request)
+{
+    if (request->cancelled_source != NULL)
+    {
+        g_source_destroy (request->cancelled_source);
+        g_source_unref (request->cancelled_source);
+        request->cancelled_source = NULL;
+    }
+}
+
+static void
+cddb_request_free (CddbRequest *request)
+{
+    cddb_request_clear_cancelled_source (request);
+    g_free (request->uri);
+    g_free (request->cache_file);
+    g_clear_object (&request->message);
+    g_clear_object (&request->cancellable);
+    g_slice_free (CddbRequest, request);
+}
+
+/*
+ * cache_lookup:
+ * @client: the client
+ * @request: the request to look up
+ *
+ * Read the cached response for @request, if there is a recent enough one.
+ * The responses are small, so they are read synchronously.
+ *
+ * Returns: the cached response, or %NULL
+ */
+static GBytes *
+cache_lookup (EtCddbClient *client,
+              CddbRequest *request)
+{
+    GStatBuf statbuf;
+    gchar *contents;
+    gsize length;
+
+    if (request->cache_file == NULL
+        || g_stat (request->cache_file, &statbuf) != 0)
+    {
+        return NULL;
+    }
+
+    if (client->cache_max_age >= 0
+        && g_get_real_time () / G_USEC_PER_SEC - statbuf.st_mtime
+           > client->cache_max_age)
+    {
+        return NULL;
+    }
+
+    if (!g_file_get_contents (request->cache_file, &contents, &length, NULL))
+    {
+        return NULL;
+    }
+
+    return g_bytes_new_take (contents, length);
+}
+
+static void
+cache_store (EtCddbClient *client,
+             CddbRequest *request,
+             GBytes *bytes)
+{
+    gconstpointer data;
+    gsize size;
+    GError *error = NULL;
+
+    if (request->cache_file == NULL)
+    {
+        return;
+    }
+
+    if (g_mkdir_with_parents (client->cache_path, 0700) != 0)
+    {
+        g_debug ("Unable to create CDDB cache directory ‘%s’: %s",
+                 client->cache_path, g_strerror (errno));
+        return;
+    }
+
+    data = g_bytes_get_data (bytes, &size);
+
+    if (!g_file_set_contents (request->cache_file, data, size, &error))
+    {
+        g_debug ("Unable to write CDDB cache file: %s", error->message);
+        g_error_free (error);
+    }
+}
+
+/*
+ * error_from_message:
+ * @message: the message which failed
+ * @error: (allow-none): the transport error, if any
+ *
+ * Create an error for @message, based on its status code and @error, which
+ * is only set for transport errors.
+ *
+ * Returns: a new #GError
+ */
+static GError *
+error_from_message (SoupMessage *message,
+                    const GError *error)
+{
+    SoupURI *uri;
+    const gchar *reason;
+
+    uri = soup_message_get_uri (message);
+    reason = error ? error->message : message->reason_phrase;
+
+    if (!SOUP_STATUS_IS_TRANSPORT_ERROR (message->status_code))
+    {
+        return g_error_new (G_IO_ERROR, G_IO_ERROR_FAILED,
+                            _("The server returned a bad response ‘%s’"),
+                            reason);
+    }
+
+    switch (message->status_code)
+    {
+        case SOUP_STATUS_CANT_RESOLVE:
+        case SOUP_STATUS_CANT_RESOLVE_PROXY:
+            return g_error_new (G_IO_ERROR, G_IO_ERROR_HOST_NOT_FOUND,
+                                _("Cannot resolve host: ‘%s’: %s"),
+                                soup_uri_get_host (uri), reason);
+        case SOUP_STATUS_CANT_CONNECT:
+        case SOUP_STATUS_CANT_CONNECT_PROXY:
+        case SOUP_STATUS_TOO_MANY_REDIRECTS:
+        default:
+            return g_error_new (G_IO_ERROR, G_IO_ERROR_FAILED,
+                                _("Cannot connect to host: ‘%s’: %s"),
+                                soup_uri_get_host (uri), reason);
+    }
+}
+
+/*
+ * cddb_request_finish:
+ * @task: the task of an active request
+ *
+ * Release the slot of @task, and send the next pending request.
+ */
+static void
+cddb_request_finish (GTask *task)
+{
+    CddbRequest *request;
+    EtCddbClient *client;
+
+    request = g_task_get_task_data (task);
+    client = request->client;
+
+    cddb_request_clear_cancelled_source (request);
+
+    if (client != NULL)
+    {
+        client->active = g_list_remove (client->active, task);
+        cddb_client_process_queue (client);
+    }
+}
+
+static void
+on_response_read (GObject *source_object,
+                  GAsyncResult *result,
+                  gpointer user_data)
+{
+    GTask *task;
+    CddbRequest *request;
+    GOutputStream *ostream;
+    GBytes *bytes;
+    GError *error = NULL;
+
+    task = G_TASK (user_data);
+    request = g_task_get_task_data (task);
+    ostream = G_OUTPUT_STREAM (source_object);
+
+    if (g_output_stream_splice_finish (ostream, result, &error) < 0)
+    {
+        cddb_request_finish (task);
+        g_task_return_error (task, error);
+        g_object_unref (task);
+        return;
+    }
+
+    bytes = g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM (ostream));
+
+    if (request->client != NULL)
+    {
+        cache_store (request->client, request, bytes);
+    }
+
+    cddb_request_finish (task);
+    g_task_return_pointer (task, bytes, (GDestroyNotify)g_bytes_unref);
+    g_object_unref (task);
+}
+
+static void
+on_request_sent (GObject *source_object,
+                 GAsyncResult *result,
+                 gpointer user_data)
+{
+    GTask *task;
+    CddbRequest *request;
+    GInputStream *istream;
+    GOutputStream *ostream;
+    GError *error = NULL;
+
+    task = G_TASK (user_data);
+    request = g_task_get_task_data (task);
+
+    istream = soup_session_send_finish (SOUP_SESSION (source_object), result,
+                                        &error);
+
+    if (istream == NULL || request->message->status_code != SOUP_STATUS_OK)
+    {
+        if (error == NULL
+            || !g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+            GError *tmp_error;
+
+            tmp_error = error_from_message (request->message, error);
+            g_clear_error (&error);
+            error = tmp_error;
+        }
+
+        g_clear_object (&istream);
+        cddb_request_finish (task);
+        g_task_return_error (task, error);
+        g_object_unref (task);
+        return;
+    }
+
+    /* Read the whole response, so that it can be cached and parsed without
+     * blocking. */
+    ostream = g_memory_output_stream_new_resizable ();
+    g_output_stream_splice_async (ostream, istream,
+                                  G_OUTPUT_STREAM_SPLICE_CLOSE_SOURCE
+                                  | G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET,
+                                  G_PRIORITY_DEFAULT, request->cancellable,
+                                  on_response_read, task);
+    g_object_unref (ostream);
+    g_object_unref (istream);
+}
+
+/*
+ * on_caller_cancelled:
+ * @cancellable: the caller's cancellable
+ * @user_data: the task of the request
+ *
+ * Complete a queued request at once, rather than once a slot frees up, or
+ * cancel the message of an active request.
+ *
+ * Returns: %G_SOURCE_REMOVE
+ */
+static gboolean
+on_caller_cancelled (GCancellable *cancellable,
+                     gpointer user_data)
+{
+    GTask *task;
+    CddbRequest *request;
+
+    task = G_TASK (user_data);
+    request = g_task_get_task_data (task);
+
+    if (request->client != NULL
+        && g_queue_remove (&request->client->pending, task))
+    {
+        g_task_return_error_if_cancelled (task);
+        g_object_unref (task);
+    }
+    else
+    {
+        g_cancellable_cancel (request->cancellable);
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+cddb_client_send (EtCddbClient *client,
+                  GTask *task)
+{
+    CddbRequest *request;
+
+    request = g_task_get_task_data (task);
+    request->message = soup_message_new (SOUP_METHOD_GET, request->uri);
+
+    if (request->message == NULL)
+    {
+        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+                                 _("Invalid CDDB request URI: %s"),
+                                 request->uri);
+        g_object_unref (task);
+        return;
+    }
+
+    client->active = g_list_prepend (client->active, task);
+    soup_session_send_async (client->session, request->message,
+                             request->cancellable, on_request_sent, task);
+}
+
+/*
+ * cddb_client_process_queue:
+ * @client: the client
+ *
+ * Send pending requests, until the limit of active requests is reached.
+ */
+static void
+cddb_client_process_queue (EtCddbClient *client)
+{
+    while (g_list_length (client->active) < client->max_requests
+           && !g_queue_is_empty (&client->pending))
+    {
+        GTask *task;
+
+        task = g_queue_pop_head (&client->pending);
+
+        if (g_task_return_error_if_cancelled (task))
+        {
+            cddb_request_clear_cancelled_source (g_task_get_task_data (task));
+            g_object_unref (task);
+            continue;
+        }
+
+        cddb_client_send (client, task);
+    }
+}
+
+/*
+ * et_cddb_client_new:
+ * @session: the session with which to send the requests
+ * @cache_path: (allow-none): the directory in which to cache responses, or
+ *              %NULL to disable the cache
+ * @max_requests: the maximum number of requests to send at the same time
+ *
+ * Create a new CDDB client. Responses are cached for
+ * %ET_CDDB_CLIENT_CACHE_MAX_AGE seconds.
+ *
+ * Returns: a new #EtCddbClient, free with et_cddb_client_free()
+ */
+EtCddbClient *
+et_cddb_client_new (SoupSession *session,
+                    const gchar *cache_path,
+                    guint max_requests)
+{
+    EtCddbClient *client;
+
+    g_return_val_if_fail (SOUP_IS_SESSION (session), NULL);
+    g_return_val_if_fail (max_requests > 0, NULL);
+
+    client = g_slice_new0 (EtCddbClient);
+    client->session = g_object_ref (session);
+    client->cache_path = g_strdup (cache_path);
+    client->cache_max_age = ET_CDDB_CLIENT_CACHE_MAX_AGE;
+    client->max_requests = max_requests;
+    g_queue_init (&client->pending);
+
+    return client;
+}
+
+/*
+ * et_cddb_client_free:
+ * @client: the client to free
+ *
+ * Free @client. Pending and active requests complete with
+ * %G_IO_ERROR_CANCELLED.
+ */
+void
+et_cddb_client_free (EtCddbClient *client)
+{
+    GTask *task;
+    GList *l;
+
+    g_return_if_fail (client != NULL);
+
+    while ((task = g_queue_pop_head (&client->pending)) != NULL)
+    {
+        CddbRequest *request;
+
+        request = g_task_get_task_data (task);
+        request->client = NULL;
+        cddb_request_clear_cancelled_source (request);
+        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_CANCELLED, "%s",
+                                 _("Operation was cancelled"));
+        g_object_unref (task);
+    }
+
+    /* The active requests complete asynchronously, once the client is
+     * gone. */
+    for (l = client->active; l != NULL; l = g_list_next (l))
+    {
+        CddbRequest *request;
+
+        request = g_task_get_task_data (G_TASK (l->data));
+        request->client = NULL;
+        g_cancellable_cancel (request->cancellable);
+    }
+
+    g_list_free (client->active);
+    g_object_unref (client->session);
+    g_free (client->cache_path);
+    g_slice_free (EtCddbClient, client);
+}
+
+/*
+ * et_cddb_client_set_cache_max_age:
+ * @client: the client
+ * @max_age: the time, in seconds, for which a cached response is used, or -1
+ *           to use cached responses regardless of their age
+ *
+ * Set the maximum age of the cached responses which are used.
+ */
+void
+et_cddb_client_set_cache_max_age (EtCddbClient *client,
+                                  gint64 max_age)
+{
+    g_return_if_fail (client != NULL);
+
+    client->cache_max_age = max_age;
+}
+
+/*
+ * et_cddb_client_get_n_active:
+ * @client: the client
+ *
+ * Get the number of requests which were sent and have not yet completed.
+ *
+ * Returns: the number of active requests
+ */
+guint
+et_cddb_client_get_n_active (EtCddbClient *client)
+{
+    g_return_val_if_fail (client != NULL, 0);
+
+    return g_list_length (client->active);
+}
+
+/*
+ * et_cddb_client_invalidate:
+ * @client: the client
+ * @uri: the URI of the response to remove
+ *
+ * Remove the cached response for @uri, for instance because the server
+ * returned an error in the body of a successful response.
+ */
+void
+et_cddb_client_invalidate (EtCddbClient *client,
+                           const gchar *uri)
+{
+    gchar *path;
+
+    g_return_if_fail (client != NULL);
+    g_return_if_fail (uri != NULL);
+
+    if ((path = cache_file_for_uri (client, uri)) != NULL)
+    {
+        g_unlink (path);
+        g_free (path);
+    }
+}
+
+/*
+ * et_cddb_client_fetch_async:
+ * @client: the client
+ * @uri: the URI to fetch
+ * @io_priority: the priority of the request, such as %G_PRIORITY_DEFAULT
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @callback: called when the response was read
+ * @user_data: user data for @callback
+ *
+ * Fetch @uri, either from the response cache or from the server. The
+ * request is queued if the maximum number of requests are already active,
+ * ahead of queued requests with a lower priority (a higher value of
+ * @io_priority). Call et_cddb_client_fetch_finish() from @callback to get
+ * the response.
+ */
+void
+et_cddb_client_fetch_async (EtCddbClient *client,
+                            const gchar *uri,
+                            gint io_priority,
+                            GCancellable *cancellable,
+                            GAsyncReadyCallback callback,
+                            gpointer user_data)
+{
+    GTask *task;
+    CddbRequest *request;
+    GBytes *bytes;
+    GList *l;
+
+    g_return_if_fail (client != NULL);
+    g_return_if_fail (uri != NULL);
+
+    task = g_task_new (NULL, cancellable, callback, user_data);
+    g_task_set_source_tag (task, et_cddb_client_fetch_async);
+
+    request = g_slice_new0 (CddbRequest);
+    request->client = client;
+    request->uri = g_strdup (uri);
+    request->io_priority = io_priority;
+    request->cache_file = cache_file_for_uri (client, uri);
+
+    g_task_set_task_data (task, request, (GDestroyNotify)cddb_request_free);
+
+    if ((bytes = cache_lookup (client, request)) != NULL)
+    {
+        g_task_return_pointer (task, bytes, (GDestroyNotify)g_bytes_unref);
+        g_object_unref (task);
+        return;
+    }
+
+    /* Watch the caller's cancellable while the request is queued too, so
+     * that cancelling it does not wait for a slot. */
+    request->cancellable = g_cancellable_new ();
+
+    if (cancellable != NULL)
+    {
+        request->cancelled_source = g_cancellable_source_new (cancellable);
+        g_task_attach_source (task, request->cancelled_source,
+                              (GSourceFunc)on_caller_cancelled);
+    }
+
+    for (l = client->pending.head; l != NULL; l = g_list_next (l))
+    {
+        const CddbRequest *queued;
+
+        queued = g_task_get_task_data (G_TASK (l->data));
+
+        if (queued->io_priority > io_priority)
+        {
+            break;
+        }
+    }
+
+    if (l != NULL)
+    {
+        g_queue_insert_before (&client->pending, l, task);
+    }
+    else
+    {
+        g_queue_push_tail (&client->pending, task);
+    }
+
+    cddb_client_process_queue (client);
+}
+
+/*
+ * et_cddb_client_fetch_finish:
+ * @result: the result passed to the callback
+ * @error: a #GError, or %NULL
+ *
+ * Finish fetching a URI. The result is not tied to the client, so it may
+ * be finished after the client was freed.
+ *
+ * Returns: the response body, or %NULL with @error set on failure
+ */
+GBytes *
+et_cddb_client_fetch_finish (GAsyncResult *result,
+                             GError **error)
+{
+    g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
+    g_return_val_if_fail (g_async_result_is_tagged (result,
+                                                    et_cddb_client_fetch_async),
+                          NULL);
+
+    return g_task_propagate_pointer (G_TASK (result), error);
+}
@@ -0,0 +1,54 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ET_CDDB_CLIENT_H_
+#define ET_CDDB_CLIENT_H_
+
+#include <libsoup/soup.h>
+
+G_BEGIN_DECLS
+
+/*
+ * ET_CDDB_CLIENT_MAX_REQUESTS:
+ *
+ * The default number of requests which are sent to the CDDB servers at the
+ * same time. Further requests are queued.
+ */
+#define ET_CDDB_CLIENT_MAX_REQUESTS 4
+
+/*
+ * ET_CDDB_CLIENT_CACHE_MAX_AGE:
+ *
+ * The default time, in seconds, for which a cached response is used instead
+ * of sending the request again.
+ */
+#define ET_CDDB_CLIENT_CACHE_MAX_AGE (7 * 24 * 60 * 60)
+
+typedef struct _EtCddbClient EtCddbClient;
+
+EtCddbClient * et_cddb_client_new (SoupSession *session, const gchar *cache_path, guint max_requests);
+void et_cddb_client_free (EtCddbClient *client);
+void et_cddb_client_set_cache_max_age (EtCddbClient *client, gint64 max_age);
+guint et_cddb_client_get_n_active (EtCddbClient *client);
+void et_cddb_client_invalidate (EtCddbClient *client, const gchar *uri);
+void et_cddb_client_fetch_async (EtCddbClient *client, const gchar *uri, gint io_priority, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data);
+GBytes * et_cddb_client_fetch_finish (GAsyncResult *result, GError **error);
+
+G_END_DECLS
+
+#endif /* !ET_CDDB_CLIENT_H_ */
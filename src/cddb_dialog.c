@@ -44,6 +44,8 @@
 #include "id3_tag.h"
 #include "setting.h"
 #include "charset.h"
+#include "cddb_client.h"
+#include "cddb_local.h"
 
 typedef struct
 {
@@ -65,8 +67,6 @@ typedef struct
     GtkWidget *status_bar;
     guint status_bar_context;
 
-    gboolean stop_searching;
-
     GtkWidget *artist_check;
     GtkWidget *album_check;
     GtkWidget *track_check;
@@ -96,6 +96,13 @@ typedef struct
     GtkWidget *dlm_check;
 
     SoupSession *session;
+    EtCddbClient *client;
+    GCancellable *search_cancellable;
+    GCancellable *album_cancellable;
+    guint prefetch_source_id;
+
+    EtCddbLocal *local;
+    GCancellable *local_cancellable;
 } EtCDDBDialogPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (EtCDDBDialog, et_cddb_dialog, GTK_TYPE_DIALOG)
@@ -126,6 +133,7 @@ typedef struct
     gchar *genre; /* (allocated) */
     gchar *year; /* (allocated) */
     guint duration;
+    gboolean loading; /* TRUE while the track list is being fetched. */
 } CddbAlbum;
 
 
@@ -194,6 +202,14 @@ static const gchar *cddb_genre_vs_id3_genre [][2] =
 };
 
 static const guint MAX_STRING_LEN = 1024;
+/* Number of times to send a read request, as the server may return a wrong
+ * answer the first time. */
+static const guint CDDB_READ_MAX_ATTEMPTS = 5;
+/* Number of albums for which to prefetch the track list, if the album list
+ * was not drawn yet. */
+static const gint CDDB_PREFETCH_ALBUMS = 16;
+/* Time, in milliseconds, to wait for scrolling to stop before prefetching. */
+static const guint CDDB_PREFETCH_DELAY = 200;
 
 
 /**************
@@ -573,21 +589,6 @@ cddb_track_frame_offset_free (CddbTrackFrameOffset *offset)
     g_slice_free (CddbTrackFrameOffset, offset);
 }
 
-/*
- * check_message_successful:
- * @message: the message on which to check for success
- *
- * Check the result of @message to see whether it was a success. Soup handles
- * redirects, so that the result code is that of the final request.
- *
- * Returns: %TRUE if the request was successful, %FALSE otherwise
- */
-static gboolean
-check_message_successful (SoupMessage *message)
-{
-    return message->status_code == SOUP_STATUS_OK;
-}
-
 /*
  * read_cddb_result_line:
  * @dstream: a #GDataInputStream corresponding to a CDDB result, with the line
@@ -693,172 +694,154 @@ read_cddb_header_line (GDataInputStream *dstream,
 }
 
 /*
- * log_message_from_request_error:
- * @message: the message which failed to be sent
- * @error: the error associated with the failed message
+ * cddb_data_input_stream_new:
+ * @bytes: a response from a CDDB server
  *
- * Create an appropriate message for @message based on the status code and
- * contents of @error.
+ * Create a stream to read @bytes line by line.
  *
- * Returns: a newly-allocated string
+ * Returns: a new #GDataInputStream
  */
-static gchar *
-log_message_from_request_error (SoupMessage *message,
-                                GError *error)
+static GDataInputStream *
+cddb_data_input_stream_new (GBytes *bytes)
 {
-    SoupURI *uri;
-    gchar *msg;
-
-    uri = soup_message_get_uri (message);
+    GInputStream *istream;
+    GDataInputStream *dstream;
 
-    switch (message->status_code)
-    {
-        case SOUP_STATUS_CANT_RESOLVE:
-        case SOUP_STATUS_CANT_RESOLVE_PROXY:
-            msg = g_strdup_printf (_("Cannot resolve host: ‘%s’: %s"),
-                                   soup_uri_get_host (uri), error->message);
-            break;
-        case SOUP_STATUS_CANT_CONNECT:
-        case SOUP_STATUS_CANT_CONNECT_PROXY:
-        case SOUP_STATUS_TOO_MANY_REDIRECTS:
-        default:
-            msg = g_strdup_printf (_("Cannot connect to host: ‘%s’: %s"),
-                                   soup_uri_get_host (uri), error->message);
-    }
+    istream = g_memory_input_stream_new_from_bytes (bytes);
+    dstream = g_data_input_stream_new (istream);
+    g_object_unref (istream);
+    g_data_input_stream_set_newline_type (dstream,
+                                          G_DATA_STREAM_NEWLINE_TYPE_ANY);
 
-    return msg;
+    return dstream;
 }
 
 /*
- * Look up a specific album in freedb, and save to a CddbAlbum structure
+ * cddb_album_new:
+ * @server_name: the name of the server which returned the album
+ * @server_port: the port of the server
+ * @server_cgi_path: the CGI path on the server
+ *
+ * Create a new album, to be filled from a search result.
+ *
+ * Returns: a new #CddbAlbum, free with cddb_album_free()
  */
-static gboolean
-Cddb_Get_Album_Tracks_List (EtCDDBDialog *self, GtkTreeSelection* selection)
+static CddbAlbum *
+cddb_album_new (const gchar *server_name,
+                guint server_port,
+                const gchar *server_cgi_path)
 {
-    EtCDDBDialogPrivate *priv;
-    CddbAlbum *cddbalbum = NULL;
-    GList     *TrackOffsetList = NULL;
-    gchar *uri;
-    gchar *cddb_out = NULL;
-    gchar *msg, *copy, *valid;
-    gchar     *cddb_server_name;
-    guint cddb_server_port;
-    gchar     *cddb_server_cgi_path;
-    gboolean   read_track_offset = FALSE;
-    GtkTreeIter row;
-    SoupMessage *message;
-    GCancellable *cancellable;
-    GError *error = NULL;
-    GInputStream *istream;
-    GDataInputStream *dstream;
+    CddbAlbum *cddbalbum;
 
-    priv = et_cddb_dialog_get_instance_private (self);
+    cddbalbum = g_slice_new0 (CddbAlbum);
 
-    cddb_track_model_clear (self);
-    update_apply_button_sensitivity (self);
+    /* Parameters of the server used. */
+    cddbalbum->server_name = g_strdup (server_name);
+    cddbalbum->server_port = server_port;
+    cddbalbum->server_cgi_path = g_strdup (server_cgi_path);
+    cddbalbum->bitmap = server_name ? Cddb_Get_Pixbuf_From_Server_Name (server_name)
+                                    : NULL;
 
-    if (gtk_tree_selection_get_selected(selection, NULL, &row))
-    {
-        gtk_tree_model_get(GTK_TREE_MODEL(priv->album_list_model), &row, CDDB_ALBUM_LIST_DATA, &cddbalbum, -1);
-    }
-    if (!cddbalbum)
-        return FALSE;
+    return cddbalbum;
+}
 
-    // We have already the track list
-    if (cddbalbum->track_list != NULL)
+static void
+cddb_album_free (CddbAlbum *cddbalbum)
+{
+    g_free (cddbalbum->server_name);
+    g_free (cddbalbum->server_cgi_path);
+    g_clear_object (&cddbalbum->bitmap);
+
+    g_free (cddbalbum->artist_album);
+    g_free (cddbalbum->category);
+    g_free (cddbalbum->id);
+
+    if (cddbalbum->track_list)
     {
-        Cddb_Load_Track_Album_List (self, cddbalbum->track_list);
-        return TRUE;
+        Cddb_Free_Track_Album_List (cddbalbum->track_list);
+        cddbalbum->track_list = NULL;
     }
 
-    // Parameters of the server used
-    cddb_server_name     = cddbalbum->server_name;
-    cddb_server_port     = cddbalbum->server_port;
-    cddb_server_cgi_path = cddbalbum->server_cgi_path;
+    g_free (cddbalbum->artist);
+    g_free (cddbalbum->album);
+    g_free (cddbalbum->genre);
+    g_free (cddbalbum->year);
 
+    g_slice_free (CddbAlbum, cddbalbum);
+}
 
-    /* Connection to the server. */
-    if (strstr (cddb_server_name, "gnudb") != NULL)
+/*
+ * cddb_album_get_read_uri:
+ * @cddbalbum: an album from a search result
+ *
+ * Get the URI from which to read the details and track list of @cddbalbum.
+ *
+ * Returns: a newly-allocated string
+ */
+static gchar *
+cddb_album_get_read_uri (const CddbAlbum *cddbalbum)
+{
+    if (strstr (cddbalbum->server_name, "gnudb") != NULL)
     {
         /* For gnudb. */
-        uri = g_strdup_printf ("http://%s:%u/gnudb/%s/%s", cddb_server_name,
-                               cddb_server_port, cddbalbum->category,
-                               cddbalbum->id);
+        return g_strdup_printf ("http://%s:%u/gnudb/%s/%s",
+                                cddbalbum->server_name,
+                                cddbalbum->server_port, cddbalbum->category,
+                                cddbalbum->id);
     }
     else
     {
         /* CDDB Request (ex: GET /~cddb/cddb.cgi?cmd=cddb+read+jazz+0200a401&hello=noname+localhost+EasyTAG+0.31&proto=1 HTTP/1.1\r\nHost: freedb.freedb.org:80\r\nConnection: close). */
-        uri = g_strdup_printf ("http://%s:%u%s?cmd=cddb+read+%s+%s&hello=noname+localhost+%s+%s&proto=6",
-                               cddb_server_name, cddb_server_port,
-                               cddb_server_cgi_path, cddbalbum->category,
-                               cddbalbum->id, PACKAGE_NAME, PACKAGE_VERSION);
-    }
-
-    /* Send the request. */
-    gtk_statusbar_push(GTK_STATUSBAR(priv->status_bar),priv->status_bar_context,_("Sending request…"));
-    while (gtk_events_pending()) gtk_main_iteration();
-
-    /* Write result in a file. */
-    message = soup_message_new (SOUP_METHOD_GET, uri);
-
-    if (!message)
-    {
-        g_critical ("Invalid CDDB request URI: %s", uri);
-        g_free (uri);
-        return FALSE;
+        return g_strdup_printf ("http://%s:%u%s?cmd=cddb+read+%s+%s&hello=noname+localhost+%s+%s&proto=6",
+                                cddbalbum->server_name,
+                                cddbalbum->server_port,
+                                cddbalbum->server_cgi_path,
+                                cddbalbum->category, cddbalbum->id,
+                                PACKAGE_NAME, PACKAGE_VERSION);
     }
+}
 
-    g_free (uri);
-
-    cancellable = g_cancellable_new ();
-    istream = soup_session_send (priv->session, message, cancellable,
-                                 &error);
-
-    if (!check_message_successful (message))
-    {
-        msg = log_message_from_request_error (message, error);
-        gtk_statusbar_push (GTK_STATUSBAR (priv->status_bar),
-                            priv->status_bar_context, msg);
-        Log_Print (LOG_ERROR, "%s", msg);
-        g_free (msg);
-        g_error_free (error);
-        g_object_unref (cancellable);
-        g_object_unref (message);
-        gtk_widget_set_sensitive (GTK_WIDGET (priv->stop_search_button),FALSE);
-        return FALSE;
-    }
+/*
+ * cddb_album_parse_tracks:
+ * @cddbalbum: the album to fill
+ * @bytes: the response to the read request of @cddbalbum
+ * @bad_response: (out): a location to store the first line of a bad response
+ *
+ * Parse the album details and the track list of @cddbalbum from @bytes.
+ *
+ * Returns: %TRUE on success, %FALSE if the server returned an error, in which
+ *          case @bad_response is set
+ */
+static gboolean
+cddb_album_parse_tracks (CddbAlbum *cddbalbum,
+                         GBytes *bytes,
+                         gchar **bad_response)
+{
+    GList     *TrackOffsetList = NULL;
+    gchar *cddb_out = NULL;
+    gchar *copy, *valid;
+    gboolean   read_track_offset = FALSE;
+    GDataInputStream *dstream;
 
-    dstream = g_data_input_stream_new (istream);
-    g_object_unref (istream);
-    g_data_input_stream_set_newline_type (dstream,
-                                          G_DATA_STREAM_NEWLINE_TYPE_ANY);
+    dstream = cddb_data_input_stream_new (bytes);
 
-    /* Parse server answer: Check CDDB Header (freedb only). */
-    if (strstr (cddb_server_name, "gnudb") == NULL)
+    /* Parse server answer: Check CDDB Header (freedb only). The records of a
+     * local dump have no header. */
+    if (cddbalbum->server_name != NULL
+        && strstr (cddbalbum->server_name, "gnudb") == NULL)
     {
         /* For freedb. */
-        if (!read_cddb_header_line (dstream, cancellable, &cddb_out))
+        if (!read_cddb_header_line (dstream, NULL, &cddb_out))
         {
-            msg = g_strdup_printf (_("The server returned a bad response ‘%s’"),
-                                   cddb_out);
-            gtk_statusbar_push (GTK_STATUSBAR (priv->status_bar),
-                                priv->status_bar_context, msg);
-            Log_Print (LOG_ERROR, "%s", msg);
-
             g_object_unref (dstream);
-            g_object_unref (cancellable);
-            g_object_unref (message);
-            g_free (msg);
-            g_free (cddb_out);
-
+            *bad_response = cddb_out;
             return FALSE;
         }
     }
 
     g_free (cddb_out);
 
-    while (!priv->stop_searching
-           && read_cddb_result_line (dstream, cancellable, &cddb_out))
+    while (read_cddb_result_line (dstream, NULL, &cddb_out))
     {
         if (!cddb_out) // Empty line?
             continue;
@@ -1023,198 +1006,584 @@ Cddb_Get_Album_Tracks_List (EtCDDBDialog *self, GtkTreeSelection* selection)
         g_free(cddb_out);
     }
 
-    /* Remote access. */
-    /* Close connection */
     g_object_unref (dstream);
-    g_object_unref (cancellable);
-    g_object_unref (message);
-
-    /* Set color of the selected row (without reloading the whole list) */
-    Cddb_Album_List_Set_Row_Appearance (self, &row);
-
-    /* Load the track list of the album */
-    gtk_statusbar_push(GTK_STATUSBAR(priv->status_bar),priv->status_bar_context,_("Loading album track list…"));
-    while (gtk_events_pending()) gtk_main_iteration();
-    Cddb_Load_Track_Album_List (self, cddbalbum->track_list);
-
-    show_album_info (self, gtk_tree_view_get_selection (GTK_TREE_VIEW (priv->album_list_view)));
-
     g_list_free_full (g_list_first (TrackOffsetList),
                       (GDestroyNotify)cddb_track_frame_offset_free);
-    return TRUE;
-}
-
-/*
- * Callback when selecting a row in the Album List.
- * We get the list of tracks of the selected album
- */
-static void
-Cddb_Get_Album_Tracks_List_CB (EtCDDBDialog *self, GtkTreeSelection *selection)
-{
-    gint i;
-    gint i_max = 5;
 
-    /* As may be not opened the first time (The server returned a wrong answer!)
-     * me try to reconnect severals times */
-    for (i = 1; i <= i_max; i++)
-    {
-        if (Cddb_Get_Album_Tracks_List (self, selection) == TRUE)
-        {
-            break;
-        }
-    }
+    return TRUE;
 }
 
 /*
- * Load the priv->album_list into the corresponding List
+ * cddb_album_list_get_selected:
+ * @self: the CDDB dialog
+ *
+ * Get the album of the selected row of the album list.
+ *
+ * Returns: (transfer none): the selected album, or %NULL
  */
-static void
-Cddb_Load_Album_List (EtCDDBDialog *self, gboolean only_red_lines)
+static CddbAlbum *
+cddb_album_list_get_selected (EtCDDBDialog *self)
 {
     EtCDDBDialogPrivate *priv;
-    GtkTreeIter iter;
-    GList *l;
-
     GtkTreeSelection *selection;
-    GList            *selectedRows = NULL;
-    GtkTreeIter       currentIter;
-    CddbAlbum        *cddbalbumSelected = NULL;
+    GtkTreeIter row;
+    CddbAlbum *cddbalbum = NULL;
 
     priv = et_cddb_dialog_get_instance_private (self);
 
-    // Memorize the current selected item
-    selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(priv->album_list_view));
-    selectedRows = gtk_tree_selection_get_selected_rows(selection, NULL);
-    if (selectedRows)
-    {
-        if (gtk_tree_model_get_iter(GTK_TREE_MODEL(priv->album_list_model), &currentIter, (GtkTreePath*)selectedRows->data))
-            gtk_tree_model_get(GTK_TREE_MODEL(priv->album_list_model), &currentIter,
-                               CDDB_ALBUM_LIST_DATA, &cddbalbumSelected, -1);
-    }
-
-    /* Remove lines. */
-    cddb_album_model_clear (self);
+    selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (priv->album_list_view));
 
-    // Reload list following parameter 'only_red_lines'
-    for (l = g_list_first (priv->album_list); l != NULL; l = g_list_next (l))
+    if (gtk_tree_selection_get_selected (selection, NULL, &row))
     {
-        CddbAlbum *cddbalbum = l->data;
-
-        if ( (only_red_lines && cddbalbum->track_list) || !only_red_lines)
-        {
-            /* Load the row in the list. */
-            gtk_list_store_insert_with_values (priv->album_list_model, &iter,
-                                               G_MAXINT,
-                                               CDDB_ALBUM_LIST_PIXBUF,
-                                               cddbalbum->bitmap,
-                                               CDDB_ALBUM_LIST_ALBUM,
-                                               cddbalbum->artist_album,
-                                               CDDB_ALBUM_LIST_CATEGORY,
-                                               cddbalbum->category,
-                                               CDDB_ALBUM_LIST_DATA,
-                                               cddbalbum, -1);
-
-            Cddb_Album_List_Set_Row_Appearance (self, &iter);
-
-            // Select this item if it is the saved one...
-            if (cddbalbum == cddbalbumSelected)
-                gtk_tree_selection_select_iter(gtk_tree_view_get_selection(GTK_TREE_VIEW(priv->album_list_view)), &iter);
-        }
+        gtk_tree_model_get (GTK_TREE_MODEL (priv->album_list_model), &row,
+                            CDDB_ALBUM_LIST_DATA, &cddbalbum, -1);
     }
+
+    return cddbalbum;
 }
 
 /*
- * Free priv->album_list
+ * cddb_album_list_find_row:
+ * @self: the CDDB dialog
+ * @cddbalbum: the album to find
+ * @row: (out): an iter to set to the row of @cddbalbum
+ *
+ * Find the row of @cddbalbum in the album list.
+ *
+ * Returns: %TRUE if the row was found, %FALSE otherwise
  */
 static gboolean
-Cddb_Free_Album_List (EtCDDBDialog *self)
+cddb_album_list_find_row (EtCDDBDialog *self,
+                          const CddbAlbum *cddbalbum,
+                          GtkTreeIter *row)
 {
     EtCDDBDialogPrivate *priv;
-    GList *l;
+    GtkTreeModel *model;
+    gboolean valid;
 
     priv = et_cddb_dialog_get_instance_private (self);
+    model = GTK_TREE_MODEL (priv->album_list_model);
 
-    g_return_val_if_fail (priv->album_list != NULL, FALSE);
-
-    priv->album_list = g_list_first (priv->album_list);
-
-    for (l = priv->album_list; l != NULL; l = g_list_next (l))
+    for (valid = gtk_tree_model_get_iter_first (model, row); valid;
+         valid = gtk_tree_model_iter_next (model, row))
     {
-        CddbAlbum *cddbalbum = l->data;
-
-        if (cddbalbum)
-        {
-            g_free(cddbalbum->server_name);
-            g_free (cddbalbum->server_cgi_path);
-            g_object_unref(cddbalbum->bitmap);
+        CddbAlbum *row_album;
 
-            g_free(cddbalbum->artist_album);
-            g_free(cddbalbum->category);
-            g_free(cddbalbum->id);
-            if (cddbalbum->track_list)
-            {
-                Cddb_Free_Track_Album_List(cddbalbum->track_list);
-                cddbalbum->track_list = NULL;
-            }
-            g_free(cddbalbum->artist);
-            g_free(cddbalbum->album);
-            g_free(cddbalbum->genre);
-            g_free(cddbalbum->year);
+        gtk_tree_model_get (model, row, CDDB_ALBUM_LIST_DATA, &row_album, -1);
 
-            g_slice_free (CddbAlbum, cddbalbum);
+        if (row_album == cddbalbum)
+        {
+            return TRUE;
         }
     }
 
-    g_list_free (priv->album_list);
-    priv->album_list = NULL;
+    return FALSE;
+}
 
-    return TRUE;
+/*
+ * CddbTrackRequest:
+ * @self: the CDDB dialog
+ * @cddbalbum: the album for which the track list is fetched
+ * @uri: the URI of the read request
+ * @io_priority: the priority of the request
+ * @attempts: the number of failed attempts so far
+ *
+ * A request for the track list of an album, either because it was selected,
+ * or to prefetch it.
+ */
+typedef struct
+{
+    EtCDDBDialog *self;
+    CddbAlbum *cddbalbum;
+    gchar *uri;
+    gint io_priority;
+    guint attempts;
+} CddbTrackRequest;
+
+static void
+cddb_track_request_free (CddbTrackRequest *request)
+{
+    g_free (request->uri);
+    g_slice_free (CddbTrackRequest, request);
 }
 
+static void cddb_track_request_send (CddbTrackRequest *request);
+
 /*
- * Fields          : artist, title, track, rest
- * CDDB Categories : blues, classical, country, data, folk, jazz, misc, newage, reggae, rock, soundtrack
+ * cddb_album_show_tracks:
+ * @self: the CDDB dialog
+ * @cddbalbum: an album for which the track list was loaded
+ *
+ * Update the row of @cddbalbum, and show its track list if it is selected.
  */
-static gchar *
-Cddb_Generate_Request_String_With_Fields_And_Categories_Options (EtCDDBDialog *self)
+static void
+cddb_album_show_tracks (EtCDDBDialog *self,
+                        CddbAlbum *cddbalbum)
 {
-    GString *string;
-    guint search_fields;
-    guint search_categories;
+    EtCDDBDialogPrivate *priv;
+    GtkTreeIter row;
 
-    /* Init. */
-    string = g_string_sized_new (256);
+    priv = et_cddb_dialog_get_instance_private (self);
 
-    /* Fields. */
-    /* FIXME: Fetch cddb-search-fields "all-set" mask. */
-#if 0
-    if (search_all_fields)
+    /* Set color of the row (without reloading the whole list) */
+    if (cddb_album_list_find_row (self, cddbalbum, &row))
     {
-        g_string_append (string, "&allfields=YES");
+        Cddb_Album_List_Set_Row_Appearance (self, &row);
     }
-    else
+
+    /* Load the track list of the album, if it is still selected. */
+    if (cddb_album_list_get_selected (self) == cddbalbum)
     {
-        g_string_append (string, "&allfields=NO");
+        Cddb_Load_Track_Album_List (self, cddbalbum->track_list);
+        show_album_info (self, gtk_tree_view_get_selection (GTK_TREE_VIEW (priv->album_list_view)));
     }
-#endif
+}
 
-    search_fields = g_settings_get_flags (MainSettings, "cddb-search-fields");
+static void
+on_album_tracks_fetched (GObject *source_object,
+                         GAsyncResult *result,
+                         gpointer user_data)
+{
+    CddbTrackRequest *request;
+    EtCDDBDialog *self;
+    EtCDDBDialogPrivate *priv;
+    CddbAlbum *cddbalbum;
+    GBytes *bytes;
+    gchar *bad_response = NULL;
+    gchar *msg = NULL;
+    GError *error = NULL;
 
-    if (search_fields & ET_CDDB_SEARCH_FIELD_ARTIST)
-    {
-        g_string_append (string, "&fields=artist");
-    }
-    if (search_fields & ET_CDDB_SEARCH_FIELD_TITLE)
+    request = user_data;
+    bytes = et_cddb_client_fetch_finish (result, &error);
+
+    if (bytes == NULL
+        && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
     {
-        g_string_append (string, "&fields=title");
+        /* The album list was freed or the search was stopped, so neither the
+         * album nor the dialog may be used. */
+        g_error_free (error);
+        cddb_track_request_free (request);
+        return;
     }
-    if (search_fields & ET_CDDB_SEARCH_FIELD_TRACK)
+
+    self = request->self;
+    priv = et_cddb_dialog_get_instance_private (self);
+    cddbalbum = request->cddbalbum;
+
+    if (bytes == NULL)
     {
-        g_string_append (string, "&fields=track");
+        msg = g_strdup (error->message);
+        g_error_free (error);
     }
-    if (search_fields & ET_CDDB_SEARCH_FIELD_OTHER)
+    else
     {
-        g_string_append (string, "&fields=rest");
+        if (!cddb_album_parse_tracks (cddbalbum, bytes, &bad_response))
+        {
+            msg = g_strdup_printf (_("The server returned a bad response ‘%s’"),
+                                   bad_response);
+            g_free (bad_response);
+
+            /* Do not use the cached response when trying again. */
+            et_cddb_client_invalidate (priv->client, request->uri);
+        }
+
+        g_bytes_unref (bytes);
+    }
+
+    if (msg != NULL)
+    {
+        /* As the server may return a wrong answer the first time, try
+         * several times. */
+        if (++request->attempts < CDDB_READ_MAX_ATTEMPTS)
+        {
+            g_free (msg);
+            cddb_track_request_send (request);
+            return;
+        }
+
+        Log_Print (LOG_ERROR, "%s", msg);
+
+        if (cddb_album_list_get_selected (self) == cddbalbum)
+        {
+            gtk_statusbar_push (GTK_STATUSBAR (priv->status_bar),
+                                priv->status_bar_context, msg);
+        }
+
+        g_free (msg);
+        cddbalbum->loading = FALSE;
+        cddb_track_request_free (request);
+        return;
+    }
+
+    cddbalbum->loading = FALSE;
+    cddb_track_request_free (request);
+
+    cddb_album_show_tracks (self, cddbalbum);
+}
+
+static void
+cddb_track_request_send (CddbTrackRequest *request)
+{
+    EtCDDBDialogPrivate *priv;
+
+    priv = et_cddb_dialog_get_instance_private (request->self);
+
+    et_cddb_client_fetch_async (priv->client, request->uri,
+                                request->io_priority, priv->album_cancellable,
+                                on_album_tracks_fetched, request);
+}
+
+/*
+ * cddb_album_read_local_tracks:
+ * @self: the CDDB dialog
+ * @cddbalbum: an album from the local dump
+ *
+ * Read the details and the track list of @cddbalbum from the local dump. The
+ * records are small files, so they are read synchronously.
+ */
+static void
+cddb_album_read_local_tracks (EtCDDBDialog *self,
+                              CddbAlbum *cddbalbum)
+{
+    EtCDDBDialogPrivate *priv;
+    GBytes *bytes;
+    gchar *bad_response = NULL;
+    GError *error = NULL;
+
+    priv = et_cddb_dialog_get_instance_private (self);
+
+    if (priv->local == NULL)
+    {
+        g_set_error (&error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND, "%s",
+                     _("The local CDDB is not available"));
+        bytes = NULL;
+    }
+    else
+    {
+        bytes = et_cddb_local_read (priv->local, cddbalbum->category,
+                                    strtoul (cddbalbum->id, NULL, 16), &error);
+    }
+
+    if (bytes == NULL)
+    {
+        Log_Print (LOG_ERROR, "%s", error->message);
+
+        if (cddb_album_list_get_selected (self) == cddbalbum)
+        {
+            gtk_statusbar_push (GTK_STATUSBAR (priv->status_bar),
+                                priv->status_bar_context, error->message);
+        }
+
+        g_error_free (error);
+        return;
+    }
+
+    /* Without a header, the record cannot be rejected. */
+    cddb_album_parse_tracks (cddbalbum, bytes, &bad_response);
+    g_bytes_unref (bytes);
+
+    cddb_album_show_tracks (self, cddbalbum);
+}
+
+/*
+ * cddb_album_fetch_tracks:
+ * @self: the CDDB dialog
+ * @cddbalbum: the album for which to fetch the track list
+ * @io_priority: the priority of the request
+ *
+ * Fetch the details and the track list of @cddbalbum, unless they were
+ * already fetched, or are being fetched. The track list is shown once it
+ * was fetched, if @cddbalbum is selected at that point.
+ */
+static void
+cddb_album_fetch_tracks (EtCDDBDialog *self,
+                         CddbAlbum *cddbalbum,
+                         gint io_priority)
+{
+    CddbTrackRequest *request;
+
+    if (cddbalbum->track_list != NULL || cddbalbum->loading)
+    {
+        return;
+    }
+
+    if (cddbalbum->server_name == NULL)
+    {
+        cddb_album_read_local_tracks (self, cddbalbum);
+        return;
+    }
+
+    request = g_slice_new0 (CddbTrackRequest);
+    request->self = self;
+    request->cddbalbum = cddbalbum;
+    request->uri = cddb_album_get_read_uri (cddbalbum);
+    request->io_priority = io_priority;
+
+    cddbalbum->loading = TRUE;
+    cddb_track_request_send (request);
+}
+
+/*
+ * Callback when selecting a row in the Album List.
+ * We get the list of tracks of the selected album
+ */
+static void
+Cddb_Get_Album_Tracks_List_CB (EtCDDBDialog *self, GtkTreeSelection *selection)
+{
+    EtCDDBDialogPrivate *priv;
+    CddbAlbum *cddbalbum;
+
+    priv = et_cddb_dialog_get_instance_private (self);
+
+    cddb_track_model_clear (self);
+    update_apply_button_sensitivity (self);
+
+    if (!(cddbalbum = cddb_album_list_get_selected (self)))
+    {
+        return;
+    }
+
+    // We have already the track list
+    if (cddbalbum->track_list != NULL)
+    {
+        Cddb_Load_Track_Album_List (self, cddbalbum->track_list);
+        return;
+    }
+
+    gtk_statusbar_push (GTK_STATUSBAR (priv->status_bar),
+                        priv->status_bar_context, _("Sending request…"));
+    cddb_album_fetch_tracks (self, cddbalbum, G_PRIORITY_DEFAULT);
+}
+
+/*
+ * prefetch_visible_albums:
+ * @user_data: the CDDB dialog
+ *
+ * Fetch the track lists of the albums in the visible rows of the album list,
+ * or of the first rows if the list was not drawn yet, so that they can be
+ * shown at once when an album is selected.
+ *
+ * Returns: %G_SOURCE_REMOVE
+ */
+static gboolean
+prefetch_visible_albums (gpointer user_data)
+{
+    EtCDDBDialog *self;
+    EtCDDBDialogPrivate *priv;
+    GtkTreeModel *model;
+    GtkTreePath *start;
+    GtkTreePath *end;
+    GtkTreeIter iter;
+    gint n_rows;
+    gboolean valid;
+
+    self = ET_CDDB_DIALOG (user_data);
+    priv = et_cddb_dialog_get_instance_private (self);
+    priv->prefetch_source_id = 0;
+    model = GTK_TREE_MODEL (priv->album_list_model);
+
+    if (gtk_tree_view_get_visible_range (GTK_TREE_VIEW (priv->album_list_view),
+                                         &start, &end))
+    {
+        n_rows = gtk_tree_path_get_indices (end)[0]
+                 - gtk_tree_path_get_indices (start)[0] + 1;
+        gtk_tree_path_free (end);
+    }
+    else
+    {
+        start = gtk_tree_path_new_first ();
+        n_rows = CDDB_PREFETCH_ALBUMS;
+    }
+
+    for (valid = gtk_tree_model_get_iter (model, &iter, start);
+         valid && n_rows > 0;
+         valid = gtk_tree_model_iter_next (model, &iter), n_rows--)
+    {
+        CddbAlbum *cddbalbum;
+
+        gtk_tree_model_get (model, &iter, CDDB_ALBUM_LIST_DATA, &cddbalbum,
+                            -1);
+        cddb_album_fetch_tracks (self, cddbalbum, G_PRIORITY_LOW);
+    }
+
+    gtk_tree_path_free (start);
+
+    return G_SOURCE_REMOVE;
+}
+
+/*
+ * schedule_prefetch:
+ * @self: the CDDB dialog
+ *
+ * Prefetch the track lists of the visible albums, once the album list has
+ * been drawn or has stopped scrolling.
+ */
+static void
+schedule_prefetch (EtCDDBDialog *self)
+{
+    EtCDDBDialogPrivate *priv;
+
+    priv = et_cddb_dialog_get_instance_private (self);
+
+    if (priv->prefetch_source_id != 0)
+    {
+        g_source_remove (priv->prefetch_source_id);
+    }
+
+    priv->prefetch_source_id = g_timeout_add (CDDB_PREFETCH_DELAY,
+                                              prefetch_visible_albums, self);
+    g_source_set_name_by_id (priv->prefetch_source_id,
+                             "CDDB album prefetch timer");
+}
+
+/*
+ * Load the priv->album_list into the corresponding List
+ */
+static void
+Cddb_Load_Album_List (EtCDDBDialog *self, gboolean only_red_lines)
+{
+    EtCDDBDialogPrivate *priv;
+    GtkTreeIter iter;
+    GList *l;
+
+    GtkTreeSelection *selection;
+    GList            *selectedRows = NULL;
+    GtkTreeIter       currentIter;
+    CddbAlbum        *cddbalbumSelected = NULL;
+
+    priv = et_cddb_dialog_get_instance_private (self);
+
+    // Memorize the current selected item
+    selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(priv->album_list_view));
+    selectedRows = gtk_tree_selection_get_selected_rows(selection, NULL);
+    if (selectedRows)
+    {
+        if (gtk_tree_model_get_iter(GTK_TREE_MODEL(priv->album_list_model), &currentIter, (GtkTreePath*)selectedRows->data))
+            gtk_tree_model_get(GTK_TREE_MODEL(priv->album_list_model), &currentIter,
+                               CDDB_ALBUM_LIST_DATA, &cddbalbumSelected, -1);
+    }
+
+    /* Remove lines. */
+    cddb_album_model_clear (self);
+
+    // Reload list following parameter 'only_red_lines'
+    for (l = g_list_first (priv->album_list); l != NULL; l = g_list_next (l))
+    {
+        CddbAlbum *cddbalbum = l->data;
+
+        if ( (only_red_lines && cddbalbum->track_list) || !only_red_lines)
+        {
+            /* Load the row in the list. */
+            gtk_list_store_insert_with_values (priv->album_list_model, &iter,
+                                               G_MAXINT,
+                                               CDDB_ALBUM_LIST_PIXBUF,
+                                               cddbalbum->bitmap,
+                                               CDDB_ALBUM_LIST_ALBUM,
+                                               cddbalbum->artist_album,
+                                               CDDB_ALBUM_LIST_CATEGORY,
+                                               cddbalbum->category,
+                                               CDDB_ALBUM_LIST_DATA,
+                                               cddbalbum, -1);
+
+            Cddb_Album_List_Set_Row_Appearance (self, &iter);
+
+            // Select this item if it is the saved one...
+            if (cddbalbum == cddbalbumSelected)
+                gtk_tree_selection_select_iter(gtk_tree_view_get_selection(GTK_TREE_VIEW(priv->album_list_view)), &iter);
+        }
+    }
+}
+
+/*
+ * cddb_album_requests_cancel:
+ * @self: the CDDB dialog
+ *
+ * Cancel the pending requests for the track lists of the albums.
+ */
+static void
+cddb_album_requests_cancel (EtCDDBDialog *self)
+{
+    EtCDDBDialogPrivate *priv;
+    GList *l;
+
+    priv = et_cddb_dialog_get_instance_private (self);
+
+    g_cancellable_cancel (priv->album_cancellable);
+    g_object_unref (priv->album_cancellable);
+    priv->album_cancellable = g_cancellable_new ();
+
+    for (l = priv->album_list; l != NULL; l = g_list_next (l))
+    {
+        ((CddbAlbum *)l->data)->loading = FALSE;
+    }
+}
+
+/*
+ * Free priv->album_list
+ */
+static gboolean
+Cddb_Free_Album_List (EtCDDBDialog *self)
+{
+    EtCDDBDialogPrivate *priv;
+
+    priv = et_cddb_dialog_get_instance_private (self);
+
+    g_return_val_if_fail (priv->album_list != NULL, FALSE);
+
+    /* The pending requests refer to the albums. */
+    cddb_album_requests_cancel (self);
+
+    g_list_free_full (g_list_first (priv->album_list),
+                      (GDestroyNotify)cddb_album_free);
+    priv->album_list = NULL;
+
+    return TRUE;
+}
+
+/*
+ * Fields          : artist, title, track, rest
+ * CDDB Categories : blues, classical, country, data, folk, jazz, misc, newage, reggae, rock, soundtrack
+ */
+static gchar *
+Cddb_Generate_Request_String_With_Fields_And_Categories_Options (EtCDDBDialog *self)
+{
+    GString *string;
+    guint search_fields;
+    guint search_categories;
+
+    /* Init. */
+    string = g_string_sized_new (256);
+
+    /* Fields. */
+    /* FIXME: Fetch cddb-search-fields "all-set" mask. */
+#if 0
+    if (search_all_fields)
+    {
+        g_string_append (string, "&allfields=YES");
+    }
+    else
+    {
+        g_string_append (string, "&allfields=NO");
+    }
+#endif
+
+    search_fields = g_settings_get_flags (MainSettings, "cddb-search-fields");
+
+    if (search_fields & ET_CDDB_SEARCH_FIELD_ARTIST)
+    {
+        g_string_append (string, "&fields=artist");
+    }
+    if (search_fields & ET_CDDB_SEARCH_FIELD_TITLE)
+    {
+        g_string_append (string, "&fields=title");
+    }
+    if (search_fields & ET_CDDB_SEARCH_FIELD_TRACK)
+    {
+        g_string_append (string, "&fields=track");
+    }
+    if (search_fields & ET_CDDB_SEARCH_FIELD_OTHER)
+    {
+        g_string_append (string, "&fields=rest");
     }
 
     /* Categories (warning: there is one other CDDB category that is not used
@@ -1268,47 +1637,185 @@ Cddb_Generate_Request_String_With_Fields_And_Categories_Options (EtCDDBDialog *s
 }
 
 /*
- * Site FREEDB.ORG - Manual Search
- * Send request (using the HTML search page in freedb.org site) to the CD database
- * to get the list of albums matching to a string.
+ * CddbSearch:
+ * @self: the CDDB dialog
+ * @cancellable: the cancellable of the search
+ * @server_name: the name of the server to search
+ * @server_port: the port of the server
+ * @server_cgi_path: the CGI path on the server
+ * @uri: the URI of the current request
+ * @words: the words to search for, for a manual search
+ * @page: the page of results to request next, for gnudb
+ * @num_albums: the number of albums read so far, for gnudb
+ * @total_num_albums: the number of albums found, as reported by gnudb
+ * @albums: (element-type CddbAlbum): the albums read from the last response,
+ *          in reverse order
+ * @query: the disc ID query of which the search is part, or %NULL
+ *
+ * The state of a search on a single server, kept across the asynchronous
+ * requests which make up the search.
+ */
+typedef struct _CddbDiscIdQuery CddbDiscIdQuery;
+
+typedef struct
+{
+    EtCDDBDialog *self;
+    GCancellable *cancellable;
+    gchar *server_name;
+    guint server_port;
+    gchar *server_cgi_path;
+    gchar *uri;
+    gchar *words;
+    gint page;
+    gint num_albums;
+    gint total_num_albums;
+    GList *albums;
+    CddbDiscIdQuery *query;
+} CddbSearch;
+
+static CddbSearch *
+cddb_search_new (EtCDDBDialog *self,
+                 GCancellable *cancellable,
+                 const gchar *server_name,
+                 guint server_port,
+                 const gchar *server_cgi_path)
+{
+    CddbSearch *search;
+
+    search = g_slice_new0 (CddbSearch);
+    search->self = self;
+    search->cancellable = g_object_ref (cancellable);
+    search->server_name = g_strdup (server_name);
+    search->server_port = server_port;
+    search->server_cgi_path = g_strdup (server_cgi_path);
+
+    return search;
+}
+
+static void
+cddb_search_free (CddbSearch *search)
+{
+    g_object_unref (search->cancellable);
+    g_free (search->server_name);
+    g_free (search->server_cgi_path);
+    g_free (search->uri);
+    g_free (search->words);
+    g_list_free_full (search->albums, (GDestroyNotify)cddb_album_free);
+
+    g_slice_free (CddbSearch, search);
+}
+
+/*
+ * cddb_search_report_error:
+ * @search: the search which failed
+ * @error: the reason for the failure
+ *
+ * Show @error in the status bar and in the log, unless the search was
+ * cancelled, in which case the dialog may no longer exist.
+ *
+ * Returns: %TRUE if the error was reported, %FALSE if the search was
+ *          cancelled
  */
 static gboolean
-Cddb_Search_Album_List_From_String_Freedb (EtCDDBDialog *self)
+cddb_search_report_error (CddbSearch *search,
+                          const GError *error)
 {
     EtCDDBDialogPrivate *priv;
-    gchar *string = NULL;
-    gchar *tmp, *tmp1;
-    gchar *cddb_in;         // For the request to send
-    gchar *cddb_out = NULL; // Answer received
-    gchar *cddb_out_tmp;
-    gchar *msg;
-    gchar *cddb_server_name;
-    guint cddb_server_port;
-    gchar *cddb_server_cgi_path;
 
-    gchar *ptr_cat, *cat_str, *id_str, *art_alb_str;
-    gchar *art_alb_tmp = NULL;
-    gboolean use_art_alb = FALSE;
-    gchar *end_str;
-    gchar *html_end_str;
-    gchar  buffer[MAX_STRING_LEN+1];
-    gboolean web_search_disabled = FALSE;
+    if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+        return FALSE;
+    }
 
-    SoupMessage *message;
-    GCancellable *cancellable;
-    GError *error = NULL;
-    GInputStream *istream;
-    GDataInputStream *dstream;
+    priv = et_cddb_dialog_get_instance_private (search->self);
+
+    gtk_statusbar_push (GTK_STATUSBAR (priv->status_bar),
+                        priv->status_bar_context, error->message);
+    Log_Print (LOG_ERROR, "%s", error->message);
+
+    return TRUE;
+}
+
+/*
+ * cddb_search_fail:
+ * @search: the search which failed
+ * @error: (transfer full): the reason for the failure
+ *
+ * Report @error, end @search and free it.
+ */
+static void
+cddb_search_fail (CddbSearch *search,
+                  GError *error)
+{
+    if (cddb_search_report_error (search, error))
+    {
+        EtCDDBDialogPrivate *priv;
+
+        priv = et_cddb_dialog_get_instance_private (search->self);
+        gtk_widget_set_sensitive (GTK_WIDGET (priv->stop_search_button),
+                                  FALSE);
+    }
+
+    g_error_free (error);
+    cddb_search_free (search);
+}
+
+/*
+ * cddb_search_start:
+ * @self: the CDDB dialog
+ *
+ * Cancel the previous search, if any, and clear its results.
+ *
+ * Returns: (transfer none): the cancellable to use for the new search
+ */
+static GCancellable *
+cddb_search_start (EtCDDBDialog *self)
+{
+    EtCDDBDialogPrivate *priv;
 
     priv = et_cddb_dialog_get_instance_private (self);
 
-    gtk_statusbar_push(GTK_STATUSBAR(priv->status_bar),priv->status_bar_context,"");
+    g_cancellable_cancel (priv->search_cancellable);
+    g_object_unref (priv->search_cancellable);
+    priv->search_cancellable = g_cancellable_new ();
+
+    /* Delete previous album list. */
+    cddb_album_model_clear (self);
+    cddb_track_model_clear (self);
+
+    if (priv->album_list)
+    {
+        Cddb_Free_Album_List (self);
+    }
+
+    gtk_widget_set_sensitive (GTK_WIDGET (priv->stop_search_button), TRUE);
+
+    return priv->search_cancellable;
+}
+
+/*
+ * cddb_search_get_words:
+ * @self: the CDDB dialog
+ *
+ * Get the words to search for from the search entry, separated by '+'.
+ *
+ * Returns: the words to search for, or %NULL if there are none
+ */
+static gchar *
+cddb_search_get_words (EtCDDBDialog *self)
+{
+    EtCDDBDialogPrivate *priv;
+    gchar *string;
+    gchar *tmp, *tmp1;
+
+    priv = et_cddb_dialog_get_instance_private (self);
 
     /* Get words to search... */
     string = g_strdup (gtk_entry_get_text (GTK_ENTRY (priv->search_entry)));
     if (et_str_empty (string))
     {
-        return FALSE;
+        g_free (string);
+        return NULL;
     }
 
     /* Format the string of words */
@@ -1326,69 +1833,92 @@ Cddb_Search_Album_List_From_String_Freedb (EtCDDBDialog *self)
     while ( (tmp=strchr(string,' '))!=NULL )
         *tmp = '+';
 
-    cddb_server_name = g_settings_get_string (MainSettings,
-                                              "cddb-manual-search-hostname");
-    cddb_server_port = g_settings_get_uint (MainSettings,
-                                            "cddb-manual-search-port");
-    cddb_server_cgi_path = g_settings_get_string (MainSettings,
-                                                  "cddb-manual-search-path");
-
-    /* Build request */
-    cddb_in = g_strdup_printf ("http://%s:%u/freedb_search.php?words=%s%s&grouping=none",
-                               cddb_server_name,
-                               cddb_server_port,
-                               string,
-                               (tmp = Cddb_Generate_Request_String_With_Fields_And_Categories_Options (self)));
+    return string;
+}
 
-    message = soup_message_new (SOUP_METHOD_GET, cddb_in);
+/*
+ * cddb_search_new_manual:
+ * @self: the CDDB dialog
+ *
+ * Start a manual search, on the server from the settings, for the words in
+ * the search entry.
+ *
+ * Returns: the new search, or %NULL if there are no words to search for
+ */
+static CddbSearch *
+cddb_search_new_manual (EtCDDBDialog *self)
+{
+    EtCDDBDialogPrivate *priv;
+    CddbSearch *search;
+    gchar *words;
+    gchar *server_name;
+    gchar *server_cgi_path;
 
-    g_free(string);
-    g_free(tmp);
-    g_free (cddb_in);
-    //g_print("Request Cddb_Search_Album_List_From_String_Freedb : '%s'\n", cddb_in);
+    priv = et_cddb_dialog_get_instance_private (self);
 
-    /* Send the request. */
-    cancellable = g_cancellable_new ();
-    istream = soup_session_send (priv->session, message, cancellable, &error);
-    gtk_statusbar_push(GTK_STATUSBAR(priv->status_bar),priv->status_bar_context,_("Sending request…"));
-    while (gtk_events_pending()) gtk_main_iteration();
+    gtk_statusbar_push(GTK_STATUSBAR(priv->status_bar),priv->status_bar_context,"");
 
-    if (!check_message_successful (message))
+    if (!(words = cddb_search_get_words (self)))
     {
-        msg = log_message_from_request_error (message, error);
-        gtk_statusbar_push (GTK_STATUSBAR (priv->status_bar),
-                            priv->status_bar_context, msg);
-        Log_Print (LOG_ERROR, "%s", msg);
-        g_error_free (error);
-        g_object_unref (message);
-        g_free(cddb_server_name);
-        g_free(cddb_server_cgi_path);
-        return FALSE;
+        return NULL;
     }
 
-    /* Delete previous album list. */
-    cddb_album_model_clear (self);
-    cddb_track_model_clear (self);
+    server_name = g_settings_get_string (MainSettings,
+                                         "cddb-manual-search-hostname");
+    server_cgi_path = g_settings_get_string (MainSettings,
+                                             "cddb-manual-search-path");
+
+    search = cddb_search_new (self, cddb_search_start (self), server_name,
+                              g_settings_get_uint (MainSettings,
+                                                   "cddb-manual-search-port"),
+                              server_cgi_path);
+    search->words = words;
+
+    g_free (server_name);
+    g_free (server_cgi_path);
+
+    return search;
+}
+
+static void
+on_freedb_search_fetched (GObject *source_object,
+                          GAsyncResult *result,
+                          gpointer user_data)
+{
+    CddbSearch *search;
+    EtCDDBDialog *self;
+    EtCDDBDialogPrivate *priv;
+    GBytes *bytes;
+    GDataInputStream *dstream;
+    gchar *cddb_out = NULL; // Answer received
+    gchar *cddb_out_tmp;
+    gchar *msg;
+
+    gchar *ptr_cat, *cat_str, *id_str, *art_alb_str;
+    gchar *art_alb_tmp = NULL;
+    gboolean use_art_alb = FALSE;
+    gchar *end_str;
+    gchar *html_end_str;
+    gchar  buffer[MAX_STRING_LEN+1];
+    gboolean web_search_disabled = FALSE;
+    GError *error = NULL;
+
+    search = user_data;
 
-    if (priv->album_list)
+    if (!(bytes = et_cddb_client_fetch_finish (result, &error)))
     {
-        Cddb_Free_Album_List (self);
+        cddb_search_fail (search, error);
+        return;
     }
-    gtk_widget_set_sensitive (GTK_WIDGET (priv->stop_search_button), TRUE);
 
+    self = search->self;
+    priv = et_cddb_dialog_get_instance_private (self);
 
     /*
      * Read the answer
      */
-    gtk_statusbar_push(GTK_STATUSBAR(priv->status_bar),priv->status_bar_context,_("Receiving data…"));
-    while (gtk_events_pending())
-        gtk_main_iteration();
-
-    /* Parse server answer : Check returned code in the first line. */
-    dstream = g_data_input_stream_new (istream);
-    g_object_unref (istream);
-    g_data_input_stream_set_newline_type (dstream,
-                                          G_DATA_STREAM_NEWLINE_TYPE_ANY);
+    dstream = cddb_data_input_stream_new (bytes);
+    g_bytes_unref (bytes);
 
     // Read other lines, and get list of matching albums
     // Composition of a line :
@@ -1399,9 +1929,7 @@ Cddb_Search_Album_List_From_String_Freedb (EtCDDBDialog *self)
     art_alb_str  = g_strdup("\">");
     end_str      = g_strdup("</a>"); //"</a><br>");
     html_end_str = g_strdup("</body>"); // To avoid the cddb lookups to hang
-    while (!priv->stop_searching && read_cddb_result_line (dstream,
-                                                           cancellable,
-                                                           &cddb_out))
+    while (read_cddb_result_line (dstream, NULL, &cddb_out))
     {
         cddb_out_tmp = cddb_out;
         //g_print("%s\n",cddb_out); // To print received data
@@ -1423,14 +1951,9 @@ Cddb_Search_Album_List_From_String_Freedb (EtCDDBDialog *self)
             gchar *copy;
             CddbAlbum *cddbalbum;
 
-            cddbalbum = g_slice_new0 (CddbAlbum);
-
-
-            // Parameters of the server used
-            cddbalbum->server_name     = g_strdup(cddb_server_name);
-            cddbalbum->server_port     = cddb_server_port;
-            cddbalbum->server_cgi_path = g_strdup(cddb_server_cgi_path);
-            cddbalbum->bitmap          = Cddb_Get_Pixbuf_From_Server_Name(cddbalbum->server_name);
+            cddbalbum = cddb_album_new (search->server_name,
+                                        search->server_port,
+                                        search->server_cgi_path);
 
             // Get album category
             cddb_out_tmp = ptr_cat + strlen(cat_str);
@@ -1506,15 +2029,11 @@ Cddb_Search_Album_List_From_String_Freedb (EtCDDBDialog *self)
         g_free(cddb_out);
     }
     g_free(cat_str); g_free(id_str); g_free(art_alb_str); g_free(end_str); g_free(html_end_str);
-    g_free(cddb_server_name);
-    g_free(cddb_server_cgi_path);
-
-    gtk_widget_set_sensitive(GTK_WIDGET(priv->stop_search_button),FALSE);
 
-    /* Close connection. */
     g_object_unref (dstream);
-    g_object_unref (cancellable);
-    g_object_unref (message);
+    cddb_search_free (search);
+
+    gtk_widget_set_sensitive(GTK_WIDGET(priv->stop_search_button),FALSE);
 
     if (web_search_disabled)
         msg = g_strdup_printf(_("Sorry, the web-based search is currently not available"));
@@ -1531,334 +2050,459 @@ Cddb_Search_Album_List_From_String_Freedb (EtCDDBDialog *self)
 
     /* Load the albums found in the list. */
     Cddb_Load_Album_List (self, FALSE);
-
-    return TRUE;
+    schedule_prefetch (self);
 }
 
 /*
- * Site GNUDB.ORG - Manual Search
+ * Site FREEDB.ORG - Manual Search
  * Send request (using the HTML search page in freedb.org site) to the CD database
  * to get the list of albums matching to a string.
  */
 static gboolean
-Cddb_Search_Album_List_From_String_Gnudb (EtCDDBDialog *self)
+Cddb_Search_Album_List_From_String_Freedb (EtCDDBDialog *self)
 {
     EtCDDBDialogPrivate *priv;
-    gchar *string = NULL;
-    gchar *tmp, *tmp1;
+    CddbSearch *search;
+    gchar *tmp;
+
+    priv = et_cddb_dialog_get_instance_private (self);
+
+    if (!(search = cddb_search_new_manual (self)))
+    {
+        return FALSE;
+    }
+
+    /* Build request */
+    search->uri = g_strdup_printf ("http://%s:%u/freedb_search.php?words=%s%s&grouping=none",
+                                   search->server_name, search->server_port,
+                                   search->words,
+                                   (tmp = Cddb_Generate_Request_String_With_Fields_And_Categories_Options (self)));
+    g_free (tmp);
+
+    /* Send the request. */
+    gtk_statusbar_push(GTK_STATUSBAR(priv->status_bar),priv->status_bar_context,_("Sending request…"));
+    et_cddb_client_fetch_async (priv->client, search->uri, G_PRIORITY_DEFAULT,
+                                search->cancellable, on_freedb_search_fetched,
+                                search);
+
+    return TRUE;
+}
+
+static void cddb_search_fetch_gnudb_page (CddbSearch *search);
+
+static void
+on_gnudb_page_fetched (GObject *source_object,
+                       GAsyncResult *result,
+                       gpointer user_data)
+{
+    CddbSearch *search;
+    EtCDDBDialog *self;
+    EtCDDBDialogPrivate *priv;
+    GBytes *bytes;
+    GDataInputStream *dstream;
     gchar *cddb_out = NULL; // Answer received
     gchar *cddb_out_tmp;
     gchar *msg;
-    gchar *cddb_server_name;
-    guint cddb_server_port;
-    gchar *cddb_server_cgi_path;
 
     gchar *ptr_cat, *cat_str, *art_alb_str;
     gchar *end_str;
     gchar *ptr_sraf, *sraf_str, *sraf_end_str;
     gchar *html_end_str;
     gchar  buffer[MAX_STRING_LEN+1];
-    gint   num_albums = 0;
-    gint   total_num_albums = 0;
+    gchar *next_page;
+    gboolean next_page_found = FALSE;
+    GError *error = NULL;
+
+    search = user_data;
 
-    gint   next_page_cpt = 0;
-    gboolean next_page_found;
+    if (!(bytes = et_cddb_client_fetch_finish (result, &error)))
+    {
+        cddb_search_fail (search, error);
+        return;
+    }
 
+    self = search->self;
     priv = et_cddb_dialog_get_instance_private (self);
 
-    gtk_statusbar_push(GTK_STATUSBAR(priv->status_bar),priv->status_bar_context,"");
+    /* Parse server answer : Check returned code in the first line. */
+    dstream = cddb_data_input_stream_new (bytes);
+    g_bytes_unref (bytes);
 
-    /* Get words to search... */
-    string = g_strdup (gtk_entry_get_text (GTK_ENTRY (priv->search_entry)));
-    if (et_str_empty (string))
+    if (!read_cddb_result_line (dstream, NULL, &cddb_out) || !cddb_out)
     {
-        return FALSE;
+        /* Do not keep the bad response in the cache. */
+        et_cddb_client_invalidate (priv->client, search->uri);
+        g_object_unref (dstream);
+        g_free (cddb_out);
+        cddb_search_fail (search,
+                          g_error_new_literal (G_IO_ERROR,
+                                               G_IO_ERROR_INVALID_DATA,
+                                               _("The server returned a bad response")));
+        return;
     }
+    g_free(cddb_out);
 
-    /* Format the string of words */
-    g_strstrip (string);
-    /* Remove the duplicated spaces */
-    while ((tmp=strstr(string,"  "))!=NULL) // Search 2 spaces
+    // The next page if exists will contains this url :
+    next_page = g_strdup_printf ("?page=%d", ++search->page);
+
+    // Read other lines, and get list of matching albums
+    // Composition of a line :
+    //  - gnudb.org
+    // <a href="http://www.gnudb.org/cd/ro21123813"><b>Indochine / Le Birthday Album</b></a><br>
+    cat_str      = g_strdup("http://www.gnudb.org/cd/");
+    art_alb_str  = g_strdup("\"><b>");
+    end_str      = g_strdup("</b></a>"); //"</a><br>");
+    html_end_str = g_strdup("</body>"); // To avoid the cddb lookups to hang
+    // Composition of a line displaying the number of albums
+    // <h2>Search Results, 3486 albums found:</h2>
+    sraf_str     = g_strdup("<h2>Search Results, ");
+    sraf_end_str = g_strdup(" albums found:</h2>");
+
+    while (read_cddb_result_line (dstream, NULL, &cddb_out))
     {
-        tmp1 = tmp + 1;
-        while (*tmp1)
-            *(tmp++) = *(tmp1++);
-        *tmp = '\0';
+        cddb_out_tmp = cddb_out;
+        //g_print("%s\n",cddb_out); // To print received data
+
+        // Line that displays the number of total albums return by the search
+        if ( cddb_out != NULL
+        && search->total_num_albums == 0 // Do it only the first time
+        && (ptr_sraf=strstr(cddb_out_tmp,sraf_end_str)) != NULL
+        && strstr(cddb_out_tmp,sraf_str) != NULL )
+        {
+            // Get total number of albums
+            ptr_sraf = 0;
+            search->total_num_albums = atoi(cddb_out_tmp + strlen(sraf_str));
+        }
+
+        // For GNUDB.ORG : one album per line
+        if ( cddb_out != NULL
+        && (ptr_cat=strstr(cddb_out_tmp,cat_str)) != NULL
+        && strstr(cddb_out_tmp,end_str) != NULL )
+        {
+            gchar *ptr_art_alb, *ptr_end;
+            gchar *valid;
+            CddbAlbum *cddbalbum;
+
+            cddbalbum = cddb_album_new (search->server_name,
+                                        search->server_port,
+                                        search->server_cgi_path);
+
+            search->num_albums++;
+
+            // Get album category
+            cddb_out_tmp = ptr_cat + strlen(cat_str);
+            strncpy(buffer,cddb_out_tmp,MAX_STRING_LEN);
+            *(buffer+2) = 0;
+
+            // Check only the 2 first characters to set the right category
+            if ( strncmp(buffer,"blues",2)==0 )
+                valid = g_strdup("blues");
+            else if ( strncmp(buffer,"classical",2)==0 )
+                valid = g_strdup("classical");
+            else if ( strncmp(buffer,"country",2)==0 )
+                valid = g_strdup("country");
+            else if ( strncmp(buffer,"data",2)==0 )
+                valid = g_strdup("data");
+            else if ( strncmp(buffer,"folk",2)==0 )
+                valid = g_strdup("folk");
+            else if ( strncmp(buffer,"jazz",2)==0 )
+                valid = g_strdup("jazz");
+            else if ( strncmp(buffer,"misc",2)==0 )
+                valid = g_strdup("misc");
+            else if ( strncmp(buffer,"newage",2)==0 )
+                valid = g_strdup("newage");
+            else if ( strncmp(buffer,"reggae",2)==0 )
+                valid = g_strdup("reggae");
+            else if ( strncmp(buffer,"rock",2)==0 )
+                valid = g_strdup("rock");
+            else //if ( strncmp(buffer,"soundtrack",2)==0 )
+                valid = g_strdup("soundtrack");
+
+            cddbalbum->category = valid; //Not useful -> Try_To_Validate_Utf8_String(valid);
+
+
+            // Get album ID
+            cddb_out_tmp = ptr_cat + strlen(cat_str) + 2;
+            strncpy(buffer,cddb_out_tmp,MAX_STRING_LEN);
+            if ( (ptr_art_alb=strstr(buffer,art_alb_str)) != NULL )
+                *ptr_art_alb = 0;
+            cddbalbum->id = Try_To_Validate_Utf8_String(buffer);
+
+
+            // Get album and artist names.
+            cddb_out_tmp = strstr(cddb_out_tmp,art_alb_str) + strlen(art_alb_str);
+            strncpy(buffer,cddb_out_tmp,MAX_STRING_LEN);
+            if ( (ptr_end=strstr(buffer,end_str)) != NULL )
+                *ptr_end = 0;
+            cddbalbum->artist_album = Try_To_Validate_Utf8_String(buffer);
+
+            search->albums = g_list_prepend (search->albums, cddbalbum);
+        }
+
+        // To avoid the cddb lookups to hang (Patch from Paul Giordano)
+        /* It appears that on some systems that cddb lookups continue to attempt
+         * to get data from the socket even though the other system has completed
+         * sending. Here we see if the actual end of data is in the last block read.
+         * In the case of the html scan, the </body> tag is used because there's
+         * no crlf followint the </html> tag.
+         */
+        /***if (strstr(cddb_out_tmp,html_end_str)!=NULL)
+            break;***/
+
+
+        // Check if the link to the next results exists to loop again with the next link
+        if (cddb_out != NULL && next_page != NULL
+        && (strstr(cddb_out_tmp,next_page) != NULL || search->page < 2) ) // BUG : "search->page < 2" to fix a bug in gnudb : the page 0 doesn't contain link to the page=1, so we force it...
+        {
+            next_page_found = TRUE;
+
+            if ( !(search->page < 2) ) // Don't display message in this case as it will be displayed each line of page 0 and 1
+            {
+                msg = g_strdup_printf(_("More results to load…"));
+                gtk_statusbar_push(GTK_STATUSBAR(priv->status_bar),priv->status_bar_context,msg);
+                g_free(msg);
+            }
+        }
+
+        g_free(cddb_out);
     }
 
-    /* Convert spaces to '+' */
-    while ( (tmp=strchr(string,' '))!=NULL )
-        *tmp = '+';
+    g_free(cat_str); g_free(art_alb_str); g_free(end_str); g_free(html_end_str);
+    g_free(sraf_str);g_free(sraf_end_str);
+    g_free (next_page);
 
-    /* Delete previous album list. */
-    cddb_album_model_clear (self);
-    cddb_track_model_clear (self);
+    g_object_unref (dstream);
 
-    if (priv->album_list)
+    /* Show the albums of each page as soon as it is read. */
+    priv->album_list = g_list_concat (priv->album_list,
+                                      g_list_reverse (search->albums));
+    search->albums = NULL;
+    Cddb_Load_Album_List (self, FALSE);
+    schedule_prefetch (self);
+
+    /* Each page tells whether there is another one, so the pages must be
+     * requested one after the other. */
+    if (next_page_found)
     {
-        Cddb_Free_Album_List (self);
+        cddb_search_fetch_gnudb_page (search);
+        return;
     }
-    gtk_widget_set_sensitive(GTK_WIDGET(priv->stop_search_button),TRUE);
 
+    gtk_widget_set_sensitive(GTK_WIDGET(priv->stop_search_button),FALSE);
 
-    // Do a loop to load all the pages of results
-    do
-    {
-        gchar *uri;
-        SoupMessage *message;
-        GCancellable *cancellable;
-        GError *error = NULL;
-        GInputStream *istream;
-        GDataInputStream *dstream;
-        gchar *next_page;
+    msg = g_strdup_printf (ngettext ("Found one matching album",
+                                     "Found %d matching albums",
+                                     search->num_albums),
+                           search->num_albums);
+    gtk_statusbar_push(GTK_STATUSBAR(priv->status_bar),priv->status_bar_context,msg);
+    g_free(msg);
 
-        cddb_server_name = g_settings_get_string (MainSettings,
-                                                  "cddb-manual-search-hostname");
-        cddb_server_port = g_settings_get_uint (MainSettings,
-                                                "cddb-manual-search-port");
-        cddb_server_cgi_path = g_settings_get_string (MainSettings,
-                                                      "cddb-manual-search-path");
+    cddb_search_free (search);
+}
 
-        /* Build request */
-        uri = g_strdup_printf ("http://%s:%u/search/%s?page=%d",
-                               cddb_server_name, cddb_server_port, string,
-                               next_page_cpt);
-        next_page_found = FALSE;
+/*
+ * cddb_search_fetch_gnudb_page:
+ * @search: a manual search on gnudb
+ *
+ * Request the next page of results of @search.
+ */
+static void
+cddb_search_fetch_gnudb_page (CddbSearch *search)
+{
+    EtCDDBDialogPrivate *priv;
+    gchar *msg;
 
-        message = soup_message_new (SOUP_METHOD_GET, uri);
+    priv = et_cddb_dialog_get_instance_private (search->self);
 
-        if (!message)
-        {
-            g_critical ("Invalid CDDB_request URI: %s", uri);
-            g_free (uri);
-            return FALSE;
-        }
+    /* Build request */
+    g_free (search->uri);
+    search->uri = g_strdup_printf ("http://%s:%u/search/%s?page=%d",
+                                   search->server_name, search->server_port,
+                                   search->words, search->page);
+
+    if (search->total_num_albums != 0)
+        msg = g_strdup_printf(_("Receiving data of page %d (album %d/%d)…"),search->page,search->num_albums,search->total_num_albums);
+    else
+        msg = g_strdup_printf(_("Receiving data of page %d…"),search->page);
 
-        g_free (uri);
+    gtk_statusbar_push(GTK_STATUSBAR(priv->status_bar),priv->status_bar_context,msg);
+    g_free(msg);
 
-        /* Send the request. */
-        gtk_statusbar_push (GTK_STATUSBAR (priv->status_bar),
-                            priv->status_bar_context, _("Sending request…"));
-        while (gtk_events_pending()) gtk_main_iteration();
+    et_cddb_client_fetch_async (priv->client, search->uri, G_PRIORITY_DEFAULT,
+                                search->cancellable, on_gnudb_page_fetched,
+                                search);
+}
 
-        cancellable = g_cancellable_new ();
-        istream = soup_session_send (priv->session, message, cancellable,
-                                     &error);
+/*
+ * Site GNUDB.ORG - Manual Search
+ * Send request (using the HTML search page in freedb.org site) to the CD database
+ * to get the list of albums matching to a string.
+ */
+static gboolean
+Cddb_Search_Album_List_From_String_Gnudb (EtCDDBDialog *self)
+{
+    CddbSearch *search;
 
-        if (!check_message_successful (message))
-        {
-            msg = log_message_from_request_error (message, error);
-            gtk_statusbar_push (GTK_STATUSBAR (priv->status_bar),
-                                priv->status_bar_context, msg);
-            Log_Print (LOG_ERROR, "%s", msg);
-            g_free (msg);
-            g_object_unref (cancellable);
-            g_object_unref (message);
-            g_error_free (error);
-            g_free (string);
-            g_free (cddb_server_name);
-            g_free (cddb_server_cgi_path);
-            gtk_widget_set_sensitive (GTK_WIDGET (priv->stop_search_button),
-                                      FALSE);
-            return FALSE;
-        }
+    if (!(search = cddb_search_new_manual (self)))
+    {
+        return FALSE;
+    }
 
+    cddb_search_fetch_gnudb_page (search);
 
-        /*
-         * Read the answer
-         */
-        if (total_num_albums != 0)
-            msg = g_strdup_printf(_("Receiving data of page %d (album %d/%d)…"),next_page_cpt,num_albums,total_num_albums);
-        else
-            msg = g_strdup_printf(_("Receiving data of page %d…"),next_page_cpt);
+    return TRUE;
+}
 
-        gtk_statusbar_push(GTK_STATUSBAR(priv->status_bar),priv->status_bar_context,msg);
-        g_free(msg);
-        while (gtk_events_pending())
-            gtk_main_iteration();
+/*
+ * cddb_local_is_enabled:
+ *
+ * Returns: %TRUE if a local dump is searched instead of the servers
+ */
+static gboolean
+cddb_local_is_enabled (void)
+{
+    gchar *dump_path;
+    gboolean enabled;
 
-        /* Parse server answer : Check returned code in the first line. */
-        dstream = g_data_input_stream_new (istream);
-        g_object_unref (istream);
-        g_data_input_stream_set_newline_type (dstream,
-                                              G_DATA_STREAM_NEWLINE_TYPE_ANY);
+    dump_path = g_settings_get_string (MainSettings, "cddb-local-path");
+    enabled = !et_str_empty (dump_path);
+    g_free (dump_path);
 
-        if (!read_cddb_result_line (dstream, cancellable, &cddb_out)
-            || !cddb_out)
-        {
-            msg = g_strdup (_("The server returned a bad response"));
-            gtk_statusbar_push (GTK_STATUSBAR (priv->status_bar),
-                                priv->status_bar_context, msg);
-            Log_Print (LOG_ERROR, "%s", msg);
-            g_object_unref (dstream);
-            g_object_unref (cancellable);
-            g_object_unref (message);
-            g_free(msg);
-            g_free(cddb_out);
-            g_free(string);
-            g_free(cddb_server_name);
-            g_free(cddb_server_cgi_path);
-            gtk_widget_set_sensitive(GTK_WIDGET(priv->stop_search_button),FALSE);
-            return FALSE;
-        }
-        g_free(cddb_out);
+    return enabled;
+}
 
-        // The next page if exists will contains this url :
-        next_page = g_strdup_printf("?page=%d",++next_page_cpt);
-
-        // Read other lines, and get list of matching albums
-        // Composition of a line :
-        //  - gnudb.org
-        // <a href="http://www.gnudb.org/cd/ro21123813"><b>Indochine / Le Birthday Album</b></a><br>
-        cat_str      = g_strdup("http://www.gnudb.org/cd/");
-        art_alb_str  = g_strdup("\"><b>");
-        end_str      = g_strdup("</b></a>"); //"</a><br>");
-        html_end_str = g_strdup("</body>"); // To avoid the cddb lookups to hang
-        // Composition of a line displaying the number of albums
-        // <h2>Search Results, 3486 albums found:</h2>
-        sraf_str     = g_strdup("<h2>Search Results, ");
-        sraf_end_str = g_strdup(" albums found:</h2>");
-
-        while (!priv->stop_searching && read_cddb_result_line (dstream,
-                                                               cancellable,
-                                                               &cddb_out))
-        {
-            cddb_out_tmp = cddb_out;
-            //g_print("%s\n",cddb_out); // To print received data
-
-            // Line that displays the number of total albums return by the search
-            if ( cddb_out != NULL
-            && total_num_albums == 0 // Do it only the first time
-            && (ptr_sraf=strstr(cddb_out_tmp,sraf_end_str)) != NULL
-            && strstr(cddb_out_tmp,sraf_str) != NULL )
-            {
-                // Get total number of albums
-                ptr_sraf = 0;
-                total_num_albums = atoi(cddb_out_tmp + strlen(sraf_str));
-            }
+/*
+ * cddb_local_get_albums:
+ * @matches: (element-type EtCddbLocalMatch) (transfer full): albums found in
+ *           the local dump
+ *
+ * Returns: (element-type CddbAlbum) (transfer full): the albums for @matches
+ */
+static GList *
+cddb_local_get_albums (GList *matches)
+{
+    GList *albums = NULL;
+    GList *l;
 
-            // For GNUDB.ORG : one album per line
-            if ( cddb_out != NULL
-            && (ptr_cat=strstr(cddb_out_tmp,cat_str)) != NULL
-            && strstr(cddb_out_tmp,end_str) != NULL )
-            {
-                gchar *ptr_art_alb, *ptr_end;
-                gchar *valid;
-                CddbAlbum *cddbalbum;
+    for (l = matches; l != NULL; l = g_list_next (l))
+    {
+        EtCddbLocalMatch *match = l->data;
+        CddbAlbum *cddbalbum;
 
-                cddbalbum = g_slice_new0 (CddbAlbum);
+        cddbalbum = cddb_album_new (NULL, 0, NULL);
+        cddbalbum->category = g_strdup (match->category);
+        cddbalbum->id = g_strdup_printf ("%08x", match->disc_id);
+        cddbalbum->artist_album = g_strdup (match->title);
 
-                // Parameters of the server used
-                cddbalbum->server_name     = g_strdup(cddb_server_name);
-                cddbalbum->server_port     = cddb_server_port;
-                cddbalbum->server_cgi_path = g_strdup(cddb_server_cgi_path);
-                cddbalbum->bitmap          = Cddb_Get_Pixbuf_From_Server_Name(cddbalbum->server_name);
+        albums = g_list_prepend (albums, cddbalbum);
+    }
 
-                num_albums++;
+    g_list_free_full (matches, (GDestroyNotify)et_cddb_local_match_free);
 
-                // Get album category
-                cddb_out_tmp = ptr_cat + strlen(cat_str);
-                strncpy(buffer,cddb_out_tmp,MAX_STRING_LEN);
-                *(buffer+2) = 0;
-
-                // Check only the 2 first characters to set the right category
-                if ( strncmp(buffer,"blues",2)==0 )
-                    valid = g_strdup("blues");
-                else if ( strncmp(buffer,"classical",2)==0 )
-                    valid = g_strdup("classical");
-                else if ( strncmp(buffer,"country",2)==0 )
-                    valid = g_strdup("country");
-                else if ( strncmp(buffer,"data",2)==0 )
-                    valid = g_strdup("data");
-                else if ( strncmp(buffer,"folk",2)==0 )
-                    valid = g_strdup("folk");
-                else if ( strncmp(buffer,"jazz",2)==0 )
-                    valid = g_strdup("jazz");
-                else if ( strncmp(buffer,"misc",2)==0 )
-                    valid = g_strdup("misc");
-                else if ( strncmp(buffer,"newage",2)==0 )
-                    valid = g_strdup("newage");
-                else if ( strncmp(buffer,"reggae",2)==0 )
-                    valid = g_strdup("reggae");
-                else if ( strncmp(buffer,"rock",2)==0 )
-                    valid = g_strdup("rock");
-                else //if ( strncmp(buffer,"soundtrack",2)==0 )
-                    valid = g_strdup("soundtrack");
-
-                cddbalbum->category = valid; //Not useful -> Try_To_Validate_Utf8_String(valid);
+    return g_list_reverse (albums);
+}
 
+/*
+ * cddb_local_unavailable:
+ * @self: the CDDB dialog
+ *
+ * Report that the local dump cannot be searched, as it is not indexed yet.
+ */
+static void
+cddb_local_unavailable (EtCDDBDialog *self)
+{
+    EtCDDBDialogPrivate *priv;
 
-                // Get album ID
-                cddb_out_tmp = ptr_cat + strlen(cat_str) + 2;
-                strncpy(buffer,cddb_out_tmp,MAX_STRING_LEN);
-                if ( (ptr_art_alb=strstr(buffer,art_alb_str)) != NULL )
-                    *ptr_art_alb = 0;
-                cddbalbum->id = Try_To_Validate_Utf8_String(buffer);
+    priv = et_cddb_dialog_get_instance_private (self);
 
+    gtk_widget_set_sensitive (GTK_WIDGET (priv->stop_search_button), FALSE);
+    gtk_statusbar_push (GTK_STATUSBAR (priv->status_bar),
+                        priv->status_bar_context,
+                        _("The local CDDB is being indexed. Try again later"));
+}
 
-                // Get album and artist names.
-                cddb_out_tmp = strstr(cddb_out_tmp,art_alb_str) + strlen(art_alb_str);
-                strncpy(buffer,cddb_out_tmp,MAX_STRING_LEN);
-                if ( (ptr_end=strstr(buffer,end_str)) != NULL )
-                    *ptr_end = 0;
-                cddbalbum->artist_album = Try_To_Validate_Utf8_String(buffer);
+/*
+ * Local dump - Manual Search
+ * Search for the words in the titles of the albums of the local dump, in the
+ * categories from the settings.
+ */
+static gboolean
+Cddb_Search_Album_List_From_String_Local (EtCDDBDialog *self)
+{
+    static const struct
+    {
+        guint flag;
+        const gchar *category;
+    } categories[] =
+    {
+        { ET_CDDB_SEARCH_CATEGORY_BLUES, "blues" },
+        { ET_CDDB_SEARCH_CATEGORY_CLASSICAL, "classical" },
+        { ET_CDDB_SEARCH_CATEGORY_COUNTRY, "country" },
+        { ET_CDDB_SEARCH_CATEGORY_FOLK, "folk" },
+        { ET_CDDB_SEARCH_CATEGORY_JAZZ, "jazz" },
+        { ET_CDDB_SEARCH_CATEGORY_MISC, "misc" },
+        { ET_CDDB_SEARCH_CATEGORY_NEWAGE, "newage" },
+        { ET_CDDB_SEARCH_CATEGORY_REGGAE, "reggae" },
+        { ET_CDDB_SEARCH_CATEGORY_ROCK, "rock" },
+        { ET_CDDB_SEARCH_CATEGORY_SOUNDTRACK, "soundtrack" }
+    };
+    EtCDDBDialogPrivate *priv;
+    const gchar *search_categories[G_N_ELEMENTS (categories) + 1];
+    guint flags;
+    gsize n_categories = 0;
+    gchar *words;
+    gchar *msg;
+    gsize i;
 
-                priv->album_list = g_list_append(priv->album_list,cddbalbum);
-            }
+    priv = et_cddb_dialog_get_instance_private (self);
 
-            // To avoid the cddb lookups to hang (Patch from Paul Giordano)
-            /* It appears that on some systems that cddb lookups continue to attempt
-             * to get data from the socket even though the other system has completed
-             * sending. Here we see if the actual end of data is in the last block read.
-             * In the case of the html scan, the </body> tag is used because there's
-             * no crlf followint the </html> tag.
-             */
-            /***if (strstr(cddb_out_tmp,html_end_str)!=NULL)
-                break;***/
+    gtk_statusbar_push(GTK_STATUSBAR(priv->status_bar),priv->status_bar_context,"");
 
+    if (!(words = cddb_search_get_words (self)))
+    {
+        return FALSE;
+    }
 
-            // Check if the link to the next results exists to loop again with the next link
-            if (cddb_out != NULL && next_page != NULL
-            && (strstr(cddb_out_tmp,next_page) != NULL || next_page_cpt < 2) ) // BUG : "next_page_cpt < 2" to fix a bug in gnudb : the page 0 doesn't contain link to the page=1, so we force it...
-            {
-                next_page_found = TRUE;
+    cddb_search_start (self);
 
-                if ( !(next_page_cpt < 2) ) // Don't display message in this case as it will be displayed each line of page 0 and 1
-                {
-                    msg = g_strdup_printf(_("More results to load…"));
-                    gtk_statusbar_push(GTK_STATUSBAR(priv->status_bar),priv->status_bar_context,msg);
-                    g_free(msg);
+    if (priv->local == NULL)
+    {
+        cddb_local_unavailable (self);
+        g_free (words);
+        return TRUE;
+    }
 
-                    while (gtk_events_pending())
-                        gtk_main_iteration();
-                }
-            }
+    flags = g_settings_get_flags (MainSettings, "cddb-search-categories");
 
-            g_free(cddb_out);
+    for (i = 0; i < G_N_ELEMENTS (categories); i++)
+    {
+        if (flags & categories[i].flag)
+        {
+            search_categories[n_categories++] = categories[i].category;
         }
+    }
 
-        g_free(cat_str); g_free(art_alb_str); g_free(end_str); g_free(html_end_str);
-        g_free(sraf_str);g_free(sraf_end_str);
-        g_free(cddb_server_name);
-        g_free(cddb_server_cgi_path);
-        g_free (next_page);
-
-        /* Close connection. */
-        g_object_unref (dstream);
-        g_object_unref (cancellable);
-        g_object_unref (message);
-    } while (next_page_found);
-    g_free(string);
+    search_categories[n_categories] = NULL;
 
+    /* Only the "Artist / Album" titles are indexed, so the search fields
+     * from the settings do not apply. */
+    priv->album_list = cddb_local_get_albums (et_cddb_local_search (priv->local,
+                                                                    words,
+                                                                    search_categories));
+    g_free (words);
 
-    gtk_widget_set_sensitive(GTK_WIDGET(priv->stop_search_button),FALSE);
+    gtk_widget_set_sensitive (GTK_WIDGET (priv->stop_search_button), FALSE);
 
-    msg = g_strdup_printf(ngettext("Found one matching album","Found %d matching albums",num_albums),num_albums);
+    msg = g_strdup_printf (ngettext ("Found one matching album",
+                                     "Found %u matching albums",
+                                     g_list_length (priv->album_list)),
+                           g_list_length (priv->album_list));
     gtk_statusbar_push(GTK_STATUSBAR(priv->status_bar),priv->status_bar_context,msg);
     g_free(msg);
 
     /* Load the albums found in the list. */
     Cddb_Load_Album_List (self, FALSE);
+    schedule_prefetch (self);
 
     return TRUE;
 }
@@ -1871,8 +2515,15 @@ Cddb_Search_Album_List_From_String_Gnudb (EtCDDBDialog *self)
 static gboolean
 Cddb_Search_Album_List_From_String (EtCDDBDialog *self)
 {
-    gchar *hostname = g_settings_get_string (MainSettings,
-                                             "cddb-manual-search-hostname");
+    gchar *hostname;
+
+    if (cddb_local_is_enabled ())
+    {
+        return Cddb_Search_Album_List_From_String_Local (self);
+    }
+
+    hostname = g_settings_get_string (MainSettings,
+                                      "cddb-manual-search-hostname");
 
     if (strstr (hostname, "gnudb") != NULL)
     {
@@ -2251,7 +2902,10 @@ stop_search (EtCDDBDialog *self)
 
     priv = et_cddb_dialog_get_instance_private (self);
 
-    priv->stop_searching = TRUE;
+    g_cancellable_cancel (priv->search_cancellable);
+    cddb_album_requests_cancel (self);
+
+    gtk_widget_set_sensitive (GTK_WIDGET (priv->stop_search_button), FALSE);
 }
 
 /*
@@ -2383,11 +3037,157 @@ init_set_field_check (GtkWidget *widget)
                                   et_settings_flags_toggle_set, widget, NULL);
 }
 
+/*
+ * cddb_local_get_index_path:
+ * @dump_path: the path of the local dump
+ *
+ * Get the path of the index of @dump_path, which is named after a hash of
+ * @dump_path, so that switching between dumps does not index them again.
+ *
+ * Returns: the path of the index, free with g_free()
+ */
+static gchar *
+cddb_local_get_index_path (const gchar *dump_path)
+{
+    gchar *checksum;
+    gchar *basename;
+    gchar *index_path;
+
+    checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, dump_path, -1);
+    basename = g_strconcat ("cddb-local-", checksum, ".index", NULL);
+    index_path = g_build_filename (g_get_user_cache_dir (), PACKAGE_TARNAME,
+                                   basename, NULL);
+    g_free (basename);
+    g_free (checksum);
+
+    return index_path;
+}
+
+static void
+on_cddb_local_updated (GObject *source_object,
+                       GAsyncResult *result,
+                       gpointer user_data)
+{
+    EtCDDBDialog *self;
+    EtCDDBDialogPrivate *priv;
+    gchar *dump_path;
+    gchar *index_path;
+    gchar *msg;
+    GError *error = NULL;
+
+    if (!et_cddb_local_update_finish (result, &error))
+    {
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+            /* The dialog may no longer exist. */
+            g_error_free (error);
+            return;
+        }
+
+        self = ET_CDDB_DIALOG (user_data);
+        priv = et_cddb_dialog_get_instance_private (self);
+
+        msg = g_strdup_printf (_("Cannot index the local CDDB: %s"),
+                               error->message);
+        Log_Print (LOG_ERROR, "%s", msg);
+        gtk_statusbar_push (GTK_STATUSBAR (priv->status_bar),
+                            priv->status_bar_context, msg);
+        g_free (msg);
+        g_error_free (error);
+        return;
+    }
+
+    self = ET_CDDB_DIALOG (user_data);
+    priv = et_cddb_dialog_get_instance_private (self);
+
+    /* The albums in the list keep working with the updated index, as they
+     * only refer to the dump by category and disc ID. */
+    g_clear_pointer (&priv->local, et_cddb_local_free);
+    /* The update is cancelled when the path changes, so this is the path
+     * which was indexed. */
+    dump_path = g_settings_get_string (MainSettings, "cddb-local-path");
+    index_path = cddb_local_get_index_path (dump_path);
+    priv->local = et_cddb_local_open (index_path, &error);
+    g_free (index_path);
+    g_free (dump_path);
+
+    if (priv->local == NULL)
+    {
+        Log_Print (LOG_ERROR, "%s", error->message);
+        gtk_statusbar_push (GTK_STATUSBAR (priv->status_bar),
+                            priv->status_bar_context, error->message);
+        g_error_free (error);
+        return;
+    }
+
+    msg = g_strdup_printf (ngettext ("The local CDDB has one album",
+                                     "The local CDDB has %u albums",
+                                     et_cddb_local_get_n_records (priv->local)),
+                           et_cddb_local_get_n_records (priv->local));
+    gtk_statusbar_push (GTK_STATUSBAR (priv->status_bar),
+                        priv->status_bar_context, msg);
+    g_free (msg);
+}
+
+/*
+ * on_cddb_local_path_changed:
+ * @self: the CDDB dialog
+ * @key: the changed key
+ * @settings: the settings
+ *
+ * Open the index of the local dump, and update it in the background, as the
+ * dump may have changed since it was indexed.
+ */
+static void
+on_cddb_local_path_changed (EtCDDBDialog *self,
+                            const gchar *key,
+                            GSettings *settings)
+{
+    EtCDDBDialogPrivate *priv;
+    gchar *dump_path;
+    gchar *index_path;
+
+    priv = et_cddb_dialog_get_instance_private (self);
+
+    g_cancellable_cancel (priv->local_cancellable);
+    g_object_unref (priv->local_cancellable);
+    priv->local_cancellable = g_cancellable_new ();
+    g_clear_pointer (&priv->local, et_cddb_local_free);
+
+    dump_path = g_settings_get_string (MainSettings, "cddb-local-path");
+
+    if (et_str_empty (dump_path))
+    {
+        g_free (dump_path);
+        return;
+    }
+
+    index_path = cddb_local_get_index_path (dump_path);
+
+    /* Search the previous index of the dump while it is updated. */
+    if ((priv->local = et_cddb_local_open (index_path, NULL))
+        && strcmp (et_cddb_local_get_dump_path (priv->local), dump_path) != 0)
+    {
+        g_clear_pointer (&priv->local, et_cddb_local_free);
+    }
+
+    gtk_statusbar_push (GTK_STATUSBAR (priv->status_bar),
+                        priv->status_bar_context,
+                        _("Indexing the local CDDB…"));
+    et_cddb_local_update_async (dump_path, index_path,
+                                priv->local_cancellable,
+                                on_cddb_local_updated, self);
+
+    g_free (index_path);
+    g_free (dump_path);
+}
+
 static void
 create_cddb_dialog (EtCDDBDialog *self)
 {
     EtCDDBDialogPrivate *priv;
     GtkTreePath *path;
+    gchar *cache_path;
 
     priv = et_cddb_dialog_get_instance_private (self);
 
@@ -2459,14 +3259,34 @@ create_cddb_dialog (EtCDDBDialog *self)
                         priv->status_bar_context, _("Ready to search"));
 
     g_signal_emit_by_name (priv->search_entry, "changed");
-    priv->stop_searching = FALSE;
 
     /* The User-Agent header is not used by the CDDB protocol over HTTP, but it
      * is still good practice to set it appropriately. */
     /* FIXME: Enable a SoupLogger with g_parse_debug_string(). */
     priv->session = soup_session_new_with_options (SOUP_SESSION_USER_AGENT,
                                                    PACKAGE_NAME " " PACKAGE_VERSION,
+                                                   SOUP_SESSION_MAX_CONNS_PER_HOST,
+                                                   ET_CDDB_CLIENT_MAX_REQUESTS,
                                                    NULL);
+
+    cache_path = g_build_filename (g_get_user_cache_dir (), PACKAGE_TARNAME,
+                                   "cddb", NULL);
+    priv->client = et_cddb_client_new (priv->session, cache_path,
+                                       ET_CDDB_CLIENT_MAX_REQUESTS);
+    g_free (cache_path);
+
+    priv->search_cancellable = g_cancellable_new ();
+    priv->album_cancellable = g_cancellable_new ();
+    priv->local_cancellable = g_cancellable_new ();
+
+    g_signal_connect_swapped (MainSettings, "changed::cddb-local-path",
+                              G_CALLBACK (on_cddb_local_path_changed), self);
+    on_cddb_local_path_changed (self, "cddb-local-path", MainSettings);
+
+    /* Prefetch the track lists of the albums which are scrolled to. */
+    g_signal_connect_swapped (gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (priv->album_list_view)),
+                              "value-changed", G_CALLBACK (schedule_prefetch),
+                              self);
 }
 
 /*
@@ -2545,6 +3365,210 @@ Cddb_Free_Track_Album_List (GList *track_list)
     return TRUE;
 }
 
+/*
+ * CddbDiscIdQuery:
+ * @self: the CDDB dialog
+ * @cancellable: the cancellable of the search
+ * @disc_id: the disc ID to look up
+ * @n_pending: the number of servers which did not answer yet
+ * @n_succeeded: the number of servers which answered
+ * @searches: the searches on each server, or %NULL for a server which is not
+ *            configured
+ *
+ * A lookup of a disc ID, sent to all the configured servers at once.
+ */
+struct _CddbDiscIdQuery
+{
+    EtCDDBDialog *self;
+    GCancellable *cancellable;
+    gchar *disc_id;
+    guint n_pending;
+    guint n_succeeded;
+    CddbSearch *searches[2];
+};
+
+static void
+cddb_disc_id_query_free (CddbDiscIdQuery *query)
+{
+    gsize i;
+
+    for (i = 0; i < G_N_ELEMENTS (query->searches); i++)
+    {
+        if (query->searches[i])
+        {
+            cddb_search_free (query->searches[i]);
+        }
+    }
+
+    g_object_unref (query->cancellable);
+    g_free (query->disc_id);
+    g_slice_free (CddbDiscIdQuery, query);
+}
+
+/*
+ * cddb_disc_id_query_complete:
+ * @query: a disc ID query, for which all the servers answered
+ *
+ * Show the albums found by all the servers, in the order of the servers in
+ * the settings, and free @query.
+ */
+static void
+cddb_disc_id_query_complete (CddbDiscIdQuery *query)
+{
+    EtCDDBDialog *self;
+    EtCDDBDialogPrivate *priv;
+    gchar *msg;
+    gsize i;
+
+    if (g_cancellable_is_cancelled (query->cancellable))
+    {
+        /* The dialog may no longer exist. */
+        cddb_disc_id_query_free (query);
+        return;
+    }
+
+    self = query->self;
+    priv = et_cddb_dialog_get_instance_private (self);
+
+    for (i = 0; i < G_N_ELEMENTS (query->searches); i++)
+    {
+        CddbSearch *search = query->searches[i];
+
+        if (search)
+        {
+            priv->album_list = g_list_concat (priv->album_list,
+                                              g_list_reverse (search->albums));
+            search->albums = NULL;
+        }
+    }
+
+    if (query->n_succeeded > 0)
+    {
+        msg = g_strdup_printf (ngettext ("DiscID ‘%s’ gave one matching album",
+                                         "DiscID ‘%s’ gave %u matching albums",
+                                         g_list_length (priv->album_list)),
+                               query->disc_id,
+                               g_list_length (priv->album_list));
+        gtk_statusbar_push(GTK_STATUSBAR(priv->status_bar),priv->status_bar_context,msg);
+        g_free(msg);
+    }
+
+    gtk_widget_set_sensitive (GTK_WIDGET (priv->stop_search_button), FALSE);
+
+    /* Load the albums found in the list. */
+    Cddb_Load_Album_List (self, FALSE);
+    schedule_prefetch (self);
+
+    cddb_disc_id_query_free (query);
+}
+
+static void
+on_disc_id_query_fetched (GObject *source_object,
+                          GAsyncResult *result,
+                          gpointer user_data)
+{
+    CddbSearch *search;
+    CddbDiscIdQuery *query;
+    GBytes *bytes;
+    GDataInputStream *dstream;
+    gchar *cddb_out = NULL;       /* Answer received */
+    GError *error = NULL;
+
+    search = user_data;
+    query = search->query;
+
+    if (!(bytes = et_cddb_client_fetch_finish (result, &error)))
+    {
+        cddb_search_report_error (search, error);
+        g_error_free (error);
+    }
+    else
+    {
+        /* Read the answer. */
+        dstream = cddb_data_input_stream_new (bytes);
+        g_bytes_unref (bytes);
+
+        /*
+         * Format :
+         * For Freedb, Gnudb, the lines to read are like :
+         *      211 Found inexact matches, list follows (until terminating `.')
+         *      rock 8f0dc00b Archive / Noise
+         *      rock 7b0dd80b Archive / Noise
+         *      .
+         * For MusicBrainz Cddb Gateway (see http://wiki.musicbrainz.org/CddbGateway), the lines to read are like :
+         *      200 jazz 7e0a100a Pink Floyd / Dark Side of the Moon
+         */
+        while (read_cddb_result_line (dstream, NULL, &cddb_out))
+        {
+            const gchar *cddb_out_tmp = cddb_out;
+
+            if (!cddb_out_tmp)
+            {
+                break;
+            }
+
+            /* Compatibility for the MusicBrainz CddbGateway. */
+            if (strlen (cddb_out_tmp) > 3
+                && (strncmp (cddb_out_tmp, "200", 3) == 0
+                    || strncmp (cddb_out_tmp, "210", 3) == 0
+                    || strncmp (cddb_out_tmp, "211", 3) == 0))
+            {
+                cddb_out_tmp += 4;
+            }
+
+            // Reading of lines with albums (skiping return code lines :
+            // "211 Found inexact matches, list follows (until terminating `.')" )
+            if (strstr (cddb_out_tmp, "/") != NULL)
+            {
+                gchar* ptr;
+                CddbAlbum *cddbalbum;
+
+                cddbalbum = cddb_album_new (search->server_name,
+                                            search->server_port,
+                                            search->server_cgi_path);
+
+                // Get album category
+                if ( (ptr = strstr(cddb_out_tmp, " ")) != NULL )
+                {
+                    *ptr = 0;
+                    cddbalbum->category = Try_To_Validate_Utf8_String(cddb_out_tmp);
+                    *ptr = ' ';
+                    cddb_out_tmp = ptr + 1;
+                }
+
+                // Get album ID
+                if ( (ptr = strstr(cddb_out_tmp, " ")) != NULL )
+                {
+                    *ptr = 0;
+                    cddbalbum->id = Try_To_Validate_Utf8_String(cddb_out_tmp);
+                    *ptr = ' ';
+                    cddb_out_tmp = ptr + 1;
+                }
+
+                // Get album and artist names.
+                cddbalbum->artist_album = Try_To_Validate_Utf8_String(cddb_out_tmp);
+
+                search->albums = g_list_prepend (search->albums,
+                                                 cddbalbum);
+            }
+
+            /* There is no need to explicitly check for the terminating
+             * '.' */
+            g_free(cddb_out);
+        }
+
+        g_free (cddb_out);
+        g_object_unref (dstream);
+
+        query->n_succeeded++;
+    }
+
+    if (--query->n_pending == 0)
+    {
+        cddb_disc_id_query_complete (query);
+    }
+}
+
 /*
  * Send cddb query using the CddbId generated from the selected files to get the
  * list of albums matching with this cddbid.
@@ -2553,13 +3577,14 @@ gboolean
 et_cddb_dialog_search_from_selection (EtCDDBDialog *self)
 {
     EtCDDBDialogPrivate *priv;
+    CddbDiscIdQuery *query;
 
-    gchar *cddb_out = NULL;       /* Answer received */
     gchar *msg;
     gchar *cddb_server_name;
     guint cddb_server_port;
+    guint32 disc_id;
     gchar *cddb_server_cgi_path;
-    gint   server_try = 0;
+    guint server_try;
     GString *query_string;
     gchar *cddb_discid;
 
@@ -2671,222 +3696,110 @@ et_cddb_dialog_search_from_selection (EtCDDBDialog *self)
     g_list_free (filelist);
 
     /* Compute CddbId. */
-    cddb_discid = g_strdup_printf ("%08x", (guint)(((total_id % 0xFF) << 24) |
-                                           (disc_length << 8) | num_tracks));
+    disc_id = ((total_id % 0xFF) << 24) | (disc_length << 8) | num_tracks;
+    cddb_discid = g_strdup_printf ("%08x", disc_id);
 
 
-    /* Delete previous album list. */
-    cddb_album_model_clear (self);
-    cddb_track_model_clear (self);
-
-    if (priv->album_list)
-    {
-        Cddb_Free_Album_List (self);
-    }
-    gtk_widget_set_sensitive(GTK_WIDGET(priv->stop_search_button),TRUE);
+    query = g_slice_new0 (CddbDiscIdQuery);
+    query->self = self;
+    query->cancellable = g_object_ref (cddb_search_start (self));
+    query->disc_id = cddb_discid;
 
+    msg = g_strdup_printf (_("Sending request (disc ID: %s, #tracks: %u, Disc length: %u)…"),
+                           cddb_discid, num_tracks, disc_length);
+    gtk_statusbar_push(GTK_STATUSBAR(priv->status_bar),priv->status_bar_context,msg);
+    g_free(msg);
 
+    /* Local cddb access: the dump is searched instead of the servers. */
+    if (cddb_local_is_enabled ())
     {
-        /*
-         * Remote cddb acces
-         *
-         * Request the two servers
-         *   - 1) www.freedb.org
-         *   - 2) MusicBrainz Gateway : freedb.musicbrainz.org (in Easytag < 2.1.1, it was: www.mb.inhouse.co.uk)
-         */
-        while (server_try < 2)
-        {
-            gchar *uri;
-            SoupMessage *message;
-            GError *error = NULL;
-            GCancellable *cancellable;
-            GInputStream *istream;
-            GDataInputStream *dstream;
-
-            server_try++;
-
-            if (server_try == 1)
-            {
-                /* 1st try. */
-                cddb_server_name = g_settings_get_string (MainSettings,
-                                                          "cddb-automatic-search-hostname");
-                cddb_server_port = g_settings_get_uint (MainSettings,
-                                                        "cddb-automatic-search-port");
-                cddb_server_cgi_path = g_settings_get_string (MainSettings,
-                                                              "cddb-automatic-search-path");
- 
-            }
-            else
-            {
-                /* 2nd try. */
-                cddb_server_name = g_settings_get_string (MainSettings,
-                                                          "cddb-automatic-search-hostname2");
-                cddb_server_port = g_settings_get_uint (MainSettings,
-                                                        "cddb-automatic-search-port");
-                cddb_server_cgi_path = g_settings_get_string (MainSettings,
-                                                              "cddb-automatic-search-path2");
-            }
-
-            /* Check values. */
-            if (et_str_empty (cddb_server_name))
-            {
-                g_free (cddb_server_name);
-                g_free (cddb_server_cgi_path);
-                continue;
-            }
-
-            // CDDB Request (ex: GET /~cddb/cddb.cgi?cmd=cddb+query+0800ac01+1++150+172&hello=noname+localhost+EasyTAG+0.31&proto=1 HTTP/1.1\r\nHost: freedb.freedb.org:80\r\nConnection: close)
-            // proto=1 => ISO-8859-1 - proto=6 => UTF-8
-            uri = g_strdup_printf ("http://%s:%u%s?cmd=cddb+query+%s+%u+%s+%u&hello=noname+localhost+%s+%s&proto=6",
-                                   cddb_server_name, cddb_server_port,
-                                   cddb_server_cgi_path, cddb_discid,
-                                   num_tracks, query_string->str, disc_length,
-                                   PACKAGE_NAME, PACKAGE_VERSION);
-            message = soup_message_new (SOUP_METHOD_GET, uri);
-
-            if (!message)
-            {
-                g_critical ("Invalid CDDB request URI: %s", uri);
-                g_free (uri);
-                return FALSE;
-            }
+        g_string_free (query_string, TRUE);
 
-            g_free (uri);
+        if (priv->local == NULL)
+        {
+            cddb_local_unavailable (self);
+            cddb_disc_id_query_free (query);
+            return TRUE;
+        }
 
-            msg = g_strdup_printf (_("Sending request (disc ID: %s, #tracks: %u, Disc length: %u)…"),
-                                   cddb_discid, num_tracks, disc_length);
-            gtk_statusbar_push(GTK_STATUSBAR(priv->status_bar),priv->status_bar_context,msg);
-            g_free(msg);
+        priv->album_list = cddb_local_get_albums (et_cddb_local_lookup (priv->local,
+                                                                        disc_id));
+        query->n_succeeded++;
+        cddb_disc_id_query_complete (query);
 
-            while (gtk_events_pending())
-                gtk_main_iteration();
+        return TRUE;
+    }
 
-            cancellable = g_cancellable_new ();
-            istream = soup_session_send (priv->session, message, cancellable,
-                                         &error);
+    /*
+     * Remote cddb acces
+     *
+     * Request the two servers at the same time
+     *   - 1) www.freedb.org
+     *   - 2) MusicBrainz Gateway : freedb.musicbrainz.org (in Easytag < 2.1.1, it was: www.mb.inhouse.co.uk)
+     */
+    for (server_try = 0; server_try < G_N_ELEMENTS (query->searches); server_try++)
+    {
+        CddbSearch *search;
 
-            if (!check_message_successful (message))
-            {
-                msg = log_message_from_request_error (message, error);
-                gtk_statusbar_push (GTK_STATUSBAR (priv->status_bar),
-                                    priv->status_bar_context, msg);
-                Log_Print (LOG_ERROR, "%s", msg);
-                g_free (msg);
-                g_error_free (error);
-                g_free (cddb_server_name);
-                g_free (cddb_server_cgi_path);
-                g_string_free (query_string, TRUE);
-                g_free (cddb_discid);
-                g_object_unref (cancellable);
-                g_object_unref (message);
-                gtk_widget_set_sensitive (GTK_WIDGET (priv->stop_search_button),
-                                          FALSE);
-                return FALSE;
-            }
+        if (server_try == 0)
+        {
+            /* 1st server. */
+            cddb_server_name = g_settings_get_string (MainSettings,
+                                                      "cddb-automatic-search-hostname");
+            cddb_server_cgi_path = g_settings_get_string (MainSettings,
+                                                          "cddb-automatic-search-path");
+        }
+        else
+        {
+            /* 2nd server. */
+            cddb_server_name = g_settings_get_string (MainSettings,
+                                                      "cddb-automatic-search-hostname2");
+            cddb_server_cgi_path = g_settings_get_string (MainSettings,
+                                                          "cddb-automatic-search-path2");
+        }
 
-            /* Read the answer. */
-            dstream = g_data_input_stream_new (istream);
-            g_object_unref (istream);
-            g_data_input_stream_set_newline_type (dstream,
-                                                  G_DATA_STREAM_NEWLINE_TYPE_ANY);
-
-            /*
-             * Format :
-             * For Freedb, Gnudb, the lines to read are like :
-             *      211 Found inexact matches, list follows (until terminating `.')
-             *      rock 8f0dc00b Archive / Noise
-             *      rock 7b0dd80b Archive / Noise
-             *      .
-             * For MusicBrainz Cddb Gateway (see http://wiki.musicbrainz.org/CddbGateway), the lines to read are like :
-             *      200 jazz 7e0a100a Pink Floyd / Dark Side of the Moon
-             */
-            while (!priv->stop_searching
-                   && read_cddb_result_line (dstream, cancellable, &cddb_out))
-            {
-                const gchar *cddb_out_tmp = cddb_out;
+        cddb_server_port = g_settings_get_uint (MainSettings,
+                                                "cddb-automatic-search-port");
 
-                if (!cddb_out_tmp)
-                {
-                    break;
-                }
+        /* Check values. */
+        if (et_str_empty (cddb_server_name))
+        {
+            g_free (cddb_server_name);
+            g_free (cddb_server_cgi_path);
+            continue;
+        }
 
-                /* Compatibility for the MusicBrainz CddbGateway. */
-                if (strlen (cddb_out_tmp) > 3
-                    && (strncmp (cddb_out_tmp, "200", 3) == 0
-                        || strncmp (cddb_out_tmp, "210", 3) == 0
-                        || strncmp (cddb_out_tmp, "211", 3) == 0))
-                {
-                    cddb_out_tmp += 4;
-                }
+        search = cddb_search_new (self, query->cancellable, cddb_server_name,
+                                  cddb_server_port, cddb_server_cgi_path);
+        search->query = query;
+        query->searches[server_try] = search;
+        query->n_pending++;
 
-                // Reading of lines with albums (skiping return code lines :
-                // "211 Found inexact matches, list follows (until terminating `.')" )
-                if (strstr (cddb_out_tmp, "/") != NULL)
-                {
-                    gchar* ptr;
-                    CddbAlbum *cddbalbum;
-
-                    cddbalbum = g_slice_new0 (CddbAlbum);
-
-                    // Parameters of the server used
-                    cddbalbum->server_name     = g_strdup(cddb_server_name);
-                    cddbalbum->server_port     = cddb_server_port;
-                    cddbalbum->server_cgi_path = g_strdup(cddb_server_cgi_path);
-                    cddbalbum->bitmap          = Cddb_Get_Pixbuf_From_Server_Name(cddbalbum->server_name);
-
-                    // Get album category
-                    if ( (ptr = strstr(cddb_out_tmp, " ")) != NULL )
-                    {
-                        *ptr = 0;
-                        cddbalbum->category = Try_To_Validate_Utf8_String(cddb_out_tmp);
-                        *ptr = ' ';
-                        cddb_out_tmp = ptr + 1;
-                    }
-
-                    // Get album ID
-                    if ( (ptr = strstr(cddb_out_tmp, " ")) != NULL )
-                    {
-                        *ptr = 0;
-                        cddbalbum->id = Try_To_Validate_Utf8_String(cddb_out_tmp);
-                        *ptr = ' ';
-                        cddb_out_tmp = ptr + 1;
-                    }
-
-                    // Get album and artist names.
-                    cddbalbum->artist_album = Try_To_Validate_Utf8_String(cddb_out_tmp);
-
-                    priv->album_list = g_list_append(priv->album_list,cddbalbum);
-                }
+        g_free (cddb_server_name);
+        g_free (cddb_server_cgi_path);
 
-                /* There is no need to explicitly check for the terminating
-                 * '.' */
-                g_free(cddb_out);
-            }
+        // CDDB Request (ex: GET /~cddb/cddb.cgi?cmd=cddb+query+0800ac01+1++150+172&hello=noname+localhost+EasyTAG+0.31&proto=1 HTTP/1.1\r\nHost: freedb.freedb.org:80\r\nConnection: close)
+        // proto=1 => ISO-8859-1 - proto=6 => UTF-8
+        search->uri = g_strdup_printf ("http://%s:%u%s?cmd=cddb+query+%s+%u+%s+%u&hello=noname+localhost+%s+%s&proto=6",
+                                       search->server_name,
+                                       search->server_port,
+                                       search->server_cgi_path, cddb_discid,
+                                       num_tracks, query_string->str,
+                                       disc_length, PACKAGE_NAME,
+                                       PACKAGE_VERSION);
 
-            g_free (cddb_out);
-            g_free(cddb_server_name);
-            g_free(cddb_server_cgi_path);
-            g_object_unref (dstream);
-            g_object_unref (cancellable);
-            g_object_unref (message);
-        }
+        et_cddb_client_fetch_async (priv->client, search->uri,
+                                    G_PRIORITY_DEFAULT, query->cancellable,
+                                    on_disc_id_query_fetched, search);
     }
 
     g_string_free (query_string, TRUE);
 
-    msg = g_strdup_printf (ngettext ("DiscID ‘%s’ gave one matching album",
-                                     "DiscID ‘%s’ gave %u matching albums",
-                                     g_list_length (priv->album_list)),
-                           cddb_discid, g_list_length (priv->album_list));
-    gtk_statusbar_push(GTK_STATUSBAR(priv->status_bar),priv->status_bar_context,msg);
-    g_free(msg);
-
-    g_free(cddb_discid);
-
-    gtk_widget_set_sensitive (GTK_WIDGET (priv->stop_search_button), FALSE);
-
-    /* Load the albums found in the list. */
-    Cddb_Load_Album_List (self, FALSE);
+    if (query->n_pending == 0)
+    {
+        /* No server is configured. */
+        cddb_disc_id_query_complete (query);
+    }
 
     return TRUE;
 }
@@ -2942,11 +3855,30 @@ et_cddb_dialog_finalize (GObject *object)
     self = ET_CDDB_DIALOG (object);
     priv = et_cddb_dialog_get_instance_private (self);
 
+    if (priv->prefetch_source_id != 0)
+    {
+        g_source_remove (priv->prefetch_source_id);
+        priv->prefetch_source_id = 0;
+    }
+
+    g_cancellable_cancel (priv->search_cancellable);
+    g_clear_object (&priv->search_cancellable);
+
     if (priv->album_list)
     {
         Cddb_Free_Album_List (self);
     }
 
+    g_cancellable_cancel (priv->album_cancellable);
+    g_clear_object (&priv->album_cancellable);
+
+    g_signal_handlers_disconnect_by_func (MainSettings,
+                                          on_cddb_local_path_changed, self);
+    g_cancellable_cancel (priv->local_cancellable);
+    g_clear_object (&priv->local_cancellable);
+    g_clear_pointer (&priv->local, et_cddb_local_free);
+
+    et_cddb_client_free (priv->client);
     g_object_unref (priv->session);
 
     G_OBJECT_CLASS (et_cddb_dialog_parent_class)->finalize (object);
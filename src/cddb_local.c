@@ -0,0 +1,2052 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include "cddb_local.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+
+/*
+ * A freedb dump is either a directory with a subdirectory per category, which
+ * holds a file per album named after its disc ID, or a tarball of such a
+ * directory. Each album is an xmcd record, as returned by a "cddb read".
+ *
+ * The index is a single file, which is mapped into memory when it is opened.
+ * It starts with an IndexHeader, followed by the tables:
+ *   - files: the files of the dump, for a directory, or the tarball itself
+ *   - records: where each record is in the dump, with its category and title
+ *   - record disc IDs: the disc IDs of each record, in record order
+ *   - disc IDs: the disc IDs, sorted, each with its record
+ *   - words: the words of the titles, sorted, each with its postings
+ *   - postings: the records which contain each word, sorted
+ *   - strings: the strings referred to by offset in the other tables
+ *
+ * The index is only a cache, so it is stored in the byte order of the host.
+ */
+#define INDEX_MAGIC "ETCDDBIX"
+#define INDEX_VERSION 1
+#define INDEX_BYTE_ORDER 0x01020304
+
+/* The dump is a tarball, rather than a directory. */
+#define INDEX_FLAG_TAR (1 << 0)
+
+/* The number of tarball members which are parsed by the same job. */
+#define TAR_BATCH_SIZE 1024
+#define TAR_BLOCK_SIZE 512
+
+/* Larger files are not xmcd records, which are a few kilobytes at most. */
+#define MAX_RECORD_SIZE (1024 * 1024)
+
+typedef struct
+{
+    gchar magic[8];
+    guint32 version;
+    guint32 byte_order;
+    guint32 flags;
+    guint32 dump_path;
+    guint32 n_files;
+    guint32 n_records;
+    guint32 n_record_disc_ids;
+    guint32 n_disc_ids;
+    guint32 n_words;
+    guint32 n_postings;
+    guint32 strings_size;
+    guint32 reserved;
+} IndexHeader;
+
+typedef struct
+{
+    guint32 path;
+    guint32 first_record;
+    guint32 n_records;
+    guint32 reserved;
+    gint64 mtime;
+    guint64 size;
+} IndexFile;
+
+typedef struct
+{
+    guint32 file;
+    guint32 category;
+    guint64 offset;
+    guint32 length;
+    guint32 title;
+    guint32 first_disc_id;
+    guint32 n_disc_ids;
+} IndexRecord;
+
+typedef struct
+{
+    guint32 disc_id;
+    guint32 record;
+} IndexDiscId;
+
+typedef struct
+{
+    guint32 word;
+    guint32 first_posting;
+    guint32 n_postings;
+} IndexWord;
+
+/*
+ * EtCddbLocal:
+ * @mapped_file: the index file
+ * @header: the header of the index
+ * @files: the files of the dump
+ * @records: the records of the dump
+ * @record_disc_ids: the disc IDs of each record
+ * @disc_ids: the disc IDs, sorted
+ * @words: the words of the titles, sorted
+ * @postings: the records of each word
+ * @strings: the string table
+ *
+ * An index of a local freedb dump, opened for lookups.
+ */
+struct _EtCddbLocal
+{
+    GMappedFile *mapped_file;
+    const IndexHeader *header;
+    const IndexFile *files;
+    const IndexRecord *records;
+    const guint32 *record_disc_ids;
+    const IndexDiscId *disc_ids;
+    const IndexWord *words;
+    const guint32 *postings;
+    const gchar *strings;
+};
+
+/*
+ * BuildRecord:
+ * @path: the path of the file of the record, relative to the dump, or %NULL
+ *        in a tarball
+ * @mtime: the modification time of the file
+ * @size: the size of the file
+ * @category: the category of the record (interned)
+ * @offset: the offset of the record in the tarball
+ * @length: the length of the record
+ * @title: the "Artist / Album" title of the record
+ * @disc_ids: the disc IDs of the record
+ *
+ * A record, as read from the dump or copied from the previous index.
+ */
+typedef struct
+{
+    gchar *path;
+    gint64 mtime;
+    guint64 size;
+    const gchar *category;
+    guint64 offset;
+    guint32 length;
+    gchar *title;
+    GArray *disc_ids;
+} BuildRecord;
+
+/*
+ * TarMember:
+ * @category: the category of the member (interned)
+ * @offset: the offset of the contents of the member in the tarball
+ * @data: the contents of the member
+ * @length: the length of @data
+ */
+typedef struct
+{
+    const gchar *category;
+    guint64 offset;
+    gchar *data;
+    gsize length;
+} TarMember;
+
+/*
+ * BuildContext:
+ * @dump_path: the path of the dump
+ * @cancellable: the cancellable of the update
+ * @old: the previous index of the dump, or %NULL
+ * @old_files: the files of @old, by path
+ * @lock: protects @error
+ * @error: the first error of the jobs
+ *
+ * The state of an update, shared by the jobs.
+ */
+typedef struct
+{
+    const gchar *dump_path;
+    GCancellable *cancellable;
+    EtCddbLocal *old;
+    GHashTable *old_files;
+    GMutex lock;
+    GError *error;
+} BuildContext;
+
+/*
+ * BuildJob:
+ * @category: the category directory to read, or %NULL
+ * @members: (element-type TarMember): the tarball members to parse, or %NULL
+ * @records: (element-type BuildRecord): the records which were read
+ * @n_reused: the number of records copied from the previous index
+ *
+ * A part of the dump, which is read by a thread of the pool.
+ */
+typedef struct
+{
+    gchar *category;
+    GPtrArray *members;
+    GPtrArray *records;
+    guint n_reused;
+} BuildJob;
+
+void
+et_cddb_local_match_free (EtCddbLocalMatch *match)
+{
+    g_return_if_fail (match != NULL);
+
+    g_free (match->category);
+    g_free (match->title);
+    g_slice_free (EtCddbLocalMatch, match);
+}
+
+static const gchar *
+index_get_string (EtCddbLocal *local,
+                  guint32 offset)
+{
+    if (offset >= local->header->strings_size)
+    {
+        return "";
+    }
+
+    return local->strings + offset;
+}
+
+/*
+ * et_cddb_local_open:
+ * @index_path: the path of the index, as written by et_cddb_local_update()
+ * @error: a #GError to provide information on errors, or %NULL to ignore
+ *
+ * Open an index of a local freedb dump, for lookups.
+ *
+ * Returns: the index, or %NULL on error
+ */
+EtCddbLocal *
+et_cddb_local_open (const gchar *index_path,
+                    GError **error)
+{
+    EtCddbLocal *local;
+    GMappedFile *mapped_file;
+    const gchar *contents;
+    const IndexHeader *header;
+    gsize length;
+    guint64 expected;
+
+    g_return_val_if_fail (index_path != NULL, NULL);
+    g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+    if (!(mapped_file = g_mapped_file_new (index_path, FALSE, error)))
+    {
+        return NULL;
+    }
+
+    contents = g_mapped_file_get_contents (mapped_file);
+    length = g_mapped_file_get_length (mapped_file);
+    header = (const IndexHeader *)contents;
+
+    if (length < sizeof (IndexHeader)
+        || memcmp (header->magic, INDEX_MAGIC, sizeof (header->magic)) != 0
+        || header->version != INDEX_VERSION
+        || header->byte_order != INDEX_BYTE_ORDER)
+    {
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                     _("Not a local CDDB index: %s"), index_path);
+        g_mapped_file_unref (mapped_file);
+        return NULL;
+    }
+
+    expected = sizeof (IndexHeader)
+               + (guint64)header->n_files * sizeof (IndexFile)
+               + (guint64)header->n_records * sizeof (IndexRecord)
+               + (guint64)header->n_record_disc_ids * sizeof (guint32)
+               + (guint64)header->n_disc_ids * sizeof (IndexDiscId)
+               + (guint64)header->n_words * sizeof (IndexWord)
+               + (guint64)header->n_postings * sizeof (guint32)
+               + header->strings_size;
+
+    if (expected != length || header->strings_size == 0
+        || contents[length - 1] != '\0')
+    {
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                     _("The local CDDB index is corrupt: %s"), index_path);
+        g_mapped_file_unref (mapped_file);
+        return NULL;
+    }
+
+    local = g_slice_new (EtCddbLocal);
+    local->mapped_file = mapped_file;
+    local->header = header;
+    local->files = (const IndexFile *)(header + 1);
+    local->records = (const IndexRecord *)(local->files + header->n_files);
+    local->record_disc_ids = (const guint32 *)(local->records
+                                               + header->n_records);
+    local->disc_ids = (const IndexDiscId *)(local->record_disc_ids
+                                            + header->n_record_disc_ids);
+    local->words = (const IndexWord *)(local->disc_ids + header->n_disc_ids);
+    local->postings = (const guint32 *)(local->words + header->n_words);
+    local->strings = (const gchar *)(local->postings + header->n_postings);
+
+    return local;
+}
+
+void
+et_cddb_local_free (EtCddbLocal *local)
+{
+    g_return_if_fail (local != NULL);
+
+    g_mapped_file_unref (local->mapped_file);
+    g_slice_free (EtCddbLocal, local);
+}
+
+/*
+ * et_cddb_local_get_dump_path:
+ * @local: a local CDDB index
+ *
+ * Get the path of the dump which was indexed.
+ *
+ * Returns: the path of the dump
+ */
+const gchar *
+et_cddb_local_get_dump_path (EtCddbLocal *local)
+{
+    g_return_val_if_fail (local != NULL, NULL);
+
+    return index_get_string (local, local->header->dump_path);
+}
+
+guint
+et_cddb_local_get_n_records (EtCddbLocal *local)
+{
+    g_return_val_if_fail (local != NULL, 0);
+
+    return local->header->n_records;
+}
+
+static EtCddbLocalMatch *
+index_match_new (EtCddbLocal *local,
+                 guint32 record_index,
+                 guint32 disc_id)
+{
+    const IndexRecord *record;
+    EtCddbLocalMatch *match;
+
+    record = &local->records[record_index];
+
+    match = g_slice_new (EtCddbLocalMatch);
+    match->category = g_strdup (index_get_string (local, record->category));
+    match->disc_id = disc_id;
+    match->title = g_strdup (index_get_string (local, record->title));
+
+    return match;
+}
+
+/*
+ * index_find_disc_id:
+ * @local: a local CDDB index
+ * @disc_id: the disc ID to find
+ *
+ * Find the first entry for @disc_id in the sorted disc ID table.
+ *
+ * Returns: the index of the first entry for @disc_id, or the number of
+ *          entries if there is none
+ */
+static guint32
+index_find_disc_id (EtCddbLocal *local,
+                    guint32 disc_id)
+{
+    guint32 low = 0;
+    guint32 high = local->header->n_disc_ids;
+
+    while (low < high)
+    {
+        guint32 middle = low + (high - low) / 2;
+
+        if (local->disc_ids[middle].disc_id < disc_id)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    if (low < local->header->n_disc_ids
+        && local->disc_ids[low].disc_id == disc_id)
+    {
+        return low;
+    }
+
+    return local->header->n_disc_ids;
+}
+
+/*
+ * et_cddb_local_lookup:
+ * @local: a local CDDB index
+ * @disc_id: the disc ID to look up
+ *
+ * Look up the albums with @disc_id, which may be in several categories.
+ *
+ * Returns: (element-type EtCddbLocalMatch) (transfer full): the matching
+ *          albums, free with et_cddb_local_match_free()
+ */
+GList *
+et_cddb_local_lookup (EtCddbLocal *local,
+                      guint32 disc_id)
+{
+    GList *matches = NULL;
+    guint32 i;
+
+    g_return_val_if_fail (local != NULL, NULL);
+
+    for (i = index_find_disc_id (local, disc_id);
+         i < local->header->n_disc_ids && local->disc_ids[i].disc_id == disc_id;
+         i++)
+    {
+        guint32 record = local->disc_ids[i].record;
+
+        if (record < local->header->n_records)
+        {
+            matches = g_list_prepend (matches,
+                                      index_match_new (local, record,
+                                                       disc_id));
+        }
+    }
+
+    return g_list_reverse (matches);
+}
+
+/*
+ * split_words:
+ * @text: a title, or the words of a search
+ *
+ * Split @text into words, for the word index. The words are case folded and
+ * stripped of accents, so that a search for "bjork" finds "Björk".
+ *
+ * Returns: (transfer full): a %NULL-terminated array of words
+ */
+static gchar **
+split_words (const gchar *text)
+{
+    GPtrArray *words;
+    GString *word;
+    gchar *folded;
+    gchar *normalized;
+    const gchar *p;
+
+    words = g_ptr_array_new ();
+    word = g_string_new (NULL);
+
+    folded = g_utf8_casefold (text, -1);
+    normalized = g_utf8_normalize (folded, -1, G_NORMALIZE_ALL);
+    g_free (folded);
+
+    for (p = normalized; p != NULL; p = *p ? g_utf8_next_char (p) : NULL)
+    {
+        gunichar c = g_utf8_get_char (p);
+
+        if (c != 0 && g_unichar_ismark (c))
+        {
+            continue;
+        }
+
+        if (c != 0 && g_unichar_isalnum (c))
+        {
+            g_string_append_unichar (word, c);
+        }
+        else if (word->len > 0)
+        {
+            g_ptr_array_add (words, g_strndup (word->str, word->len));
+            g_string_truncate (word, 0);
+        }
+    }
+
+    g_free (normalized);
+    g_string_free (word, TRUE);
+    g_ptr_array_add (words, NULL);
+
+    return (gchar **)g_ptr_array_free (words, FALSE);
+}
+
+static const IndexWord *
+index_find_word (EtCddbLocal *local,
+                 const gchar *word)
+{
+    guint32 low = 0;
+    guint32 high = local->header->n_words;
+
+    while (low < high)
+    {
+        guint32 middle = low + (high - low) / 2;
+        gint cmp;
+
+        cmp = strcmp (index_get_string (local, local->words[middle].word),
+                      word);
+
+        if (cmp == 0)
+        {
+            return &local->words[middle];
+        }
+        else if (cmp < 0)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return NULL;
+}
+
+static gint
+compare_words_by_n_postings (gconstpointer a,
+                             gconstpointer b)
+{
+    const IndexWord *word_a = *(const IndexWord * const *)a;
+    const IndexWord *word_b = *(const IndexWord * const *)b;
+
+    return (word_a->n_postings > word_b->n_postings)
+           - (word_a->n_postings < word_b->n_postings);
+}
+
+static gboolean
+strv_contains (const gchar * const *strv,
+               const gchar *str)
+{
+    for (; *strv != NULL; strv++)
+    {
+        if (strcmp (*strv, str) == 0)
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/*
+ * et_cddb_local_search:
+ * @local: a local CDDB index
+ * @words: the words to search for, separated by spaces or '+'
+ * @categories: (allow-none): the categories to search in, or %NULL to search
+ *              in all categories
+ *
+ * Search for the albums which have all of @words in their title.
+ *
+ * Returns: (element-type EtCddbLocalMatch) (transfer full): the matching
+ *          albums, free with et_cddb_local_match_free()
+ */
+GList *
+et_cddb_local_search (EtCddbLocal *local,
+                      const gchar *words,
+                      const gchar * const *categories)
+{
+    gchar **split;
+    GPtrArray *postings;
+    GArray *result = NULL;
+    GList *matches = NULL;
+    guint i;
+
+    g_return_val_if_fail (local != NULL, NULL);
+    g_return_val_if_fail (words != NULL, NULL);
+
+    split = split_words (words);
+    postings = g_ptr_array_new ();
+
+    for (i = 0; split[i] != NULL; i++)
+    {
+        const IndexWord *word;
+
+        if (!(word = index_find_word (local, split[i])))
+        {
+            /* A word is missing, so no album has all the words. */
+            g_ptr_array_set_size (postings, 0);
+            break;
+        }
+
+        g_ptr_array_add (postings, (gpointer)word);
+    }
+
+    g_strfreev (split);
+
+    if (postings->len == 0)
+    {
+        g_ptr_array_free (postings, TRUE);
+        return NULL;
+    }
+
+    /* Intersect the postings, starting with the shortest list. */
+    g_ptr_array_sort (postings, compare_words_by_n_postings);
+
+    for (i = 0; i < postings->len; i++)
+    {
+        const IndexWord *word = g_ptr_array_index (postings, i);
+        const guint32 *list;
+        guint32 n;
+
+        if (word->first_posting > local->header->n_postings
+            || word->n_postings > local->header->n_postings
+                                  - word->first_posting)
+        {
+            if (result != NULL)
+            {
+                g_array_set_size (result, 0);
+            }
+
+            break;
+        }
+
+        list = local->postings + word->first_posting;
+        n = word->n_postings;
+
+        if (result == NULL)
+        {
+            result = g_array_sized_new (FALSE, FALSE, sizeof (guint32), n);
+            g_array_append_vals (result, list, n);
+        }
+        else
+        {
+            guint32 j = 0;
+            guint32 k;
+            guint32 kept = 0;
+
+            for (k = 0; k < result->len; k++)
+            {
+                guint32 record = g_array_index (result, guint32, k);
+
+                while (j < n && list[j] < record)
+                {
+                    j++;
+                }
+
+                if (j < n && list[j] == record)
+                {
+                    g_array_index (result, guint32, kept++) = record;
+                }
+            }
+
+            g_array_set_size (result, kept);
+        }
+
+        if (result->len == 0)
+        {
+            break;
+        }
+    }
+
+    g_ptr_array_free (postings, TRUE);
+
+    if (result == NULL)
+    {
+        return NULL;
+    }
+
+    for (i = 0; i < result->len; i++)
+    {
+        guint32 record_index = g_array_index (result, guint32, i);
+        const IndexRecord *record;
+
+        if (record_index >= local->header->n_records)
+        {
+            continue;
+        }
+
+        record = &local->records[record_index];
+
+        if (categories != NULL
+            && !strv_contains (categories,
+                               index_get_string (local, record->category)))
+        {
+            continue;
+        }
+
+        if (record->n_disc_ids == 0
+            || record->first_disc_id >= local->header->n_record_disc_ids)
+        {
+            continue;
+        }
+
+        matches = g_list_prepend (matches,
+                                  index_match_new (local, record_index,
+                                                   local->record_disc_ids[record->first_disc_id]));
+    }
+
+    g_array_free (result, TRUE);
+
+    return g_list_reverse (matches);
+}
+
+/*
+ * read_tar_member:
+ * @path: the path of the tarball
+ * @offset: the offset of the member
+ * @length: the length of the member
+ * @error: a #GError to provide information on errors, or %NULL to ignore
+ *
+ * Read a member of a tarball.
+ *
+ * Returns: the contents of the member, or %NULL on error
+ */
+static GBytes *
+read_tar_member (const gchar *path,
+                 guint64 offset,
+                 gsize length,
+                 GError **error)
+{
+    GFile *file;
+    GFileInputStream *istream;
+    gchar *data;
+    gsize bytes_read;
+
+    file = g_file_new_for_path (path);
+    istream = g_file_read (file, NULL, error);
+    g_object_unref (file);
+
+    if (!istream)
+    {
+        return NULL;
+    }
+
+    data = g_malloc (length);
+
+    if (!g_seekable_seek (G_SEEKABLE (istream), offset, G_SEEK_SET, NULL,
+                          error)
+        || !g_input_stream_read_all (G_INPUT_STREAM (istream), data, length,
+                                     &bytes_read, NULL, error))
+    {
+        g_free (data);
+        g_object_unref (istream);
+        return NULL;
+    }
+
+    g_object_unref (istream);
+
+    if (bytes_read != length)
+    {
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                     _("The local CDDB dump changed since it was indexed"));
+        g_free (data);
+        return NULL;
+    }
+
+    return g_bytes_new_take (data, length);
+}
+
+/*
+ * et_cddb_local_read:
+ * @local: a local CDDB index
+ * @category: the category of the album
+ * @disc_id: the disc ID of the album
+ * @error: a #GError to provide information on errors, or %NULL to ignore
+ *
+ * Read the xmcd record of an album from the dump. The record has the same
+ * format as the response to a "cddb read", without the status line.
+ *
+ * Returns: the record, or %NULL on error
+ */
+GBytes *
+et_cddb_local_read (EtCddbLocal *local,
+                    const gchar *category,
+                    guint32 disc_id,
+                    GError **error)
+{
+    const gchar *dump_path;
+    guint32 i;
+
+    g_return_val_if_fail (local != NULL, NULL);
+    g_return_val_if_fail (category != NULL, NULL);
+    g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+    dump_path = et_cddb_local_get_dump_path (local);
+
+    for (i = index_find_disc_id (local, disc_id);
+         i < local->header->n_disc_ids && local->disc_ids[i].disc_id == disc_id;
+         i++)
+    {
+        const IndexRecord *record;
+        const IndexFile *file;
+        gchar *path;
+        gchar *contents;
+        gsize length;
+
+        if (local->disc_ids[i].record >= local->header->n_records)
+        {
+            continue;
+        }
+
+        record = &local->records[local->disc_ids[i].record];
+
+        if (strcmp (index_get_string (local, record->category), category) != 0
+            || record->file >= local->header->n_files)
+        {
+            continue;
+        }
+
+        if (local->header->flags & INDEX_FLAG_TAR)
+        {
+            return read_tar_member (dump_path, record->offset, record->length,
+                                    error);
+        }
+
+        file = &local->files[record->file];
+        path = g_build_filename (dump_path,
+                                 index_get_string (local, file->path), NULL);
+
+        if (!g_file_get_contents (path, &contents, &length, error))
+        {
+            g_free (path);
+            return NULL;
+        }
+
+        g_free (path);
+
+        return g_bytes_new_take (contents, length);
+    }
+
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND,
+                 _("The album ‘%s/%08x’ is not in the local CDDB"), category,
+                 disc_id);
+
+    return NULL;
+}
+
+static void
+build_record_free (BuildRecord *record)
+{
+    g_free (record->path);
+    g_free (record->title);
+    g_array_free (record->disc_ids, TRUE);
+    g_slice_free (BuildRecord, record);
+}
+
+static void
+tar_member_free (TarMember *member)
+{
+    g_free (member->data);
+    g_slice_free (TarMember, member);
+}
+
+static void
+build_job_free (BuildJob *job)
+{
+    g_free (job->category);
+
+    if (job->members)
+    {
+        g_ptr_array_free (job->members, TRUE);
+    }
+
+    g_ptr_array_free (job->records, TRUE);
+    g_slice_free (BuildJob, job);
+}
+
+static BuildJob *
+build_job_new (void)
+{
+    BuildJob *job;
+
+    job = g_slice_new0 (BuildJob);
+    job->records = g_ptr_array_new_with_free_func ((GDestroyNotify)build_record_free);
+
+    return job;
+}
+
+static void
+build_context_set_error (BuildContext *context,
+                         GError *error)
+{
+    g_mutex_lock (&context->lock);
+
+    if (context->error == NULL)
+    {
+        context->error = error;
+    }
+    else
+    {
+        g_error_free (error);
+    }
+
+    g_mutex_unlock (&context->lock);
+}
+
+static gboolean
+build_context_is_cancelled (BuildContext *context)
+{
+    GError *error = NULL;
+
+    if (g_cancellable_set_error_if_cancelled (context->cancellable, &error))
+    {
+        build_context_set_error (context, error);
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+/*
+ * parse_record:
+ * @data: an xmcd record
+ * @length: the length of @data
+ * @disc_ids: an array to which to append the disc IDs of the record
+ *
+ * Read the disc IDs and the title of an xmcd record.
+ *
+ * Returns: the title of the record, or %NULL if it has no disc ID
+ */
+static gchar *
+parse_record (const gchar *data,
+              gsize length,
+              GArray *disc_ids)
+{
+    GString *title;
+    const gchar *end = data + length;
+    const gchar *line;
+
+    title = g_string_new (NULL);
+
+    for (line = data; line < end;)
+    {
+        const gchar *eol = memchr (line, '\n', end - line);
+        gsize line_length;
+
+        if (eol == NULL)
+        {
+            eol = end;
+        }
+
+        line_length = eol - line;
+
+        if (line_length > 0 && line[line_length - 1] == '\r')
+        {
+            line_length--;
+        }
+
+        if (line_length > 7 && strncmp (line, "DISCID=", 7) == 0)
+        {
+            /* Several disc IDs may be given, separated by commas. */
+            gchar *value = g_strndup (line + 7, line_length - 7);
+            gchar **ids = g_strsplit (value, ",", -1);
+            gsize i;
+
+            for (i = 0; ids[i] != NULL; i++)
+            {
+                gchar *id_end;
+                guint64 id = g_ascii_strtoull (g_strstrip (ids[i]), &id_end,
+                                               16);
+
+                if (id_end != ids[i] && *id_end == '\0' && id <= G_MAXUINT32)
+                {
+                    guint32 disc_id = id;
+
+                    g_array_append_val (disc_ids, disc_id);
+                }
+            }
+
+            g_strfreev (ids);
+            g_free (value);
+        }
+        else if (line_length >= 7 && strncmp (line, "DTITLE=", 7) == 0)
+        {
+            /* Long titles are split across several lines. */
+            g_string_append_len (title, line + 7, line_length - 7);
+        }
+
+        line = eol + 1;
+    }
+
+    if (disc_ids->len == 0)
+    {
+        g_string_free (title, TRUE);
+        return NULL;
+    }
+
+    if (!g_utf8_validate (title->str, title->len, NULL))
+    {
+        /* Old records may be in ISO-8859-1. */
+        gchar *converted = g_convert (title->str, title->len, "UTF-8",
+                                      "ISO-8859-1", NULL, NULL, NULL);
+
+        g_string_free (title, TRUE);
+
+        return converted != NULL ? converted : g_strdup ("");
+    }
+
+    return g_string_free (title, FALSE);
+}
+
+/*
+ * reuse_old_records:
+ * @context: the state of the update
+ * @path: the path of a file, relative to the dump
+ * @statbuf: the status of the file
+ * @records: an array to which to append the records
+ *
+ * Copy the records of a file from the previous index, if the file did not
+ * change since.
+ *
+ * Returns: %TRUE if the records were copied, %FALSE if the file must be read
+ */
+static gboolean
+reuse_old_records (BuildContext *context,
+                   const gchar *path,
+                   const GStatBuf *statbuf,
+                   GPtrArray *records)
+{
+    EtCddbLocal *old = context->old;
+    const IndexFile *file;
+    gpointer value;
+    guint32 i;
+
+    if (context->old_files == NULL
+        || !(value = g_hash_table_lookup (context->old_files, path)))
+    {
+        return FALSE;
+    }
+
+    file = &old->files[GPOINTER_TO_UINT (value) - 1];
+
+    if (file->mtime != (gint64)statbuf->st_mtime
+        || file->size != (guint64)statbuf->st_size
+        || file->first_record > old->header->n_records
+        || file->n_records > old->header->n_records - file->first_record)
+    {
+        return FALSE;
+    }
+
+    for (i = file->first_record; i < file->first_record + file->n_records; i++)
+    {
+        const IndexRecord *old_record = &old->records[i];
+        BuildRecord *record;
+
+        if (old_record->first_disc_id > old->header->n_record_disc_ids
+            || old_record->n_disc_ids > old->header->n_record_disc_ids
+                                        - old_record->first_disc_id)
+        {
+            continue;
+        }
+
+        record = g_slice_new0 (BuildRecord);
+        record->path = g_strdup (path);
+        record->mtime = file->mtime;
+        record->size = file->size;
+        record->category = g_intern_string (index_get_string (old, old_record->category));
+        record->length = old_record->length;
+        record->title = g_strdup (index_get_string (old, old_record->title));
+        record->disc_ids = g_array_sized_new (FALSE, FALSE, sizeof (guint32),
+                                              old_record->n_disc_ids);
+        g_array_append_vals (record->disc_ids,
+                             old->record_disc_ids + old_record->first_disc_id,
+                             old_record->n_disc_ids);
+        g_ptr_array_add (records, record);
+    }
+
+    return TRUE;
+}
+
+/*
+ * read_category_directory:
+ * @context: the state of the update
+ * @job: a job with the category directory to read
+ *
+ * Read the records of a category directory of the dump, reusing those of the
+ * files which did not change since the previous update.
+ */
+static void
+read_category_directory (BuildContext *context,
+                         BuildJob *job)
+{
+    gchar *dir_path;
+    GDir *dir;
+    const gchar *name;
+    const gchar *category;
+    GError *error = NULL;
+
+    dir_path = g_build_filename (context->dump_path, job->category, NULL);
+    dir = g_dir_open (dir_path, 0, &error);
+
+    if (!dir)
+    {
+        build_context_set_error (context, error);
+        g_free (dir_path);
+        return;
+    }
+
+    category = g_intern_string (job->category);
+
+    while ((name = g_dir_read_name (dir)))
+    {
+        gchar *path;
+        gchar *full_path;
+        GStatBuf statbuf;
+        gchar *contents;
+        gsize length;
+        BuildRecord *record;
+
+        if (build_context_is_cancelled (context))
+        {
+            break;
+        }
+
+        path = g_build_filename (job->category, name, NULL);
+        full_path = g_build_filename (dir_path, name, NULL);
+
+        if (g_stat (full_path, &statbuf) != 0 || !S_ISREG (statbuf.st_mode)
+            || statbuf.st_size > MAX_RECORD_SIZE)
+        {
+            g_free (full_path);
+            g_free (path);
+            continue;
+        }
+
+        if (reuse_old_records (context, path, &statbuf, job->records))
+        {
+            job->n_reused++;
+            g_free (full_path);
+            g_free (path);
+            continue;
+        }
+
+        if (!g_file_get_contents (full_path, &contents, &length, &error))
+        {
+            /* Skip the files which cannot be read, rather than failing. */
+            g_debug ("Error reading local CDDB record: %s", error->message);
+            g_clear_error (&error);
+            g_free (full_path);
+            g_free (path);
+            continue;
+        }
+
+        record = g_slice_new0 (BuildRecord);
+        record->disc_ids = g_array_new (FALSE, FALSE, sizeof (guint32));
+
+        if (!(record->title = parse_record (contents, length,
+                                            record->disc_ids)))
+        {
+            build_record_free (record);
+            g_free (contents);
+            g_free (full_path);
+            g_free (path);
+            continue;
+        }
+
+        record->path = path;
+        record->mtime = statbuf.st_mtime;
+        record->size = statbuf.st_size;
+        record->category = category;
+        record->length = length;
+        g_ptr_array_add (job->records, record);
+
+        g_free (contents);
+        g_free (full_path);
+    }
+
+    g_dir_close (dir);
+    g_free (dir_path);
+}
+
+/*
+ * parse_tar_members:
+ * @context: the state of the update
+ * @job: a job with the tarball members to parse
+ *
+ * Parse a batch of members of a tarball dump.
+ */
+static void
+parse_tar_members (BuildContext *context,
+                   BuildJob *job)
+{
+    guint i;
+
+    for (i = 0; i < job->members->len; i++)
+    {
+        TarMember *member = g_ptr_array_index (job->members, i);
+        BuildRecord *record;
+
+        if (build_context_is_cancelled (context))
+        {
+            break;
+        }
+
+        record = g_slice_new0 (BuildRecord);
+        record->disc_ids = g_array_new (FALSE, FALSE, sizeof (guint32));
+
+        if (!(record->title = parse_record (member->data, member->length,
+                                            record->disc_ids)))
+        {
+            build_record_free (record);
+            continue;
+        }
+
+        record->category = member->category;
+        record->offset = member->offset;
+        record->length = member->length;
+        g_ptr_array_add (job->records, record);
+    }
+
+    /* The contents are no longer needed. */
+    g_ptr_array_set_size (job->members, 0);
+}
+
+static void
+build_job_run (gpointer data,
+               gpointer user_data)
+{
+    BuildJob *job = data;
+    BuildContext *context = user_data;
+
+    if (job->category)
+    {
+        read_category_directory (context, job);
+    }
+    else
+    {
+        parse_tar_members (context, job);
+    }
+}
+
+/*
+ * parse_tar_octal:
+ * @field: a numeric field of a tar header
+ * @length: the length of @field
+ *
+ * Returns: the value of @field
+ */
+static guint64
+parse_tar_octal (const gchar *field,
+                 gsize length)
+{
+    guint64 value = 0;
+    gsize i;
+
+    i = 0;
+
+    while (i < length && field[i] == ' ')
+    {
+        i++;
+    }
+
+    for (; i < length && field[i] >= '0' && field[i] <= '7'; i++)
+    {
+        value = value * 8 + (field[i] - '0');
+    }
+
+    return value;
+}
+
+/*
+ * tar_member_get_category:
+ * @header: a tar header block
+ *
+ * Get the category of a member, from the name of its parent directory.
+ *
+ * Returns: the interned category, or %NULL if the member is not in a
+ *          directory
+ */
+static const gchar *
+tar_member_get_category (const gchar *header)
+{
+    gchar *name;
+    gchar *dirname;
+    gchar *category;
+    const gchar *interned;
+
+    /* The ustar prefix, at offset 345, is prepended to the name. */
+    if (memcmp (header + 257, "ustar", 5) == 0 && header[345] != '\0')
+    {
+        gchar *prefix = g_strndup (header + 345, 155);
+        gchar *member_name = g_strndup (header, 100);
+
+        name = g_strconcat (prefix, "/", member_name, NULL);
+        g_free (member_name);
+        g_free (prefix);
+    }
+    else
+    {
+        name = g_strndup (header, 100);
+    }
+
+    dirname = g_path_get_dirname (name);
+    g_free (name);
+
+    if (strcmp (dirname, ".") == 0)
+    {
+        g_free (dirname);
+        return NULL;
+    }
+
+    category = g_path_get_basename (dirname);
+    interned = g_intern_string (category);
+    g_free (category);
+    g_free (dirname);
+
+    return interned;
+}
+
+/*
+ * read_tar:
+ * @context: the state of the update
+ * @pool: the pool to which to push the jobs
+ * @jobs: an array to which to append the jobs
+ * @error: a #GError to provide information on errors, or %NULL to ignore
+ *
+ * Read a tarball dump sequentially, handing batches of members to the pool
+ * to be parsed.
+ *
+ * Returns: %TRUE on success, %FALSE otherwise
+ */
+static gboolean
+read_tar (BuildContext *context,
+          GThreadPool *pool,
+          GPtrArray *jobs,
+          GError **error)
+{
+    GFile *file;
+    GFileInputStream *istream;
+    GInputStream *stream;
+    BuildJob *job = NULL;
+    guint64 offset = 0;
+    gchar header[TAR_BLOCK_SIZE];
+    gboolean success = FALSE;
+
+    file = g_file_new_for_path (context->dump_path);
+    istream = g_file_read (file, context->cancellable, error);
+    g_object_unref (file);
+
+    if (!istream)
+    {
+        return FALSE;
+    }
+
+    stream = G_INPUT_STREAM (istream);
+
+    for (;;)
+    {
+        gsize bytes_read;
+        guint64 size;
+        guint64 padded_size;
+        const gchar *category;
+
+        if (!g_input_stream_read_all (stream, header, TAR_BLOCK_SIZE,
+                                      &bytes_read, context->cancellable,
+                                      error))
+        {
+            goto out;
+        }
+
+        offset += bytes_read;
+
+        /* The archive ends with a zero block, which may be missing. */
+        if (bytes_read < TAR_BLOCK_SIZE || header[0] == '\0')
+        {
+            break;
+        }
+
+        size = parse_tar_octal (header + 124, 12);
+        padded_size = (size + TAR_BLOCK_SIZE - 1)
+                      / TAR_BLOCK_SIZE * TAR_BLOCK_SIZE;
+        category = tar_member_get_category (header);
+
+        /* Only regular files in a category directory are records. */
+        if ((header[156] == '0' || header[156] == '\0') && category != NULL
+            && size > 0 && size <= MAX_RECORD_SIZE)
+        {
+            TarMember *member;
+
+            member = g_slice_new (TarMember);
+            member->category = category;
+            member->offset = offset;
+            member->length = size;
+            member->data = g_malloc (size);
+
+            if (!g_input_stream_read_all (stream, member->data, size,
+                                          &bytes_read, context->cancellable,
+                                          error))
+            {
+                tar_member_free (member);
+                goto out;
+            }
+
+            if (bytes_read < size)
+            {
+                tar_member_free (member);
+                g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                             _("The local CDDB dump is truncated: %s"),
+                             context->dump_path);
+                goto out;
+            }
+
+            if (job == NULL)
+            {
+                job = build_job_new ();
+                job->members = g_ptr_array_new_with_free_func ((GDestroyNotify)tar_member_free);
+            }
+
+            g_ptr_array_add (job->members, member);
+            offset += size;
+            padded_size -= size;
+
+            if (job->members->len == TAR_BATCH_SIZE)
+            {
+                g_ptr_array_add (jobs, job);
+                g_thread_pool_push (pool, job, NULL);
+                job = NULL;
+            }
+        }
+
+        if (padded_size > 0)
+        {
+            if (g_input_stream_skip (stream, padded_size, context->cancellable,
+                                     error) < 0)
+            {
+                goto out;
+            }
+
+            offset += padded_size;
+        }
+    }
+
+    success = TRUE;
+
+out:
+    if (job != NULL)
+    {
+        g_ptr_array_add (jobs, job);
+        g_thread_pool_push (pool, job, NULL);
+    }
+
+    g_object_unref (istream);
+
+    return success;
+}
+
+static gint
+compare_strings (gconstpointer a,
+                 gconstpointer b)
+{
+    return strcmp (*(const gchar * const *)a, *(const gchar * const *)b);
+}
+
+/*
+ * list_categories:
+ * @dump_path: the path of a dump directory
+ * @jobs: an array to which to append a job for each category directory
+ * @error: a #GError to provide information on errors, or %NULL to ignore
+ *
+ * Returns: %TRUE on success, %FALSE otherwise
+ */
+static gboolean
+list_categories (const gchar *dump_path,
+                 GPtrArray *jobs,
+                 GError **error)
+{
+    GDir *dir;
+    const gchar *name;
+    GPtrArray *names;
+    guint i;
+
+    if (!(dir = g_dir_open (dump_path, 0, error)))
+    {
+        return FALSE;
+    }
+
+    names = g_ptr_array_new ();
+
+    while ((name = g_dir_read_name (dir)))
+    {
+        gchar *path = g_build_filename (dump_path, name, NULL);
+
+        if (g_file_test (path, G_FILE_TEST_IS_DIR))
+        {
+            g_ptr_array_add (names, g_strdup (name));
+        }
+
+        g_free (path);
+    }
+
+    g_dir_close (dir);
+
+    /* Keep the order of the index stable. */
+    g_ptr_array_sort (names, compare_strings);
+
+    for (i = 0; i < names->len; i++)
+    {
+        BuildJob *job = build_job_new ();
+
+        job->category = g_ptr_array_index (names, i);
+        g_ptr_array_add (jobs, job);
+    }
+
+    g_ptr_array_free (names, TRUE);
+
+    return TRUE;
+}
+
+/*
+ * StringTable:
+ * @strings: the contents of the table
+ * @shared: the offsets of the strings which are often repeated
+ */
+typedef struct
+{
+    GString *strings;
+    GHashTable *shared;
+} StringTable;
+
+static guint32
+string_table_add (StringTable *table,
+                  const gchar *string)
+{
+    guint32 offset = table->strings->len;
+
+    g_string_append_len (table->strings, string, strlen (string) + 1);
+
+    return offset;
+}
+
+static guint32
+string_table_add_shared (StringTable *table,
+                         const gchar *string)
+{
+    gpointer value;
+
+    if (g_hash_table_lookup_extended (table->shared, string, NULL, &value))
+    {
+        return GPOINTER_TO_UINT (value);
+    }
+
+    value = GUINT_TO_POINTER (string_table_add (table, string));
+    g_hash_table_insert (table->shared, (gpointer)string, value);
+
+    return GPOINTER_TO_UINT (value);
+}
+
+static gint
+compare_disc_ids (gconstpointer a,
+                  gconstpointer b)
+{
+    const IndexDiscId *disc_id_a = a;
+    const IndexDiscId *disc_id_b = b;
+
+    if (disc_id_a->disc_id != disc_id_b->disc_id)
+    {
+        return disc_id_a->disc_id < disc_id_b->disc_id ? -1 : 1;
+    }
+
+    return (disc_id_a->record > disc_id_b->record)
+           - (disc_id_a->record < disc_id_b->record);
+}
+
+/*
+ * write_index:
+ * @dump_path: the path of the dump
+ * @is_tar: whether the dump is a tarball
+ * @tar_statbuf: the status of the tarball, if @is_tar
+ * @jobs: the jobs, with the records which were read
+ * @index_path: the path of the index to write
+ * @error: a #GError to provide information on errors, or %NULL to ignore
+ *
+ * Build the tables of the index from the records, and write it.
+ *
+ * Returns: %TRUE on success, %FALSE otherwise
+ */
+static gboolean
+write_index (const gchar *dump_path,
+             gboolean is_tar,
+             const GStatBuf *tar_statbuf,
+             GPtrArray *jobs,
+             const gchar *index_path,
+             GError **error)
+{
+    IndexHeader header;
+    GArray *files;
+    GArray *records;
+    GArray *record_disc_ids;
+    GArray *disc_ids;
+    GArray *words;
+    GArray *postings;
+    GHashTable *word_postings;
+    GPtrArray *sorted_words;
+    StringTable strings;
+    GByteArray *contents;
+    gchar *dirname;
+    guint i;
+    gboolean success;
+
+    files = g_array_new (FALSE, FALSE, sizeof (IndexFile));
+    records = g_array_new (FALSE, FALSE, sizeof (IndexRecord));
+    record_disc_ids = g_array_new (FALSE, FALSE, sizeof (guint32));
+    disc_ids = g_array_new (FALSE, FALSE, sizeof (IndexDiscId));
+    words = g_array_new (FALSE, FALSE, sizeof (IndexWord));
+    postings = g_array_new (FALSE, FALSE, sizeof (guint32));
+    word_postings = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                           (GDestroyNotify)g_array_unref);
+    strings.strings = g_string_new (NULL);
+    strings.shared = g_hash_table_new (g_str_hash, g_str_equal);
+
+    memset (&header, 0, sizeof (header));
+    memcpy (header.magic, INDEX_MAGIC, sizeof (header.magic));
+    header.version = INDEX_VERSION;
+    header.byte_order = INDEX_BYTE_ORDER;
+    header.flags = is_tar ? INDEX_FLAG_TAR : 0;
+    header.dump_path = string_table_add (&strings, dump_path);
+
+    if (is_tar)
+    {
+        IndexFile file = { 0, };
+
+        file.path = string_table_add (&strings, "");
+        file.mtime = tar_statbuf->st_mtime;
+        file.size = tar_statbuf->st_size;
+        g_array_append_val (files, file);
+    }
+
+    for (i = 0; i < jobs->len; i++)
+    {
+        BuildJob *job = g_ptr_array_index (jobs, i);
+        guint j;
+
+        for (j = 0; j < job->records->len; j++)
+        {
+            BuildRecord *build_record = g_ptr_array_index (job->records, j);
+            IndexRecord record = { 0, };
+            gchar **title_words;
+            guint k;
+
+            if (!is_tar)
+            {
+                IndexFile file = { 0, };
+
+                file.path = string_table_add (&strings, build_record->path);
+                file.first_record = records->len;
+                file.n_records = 1;
+                file.mtime = build_record->mtime;
+                file.size = build_record->size;
+                g_array_append_val (files, file);
+            }
+
+            record.file = files->len - 1;
+            record.category = string_table_add_shared (&strings,
+                                                       build_record->category);
+            record.offset = build_record->offset;
+            record.length = build_record->length;
+            record.title = string_table_add (&strings, build_record->title);
+            record.first_disc_id = record_disc_ids->len;
+            record.n_disc_ids = build_record->disc_ids->len;
+
+            for (k = 0; k < build_record->disc_ids->len; k++)
+            {
+                IndexDiscId disc_id;
+
+                disc_id.disc_id = g_array_index (build_record->disc_ids,
+                                                 guint32, k);
+                disc_id.record = records->len;
+                g_array_append_val (record_disc_ids, disc_id.disc_id);
+                g_array_append_val (disc_ids, disc_id);
+            }
+
+            /* The records are added in order, so that each list of postings
+             * is sorted. */
+            title_words = split_words (build_record->title);
+
+            for (k = 0; title_words[k] != NULL; k++)
+            {
+                GArray *list = g_hash_table_lookup (word_postings,
+                                                    title_words[k]);
+                guint32 record_index = records->len;
+
+                if (list == NULL)
+                {
+                    list = g_array_new (FALSE, FALSE, sizeof (guint32));
+                    g_hash_table_insert (word_postings,
+                                         g_strdup (title_words[k]), list);
+                }
+                else if (g_array_index (list, guint32, list->len - 1)
+                         == record_index)
+                {
+                    /* The word is repeated in the title. */
+                    continue;
+                }
+
+                g_array_append_val (list, record_index);
+            }
+
+            g_strfreev (title_words);
+            g_array_append_val (records, record);
+        }
+    }
+
+    if (is_tar)
+    {
+        g_array_index (files, IndexFile, 0).n_records = records->len;
+    }
+
+    g_array_sort (disc_ids, compare_disc_ids);
+
+    sorted_words = g_ptr_array_sized_new (g_hash_table_size (word_postings));
+
+    {
+        GHashTableIter iter;
+        gpointer key;
+
+        g_hash_table_iter_init (&iter, word_postings);
+
+        while (g_hash_table_iter_next (&iter, &key, NULL))
+        {
+            g_ptr_array_add (sorted_words, key);
+        }
+    }
+
+    g_ptr_array_sort (sorted_words, compare_strings);
+
+    for (i = 0; i < sorted_words->len; i++)
+    {
+        const gchar *word_string = g_ptr_array_index (sorted_words, i);
+        GArray *list = g_hash_table_lookup (word_postings, word_string);
+        IndexWord word;
+
+        word.word = string_table_add (&strings, word_string);
+        word.first_posting = postings->len;
+        word.n_postings = list->len;
+        g_array_append_vals (postings, list->data, list->len);
+        g_array_append_val (words, word);
+    }
+
+    g_ptr_array_free (sorted_words, TRUE);
+
+    header.n_files = files->len;
+    header.n_records = records->len;
+    header.n_record_disc_ids = record_disc_ids->len;
+    header.n_disc_ids = disc_ids->len;
+    header.n_words = words->len;
+    header.n_postings = postings->len;
+    header.strings_size = strings.strings->len;
+
+    contents = g_byte_array_new ();
+    g_byte_array_append (contents, (const guint8 *)&header, sizeof (header));
+    g_byte_array_append (contents, (const guint8 *)files->data,
+                         files->len * sizeof (IndexFile));
+    g_byte_array_append (contents, (const guint8 *)records->data,
+                         records->len * sizeof (IndexRecord));
+    g_byte_array_append (contents, (const guint8 *)record_disc_ids->data,
+                         record_disc_ids->len * sizeof (guint32));
+    g_byte_array_append (contents, (const guint8 *)disc_ids->data,
+                         disc_ids->len * sizeof (IndexDiscId));
+    g_byte_array_append (contents, (const guint8 *)words->data,
+                         words->len * sizeof (IndexWord));
+    g_byte_array_append (contents, (const guint8 *)postings->data,
+                         postings->len * sizeof (guint32));
+    g_byte_array_append (contents, (const guint8 *)strings.strings->str,
+                         strings.strings->len);
+
+    g_array_free (files, TRUE);
+    g_array_free (records, TRUE);
+    g_array_free (record_disc_ids, TRUE);
+    g_array_free (disc_ids, TRUE);
+    g_array_free (words, TRUE);
+    g_array_free (postings, TRUE);
+    g_hash_table_unref (word_postings);
+    g_hash_table_unref (strings.shared);
+    g_string_free (strings.strings, TRUE);
+
+    dirname = g_path_get_dirname (index_path);
+
+    if (g_mkdir_with_parents (dirname, 0700) != 0)
+    {
+        gint saved_errno = errno;
+
+        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (saved_errno),
+                     _("Cannot create directory ‘%s’: %s"), dirname,
+                     g_strerror (saved_errno));
+        g_free (dirname);
+        g_byte_array_free (contents, TRUE);
+        return FALSE;
+    }
+
+    g_free (dirname);
+
+    /* The index is replaced atomically, so that it can be opened while it
+     * is updated. */
+    success = g_file_set_contents (index_path, (const gchar *)contents->data,
+                                   contents->len, error);
+    g_byte_array_free (contents, TRUE);
+
+    return success;
+}
+
+/*
+ * et_cddb_local_update:
+ * @dump_path: the path of a freedb dump, either a directory or a tarball
+ * @index_path: the path of the index
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @error: a #GError to provide information on errors, or %NULL to ignore
+ *
+ * Build or update the index of a freedb dump, with the disc IDs of the
+ * albums and the words of their titles.
+ *
+ * The categories of a dump directory are read in parallel. The files which
+ * did not change since the previous update are not read again, and the index
+ * is not rewritten if nothing changed. A tarball is read sequentially, with
+ * its records parsed in parallel, and only if it changed.
+ *
+ * Returns: %TRUE on success, %FALSE otherwise
+ */
+gboolean
+et_cddb_local_update (const gchar *dump_path,
+                      const gchar *index_path,
+                      GCancellable *cancellable,
+                      GError **error)
+{
+    BuildContext context;
+    GStatBuf statbuf;
+    gboolean is_tar;
+    GThreadPool *pool;
+    GPtrArray *jobs;
+    guint n_records = 0;
+    guint n_reused = 0;
+    guint i;
+    gboolean success = FALSE;
+
+    g_return_val_if_fail (dump_path != NULL, FALSE);
+    g_return_val_if_fail (index_path != NULL, FALSE);
+    g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+    if (g_stat (dump_path, &statbuf) != 0)
+    {
+        gint saved_errno = errno;
+
+        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (saved_errno),
+                     _("Cannot open the local CDDB ‘%s’: %s"), dump_path,
+                     g_strerror (saved_errno));
+        return FALSE;
+    }
+
+    is_tar = !S_ISDIR (statbuf.st_mode);
+
+    memset (&context, 0, sizeof (context));
+    context.dump_path = dump_path;
+    context.cancellable = cancellable;
+    g_mutex_init (&context.lock);
+
+    /* Only an index of the same dump can be reused. */
+    if ((context.old = et_cddb_local_open (index_path, NULL))
+        && strcmp (et_cddb_local_get_dump_path (context.old), dump_path) != 0)
+    {
+        g_clear_pointer (&context.old, et_cddb_local_free);
+    }
+
+    if (context.old != NULL && is_tar)
+    {
+        const IndexFile *file = context.old->files;
+
+        if ((context.old->header->flags & INDEX_FLAG_TAR)
+            && context.old->header->n_files == 1
+            && file->mtime == (gint64)statbuf.st_mtime
+            && file->size == (guint64)statbuf.st_size)
+        {
+            /* The tarball did not change. */
+            et_cddb_local_free (context.old);
+            g_mutex_clear (&context.lock);
+            return TRUE;
+        }
+    }
+    else if (context.old != NULL
+             && !(context.old->header->flags & INDEX_FLAG_TAR))
+    {
+        context.old_files = g_hash_table_new (g_str_hash, g_str_equal);
+
+        for (i = 0; i < context.old->header->n_files; i++)
+        {
+            g_hash_table_insert (context.old_files,
+                                 (gpointer)index_get_string (context.old,
+                                                             context.old->files[i].path),
+                                 GUINT_TO_POINTER (i + 1));
+        }
+    }
+
+    jobs = g_ptr_array_new_with_free_func ((GDestroyNotify)build_job_free);
+    pool = g_thread_pool_new (build_job_run, &context,
+                              g_get_num_processors (), FALSE, NULL);
+
+    if (is_tar)
+    {
+        if (!read_tar (&context, pool, jobs, error))
+        {
+            /* Let the pushed jobs finish before freeing them. */
+            g_thread_pool_free (pool, FALSE, TRUE);
+            goto out;
+        }
+    }
+    else
+    {
+        if (!list_categories (dump_path, jobs, error))
+        {
+            g_thread_pool_free (pool, FALSE, TRUE);
+            goto out;
+        }
+
+        for (i = 0; i < jobs->len; i++)
+        {
+            g_thread_pool_push (pool, g_ptr_array_index (jobs, i), NULL);
+        }
+    }
+
+    /* Wait for all the jobs. */
+    g_thread_pool_free (pool, FALSE, TRUE);
+
+    if (context.error)
+    {
+        g_propagate_error (error, context.error);
+        context.error = NULL;
+        goto out;
+    }
+
+    for (i = 0; i < jobs->len; i++)
+    {
+        BuildJob *job = g_ptr_array_index (jobs, i);
+
+        n_records += job->records->len;
+        n_reused += job->n_reused;
+    }
+
+    if (context.old != NULL && !is_tar && n_reused == n_records
+        && n_reused == context.old->header->n_files)
+    {
+        /* No file was added, changed or removed. */
+        success = TRUE;
+        goto out;
+    }
+
+    /* The reused records were copied, so the previous index can be closed
+     * before it is replaced. */
+    g_clear_pointer (&context.old_files, g_hash_table_unref);
+    g_clear_pointer (&context.old, et_cddb_local_free);
+
+    success = write_index (dump_path, is_tar, &statbuf, jobs, index_path,
+                           error);
+
+out:
+    g_ptr_array_free (jobs, TRUE);
+
+    if (context.old_files)
+    {
+        g_hash_table_unref (context.old_files);
+    }
+
+    if (context.old)
+    {
+        et_cddb_local_free (context.old);
+    }
+
+    g_clear_error (&context.error);
+    g_mutex_clear (&context.lock);
+
+    return success;
+}
+
+typedef struct
+{
+    gchar *dump_path;
+    gchar *index_path;
+} UpdateData;
+
+static void
+update_data_free (UpdateData *data)
+{
+    g_free (data->dump_path);
+    g_free (data->index_path);
+    g_slice_free (UpdateData, data);
+}
+
+static void
+update_thread (GTask *task,
+               gpointer source_object,
+               gpointer task_data,
+               GCancellable *cancellable)
+{
+    UpdateData *data = task_data;
+    GError *error = NULL;
+
+    if (et_cddb_local_update (data->dump_path, data->index_path, cancellable,
+                              &error))
+    {
+        g_task_return_boolean (task, TRUE);
+    }
+    else
+    {
+        g_task_return_error (task, error);
+    }
+}
+
+/*
+ * et_cddb_local_update_async:
+ * @dump_path: the path of a freedb dump, either a directory or a tarball
+ * @index_path: the path of the index
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @callback: the function to call when the index was updated
+ * @user_data: the data to pass to @callback
+ *
+ * Update the index of a freedb dump in a thread, as with
+ * et_cddb_local_update().
+ */
+void
+et_cddb_local_update_async (const gchar *dump_path,
+                            const gchar *index_path,
+                            GCancellable *cancellable,
+                            GAsyncReadyCallback callback,
+                            gpointer user_data)
+{
+    GTask *task;
+    UpdateData *data;
+
+    g_return_if_fail (dump_path != NULL);
+    g_return_if_fail (index_path != NULL);
+
+    data = g_slice_new (UpdateData);
+    data->dump_path = g_strdup (dump_path);
+    data->index_path = g_strdup (index_path);
+
+    task = g_task_new (NULL, cancellable, callback, user_data);
+    g_task_set_source_tag (task, et_cddb_local_update_async);
+    g_task_set_task_data (task, data, (GDestroyNotify)update_data_free);
+    g_task_set_return_on_cancel (task, FALSE);
+    g_task_run_in_thread (task, update_thread);
+    g_object_unref (task);
+}
+
+gboolean
+et_cddb_local_update_finish (GAsyncResult *result,
+                             GError **error)
+{
+    g_return_val_if_fail (g_task_is_valid (result, NULL), FALSE);
+    g_return_val_if_fail (g_async_result_is_tagged (result,
+                                                    et_cddb_local_update_async),
+                          FALSE);
+
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
@@ -0,0 +1,59 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ET_CDDB_LOCAL_H_
+#define ET_CDDB_LOCAL_H_
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef struct _EtCddbLocal EtCddbLocal;
+
+/*
+ * EtCddbLocalMatch:
+ * @category: the CDDB category of the album
+ * @disc_id: the disc ID of the album
+ * @title: the "Artist / Album" title of the album
+ *
+ * An album found in the index of a local CDDB dump.
+ */
+typedef struct
+{
+    gchar *category;
+    guint32 disc_id;
+    gchar *title;
+} EtCddbLocalMatch;
+
+void et_cddb_local_match_free (EtCddbLocalMatch *match);
+
+EtCddbLocal * et_cddb_local_open (const gchar *index_path, GError **error);
+void et_cddb_local_free (EtCddbLocal *local);
+const gchar * et_cddb_local_get_dump_path (EtCddbLocal *local);
+guint et_cddb_local_get_n_records (EtCddbLocal *local);
+GList * et_cddb_local_lookup (EtCddbLocal *local, guint32 disc_id);
+GList * et_cddb_local_search (EtCddbLocal *local, const gchar *words, const gchar * const *categories);
+GBytes * et_cddb_local_read (EtCddbLocal *local, const gchar *category, guint32 disc_id, GError **error);
+
+gboolean et_cddb_local_update (const gchar *dump_path, const gchar *index_path, GCancellable *cancellable, GError **error);
+void et_cddb_local_update_async (const gchar *dump_path, const gchar *index_path, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data);
+gboolean et_cddb_local_update_finish (GAsyncResult *result, GError **error);
+
+G_END_DECLS
+
+#endif /* !ET_CDDB_LOCAL_H_ */
@@ -0,0 +1,685 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include "directory_cache.h"
+
+#include <string.h>
+
+/* The attributes needed to list the subdirectories of a directory. */
+#define LIST_ATTRIBUTES G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+                        G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+                        G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME "," \
+                        G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN "," \
+                        G_FILE_ATTRIBUTE_ACCESS_CAN_READ "," \
+                        G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE "," \
+                        G_FILE_ATTRIBUTE_UNIX_NLINK
+
+/*
+ * EtDirectoryCache:
+ * @items: the #EtDirectoryCacheItem of each directory, by #GFile
+ *
+ * Listings of the subdirectories of directories, kept until a change in the
+ * directory is reported by its #GFileMonitor.
+ */
+struct _EtDirectoryCache
+{
+    GHashTable *items;
+};
+
+/*
+ * EtDirectoryCacheItem:
+ * @ref_count: the reference count, held by the cache and by pending listings,
+ * which may release it from their thread
+ * @cache: the cache, or %NULL once the item was invalidated
+ * @directory: the listed directory
+ * @monitor: the monitor of @directory, or %NULL
+ * @listing: the #EtDirectoryEntry of each subdirectory, or %NULL while
+ * the directory is being listed
+ */
+typedef struct
+{
+    gint ref_count;
+    EtDirectoryCache *cache;
+    GFile *directory;
+    GFileMonitor *monitor;
+    GPtrArray *listing;
+} EtDirectoryCacheItem;
+
+static void
+directory_entry_free (EtDirectoryEntry *entry)
+{
+    g_free (entry->name);
+    g_free (entry->display_name);
+    g_slice_free (EtDirectoryEntry, entry);
+}
+
+static EtDirectoryCacheItem *
+directory_cache_item_ref (EtDirectoryCacheItem *item)
+{
+    g_atomic_int_inc (&item->ref_count);
+
+    return item;
+}
+
+static void
+directory_cache_item_unref (EtDirectoryCacheItem *item)
+{
+    if (!g_atomic_int_dec_and_test (&item->ref_count))
+    {
+        return;
+    }
+
+    g_clear_pointer (&item->listing, g_ptr_array_unref);
+    g_object_unref (item->directory);
+    g_slice_free (EtDirectoryCacheItem, item);
+}
+
+/*
+ * Called when the item is removed from the cache. A pending listing of the
+ * directory may still hold a reference, but will not be cached.
+ */
+static void
+directory_cache_item_remove (EtDirectoryCacheItem *item)
+{
+    item->cache = NULL;
+
+    if (item->monitor)
+    {
+        g_signal_handlers_disconnect_by_data (item->monitor, item);
+        g_file_monitor_cancel (item->monitor);
+        g_clear_object (&item->monitor);
+    }
+
+    directory_cache_item_unref (item);
+}
+
+static void
+on_directory_changed (GFileMonitor *monitor,
+                      GFile *file,
+                      GFile *other_file,
+                      GFileMonitorEvent event_type,
+                      EtDirectoryCacheItem *item)
+{
+    switch (event_type)
+    {
+        case G_FILE_MONITOR_EVENT_CREATED:
+        case G_FILE_MONITOR_EVENT_DELETED:
+        case G_FILE_MONITOR_EVENT_MOVED:
+        case G_FILE_MONITOR_EVENT_PRE_UNMOUNT:
+        case G_FILE_MONITOR_EVENT_UNMOUNTED:
+            /* Frees the item. */
+            g_hash_table_remove (item->cache->items, item->directory);
+            break;
+        case G_FILE_MONITOR_EVENT_CHANGED:
+        case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+        case G_FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED:
+        default:
+            /* The contents of files do not change the listing. */
+            break;
+    }
+}
+
+/*
+ * Get the item of @directory, adding one which is not yet listed if there
+ * is none. The monitor is created before the directory is read, so that no
+ * change is missed between reading and caching the listing.
+ */
+static EtDirectoryCacheItem *
+directory_cache_get_item (EtDirectoryCache *cache,
+                          GFile *directory)
+{
+    EtDirectoryCacheItem *item;
+
+    item = g_hash_table_lookup (cache->items, directory);
+
+    if (item)
+    {
+        return item;
+    }
+
+    item = g_slice_new0 (EtDirectoryCacheItem);
+    item->ref_count = 1;
+    item->cache = cache;
+    item->directory = g_object_ref (directory);
+
+    /* Without a monitor, such as on some remote file systems, the listing is
+     * not cached. */
+    item->monitor = g_file_monitor_directory (directory,
+                                              G_FILE_MONITOR_NONE, NULL,
+                                              NULL);
+
+    if (item->monitor == NULL)
+    {
+        g_object_unref (item->directory);
+        g_slice_free (EtDirectoryCacheItem, item);
+        return NULL;
+    }
+
+    g_signal_connect (item->monitor, "changed",
+                      G_CALLBACK (on_directory_changed), item);
+    g_hash_table_insert (cache->items, item->directory, item);
+
+    return item;
+}
+
+static gint
+compare_entries (gconstpointer a,
+                 gconstpointer b,
+                 gpointer user_data)
+{
+    GHashTable *keys = user_data;
+
+    return strcmp (g_hash_table_lookup (keys, *(EtDirectoryEntry **)a),
+                   g_hash_table_lookup (keys, *(EtDirectoryEntry **)b));
+}
+
+/*
+ * directory_read:
+ * @directory: the directory to list
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @error: a #GError, or %NULL
+ *
+ * List the subdirectories of @directory, sorted by display name in the same
+ * order as g_utf8_collate().
+ *
+ * Returns: the #EtDirectoryEntry of each subdirectory, or %NULL with @error
+ * set on failure
+ */
+static GPtrArray *
+directory_read (GFile *directory,
+                GCancellable *cancellable,
+                GError **error)
+{
+    GFileEnumerator *enumerator;
+    GFileInfo *info;
+    GPtrArray *listing;
+    GHashTable *keys;
+    GError *local_error = NULL;
+
+    enumerator = g_file_enumerate_children (directory, LIST_ATTRIBUTES,
+                                            G_FILE_QUERY_INFO_NONE,
+                                            cancellable, error);
+
+    if (!enumerator)
+    {
+        return NULL;
+    }
+
+    listing = g_ptr_array_new_with_free_func ((GDestroyNotify)directory_entry_free);
+    keys = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+
+    while ((info = g_file_enumerator_next_file (enumerator, cancellable,
+                                                &local_error)) != NULL)
+    {
+        if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
+        {
+            EtDirectoryEntry *entry;
+
+            entry = g_slice_new (EtDirectoryEntry);
+            entry->name = g_strdup (g_file_info_get_name (info));
+            entry->display_name = g_strdup (g_file_info_get_display_name (info));
+            entry->is_hidden = g_file_info_get_is_hidden (info);
+            entry->can_read = !g_file_info_has_attribute (info,
+                                                          G_FILE_ATTRIBUTE_ACCESS_CAN_READ)
+                              || g_file_info_get_attribute_boolean (info,
+                                                                    G_FILE_ATTRIBUTE_ACCESS_CAN_READ);
+            entry->can_write = !g_file_info_has_attribute (info,
+                                                           G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE)
+                               || g_file_info_get_attribute_boolean (info,
+                                                                     G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE);
+
+            /* On most POSIX file systems, the link count of a directory is
+             * two (its entry in the parent, and its "." entry) plus one for
+             * the ".." entry of each subdirectory. Some, such as Btrfs,
+             * always give a count of one, so a lower count means nothing. */
+            switch (g_file_info_get_attribute_uint32 (info,
+                                                      G_FILE_ATTRIBUTE_UNIX_NLINK))
+            {
+                case 0:
+                case 1:
+                    entry->subdirs = ET_DIRECTORY_SUBDIRS_UNKNOWN;
+                    break;
+                case 2:
+                    entry->subdirs = ET_DIRECTORY_SUBDIRS_NONE;
+                    break;
+                default:
+                    entry->subdirs = ET_DIRECTORY_SUBDIRS_SOME;
+                    break;
+            }
+
+            g_ptr_array_add (listing, entry);
+            g_hash_table_insert (keys, entry,
+                                 g_utf8_collate_key (entry->display_name, -1));
+        }
+
+        g_object_unref (info);
+    }
+
+    g_file_enumerator_close (enumerator, NULL, NULL);
+    g_object_unref (enumerator);
+
+    if (local_error)
+    {
+        g_propagate_error (error, local_error);
+        g_ptr_array_unref (listing);
+        listing = NULL;
+    }
+    else
+    {
+        g_ptr_array_sort_with_data (listing, compare_entries, keys);
+    }
+
+    g_hash_table_destroy (keys);
+
+    return listing;
+}
+
+/*
+ * et_directory_cache_new:
+ *
+ * Create a new cache of directory listings. The cache must be used from the
+ * thread which created it, with its thread-default main context running.
+ *
+ * Returns: a new cache, free with et_directory_cache_free()
+ */
+EtDirectoryCache *
+et_directory_cache_new (void)
+{
+    EtDirectoryCache *cache;
+
+    cache = g_slice_new (EtDirectoryCache);
+    cache->items = g_hash_table_new_full (g_file_hash,
+                                          (GEqualFunc)g_file_equal, NULL,
+                                          (GDestroyNotify)directory_cache_item_remove);
+
+    return cache;
+}
+
+/*
+ * et_directory_cache_free:
+ * @cache: the cache to free
+ *
+ * Free @cache, and stop monitoring the cached directories. Pending listings
+ * still complete, but are not cached.
+ */
+void
+et_directory_cache_free (EtDirectoryCache *cache)
+{
+    g_return_if_fail (cache != NULL);
+
+    g_hash_table_destroy (cache->items);
+    g_slice_free (EtDirectoryCache, cache);
+}
+
+/*
+ * et_directory_cache_clear:
+ * @cache: the cache to clear
+ *
+ * Forget all the cached listings, so that the directories are read again.
+ */
+void
+et_directory_cache_clear (EtDirectoryCache *cache)
+{
+    g_return_if_fail (cache != NULL);
+
+    g_hash_table_remove_all (cache->items);
+}
+
+/*
+ * et_directory_cache_lookup:
+ * @cache: the cache
+ * @directory: the directory to look up
+ *
+ * Get the cached listing of @directory, without reading it.
+ *
+ * Returns: (transfer full): the #EtDirectoryEntry of each subdirectory,
+ * sorted by display name, or %NULL if the listing is not cached
+ */
+GPtrArray *
+et_directory_cache_lookup (EtDirectoryCache *cache,
+                           GFile *directory)
+{
+    EtDirectoryCacheItem *item;
+
+    g_return_val_if_fail (cache != NULL, NULL);
+    g_return_val_if_fail (G_IS_FILE (directory), NULL);
+
+    item = g_hash_table_lookup (cache->items, directory);
+
+    return item && item->listing ? g_ptr_array_ref (item->listing) : NULL;
+}
+
+/*
+ * et_directory_cache_list:
+ * @cache: the cache
+ * @directory: the directory to list
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @error: a #GError, or %NULL
+ *
+ * List the subdirectories of @directory, from the cache if possible. The
+ * listing is cached until a change in @directory is reported.
+ *
+ * Returns: (transfer full): the #EtDirectoryEntry of each subdirectory,
+ * sorted by display name, or %NULL with @error set on failure
+ */
+GPtrArray *
+et_directory_cache_list (EtDirectoryCache *cache,
+                         GFile *directory,
+                         GCancellable *cancellable,
+                         GError **error)
+{
+    EtDirectoryCacheItem *item;
+    GPtrArray *listing;
+
+    g_return_val_if_fail (cache != NULL, NULL);
+    g_return_val_if_fail (G_IS_FILE (directory), NULL);
+    g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+    item = directory_cache_get_item (cache, directory);
+
+    if (item && item->listing)
+    {
+        return g_ptr_array_ref (item->listing);
+    }
+
+    listing = directory_read (directory, cancellable, error);
+
+    /* The item may have been invalidated while reading, but no events are
+     * dispatched here. */
+    if (item && listing)
+    {
+        item->listing = g_ptr_array_ref (listing);
+    }
+
+    return listing;
+}
+
+/*
+ * ListData:
+ * @directory: the directory to list
+ * @item: (allow-none): the cache item in which to store the listing
+ */
+typedef struct
+{
+    GFile *directory;
+    EtDirectoryCacheItem *item;
+} ListData;
+
+static void
+list_data_free (ListData *data)
+{
+    g_object_unref (data->directory);
+
+    if (data->item)
+    {
+        directory_cache_item_unref (data->item);
+    }
+
+    g_slice_free (ListData, data);
+}
+
+static void
+list_thread (GTask *task,
+             gpointer source_object,
+             gpointer task_data,
+             GCancellable *cancellable)
+{
+    ListData *data = task_data;
+    GPtrArray *listing;
+    GError *error = NULL;
+
+    listing = directory_read (data->directory, cancellable, &error);
+
+    if (listing)
+    {
+        g_task_return_pointer (task, listing,
+                               (GDestroyNotify)g_ptr_array_unref);
+    }
+    else
+    {
+        g_task_return_error (task, error);
+    }
+}
+
+/*
+ * et_directory_cache_list_async:
+ * @cache: the cache
+ * @directory: the directory to list
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @callback: called when the directory was listed
+ * @user_data: user data for @callback
+ *
+ * List the subdirectories of @directory, from the cache if possible, or
+ * otherwise in a thread. Call et_directory_cache_list_finish() from
+ * @callback to get the listing, which is then cached.
+ */
+void
+et_directory_cache_list_async (EtDirectoryCache *cache,
+                               GFile *directory,
+                               GCancellable *cancellable,
+                               GAsyncReadyCallback callback,
+                               gpointer user_data)
+{
+    GTask *task;
+    EtDirectoryCacheItem *item;
+    ListData *data;
+
+    g_return_if_fail (cache != NULL);
+    g_return_if_fail (G_IS_FILE (directory));
+
+    task = g_task_new (NULL, cancellable, callback, user_data);
+    g_task_set_source_tag (task, et_directory_cache_list_async);
+
+    item = directory_cache_get_item (cache, directory);
+
+    if (item && item->listing)
+    {
+        g_task_return_pointer (task, g_ptr_array_ref (item->listing),
+                               (GDestroyNotify)g_ptr_array_unref);
+        g_object_unref (task);
+        return;
+    }
+
+    data = g_slice_new (ListData);
+    data->directory = g_object_ref (directory);
+    data->item = item ? directory_cache_item_ref (item) : NULL;
+
+    g_task_set_task_data (task, data, (GDestroyNotify)list_data_free);
+    g_task_run_in_thread (task, list_thread);
+    g_object_unref (task);
+}
+
+/*
+ * et_directory_cache_list_finish:
+ * @result: the result passed to the callback
+ * @error: a #GError, or %NULL
+ *
+ * Finish listing a directory. The listing is cached, unless a change in the
+ * directory was reported while it was read, or the cache was freed.
+ *
+ * Returns: (transfer full): the #EtDirectoryEntry of each subdirectory,
+ * sorted by display name, or %NULL with @error set on failure
+ */
+GPtrArray *
+et_directory_cache_list_finish (GAsyncResult *result,
+                                GError **error)
+{
+    ListData *data;
+    GPtrArray *listing;
+
+    g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
+    g_return_val_if_fail (g_async_result_is_tagged (result,
+                                                    et_directory_cache_list_async),
+                          NULL);
+
+    listing = g_task_propagate_pointer (G_TASK (result), error);
+    data = g_task_get_task_data (G_TASK (result));
+
+    /* There is no task data if the listing came from the cache. */
+    if (listing && data && data->item && data->item->cache
+        && !data->item->listing)
+    {
+        data->item->listing = g_ptr_array_ref (listing);
+    }
+
+    return listing;
+}
+
+/*
+ * Check whether @directory has a subdirectory, stopping at the first one.
+ */
+static gboolean
+directory_has_subdir (GFile *directory,
+                      gboolean show_hidden,
+                      GCancellable *cancellable)
+{
+    GFileEnumerator *enumerator;
+    GFileInfo *info;
+    gboolean found = FALSE;
+
+    enumerator = g_file_enumerate_children (directory,
+                                            G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+                                            G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN,
+                                            G_FILE_QUERY_INFO_NONE,
+                                            cancellable, NULL);
+
+    if (!enumerator)
+    {
+        return FALSE;
+    }
+
+    while (!found && (info = g_file_enumerator_next_file (enumerator,
+                                                          cancellable,
+                                                          NULL)) != NULL)
+    {
+        found = g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY
+                && (show_hidden || !g_file_info_get_is_hidden (info));
+        g_object_unref (info);
+    }
+
+    g_file_enumerator_close (enumerator, NULL, NULL);
+    g_object_unref (enumerator);
+
+    return found;
+}
+
+typedef struct
+{
+    GPtrArray *directories;
+    gboolean show_hidden;
+} ProbeData;
+
+static void
+probe_data_free (ProbeData *data)
+{
+    g_ptr_array_unref (data->directories);
+    g_slice_free (ProbeData, data);
+}
+
+static void
+probe_thread (GTask *task,
+              gpointer source_object,
+              gpointer task_data,
+              GCancellable *cancellable)
+{
+    ProbeData *data = task_data;
+    GArray *results;
+    guint i;
+
+    results = g_array_sized_new (FALSE, FALSE, sizeof (gboolean),
+                                 data->directories->len);
+
+    for (i = 0; i < data->directories->len; i++)
+    {
+        gboolean found;
+
+        if (g_task_return_error_if_cancelled (task))
+        {
+            g_array_unref (results);
+            return;
+        }
+
+        found = directory_has_subdir (g_ptr_array_index (data->directories,
+                                                         i),
+                                      data->show_hidden, cancellable);
+        g_array_append_val (results, found);
+    }
+
+    g_task_return_pointer (task, results, (GDestroyNotify)g_array_unref);
+}
+
+/*
+ * et_directory_probe_async:
+ * @directories: (element-type GFile): the directories to probe
+ * @show_hidden: whether hidden subdirectories count
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @callback: called when all the directories were probed
+ * @user_data: user data for @callback
+ *
+ * Check, in a thread, whether each of @directories has subdirectories, for
+ * those for which the link count did not tell. Call
+ * et_directory_probe_finish() from @callback to get the results.
+ */
+void
+et_directory_probe_async (GPtrArray *directories,
+                          gboolean show_hidden,
+                          GCancellable *cancellable,
+                          GAsyncReadyCallback callback,
+                          gpointer user_data)
+{
+    GTask *task;
+    ProbeData *data;
+
+    g_return_if_fail (directories != NULL);
+
+    data = g_slice_new (ProbeData);
+    data->directories = g_ptr_array_ref (directories);
+    data->show_hidden = show_hidden;
+
+    task = g_task_new (NULL, cancellable, callback, user_data);
+    g_task_set_source_tag (task, et_directory_probe_async);
+    g_task_set_task_data (task, data, (GDestroyNotify)probe_data_free);
+    g_task_run_in_thread (task, probe_thread);
+    g_object_unref (task);
+}
+
+/*
+ * et_directory_probe_finish:
+ * @result: the result passed to the callback
+ * @error: a #GError, or %NULL
+ *
+ * Finish probing directories. Directories which could not be read have no
+ * subdirectories.
+ *
+ * Returns: (element-type gboolean): whether each of the directories has
+ * subdirectories, in the same order, or %NULL with @error set if the probe
+ * was cancelled
+ */
+GArray *
+et_directory_probe_finish (GAsyncResult *result,
+                           GError **error)
+{
+    g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
+    g_return_val_if_fail (g_async_result_is_tagged (result,
+                                                    et_directory_probe_async),
+                          NULL);
+
+    return g_task_propagate_pointer (G_TASK (result), error);
+}
@@ -0,0 +1,79 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ET_DIRECTORY_CACHE_H_
+#define ET_DIRECTORY_CACHE_H_
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/*
+ * EtDirectorySubdirs:
+ * @ET_DIRECTORY_SUBDIRS_UNKNOWN: the directory must be probed to know
+ * whether it has subdirectories
+ * @ET_DIRECTORY_SUBDIRS_NONE: the directory has no subdirectories
+ * @ET_DIRECTORY_SUBDIRS_SOME: the directory has subdirectories, which may
+ * all be hidden
+ *
+ * Whether a directory has subdirectories, as guessed from its link count.
+ */
+typedef enum
+{
+    ET_DIRECTORY_SUBDIRS_UNKNOWN,
+    ET_DIRECTORY_SUBDIRS_NONE,
+    ET_DIRECTORY_SUBDIRS_SOME
+} EtDirectorySubdirs;
+
+/*
+ * EtDirectoryEntry:
+ * @name: the name of the subdirectory, in the GLib filename encoding
+ * @display_name: the name of the subdirectory, in UTF-8
+ * @is_hidden: whether the subdirectory is hidden
+ * @can_read: whether the subdirectory can be read
+ * @can_write: whether the subdirectory can be written to
+ * @subdirs: whether the subdirectory has subdirectories itself
+ *
+ * A subdirectory of a listed directory.
+ */
+typedef struct
+{
+    gchar *name;
+    gchar *display_name;
+    gboolean is_hidden;
+    gboolean can_read;
+    gboolean can_write;
+    EtDirectorySubdirs subdirs;
+} EtDirectoryEntry;
+
+typedef struct _EtDirectoryCache EtDirectoryCache;
+
+EtDirectoryCache * et_directory_cache_new (void);
+void et_directory_cache_free (EtDirectoryCache *cache);
+void et_directory_cache_clear (EtDirectoryCache *cache);
+GPtrArray * et_directory_cache_lookup (EtDirectoryCache *cache, GFile *directory);
+GPtrArray * et_directory_cache_list (EtDirectoryCache *cache, GFile *directory, GCancellable *cancellable, GError **error);
+void et_directory_cache_list_async (EtDirectoryCache *cache, GFile *directory, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data);
+GPtrArray * et_directory_cache_list_finish (GAsyncResult *result, GError **error);
+
+void et_directory_probe_async (GPtrArray *directories, gboolean show_hidden, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data);
+GArray * et_directory_probe_finish (GAsyncResult *result, GError **error);
+
+G_END_DECLS
+
+#endif /* !ET_DIRECTORY_CACHE_H_ */
@@ -0,0 +1,228 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include "directory_watch.h"
+
+/*
+ * EtDirectoryWatch:
+ * @monitors: the #GFileMonitor of each watched directory, by #GFile
+ * @unwatched: the directories which could not be monitored, as a set of
+ * #GFile
+ * @changes: the files and directories reported as changed, as a set of
+ * #GFile
+ * @valid: %FALSE once a watched directory was unmounted
+ *
+ * The directories of a loaded tree of files, and the changes reported in
+ * them since the last call to et_directory_watch_take_changes().
+ */
+struct _EtDirectoryWatch
+{
+    GHashTable *monitors;
+    GHashTable *unwatched;
+    GHashTable *changes;
+    gboolean valid;
+};
+
+static void
+on_directory_changed (GFileMonitor *monitor,
+                      GFile *file,
+                      GFile *other_file,
+                      GFileMonitorEvent event_type,
+                      EtDirectoryWatch *watch)
+{
+    switch (event_type)
+    {
+        case G_FILE_MONITOR_EVENT_PRE_UNMOUNT:
+        case G_FILE_MONITOR_EVENT_UNMOUNTED:
+            watch->valid = FALSE;
+            return;
+        case G_FILE_MONITOR_EVENT_DELETED:
+            /* A watched directory which was removed is reported by its
+             * parent too, and need not be watched any more. */
+            g_hash_table_remove (watch->monitors, file);
+            break;
+        case G_FILE_MONITOR_EVENT_CHANGED:
+        case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+        case G_FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED:
+        case G_FILE_MONITOR_EVENT_CREATED:
+        case G_FILE_MONITOR_EVENT_MOVED:
+        default:
+            break;
+    }
+
+    g_hash_table_add (watch->changes, g_object_ref (file));
+
+    if (other_file)
+    {
+        g_hash_table_add (watch->changes, g_object_ref (other_file));
+    }
+}
+
+static void
+directory_monitor_free (GFileMonitor *monitor)
+{
+    g_signal_handlers_disconnect_matched (monitor, G_SIGNAL_MATCH_FUNC, 0, 0,
+                                          NULL, on_directory_changed, NULL);
+    g_file_monitor_cancel (monitor);
+    g_object_unref (monitor);
+}
+
+/*
+ * et_directory_watch_new:
+ *
+ * Create a new watch, with no directories. The watch must be used from the
+ * thread which created it, with its thread-default main context running.
+ *
+ * Returns: a new watch, free with et_directory_watch_free()
+ */
+EtDirectoryWatch *
+et_directory_watch_new (void)
+{
+    EtDirectoryWatch *watch;
+
+    watch = g_slice_new (EtDirectoryWatch);
+    watch->monitors = g_hash_table_new_full (g_file_hash,
+                                             (GEqualFunc)g_file_equal,
+                                             g_object_unref,
+                                             (GDestroyNotify)directory_monitor_free);
+    watch->unwatched = g_hash_table_new_full (g_file_hash,
+                                              (GEqualFunc)g_file_equal,
+                                              g_object_unref, NULL);
+    watch->changes = g_hash_table_new_full (g_file_hash,
+                                            (GEqualFunc)g_file_equal,
+                                            g_object_unref, NULL);
+    watch->valid = TRUE;
+
+    return watch;
+}
+
+/*
+ * et_directory_watch_free:
+ * @watch: the watch to free
+ *
+ * Stop watching the directories of @watch, and free it.
+ */
+void
+et_directory_watch_free (EtDirectoryWatch *watch)
+{
+    g_return_if_fail (watch != NULL);
+
+    g_hash_table_destroy (watch->monitors);
+    g_hash_table_destroy (watch->unwatched);
+    g_hash_table_destroy (watch->changes);
+    g_slice_free (EtDirectoryWatch, watch);
+}
+
+/*
+ * et_directory_watch_add:
+ * @watch: the watch
+ * @directory: a directory of the loaded tree
+ *
+ * Report changes to the files and subdirectories directly in @directory.
+ * Subdirectories must be added separately. A directory which cannot be
+ * monitored is instead reported as changed every time.
+ */
+void
+et_directory_watch_add (EtDirectoryWatch *watch,
+                        GFile *directory)
+{
+    GFileMonitor *monitor;
+
+    g_return_if_fail (watch != NULL);
+    g_return_if_fail (G_IS_FILE (directory));
+
+    if (g_hash_table_contains (watch->monitors, directory)
+        || g_hash_table_contains (watch->unwatched, directory))
+    {
+        return;
+    }
+
+    /* Such as when the limit of inotify watches is reached. */
+    monitor = g_file_monitor_directory (directory, G_FILE_MONITOR_NONE, NULL,
+                                        NULL);
+
+    if (monitor == NULL)
+    {
+        g_hash_table_add (watch->unwatched, g_object_ref (directory));
+        return;
+    }
+
+    g_signal_connect (monitor, "changed", G_CALLBACK (on_directory_changed),
+                      watch);
+    g_hash_table_insert (watch->monitors, g_object_ref (directory), monitor);
+}
+
+/*
+ * et_directory_watch_is_valid:
+ * @watch: the watch
+ *
+ * Check whether the changes reported by @watch can still be trusted, which is
+ * not the case once the file system of a watched directory was unmounted.
+ *
+ * Returns: %TRUE if @watch is valid, %FALSE otherwise
+ */
+gboolean
+et_directory_watch_is_valid (EtDirectoryWatch *watch)
+{
+    g_return_val_if_fail (watch != NULL, FALSE);
+
+    return watch->valid;
+}
+
+/*
+ * et_directory_watch_take_changes:
+ * @watch: the watch
+ *
+ * Get the files and directories which changed since the last call, and the
+ * directories which could not be monitored, and so may have changed. Changed
+ * directories must be read again, with their subdirectories.
+ *
+ * Returns: (element-type GFile) (transfer full): the changed files and
+ * directories, in no particular order
+ */
+GPtrArray *
+et_directory_watch_take_changes (EtDirectoryWatch *watch)
+{
+    GPtrArray *changes;
+    GHashTableIter iter;
+    gpointer file;
+
+    g_return_val_if_fail (watch != NULL, NULL);
+
+    changes = g_ptr_array_new_full (g_hash_table_size (watch->changes)
+                                    + g_hash_table_size (watch->unwatched),
+                                    g_object_unref);
+    g_hash_table_iter_init (&iter, watch->changes);
+
+    while (g_hash_table_iter_next (&iter, &file, NULL))
+    {
+        g_ptr_array_add (changes, file);
+        g_hash_table_iter_steal (&iter);
+    }
+
+    g_hash_table_iter_init (&iter, watch->unwatched);
+
+    while (g_hash_table_iter_next (&iter, &file, NULL))
+    {
+        g_ptr_array_add (changes, g_object_ref (file));
+    }
+
+    return changes;
+}
@@ -0,0 +1,36 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ET_DIRECTORY_WATCH_H_
+#define ET_DIRECTORY_WATCH_H_
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef struct _EtDirectoryWatch EtDirectoryWatch;
+
+EtDirectoryWatch * et_directory_watch_new (void);
+void et_directory_watch_free (EtDirectoryWatch *watch);
+void et_directory_watch_add (EtDirectoryWatch *watch, GFile *directory);
+gboolean et_directory_watch_is_valid (EtDirectoryWatch *watch);
+GPtrArray * et_directory_watch_take_changes (EtDirectoryWatch *watch);
+
+G_END_DECLS
+
+#endif /* !ET_DIRECTORY_WATCH_H_ */
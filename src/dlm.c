@@ -20,97 +20,614 @@
 
 #include "dlm.h"
 
-static int dlm_cost    (const gchar, const gchar);
-static int dlm_minimum (int a, int b, int c, int d);
+/*
+ * The distance which is computed is the optimal string alignment variant of
+ * the Damerau-Levenshtein distance (insertions, deletions, substitutions and
+ * transpositions of adjacent characters, each with a cost of 1), between
+ * strings of Unicode code points.
+ *
+ * It is computed with the bit-parallel algorithm of Myers, as extended by
+ * Hyyrö for transpositions: the pattern (the query) is split in words of 64
+ * bits, and the text is processed one character at a time, each step
+ * updating one column of the dynamic programming matrix for all the rows of
+ * a word at once.
+ */
+
+#define DLM_WORD_BITS 64
+#define DLM_LATIN1_SIZE 256
+
+typedef guint64 DlmWord;
 
 /*
- * Compute the Damerau-Levenshtein Distance between utf-8 strings ds and dt.
+ * EtDlmMatcher:
+ * @pattern: the casefolded query
+ * @length: the number of characters in @pattern
+ * @n_words: the number of words needed for a bit for each character
+ * @latin1: the match masks for the characters below U+0100, @n_words each
+ * @keys: the characters of @pattern above U+00FF, in an open addressing hash
+ *        table, where 0 marks an empty slot
+ * @masks: the match masks for @keys, @n_words each
+ * @table_mask: the size of @keys, less one
+ * @none: the match mask of a character not in @pattern
+ * @vp: scratch buffer, positive vertical deltas
+ * @vn: scratch buffer, negative vertical deltas
+ * @d0: scratch buffer, diagonal zero deltas of the previous column
+ * @pm_old: scratch buffer, match mask of the previous text character
+ *
+ * A query prepared for bit-parallel matching, with buffers which are reused
+ * for each string which the query is matched against.
  */
-gint
-dlm (const gchar *ds, const gchar *dt)
+typedef struct
 {
-    gsize n;
-    gsize m;
+    gunichar *pattern;
+    gsize length;
+    gsize n_words;
+    DlmWord *latin1;
+    gunichar *keys;
+    DlmWord *masks;
+    gsize table_mask;
+    DlmWord *none;
+    DlmWord *vp;
+    DlmWord *vn;
+    DlmWord *d0;
+    DlmWord *pm_old;
+} EtDlmMatcher;
 
-    /* Casefold for better matching of the strings. */
-    gchar *s = g_utf8_casefold(ds, -1);
-    gchar *t = g_utf8_casefold(dt, -1);
+typedef struct
+{
+    gunichar *chars;
+    glong length;
+} EtDlmCorpusEntry;
 
-    n = strlen(s);
-    m = strlen(t);
+struct _EtDlmCorpus
+{
+    GArray *entries;
+};
 
-    if (n && m)
+static gsize
+dlm_hash (gunichar c, gsize table_mask)
+{
+    return (c * 0x9E3779B1u) & table_mask;
+}
+
+/*
+ * dlm_matcher_get_mask:
+ * @matcher: the matcher
+ * @c: a character of the text
+ *
+ * Returns: the mask of the positions of @c in the pattern, one bit per
+ *          character, in @matcher->n_words words
+ */
+static const DlmWord *
+dlm_matcher_get_mask (const EtDlmMatcher *matcher,
+                      gunichar c)
+{
+    gsize slot;
+
+    if (c < DLM_LATIN1_SIZE)
     {
-        gint *d;
-        gsize i;
-        gsize j;
-        gint metric;
+        return matcher->latin1 + c * matcher->n_words;
+    }
 
-        n++;
-        m++;
+    if (matcher->keys == NULL)
+    {
+        return matcher->none;
+    }
 
-        d = (gint *)g_malloc0 (sizeof (gint) * m * n);
+    for (slot = dlm_hash (c, matcher->table_mask); matcher->keys[slot] != 0;
+         slot = (slot + 1) & matcher->table_mask)
+    {
+        if (matcher->keys[slot] == c)
+        {
+            return matcher->masks + slot * matcher->n_words;
+        }
+    }
+
+    return matcher->none;
+}
+
+static void
+dlm_matcher_init (EtDlmMatcher *matcher,
+                  gunichar *pattern,
+                  gsize length)
+{
+    gsize n_other = 0;
+    gsize i;
+
+    matcher->pattern = pattern;
+    matcher->length = length;
+    matcher->n_words = MAX (1, (length + DLM_WORD_BITS - 1) / DLM_WORD_BITS);
+
+    /* The masks and the scratch buffers share one allocation. */
+    matcher->latin1 = g_new0 (DlmWord,
+                              (DLM_LATIN1_SIZE + 5) * matcher->n_words);
+    matcher->none = matcher->latin1 + DLM_LATIN1_SIZE * matcher->n_words;
+    matcher->vp = matcher->none + matcher->n_words;
+    matcher->vn = matcher->vp + matcher->n_words;
+    matcher->d0 = matcher->vn + matcher->n_words;
+    matcher->pm_old = matcher->d0 + matcher->n_words;
+    matcher->keys = NULL;
+    matcher->masks = NULL;
+    matcher->table_mask = 0;
 
-        for (i = 0; i < m; i++)
-            d[i * n] = i;
+    for (i = 0; i < length; i++)
+    {
+        if (pattern[i] >= DLM_LATIN1_SIZE)
+        {
+            n_other++;
+        }
+    }
+
+    if (n_other > 0)
+    {
+        gsize table_size = 4;
 
-        for (i = 1; i < n; i++)
+        /* Keep the table at most half full. */
+        while (table_size < n_other * 2)
         {
-            d[i] = i;
-            for (j = 1; j < m; j++)
+            table_size *= 2;
+        }
+
+        matcher->table_mask = table_size - 1;
+        matcher->keys = g_new0 (gunichar, table_size);
+        matcher->masks = g_new0 (DlmWord, table_size * matcher->n_words);
+    }
+
+    for (i = 0; i < length; i++)
+    {
+        const gunichar c = pattern[i];
+        const DlmWord bit = (DlmWord)1 << (i % DLM_WORD_BITS);
+        const gsize word = i / DLM_WORD_BITS;
+
+        if (c < DLM_LATIN1_SIZE)
+        {
+            matcher->latin1[c * matcher->n_words + word] |= bit;
+        }
+        else
+        {
+            gsize slot;
+
+            for (slot = dlm_hash (c, matcher->table_mask);
+                 matcher->keys[slot] != 0 && matcher->keys[slot] != c;
+                 slot = (slot + 1) & matcher->table_mask)
             {
-                d[j * n + i] = dlm_minimum(
-                    d[(j - 1) * n + i] + 1,
-                    d[j * n + i - 1] + 1,
-                    d[(j - 1) * n + i - 1] + dlm_cost(s[i - 1], t[j - 1]),
-                    (j>1 && i>1 ?
-                         d[(j - 2) * n + i - 2] + dlm_cost(s[i - 1], t[j])
-                        + dlm_cost(s[i], t[j - 1])
-                    : 0x7fff)
-                );
             }
+
+            matcher->keys[slot] = c;
+            matcher->masks[slot * matcher->n_words + word] |= bit;
         }
-        metric = d[n * m - 1];
-        g_free(d);
+    }
+}
+
+static void
+dlm_matcher_clear (EtDlmMatcher *matcher)
+{
+    g_free (matcher->latin1);
+    g_free (matcher->keys);
+    g_free (matcher->masks);
+}
+
+/*
+ * dlm_matcher_distance:
+ * @matcher: the matcher, holding the pattern
+ * @text: the characters to match the pattern against
+ * @text_length: the number of characters in @text
+ * @max_distance: the maximum distance of interest, or -1 for no limit
+ *
+ * Compute the distance between the pattern of @matcher and @text. The
+ * computation stops as soon as the distance is known to be greater than
+ * @max_distance.
+ *
+ * Returns: the distance, or -1 if it is greater than @max_distance
+ */
+static gint
+dlm_matcher_distance (EtDlmMatcher *matcher,
+                      const gunichar *text,
+                      gsize text_length,
+                      gint max_distance)
+{
+    const gsize n_words = matcher->n_words;
+    const gsize last_bit = (matcher->length - 1) % DLM_WORD_BITS;
+    gsize score;
+    gsize max;
+    gsize i;
+    gsize w;
+
+    max = max_distance < 0 ? G_MAXSIZE : (gsize)max_distance;
+
+    if (matcher->length == 0 || text_length == 0)
+    {
+        score = MAX (matcher->length, text_length);
+        return score <= max ? (gint)score : -1;
+    }
+
+    /* The distance is at least the difference between the lengths. */
+    if ((matcher->length > text_length ? matcher->length - text_length
+                                       : text_length - matcher->length) > max)
+    {
+        return -1;
+    }
+
+    for (w = 0; w < n_words; w++)
+    {
+        matcher->vp[w] = ~(DlmWord)0;
+        matcher->vn[w] = 0;
+        matcher->d0[w] = 0;
+        matcher->pm_old[w] = 0;
+    }
+
+    score = matcher->length;
+
+    for (i = 0; i < text_length; i++)
+    {
+        const DlmWord *pm = dlm_matcher_get_mask (matcher, text[i]);
+        /* The first row of the matrix increases by one in each column. */
+        DlmWord hp_carry = 1;
+        DlmWord hn_carry = 0;
+        /* The values for the previous word, to carry the transposition bit
+         * over the word boundary. */
+        DlmWord d0_below = 0;
+        DlmWord pm_below = 0;
+
+        for (w = 0; w < n_words; w++)
+        {
+            const DlmWord pm_j = pm[w];
+            const DlmWord vp = matcher->vp[w];
+            const DlmWord vn = matcher->vn[w];
+            const DlmWord d0_old = matcher->d0[w];
+            DlmWord x;
+            DlmWord tr;
+            DlmWord d0;
+            DlmWord hp;
+            DlmWord hn;
+            DlmWord hp_out;
+            DlmWord hn_out;
+
+            x = pm_j | hn_carry;
+            tr = ((((~d0_old) & pm_j) << 1)
+                  | (((~d0_below) & pm_below) >> (DLM_WORD_BITS - 1)))
+                 & matcher->pm_old[w];
+            d0 = (((x & vp) + vp) ^ vp) | x | vn | tr;
+            hp = vn | ~(d0 | vp);
+            hn = d0 & vp;
+
+            if (w == n_words - 1)
+            {
+                if (hp & ((DlmWord)1 << last_bit))
+                {
+                    score++;
+                }
+                else if (hn & ((DlmWord)1 << last_bit))
+                {
+                    score--;
+                }
+            }
+
+            hp_out = hp >> (DLM_WORD_BITS - 1);
+            hn_out = hn >> (DLM_WORD_BITS - 1);
+            hp = (hp << 1) | hp_carry;
+            hn = (hn << 1) | hn_carry;
+            hp_carry = hp_out;
+            hn_carry = hn_out;
+
+            matcher->vp[w] = hn | ~(d0 | hp);
+            matcher->vn[w] = hp & d0;
+
+            d0_below = d0_old;
+            pm_below = pm_j;
+            matcher->d0[w] = d0;
+            matcher->pm_old[w] = pm_j;
+        }
+
+        /* Each remaining column can lower the distance by one at most. */
+        if (score > max && score - max > text_length - i - 1)
+        {
+            return -1;
+        }
+    }
+
+    return score <= max ? (gint)score : -1;
+}
+
+/*
+ * dlm_casefold:
+ * @string: a UTF-8 string
+ * @length: (out): return location for the number of characters
+ *
+ * Returns: the casefolded characters of @string, free with g_free()
+ */
+static gunichar *
+dlm_casefold (const gchar *string,
+              glong *length)
+{
+    gchar *folded;
+    gunichar *chars;
+
+    folded = g_utf8_casefold (string, -1);
+    chars = g_utf8_to_ucs4_fast (folded, -1, length);
+    g_free (folded);
+
+    return chars;
+}
+
+/*
+ * dlm_metric:
+ *
+ * Turn a distance into a "similarity value", between 0 and 1000.
+ */
+static gint
+dlm_metric (gsize distance,
+            gsize total_length)
+{
+    return 1000 - (gint)((1000 * (distance * 2)) / total_length);
+}
+
+/*
+ * et_dlm_distance:
+ * @s: a UTF-8 string
+ * @t: a UTF-8 string
+ * @max_distance: the maximum distance of interest, or -1 for no limit
+ *
+ * Compute the Damerau-Levenshtein distance between the casefolded @s and
+ * @t, counted in characters.
+ *
+ * Returns: the distance, or -1 if it is greater than @max_distance
+ */
+gint
+et_dlm_distance (const gchar *s,
+                 const gchar *t,
+                 gint max_distance)
+{
+    EtDlmMatcher matcher;
+    gunichar *s_chars;
+    gunichar *t_chars;
+    glong n;
+    glong m;
+    gint distance;
+
+    g_return_val_if_fail (s != NULL && t != NULL, -1);
+
+    s_chars = dlm_casefold (s, &n);
+    t_chars = dlm_casefold (t, &m);
+
+    dlm_matcher_init (&matcher, s_chars, n);
+    distance = dlm_matcher_distance (&matcher, t_chars, m, max_distance);
+    dlm_matcher_clear (&matcher);
 
-        /* Count a "similarity value" */
-        /* Subtract the extra byte added to each string length earlier. */
-        metric = 1000 - (1000 * (metric * 2)) / (m + n - 2);
+    g_free (t_chars);
+    g_free (s_chars);
 
-        g_free(t);
-        g_free(s);
-        return metric;
+    return distance;
+}
+
+/*
+ * Compute the Damerau-Levenshtein Metric between utf-8 strings ds and dt.
+ *
+ * Returns: a similarity value between 0 (nothing in common) and 1000 (equal
+ *          strings), or -1 if either string is empty
+ */
+gint
+dlm (const gchar *ds, const gchar *dt)
+{
+    EtDlmMatcher matcher;
+    gunichar *s;
+    gunichar *t;
+    glong n;
+    glong m;
+    gint metric = -1;
+
+    /* Casefold for better matching of the strings. */
+    s = dlm_casefold (ds, &n);
+    t = dlm_casefold (dt, &m);
+
+    if (n && m)
+    {
+        dlm_matcher_init (&matcher, s, n);
+        metric = dlm_metric (dlm_matcher_distance (&matcher, t, m, -1),
+                             n + m);
+        dlm_matcher_clear (&matcher);
     }
-    g_free(t);
-    g_free(s);
+
+    g_free (t);
+    g_free (s);
 
     /* Return value of -1 indicates an error */
-    return -1;
+    return metric;
 }
 
-/* "Cost" of changing from a to b. */
-static int
-dlm_cost (const char a, const char b)
+/*
+ * et_dlm_corpus_new:
+ *
+ * Create a corpus of strings, which are casefolded once, to be searched for
+ * the string most similar to a query with et_dlm_corpus_find_best().
+ *
+ * Returns: a new corpus, free with et_dlm_corpus_free()
+ */
+EtDlmCorpus *
+et_dlm_corpus_new (void)
 {
-    return a == b ? 0 : 1;
+    EtDlmCorpus *corpus;
+
+    corpus = g_slice_new (EtDlmCorpus);
+    corpus->entries = g_array_new (FALSE, TRUE, sizeof (EtDlmCorpusEntry));
+
+    return corpus;
 }
 
-/* Return the smallest of four integers. */
-static int
-dlm_minimum (int a, int b, int c, int d)
+void
+et_dlm_corpus_free (EtDlmCorpus *corpus)
 {
-    int min = a;
-    if (b < min)
+    g_return_if_fail (corpus != NULL);
+
+    et_dlm_corpus_set_size (corpus, 0);
+    g_array_unref (corpus->entries);
+    g_slice_free (EtDlmCorpus, corpus);
+}
+
+guint
+et_dlm_corpus_get_size (const EtDlmCorpus *corpus)
+{
+    g_return_val_if_fail (corpus != NULL, 0);
+
+    return corpus->entries->len;
+}
+
+/*
+ * et_dlm_corpus_set_size:
+ * @corpus: the corpus
+ * @size: the new number of strings
+ *
+ * Remove the strings after @size, or add empty strings up to @size.
+ */
+void
+et_dlm_corpus_set_size (EtDlmCorpus *corpus,
+                        guint size)
+{
+    guint i;
+
+    g_return_if_fail (corpus != NULL);
+
+    for (i = size; i < corpus->entries->len; i++)
     {
-        min = b;
+        g_free (g_array_index (corpus->entries, EtDlmCorpusEntry, i).chars);
     }
-    if (c < min)
+
+    g_array_set_size (corpus->entries, size);
+}
+
+/*
+ * et_dlm_corpus_set:
+ * @corpus: the corpus
+ * @index_: the index of the string to set, extending the corpus if needed
+ * @string: (nullable): the UTF-8 string to store, or %NULL to never match
+ *          at @index_
+ */
+void
+et_dlm_corpus_set (EtDlmCorpus *corpus,
+                   guint index_,
+                   const gchar *string)
+{
+    EtDlmCorpusEntry *entry;
+
+    g_return_if_fail (corpus != NULL);
+
+    if (index_ >= corpus->entries->len)
+    {
+        et_dlm_corpus_set_size (corpus, index_ + 1);
+    }
+
+    entry = &g_array_index (corpus->entries, EtDlmCorpusEntry, index_);
+    g_free (entry->chars);
+
+    if (string)
     {
-        min = c;
+        entry->chars = dlm_casefold (string, &entry->length);
+    }
+    else
+    {
+        entry->chars = NULL;
+        entry->length = 0;
+    }
+}
+
+/*
+ * et_dlm_corpus_find_best:
+ * @corpus: the corpus
+ * @query: the UTF-8 string to match
+ * @metric: (out) (optional): return location for the metric of the best
+ *          match, as returned by dlm()
+ *
+ * Find the string of @corpus which is most similar to @query, according to
+ * dlm(). The query is prepared once, and the matching of each string stops
+ * as soon as it cannot be better than the best match so far. Strings with no
+ * similarity to @query are never returned, and the first one of equally
+ * similar strings is returned.
+ *
+ * Returns: the index of the best match, or -1 if there was no match
+ */
+gint
+et_dlm_corpus_find_best (const EtDlmCorpus *corpus,
+                         const gchar *query,
+                         gint *metric)
+{
+    EtDlmMatcher matcher;
+    gunichar *chars;
+    glong length;
+    gint best = -1;
+    gint best_metric = 0;
+    guint i;
+
+    g_return_val_if_fail (corpus != NULL, -1);
+    g_return_val_if_fail (query != NULL, -1);
+
+    chars = dlm_casefold (query, &length);
+
+    if (length > 0)
+    {
+        dlm_matcher_init (&matcher, chars, length);
+
+        for (i = 0; i < corpus->entries->len; i++)
+        {
+            const EtDlmCorpusEntry *entry;
+            gsize total;
+            gint max_distance;
+            gint distance;
+            gint this;
+
+            entry = &g_array_index (corpus->entries, EtDlmCorpusEntry, i);
+
+            if (entry->length == 0)
+            {
+                continue;
+            }
+
+            total = length + entry->length;
+
+            /* Find the largest distance which gives a better metric. */
+            max_distance = ((1000 - best_metric) * total) / 2000 + 1;
+
+            while (max_distance >= 0
+                   && dlm_metric (max_distance, total) <= best_metric)
+            {
+                max_distance--;
+            }
+
+            if (max_distance < 0)
+            {
+                continue;
+            }
+
+            distance = dlm_matcher_distance (&matcher, entry->chars,
+                                             entry->length, max_distance);
+
+            if (distance < 0)
+            {
+                continue;
+            }
+
+            this = dlm_metric (distance, total);
+
+            if (this > best_metric)
+            {
+                best_metric = this;
+                best = i;
+
+                if (best_metric == 1000)
+                {
+                    break;
+                }
+            }
+        }
+
+        dlm_matcher_clear (&matcher);
     }
-    if (d < min)
+
+    g_free (chars);
+
+    if (metric)
     {
-        min = d;
+        *metric = best_metric;
     }
-    return min;
+
+    return best;
 }
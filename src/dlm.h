@@ -23,7 +23,17 @@
 
 G_BEGIN_DECLS
 
+typedef struct _EtDlmCorpus EtDlmCorpus;
+
 gint dlm (const gchar *s, const gchar *t);
+gint et_dlm_distance (const gchar *s, const gchar *t, gint max_distance);
+
+EtDlmCorpus * et_dlm_corpus_new (void);
+void et_dlm_corpus_free (EtDlmCorpus *corpus);
+guint et_dlm_corpus_get_size (const EtDlmCorpus *corpus);
+void et_dlm_corpus_set_size (EtDlmCorpus *corpus, guint size);
+void et_dlm_corpus_set (EtDlmCorpus *corpus, guint index_, const gchar *string);
+gint et_dlm_corpus_find_best (const EtDlmCorpus *corpus, const gchar *query, gint *metric);
 
 G_END_DECLS
 
@@ -32,6 +32,7 @@
 #include "id3_tag.h"
 #include "log.h"
 #include "misc.h"
+#include "rename_plan.h"
 #include "cddb_dialog.h"
 #include "setting.h"
 #include "scan_dialog.h"
@@ -42,6 +43,13 @@
 
 static GtkWidget *QuitRecursionWindow = NULL;
 
+/* The directories of the files loaded by Read_Directory(), and how they were
+ * searched, to read again only the files which changed when reloading. */
+static EtDirectoryWatch *DirectoryWatch = NULL;
+static GFile *DirectoryWatchRoot = NULL;
+static gboolean DirectoryWatchRecurse;
+static gboolean DirectoryWatchShowHidden;
+
 /* Referenced in the header. */
 gboolean Main_Stop_Button_Pressed;
 GtkWidget *MainWindow;
@@ -58,14 +66,18 @@ static gint SF_ButtonPressed_Rename_File;
 
 static gboolean Write_File_Tag (ET_File *ETFile, gboolean hide_msgbox);
 static gint Save_File (ET_File *ETFile, gboolean multiple_files,
-                       gboolean force_saving_files);
+                       gboolean force_saving_files,
+                       EtRenamePlan *rename_plan);
+static gboolean rename_planned_files (EtRenamePlan *rename_plan);
 static gint Save_Selected_Files_With_Answer (gboolean force_saving_files);
 static gint Save_List_Of_Files (GList *etfilelist,
                                 gboolean force_saving_files);
 
 static GList *read_directory_recursively (GList *file_list,
                                           GFileEnumerator *dir_enumerator,
-                                          gboolean recurse);
+                                          gboolean recurse,
+                                          EtDirectoryWatch *watch);
+static void clear_directory_watch (void);
 static void Open_Quit_Recursion_Function_Window (void);
 static void Destroy_Quit_Recursion_Function_Window (void);
 static void et_on_quit_recursion_response (GtkDialog *dialog, gint response_id,
@@ -136,7 +148,8 @@ Save_List_Of_Files (GList *etfilelist, gboolean force_saving_files)
     GAction *action;
     GVariant *variant;
     GtkWidget *widget_focused;
-    GtkTreePath *currentPath = NULL;
+    EtRenamePlan *rename_plan;
+    gboolean renamed;
 
     g_return_val_if_fail (ETCore != NULL, FALSE);
 
@@ -163,9 +176,7 @@ Save_List_Of_Files (GList *etfilelist, gboolean force_saving_files)
         const ET_File *ETFile = (ET_File *)l->data;
         const File_Tag *file_tag  = (File_Tag *)ETFile->FileTag->data;
         const File_Name *FileName = (File_Name *)ETFile->FileNameNew->data;
-        const gchar *filename_cur = ((File_Name *)ETFile->FileNameCur->data)->value;
-        const gchar *filename_cur_utf8 = ((File_Name *)ETFile->FileNameCur->data)->value_utf8;
-        gchar *basename_cur_utf8 = g_path_get_basename(filename_cur_utf8);
+        gchar *filename_cur;
 
         // Count only the changed files or all files if force_saving_files==TRUE
         if (force_saving_files
@@ -173,7 +184,9 @@ Save_List_Of_Files (GList *etfilelist, gboolean force_saving_files)
             || (file_tag && file_tag->saved == FALSE))
             nb_files_to_save++;
 
+        filename_cur = et_file_name_get_path ((File_Name *)ETFile->FileNameCur->data);
         file = g_file_new_for_path (filename_cur);
+        g_free (filename_cur);
         fileinfo = g_file_query_info (file, G_FILE_ATTRIBUTE_TIME_MODIFIED,
                                       G_FILE_QUERY_INFO_NONE, NULL, NULL);
         g_object_unref (file);
@@ -189,7 +202,6 @@ Save_List_Of_Files (GList *etfilelist, gboolean force_saving_files)
 
             g_object_unref (fileinfo);
         }
-        g_free(basename_cur_utf8);
     }
 
     /* Initialize status bar */
@@ -213,6 +225,9 @@ Save_List_Of_Files (GList *etfilelist, gboolean force_saving_files)
     action = g_action_map_lookup_action (G_ACTION_MAP (MainWindow), "stop");
     g_simple_action_set_enabled (G_SIMPLE_ACTION (action), FALSE);
 
+    /* The files are renamed together, once their tags are written. */
+    rename_plan = et_rename_plan_new ();
+
     /*
      * Check if file was changed by an external program
      */
@@ -267,13 +282,10 @@ Save_List_Of_Files (GList *etfilelist, gboolean force_saving_files)
         if ( force_saving_files
         || FileTag->saved == FALSE || FileNameNew->saved == FALSE )
         {
-            /* ET_Display_File_Data_To_UI ((ET_File *)l->data);
-             * Use of 'currentPath' to try to increase speed. Indeed, in many
-             * cases, the next file to select, is the next in the list. */
-            currentPath = et_application_window_browser_select_file_by_et_file2 (window,
-                                                                                (ET_File *)l->data,
-                                                                                FALSE,
-                                                                                currentPath);
+            /* ET_Display_File_Data_To_UI ((ET_File *)l->data); */
+            et_application_window_browser_select_file_by_et_file (window,
+                                                                  (ET_File *)l->data,
+                                                                  FALSE);
 
             fraction = (++progress_bar_index) / (double) nb_files_to_save;
             et_application_window_progress_set_fraction (window, fraction);
@@ -288,33 +300,28 @@ Save_List_Of_Files (GList *etfilelist, gboolean force_saving_files)
             // Save tag and rename file
             saving_answer = Save_File ((ET_File *)l->data,
                                        nb_files_to_save > 1 ? TRUE : FALSE,
-                                       force_saving_files);
+                                       force_saving_files, rename_plan);
 
             if (saving_answer == -1)
             {
-                /* Stop saving files + reinit progress bar */
-                et_application_window_progress_set_text (window, "");
-                et_application_window_progress_set_fraction (window, 0.0);
-                et_application_window_status_bar_message (window,
-                                                          _("Saving files was stopped"),
-                                                          TRUE);
-                /* To update state of command buttons */
-                et_application_window_update_actions (window);
-                et_application_window_browser_set_sensitive (window, TRUE);
-                et_application_window_tag_area_set_sensitive (window, TRUE);
-                et_application_window_file_area_set_sensitive (window, TRUE);
+                /* Rename the files which were accepted before stopping. */
+                rename_planned_files (rename_plan);
+                et_rename_plan_free (rename_plan);
 
-                if (currentPath)
-                {
-                    gtk_tree_path_free (currentPath);
-                }
-                return -1; /* We stop all actions */
+                goto stopped;
             }
         }
     }
 
-    if (currentPath)
-        gtk_tree_path_free(currentPath);
+    renamed = rename_planned_files (rename_plan);
+    et_rename_plan_free (rename_plan);
+
+    /* If 'SF_HideMsgbox_Rename_File' is TRUE, the error was only logged, and
+     * saving is not stopped. */
+    if (!renamed && !SF_HideMsgbox_Rename_File)
+    {
+        goto stopped;
+    }
 
     if (Main_Stop_Button_Pressed)
         msg = g_strdup (_("Saving files was stopped"));
@@ -359,6 +366,21 @@ Save_List_Of_Files (GList *etfilelist, gboolean force_saving_files)
     g_free(msg);
     et_application_window_browser_refresh_list (window);
     return TRUE;
+
+stopped:
+    /* Stop saving files + reinit progress bar */
+    et_application_window_progress_set_text (window, "");
+    et_application_window_progress_set_fraction (window, 0.0);
+    et_application_window_status_bar_message (window,
+                                              _("Saving files was stopped"),
+                                              TRUE);
+    /* To update state of command buttons */
+    et_application_window_update_actions (window);
+    et_application_window_browser_set_sensitive (window, TRUE);
+    et_application_window_tag_area_set_sensitive (window, TRUE);
+    et_application_window_file_area_set_sensitive (window, TRUE);
+
+    return -1; /* We stop all actions */
 }
 
 
@@ -371,20 +393,21 @@ Save_List_Of_Files (GList *etfilelist, gboolean force_saving_files)
  */
 static gint
 Save_File (ET_File *ETFile, gboolean multiple_files,
-           gboolean force_saving_files)
+           gboolean force_saving_files, EtRenamePlan *rename_plan)
 {
     const File_Tag *FileTag;
     const File_Name *FileNameNew;
     gint stop_loop = 0;
-    const gchar *filename_cur_utf8 = ((File_Name *)ETFile->FileNameCur->data)->value_utf8;
-    const gchar *filename_new_utf8 = ((File_Name *)ETFile->FileNameNew->data)->value_utf8;
+    gchar *filename_cur_utf8, *filename_new_utf8;
     gchar *basename_cur_utf8, *basename_new_utf8;
     gchar *dirname_cur_utf8, *dirname_new_utf8;
 
     g_return_val_if_fail (ETFile != NULL, 0);
 
-    basename_cur_utf8 = g_path_get_basename(filename_cur_utf8);
-    basename_new_utf8 = g_path_get_basename(filename_new_utf8);
+    filename_cur_utf8 = et_file_name_get_path_utf8 ((File_Name *)ETFile->FileNameCur->data);
+    filename_new_utf8 = et_file_name_get_path_utf8 ((File_Name *)ETFile->FileNameNew->data);
+    basename_cur_utf8 = g_strdup (((File_Name *)ETFile->FileNameCur->data)->name_utf8);
+    basename_new_utf8 = g_strdup (((File_Name *)ETFile->FileNameNew->data)->name_utf8);
 
     /* Save the current displayed data */
     //ET_Save_File_Data_From_UI((ET_File *)ETFileList->data); // Not needed, because it was done before
@@ -502,6 +525,8 @@ Save_File (ET_File *ETFile, gboolean multiple_files,
 
                     g_free (basename_cur_utf8);
                     g_free (basename_new_utf8);
+                    g_free (filename_cur_utf8);
+                    g_free (filename_new_utf8);
 
                     return stop_loop;
                 }
@@ -515,6 +540,8 @@ Save_File (ET_File *ETFile, gboolean multiple_files,
 
                 g_free (basename_cur_utf8);
                 g_free (basename_new_utf8);
+                g_free (filename_cur_utf8);
+                g_free (filename_new_utf8);
 
                 return stop_loop;
                 break;
@@ -543,8 +570,8 @@ Save_File (ET_File *ETFile, gboolean multiple_files,
             gchar *msg1 = NULL;
             // ET_Display_File_Data_To_UI(ETFile);
 
-            dirname_cur_utf8 = g_path_get_dirname(filename_cur_utf8);
-            dirname_new_utf8 = g_path_get_dirname(filename_new_utf8);
+            dirname_cur_utf8 = et_file_name_get_dirname_utf8 ((File_Name *)ETFile->FileNameCur->data);
+            dirname_new_utf8 = et_file_name_get_dirname_utf8 ((File_Name *)ETFile->FileNameNew->data);
 
             // Directories were renamed? or only filename?
             if (g_utf8_collate(dirname_cur_utf8,dirname_new_utf8) != 0)
@@ -574,8 +601,8 @@ Save_File (ET_File *ETFile, gboolean multiple_files,
                                        basename_cur_utf8, basename_new_utf8);
             }
 
-            g_free(dirname_cur_utf8);
-            g_free(dirname_new_utf8);
+            g_free (dirname_new_utf8);
+            g_free (dirname_cur_utf8);
 
             msgdialog = gtk_message_dialog_new(GTK_WINDOW(MainWindow),
                                                GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
@@ -625,59 +652,14 @@ Save_File (ET_File *ETFile, gboolean multiple_files,
         {
             case GTK_RESPONSE_YES:
             {
-                gboolean rc;
-                GError *error = NULL;
-                const gchar *cur_filename = ((File_Name *)ETFile->FileNameCur->data)->value;
-                const gchar *new_filename = ((File_Name *)ETFile->FileNameNew->data)->value;
-                rc = et_rename_file (cur_filename, new_filename, &error);
-
-                // if 'SF_HideMsgbox_Rename_File is TRUE', then errors are displayed only in log
-                if (!rc)
-                {
-                    if (!SF_HideMsgbox_Rename_File)
-                    {
-                        msgdialog = gtk_message_dialog_new (GTK_WINDOW (MainWindow),
-                                                            GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
-                                                            GTK_MESSAGE_ERROR,
-                                                            GTK_BUTTONS_CLOSE,
-                                                            _("Cannot rename file ‘%s’ to ‘%s’"),
-                                                            filename_cur_utf8,
-                                                            filename_new_utf8);
-                        gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (msgdialog),
-                                                                  "%s",
-                                                                  error->message);
-                        gtk_window_set_title (GTK_WINDOW (msgdialog),
-                                              _("Rename File Error"));
-
-                        gtk_dialog_run (GTK_DIALOG (msgdialog));
-                        gtk_widget_destroy (msgdialog);
-                    }
-
-                    Log_Print (LOG_ERROR,
-                               _("Cannot rename file ‘%s’ to ‘%s’: %s"),
-                               filename_cur_utf8, filename_new_utf8,
-                               error->message);
-
-                    et_application_window_status_bar_message (ET_APPLICATION_WINDOW (MainWindow),
-                                                              _("File(s) not renamed"),
-                                                              TRUE);
-                    g_error_free (error);
-                }
-
-                // if an error occurs when 'SF_HideMsgbox_Rename_File is TRUE', we don't stop saving...
-                if (!rc && !SF_HideMsgbox_Rename_File)
-                {
-                    stop_loop = -1;
-
-                    g_free (basename_cur_utf8);
-                    g_free (basename_new_utf8);
-
-                    return stop_loop;
-                }
-
-                /* Mark after renaming files. */
-                ETFile->FileNameCur = ETFile->FileNameNew;
-                ET_Mark_File_Name_As_Saved (ETFile);
+                gchar *cur_filename = et_file_name_get_path ((File_Name *)ETFile->FileNameCur->data);
+                gchar *new_filename = et_file_name_get_path ((File_Name *)ETFile->FileNameNew->data);
+
+                /* Renamed with the other files, by rename_planned_files(). */
+                et_rename_plan_add (rename_plan, cur_filename, new_filename,
+                                    ETFile);
+                g_free (cur_filename);
+                g_free (new_filename);
                 break;
             }
             case GTK_RESPONSE_NO:
@@ -688,6 +670,8 @@ Save_File (ET_File *ETFile, gboolean multiple_files,
 
                 g_free (basename_cur_utf8);
                 g_free (basename_new_utf8);
+                g_free (filename_cur_utf8);
+                g_free (filename_new_utf8);
 
                 return stop_loop;
                 break;
@@ -699,6 +683,8 @@ Save_File (ET_File *ETFile, gboolean multiple_files,
 
     g_free(basename_cur_utf8);
     g_free(basename_new_utf8);
+    g_free (filename_cur_utf8);
+    g_free (filename_new_utf8);
 
     /* Refresh file into browser list */
     // Browser_List_Refresh_File_In_List(ETFile);
@@ -706,6 +692,68 @@ Save_File (ET_File *ETFile, gboolean multiple_files,
     return 1;
 }
 
+static void
+mark_file_name_renamed (gpointer data, gpointer user_data)
+{
+    ET_File *ETFile = data;
+
+    /* Mark after renaming files. */
+    ETFile->FileNameCur = ETFile->FileNameNew;
+    ET_Mark_File_Name_As_Saved (ETFile);
+}
+
+/*
+ * Rename the files accepted by Save_File(), all at once, so that files may
+ * swap names. If a file cannot be renamed, none of them are.
+ * Return TRUE => OK
+ *        FALSE => error
+ */
+static gboolean
+rename_planned_files (EtRenamePlan *rename_plan)
+{
+    GError *error = NULL;
+
+    if (et_rename_plan_get_length (rename_plan) == 0)
+    {
+        return TRUE;
+    }
+
+    if (!et_rename_plan_execute (rename_plan, &error))
+    {
+        // if 'SF_HideMsgbox_Rename_File is TRUE', then errors are displayed only in log
+        if (!SF_HideMsgbox_Rename_File)
+        {
+            GtkWidget *msgdialog;
+
+            msgdialog = gtk_message_dialog_new (GTK_WINDOW (MainWindow),
+                                                GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+                                                GTK_MESSAGE_ERROR,
+                                                GTK_BUTTONS_CLOSE,
+                                                "%s",
+                                                _("File(s) not renamed"));
+            gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (msgdialog),
+                                                      "%s", error->message);
+            gtk_window_set_title (GTK_WINDOW (msgdialog),
+                                  _("Rename File Error"));
+
+            gtk_dialog_run (GTK_DIALOG (msgdialog));
+            gtk_widget_destroy (msgdialog);
+        }
+
+        Log_Print (LOG_ERROR, "%s", error->message);
+        et_application_window_status_bar_message (ET_APPLICATION_WINDOW (MainWindow),
+                                                  _("File(s) not renamed"),
+                                                  TRUE);
+        g_error_free (error);
+
+        return FALSE;
+    }
+
+    et_rename_plan_foreach (rename_plan, mark_file_name_renamed, NULL);
+
+    return TRUE;
+}
+
 /*
  * Write tag of the ETFile
  * Return TRUE => OK
@@ -715,12 +763,11 @@ static gboolean
 Write_File_Tag (ET_File *ETFile, gboolean hide_msgbox)
 {
     GError *error = NULL;
-    const gchar *cur_filename_utf8 = ((File_Name *)ETFile->FileNameCur->data)->value_utf8;
     gchar *msg = NULL;
     gchar *basename_utf8;
     GtkWidget *msgdialog;
 
-    basename_utf8 = g_path_get_basename(cur_filename_utf8);
+    basename_utf8 = g_strdup (((File_Name *)ETFile->FileNameCur->data)->name_utf8);
     msg = g_strdup_printf (_("Writing tag of ‘%s’"),basename_utf8);
     et_application_window_status_bar_message (ET_APPLICATION_WINDOW (MainWindow),
                                               msg, TRUE);
@@ -823,12 +870,14 @@ Read_Directory (const gchar *path_real)
 
     ReadingDirectory = TRUE;    /* A flag to avoid to start another reading */
 
+    window = ET_APPLICATION_WINDOW (MainWindow);
+
     /* Initialize file list */
+    et_application_window_search_dialog_clear (window);
     ET_Core_Free ();
     ET_Core_Create ();
-    et_application_window_update_actions (ET_APPLICATION_WINDOW (MainWindow));
-
-    window = ET_APPLICATION_WINDOW (MainWindow);
+    clear_directory_watch ();
+    et_application_window_update_actions (window);
 
     /* Initialize browser list */
     et_application_window_browser_clear (window);
@@ -886,10 +935,20 @@ Read_Directory (const gchar *path_real)
     msg = g_strdup_printf(_("Search in progress…"));
     et_application_window_status_bar_message (window, msg, FALSE);
     g_free (msg);
+
+    /* Watch the directories before searching them, so that no change made
+     * while loading is missed. */
+    DirectoryWatch = et_directory_watch_new ();
+    DirectoryWatchRoot = g_object_ref (dir);
+    DirectoryWatchRecurse = g_settings_get_boolean (MainSettings,
+                                                    "browse-subdir");
+    DirectoryWatchShowHidden = et_settings_get_snapshot ()->browse_show_hidden;
+    et_directory_watch_add (DirectoryWatch, dir);
+
     /* Search the supported files. */
     FileList = read_directory_recursively (FileList, dir_enumerator,
-                                           g_settings_get_boolean (MainSettings,
-                                                                   "browse-subdir"));
+                                           DirectoryWatchRecurse,
+                                           DirectoryWatch);
     g_file_enumerator_close (dir_enumerator, NULL, &error);
     g_object_unref (dir_enumerator);
     g_object_unref (dir);
@@ -929,6 +988,13 @@ Read_Directory (const gchar *path_real)
     g_list_free_full (FileList, g_object_unref);
     et_application_window_progress_set_text (window, "");
 
+    /* Only some of the files were loaded, so that the directory must be read
+     * again in full when reloading. */
+    if (Main_Stop_Button_Pressed)
+    {
+        clear_directory_watch ();
+    }
+
     /* Close window to quit recursion */
     Destroy_Quit_Recursion_Function_Window();
     Main_Stop_Button_Pressed = FALSE;
@@ -1000,12 +1066,272 @@ Read_Directory (const gchar *path_real)
 
 
 
+/*
+ * et_read_directory_changes:
+ * @path_real: the directory to reload
+ *
+ * Read again only the files which were added, removed or changed in
+ * @path_real since it was loaded by Read_Directory(), as reported by the
+ * watch of the loaded directories. The other files are kept as they are,
+ * with their undo history, and the selection is kept too. Files with unsaved
+ * changes are not read again either, unless they were removed.
+ *
+ * Returns: %TRUE if the directory was reloaded, %FALSE if it must be read
+ * again in full with Read_Directory()
+ */
+gboolean
+et_read_directory_changes (const gchar *path_real)
+{
+    EtApplicationWindow *window;
+    GFile *dir;
+    gboolean loaded_dir;
+    GPtrArray *changes;
+    GList *removed_files;
+    GList *added_files;
+    GList *selected_files;
+    GList *selected_filenames = NULL;
+    gchar *displayed_filename = NULL;
+    GHashTable *added_filenames;
+    GHashTable *removed_filenames;
+    GHashTable *loaded_files;
+    gboolean unselected;
+    guint n_changed;
+    gchar *msg;
+    GList *l;
+
+    g_return_val_if_fail (path_real != NULL, FALSE);
+
+    if (ReadingDirectory || DirectoryWatch == NULL
+        || !et_directory_watch_is_valid (DirectoryWatch)
+        || DirectoryWatchRecurse != g_settings_get_boolean (MainSettings,
+                                                            "browse-subdir")
+        || DirectoryWatchShowHidden != et_settings_get_snapshot ()->browse_show_hidden)
+    {
+        return FALSE;
+    }
+
+    dir = g_file_new_for_path (path_real);
+    loaded_dir = g_file_equal (dir, DirectoryWatchRoot);
+    g_object_unref (dir);
+
+    if (!loaded_dir)
+    {
+        return FALSE;
+    }
+
+    window = ET_APPLICATION_WINDOW (MainWindow);
+
+    /* Keep the changes made to the displayed file. */
+    et_application_window_update_et_file_from_ui (window);
+
+    changes = et_directory_watch_take_changes (DirectoryWatch);
+    et_file_list_find_changes (ETCore->ETFileList, DirectoryWatchRoot, changes,
+                               DirectoryWatchRecurse, DirectoryWatchShowHidden,
+                               DirectoryWatch, &removed_files, &added_files);
+    g_ptr_array_unref (changes);
+
+    if (removed_files == NULL && added_files == NULL)
+    {
+        et_application_window_status_bar_message (window,
+                                                  _("No files changed in this directory"),
+                                                  FALSE);
+        return TRUE;
+    }
+
+    ReadingDirectory = TRUE;
+    et_application_window_set_busy_cursor (window);
+
+    /* The rows of the browser refer to the files, so they are selected again
+     * by filename once the list is loaded again. */
+    selected_files = et_application_window_browser_get_selected_files (window);
+
+    for (l = selected_files; l != NULL; l = g_list_next (l))
+    {
+        ET_File *ETFile = (ET_File *)l->data;
+
+        selected_filenames = g_list_prepend (selected_filenames,
+                                             et_file_name_get_path ((File_Name *)ETFile->FileNameCur->data));
+    }
+
+    g_list_free (selected_files);
+
+    if (ETCore->ETFileDisplayed)
+    {
+        displayed_filename = et_file_name_get_path ((File_Name *)ETCore->ETFileDisplayed->FileNameCur->data);
+    }
+
+    et_application_window_browser_clear (window);
+    et_application_window_file_area_clear (window);
+    et_application_window_tag_area_clear (window);
+    ETCore->ETFileDisplayed = NULL;
+
+    /* A changed file is both removed and added. */
+    added_filenames = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                             NULL);
+
+    for (l = added_files; l != NULL; l = g_list_next (l))
+    {
+        g_hash_table_insert (added_filenames, g_file_get_path (l->data), l);
+    }
+
+    removed_filenames = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                               NULL);
+    n_changed = 0;
+
+    for (l = removed_files; l != NULL; l = g_list_next (l))
+    {
+        ET_File *ETFile = (ET_File *)l->data;
+        gchar *filename = et_file_name_get_path ((File_Name *)ETFile->FileNameCur->data);
+        gchar *display_path;
+        GList *added;
+
+        if (et_file_check_saved (ETFile))
+        {
+            g_hash_table_add (removed_filenames, filename);
+            n_changed++;
+            et_application_window_search_dialog_remove_file (window, ETFile);
+            ET_Remove_File_From_File_List (ETFile);
+            continue;
+        }
+
+        display_path = g_filename_display_name (filename);
+        added = g_hash_table_lookup (added_filenames, filename);
+
+        if (added)
+        {
+            /* Keep the unsaved changes instead of reading the file again.
+             * Its modification time is left as it was, so that saving it
+             * warns that it was changed by an external program. */
+            Log_Print (LOG_WARNING,
+                       _("File ‘%s’ was changed by another program, its unsaved changes were kept"),
+                       display_path);
+            g_object_unref (added->data);
+            added_files = g_list_delete_link (added_files, added);
+            g_free (filename);
+        }
+        else
+        {
+            Log_Print (LOG_WARNING,
+                       _("File ‘%s’ was removed by another program, its unsaved changes were discarded"),
+                       display_path);
+            g_hash_table_add (removed_filenames, filename);
+            n_changed++;
+            et_application_window_search_dialog_remove_file (window, ETFile);
+            ET_Remove_File_From_File_List (ETFile);
+        }
+
+        g_free (display_path);
+    }
+
+    g_hash_table_destroy (added_filenames);
+
+    for (l = added_files; l != NULL; l = g_list_next (l))
+    {
+        GFile *file = l->data;
+        gchar *filename = g_file_get_path (file);
+
+        if (!g_hash_table_contains (removed_filenames, filename))
+        {
+            n_changed++;
+        }
+
+        ETCore->ETFileList = et_file_list_add (ETCore->ETFileList, file);
+        g_free (filename);
+    }
+
+    g_hash_table_destroy (removed_filenames);
+    g_list_free (removed_files);
+    g_list_free_full (added_files, g_object_unref);
+
+    if (ETCore->ETFileList)
+    {
+        et_application_window_browser_toggle_display_mode (window);
+
+        loaded_files = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                              NULL);
+
+        for (l = ETCore->ETFileList; l != NULL; l = g_list_next (l))
+        {
+            ET_File *ETFile = (ET_File *)l->data;
+
+            g_hash_table_insert (loaded_files,
+                                 et_file_name_get_path ((File_Name *)ETFile->FileNameCur->data),
+                                 ETFile);
+        }
+
+        /* Unless all were removed, keep the selected files. */
+        unselected = FALSE;
+
+        for (l = selected_filenames; l != NULL; l = g_list_next (l))
+        {
+            ET_File *ETFile = g_hash_table_lookup (loaded_files, l->data);
+
+            if (ETFile)
+            {
+                if (!unselected)
+                {
+                    et_application_window_browser_unselect_all (window);
+                    unselected = TRUE;
+                }
+
+                et_application_window_browser_select_file_by_et_file (window,
+                                                                      ETFile,
+                                                                      TRUE);
+            }
+        }
+
+        if (displayed_filename
+            && g_hash_table_contains (loaded_files, displayed_filename))
+        {
+            et_application_window_select_file_by_et_file (window,
+                                                          g_hash_table_lookup (loaded_files,
+                                                                               displayed_filename));
+        }
+
+        g_hash_table_destroy (loaded_files);
+    }
+    else
+    {
+        et_application_window_browser_label_set_text (window,
+                                                      /* Translators: No files, as in "0 files". */
+                                                      _("No files"));
+    }
+
+    g_list_free_full (selected_filenames, g_free);
+    g_free (displayed_filename);
+
+    et_application_window_update_actions (window);
+
+    msg = g_strdup_printf (ngettext ("Reloaded one changed file",
+                                     "Reloaded %u changed files", n_changed),
+                           n_changed);
+    et_application_window_status_bar_message (window, msg, FALSE);
+    g_free (msg);
+    et_application_window_set_normal_cursor (window);
+    ReadingDirectory = FALSE;
+
+    return TRUE;
+}
+
+static void
+clear_directory_watch (void)
+{
+    if (DirectoryWatch)
+    {
+        et_directory_watch_free (DirectoryWatch);
+        DirectoryWatch = NULL;
+    }
+
+    g_clear_object (&DirectoryWatchRoot);
+}
+
 /*
  * Recurse the path to create a list of files. Return a GList of the files found.
+ * The directories searched are added to @watch.
  */
 static GList *
 read_directory_recursively (GList *file_list, GFileEnumerator *dir_enumerator,
-                            gboolean recurse)
+                            gboolean recurse, EtDirectoryWatch *watch)
 {
     GError *error = NULL;
     GFileInfo *info;
@@ -1029,8 +1355,7 @@ read_directory_recursively (GList *file_list, GFileEnumerator *dir_enumerator,
         type = g_file_info_get_file_type (info);
 
         /* Hidden directory like '.mydir' will also be browsed if allowed. */
-        if (!is_hidden || (g_settings_get_boolean (MainSettings,
-                                                   "browse-show-hidden")
+        if (!is_hidden || (et_settings_get_snapshot ()->browse_show_hidden
                            && is_hidden))
         {
             if (type == G_FILE_TYPE_DIRECTORY)
@@ -1048,6 +1373,9 @@ read_directory_recursively (GList *file_list, GFileEnumerator *dir_enumerator,
                                                                      G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN,
                                                                      G_FILE_QUERY_INFO_NONE,
                                                                      NULL, &child_error);
+
+                    et_directory_watch_add (watch, child_dir);
+
                     if (!childdir_enumerator)
                     {
                         gchar *child_path;
@@ -1069,7 +1397,7 @@ read_directory_recursively (GList *file_list, GFileEnumerator *dir_enumerator,
                     }
                     file_list = read_directory_recursively (file_list,
                                                             childdir_enumerator,
-                                                            recurse);
+                                                            recurse, watch);
                     g_object_unref (child_dir);
                     g_file_enumerator_close (childdir_enumerator, NULL,
                                              &error);
@@ -36,6 +36,7 @@ ET_Core_Create (void)
     if (ETCore == NULL)
     {
         ETCore = g_slice_new0 (ET_Core);
+        ETCore->ETFileChangedKeys = g_hash_table_new (NULL, NULL);
     }
 }
 
@@ -69,9 +70,33 @@ ET_Core_Free (void)
         ETCore->ETArtistAlbumFileList = NULL;
     }
 
+    g_clear_pointer (&ETCore->ETFileChangedKeys, g_hash_table_unref);
+
     if (ETCore)
     {
         g_slice_free (ET_Core, ETCore);
         ETCore = NULL;
     }
 }
+
+/*
+ * et_core_mark_file_changed:
+ * @ETFile: the file whose name, tag or saved state changed
+ *
+ * Record that @ETFile changed, so that et_browser_refresh_list() only
+ * refreshes the rows of the changed files. Does nothing without a core, such
+ * as in batch mode, where files are changed from several threads.
+ */
+void
+et_core_mark_file_changed (const ET_File *ETFile)
+{
+    g_return_if_fail (ETFile != NULL);
+
+    if (ETCore == NULL)
+    {
+        return;
+    }
+
+    g_hash_table_add (ETCore->ETFileChangedKeys,
+                      GUINT_TO_POINTER (ETFile->ETFileKey));
+}
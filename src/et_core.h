@@ -56,6 +56,10 @@ typedef struct
 
     // History list
     GList *ETHistoryFileList;           // History list of files changes for undo/redo actions
+
+    /* Set of the ETFileKey of the files whose name, tag or saved state
+     * changed since their row in the browser list was last refreshed. */
+    GHashTable *ETFileChangedKeys;
 } ET_Core;
 
 extern ET_Core *ETCore; /* Main pointer to structure needed by EasyTAG. */
@@ -63,6 +67,8 @@ extern ET_Core *ETCore; /* Main pointer to structure needed by EasyTAG. */
 void ET_Core_Create (void);
 void ET_Core_Free (void);
 
+void et_core_mark_file_changed (const ET_File *ETFile);
+
 G_END_DECLS
 
 #endif /* ET_CORE_H_ */
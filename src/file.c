@@ -88,13 +88,11 @@ gint
 ET_Comp_Func_Sort_File_By_Ascending_Filename (const ET_File *ETFile1,
                                               const ET_File *ETFile2)
 {
-    const gchar *file1_ck = ((File_Name *)((GList *)ETFile1->FileNameCur)->data)->value_ck;
-    const gchar *file2_ck = ((File_Name *)((GList *)ETFile2->FileNameCur)->data)->value_ck;
     // !!!! : Must be the same rules as "Cddb_Track_List_Sort_Func" to be
     // able to sort in the same order files in cddb and in the file list.
-    return g_settings_get_boolean (MainSettings,
-                                   "sort-case-sensitive") ? strcmp (file1_ck, file2_ck)
-                                                          : strcasecmp (file1_ck, file2_ck);
+    return et_file_name_collate ((File_Name *)ETFile1->FileNameCur->data,
+                                 (File_Name *)ETFile2->FileNameCur->data,
+                                 et_settings_get_snapshot ()->sort_case_sensitive);
 }
 
 /*
@@ -205,13 +203,16 @@ gint
 ET_Comp_Func_Sort_File_By_Ascending_Creation_Date (const ET_File *ETFile1,
                                                    const ET_File *ETFile2)
 {
+    gchar *path;
     GFile *file;
     GFileInfo *info;
     guint64 time1 = 0;
     guint64 time2 = 0;
 
     /* TODO: Report errors? */
-    file = g_file_new_for_path (((File_Name *)ETFile1->FileNameCur->data)->value);
+    path = et_file_name_get_path ((File_Name *)ETFile1->FileNameCur->data);
+    file = g_file_new_for_path (path);
+    g_free (path);
     info = g_file_query_info (file, G_FILE_ATTRIBUTE_TIME_CHANGED,
                               G_FILE_QUERY_INFO_NONE, NULL, NULL);
 
@@ -224,7 +225,9 @@ ET_Comp_Func_Sort_File_By_Ascending_Creation_Date (const ET_File *ETFile1,
         g_object_unref (info);
     }
 
-    file = g_file_new_for_path (((File_Name *)ETFile2->FileNameCur->data)->value);
+    path = et_file_name_get_path ((File_Name *)ETFile2->FileNameCur->data);
+    file = g_file_new_for_path (path);
+    g_free (path);
     info = g_file_query_info (file, G_FILE_ATTRIBUTE_TIME_CHANGED,
                               G_FILE_QUERY_INFO_NONE, NULL, NULL);
 
@@ -327,8 +330,7 @@ ET_Comp_Func_Sort_File_By_Ascending_Title (const ET_File *ETFile1,
     return et_file_list_sort_string (((File_Tag *)ETFile1->FileTag->data)->title,
                                      ((File_Tag *)ETFile2->FileTag->data)->title,
                                      ETFile1, ETFile2,
-                                     g_settings_get_boolean (MainSettings,
-                                                             "sort-case-sensitive"));
+                                     et_settings_get_snapshot ()->sort_case_sensitive);
 }
 
 /*
@@ -367,8 +369,7 @@ ET_Comp_Func_Sort_File_By_Ascending_Artist (const ET_File *ETFile1,
     return et_file_list_sort_string (((File_Tag *)ETFile1->FileTag->data)->artist,
                                      ((File_Tag *)ETFile2->FileTag->data)->artist,
                                      ETFile1, ETFile2,
-                                     g_settings_get_boolean (MainSettings,
-                                                             "sort-case-sensitive"));
+                                     et_settings_get_snapshot ()->sort_case_sensitive);
 }
 
 /*
@@ -406,8 +407,7 @@ ET_Comp_Func_Sort_File_By_Ascending_Album_Artist (const ET_File *ETFile1,
     return et_file_list_sort_string (((File_Tag *)ETFile1->FileTag->data)->album_artist,
                                      ((File_Tag *)ETFile2->FileTag->data)->album_artist,
                                      ETFile1, ETFile2,
-                                     g_settings_get_boolean (MainSettings,
-                                                             "sort-case-sensitive"));
+                                     et_settings_get_snapshot ()->sort_case_sensitive);
 }
 
 /*
@@ -445,8 +445,7 @@ ET_Comp_Func_Sort_File_By_Ascending_Album (const ET_File *ETFile1,
     return et_file_list_sort_string (((File_Tag *)ETFile1->FileTag->data)->album,
                                      ((File_Tag *)ETFile2->FileTag->data)->album,
                                      ETFile1, ETFile2,
-                                     g_settings_get_boolean (MainSettings,
-                                                             "sort-case-sensitive"));
+                                     et_settings_get_snapshot ()->sort_case_sensitive);
 }
 
 /*
@@ -523,8 +522,7 @@ ET_Comp_Func_Sort_File_By_Ascending_Genre (const ET_File *ETFile1,
     return et_file_list_sort_string (((File_Tag *)ETFile1->FileTag->data)->genre,
                                      ((File_Tag *)ETFile2->FileTag->data)->genre,
                                      ETFile1, ETFile2,
-                                     g_settings_get_boolean (MainSettings,
-                                                             "sort-case-sensitive"));
+                                     et_settings_get_snapshot ()->sort_case_sensitive);
 }
 
 /*
@@ -563,8 +561,7 @@ ET_Comp_Func_Sort_File_By_Ascending_Comment (const ET_File *ETFile1,
     return et_file_list_sort_string (((File_Tag *)ETFile1->FileTag->data)->comment,
                                      ((File_Tag *)ETFile2->FileTag->data)->comment,
                                      ETFile1, ETFile2,
-                                     g_settings_get_boolean (MainSettings,
-                                                             "sort-case-sensitive"));
+                                     et_settings_get_snapshot ()->sort_case_sensitive);
 }
 
 /*
@@ -603,8 +600,7 @@ ET_Comp_Func_Sort_File_By_Ascending_Composer (const ET_File *ETFile1,
     return et_file_list_sort_string (((File_Tag *)ETFile1->FileTag->data)->composer,
                                      ((File_Tag *)ETFile2->FileTag->data)->composer,
                                      ETFile1, ETFile2,
-                                     g_settings_get_boolean (MainSettings,
-                                                             "sort-case-sensitive"));
+                                     et_settings_get_snapshot ()->sort_case_sensitive);
 }
 
 /*
@@ -643,8 +639,7 @@ ET_Comp_Func_Sort_File_By_Ascending_Orig_Artist (const ET_File *ETFile1,
     return et_file_list_sort_string (((File_Tag *)ETFile1->FileTag->data)->orig_artist,
                                      ((File_Tag *)ETFile2->FileTag->data)->orig_artist,
                                      ETFile1, ETFile2,
-                                     g_settings_get_boolean (MainSettings,
-                                                             "sort-case-sensitive"));
+                                     et_settings_get_snapshot ()->sort_case_sensitive);
 }
 
 /*
@@ -683,8 +678,7 @@ ET_Comp_Func_Sort_File_By_Ascending_Copyright (const ET_File *ETFile1,
     return et_file_list_sort_string (((File_Tag *)ETFile1->FileTag->data)->copyright,
                                      ((File_Tag *)ETFile2->FileTag->data)->copyright,
                                      ETFile1, ETFile2,
-                                     g_settings_get_boolean (MainSettings,
-                                                             "sort-case-sensitive"));
+                                     et_settings_get_snapshot ()->sort_case_sensitive);
 }
 
 /*
@@ -726,8 +720,7 @@ ET_Comp_Func_Sort_File_By_Ascending_Url (const ET_File *ETFile1,
     return et_file_list_sort_string (((File_Tag *)ETFile1->FileTag->data)->url,
                                      ((File_Tag *)ETFile2->FileTag->data)->url,
                                      ETFile1, ETFile2,
-                                     g_settings_get_boolean (MainSettings,
-                                                             "sort-case-sensitive"));
+                                     et_settings_get_snapshot ()->sort_case_sensitive);
 }
 
 /*
@@ -769,8 +762,7 @@ ET_Comp_Func_Sort_File_By_Ascending_Encoded_By (const ET_File *ETFile1,
     return et_file_list_sort_string (((File_Tag *)ETFile1->FileTag->data)->encoded_by,
                                      ((File_Tag *)ETFile2->FileTag->data)->encoded_by,
                                      ETFile1, ETFile2,
-                                     g_settings_get_boolean (MainSettings,
-                                                             "sort-case-sensitive"));
+                                     et_settings_get_snapshot ()->sort_case_sensitive);
 }
 
 /*
@@ -1036,10 +1028,10 @@ ET_Save_File_Name_Internal (const ET_File *ETFile,
     g_return_val_if_fail (ETFile != NULL && FileName != NULL, FALSE);
 
     // Get the current path to the file
-    dirname = g_path_get_dirname( ((File_Name *)ETFile->FileNameNew->data)->value );
+    dirname = et_file_name_get_dirname ((File_Name *)ETFile->FileNameNew->data);
 
     // Get the name of file (and rebuild it with extension with a 'correct' case)
-    filename = g_path_get_basename( ((File_Name *)ETFile->FileNameNew->data)->value );
+    filename = g_strdup (((File_Name *)ETFile->FileNameNew->data)->name);
 
     // Remove the extension
     if ((pos=strrchr(filename, '.'))!=NULL)
@@ -1058,8 +1050,7 @@ ET_Save_File_Name_Internal (const ET_File *ETFile,
 
     success = et_file_name_set_from_components (FileName, filename_new,
                                                 dirname,
-                                                g_settings_get_boolean (MainSettings,
-                                                                        "rename-replace-illegal-chars"));
+                                                et_settings_get_snapshot ()->rename_replace_illegal_chars);
 
     g_free (filename_new);
     g_free (dirname);
@@ -1276,8 +1267,8 @@ gboolean
 ET_Save_File_Tag_To_HD (ET_File *ETFile, GError **error)
 {
     const ET_File_Description *description;
-    const gchar *cur_filename;
-    const gchar *cur_filename_utf8;
+    const File_Name *FileNameCur;
+    gchar *cur_filename;
     gboolean state;
     GFile *file;
     GFileInfo *fileinfo;
@@ -1285,13 +1276,14 @@ ET_Save_File_Tag_To_HD (ET_File *ETFile, GError **error)
     g_return_val_if_fail (ETFile != NULL, FALSE);
     g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-    cur_filename = ((File_Name *)(ETFile->FileNameCur)->data)->value;
-    cur_filename_utf8 = ((File_Name *)(ETFile->FileNameCur)->data)->value_utf8;
+    FileNameCur = (File_Name *)ETFile->FileNameCur->data;
 
     description = ETFile->ETFileDescription;
 
     /* Store the file timestamps (in case they are to be preserved) */
+    cur_filename = et_file_name_get_path (FileNameCur);
     file = g_file_new_for_path (cur_filename);
+    g_free (cur_filename);
     fileinfo = g_file_query_info (file, "time::*", G_FILE_QUERY_INFO_NONE,
                                   NULL, NULL);
 
@@ -1350,11 +1342,16 @@ ET_Save_File_Tag_To_HD (ET_File *ETFile, GError **error)
 #endif
         case UNKNOWN_TAG:
         default:
+        {
+            gchar *cur_filename_utf8 = et_file_name_get_path_utf8 (FileNameCur);
+
             Log_Print (LOG_ERROR,
                        "Saving to HD: Undefined function for tag type '%d' (file %s).",
                        (gint)description->TagType, cur_filename_utf8);
+            g_free (cur_filename_utf8);
             state = FALSE;
             break;
+        }
     }
 
     /* Update properties for the file. */
@@ -1371,16 +1368,19 @@ ET_Save_File_Tag_To_HD (ET_File *ETFile, GError **error)
         g_object_unref (fileinfo);
     }
 
-    /* Update the stored file modification time to prevent EasyTAG from warning
-     * that an external program has changed the file. */
+    /* Update the stored file modification time and size to prevent EasyTAG
+     * from warning that an external program has changed the file, or from
+     * reading it again when reloading the directory. */
     fileinfo = g_file_query_info (file,
-                                  G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                                  G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                                  G_FILE_ATTRIBUTE_STANDARD_SIZE,
                                   G_FILE_QUERY_INFO_NONE, NULL, NULL);
 
     if (fileinfo)
     {
         ETFile->FileModificationTime = g_file_info_get_attribute_uint64 (fileinfo,
                                                                          G_FILE_ATTRIBUTE_TIME_MODIFIED);
+        ETFile->ETFileInfo->size = g_file_info_get_size (fileinfo);
         g_object_unref (fileinfo);
     }
 
@@ -1397,9 +1397,10 @@ ET_Save_File_Tag_To_HD (ET_File *ETFile, GError **error)
         if (g_settings_get_boolean (MainSettings,
                                     "file-update-parent-modification-time"))
         {
-            gchar *path = g_path_get_dirname (cur_filename);
-            g_utime (path, NULL);
-            g_free (path);
+            gchar *dirname = et_file_name_get_dirname (FileNameCur);
+
+            g_utime (dirname, NULL);
+            g_free (dirname);
         }
 
         ET_Mark_File_Tag_As_Saved(ETFile);
@@ -1462,12 +1463,14 @@ ET_Manage_Changes_Of_File_Data (ET_File *ETFile,
     }
 
     /*
-     * Generate main undo (file history of modifications)
+     * Generate main undo (file history of modifications). There is no main
+     * undo list in batch mode.
      */
-    if (undo_added)
+    if (undo_added && ETCore)
     {
         ETCore->ETHistoryFileList = et_history_list_add (ETCore->ETHistoryFileList,
                                                          ETFile);
+        et_core_mark_file_changed (ETFile);
     }
 
     //return TRUE;
@@ -1574,6 +1577,11 @@ gboolean ET_Undo_File_Data (ET_File *ETFile)
         has_filetag_undo_data  = TRUE;
     }
 
+    if (has_filename_undo_data || has_filetag_undo_data)
+    {
+        et_core_mark_file_changed (ETFile);
+    }
+
     return has_filename_undo_data | has_filetag_undo_data;
 }
 
@@ -1635,6 +1643,11 @@ gboolean ET_Redo_File_Data (ET_File *ETFile)
         has_filetag_redo_data  = TRUE;
     }
 
+    if (has_filename_redo_data || has_filetag_redo_data)
+    {
+        et_core_mark_file_changed (ETFile);
+    }
+
     return has_filename_redo_data | has_filetag_redo_data;
 }
 
@@ -1719,6 +1732,7 @@ ET_Mark_File_Tag_As_Saved (ET_File *ETFile)
     FileTagList = ETFile->FileTagList;
     g_list_foreach(FileTagList,(GFunc)Set_Saved_Value_Of_File_Tag,FALSE); // All other FileTag set to FALSE
     FileTag->saved = TRUE; // The current FileTag set to TRUE
+    et_core_mark_file_changed (ETFile);
 }
 
 
@@ -1731,6 +1745,7 @@ void ET_Mark_File_Name_As_Saved (ET_File *ETFile)
     FileNameList = ETFile->FileNameList;
     g_list_foreach(FileNameList,(GFunc)Set_Saved_Value_Of_File_Tag,FALSE);
     FileNameNew->saved = TRUE;
+    et_core_mark_file_changed (ETFile);
 }
 
 /*
@@ -1753,7 +1768,7 @@ et_file_generate_name (const ET_File *ETFile,
     g_return_val_if_fail (ETFile && ETFile->FileNameNew->data, NULL);
     g_return_val_if_fail (new_file_name_utf8, NULL);
 
-    if ((dirname_utf8 = g_path_get_dirname (((File_Name *)ETFile->FileNameNew->data)->value_utf8)))
+    if ((dirname_utf8 = et_file_name_get_dirname_utf8 ((File_Name *)ETFile->FileNameNew->data)))
     {
         gchar *extension;
         gchar *new_file_name_path_utf8;
@@ -1805,7 +1820,7 @@ gchar *et_file_generate_name (ET_File *ETFile, gchar *new_file_name_utf8)
     gchar *dirname;
 
     if (ETFile && ETFile->FileNameNew->data && new_file_name_utf8
-    && (dirname=g_path_get_dirname(((File_Name *)ETFile->FileNameNew->data)->value)) )
+    && (dirname=et_file_name_get_dirname((File_Name *)ETFile->FileNameNew->data)) )
     {
         gchar *extension;
         gchar *new_file_name_path;
@@ -207,7 +207,7 @@ et_file_area_set_file_fields (EtFileArea *self,
     EtFileAreaPrivate *priv;
     GFile *file;
     gchar *text;
-    const gchar *cur_filename;
+    gchar *cur_filename;
     gchar *basename_utf8;
     gchar *pos;
     GFileInfo *info;
@@ -218,9 +218,10 @@ et_file_area_set_file_fields (EtFileArea *self,
 
     priv = et_file_area_get_instance_private (self);
 
-    cur_filename = ((File_Name *)((GList *)ETFile->FileNameCur)->data)->value;
+    cur_filename = et_file_name_get_path ((File_Name *)ETFile->FileNameCur->data);
 
     file = g_file_new_for_path (cur_filename);
+    g_free (cur_filename);
 
     info = g_file_query_info (file, G_FILE_ATTRIBUTE_ACCESS_CAN_READ ","
                               G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE,
@@ -305,7 +306,7 @@ et_file_area_set_file_fields (EtFileArea *self,
 
 
     /* Set new filename into name_entry. This matches the GFile edit name. */
-    basename_utf8 = g_filename_display_basename (((File_Name *)((GList *)ETFile->FileNameNew)->data)->value);
+    basename_utf8 = g_filename_display_name (((File_Name *)ETFile->FileNameNew->data)->name);
 
     /* Remove the extension. */
     if ((pos = strrchr (basename_utf8, '.')) != NULL)
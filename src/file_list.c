@@ -37,6 +37,7 @@
 #include "monkeyaudio_header.h"
 #include "musepack_header.h"
 #include "picture.h"
+#include "setting.h"
 #include "ape_tag.h"
 #ifdef ENABLE_MP3
 #include "id3_tag.h"
@@ -76,12 +77,6 @@ et_file_list_free (GList *file_list)
     g_list_free_full (file_list, (GDestroyNotify)ET_Free_File_List_Item);
 }
 
-static void
-et_history_file_free (ET_History_File *file)
-{
-    g_slice_free (ET_History_File, file);
-}
-
 /*
  * History list contains only pointers, so no data to free except the history structure.
  */
@@ -137,12 +132,13 @@ et_artist_album_file_list_free (GList *file_list)
     g_list_free (file_list);
 }
 
-/* Key for each item of ETFileList */
+/* Key for each item of ETFileList. Files may be loaded from several threads,
+ * in batch mode. */
 static guint
 ET_File_Key_New (void)
 {
-    static guint ETFileKey = 0;
-    return ++ETFileKey;
+    static gint ETFileKey = 0;
+    return g_atomic_int_add (&ETFileKey, 1) + 1;
 }
 
 /*
@@ -212,6 +208,13 @@ et_file_list_add (GList *file_list,
     gchar *display_path;
     GError *error = NULL;
     gboolean success;
+#ifdef ENABLE_MP3
+    /* Offset of the audio data, found while reading the ID3v2 tag. */
+    goffset audio_offset = -1;
+#endif
+#ifdef ENABLE_MP4
+    gboolean mp4_info_read = FALSE;
+#endif
 
     g_return_val_if_fail (file != NULL, file_list);
 
@@ -235,11 +238,15 @@ et_file_list_add (GList *file_list,
     FileTag = et_file_tag_new ();
     FileTag->saved = TRUE;    /* The file hasn't been changed, so it's saved */
 
+    /* Fill the ET_File_Info structure: some tag readers fill it in as well,
+     * from the same parse of the file. */
+    ETFileInfo = et_file_info_new ();
+
     switch (description->TagType)
     {
 #ifdef ENABLE_MP3
         case ID3_TAG:
-            if (!id3tag_read_file_tag (file, FileTag, &error))
+            if (!et_id3tag_read_file (file, FileTag, &audio_offset, &error))
             {
                 Log_Print (LOG_ERROR,
                            _("Error reading ID3 tag from file ‘%s’: %s"),
@@ -281,13 +288,17 @@ et_file_list_add (GList *file_list,
             break;
 #ifdef ENABLE_MP4
         case MP4_TAG:
-            if (!mp4tag_read_file_tag (file, FileTag, &error))
+            if (!mp4tag_read_file_tag (file, FileTag, ETFileInfo, &error))
             {
                 Log_Print (LOG_ERROR,
                            _("Error reading tag from MP4 file ‘%s’: %s"),
                            display_path, error->message);
                 g_clear_error (&error);
             }
+            else
+            {
+                mp4_info_read = TRUE;
+            }
             break;
 #endif
 #ifdef ENABLE_WAVPACK
@@ -346,15 +357,13 @@ et_file_list_add (GList *file_list,
                    FileTag->year, display_path);
     }
 
-    /* Fill the ET_File_Info structure */
-    ETFileInfo = et_file_info_new ();
-
     switch (description->FileType)
     {
-#if defined ENABLE_MP3 && defined ENABLE_ID3LIB
+#ifdef ENABLE_MP3
         case MP3_FILE:
         case MP2_FILE:
-            success = et_mpeg_header_read_file_info (file, ETFileInfo, &error);
+            success = et_mpeg_header_read_file_info (file, audio_offset,
+                                                     ETFileInfo, &error);
             break;
 #endif
 #ifdef ENABLE_OGG
@@ -387,7 +396,9 @@ et_file_list_add (GList *file_list,
 #endif
 #ifdef ENABLE_MP4
         case MP4_FILE:
-            success = et_mp4_header_read_file_info (file, ETFileInfo, &error);
+            success = mp4_info_read
+                      || et_mp4_header_read_file_info (file, ETFileInfo,
+                                                       &error);
             break;
 #endif
 #ifdef ENABLE_OPUS
@@ -396,7 +407,7 @@ et_file_list_add (GList *file_list,
             break;
 #endif
         case OFR_FILE:
-#if !defined ENABLE_MP3 && !defined ENABLE_ID3LIB
+#ifndef ENABLE_MP3
         case MP3_FILE:
         case MP2_FILE:
 #endif
@@ -542,7 +553,7 @@ ET_Comp_Func_Sort_Artist_Item_By_Ascending_Artist (const GList *AlbumList1,
     etfile1_artist = ((File_Tag *)etfile1->FileTag->data)->artist;
     etfile2_artist = ((File_Tag *)etfile2->FileTag->data)->artist;
 
-    if (g_settings_get_boolean (MainSettings, "sort-case-sensitive"))
+    if (et_settings_get_snapshot ()->sort_case_sensitive)
     {
         return et_normalized_strcmp0 (etfile1_artist, etfile2_artist);
     }
@@ -577,7 +588,7 @@ ET_Comp_Func_Sort_Album_Item_By_Ascending_Album (const GList *etfilelist1,
     etfile1_album  = ((File_Tag *)etfile1->FileTag->data)->album;
     etfile2_album  = ((File_Tag *)etfile2->FileTag->data)->album;
 
-    if (g_settings_get_boolean (MainSettings, "sort-case-sensitive"))
+    if (et_settings_get_snapshot ()->sort_case_sensitive)
     {
         return et_normalized_strcmp0 (etfile1_album, etfile2_album);
     }
@@ -847,6 +858,10 @@ ET_Remove_File_From_File_List (ET_File *ETFile)
     ETCore->ETFileDisplayedList = g_list_remove (g_list_first (ETCore->ETFileDisplayedList),
                                                  ETFile);
 
+    /* Remove the changes of the file from the main undo list. */
+    ETCore->ETHistoryFileList = et_history_list_remove_file (ETCore->ETHistoryFileList,
+                                                            ETFile);
+
     // Free data of the file
     ET_Free_File_List_Item(ETFile);
 
@@ -1197,71 +1212,6 @@ et_displayed_file_list_set (GList *ETFileList)
     et_displayed_file_list_renumber (ETCore->ETFileDisplayedList);
 }
 
-/*
- * Function used to update path of filenames into list after renaming a parent directory
- * (for ex: "/mp3/old_path/file.mp3" to "/mp3/new_path/file.mp3"
- */
-void
-et_file_list_update_directory_name (GList *file_list,
-                                    const gchar *old_path,
-                                    const gchar *new_path)
-{
-    GList *filelist;
-    ET_File *file;
-    GList *filenamelist;
-    gchar *filename;
-    gchar *old_path_tmp;
-
-    g_return_if_fail (file_list != NULL);
-    g_return_if_fail (!et_str_empty (old_path));
-    g_return_if_fail (!et_str_empty (new_path));
-
-    /* Add '/' to end of path to avoid ambiguity between a directory and a
-     * filename... */
-    if (old_path[strlen (old_path) - 1] == G_DIR_SEPARATOR)
-    {
-        old_path_tmp = g_strdup (old_path);
-    }
-    else
-    {
-        old_path_tmp = g_strconcat (old_path, G_DIR_SEPARATOR_S, NULL);
-    }
-
-    for (filelist = g_list_first (file_list); filelist != NULL;
-         filelist = g_list_next (filelist))
-    {
-        if ((file = filelist->data))
-        {
-            for (filenamelist = file->FileNameList; filenamelist != NULL;
-                 filenamelist = g_list_next (filenamelist))
-            {
-                File_Name *FileName = (File_Name *)filenamelist->data;
-
-                if ( FileName && (filename=FileName->value) )
-                {
-                    /* Replace path of filename. */
-                    if (strncmp (filename, old_path_tmp, strlen (old_path_tmp))
-                        == 0)
-                    {
-                        gchar *filename_tmp;
-
-                        // Create the new filename
-                        filename_tmp = g_strconcat (new_path,
-                                                    (new_path[strlen (new_path) - 1] == G_DIR_SEPARATOR) ? "" : G_DIR_SEPARATOR_S,
-                                                    &filename[strlen (old_path_tmp)],NULL);
-
-                        ET_Set_Filename_File_Name_Item (FileName, NULL,
-                                                        filename_tmp);
-                        g_free (filename_tmp);
-                    }
-                }
-             }
-        }
-    }
-
-    g_free (old_path_tmp);
-}
-
 /*
  * Execute one 'undo' in the main undo list (it selects the last ETFile changed,
  * before to apply an undo action)
@@ -1408,20 +1358,15 @@ guint
 et_file_list_get_n_files_in_path (GList *file_list,
                                   const gchar *path_utf8)
 {
-    gchar *path_key;
     GList *l;
     guint  count = 0;
 
     g_return_val_if_fail (path_utf8 != NULL, count);
 
-    path_key = g_utf8_collate_key (path_utf8, -1);
-
     for (l = g_list_first (file_list); l != NULL; l = g_list_next (l))
     {
         ET_File *ETFile = (ET_File *)l->data;
-        const gchar *cur_filename_utf8 = ((File_Name *)((GList *)ETFile->FileNameCur)->data)->value_utf8;
-        gchar *dirname_utf8      = g_path_get_dirname(cur_filename_utf8);
-        gchar *dirname_key = g_utf8_collate_key (dirname_utf8, -1);
+        gchar *dirname_utf8 = et_file_name_get_dirname_utf8 ((File_Name *)ETFile->FileNameCur->data);
 
         if (strcmp (dirname_utf8, path_utf8) == 0)
         {
@@ -1429,10 +1374,7 @@ et_file_list_get_n_files_in_path (GList *file_list,
         }
 
         g_free (dirname_utf8);
-        g_free (dirname_key);
     }
 
-    g_free (path_key);
-
     return count;
 }
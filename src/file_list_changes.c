@@ -0,0 +1,367 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include "file_list_changes.h"
+
+/*
+ * et_history_file_free:
+ * @file: an item of a history list
+ *
+ * Free @file. The file it refers to is not freed.
+ */
+void
+et_history_file_free (ET_History_File *file)
+{
+    g_slice_free (ET_History_File, file);
+}
+
+/*
+ * et_history_list_remove_file:
+ * @history_list: the current item of a history list
+ * @ETFile: the file of which to remove the changes
+ *
+ * Remove the items of @history_list which refer to @ETFile, such as before
+ * freeing it.
+ *
+ * Returns: the current item of the history list, which is moved back if it
+ * was removed
+ */
+GList *
+et_history_list_remove_file (GList *history_list,
+                             const ET_File *ETFile)
+{
+    GList *head;
+    GList *l;
+
+    if (history_list == NULL)
+    {
+        return NULL;
+    }
+
+    /* The first item has no file, so is never removed. */
+    head = g_list_first (history_list);
+    l = head->next;
+
+    while (l != NULL)
+    {
+        GList *next = l->next;
+
+        if (((ET_History_File *)l->data)->ETFile == ETFile)
+        {
+            if (history_list == l)
+            {
+                history_list = l->prev;
+            }
+
+            et_history_file_free (l->data);
+            head = g_list_delete_link (head, l);
+        }
+
+        l = next;
+    }
+
+    return history_list;
+}
+
+/* The attributes needed to tell whether a file changed since it was read. */
+#define CHANGES_ATTRIBUTES G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+                           G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+                           G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN "," \
+                           G_FILE_ATTRIBUTE_STANDARD_SIZE "," \
+                           G_FILE_ATTRIBUTE_TIME_MODIFIED
+
+/*
+ * EtFileListChanges:
+ * @loaded: the loaded files, by current filename
+ * @handled: the filenames which were already compared, as a set
+ * @removed: the files to remove, as a set
+ * @removed_files: the files to remove, in the order found
+ * @added_files: the files to read, in the order found
+ * @recurse: whether files in subdirectories are loaded
+ * @show_hidden: whether hidden files and directories are loaded
+ * @watch: (allow-none): the watch to which to add the directories read
+ *
+ * The state of et_file_list_find_changes().
+ */
+typedef struct
+{
+    GHashTable *loaded;
+    GHashTable *handled;
+    GHashTable *removed;
+    GList *removed_files;
+    GList *added_files;
+    gboolean recurse;
+    gboolean show_hidden;
+    EtDirectoryWatch *watch;
+} EtFileListChanges;
+
+static void
+changes_remove_file (EtFileListChanges *changes,
+                     ET_File *ETFile)
+{
+    if (!g_hash_table_contains (changes->removed, ETFile))
+    {
+        g_hash_table_add (changes->removed, ETFile);
+        changes->removed_files = g_list_prepend (changes->removed_files,
+                                                 ETFile);
+    }
+}
+
+/*
+ * Compare @file with the loaded file of the same name, if any. @info is
+ * %NULL if @file does not exist.
+ */
+static void
+changes_check_file (EtFileListChanges *changes,
+                    GFile *file,
+                    GFileInfo *info)
+{
+    gchar *filename;
+    ET_File *ETFile;
+    gboolean visible;
+
+    filename = g_file_get_path (file);
+
+    if (filename == NULL
+        || g_hash_table_contains (changes->handled, filename))
+    {
+        g_free (filename);
+        return;
+    }
+
+    g_hash_table_add (changes->handled, filename);
+    ETFile = g_hash_table_lookup (changes->loaded, filename);
+    visible = info && g_file_info_get_file_type (info) == G_FILE_TYPE_REGULAR
+              && (changes->show_hidden || !g_file_info_get_is_hidden (info))
+              && et_file_is_supported (g_file_info_get_name (info));
+
+    if (ETFile)
+    {
+        if (visible
+            && ETFile->FileModificationTime
+               == g_file_info_get_attribute_uint64 (info,
+                                                    G_FILE_ATTRIBUTE_TIME_MODIFIED)
+            && ETFile->ETFileInfo->size == g_file_info_get_size (info))
+        {
+            return;
+        }
+
+        changes_remove_file (changes, ETFile);
+    }
+
+    if (visible)
+    {
+        changes->added_files = g_list_prepend (changes->added_files,
+                                               g_object_ref (file));
+    }
+}
+
+/*
+ * Remove the loaded files below @directory which were not found on disk.
+ */
+static void
+changes_remove_missing (EtFileListChanges *changes,
+                        GFile *directory)
+{
+    gchar *path;
+    gchar *prefix;
+    GHashTableIter iter;
+    gpointer filename;
+    gpointer ETFile;
+
+    path = g_file_get_path (directory);
+
+    if (path == NULL)
+    {
+        return;
+    }
+
+    prefix = g_str_has_suffix (path, G_DIR_SEPARATOR_S) ? g_strdup (path)
+                                                         : g_strconcat (path,
+                                                                        G_DIR_SEPARATOR_S,
+                                                                        NULL);
+    g_hash_table_iter_init (&iter, changes->loaded);
+
+    while (g_hash_table_iter_next (&iter, &filename, &ETFile))
+    {
+        if (g_str_has_prefix (filename, prefix)
+            && !g_hash_table_contains (changes->handled, filename))
+        {
+            changes_remove_file (changes, ETFile);
+        }
+    }
+
+    g_free (prefix);
+    g_free (path);
+}
+
+/*
+ * Compare the files in @directory, and in its subdirectories when loading
+ * recursively, with the loaded files.
+ */
+static void
+changes_read_directory (EtFileListChanges *changes,
+                        GFile *directory)
+{
+    GFileEnumerator *enumerator;
+    GFileInfo *info;
+
+    if (changes->watch)
+    {
+        et_directory_watch_add (changes->watch, directory);
+    }
+
+    enumerator = g_file_enumerate_children (directory, CHANGES_ATTRIBUTES,
+                                            G_FILE_QUERY_INFO_NONE, NULL,
+                                            NULL);
+
+    if (enumerator == NULL)
+    {
+        return;
+    }
+
+    while ((info = g_file_enumerator_next_file (enumerator, NULL, NULL)))
+    {
+        GFile *child;
+
+        child = g_file_enumerator_get_child (enumerator, info);
+
+        if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
+        {
+            if (changes->recurse
+                && (changes->show_hidden || !g_file_info_get_is_hidden (info)))
+            {
+                changes_read_directory (changes, child);
+            }
+        }
+        else
+        {
+            changes_check_file (changes, child, info);
+        }
+
+        g_object_unref (child);
+        g_object_unref (info);
+    }
+
+    g_file_enumerator_close (enumerator, NULL, NULL);
+    g_object_unref (enumerator);
+}
+
+/*
+ * et_file_list_find_changes:
+ * @file_list: (element-type ET_File) (allow-none): the loaded files
+ * @root: the loaded directory
+ * @changes: (element-type GFile): files and directories which changed since
+ * @file_list was loaded, such as reported by an #EtDirectoryWatch
+ * @recurse: whether files in subdirectories of @root are loaded
+ * @show_hidden: whether hidden files and directories are loaded
+ * @watch: (allow-none): a watch to which to add the directories which are
+ * read, or %NULL
+ * @removed_files: (out) (element-type ET_File) (transfer container): the
+ * loaded files which were removed, or changed and must be read again
+ * @added_files: (out) (element-type GFile) (transfer full): the files which
+ * were added, or changed and must be read again
+ *
+ * Compare the files of @changes, and the files in the directories of
+ * @changes, with @file_list, by modification time and size. Only the files
+ * which changed are to be read again, so that the others keep their undo
+ * history.
+ */
+void
+et_file_list_find_changes (GList *file_list,
+                           GFile *root,
+                           GPtrArray *changes,
+                           gboolean recurse,
+                           gboolean show_hidden,
+                           EtDirectoryWatch *watch,
+                           GList **removed_files,
+                           GList **added_files)
+{
+    EtFileListChanges state;
+    GList *l;
+    guint i;
+
+    g_return_if_fail (G_IS_FILE (root));
+    g_return_if_fail (changes != NULL);
+    g_return_if_fail (removed_files != NULL && added_files != NULL);
+
+    state.loaded = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                          NULL);
+    state.handled = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                           NULL);
+    state.removed = g_hash_table_new (NULL, NULL);
+    state.removed_files = NULL;
+    state.added_files = NULL;
+    state.recurse = recurse;
+    state.show_hidden = show_hidden;
+    state.watch = watch;
+
+    for (l = g_list_first (file_list); l != NULL; l = g_list_next (l))
+    {
+        ET_File *ETFile = (ET_File *)l->data;
+
+        g_hash_table_insert (state.loaded,
+                             et_file_name_get_path ((File_Name *)ETFile->FileNameCur->data),
+                             ETFile);
+    }
+
+    for (i = 0; i < changes->len; i++)
+    {
+        GFile *file = g_ptr_array_index (changes, i);
+        GFileInfo *info;
+
+        info = g_file_query_info (file, CHANGES_ATTRIBUTES,
+                                  G_FILE_QUERY_INFO_NONE, NULL, NULL);
+
+        if (info
+            && g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
+        {
+            /* Subdirectories are only read when loading recursively, but
+             * the loaded directory itself may be hidden. */
+            if (g_file_equal (file, root)
+                || (recurse
+                    && (show_hidden || !g_file_info_get_is_hidden (info))))
+            {
+                changes_read_directory (&state, file);
+            }
+
+            changes_remove_missing (&state, file);
+        }
+        else
+        {
+            changes_check_file (&state, file, info);
+
+            /* The file may have been a directory. */
+            if (info == NULL)
+            {
+                changes_remove_missing (&state, file);
+            }
+        }
+
+        g_clear_object (&info);
+    }
+
+    *removed_files = g_list_reverse (state.removed_files);
+    *added_files = g_list_reverse (state.added_files);
+
+    g_hash_table_destroy (state.removed);
+    g_hash_table_destroy (state.handled);
+    g_hash_table_destroy (state.loaded);
+}
@@ -0,0 +1,36 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ET_FILE_LIST_CHANGES_H_
+#define ET_FILE_LIST_CHANGES_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#include "directory_watch.h"
+#include "file.h"
+
+void et_file_list_find_changes (GList *file_list, GFile *root, GPtrArray *changes, gboolean recurse, gboolean show_hidden, EtDirectoryWatch *watch, GList **removed_files, GList **added_files);
+
+void et_history_file_free (ET_History_File *file);
+GList * et_history_list_remove_file (GList *history_list, const ET_File *ETFile);
+
+G_END_DECLS
+
+#endif /* !ET_FILE_LIST_CHANGES_H_ */
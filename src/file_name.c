@@ -23,6 +23,89 @@
 
 #include <string.h>
 
+/*
+ * EtFileNameDirectory:
+ * @ref_count: the number of filenames in the directory
+ * @path: the path of the directory, in the GLib filename encoding
+ * @path_utf8: the path of the directory, in UTF-8
+ * @path_ck: the collate key of @path_utf8
+ *
+ * A directory of one or more filenames. Each directory is stored once, in
+ * the directory table, so that the filenames only store their name, and a
+ * directory is renamed by updating it in the table.
+ */
+struct _EtFileNameDirectory
+{
+    gint ref_count;
+    gchar *path;
+    gchar *path_utf8;
+    gchar *path_ck;
+};
+
+/* The directories of the filenames, by path. Filenames are created by the
+ * batch mode from several threads, so the paths of the directories, which
+ * are replaced when renaming a directory, are only read with the mutex held. */
+static GHashTable *directories = NULL;
+static GMutex directories_mutex;
+
+static EtFileNameDirectory *
+directory_ref (const gchar *path,
+               const gchar *path_utf8)
+{
+    EtFileNameDirectory *directory;
+
+    g_mutex_lock (&directories_mutex);
+
+    if (directories == NULL)
+    {
+        directories = g_hash_table_new (g_str_hash, g_str_equal);
+    }
+
+    directory = g_hash_table_lookup (directories, path);
+
+    if (directory)
+    {
+        directory->ref_count++;
+    }
+    else
+    {
+        directory = g_slice_new (EtFileNameDirectory);
+        directory->ref_count = 1;
+        directory->path = g_strdup (path);
+        directory->path_utf8 = path_utf8 ? g_strdup (path_utf8)
+                                         : g_filename_display_name (path);
+        directory->path_ck = g_utf8_collate_key_for_filename (directory->path_utf8,
+                                                              -1);
+        g_hash_table_insert (directories, directory->path, directory);
+    }
+
+    g_mutex_unlock (&directories_mutex);
+
+    return directory;
+}
+
+static void
+directory_unref (EtFileNameDirectory *directory)
+{
+    g_mutex_lock (&directories_mutex);
+
+    if (--directory->ref_count == 0)
+    {
+        /* A renamed directory may have replaced this one in the table. */
+        if (g_hash_table_lookup (directories, directory->path) == directory)
+        {
+            g_hash_table_remove (directories, directory->path);
+        }
+
+        g_free (directory->path);
+        g_free (directory->path_utf8);
+        g_free (directory->path_ck);
+        g_slice_free (EtFileNameDirectory, directory);
+    }
+
+    g_mutex_unlock (&directories_mutex);
+}
+
 /*
  * Create a new File_Name structure
  */
@@ -34,13 +117,31 @@ et_file_name_new (void)
     file_name = g_slice_new (File_Name);
     file_name->key = et_undo_key_new ();
     file_name->saved = FALSE;
-    file_name->value = NULL;
-    file_name->value_utf8 = NULL;
-    file_name->value_ck = NULL;
+    file_name->directory = NULL;
+    file_name->name = NULL;
+    file_name->name_utf8 = NULL;
+    file_name->name_ck = NULL;
 
     return file_name;
 }
 
+static void
+et_file_name_clear (File_Name *file_name)
+{
+    if (file_name->directory)
+    {
+        directory_unref (file_name->directory);
+        file_name->directory = NULL;
+    }
+
+    g_free (file_name->name);
+    file_name->name = NULL;
+    g_free (file_name->name_utf8);
+    file_name->name_utf8 = NULL;
+    g_free (file_name->name_ck);
+    file_name->name_ck = NULL;
+}
+
 /*
  * Frees a File_Name item.
  */
@@ -49,12 +150,24 @@ et_file_name_free (File_Name *file_name)
 {
     g_return_if_fail (file_name != NULL);
 
-    g_free (file_name->value);
-    g_free (file_name->value_utf8);
-    g_free (file_name->value_ck);
+    et_file_name_clear (file_name);
     g_slice_free (File_Name, file_name);
 }
 
+static gboolean
+has_dir_separator (const gchar *filename)
+{
+    for (; *filename != '\0'; filename++)
+    {
+        if (G_IS_DIR_SEPARATOR (*filename))
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
 /*
  * Fill content of a FileName item according to the filename passed in argument (UTF-8 filename or not)
  * Calculate also the collate key.
@@ -65,26 +178,55 @@ ET_Set_Filename_File_Name_Item (File_Name *FileName,
                                 const gchar *filename_utf8,
                                 const gchar *filename)
 {
+    gchar *path;
+    gchar *path_utf8;
+
     g_return_if_fail (FileName != NULL);
 
     if (filename_utf8 && filename)
     {
-        FileName->value_utf8 = g_strdup (filename_utf8);
-        FileName->value = g_strdup (filename);
-        FileName->value_ck = g_utf8_collate_key_for_filename (FileName->value_utf8, -1);
+        path_utf8 = g_strdup (filename_utf8);
+        path = g_strdup (filename);
     }
     else if (filename_utf8)
     {
-        FileName->value_utf8 = g_strdup (filename_utf8);
-        FileName->value = filename_from_display (filename_utf8);
-        FileName->value_ck = g_utf8_collate_key_for_filename (FileName->value_utf8, -1);
+        path_utf8 = g_strdup (filename_utf8);
+        path = filename_from_display (filename_utf8);
     }
     else if (filename)
     {
-        FileName->value_utf8 = g_filename_display_name (filename);
-        FileName->value = g_strdup (filename);
-        FileName->value_ck = g_utf8_collate_key_for_filename (FileName->value_utf8, -1);
+        path_utf8 = g_filename_display_name (filename);
+        path = g_strdup (filename);
+    }
+    else
+    {
+        return;
+    }
+
+    et_file_name_clear (FileName);
+
+    if (has_dir_separator (path))
+    {
+        gchar *dirname = g_path_get_dirname (path);
+        gchar *dirname_utf8 = g_path_get_dirname (path_utf8);
+
+        FileName->directory = directory_ref (dirname, dirname_utf8);
+        FileName->name = g_path_get_basename (path);
+        FileName->name_utf8 = g_path_get_basename (path_utf8);
+
+        g_free (dirname_utf8);
+        g_free (dirname);
+        g_free (path_utf8);
+        g_free (path);
+    }
+    else
+    {
+        FileName->name = path;
+        FileName->name_utf8 = path_utf8;
     }
+
+    FileName->name_ck = g_utf8_collate_key_for_filename (FileName->name_utf8,
+                                                         -1);
 }
 
 gboolean
@@ -114,9 +256,7 @@ et_file_name_set_from_components (File_Name *file_name,
     }
     else
     {
-        file_name->value = NULL;
-        file_name->value_utf8 = NULL;
-        file_name->value_ck = NULL;
+        et_file_name_clear (file_name);
 
         return FALSE;
     }
@@ -131,31 +271,277 @@ gboolean
 et_file_name_detect_difference (const File_Name *a,
                                 const File_Name *b)
 {
-    const gchar *filename1_ck;
-    const gchar *filename2_ck;
-
     g_return_val_if_fail (a && b, FALSE);
 
     if (a && !b) return TRUE;
     if (!a && b) return TRUE;
 
     /* Both a and b are != NULL. */
-    if (!a->value && !b->value) return FALSE;
-    if (a->value && !b->value) return TRUE;
-    if (!a->value && b->value) return TRUE;
-
-    /* Compare collate keys (with FileName->value converted to UTF-8 as it
-     * contains raw data). */
-    filename1_ck = a->value_ck;
-    filename2_ck = b->value_ck;
+    if (!a->name && !b->name) return FALSE;
+    if (a->name && !b->name) return TRUE;
+    if (!a->name && b->name) return TRUE;
 
     /* Filename changed ? (we check path + file). */
-    if (strcmp (filename1_ck, filename2_ck) != 0)
+    return et_file_name_collate (a, b, TRUE) != 0;
+}
+
+/*
+ * et_file_name_collate:
+ * @a: a filename
+ * @b: a filename to compare with @a
+ * @case_sensitive: whether to compare the case of the collate keys
+ *
+ * Compare the collate keys of @a and @b, by directory and then by name, so
+ * that the files of a directory are sorted together.
+ *
+ * Returns: a negative value if @a sorts before @b, zero if they are the
+ * same, or a positive value if @a sorts after @b
+ */
+gint
+et_file_name_collate (const File_Name *a,
+                      const File_Name *b,
+                      gboolean case_sensitive)
+{
+    gint (*compare) (const gchar *, const gchar *);
+    gint result;
+
+    g_return_val_if_fail (a != NULL && b != NULL, 0);
+
+    compare = case_sensitive ? strcmp : strcasecmp;
+
+    if (a->directory != b->directory)
     {
-        return TRUE;
+        if (a->directory == NULL || b->directory == NULL)
+        {
+            return a->directory == NULL ? -1 : 1;
+        }
+
+        /* Compare collate keys (with the paths converted to UTF-8 as they
+         * contain raw data). */
+        g_mutex_lock (&directories_mutex);
+        result = compare (a->directory->path_ck, b->directory->path_ck);
+        g_mutex_unlock (&directories_mutex);
+
+        if (result != 0)
+        {
+            return result;
+        }
     }
-    else
+
+    return compare (a->name_ck ? a->name_ck : "", b->name_ck ? b->name_ck : "");
+}
+
+/*
+ * et_file_name_get_path:
+ * @file_name: a filename
+ *
+ * Get the full path of @file_name, in the GLib filename encoding.
+ *
+ * Returns: the newly-allocated path, or %NULL if @file_name is not set
+ */
+gchar *
+et_file_name_get_path (const File_Name *file_name)
+{
+    gchar *path;
+
+    g_return_val_if_fail (file_name != NULL, NULL);
+
+    if (file_name->directory == NULL)
     {
-        return FALSE;
+        return g_strdup (file_name->name);
+    }
+
+    g_mutex_lock (&directories_mutex);
+    path = g_build_filename (file_name->directory->path, file_name->name,
+                             NULL);
+    g_mutex_unlock (&directories_mutex);
+
+    return path;
+}
+
+/*
+ * et_file_name_get_path_utf8:
+ * @file_name: a filename
+ *
+ * Get the full path of @file_name, in UTF-8.
+ *
+ * Returns: the newly-allocated path, or %NULL if @file_name is not set
+ */
+gchar *
+et_file_name_get_path_utf8 (const File_Name *file_name)
+{
+    gchar *path_utf8;
+
+    g_return_val_if_fail (file_name != NULL, NULL);
+
+    if (file_name->directory == NULL)
+    {
+        return g_strdup (file_name->name_utf8);
+    }
+
+    g_mutex_lock (&directories_mutex);
+    path_utf8 = g_build_filename (file_name->directory->path_utf8,
+                                  file_name->name_utf8, NULL);
+    g_mutex_unlock (&directories_mutex);
+
+    return path_utf8;
+}
+
+/*
+ * et_file_name_get_dirname:
+ * @file_name: a filename
+ *
+ * Get the directory of @file_name, in the GLib filename encoding, as
+ * g_path_get_dirname() would. A copy is returned, as the directory may be
+ * renamed by et_file_name_rename_directory().
+ *
+ * Returns: the newly-allocated directory
+ */
+gchar *
+et_file_name_get_dirname (const File_Name *file_name)
+{
+    gchar *dirname;
+
+    g_return_val_if_fail (file_name != NULL, NULL);
+
+    if (file_name->directory == NULL)
+    {
+        return g_strdup (".");
     }
+
+    g_mutex_lock (&directories_mutex);
+    dirname = g_strdup (file_name->directory->path);
+    g_mutex_unlock (&directories_mutex);
+
+    return dirname;
+}
+
+/*
+ * et_file_name_get_dirname_utf8:
+ * @file_name: a filename
+ *
+ * Get the directory of @file_name, in UTF-8, as g_path_get_dirname() would.
+ *
+ * Returns: the newly-allocated directory
+ */
+gchar *
+et_file_name_get_dirname_utf8 (const File_Name *file_name)
+{
+    gchar *dirname_utf8;
+
+    g_return_val_if_fail (file_name != NULL, NULL);
+
+    if (file_name->directory == NULL)
+    {
+        return g_strdup (".");
+    }
+
+    g_mutex_lock (&directories_mutex);
+    dirname_utf8 = g_strdup (file_name->directory->path_utf8);
+    g_mutex_unlock (&directories_mutex);
+
+    return dirname_utf8;
+}
+
+static gchar *
+strip_dir_separators (const gchar *path)
+{
+    gchar *stripped;
+    gsize len;
+
+    stripped = g_strdup (path);
+    len = strlen (stripped);
+
+    /* Keep the root directory. */
+    while (len > 1 && G_IS_DIR_SEPARATOR (stripped[len - 1]))
+    {
+        stripped[--len] = '\0';
+    }
+
+    return stripped;
+}
+
+/*
+ * et_file_name_rename_directory:
+ * @old_path: the previous path of a directory
+ * @new_path: the new path of the directory
+ *
+ * Update the filenames in @old_path, and in its subdirectories, after
+ * renaming it to @new_path (for ex: "/mp3/old_path/file.mp3" to
+ * "/mp3/new_path/file.mp3"). Only the directories are updated, not each
+ * filename. Must be called from the main thread.
+ */
+void
+et_file_name_rename_directory (const gchar *old_path,
+                               const gchar *new_path)
+{
+    gchar *old_dir;
+    gchar *new_dir;
+    gchar *old_prefix;
+    gsize old_len;
+    GHashTableIter iter;
+    gpointer directory;
+    GList *renamed = NULL;
+    GList *l;
+
+    g_return_if_fail (!et_str_empty (old_path));
+    g_return_if_fail (!et_str_empty (new_path));
+
+    g_mutex_lock (&directories_mutex);
+
+    if (directories == NULL)
+    {
+        g_mutex_unlock (&directories_mutex);
+        return;
+    }
+
+    /* The directories are stored as g_path_get_dirname() returns them,
+     * without a trailing separator. */
+    old_dir = strip_dir_separators (old_path);
+    new_dir = strip_dir_separators (new_path);
+    old_len = strlen (old_dir);
+
+    /* Add '/' to end of path to avoid ambiguity between a directory and a
+     * filename... */
+    old_prefix = G_IS_DIR_SEPARATOR (old_dir[old_len - 1])
+                 ? g_strdup (old_dir)
+                 : g_strconcat (old_dir, G_DIR_SEPARATOR_S, NULL);
+
+    g_hash_table_iter_init (&iter, directories);
+
+    while (g_hash_table_iter_next (&iter, NULL, &directory))
+    {
+        const gchar *path = ((EtFileNameDirectory *)directory)->path;
+
+        if (strcmp (path, old_dir) == 0 || g_str_has_prefix (path, old_prefix))
+        {
+            renamed = g_list_prepend (renamed, directory);
+            g_hash_table_iter_steal (&iter);
+        }
+    }
+
+    for (l = renamed; l != NULL; l = g_list_next (l))
+    {
+        EtFileNameDirectory *dir = l->data;
+        gchar *path;
+
+        path = g_build_filename (new_dir, dir->path + old_len, NULL);
+        g_free (dir->path);
+        dir->path = path;
+        g_free (dir->path_utf8);
+        dir->path_utf8 = g_filename_display_name (dir->path);
+        g_free (dir->path_ck);
+        dir->path_ck = g_utf8_collate_key_for_filename (dir->path_utf8, -1);
+
+        /* A directory previously stored at the new path, such as for the
+         * undo history of a removed directory, is left out of the table. */
+        g_hash_table_replace (directories, dir->path, dir);
+    }
+
+    g_list_free (renamed);
+    g_free (old_prefix);
+    g_free (new_dir);
+    g_free (old_dir);
+
+    g_mutex_unlock (&directories_mutex);
 }
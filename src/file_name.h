@@ -23,6 +23,8 @@
 
 G_BEGIN_DECLS
 
+typedef struct _EtFileNameDirectory EtFileNameDirectory;
+
 /*
  * Description of each item of the FileNameList list
  */
@@ -30,9 +32,10 @@ typedef struct
 {
     guint key;
     gboolean saved; /* Set to TRUE if this filename had been saved */
-    gchar *value; /* The filename containing the full path and the extension of the file */
-    gchar *value_utf8; /* Same than "value", but converted to UTF-8 to avoid multiple call to the convertion function */
-    gchar *value_ck; /* Collate key of "value_utf8" to speed up comparison. */
+    EtFileNameDirectory *directory; /* The directory of the file, shared with the other filenames in it, or NULL if the filename has no directory */
+    gchar *name; /* The name of the file, with its extension */
+    gchar *name_utf8; /* Same than "name", but converted to UTF-8 to avoid multiple call to the convertion function */
+    gchar *name_ck; /* Collate key of "name_utf8" to speed up comparison. */
 } File_Name;
 
 File_Name * et_file_name_new (void);
@@ -40,6 +43,12 @@ void et_file_name_free (File_Name *file_name);
 void ET_Set_Filename_File_Name_Item (File_Name *FileName, const gchar *filename_utf8, const gchar *filename);
 gboolean et_file_name_set_from_components (File_Name *file_name, const gchar *new_name, const gchar *dir_name, gboolean replace_illegal);
 gboolean et_file_name_detect_difference (const File_Name *a, const File_Name *b);
+gint et_file_name_collate (const File_Name *a, const File_Name *b, gboolean case_sensitive);
+gchar * et_file_name_get_path (const File_Name *file_name);
+gchar * et_file_name_get_path_utf8 (const File_Name *file_name);
+gchar * et_file_name_get_dirname (const File_Name *file_name);
+gchar * et_file_name_get_dirname_utf8 (const File_Name *file_name);
+void et_file_name_rename_directory (const gchar *old_path, const gchar *new_path);
 
 G_END_DECLS
 
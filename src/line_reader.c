@@ -0,0 +1,235 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include "line_reader.h"
+
+#include <string.h>
+
+/* The initial size of the buffer, which grows for longer lines. */
+#define LINE_READER_BUFFER_SIZE 16384
+
+/*
+ * EtLineReader:
+ * @stream: the stream to read the lines from
+ * @buffer: the data read from @stream, which is not yet returned
+ * @size: the allocated size of @buffer
+ * @start: the offset of the next line in @buffer
+ * @end: the offset of the end of the data in @buffer
+ * @eof: whether the end of @stream was reached
+ * @skip_lf: whether the last line ended with a carriage return, so that a
+ * following line feed is part of the same line ending
+ *
+ * Reads the lines of a stream through a single buffer, without allocating
+ * each line.
+ */
+struct _EtLineReader
+{
+    GInputStream *stream;
+    gchar *buffer;
+    gsize size;
+    gsize start;
+    gsize end;
+    gboolean eof;
+    gboolean skip_lf;
+};
+
+/*
+ * et_line_reader_new:
+ * @stream: the stream to read the lines from
+ *
+ * Create a reader for the lines of @stream.
+ *
+ * Returns: a new #EtLineReader, free with et_line_reader_free()
+ */
+EtLineReader *
+et_line_reader_new (GInputStream *stream)
+{
+    EtLineReader *reader;
+
+    g_return_val_if_fail (G_IS_INPUT_STREAM (stream), NULL);
+
+    reader = g_slice_new0 (EtLineReader);
+    reader->stream = g_object_ref (stream);
+    reader->size = LINE_READER_BUFFER_SIZE;
+    reader->buffer = g_malloc (reader->size);
+
+    return reader;
+}
+
+/*
+ * et_line_reader_free:
+ * @reader: the reader to free
+ *
+ * Free @reader. The stream is not closed.
+ */
+void
+et_line_reader_free (EtLineReader *reader)
+{
+    g_return_if_fail (reader != NULL);
+
+    g_object_unref (reader->stream);
+    g_free (reader->buffer);
+    g_slice_free (EtLineReader, reader);
+}
+
+/*
+ * line_reader_fill:
+ * @reader: the reader to read more data into
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @error: a #GError to provide information on errors, or %NULL to ignore
+ *
+ * Move the data which is not yet returned to the start of the buffer, growing
+ * the buffer if it is full, and read more data after it. One byte is always
+ * kept free, for the nul terminator of the last line.
+ *
+ * Returns: %TRUE on success, %FALSE and with @error set on failure
+ */
+static gboolean
+line_reader_fill (EtLineReader *reader,
+                  GCancellable *cancellable,
+                  GError **error)
+{
+    gssize bytes_read;
+
+    if (reader->start > 0)
+    {
+        memmove (reader->buffer, reader->buffer + reader->start,
+                 reader->end - reader->start);
+        reader->end -= reader->start;
+        reader->start = 0;
+    }
+
+    if (reader->end + 1 >= reader->size)
+    {
+        reader->size *= 2;
+        reader->buffer = g_realloc (reader->buffer, reader->size);
+    }
+
+    bytes_read = g_input_stream_read (reader->stream,
+                                      reader->buffer + reader->end,
+                                      reader->size - reader->end - 1,
+                                      cancellable, error);
+
+    if (bytes_read < 0)
+    {
+        return FALSE;
+    }
+
+    if (bytes_read == 0)
+    {
+        reader->eof = TRUE;
+    }
+
+    reader->end += bytes_read;
+
+    return TRUE;
+}
+
+/*
+ * et_line_reader_next:
+ * @reader: the reader to read the next line from
+ * @length: (out) (allow-none): the length of the line, or %NULL
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @error: a #GError to provide information on errors, or %NULL to ignore
+ *
+ * Read the next line. Lines end with a line feed, a carriage return, or a
+ * carriage return followed by a line feed, which is not part of the returned
+ * line. No conversion is done on the contents of the line.
+ *
+ * Returns: (transfer none): the nul-terminated line, which is valid until the
+ * next call, or %NULL at the end of the stream or with @error set on failure
+ */
+const gchar *
+et_line_reader_next (EtLineReader *reader,
+                     gsize *length,
+                     GCancellable *cancellable,
+                     GError **error)
+{
+    gsize scanned = 0;
+    gchar *line;
+
+    g_return_val_if_fail (reader != NULL, NULL);
+    g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+    for (;;)
+    {
+        gsize i;
+
+        if (reader->skip_lf && reader->start < reader->end)
+        {
+            if (reader->buffer[reader->start] == '\n')
+            {
+                reader->start++;
+            }
+
+            reader->skip_lf = FALSE;
+        }
+
+        /* Only the data read since the last iteration needs scanning. */
+        for (i = reader->start + scanned; i < reader->end; i++)
+        {
+            if (reader->buffer[i] == '\n' || reader->buffer[i] == '\r')
+            {
+                reader->skip_lf = (reader->buffer[i] == '\r');
+                reader->buffer[i] = '\0';
+                line = reader->buffer + reader->start;
+
+                if (length)
+                {
+                    *length = i - reader->start;
+                }
+
+                reader->start = i + 1;
+
+                return line;
+            }
+        }
+
+        if (reader->eof)
+        {
+            break;
+        }
+
+        scanned = reader->end - reader->start;
+
+        if (!line_reader_fill (reader, cancellable, error))
+        {
+            return NULL;
+        }
+    }
+
+    /* The last line, without a line ending. */
+    if (reader->start == reader->end)
+    {
+        return NULL;
+    }
+
+    reader->buffer[reader->end] = '\0';
+    line = reader->buffer + reader->start;
+
+    if (length)
+    {
+        *length = reader->end - reader->start;
+    }
+
+    reader->start = reader->end;
+
+    return line;
+}
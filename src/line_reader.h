@@ -0,0 +1,34 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ET_LINE_READER_H_
+#define ET_LINE_READER_H_
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef struct _EtLineReader EtLineReader;
+
+EtLineReader * et_line_reader_new (GInputStream *stream);
+void et_line_reader_free (EtLineReader *reader);
+const gchar * et_line_reader_next (EtLineReader *reader, gsize *length, GCancellable *cancellable, GError **error);
+
+G_END_DECLS
+
+#endif /* !ET_LINE_READER_H_ */
@@ -27,6 +27,7 @@
 #include "browser.h"
 #include "charset.h"
 #include "easytag.h"
+#include "line_reader.h"
 #include "log.h"
 #include "misc.h"
 #include "picture.h"
@@ -66,6 +67,85 @@ enum
     LOAD_FILE_NAME_COUNT
 };
 
+/*
+ * EtLoadFilesPair:
+ * @ETFile: the file to rename
+ * @text: the line to generate the new name from, owned by the pair
+ *
+ * A file of priv->file_name_model, with the line of
+ * priv->file_content_model at the same position.
+ */
+typedef struct
+{
+    ET_File *ETFile;
+    gchar *text;
+} EtLoadFilesPair;
+
+static void
+load_files_pair_clear (EtLoadFilesPair *pair)
+{
+    g_free (pair->text);
+}
+
+/*
+ * pair_files_with_lines:
+ * @self: the load files dialog
+ *
+ * Walk the file names and the lines together, once, pairing each file with
+ * the line at the same position. Files without a line, or with an empty
+ * line, are left out.
+ *
+ * Returns: (element-type EtLoadFilesPair): the pairs, free with
+ * g_array_unref()
+ */
+static GArray *
+pair_files_with_lines (EtLoadFilesDialog *self)
+{
+    EtLoadFilesDialogPrivate *priv;
+    GtkTreeModel *name_model;
+    GtkTreeModel *content_model;
+    GtkTreeIter iter_name;
+    GtkTreeIter iter_content;
+    gboolean valid;
+    GArray *pairs;
+
+    priv = et_load_files_dialog_get_instance_private (self);
+
+    name_model = GTK_TREE_MODEL (priv->file_name_model);
+    content_model = GTK_TREE_MODEL (priv->file_content_model);
+    pairs = g_array_sized_new (FALSE, FALSE, sizeof (EtLoadFilesPair),
+                               gtk_tree_model_iter_n_children (name_model,
+                                                               NULL));
+    g_array_set_clear_func (pairs, (GDestroyNotify)load_files_pair_clear);
+
+    valid = gtk_tree_model_get_iter_first (name_model, &iter_name)
+            && gtk_tree_model_get_iter_first (content_model, &iter_content);
+
+    while (valid)
+    {
+        EtLoadFilesPair pair;
+
+        gtk_tree_model_get (name_model, &iter_name, LOAD_FILE_NAME_POINTER,
+                            &pair.ETFile, -1);
+        gtk_tree_model_get (content_model, &iter_content,
+                            LOAD_FILE_CONTENT_TEXT, &pair.text, -1);
+
+        if (pair.ETFile && !et_str_empty (pair.text))
+        {
+            g_array_append_val (pairs, pair);
+        }
+        else
+        {
+            g_free (pair.text);
+        }
+
+        valid = gtk_tree_model_iter_next (name_model, &iter_name)
+                && gtk_tree_model_iter_next (content_model, &iter_content);
+    }
+
+    return pairs;
+}
+
 /*
  * Set the new filename of each file.
  * Associate lines from priv->file_content_view with priv->file_name_view
@@ -74,16 +154,10 @@ static void
 Load_Filename_Set_Filenames (EtLoadFilesDialog *self)
 {
     EtLoadFilesDialogPrivate *priv;
-    gint row;
-    ET_File *ETFile = NULL;
-    File_Name *FileName;
-    gchar *list_text = NULL;
-    gint rowcount;
-    gboolean found;
-
-    GtkTreePath *currentPath = NULL;
-    GtkTreeIter iter_name;
-    GtkTreeIter iter_content;
+    GArray *pairs;
+    gboolean replace_illegal;
+    EtScanDialog *scan_dialog = NULL;
+    guint i;
 
     priv = et_load_files_dialog_get_instance_private (self);
 
@@ -92,67 +166,47 @@ Load_Filename_Set_Filenames (EtLoadFilesDialog *self)
 
     et_application_window_update_et_file_from_ui (ET_APPLICATION_WINDOW (MainWindow));
 
-    rowcount = MIN(gtk_tree_model_iter_n_children(GTK_TREE_MODEL(priv->file_name_model), NULL),
-                   gtk_tree_model_iter_n_children(GTK_TREE_MODEL(priv->file_content_model), NULL));
+    pairs = pair_files_with_lines (self);
+
+    /* Read the settings once, rather than for each file. */
+    replace_illegal = et_settings_get_snapshot ()->rename_replace_illegal_chars;
 
-    for (row=0; row < rowcount; row++)
+    /* Then run current scanner if requested. */
+    if (g_settings_get_boolean (MainSettings, "load-filenames-run-scanner"))
     {
-        if (row == 0)
-            currentPath = gtk_tree_path_new_first();
-        else
-            gtk_tree_path_next(currentPath);
+        scan_dialog = ET_SCAN_DIALOG (et_application_window_get_scan_dialog (ET_APPLICATION_WINDOW (MainWindow)));
+    }
 
-        found = gtk_tree_model_get_iter(GTK_TREE_MODEL(priv->file_name_model), &iter_name, currentPath);
-        if (found)
-            gtk_tree_model_get(GTK_TREE_MODEL(priv->file_name_model), &iter_name, 
-                               LOAD_FILE_NAME_POINTER, &ETFile, -1);
+    for (i = 0; i < pairs->len; i++)
+    {
+        const EtLoadFilesPair *pair;
+        File_Name *FileName;
+        gchar *filename_new_utf8;
 
-        found = gtk_tree_model_get_iter(GTK_TREE_MODEL(priv->file_content_model), &iter_content, currentPath);
-        if (found)
-            gtk_tree_model_get(GTK_TREE_MODEL(priv->file_content_model), &iter_content, 
-                               LOAD_FILE_CONTENT_TEXT, &list_text, -1);
+        pair = &g_array_index (pairs, EtLoadFilesPair, i);
 
-        if (ETFile && !et_str_empty (list_text))
-        {
-            gchar *list_text_tmp;
-            gchar *filename_new_utf8;
-
-            list_text_tmp = g_strdup(list_text);
-            et_filename_prepare (list_text_tmp,
-                                 g_settings_get_boolean (MainSettings,
-                                                         "rename-replace-illegal-chars"));
-
-            /* Build the filename with the path */
-            filename_new_utf8 = et_file_generate_name (ETFile, list_text_tmp);
-            g_free(list_text_tmp);
-
-            /* Set the new filename */
-            // Create a new 'File_Name' item
-            FileName = et_file_name_new ();
-            // Save changes of the 'File_Name' item
-            ET_Set_Filename_File_Name_Item(FileName,filename_new_utf8,NULL);
-            ET_Manage_Changes_Of_File_Data(ETFile,FileName,NULL);
-
-            g_free(filename_new_utf8);
-
-            /* Then run current scanner if requested. */
-            if (g_settings_get_boolean (MainSettings,
-                                        "load-filenames-run-scanner"))
-            {
-                EtScanDialog *dialog;
+        /* The text is owned by the pair, so it can be prepared in place. */
+        et_filename_prepare (pair->text, replace_illegal);
 
-                dialog = ET_SCAN_DIALOG (et_application_window_get_scan_dialog (ET_APPLICATION_WINDOW (MainWindow)));
+        /* Build the filename with the path */
+        filename_new_utf8 = et_file_generate_name (pair->ETFile, pair->text);
 
-                if (dialog)
-                {
-                    Scan_Select_Mode_And_Run_Scanner (dialog, ETFile);
-                }
-            }
+        /* Set the new filename */
+        // Create a new 'File_Name' item
+        FileName = et_file_name_new ();
+        // Save changes of the 'File_Name' item
+        ET_Set_Filename_File_Name_Item(FileName,filename_new_utf8,NULL);
+        ET_Manage_Changes_Of_File_Data (pair->ETFile, FileName, NULL);
+
+        g_free(filename_new_utf8);
+
+        if (scan_dialog)
+        {
+            Scan_Select_Mode_And_Run_Scanner (scan_dialog, pair->ETFile);
         }
-        g_free(list_text);
     }
 
-    gtk_tree_path_free(currentPath);
+    g_array_unref (pairs);
 
     et_application_window_browser_refresh_list (ET_APPLICATION_WINDOW (MainWindow));
     et_application_window_display_et_file (ET_APPLICATION_WINDOW (MainWindow),
@@ -248,12 +302,13 @@ Load_File_Content (G_GNUC_UNUSED GtkButton *button, gpointer user_data)
     EtLoadFilesDialogPrivate *priv;
     GFile *file;
     GFileInputStream *istream;
-    GDataInputStream *data;
+    EtLineReader *reader;
+    GtkTreeView *view;
     GError *error = NULL;
-    gsize size_read;
+    gsize length;
     gchar *path;
     gchar *display_path;
-    gchar *line;
+    const gchar *line;
     gchar *valid;
 
     priv = et_load_files_dialog_get_instance_private (ET_LOAD_FILES_DIALOG (user_data));
@@ -272,38 +327,52 @@ Load_File_Content (G_GNUC_UNUSED GtkButton *button, gpointer user_data)
         Log_Print (LOG_ERROR, _("Cannot open file ‘%s’: %s"), display_path,
                    error->message);
         g_error_free (error);
-        g_object_unref (file);
         g_free (display_path);
         return;
     }
 
     g_free (display_path);
-    data = g_data_input_stream_new (G_INPUT_STREAM (istream));
-    /* TODO: Find a safer alternative to _ANY. */
-    g_data_input_stream_set_newline_type (data,
-                                          G_DATA_STREAM_NEWLINE_TYPE_ANY);
+    reader = et_line_reader_new (G_INPUT_STREAM (istream));
+
+    /* Fill the model while it is detached from the view, so that the view is
+     * not updated for each line. */
+    view = GTK_TREE_VIEW (priv->file_content_view);
+    g_object_ref (priv->file_content_model);
+    gtk_tree_view_set_model (view, NULL);
     gtk_list_store_clear (priv->file_content_model);
 
-    while ((line = g_data_input_stream_read_line (data, &size_read, NULL,
-                                                  &error)))
+    while ((line = et_line_reader_next (reader, &length, NULL, &error)))
     {
         /* FIXME: This should use the GLib filename encoding, not UTF-8. */
-        valid = Try_To_Validate_Utf8_String (line);
-        g_free (line);
-
-        gtk_list_store_insert_with_values (priv->file_content_model, NULL,
-                                           G_MAXINT, LOAD_FILE_CONTENT_TEXT,
-                                           valid, -1);
-        g_free (valid);
+        if (g_utf8_validate (line, length, NULL))
+        {
+            gtk_list_store_insert_with_values (priv->file_content_model, NULL,
+                                               G_MAXINT,
+                                               LOAD_FILE_CONTENT_TEXT, line,
+                                               -1);
+        }
+        else
+        {
+            valid = Try_To_Validate_Utf8_String (line);
+            gtk_list_store_insert_with_values (priv->file_content_model, NULL,
+                                               G_MAXINT,
+                                               LOAD_FILE_CONTENT_TEXT, valid,
+                                               -1);
+            g_free (valid);
+        }
     }
 
+    gtk_tree_view_set_model (view,
+                             GTK_TREE_MODEL (priv->file_content_model));
+    g_object_unref (priv->file_content_model);
+
     if (error)
     {
         Log_Print (LOG_ERROR, _("Error reading file ‘%s’"), error->message);
         g_error_free (error);
     }
 
-    g_object_unref (data);
+    et_line_reader_free (reader);
     g_object_unref (istream);
 }
 
@@ -619,15 +688,20 @@ Load_File_List (EtLoadFilesDialog *self)
     ET_File *etfile;
     gchar *filename_utf8;
     gchar *pos;
+    GtkTreeView *view;
 
     priv = et_load_files_dialog_get_instance_private (self);
 
+    /* Fill the model while it is detached from the view. */
+    view = GTK_TREE_VIEW (priv->file_name_view);
+    g_object_ref (priv->file_name_model);
+    gtk_tree_view_set_model (view, NULL);
     gtk_list_store_clear(priv->file_name_model);
 
     for (l = ETCore->ETFileList; l != NULL; l = g_list_next (l))
     {
         etfile = (ET_File *)l->data;
-        filename_utf8 = g_path_get_basename(((File_Name *)etfile->FileNameNew->data)->value_utf8);
+        filename_utf8 = g_strdup (((File_Name *)etfile->FileNameNew->data)->name_utf8);
         // Remove the extension ('filename' must be allocated to don't affect the initial value)
         if ((pos=strrchr(filename_utf8,'.'))!=NULL)
             *pos = 0;
@@ -638,6 +712,9 @@ Load_File_List (EtLoadFilesDialog *self)
                                            -1);
         g_free(filename_utf8);
     }
+
+    gtk_tree_view_set_model (view, GTK_TREE_MODEL (priv->file_name_model));
+    g_object_unref (priv->file_name_model);
 }
 
 static void
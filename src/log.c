@@ -38,8 +38,19 @@ typedef struct
 
     /* Popup menu. */
     GtkWidget *menu;
+
+    /* Queue of EtLogEntry, waiting to be added to log_model. */
+    GQueue *pending;
+    guint flush_id;
 } EtLogAreaPrivate;
 
+typedef struct
+{
+    EtLogAreaKind kind;
+    gchar *time;
+    gchar *text;
+} EtLogEntry;
+
 G_DEFINE_TYPE_WITH_PRIVATE (EtLogArea, et_log_area, GTK_TYPE_BIN)
 
 enum
@@ -53,11 +64,30 @@ enum
 /* File for log. */
 static const gchar LOG_FILE[] = "easytag.log";
 
+/* Maximum number of messages kept in the log list. The oldest messages are
+ * removed when more are added. */
+#define LOG_MAX_ROWS 5000
+/* Interval, in milliseconds, at which queued messages are added to the log
+ * list. */
+#define LOG_FLUSH_INTERVAL 100
+/* Maximum time, in microseconds, that a message waits before being written
+ * to the log file, and the buffer size at which it is written at once. */
+#define LOG_WRITE_DELAY (G_USEC_PER_SEC / 2)
+#define LOG_WRITE_BUFFER_SIZE 65536
+
+/* State of the log file writer thread, protected by log_mutex. */
+static GMutex log_mutex;
+static GCond log_cond;
+static GString *log_buffer = NULL;
+static GThread *log_thread = NULL;
+static gboolean log_stopped = FALSE;
+
 /**************
  * Prototypes *
  **************/
 static void Log_List_Set_Row_Visible (EtLogArea *self, GtkTreeIter *rowIter);
 static gchar *Log_Format_Date (void);
+static const gchar *get_icon_name_from_error_kind (EtLogAreaKind error_kind);
 
 
 
@@ -119,11 +149,43 @@ on_button_press_event (GtkWidget *treeview,
 }
 
 
+static void
+et_log_entry_free (EtLogEntry *entry)
+{
+    g_free (entry->time);
+    g_free (entry->text);
+    g_slice_free (EtLogEntry, entry);
+}
+
+static void
+et_log_area_dispose (GObject *object)
+{
+    EtLogAreaPrivate *priv;
+
+    priv = et_log_area_get_instance_private (ET_LOG_AREA (object));
+
+    if (priv->flush_id != 0)
+    {
+        g_source_remove (priv->flush_id);
+        priv->flush_id = 0;
+    }
+
+    if (priv->pending)
+    {
+        g_queue_free_full (priv->pending, (GDestroyNotify)et_log_entry_free);
+        priv->pending = NULL;
+    }
+
+    G_OBJECT_CLASS (et_log_area_parent_class)->dispose (object);
+}
+
 static void
 et_log_area_class_init (EtLogAreaClass *klass)
 {
     GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
 
+    G_OBJECT_CLASS (klass)->dispose = et_log_area_dispose;
+
     gtk_widget_class_set_template_from_resource (widget_class,
                                                  "/org/gnome/EasyTAG/log_area.ui");
     gtk_widget_class_bind_template_child_private (widget_class, EtLogArea,
@@ -140,6 +202,7 @@ et_log_area_init (EtLogArea *self)
     GMenuModel *menu_model;
 
     priv = et_log_area_get_instance_private (self);
+    priv->pending = g_queue_new ();
 
     gtk_widget_init_template (GTK_WIDGET (self));
 
@@ -213,12 +276,83 @@ et_log_area_clear (EtLogArea *self)
 
     priv = et_log_area_get_instance_private (self);
 
+    if (priv->pending)
+    {
+        g_queue_foreach (priv->pending, (GFunc)et_log_entry_free, NULL);
+        g_queue_clear (priv->pending);
+    }
+
     if (priv->log_model)
     {
         gtk_list_store_clear (priv->log_model);
     }
 }
 
+/*
+ * et_log_area_flush:
+ * @user_data: the #EtLogArea
+ *
+ * Add the queued messages to the log list in one go, remove the oldest rows
+ * if the list holds more than LOG_MAX_ROWS, and scroll to the last message.
+ *
+ * Returns: %G_SOURCE_REMOVE
+ */
+static gboolean
+et_log_area_flush (gpointer user_data)
+{
+    EtLogArea *self;
+    EtLogAreaPrivate *priv;
+    EtLogEntry *entry;
+    GtkTreeModel *model;
+    GtkTreeIter iter;
+    gboolean inserted = FALSE;
+    gint n_rows;
+
+    self = ET_LOG_AREA (user_data);
+    priv = et_log_area_get_instance_private (self);
+    model = GTK_TREE_MODEL (priv->log_model);
+
+    priv->flush_id = 0;
+
+    /* Messages which would be removed straight away are not inserted. */
+    while (g_queue_get_length (priv->pending) > LOG_MAX_ROWS)
+    {
+        et_log_entry_free (g_queue_pop_head (priv->pending));
+    }
+
+    while ((entry = g_queue_pop_head (priv->pending)) != NULL)
+    {
+        gtk_list_store_insert_with_values (priv->log_model, &iter, G_MAXINT,
+                                           LOG_ICON_NAME,
+                                           get_icon_name_from_error_kind (entry->kind),
+                                           LOG_TIME_TEXT, entry->time,
+                                           LOG_TEXT, entry->text, -1);
+        et_log_entry_free (entry);
+        inserted = TRUE;
+    }
+
+    n_rows = gtk_tree_model_iter_n_children (model, NULL);
+
+    if (n_rows > LOG_MAX_ROWS)
+    {
+        GtkTreeIter first;
+
+        gtk_tree_model_get_iter_first (model, &first);
+
+        for (; n_rows > LOG_MAX_ROWS; n_rows--)
+        {
+            gtk_list_store_remove (priv->log_model, &first);
+        }
+    }
+
+    if (inserted)
+    {
+        Log_List_Set_Row_Visible (self, &iter);
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
 
 /*
  * Return time in allocated data
@@ -263,128 +397,284 @@ get_icon_name_from_error_kind (EtLogAreaKind error_kind)
 }
 
 /*
- * Function to use anywhere in the application to send a message to the LogList
+ * log_writer_open:
+ *
+ * Create the log file, replacing the log of the previous run, in the cache
+ * directory.
+ *
+ * Returns: an output stream for the log file, or %NULL on error
  */
-void
-Log_Print (EtLogAreaKind error_type, const gchar * const format, ...)
+static GOutputStream *
+log_writer_open (void)
 {
-    EtLogArea *self;
-    EtLogAreaPrivate *priv;
-    va_list args;
-    gchar *string;
-    gchar *time;
-    GtkTreeIter iter;
-    static gboolean first_time = TRUE;
-    static gchar *file_path = NULL;
+    gchar *cache_path;
+    gchar *file_path;
     GFile *file;
     GFileOutputStream *file_ostream;
     GError *error = NULL;
 
-    self = ET_LOG_AREA (et_application_window_get_log_area (ET_APPLICATION_WINDOW (MainWindow)));
+    cache_path = g_build_filename (g_get_user_cache_dir (), PACKAGE_TARNAME,
+                                   NULL);
 
-    g_return_if_fail (self != NULL);
+    if (!g_file_test (cache_path, G_FILE_TEST_IS_DIR))
+    {
+        gint result = g_mkdir_with_parents (cache_path, S_IRWXU);
 
-    priv = et_log_area_get_instance_private (self);
+        if (result == -1)
+        {
+            g_printerr ("%s", "Unable to create cache directory");
+            g_free (cache_path);
 
-    va_start (args, format);
-    string = g_strdup_vprintf (format, args);
-    va_end (args);
+            return NULL;
+        }
+    }
 
-    time = Log_Format_Date ();
+    file_path = g_build_filename (cache_path, LOG_FILE, NULL);
+    g_free (cache_path);
 
-    gtk_list_store_insert_with_values (priv->log_model, &iter, G_MAXINT,
-                                       LOG_ICON_NAME,
-                                       get_icon_name_from_error_kind (error_type),
-                                       LOG_TIME_TEXT, time, LOG_TEXT,
-                                       string, -1);
-    Log_List_Set_Row_Visible (self, &iter);
-    g_free (time);
+    file = g_file_new_for_path (file_path);
+    file_ostream = g_file_replace (file, NULL, FALSE, G_FILE_CREATE_NONE,
+                                   NULL, &error);
 
-    // Store also the messages in the log file.
-    if (!file_path)
+    if (!file_ostream)
+    {
+        /* To avoid recursion of Log_Print. */
+        g_warning ("Error opening output stream of file '%s' ('%s')",
+                   file_path, error->message);
+        g_error_free (error);
+    }
+
+    g_object_unref (file);
+    g_free (file_path);
+
+    return file_ostream ? G_OUTPUT_STREAM (file_ostream) : NULL;
+}
+
+/*
+ * log_writer_thread:
+ *
+ * Keep the log file open, and write the messages queued by Log_Print() to it
+ * in batches, until et_log_shutdown() is called.
+ */
+static gpointer
+log_writer_thread (gpointer user_data)
+{
+    GOutputStream *ostream;
+    GString *data;
+
+    ostream = log_writer_open ();
+    data = g_string_sized_new (LOG_WRITE_BUFFER_SIZE);
+
+    g_mutex_lock (&log_mutex);
+
+    for (;;)
     {
-        gchar *cache_path = g_build_filename (g_get_user_cache_dir (),
-                                              PACKAGE_TARNAME, NULL);
+        gboolean stopped;
+
+        while (log_buffer->len == 0 && !log_stopped)
+        {
+            g_cond_wait (&log_cond, &log_mutex);
+        }
 
-        if (!g_file_test (cache_path, G_FILE_TEST_IS_DIR))
+        /* Wait a little, so that a burst of messages is written at once. */
+        if (!log_stopped && log_buffer->len < LOG_WRITE_BUFFER_SIZE)
         {
-            gint result = g_mkdir_with_parents (cache_path, S_IRWXU);
+            gint64 end_time = g_get_monotonic_time () + LOG_WRITE_DELAY;
 
-            if (result == -1)
+            while (!log_stopped && log_buffer->len < LOG_WRITE_BUFFER_SIZE)
             {
-                g_printerr ("%s", "Unable to create cache directory");
-                g_free (cache_path);
-                g_free (string);
+                if (!g_cond_wait_until (&log_cond, &log_mutex, end_time))
+                {
+                    break;
+                }
+            }
+        }
+
+        /* Swap the buffers, so that the file is written without holding the
+         * lock. */
+        {
+            GString *tmp = data;
+            data = log_buffer;
+            log_buffer = tmp;
+        }
+
+        stopped = log_stopped;
+        g_mutex_unlock (&log_mutex);
 
-                return;
+        if (ostream && data->len > 0)
+        {
+            gsize bytes_written;
+            GError *error = NULL;
+
+            if (!g_output_stream_write_all (ostream, data->str, data->len,
+                                            &bytes_written, NULL, &error))
+            {
+                g_debug ("Only %" G_GSIZE_FORMAT " bytes out of %"
+                         G_GSIZE_FORMAT "bytes of data were written",
+                         bytes_written, data->len);
+
+                /* To avoid recursion of Log_Print. */
+                g_warning ("Error writing to the log file ('%s')",
+                           error->message);
+                g_error_free (error);
+
+                /* Do not try again for every following message. */
+                g_object_unref (ostream);
+                ostream = NULL;
             }
         }
 
-        file_path = g_build_filename (cache_path, LOG_FILE, NULL);
-        g_free (cache_path);
+        g_string_truncate (data, 0);
+
+        g_mutex_lock (&log_mutex);
+
+        if (stopped && log_buffer->len == 0)
+        {
+            break;
+        }
     }
 
-    file = g_file_new_for_path (file_path);
+    g_mutex_unlock (&log_mutex);
 
-    /* On startup, the log is cleared. The log is then appended to for the
-     * remainder of the application lifetime. */
-    if (first_time)
+    if (ostream)
     {
-        file_ostream = g_file_replace (file, NULL, FALSE, G_FILE_CREATE_NONE,
-                                       NULL, &error);
+        g_output_stream_close (ostream, NULL, NULL);
+        g_object_unref (ostream);
     }
-    else
+
+    g_string_free (data, TRUE);
+
+    return NULL;
+}
+
+/*
+ * log_writer_append:
+ * @time: the time of the message
+ * @string: the message
+ *
+ * Queue a message to be written to the log file by the writer thread, which
+ * is started for the first message.
+ */
+static void
+log_writer_append (const gchar *time,
+                   const gchar *string)
+{
+    gboolean was_empty;
+
+    g_mutex_lock (&log_mutex);
+
+    if (log_stopped)
     {
-        file_ostream = g_file_append_to (file, G_FILE_CREATE_NONE, NULL,
-                                         &error);
+        g_mutex_unlock (&log_mutex);
+        return;
     }
 
-    if (file_ostream)
+    if (!log_thread)
     {
-        GString *data;
-        gsize bytes_written;
+        log_buffer = g_string_sized_new (LOG_WRITE_BUFFER_SIZE);
+        log_thread = g_thread_new ("log writer", log_writer_thread, NULL);
+    }
+
+    was_empty = log_buffer->len == 0;
+
+    g_string_append (log_buffer, time);
+    g_string_append_c (log_buffer, ' ');
+    g_string_append (log_buffer, string);
+    g_string_append_c (log_buffer, '\n');
+
+    if (was_empty || log_buffer->len >= LOG_WRITE_BUFFER_SIZE)
+    {
+        g_cond_signal (&log_cond);
+    }
+
+    g_mutex_unlock (&log_mutex);
+}
+
+/*
+ * et_log_shutdown:
+ *
+ * Write the pending messages to the log file, and stop the log writer
+ * thread. Messages printed afterwards are only shown in the log list.
+ */
+void
+et_log_shutdown (void)
+{
+    GThread *thread;
+
+    g_mutex_lock (&log_mutex);
+    log_stopped = TRUE;
+    thread = log_thread;
+    log_thread = NULL;
+    g_cond_signal (&log_cond);
+    g_mutex_unlock (&log_mutex);
+
+    if (thread)
+    {
+        g_thread_join (thread);
+        g_string_free (log_buffer, TRUE);
+        log_buffer = NULL;
+    }
+}
+
+/*
+ * Function to use anywhere in the application to send a message to the LogList
+ *
+ * The message is queued, and added to the log list with the other messages
+ * printed during the same main loop iterations. It is written to the log
+ * file by a separate thread.
+ */
+void
+Log_Print (EtLogAreaKind error_type, const gchar * const format, ...)
+{
+    EtLogArea *self;
+    EtLogAreaPrivate *priv;
+    va_list args;
+    EtLogEntry *entry;
+
+    /* Without the main window, in batch mode, the messages are printed on
+     * standard error, as standard output is used for the results. */
+    if (!MainWindow)
+    {
+        gchar *time;
+        gchar *text;
+
+        va_start (args, format);
+        text = g_strdup_vprintf (format, args);
+        va_end (args);
 
         time = Log_Format_Date ();
-        data = g_string_new (time);
+        g_printerr ("%s %s\n", time, text);
+        log_writer_append (time, text);
+
         g_free (time);
+        g_free (text);
+        return;
+    }
 
-        data = g_string_append_c (data, ' ');
-        data = g_string_append (data, string);
-        g_free (string);
+    self = ET_LOG_AREA (et_application_window_get_log_area (ET_APPLICATION_WINDOW (MainWindow)));
 
-        data = g_string_append_c (data, '\n');
+    g_return_if_fail (self != NULL);
 
-        if (!g_output_stream_write_all (G_OUTPUT_STREAM (file_ostream),
-                                        data->str, data->len, &bytes_written,
-                                        NULL, &error))
-        {
-            g_debug ("Only %" G_GSIZE_FORMAT " bytes out of %" G_GSIZE_FORMAT
-                     "bytes of data were written", bytes_written, data->len);
+    priv = et_log_area_get_instance_private (self);
 
-            /* To avoid recursion of Log_Print. */
-            g_warning ("Error writing to the log file '%s' ('%s')", file_path,
-                       error->message);
+    entry = g_slice_new (EtLogEntry);
+    entry->kind = error_type;
 
-            g_error_free (error);
+    va_start (args, format);
+    entry->text = g_strdup_vprintf (format, args);
+    va_end (args);
 
-            g_string_free (data, TRUE);
-            g_object_unref (file_ostream);
-            g_object_unref (file);
+    entry->time = Log_Format_Date ();
 
-            return;
-        }
+    // Store also the messages in the log file.
+    log_writer_append (entry->time, entry->text);
 
-        first_time = FALSE;
+    g_queue_push_tail (priv->pending, entry);
 
-        g_string_free (data, TRUE);
-    }
-    else
+    if (priv->flush_id == 0)
     {
-        g_warning ("Error opening output stream of file '%s' ('%s')",
-                   file_path, error->message);
-        g_error_free (error);
+        priv->flush_id = g_timeout_add (LOG_FLUSH_INTERVAL, et_log_area_flush,
+                                        self);
+        g_source_set_name_by_id (priv->flush_id, "Log flush timer");
     }
-
-    g_object_unref (file_ostream);
-    g_object_unref (file);
 }
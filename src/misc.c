@@ -338,11 +338,10 @@ gchar *Convert_Duration (gulong duration)
 gchar *
 et_disc_number_to_string (const guint disc_number)
 {
-    if (g_settings_get_boolean (MainSettings, "tag-disc-padded"))
+    if (et_settings_get_snapshot ()->tag_disc_padded)
     {
         return g_strdup_printf ("%.*u",
-                                (gint)g_settings_get_uint (MainSettings,
-                                                           "tag-disc-length"),
+                                (gint)et_settings_get_snapshot ()->tag_disc_length,
                                 disc_number);
     }
 
@@ -352,11 +351,10 @@ et_disc_number_to_string (const guint disc_number)
 gchar *
 et_track_number_to_string (const guint track_number)
 {
-    if (g_settings_get_boolean (MainSettings, "tag-number-padded"))
+    if (et_settings_get_snapshot ()->tag_number_padded)
     {
         return g_strdup_printf ("%.*u",
-                                (gint)g_settings_get_uint (MainSettings,
-                                                           "tag-number-length"),
+                                (gint)et_settings_get_snapshot ()->tag_number_length,
                                 track_number);
     }
     else
@@ -565,12 +563,12 @@ et_filename_prepare (gchar *filename_utf8,
     }
 }
 
-/* Key for Undo */
+/* Key for Undo. Atomic, as files may be loaded from several threads. */
 guint
 et_undo_key_new (void)
 {
-    static guint ETUndoKey = 0;
-    return ++ETUndoKey;
+    static gint ETUndoKey = 0;
+    return g_atomic_int_add (&ETUndoKey, 1) + 1;
 }
 
 /*
@@ -33,6 +33,151 @@
 
 G_DEFINE_BOXED_TYPE (EtPicture, et_picture, et_picture_copy_single, et_picture_free)
 
+/*
+ * EtPictureData:
+ * @ref_count: the number of pictures with the image data
+ * @hash: the hash of the contents of @bytes
+ * @bytes: the image data
+ *
+ * Image data shared by all pictures with the same contents. Albums usually
+ * embed the same cover in every track, which is then stored once, in the
+ * picture data table, however many files were read.
+ */
+typedef struct
+{
+    guint ref_count;
+    guint hash;
+    GBytes *bytes;
+} EtPictureData;
+
+/* The image data of the pictures, by contents and by #GBytes. Pictures are
+ * read by the batch mode from several threads. */
+static GHashTable *picture_data = NULL;
+static GHashTable *picture_data_by_bytes = NULL;
+static GMutex picture_data_mutex;
+
+/* FNV-1a, a word at a time, as the image data is often several hundred
+ * kilobytes. */
+static guint
+picture_data_hash_bytes (GBytes *bytes)
+{
+    const guchar *data;
+    gsize size;
+    gsize i;
+    guint32 hash;
+    guint32 word;
+
+    data = g_bytes_get_data (bytes, &size);
+    hash = 2166136261U ^ (guint32)size;
+
+    for (i = 0; i + sizeof (word) <= size; i += sizeof (word))
+    {
+        memcpy (&word, data + i, sizeof (word));
+        hash = (hash ^ word) * 16777619U;
+    }
+
+    for (; i < size; i++)
+    {
+        hash = (hash ^ data[i]) * 16777619U;
+    }
+
+    return hash;
+}
+
+static guint
+picture_data_hash (gconstpointer key)
+{
+    return ((const EtPictureData *)key)->hash;
+}
+
+static gboolean
+picture_data_equal (gconstpointer a,
+                    gconstpointer b)
+{
+    const EtPictureData *data_a = a;
+    const EtPictureData *data_b = b;
+
+    return data_a->hash == data_b->hash
+           && g_bytes_equal (data_a->bytes, data_b->bytes);
+}
+
+/*
+ * picture_data_ref:
+ * @bytes: image data
+ *
+ * Look up image data with the same contents as @bytes in the picture data
+ * table, adding @bytes if there is none.
+ *
+ * Returns: (transfer full): the shared image data, release with
+ * picture_data_unref()
+ */
+static GBytes *
+picture_data_ref (GBytes *bytes)
+{
+    EtPictureData *data;
+
+    g_mutex_lock (&picture_data_mutex);
+
+    if (picture_data == NULL)
+    {
+        picture_data = g_hash_table_new (picture_data_hash,
+                                         picture_data_equal);
+        picture_data_by_bytes = g_hash_table_new (g_direct_hash,
+                                                  g_direct_equal);
+    }
+
+    /* Copies of a picture avoid hashing the image data again. */
+    data = g_hash_table_lookup (picture_data_by_bytes, bytes);
+
+    if (data == NULL)
+    {
+        EtPictureData key;
+
+        key.hash = picture_data_hash_bytes (bytes);
+        key.bytes = bytes;
+        data = g_hash_table_lookup (picture_data, &key);
+
+        if (data == NULL)
+        {
+            data = g_slice_new (EtPictureData);
+            data->ref_count = 0;
+            data->hash = key.hash;
+            data->bytes = g_bytes_ref (bytes);
+            g_hash_table_add (picture_data, data);
+            g_hash_table_insert (picture_data_by_bytes, data->bytes, data);
+        }
+    }
+
+    data->ref_count++;
+    bytes = g_bytes_ref (data->bytes);
+
+    g_mutex_unlock (&picture_data_mutex);
+
+    return bytes;
+}
+
+static void
+picture_data_unref (GBytes *bytes)
+{
+    EtPictureData *data;
+
+    g_mutex_lock (&picture_data_mutex);
+
+    data = g_hash_table_lookup (picture_data_by_bytes, bytes);
+
+    if (data && --data->ref_count == 0)
+    {
+        g_hash_table_remove (picture_data, data);
+        g_hash_table_remove (picture_data_by_bytes, data->bytes);
+        g_bytes_unref (data->bytes);
+        g_slice_free (EtPictureData, data);
+    }
+
+    g_mutex_unlock (&picture_data_mutex);
+
+    g_bytes_unref (bytes);
+}
+
 /*
  * Note :
  * -> MP4_TAG :
@@ -265,7 +410,8 @@ et_picture_detect_difference (const EtPicture *a,
         return TRUE;
     }
 
-    if (!g_bytes_equal (a->bytes, b->bytes))
+    /* The image data is shared between pictures with the same contents. */
+    if (a->bytes != b->bytes)
     {
         return TRUE;
     }
@@ -319,7 +465,8 @@ et_picture_format_info (const EtPicture *pic,
  * @bytes: image data
  *
  * Create a new #EtPicture instance, copying the string and adding a reference
- * to the image data.
+ * to the image data. The image data is shared with any other picture with the
+ * same contents, so @bytes may not be the image data of the new picture.
  *
  * Returns: a new #EtPicture, or %NULL on failure
  */
@@ -341,12 +488,63 @@ et_picture_new (EtPictureType type,
     pic->description = g_strdup (description);
     pic->width = width;
     pic->height = height;
-    pic->bytes = g_bytes_ref (bytes);
+    pic->bytes = picture_data_ref (bytes);
     pic->next = NULL;
 
     return pic;
 }
 
+/*
+ * et_picture_get_hash:
+ * @pic: the picture
+ *
+ * Get the hash of the contents of the image data of @pic, which is computed
+ * once for all the pictures with the same image data.
+ *
+ * Returns: the hash of the image data
+ */
+guint
+et_picture_get_hash (const EtPicture *pic)
+{
+    EtPictureData *data;
+    guint hash;
+
+    g_return_val_if_fail (pic != NULL, 0);
+
+    g_mutex_lock (&picture_data_mutex);
+
+    data = picture_data_by_bytes ? g_hash_table_lookup (picture_data_by_bytes,
+                                                        pic->bytes)
+                                 : NULL;
+    hash = data ? data->hash : picture_data_hash_bytes (pic->bytes);
+
+    g_mutex_unlock (&picture_data_mutex);
+
+    return hash;
+}
+
+/*
+ * et_picture_set_bytes:
+ * @pic: the picture
+ * @bytes: the new image data
+ *
+ * Replace the image data of @pic, such as after converting it to another
+ * image format.
+ */
+void
+et_picture_set_bytes (EtPicture *pic,
+                      GBytes *bytes)
+{
+    GBytes *old_bytes;
+
+    g_return_if_fail (pic != NULL);
+    g_return_if_fail (bytes != NULL);
+
+    old_bytes = pic->bytes;
+    pic->bytes = picture_data_ref (bytes);
+    picture_data_unref (old_bytes);
+}
+
 EtPicture *
 et_picture_copy_single (const EtPicture *pic)
 {
@@ -387,7 +585,7 @@ et_picture_free (EtPicture *pic)
     }
 
     g_free (pic->description);
-    g_bytes_unref (pic->bytes);
+    picture_data_unref (pic->bytes);
     pic->bytes = NULL;
 
     g_slice_free (EtPicture, pic);
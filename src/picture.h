@@ -62,7 +62,7 @@ typedef enum // Picture types
  * @description: string to describe the image, often a suitable filename
  * @width: original width, or 0 if unknown
  * @height: original height, or 0 if unknown
- * @bytes: image data
+ * @bytes: image data, shared between pictures with the same contents
  * @next: next image data in the list, or %NULL
  */
 typedef struct _EtPicture EtPicture;
@@ -86,6 +86,8 @@ typedef enum
 
 GType et_picture_get_type (void);
 EtPicture * et_picture_new (EtPictureType type, const gchar *description, guint width, guint height, GBytes *bytes);
+void et_picture_set_bytes (EtPicture *pic, GBytes *bytes);
+guint et_picture_get_hash (const EtPicture *pic);
 EtPicture * et_picture_copy_single (const EtPicture *pic);
 EtPicture * et_picture_copy_all (const EtPicture *pic);
 void et_picture_free (EtPicture *pic);
@@ -0,0 +1,495 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include "playlist.h"
+
+#include <string.h>
+
+/* The size of the buffer in which the lines of a playlist are gathered,
+ * before being written to the file. */
+#define PLAYLIST_BUFFER_SIZE 65536
+
+/*
+ * EtPlaylistEntry:
+ * @filename: the path of the file, in the GLib filename encoding
+ * @duration: the duration of the file, in seconds
+ * @title: the title to write in an extended playlist, or %NULL
+ */
+typedef struct
+{
+    gchar *filename;
+    gint duration;
+    gchar *title;
+} EtPlaylistEntry;
+
+/*
+ * EtPlaylist:
+ * @file: the file to write the playlist to, or %NULL
+ * @flags: how to write the playlist
+ * @entries: the #EtPlaylistEntry of the files of the playlist
+ * @error: the error when the playlist was last written, or %NULL
+ *
+ * A playlist, which is filled from the UI and can then be written from
+ * another thread, as it holds copies of everything needed to write it.
+ */
+struct _EtPlaylist
+{
+    GFile *file;
+    EtPlaylistFlags flags;
+    GArray *entries;
+    GError *error;
+};
+
+static void
+playlist_entry_clear (EtPlaylistEntry *entry)
+{
+    g_free (entry->filename);
+    g_free (entry->title);
+}
+
+/*
+ * et_playlist_new:
+ * @flags: how to write the playlist
+ *
+ * Create a new, empty, playlist.
+ *
+ * Returns: a new #EtPlaylist, free with et_playlist_free()
+ */
+EtPlaylist *
+et_playlist_new (EtPlaylistFlags flags)
+{
+    EtPlaylist *playlist;
+
+    playlist = g_slice_new0 (EtPlaylist);
+    playlist->flags = flags;
+    playlist->entries = g_array_new (FALSE, FALSE, sizeof (EtPlaylistEntry));
+    g_array_set_clear_func (playlist->entries,
+                            (GDestroyNotify)playlist_entry_clear);
+
+    return playlist;
+}
+
+/*
+ * et_playlist_free:
+ * @playlist: the playlist to free
+ *
+ * Free @playlist and its files.
+ */
+void
+et_playlist_free (EtPlaylist *playlist)
+{
+    g_return_if_fail (playlist != NULL);
+
+    g_clear_object (&playlist->file);
+    g_array_free (playlist->entries, TRUE);
+    g_clear_error (&playlist->error);
+    g_slice_free (EtPlaylist, playlist);
+}
+
+/*
+ * et_playlist_set_file:
+ * @playlist: the playlist to set the file of
+ * @file: the file to write @playlist to
+ *
+ * Set the file to write @playlist to, which may be decided once all the
+ * files of the playlist are known.
+ */
+void
+et_playlist_set_file (EtPlaylist *playlist,
+                      GFile *file)
+{
+    g_return_if_fail (playlist != NULL);
+    g_return_if_fail (G_IS_FILE (file));
+
+    g_object_ref (file);
+    g_clear_object (&playlist->file);
+    playlist->file = file;
+}
+
+/*
+ * et_playlist_get_file:
+ * @playlist: the playlist to get the file of
+ *
+ * Returns: (transfer none): the file to write @playlist to, or %NULL if it
+ * was not set
+ */
+GFile *
+et_playlist_get_file (const EtPlaylist *playlist)
+{
+    g_return_val_if_fail (playlist != NULL, NULL);
+
+    return playlist->file;
+}
+
+/*
+ * et_playlist_add:
+ * @playlist: the playlist to add a file to
+ * @filename: the path of the file, in the GLib filename encoding
+ * @duration: the duration of the file, in seconds
+ * @title: (allow-none): the title of the file, in the GLib filename
+ * encoding, or %NULL
+ *
+ * Add a file at the end of @playlist. The title is only written to extended
+ * playlists.
+ */
+void
+et_playlist_add (EtPlaylist *playlist,
+                 const gchar *filename,
+                 gint duration,
+                 const gchar *title)
+{
+    EtPlaylistEntry entry;
+
+    g_return_if_fail (playlist != NULL);
+    g_return_if_fail (filename != NULL);
+
+    entry.filename = g_strdup (filename);
+    entry.duration = duration;
+    entry.title = g_strdup (title);
+    g_array_append_val (playlist->entries, entry);
+}
+
+/*
+ * et_playlist_get_length:
+ * @playlist: the playlist to count the files of
+ *
+ * Returns: the number of files added to @playlist
+ */
+guint
+et_playlist_get_length (const EtPlaylist *playlist)
+{
+    g_return_val_if_fail (playlist != NULL, 0);
+
+    return playlist->entries->len;
+}
+
+/*
+ * et_playlist_get_error:
+ * @playlist: the playlist to get the error of
+ *
+ * Get the error which occurred when @playlist was written by
+ * et_playlist_write_all_async().
+ *
+ * Returns: (transfer none): the error, or %NULL if @playlist was written
+ */
+const GError *
+et_playlist_get_error (const EtPlaylist *playlist)
+{
+    g_return_val_if_fail (playlist != NULL, NULL);
+
+    return playlist->error;
+}
+
+/*
+ * Get the path to write for @filename, or %NULL if it is outside of
+ * @basedir.
+ */
+static const gchar *
+playlist_get_relative_path (const gchar *filename,
+                            const gchar *basedir,
+                            gsize basedir_len)
+{
+    if (strncmp (filename, basedir, basedir_len) != 0)
+    {
+        return NULL;
+    }
+
+    /* Keep only files in this directory and sub-dirs. */
+    if (basedir_len > 0 && basedir[basedir_len - 1] == G_DIR_SEPARATOR)
+    {
+        return filename + basedir_len;
+    }
+    else if (filename[basedir_len] == G_DIR_SEPARATOR)
+    {
+        return filename + basedir_len + 1;
+    }
+
+    return NULL;
+}
+
+/*
+ * et_playlist_write:
+ * @playlist: the playlist to write
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @error: a #GError to provide information on errors, or %NULL to ignore
+ *
+ * Write @playlist to its file, as M3U. The paths and titles are written in
+ * the filename encoding, rather than in UTF-8.
+ *
+ * Returns: %TRUE if the playlist was written, %FALSE otherwise
+ */
+gboolean
+et_playlist_write (EtPlaylist *playlist,
+                   GCancellable *cancellable,
+                   GError **error)
+{
+    GFileOutputStream *ostream;
+    GOutputStream *stream;
+    GString *line;
+    gchar *basedir = NULL;
+    gsize basedir_len = 0;
+    guint i;
+    gboolean result = FALSE;
+
+    g_return_val_if_fail (playlist != NULL, FALSE);
+    g_return_val_if_fail (playlist->file != NULL, FALSE);
+    g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+    ostream = g_file_replace (playlist->file, NULL, FALSE, G_FILE_CREATE_NONE,
+                              cancellable, error);
+
+    if (!ostream)
+    {
+        g_assert (error == NULL || *error != NULL);
+        return FALSE;
+    }
+
+    /* Gather the lines, rather than writing each of them to the file. */
+    stream = g_buffered_output_stream_new_sized (G_OUTPUT_STREAM (ostream),
+                                                 PLAYLIST_BUFFER_SIZE);
+    g_object_unref (ostream);
+
+    /* 'base directory' where is located the playlist. Used also to write file
+     * with a relative path for file located in this directory and
+     * sub-directories. */
+    if (playlist->flags & ET_PLAYLIST_RELATIVE)
+    {
+        GFile *parent;
+
+        parent = g_file_get_parent (playlist->file);
+        basedir = g_file_get_path (parent);
+        basedir_len = strlen (basedir);
+        g_object_unref (parent);
+    }
+
+    line = g_string_sized_new (256);
+
+    /* 1) First line of the file (if playlist content is not set to "write
+     * only list of files") */
+    if (playlist->flags & ET_PLAYLIST_EXTENDED)
+    {
+        g_string_append (line, "#EXTM3U\r\n");
+    }
+
+    for (i = 0; i < playlist->entries->len; i++)
+    {
+        const EtPlaylistEntry *entry = &g_array_index (playlist->entries,
+                                                       EtPlaylistEntry, i);
+        const gchar *path = entry->filename;
+        gsize path_start;
+
+        if (basedir)
+        {
+            path = playlist_get_relative_path (path, basedir, basedir_len);
+
+            if (path == NULL)
+            {
+                continue;
+            }
+        }
+
+        /* 2) Write the header. */
+        if ((playlist->flags & ET_PLAYLIST_EXTENDED) && entry->title)
+        {
+            g_string_append_printf (line, "#EXTINF:%d,%s\r\n",
+                                    entry->duration, entry->title);
+        }
+
+        /* 3) Write the file path. */
+        path_start = line->len;
+        g_string_append (line, path);
+
+        if (playlist->flags & ET_PLAYLIST_DOS_SEPARATOR)
+        {
+            gchar *c;
+
+            for (c = line->str + path_start; *c != '\0'; c++)
+            {
+                if (*c == '/')
+                {
+                    *c = '\\';
+                }
+            }
+        }
+
+        g_string_append (line, "\r\n");
+
+        if (!g_output_stream_write_all (stream, line->str, line->len, NULL,
+                                        cancellable, error))
+        {
+            goto out;
+        }
+
+        g_string_truncate (line, 0);
+    }
+
+    /* Only the header was left, for an empty playlist. */
+    if (line->len > 0
+        && !g_output_stream_write_all (stream, line->str, line->len, NULL,
+                                       cancellable, error))
+    {
+        goto out;
+    }
+
+    /* Flush the buffer, and close the file. */
+    result = g_output_stream_close (stream, cancellable, error);
+
+out:
+    g_assert (result || error == NULL || *error != NULL);
+    g_string_free (line, TRUE);
+    g_free (basedir);
+    g_object_unref (stream);
+
+    return result;
+}
+
+/*
+ * EtPlaylistWriteData:
+ * @playlists: the #EtPlaylist to write
+ * @n_written: the number of playlists which were written
+ */
+typedef struct
+{
+    GPtrArray *playlists;
+    guint n_written;
+} EtPlaylistWriteData;
+
+static void
+playlist_write_data_free (EtPlaylistWriteData *data)
+{
+    g_ptr_array_unref (data->playlists);
+    g_slice_free (EtPlaylistWriteData, data);
+}
+
+static void
+write_all_thread (GTask *task,
+                  gpointer source_object,
+                  gpointer task_data,
+                  GCancellable *cancellable)
+{
+    EtPlaylistWriteData *data = task_data;
+    const GError *first_error = NULL;
+    guint i;
+
+    for (i = 0; i < data->playlists->len; i++)
+    {
+        EtPlaylist *playlist = g_ptr_array_index (data->playlists, i);
+
+        if (g_task_return_error_if_cancelled (task))
+        {
+            return;
+        }
+
+        g_clear_error (&playlist->error);
+
+        if (et_playlist_write (playlist, cancellable, &playlist->error))
+        {
+            data->n_written++;
+        }
+        else if (first_error == NULL)
+        {
+            first_error = playlist->error;
+        }
+    }
+
+    if (g_task_return_error_if_cancelled (task))
+    {
+        return;
+    }
+
+    if (first_error)
+    {
+        g_task_return_error (task, g_error_copy (first_error));
+    }
+    else
+    {
+        g_task_return_boolean (task, TRUE);
+    }
+}
+
+/*
+ * et_playlist_write_all_async:
+ * @playlists: (element-type EtPlaylist): the playlists to write
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @callback: called when all the playlists were written
+ * @user_data: user data for @callback
+ *
+ * Write each of @playlists to its file, in a thread. A playlist which cannot
+ * be written does not stop the others, and its error is kept, to get with
+ * et_playlist_get_error(). The playlists must not be changed until @callback
+ * is called, from which et_playlist_write_all_finish() should be called.
+ */
+void
+et_playlist_write_all_async (GPtrArray *playlists,
+                             GCancellable *cancellable,
+                             GAsyncReadyCallback callback,
+                             gpointer user_data)
+{
+    GTask *task;
+    EtPlaylistWriteData *data;
+
+    g_return_if_fail (playlists != NULL);
+
+    data = g_slice_new (EtPlaylistWriteData);
+    data->playlists = g_ptr_array_ref (playlists);
+    data->n_written = 0;
+
+    task = g_task_new (NULL, cancellable, callback, user_data);
+    g_task_set_source_tag (task, et_playlist_write_all_async);
+    g_task_set_task_data (task, data,
+                          (GDestroyNotify)playlist_write_data_free);
+    g_task_run_in_thread (task, write_all_thread);
+    g_object_unref (task);
+}
+
+/*
+ * et_playlist_write_all_finish:
+ * @result: the result passed to the callback
+ * @n_written: (out) (allow-none): return location for the number of
+ * playlists which were written, or %NULL
+ * @error: a #GError, or %NULL
+ *
+ * Finish writing playlists.
+ *
+ * Returns: %TRUE if all the playlists were written, %FALSE with @error set
+ * to the error of the first playlist which could not be written, or if
+ * writing was cancelled
+ */
+gboolean
+et_playlist_write_all_finish (GAsyncResult *result,
+                              guint *n_written,
+                              GError **error)
+{
+    EtPlaylistWriteData *data;
+
+    g_return_val_if_fail (g_task_is_valid (result, NULL), FALSE);
+    g_return_val_if_fail (g_async_result_is_tagged (result,
+                                                    et_playlist_write_all_async),
+                          FALSE);
+
+    data = g_task_get_task_data (G_TASK (result));
+
+    if (n_written)
+    {
+        *n_written = data->n_written;
+    }
+
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
@@ -0,0 +1,59 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ET_PLAYLIST_H_
+#define ET_PLAYLIST_H_
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/*
+ * EtPlaylistFlags:
+ * @ET_PLAYLIST_EXTENDED: write an extended M3U playlist, with the duration
+ * and title of each file
+ * @ET_PLAYLIST_RELATIVE: write the paths relative to the directory of the
+ * playlist, leaving out the files outside of it
+ * @ET_PLAYLIST_DOS_SEPARATOR: use backslash as the directory separator
+ *
+ * How to write a playlist.
+ */
+typedef enum
+{
+    ET_PLAYLIST_EXTENDED = 1 << 0,
+    ET_PLAYLIST_RELATIVE = 1 << 1,
+    ET_PLAYLIST_DOS_SEPARATOR = 1 << 2
+} EtPlaylistFlags;
+
+typedef struct _EtPlaylist EtPlaylist;
+
+EtPlaylist * et_playlist_new (EtPlaylistFlags flags);
+void et_playlist_free (EtPlaylist *playlist);
+void et_playlist_set_file (EtPlaylist *playlist, GFile *file);
+GFile * et_playlist_get_file (const EtPlaylist *playlist);
+void et_playlist_add (EtPlaylist *playlist, const gchar *filename, gint duration, const gchar *title);
+guint et_playlist_get_length (const EtPlaylist *playlist);
+const GError * et_playlist_get_error (const EtPlaylist *playlist);
+gboolean et_playlist_write (EtPlaylist *playlist, GCancellable *cancellable, GError **error);
+
+void et_playlist_write_all_async (GPtrArray *playlists, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data);
+gboolean et_playlist_write_all_finish (GAsyncResult *result, guint *n_written, GError **error);
+
+G_END_DECLS
+
+#endif /* !ET_PLAYLIST_H_ */
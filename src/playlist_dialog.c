@@ -26,8 +26,10 @@
 #include "browser.h"
 #include "charset.h"
 #include "easytag.h"
+#include "log.h"
 #include "misc.h"
 #include "picture.h"
+#include "playlist.h"
 #include "scan.h"
 #include "scan_dialog.h"
 #include "setting.h"
@@ -44,382 +46,242 @@ typedef struct
     GtkWidget *content_extended_radio;
     GtkWidget *content_extended_mask_radio;
     GtkWidget *content_mask_entry;
+    GtkWidget *group_combo;
+
+    GPtrArray *playlists;
+    GCancellable *write_cancellable;
 } EtPlaylistDialogPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (EtPlaylistDialog, et_playlist_dialog, GTK_TYPE_DIALOG)
 
 /*
- * Function to replace UNIX ForwardSlash with a DOS BackSlash
+ * EtPlaylistOptions:
+ * @flags: how to write the playlists
+ * @group: how to group the files into playlists
+ * @content: what to write about each file
+ * @content_mask: the mask of the title of each file, for
+ * %ET_PLAYLIST_CONTENT_EXTENDED_MASK
+ * @name_mask: the mask of the name of the playlists, or %NULL to use the
+ * name of the directory, album or artist
+ * @parent_directory: whether to create playlists in the parent directory
+ * @convert_spaces: how to convert spaces in the name of the playlists
+ *
+ * The playlist settings, read once for all the files.
  */
-static void
-convert_forwardslash_to_backslash (const gchar *string)
+typedef struct
 {
-    gchar *tmp;
-
-    while ((tmp = strchr (string,'/')) != NULL)
-    {
-        *tmp = '\\';
-    }
-}
+    EtPlaylistFlags flags;
+    EtPlaylistGroup group;
+    EtPlaylistContent content;
+    gchar *content_mask;
+    gchar *name_mask;
+    gboolean parent_directory;
+    EtConvertSpaces convert_spaces;
+} EtPlaylistOptions;
 
 /*
- * Write a playlist
- *  - 'playlist_name' in file system encoding (not UTF-8)
+ * EtPlaylistGroupData:
+ * @etfile: the first file of the group, from which to name the playlist
+ * @name: the name of the directory, album or artist of the group
+ * @artist: the artist of an album group, or %NULL
+ * @dirname: the directory which contains all the files of the group
+ * @path: the path of the playlist of the group, or %NULL until it is chosen
+ * @playlist: the playlist of the group
  */
-static gboolean
-write_playlist (EtPlaylistDialog *self, GFile *file, GError **error)
+typedef struct
 {
-    EtPlaylistDialogPrivate *priv;
-    GFile *parent;
-    GFileOutputStream *ostream;
-    GString *to_write;
-    GList *l;
-    GList *etfilelist = NULL;
-    gchar *basedir;
-    gchar *temp;
-    EtPlaylistContent playlist_content;
+    const ET_File *etfile;
+    gchar *name;
+    gchar *artist;
+    gchar *dirname;
+    gchar *path;
+    EtPlaylist *playlist;
+} EtPlaylistGroupData;
 
-    g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+static void
+playlist_options_init (EtPlaylistOptions *options)
+{
+    gchar *mask;
 
-    priv = et_playlist_dialog_get_instance_private (self);
+    options->flags = 0;
 
-    ostream = g_file_replace (file, NULL, FALSE, G_FILE_CREATE_NONE, NULL, error);
+    options->content = g_settings_get_enum (MainSettings, "playlist-content");
 
-    if (!ostream)
+    if (options->content != ET_PLAYLIST_CONTENT_FILENAMES)
     {
-        g_assert (error == NULL || *error != NULL);
-        return FALSE;
+        options->flags |= ET_PLAYLIST_EXTENDED;
     }
 
-    /* 'base directory' where is located the playlist. Used also to write file with a
-     * relative path for file located in this directory and sub-directories
-     */
-    parent = g_file_get_parent (file);
-    basedir = g_file_get_path (parent);
-    g_object_unref (parent);
-
-    playlist_content = g_settings_get_enum (MainSettings, "playlist-content");
+    if (g_settings_get_boolean (MainSettings, "playlist-relative"))
+    {
+        options->flags |= ET_PLAYLIST_RELATIVE;
+    }
 
-    /* 1) First line of the file (if playlist content is not set to "write only
-     * list of files") */
-    if (playlist_content != ET_PLAYLIST_CONTENT_FILENAMES)
+    if (g_settings_get_boolean (MainSettings, "playlist-dos-separator"))
     {
-        gsize bytes_written;
+        options->flags |= ET_PLAYLIST_DOS_SEPARATOR;
+    }
 
-        to_write = g_string_new ("#EXTM3U\r\n");
+    options->group = g_settings_get_enum (MainSettings, "playlist-group");
 
-        if (!g_output_stream_write_all (G_OUTPUT_STREAM (ostream),
-                                        to_write->str, to_write->len,
-                                        &bytes_written, NULL, error))
-        {
-            g_debug ("Only %" G_GSIZE_FORMAT " bytes out of %" G_GSIZE_FORMAT
-                     "bytes of data were written", bytes_written,
-                     to_write->len);
-            g_assert (error == NULL || *error != NULL);
-            g_string_free (to_write, TRUE);
-            g_object_unref (ostream);
-            return FALSE;
-        }
-        g_string_free (to_write, TRUE);
-    }
+    mask = g_settings_get_string (MainSettings, "playlist-default-mask");
+    options->content_mask = filename_from_display (mask);
+    g_free (mask);
 
-    if (g_settings_get_boolean (MainSettings, "playlist-selected-only"))
+    if (g_settings_get_boolean (MainSettings, "playlist-use-mask"))
     {
-        etfilelist = et_application_window_browser_get_selected_files (ET_APPLICATION_WINDOW (MainWindow));
+        mask = g_settings_get_string (MainSettings, "playlist-filename-mask");
+        options->name_mask = filename_from_display (mask);
+        g_free (mask);
     }
     else
     {
-        etfilelist = ETCore->ETFileList;
+        options->name_mask = NULL;
     }
 
-    for (l = etfilelist; l != NULL; l = g_list_next (l))
-    {
-        const ET_File *etfile;
-        const gchar *filename;
-        gint duration;
+    options->parent_directory = g_settings_get_boolean (MainSettings,
+                                                        "playlist-parent-directory");
+    options->convert_spaces = g_settings_get_enum (MainSettings,
+                                                   "rename-convert-spaces");
+}
 
-        etfile = (ET_File *)l->data;
-        filename = ((File_Name *)etfile->FileNameCur->data)->value;
-        duration = ((ET_File_Info *)etfile->ETFileInfo)->duration;
+static void
+playlist_options_clear (EtPlaylistOptions *options)
+{
+    g_free (options->content_mask);
+    g_free (options->name_mask);
+}
 
-        if (g_settings_get_boolean (MainSettings, "playlist-relative"))
-        {
-            // Keep only files in this directory and sub-dirs
-            if ( strncmp(filename,basedir,strlen(basedir))==0 )
-            {
-                gsize bytes_written;
-
-                /* 2) Write the header. */
-                switch (playlist_content)
-                {
-                    case ET_PLAYLIST_CONTENT_FILENAMES:
-                        /* No header written. */
-                        break;
-                    case ET_PLAYLIST_CONTENT_EXTENDED:
-                        /* Header has extended information. */
-                        temp = g_path_get_basename (filename);
-                        to_write = g_string_new ("#EXTINF:");
-                        /* Must be written in system encoding (not UTF-8). */
-                        g_string_append_printf (to_write, "%d,%s\r\n", duration,
-                                                temp);
-
-                        if (!g_output_stream_write_all (G_OUTPUT_STREAM (ostream),
-                                                        to_write->str,
-                                                        to_write->len,
-                                                        &bytes_written, NULL,
-                                                        error))
-                        {
-                            g_debug ("Only %" G_GSIZE_FORMAT " bytes out of %"
-                                     G_GSIZE_FORMAT "bytes of data were written",
-                                     bytes_written, to_write->len);
-                            g_assert (error == NULL || *error != NULL);
-                            g_string_free (to_write, TRUE);
-                            g_object_unref (ostream);
-                            return FALSE;
-                        }
-                        g_string_free (to_write, TRUE);
-                        g_free (temp);
-                        break;
-                    case ET_PLAYLIST_CONTENT_EXTENDED_MASK:
-                    {
-                        /* Header uses information generated from a mask. */
-                        gchar *mask = filename_from_display (gtk_entry_get_text (GTK_ENTRY (priv->content_mask_entry)));
-                        /* Special case: do not replace illegal characters and
-                         * do not check if there is a directory separator in
-                         * the mask. */
-                        gchar *filename_generated_utf8 = et_scan_generate_new_filename_from_mask (etfile, mask, TRUE);
-                        gchar *filename_generated = filename_from_display (filename_generated_utf8);
-
-                        to_write = g_string_new ("#EXTINF:");
-                        /* Must be written in system encoding (not UTF-8). */
-                        g_string_append_printf (to_write, "%d,%s\r\n", duration,
-                                                filename_generated);
-
-                        if (!g_output_stream_write_all (G_OUTPUT_STREAM (ostream),
-                                                        to_write->str,
-                                                        to_write->len,
-                                                        &bytes_written, NULL,
-                                                        error))
-                        {
-                            g_debug ("Only %" G_GSIZE_FORMAT " bytes out of %"
-                                     G_GSIZE_FORMAT "bytes of data were written",
-                                     bytes_written, to_write->len);
-                            g_assert (error == NULL || *error != NULL);
-                            g_string_free (to_write, TRUE);
-                            g_object_unref (ostream);
-                            return FALSE;
-                        }
-                        g_string_free (to_write, TRUE);
-                        g_free (mask);
-                        g_free (filename_generated_utf8);
-
-                        break;
-                    }
-                    default:
-                        g_assert_not_reached ();
-                        break;
-                }
-
-                /* 3) Write the file path. */
-                if (g_settings_get_boolean (MainSettings,
-                                            "playlist-dos-separator"))
-                {
-                    gchar *filename_conv = g_strdup(filename+strlen(basedir)+1);
-                    convert_forwardslash_to_backslash (filename_conv);
-
-                    to_write = g_string_new (filename_conv);
-                    /* Must be written in system encoding (not UTF-8)*/
-                    to_write = g_string_append (to_write, "\r\n");
-
-                    if (!g_output_stream_write_all (G_OUTPUT_STREAM (ostream),
-                                                    to_write->str,
-                                                    to_write->len,
-                                                    &bytes_written, NULL,
-                                                    error))
-                    {
-                        g_debug ("Only %" G_GSIZE_FORMAT " bytes out of %"
-                                 G_GSIZE_FORMAT "bytes of data were written",
-                                 bytes_written, to_write->len);
-                        g_assert (error == NULL || *error != NULL);
-                        g_string_free (to_write, TRUE);
-                        g_object_unref (ostream);
-                        return FALSE;
-                    }
-                    g_string_free (to_write, TRUE);
-                    g_free(filename_conv);
-                }else
-                {
-                    to_write = g_string_new (filename+strlen(basedir)+1);
-                    /* Must be written in system encoding (not UTF-8)*/
-                    to_write = g_string_append (to_write, "\r\n");
-
-                    if (!g_output_stream_write_all (G_OUTPUT_STREAM (ostream),
-                                                    to_write->str,
-                                                    to_write->len,
-                                                    &bytes_written, NULL,
-                                                    error))
-                    {
-                        g_debug ("Only %" G_GSIZE_FORMAT " bytes out of %"
-                                 G_GSIZE_FORMAT "bytes of data were written",
-                                 bytes_written, to_write->len);
-                        g_assert (error == NULL || *error != NULL);
-                        g_string_free (to_write, TRUE);
-                        g_object_unref (ostream);
-                        return FALSE;
-                    }
-                    g_string_free (to_write, TRUE);
-                }
-            }
-        }
-        else /* !ETSettings:playlist-relative */
-        {
-            gsize bytes_written;
+static void
+playlist_group_data_free (EtPlaylistGroupData *data)
+{
+    g_free (data->name);
+    g_free (data->artist);
+    g_free (data->dirname);
+    g_free (data->path);
 
-            /* 2) Write the header. */
-            switch (playlist_content)
-            {
-                case ET_PLAYLIST_CONTENT_FILENAMES:
-                    /* No header written. */
-                    break;
-                case ET_PLAYLIST_CONTENT_EXTENDED:
-                    /* Header has extended information. */
-                    temp = g_path_get_basename (filename);
-                    to_write = g_string_new ("#EXTINF:");
-                    /* Must be written in system encoding (not UTF-8). */
-                    g_string_append_printf (to_write, "%d,%s\r\n", duration,
-                                            temp);
-                    g_free (temp);
-
-                    if (!g_output_stream_write_all (G_OUTPUT_STREAM (ostream),
-                                                    to_write->str, to_write->len,
-                                                    &bytes_written, NULL, error))
-                    {
-                        g_debug ("Only %" G_GSIZE_FORMAT " bytes out of %"
-                                 G_GSIZE_FORMAT" bytes of data were written",
-                                 bytes_written, to_write->len);
-                        g_assert (error == NULL || *error != NULL);
-                        g_string_free (to_write, TRUE);
-                        g_object_unref (ostream);
-                        return FALSE;
-                    }
-                    g_string_free (to_write, TRUE);
-                    break;
-                case ET_PLAYLIST_CONTENT_EXTENDED_MASK:
-                {
-                    /* Header uses information generated from a mask. */
-                    gchar *mask = filename_from_display (gtk_entry_get_text (GTK_ENTRY (priv->content_mask_entry)));
-                    /* Special case: do not replace illegal characters and
-                     * do not check if there is a directory separator in
-                     * the mask. */
-                    gchar *filename_generated_utf8 = et_scan_generate_new_filename_from_mask (etfile, mask, TRUE);
-                    gchar *filename_generated = filename_from_display (filename_generated_utf8);
-
-                    to_write = g_string_new ("#EXTINF:");
-                    /* Must be written in system encoding (not UTF-8). */
-                    g_string_append_printf (to_write, "%d,%s\r\n", duration,
-                                            filename_generated);
-                    g_free (filename_generated);
-
-                    if (!g_output_stream_write_all (G_OUTPUT_STREAM (ostream),
-                                                    to_write->str, to_write->len,
-                                                    &bytes_written, NULL, error))
-                    {
-                        g_debug ("Only %" G_GSIZE_FORMAT " bytes out of %"
-                                 G_GSIZE_FORMAT" bytes of data were written",
-                                 bytes_written, to_write->len);
-                        g_assert (error == NULL || *error != NULL);
-                        g_string_free (to_write, TRUE);
-                        g_object_unref (ostream);
-                        return FALSE;
-                    }
-                    g_string_free (to_write, TRUE);
-                    g_free (mask);
-                    g_free (filename_generated_utf8);
-                }
-                break;
-                default:
-                    g_assert_not_reached ();
-                    break;
-            }
+    if (data->playlist)
+    {
+        et_playlist_free (data->playlist);
+    }
 
-            /* 3) Write the file path. */
-            if (g_settings_get_boolean (MainSettings,
-                                        "playlist-dos-separator"))
-            {
-                gchar *filename_conv = g_strdup(filename);
-                convert_forwardslash_to_backslash(filename_conv);
-
-                to_write = g_string_new (filename_conv);
-                /* Must be written in system encoding (not UTF-8)*/
-                to_write = g_string_append (to_write, "\r\n");
-
-                if (!g_output_stream_write_all (G_OUTPUT_STREAM (ostream),
-                                                to_write->str, to_write->len,
-                                                &bytes_written, NULL, error))
-                {
-                    g_debug ("Only %" G_GSIZE_FORMAT " bytes out of %"
-                             G_GSIZE_FORMAT" bytes of data were written",
-                             bytes_written, to_write->len);
-                    g_assert (error == NULL || *error != NULL);
-                    g_string_free (to_write, TRUE);
-                    g_object_unref (ostream);
-                    return FALSE;
-                }
-                g_string_free (to_write, TRUE);
-                g_free(filename_conv);
-            }else
-            {
-                to_write = g_string_new (filename);
-                /* Must be written in system encoding (not UTF-8)*/
-                to_write = g_string_append (to_write, "\r\n");
-
-                if (!g_output_stream_write_all (G_OUTPUT_STREAM (ostream),
-                                                to_write->str, to_write->len,
-                                                &bytes_written, NULL, error))
-                {
-                    g_debug ("Only %" G_GSIZE_FORMAT " bytes out of %"
-                             G_GSIZE_FORMAT" bytes of data were written",
-                             bytes_written, to_write->len);
-                    g_assert (error == NULL || *error != NULL);
-                    g_string_free (to_write, TRUE);
-                    g_object_unref (ostream);
-                    return FALSE;
-                }
-                g_string_free (to_write, TRUE);
-            }
-        }
+    g_slice_free (EtPlaylistGroupData, data);
+}
+
+/*
+ * Generate the name of a playlist, in UTF-8, from the tag of @etfile if a
+ * mask is used, or else from @name.
+ */
+static gchar *
+generate_playlist_basename (const EtPlaylistOptions *options,
+                            const ET_File *etfile,
+                            const gchar *name)
+{
+    gchar *playlist_basename_utf8;
+
+    if (options->name_mask == NULL)
+    {
+        return g_strdup (name);
     }
 
-    if (g_settings_get_boolean (MainSettings, "playlist-selected-only"))
+    playlist_basename_utf8 = et_scan_generate_new_filename_from_mask (etfile,
+                                                                      options->name_mask,
+                                                                      FALSE);
+
+    /* Replace Characters (with scanner). */
+    switch (options->convert_spaces)
     {
-        g_list_free (etfilelist);
+        case ET_CONVERT_SPACES_SPACES:
+            Scan_Convert_Underscore_Into_Space (playlist_basename_utf8);
+            Scan_Convert_P20_Into_Space (playlist_basename_utf8);
+            break;
+        case ET_CONVERT_SPACES_UNDERSCORES:
+            Scan_Convert_Space_Into_Underscore (playlist_basename_utf8);
+            break;
+        case ET_CONVERT_SPACES_REMOVE:
+            Scan_Remove_Spaces (playlist_basename_utf8);
+            break;
+        /* FIXME: Check that this is intended. */
+        case ET_CONVERT_SPACES_NO_CHANGE:
+        default:
+            g_assert_not_reached ();
+            break;
     }
 
-    g_assert (error == NULL || *error == NULL);
-    g_object_unref (ostream);
-    g_free(basedir);
-    return TRUE;
+    return playlist_basename_utf8;
 }
 
+/*
+ * Add @etfile to @playlist, with the title given by the playlist content
+ * setting.
+ */
 static void
-write_button_clicked (EtPlaylistDialog *self)
+add_file_to_playlist (EtPlaylist *playlist,
+                      const EtPlaylistOptions *options,
+                      const ET_File *etfile)
 {
-    EtPlaylistDialogPrivate *priv;
+    gchar *filename;
+    gchar *title;
+    gint duration;
+
+    filename = et_file_name_get_path ((File_Name *)etfile->FileNameCur->data);
+    duration = ((ET_File_Info *)etfile->ETFileInfo)->duration;
+
+    switch (options->content)
+    {
+        case ET_PLAYLIST_CONTENT_FILENAMES:
+            /* No header written. */
+            title = NULL;
+            break;
+        case ET_PLAYLIST_CONTENT_EXTENDED:
+            /* Header has extended information. */
+            title = g_path_get_basename (filename);
+            break;
+        case ET_PLAYLIST_CONTENT_EXTENDED_MASK:
+        {
+            /* Header uses information generated from a mask. Special case:
+             * do not replace illegal characters and do not check if there is
+             * a directory separator in the mask. */
+            gchar *title_utf8 = et_scan_generate_new_filename_from_mask (etfile,
+                                                                         options->content_mask,
+                                                                         TRUE);
+            /* Must be written in system encoding (not UTF-8). */
+            title = filename_from_display (title_utf8);
+            g_free (title_utf8);
+            break;
+        }
+        default:
+            g_assert_not_reached ();
+            break;
+    }
+
+    et_playlist_add (playlist, filename, duration, title);
+
+    g_free (title);
+    g_free (filename);
+}
+
+/*
+ * Build the single playlist of the files, in the current directory.
+ *  - 'playlist_name' in file system encoding (not UTF-8)
+ */
+static EtPlaylist *
+build_playlist (const EtPlaylistOptions *options,
+                GList *etfilelist)
+{
+    EtPlaylist *playlist;
     gchar *playlist_name = NULL;
     gchar *playlist_path_utf8;      // Path
     gchar *playlist_basename_utf8;  // Filename
     gchar *playlist_name_utf8;      // Path + filename
     gchar *temp;
-    GtkWidget *msgdialog;
-
-    priv = et_playlist_dialog_get_instance_private (self);
+    GList *l;
+    GFile *file;
 
-    /* Check if playlist name was filled. */
-    if (g_settings_get_boolean (MainSettings, "playlist-use-mask")
-        && *(gtk_entry_get_text (GTK_ENTRY (priv->name_mask_entry))) == '\0')
+    /* Generate filename from tag of the current selected file (FIXME). */
+    if (options->name_mask && !ETCore->ETFileList)
     {
-        /* TODO: Can this happen? */
-        g_settings_set_boolean (MainSettings, "playlist-use-mask", FALSE);
+        return NULL;
     }
 
     // Path of the playlist file (may be truncated later if PLAYLIST_CREATE_IN_PARENT_DIR is TRUE)
@@ -428,70 +290,28 @@ write_button_clicked (EtPlaylistDialog *self)
     g_free (temp);
 
     /* Build the playlist filename. */
-    if (g_settings_get_boolean (MainSettings, "playlist-use-mask"))
+    if ( strcmp(playlist_path_utf8,G_DIR_SEPARATOR_S)==0 )
     {
-        EtConvertSpaces convert_mode;
-
-        if (!ETCore->ETFileList)
-            return;
-
-        playlist_name = g_settings_get_string (MainSettings,
-                                               "playlist-filename-mask");
-
-        /* Generate filename from tag of the current selected file (FIXME). */
-        temp = filename_from_display (playlist_name);
-        g_free (playlist_name);
-        playlist_basename_utf8 = et_scan_generate_new_filename_from_mask (ETCore->ETFileDisplayed,
-                                                                          temp,
-                                                                          FALSE);
-        g_free (temp);
-
-        /* Replace Characters (with scanner). */
-        convert_mode = g_settings_get_enum (MainSettings,
-                                            "rename-convert-spaces");
-
-        switch (convert_mode)
-        {
-            case ET_CONVERT_SPACES_SPACES:
-                Scan_Convert_Underscore_Into_Space (playlist_basename_utf8);
-                Scan_Convert_P20_Into_Space (playlist_basename_utf8);
-                break;
-            case ET_CONVERT_SPACES_UNDERSCORES:
-                Scan_Convert_Space_Into_Underscore (playlist_basename_utf8);
-                break;
-            case ET_CONVERT_SPACES_REMOVE:
-                Scan_Remove_Spaces (playlist_basename_utf8);
-                break;
-            /* FIXME: Check that this is intended. */
-            case ET_CONVERT_SPACES_NO_CHANGE:
-            default:
-                g_assert_not_reached ();
-                break;
-        }
-    }else // PLAYLIST_USE_DIR_NAME
+        temp = g_strdup("playlist");
+    }else
     {
-
-        if ( strcmp(playlist_path_utf8,G_DIR_SEPARATOR_S)==0 )
-        {
-            playlist_basename_utf8 = g_strdup("playlist");
-        }else
-        {
-            gchar *tmp_string = g_strdup(playlist_path_utf8);
-            // Remove last '/'
-            if (tmp_string[strlen(tmp_string)-1]==G_DIR_SEPARATOR)
-                tmp_string[strlen(tmp_string)-1] = '\0';
-            // Get directory name
-            temp = g_path_get_basename(tmp_string);
-            playlist_basename_utf8 = g_strdup(temp);
-            g_free(tmp_string);
-            g_free(temp);
-        }
-
+        gchar *tmp_string = g_strdup(playlist_path_utf8);
+        // Remove last '/'
+        if (tmp_string[strlen(tmp_string)-1]==G_DIR_SEPARATOR)
+            tmp_string[strlen(tmp_string)-1] = '\0';
+        // Get directory name
+        temp = g_path_get_basename(tmp_string);
+        g_free(tmp_string);
     }
 
+    playlist_basename_utf8 = generate_playlist_basename (options,
+                                                         ETCore->ETFileDisplayed,
+                                                         temp);
+    g_free (temp);
+
     /* Must be placed after "Build the playlist filename", as we can truncate
      * the path! */
-    if (g_settings_get_boolean (MainSettings, "playlist-parent-directory"))
+    if (options->parent_directory)
     {
         if ( (strcmp(playlist_path_utf8,G_DIR_SEPARATOR_S) != 0) )
         {
@@ -515,40 +335,525 @@ write_button_clicked (EtPlaylistDialog *self)
     g_free(playlist_basename_utf8);
 
     playlist_name = filename_from_display(playlist_name_utf8);
+    g_free (playlist_name_utf8);
+
+    playlist = et_playlist_new (options->flags);
+    file = g_file_new_for_path (playlist_name);
+    et_playlist_set_file (playlist, file);
+    g_object_unref (file);
+    g_free (playlist_name);
+
+    for (l = etfilelist; l != NULL; l = g_list_next (l))
+    {
+        add_file_to_playlist (playlist, options, (ET_File *)l->data);
+    }
+
+    return playlist;
+}
+
+/*
+ * Shorten @dirname to the directory which contains both @dirname and
+ * @other_dirname.
+ */
+static void
+shorten_to_common_directory (gchar *dirname,
+                             const gchar *other_dirname)
+{
+    gsize i;
+
+    for (i = 0; dirname[i] != '\0' && dirname[i] == other_dirname[i]; i++)
+    {
+    }
+
+    /* @dirname already contains @other_dirname. */
+    if (dirname[i] == '\0'
+        && (other_dirname[i] == '\0' || other_dirname[i] == G_DIR_SEPARATOR))
+    {
+        return;
+    }
+
+    while (i > 0 && dirname[i] != G_DIR_SEPARATOR)
+    {
+        i--;
+    }
+
+    /* Keep the separator of the root directory. */
+    dirname[i == 0 ? 1 : i] = '\0';
+}
+
+/*
+ * Get the name of the group of @etfile, in UTF-8, or %NULL if the file has
+ * none. Files with the same key go to the same playlist. @artist_name is set
+ * to the artist of an album, if any.
+ */
+static gchar *
+get_playlist_group_key (const EtPlaylistOptions *options,
+                        const ET_File *etfile,
+                        const gchar *dirname,
+                        gchar **name,
+                        gchar **artist_name)
+{
+    const File_Tag *file_tag = (File_Tag *)etfile->FileTag->data;
+    const gchar *artist;
+
+    switch (options->group)
+    {
+        case ET_PLAYLIST_GROUP_DIRECTORY:
+        {
+            gchar *basename = g_path_get_basename (dirname);
+
+            *name = g_filename_display_name (basename);
+            g_free (basename);
+            return g_strdup (dirname);
+        }
+        case ET_PLAYLIST_GROUP_ALBUM:
+            if (et_str_empty (file_tag->album))
+            {
+                return NULL;
+            }
+
+            /* Albums of the same name, by several artists, are separate. */
+            artist = !et_str_empty (file_tag->album_artist) ? file_tag->album_artist
+                                                            : file_tag->artist;
+            *name = g_strdup (file_tag->album);
+            *artist_name = !et_str_empty (artist) ? g_strdup (artist) : NULL;
+            return g_strconcat (artist ? artist : "", "\n", file_tag->album,
+                                NULL);
+        case ET_PLAYLIST_GROUP_ARTIST:
+            if (et_str_empty (file_tag->artist))
+            {
+                return NULL;
+            }
+
+            *name = g_strdup (file_tag->artist);
+            return g_strdup (file_tag->artist);
+        case ET_PLAYLIST_GROUP_NONE:
+        default:
+            g_assert_not_reached ();
+            return NULL;
+    }
+}
+
+/*
+ * Get the path of the playlist of the group @data, named after @name, with
+ * @number appended if it is greater than 1.
+ */
+static gchar *
+get_group_playlist_path (const EtPlaylistOptions *options,
+                         const EtPlaylistGroupData *data,
+                         const gchar *name,
+                         guint number)
+{
+    gchar *basename_utf8;
+    gchar *basename;
+    gchar *playlist_basename;
+    gchar *playlist_dirname;
+    gchar *playlist_name;
+
+    basename_utf8 = generate_playlist_basename (options, data->etfile, name);
+
+    if (number > 1)
+    {
+        gchar *numbered;
+
+        numbered = g_strdup_printf ("%s (%u)", basename_utf8, number);
+        g_free (basename_utf8);
+        basename_utf8 = numbered;
+    }
+
+    et_filename_prepare (basename_utf8, TRUE);
+    basename = filename_from_display (basename_utf8);
+    playlist_basename = g_strconcat (basename, ".m3u", NULL);
+
+    if (options->parent_directory)
+    {
+        playlist_dirname = g_path_get_dirname (data->dirname);
+    }
+    else
+    {
+        playlist_dirname = g_strdup (data->dirname);
+    }
 
+    playlist_name = g_build_filename (playlist_dirname, playlist_basename,
+                                      NULL);
+
+    g_free (playlist_dirname);
+    g_free (playlist_basename);
+    g_free (basename);
+    g_free (basename_utf8);
+
+    return playlist_name;
+}
+
+/*
+ * Choose the path of the playlist of each group, so that no two groups
+ * write the same playlist. This happens for albums of the same name by
+ * several artists, which are then named "Artist - Album", and for names
+ * which only differ by characters which are not allowed in filenames, such
+ * as "AC/DC" and "AC_DC", which are then numbered.
+ */
+static void
+choose_group_playlist_paths (const EtPlaylistOptions *options,
+                             GPtrArray *ordered_groups)
+{
+    GHashTable *counts;
+    GHashTable *paths;
+    guint i;
+
+    counts = g_hash_table_new (g_str_hash, g_str_equal);
+
+    for (i = 0; i < ordered_groups->len; i++)
+    {
+        EtPlaylistGroupData *data = g_ptr_array_index (ordered_groups, i);
+        guint count;
+
+        data->path = get_group_playlist_path (options, data, data->name, 1);
+        count = GPOINTER_TO_UINT (g_hash_table_lookup (counts, data->path));
+        g_hash_table_insert (counts, data->path, GUINT_TO_POINTER (count + 1));
+    }
+
+    for (i = 0; i < ordered_groups->len; i++)
+    {
+        EtPlaylistGroupData *data = g_ptr_array_index (ordered_groups, i);
+        gchar *name;
+
+        if (data->artist == NULL
+            || GPOINTER_TO_UINT (g_hash_table_lookup (counts, data->path)) < 2)
+        {
+            continue;
+        }
+
+        name = g_strconcat (data->artist, " - ", data->name, NULL);
+        g_free (data->name);
+        data->name = name;
+    }
+
+    /* The paths are the keys of counts, so they are only replaced now. */
+    g_hash_table_destroy (counts);
+
+    for (i = 0; i < ordered_groups->len; i++)
+    {
+        EtPlaylistGroupData *data = g_ptr_array_index (ordered_groups, i);
+
+        g_free (data->path);
+        data->path = get_group_playlist_path (options, data, data->name, 1);
+    }
+
+    paths = g_hash_table_new (g_str_hash, g_str_equal);
+
+    for (i = 0; i < ordered_groups->len; i++)
+    {
+        EtPlaylistGroupData *data = g_ptr_array_index (ordered_groups, i);
+        guint number = 1;
+
+        while (g_hash_table_contains (paths, data->path))
+        {
+            g_free (data->path);
+            data->path = get_group_playlist_path (options, data, data->name,
+                                                  ++number);
+        }
+
+        if (number > 1)
+        {
+            gchar *display_path;
+
+            display_path = g_filename_display_name (data->path);
+            Log_Print (LOG_WARNING,
+                       _("Another playlist has the same name as the playlist of ‘%s’, so it is written to ‘%s’"),
+                       data->name, display_path);
+            g_free (display_path);
+        }
+
+        g_hash_table_add (paths, data->path);
+    }
+
+    g_hash_table_destroy (paths);
+}
+
+/*
+ * Build one playlist for each directory, album or artist of the files, in
+ * one pass over the files. Each playlist is created in the directory which
+ * contains all of its files, named after the directory, album or artist, or
+ * with the playlist name mask applied to its first file.
+ */
+static GPtrArray *
+build_grouped_playlists (const EtPlaylistOptions *options,
+                         GList *etfilelist)
+{
+    GHashTable *groups;
+    GPtrArray *ordered_groups;
+    GPtrArray *playlists;
+    GList *l;
+    guint i;
+
+    groups = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    ordered_groups = g_ptr_array_new_with_free_func ((GDestroyNotify)playlist_group_data_free);
+
+    for (l = etfilelist; l != NULL; l = g_list_next (l))
+    {
+        const ET_File *etfile = (ET_File *)l->data;
+        gchar *filename;
+        gchar *dirname;
+        gchar *key;
+        gchar *name = NULL;
+        gchar *artist = NULL;
+        EtPlaylistGroupData *data;
+
+        filename = et_file_name_get_path ((File_Name *)etfile->FileNameCur->data);
+        dirname = g_path_get_dirname (filename);
+        g_free (filename);
+
+        key = get_playlist_group_key (options, etfile, dirname, &name,
+                                      &artist);
+
+        if (key == NULL)
+        {
+            g_free (dirname);
+            continue;
+        }
+
+        data = g_hash_table_lookup (groups, key);
+
+        if (data)
+        {
+            shorten_to_common_directory (data->dirname, dirname);
+            g_free (dirname);
+            g_free (artist);
+            g_free (name);
+            g_free (key);
+        }
+        else
+        {
+            data = g_slice_new (EtPlaylistGroupData);
+            data->etfile = etfile;
+            data->name = name;
+            data->artist = artist;
+            data->dirname = dirname;
+            data->path = NULL;
+            data->playlist = et_playlist_new (options->flags);
+
+            g_hash_table_insert (groups, key, data);
+            g_ptr_array_add (ordered_groups, data);
+        }
+
+        add_file_to_playlist (data->playlist, options, etfile);
+    }
+
+    choose_group_playlist_paths (options, ordered_groups);
+
+    playlists = g_ptr_array_new_with_free_func ((GDestroyNotify)et_playlist_free);
+
+    for (i = 0; i < ordered_groups->len; i++)
+    {
+        EtPlaylistGroupData *data = g_ptr_array_index (ordered_groups, i);
+        GFile *file;
+
+        file = g_file_new_for_path (data->path);
+        et_playlist_set_file (data->playlist, file);
+        g_object_unref (file);
+
+        g_ptr_array_add (playlists, data->playlist);
+        data->playlist = NULL;
+    }
+
+    g_ptr_array_unref (ordered_groups);
+    g_hash_table_destroy (groups);
+
+    return playlists;
+}
+
+static void
+on_playlists_written (GObject *source_object,
+                      GAsyncResult *result,
+                      gpointer user_data)
+{
+    EtPlaylistDialog *self;
+    EtPlaylistDialogPrivate *priv;
+    guint n_written;
+    GError *error = NULL;
+
+    self = ET_PLAYLIST_DIALOG (user_data);
+    priv = et_playlist_dialog_get_instance_private (self);
+
+    if (et_playlist_write_all_finish (result, &n_written, &error))
+    {
+        gchar *msg;
+
+        if (priv->playlists->len == 1)
+        {
+            gchar *path;
+            gchar *display_name;
+
+            path = g_file_get_path (et_playlist_get_file (g_ptr_array_index (priv->playlists,
+                                                                             0)));
+            display_name = g_filename_display_name (path);
+            msg = g_strdup_printf (_("Wrote playlist file ‘%s’"),
+                                   display_name);
+            g_free (display_name);
+            g_free (path);
+        }
+        else
+        {
+            msg = g_strdup_printf (ngettext ("Wrote %u playlist file",
+                                             "Wrote %u playlist files",
+                                             n_written),
+                                   n_written);
+        }
+
+        et_application_window_status_bar_message (ET_APPLICATION_WINDOW (MainWindow),
+                                                  msg, TRUE);
+        g_free (msg);
+    }
+    else if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
     {
-        GFile *file = g_file_new_for_path (playlist_name);
-        GError *error = NULL;
+        GtkWidget *msgdialog;
+        const EtPlaylist *playlist = NULL;
+        guint n_failed = 0;
+        guint i;
+        gchar *path;
+        gchar *display_name;
+
+        /* Report the first playlist which could not be written. */
+        for (i = 0; i < priv->playlists->len; i++)
+        {
+            const EtPlaylist *current = g_ptr_array_index (priv->playlists,
+                                                           i);
+
+            if (et_playlist_get_error (current))
+            {
+                playlist = playlist ? playlist : current;
+                n_failed++;
+            }
+        }
+
+        g_assert (playlist != NULL);
+        path = g_file_get_path (et_playlist_get_file (playlist));
+        display_name = g_filename_display_name (path);
 
-        if (!write_playlist (self, file, &error))
+        // Writing fails...
+        if (n_failed == 1)
         {
-            // Writing fails...
             msgdialog = gtk_message_dialog_new (GTK_WINDOW (self),
-                                               GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
-                                               GTK_MESSAGE_ERROR,
-                                               GTK_BUTTONS_CLOSE,
-                                               _("Cannot write playlist file ‘%s’"),
-                                               playlist_name_utf8);
+                                                GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+                                                GTK_MESSAGE_ERROR,
+                                                GTK_BUTTONS_CLOSE,
+                                                _("Cannot write playlist file ‘%s’"),
+                                                display_name);
             gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (msgdialog),
                                                       "%s", error->message);
-            gtk_window_set_title(GTK_WINDOW(msgdialog),_("Playlist File Error"));
+        }
+        else
+        {
+            msgdialog = gtk_message_dialog_new (GTK_WINDOW (self),
+                                                GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+                                                GTK_MESSAGE_ERROR,
+                                                GTK_BUTTONS_CLOSE,
+                                                ngettext ("Cannot write %u playlist file",
+                                                          "Cannot write %u playlist files",
+                                                          n_failed),
+                                                n_failed);
+            gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (msgdialog),
+                                                      "%s: %s", display_name,
+                                                      error->message);
+        }
 
-            gtk_dialog_run(GTK_DIALOG(msgdialog));
-            gtk_widget_destroy(msgdialog);
-            g_error_free (error);
-        }else
+        gtk_window_set_title(GTK_WINDOW(msgdialog),_("Playlist File Error"));
+
+        gtk_dialog_run(GTK_DIALOG(msgdialog));
+        gtk_widget_destroy(msgdialog);
+
+        g_free (display_name);
+        g_free (path);
+    }
+
+    /* Only cancelled when the dialog is disposed. */
+    if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+        gtk_dialog_set_response_sensitive (GTK_DIALOG (self),
+                                           GTK_RESPONSE_OK, TRUE);
+    }
+
+    g_clear_error (&error);
+    g_clear_pointer (&priv->playlists, g_ptr_array_unref);
+    g_clear_object (&priv->write_cancellable);
+    g_object_unref (self);
+}
+
+/*
+ * Build the playlists from the settings, then write them in a thread.
+ */
+static void
+write_button_clicked (EtPlaylistDialog *self)
+{
+    EtPlaylistDialogPrivate *priv;
+    EtPlaylistOptions options;
+    GList *etfilelist;
+    GPtrArray *playlists;
+
+    priv = et_playlist_dialog_get_instance_private (self);
+
+    /* Still writing the previous playlists. */
+    if (priv->playlists)
+    {
+        return;
+    }
+
+    /* Check if playlist name was filled. */
+    if (g_settings_get_boolean (MainSettings, "playlist-use-mask")
+        && *(gtk_entry_get_text (GTK_ENTRY (priv->name_mask_entry))) == '\0')
+    {
+        /* TODO: Can this happen? */
+        g_settings_set_boolean (MainSettings, "playlist-use-mask", FALSE);
+    }
+
+    playlist_options_init (&options);
+
+    if (g_settings_get_boolean (MainSettings, "playlist-selected-only"))
+    {
+        etfilelist = et_application_window_browser_get_selected_files (ET_APPLICATION_WINDOW (MainWindow));
+    }
+    else
+    {
+        etfilelist = ETCore->ETFileList;
+    }
+
+    if (options.group == ET_PLAYLIST_GROUP_NONE)
+    {
+        EtPlaylist *playlist;
+
+        playlists = g_ptr_array_new_with_free_func ((GDestroyNotify)et_playlist_free);
+        playlist = build_playlist (&options, etfilelist);
+
+        if (playlist)
         {
-            gchar *msg;
-            msg = g_strdup_printf (_("Wrote playlist file ‘%s’"),
-                                   playlist_name_utf8);
-            et_application_window_status_bar_message (ET_APPLICATION_WINDOW (MainWindow),
-                                                      msg, TRUE);
-            g_free (msg);
+            g_ptr_array_add (playlists, playlist);
         }
-        g_object_unref (file);
     }
-    g_free(playlist_name_utf8);
-    g_free(playlist_name);
+    else
+    {
+        playlists = build_grouped_playlists (&options, etfilelist);
+    }
+
+    if (g_settings_get_boolean (MainSettings, "playlist-selected-only"))
+    {
+        g_list_free (etfilelist);
+    }
+
+    playlist_options_clear (&options);
+
+    if (playlists->len == 0)
+    {
+        g_ptr_array_unref (playlists);
+        return;
+    }
+
+    priv->playlists = playlists;
+    priv->write_cancellable = g_cancellable_new ();
+    gtk_dialog_set_response_sensitive (GTK_DIALOG (self), GTK_RESPONSE_OK,
+                                       FALSE);
+
+    et_playlist_write_all_async (playlists, priv->write_cancellable,
+                                 on_playlists_written, g_object_ref (self));
 }
 
 /*
@@ -651,6 +956,10 @@ create_playlist_dialog (EtPlaylistDialog *self)
                      priv->selected_files_check, "active",
                      G_SETTINGS_BIND_DEFAULT);
 
+    /* One playlist, or one for each directory, album or artist. */
+    g_settings_bind (MainSettings, "playlist-group", priv->group_combo,
+                     "active-id", G_SETTINGS_BIND_DEFAULT);
+
     g_settings_bind (MainSettings, "playlist-relative",
                      priv->path_relative_radio, "active",
                      G_SETTINGS_BIND_DEFAULT);
@@ -706,11 +1015,30 @@ et_playlist_dialog_init (EtPlaylistDialog *self)
     create_playlist_dialog (self);
 }
 
+static void
+et_playlist_dialog_dispose (GObject *object)
+{
+    EtPlaylistDialogPrivate *priv;
+
+    priv = et_playlist_dialog_get_instance_private (ET_PLAYLIST_DIALOG (object));
+
+    /* The playlists are freed once the write is cancelled. */
+    if (priv->write_cancellable)
+    {
+        g_cancellable_cancel (priv->write_cancellable);
+    }
+
+    G_OBJECT_CLASS (et_playlist_dialog_parent_class)->dispose (object);
+}
+
 static void
 et_playlist_dialog_class_init (EtPlaylistDialogClass *klass)
 {
+    GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
     GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
 
+    gobject_class->dispose = et_playlist_dialog_dispose;
+
     gtk_widget_class_set_template_from_resource (widget_class,
                                                  "/org/gnome/EasyTAG/playlist_dialog.ui");
     gtk_widget_class_bind_template_child_private (widget_class,
@@ -722,6 +1050,9 @@ et_playlist_dialog_class_init (EtPlaylistDialogClass *klass)
     gtk_widget_class_bind_template_child_private (widget_class,
                                                   EtPlaylistDialog,
                                                   selected_files_check);
+    gtk_widget_class_bind_template_child_private (widget_class,
+                                                  EtPlaylistDialog,
+                                                  group_combo);
     gtk_widget_class_bind_template_child_private (widget_class,
                                                   EtPlaylistDialog,
                                                   path_relative_radio);
@@ -118,6 +118,7 @@ typedef struct
     GtkWidget *cddb_manual_host_combo;
     GtkWidget *cddb_manual_port_button;
     GtkWidget *cddb_manual_path_entry;
+    GtkWidget *cddb_local_path_entry;
     GtkWidget *cddb_follow_check;
     GtkWidget *cddb_dlm_check;
     GtkWidget *confirm_write_check;
@@ -166,6 +167,49 @@ et_prefs_current_folder_changed (EtPreferencesDialog *self,
     }
 }
 
+/*
+ * et_prefs_cddb_local_path_apply:
+ * @self: the preferences dialog
+ *
+ * Store the local CDDB dump path of the entry, if it changed.
+ */
+static void
+et_prefs_cddb_local_path_apply (EtPreferencesDialog *self)
+{
+    EtPreferencesDialogPrivate *priv;
+    const gchar *path;
+    gchar *current_path;
+
+    priv = et_preferences_dialog_get_instance_private (self);
+
+    path = gtk_entry_get_text (GTK_ENTRY (priv->cddb_local_path_entry));
+    current_path = g_settings_get_string (MainSettings, "cddb-local-path");
+
+    if (strcmp (path, current_path) != 0)
+    {
+        g_settings_set_string (MainSettings, "cddb-local-path", path);
+    }
+
+    g_free (current_path);
+}
+
+static void
+on_cddb_local_path_activate (EtPreferencesDialog *self,
+                             GtkEntry *entry)
+{
+    et_prefs_cddb_local_path_apply (self);
+}
+
+static gboolean
+on_cddb_local_path_focus_out (EtPreferencesDialog *self,
+                              GdkEvent *event,
+                              GtkWidget *entry)
+{
+    et_prefs_cddb_local_path_apply (self);
+
+    return GDK_EVENT_PROPAGATE;
+}
+
 static void
 on_default_path_changed (GSettings *settings,
                          const gchar *key,
@@ -313,9 +357,6 @@ create_preferences_dialog (EtPreferencesDialog *self)
     /* Set "new" Gtk+-2.0ish black/bold style for changed items. */
     g_settings_bind (MainSettings, "file-changed-bold", priv->list_bold_radio,
                      "active", G_SETTINGS_BIND_DEFAULT);
-    g_signal_connect_swapped (priv->list_bold_radio, "notify::active",
-                              G_CALLBACK (et_application_window_browser_refresh_list),
-                              MainWindow);
 
     /*
      * File Settings
@@ -692,6 +733,13 @@ create_preferences_dialog (EtPreferencesDialog *self)
                      priv->cddb_manual_path_entry, "text",
                      G_SETTINGS_BIND_DEFAULT);
 
+    /* Local CDDB dump. Changing the path indexes the dump again, so the
+     * setting is only changed once the path was entered, by
+     * et_prefs_cddb_local_path_apply(). */
+    g_settings_bind (MainSettings, "cddb-local-path",
+                     priv->cddb_local_path_entry, "text",
+                     G_SETTINGS_BIND_GET);
+
     /* Track Name list (CDDB results). */
     g_settings_bind (MainSettings, "cddb-follow-file", priv->cddb_follow_check,
                      "active", G_SETTINGS_BIND_DEFAULT);
@@ -927,9 +975,11 @@ et_preferences_on_response (GtkDialog *dialog, gint response_id,
     switch (response_id)
     {
         case GTK_RESPONSE_CLOSE:
+            et_prefs_cddb_local_path_apply (ET_PREFERENCES_DIALOG (dialog));
             OptionsWindow_Save_Button (ET_PREFERENCES_DIALOG (dialog));
             break;
         case GTK_RESPONSE_DELETE_EVENT:
+            et_prefs_cddb_local_path_apply (ET_PREFERENCES_DIALOG (dialog));
             break;
         default:
             g_assert_not_reached ();
@@ -1187,6 +1237,9 @@ et_preferences_dialog_class_init (EtPreferencesDialogClass *klass)
     gtk_widget_class_bind_template_child_private (widget_class,
                                                   EtPreferencesDialog,
                                                   cddb_manual_path_entry);
+    gtk_widget_class_bind_template_child_private (widget_class,
+                                                  EtPreferencesDialog,
+                                                  cddb_local_path_entry);
     gtk_widget_class_bind_template_child_private (widget_class,
                                                   EtPreferencesDialog,
                                                   cddb_follow_check);
@@ -1215,6 +1268,10 @@ et_preferences_dialog_class_init (EtPreferencesDialogClass *klass)
                                              et_preferences_on_response);
     gtk_widget_class_bind_template_callback (widget_class,
                                              et_prefs_current_folder_changed);
+    gtk_widget_class_bind_template_callback (widget_class,
+                                             on_cddb_local_path_activate);
+    gtk_widget_class_bind_template_callback (widget_class,
+                                             on_cddb_local_path_focus_out);
 }
 
 /*
@@ -0,0 +1,1190 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include "rename_plan.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef G_OS_WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef O_DIRECTORY
+#define O_DIRECTORY 0
+#endif
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+#endif /* !G_OS_WIN32 */
+
+#if defined (HAVE_RENAMEAT2) && defined (RENAME_NOREPLACE)
+#define USE_RENAMEAT2 1
+#endif
+
+typedef struct _EtRenameEntry EtRenameEntry;
+
+/*
+ * EtRenameEntry:
+ * @old_filepath: the current path of the file
+ * @new_filepath: the path to rename the file to
+ * @data: the data given when adding the file
+ * @next: the entry which must be moved out of @new_filepath first, or %NULL
+ * @prev: the entry which moves to @old_filepath, or %NULL
+ * @planned: whether the moves of the entry were planned
+ */
+struct _EtRenameEntry
+{
+    gchar *old_filepath;
+    gchar *new_filepath;
+    gpointer data;
+    EtRenameEntry *next;
+    EtRenameEntry *prev;
+    gboolean planned;
+};
+
+/*
+ * EtRenameStep:
+ * @from: the path to move from, or %NULL for the temporary file of the chain
+ * @to: the path to move to, or %NULL for the temporary file of the chain
+ *
+ * A single move, in a chain of moves.
+ */
+typedef struct
+{
+    const gchar *from;
+    const gchar *to;
+} EtRenameStep;
+
+/*
+ * EtRenameChain:
+ * @steps: the #EtRenameStep of the chain, in the order to run them
+ * @tmp_filepath: the temporary file used to break a cycle, or %NULL
+ *
+ * Moves which depend on each other, as each one frees the path which the
+ * next one moves to. A cycle of renames, such as swapping two names, is
+ * broken by moving its first file to a temporary name.
+ */
+typedef struct
+{
+    GArray *steps;
+    gchar *tmp_filepath;
+} EtRenameChain;
+
+/*
+ * EtRenameGroup:
+ * @plan: the plan of the group
+ * @chains: the #EtRenameChain of the group
+ * @dir_fds: the open file descriptors of directories, by path
+ * @journal: the #EtRenameStep which were done, with the temporary file of a
+ * chain filled in, to undo them in reverse order
+ * @error: the error of the failing move, or %NULL
+ *
+ * The chains of moves in a set of directories. Groups share no directory, so
+ * they are run in parallel.
+ */
+typedef struct
+{
+    EtRenamePlan *plan;
+    GPtrArray *chains;
+    GHashTable *dir_fds;
+    GArray *journal;
+    GError *error;
+} EtRenameGroup;
+
+/*
+ * EtRenamePlan:
+ * @entries: the #EtRenameEntry of the files to rename, in the order added
+ * @failed: set when a move failed, to stop the other groups
+ *
+ * Renames of a set of files, which are run together.
+ */
+struct _EtRenamePlan
+{
+    GPtrArray *entries;
+    volatile gint failed;
+};
+
+static void
+rename_entry_free (EtRenameEntry *entry)
+{
+    g_free (entry->old_filepath);
+    g_free (entry->new_filepath);
+    g_slice_free (EtRenameEntry, entry);
+}
+
+static void
+rename_chain_free (EtRenameChain *chain)
+{
+    g_array_free (chain->steps, TRUE);
+    g_free (chain->tmp_filepath);
+    g_slice_free (EtRenameChain, chain);
+}
+
+#ifndef G_OS_WIN32
+static void
+rename_close_dir_fd (gpointer data)
+{
+    close (GPOINTER_TO_INT (data));
+}
+#endif /* !G_OS_WIN32 */
+
+static EtRenameGroup *
+rename_group_new (EtRenamePlan *plan)
+{
+    EtRenameGroup *group;
+
+    group = g_slice_new0 (EtRenameGroup);
+    group->plan = plan;
+    group->chains = g_ptr_array_new ();
+#ifndef G_OS_WIN32
+    group->dir_fds = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                            rename_close_dir_fd);
+#endif /* !G_OS_WIN32 */
+    group->journal = g_array_new (FALSE, FALSE, sizeof (EtRenameStep));
+
+    return group;
+}
+
+static void
+rename_group_free (EtRenameGroup *group)
+{
+    g_ptr_array_free (group->chains, TRUE);
+
+    if (group->dir_fds)
+    {
+        g_hash_table_destroy (group->dir_fds);
+    }
+
+    g_array_free (group->journal, TRUE);
+    g_clear_error (&group->error);
+    g_slice_free (EtRenameGroup, group);
+}
+
+/*
+ * et_rename_plan_new:
+ *
+ * Create a new, empty, plan of renames.
+ *
+ * Returns: a new #EtRenamePlan, free with et_rename_plan_free()
+ */
+EtRenamePlan *
+et_rename_plan_new (void)
+{
+    EtRenamePlan *plan;
+
+    plan = g_slice_new0 (EtRenamePlan);
+    plan->entries = g_ptr_array_new_with_free_func ((GDestroyNotify)rename_entry_free);
+
+    return plan;
+}
+
+/*
+ * et_rename_plan_free:
+ * @plan: the plan to free
+ *
+ * Free @plan, without running its renames.
+ */
+void
+et_rename_plan_free (EtRenamePlan *plan)
+{
+    g_return_if_fail (plan != NULL);
+
+    g_ptr_array_free (plan->entries, TRUE);
+    g_slice_free (EtRenamePlan, plan);
+}
+
+/*
+ * et_rename_plan_add:
+ * @plan: the plan to add a rename to
+ * @old_filepath: path of the file to be renamed
+ * @new_filepath: path of the renamed file
+ * @data: data to pass to et_rename_plan_foreach() for the file
+ *
+ * Add the rename of @old_filepath to @new_filepath to @plan. The destination
+ * may be the current path of another file of @plan, as long as that one is
+ * renamed too.
+ */
+void
+et_rename_plan_add (EtRenamePlan *plan,
+                    const gchar *old_filepath,
+                    const gchar *new_filepath,
+                    gpointer data)
+{
+    EtRenameEntry *entry;
+
+    g_return_if_fail (plan != NULL);
+    g_return_if_fail (old_filepath != NULL && new_filepath != NULL);
+
+    entry = g_slice_new0 (EtRenameEntry);
+    entry->old_filepath = g_strdup (old_filepath);
+    entry->new_filepath = g_strdup (new_filepath);
+    entry->data = data;
+
+    g_ptr_array_add (plan->entries, entry);
+}
+
+/*
+ * et_rename_plan_get_length:
+ * @plan: the plan to count the renames of
+ *
+ * Returns: the number of renames added to @plan
+ */
+guint
+et_rename_plan_get_length (const EtRenamePlan *plan)
+{
+    g_return_val_if_fail (plan != NULL, 0);
+
+    return plan->entries->len;
+}
+
+/*
+ * et_rename_plan_foreach:
+ * @plan: the plan to iterate over
+ * @func: the function to call with the data of each rename
+ * @user_data: user data to pass to @func
+ *
+ * Call @func with the data given to et_rename_plan_add() for each rename of
+ * @plan, in the order they were added.
+ */
+void
+et_rename_plan_foreach (EtRenamePlan *plan,
+                        GFunc func,
+                        gpointer user_data)
+{
+    guint i;
+
+    g_return_if_fail (plan != NULL);
+    g_return_if_fail (func != NULL);
+
+    for (i = 0; i < plan->entries->len; i++)
+    {
+        const EtRenameEntry *entry = g_ptr_array_index (plan->entries, i);
+
+        func (entry->data, user_data);
+    }
+}
+
+static void
+rename_set_error (GError **error,
+                  gint errsv,
+                  const gchar *from,
+                  const gchar *to)
+{
+    gchar *from_utf8;
+    gchar *to_utf8;
+
+    from_utf8 = g_filename_display_name (from);
+    to_utf8 = g_filename_display_name (to);
+    g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv),
+                 _("Cannot rename file ‘%s’ to ‘%s’: %s"), from_utf8, to_utf8,
+                 g_strerror (errsv));
+    g_free (to_utf8);
+    g_free (from_utf8);
+}
+
+/*
+ * Create the temporary file, to move @filepath to, next to it. The file is
+ * replaced by the move.
+ */
+static gchar *
+rename_make_temporary (const gchar *filepath,
+                       GError **error)
+{
+    gchar *tmp_filepath;
+    gint fd;
+
+    tmp_filepath = g_strconcat (filepath, ".XXXXXX", NULL);
+    fd = g_mkstemp_full (tmp_filepath, O_RDWR, 0600);
+
+    if (fd < 0)
+    {
+        gint errsv = errno;
+        gchar *display_name;
+
+        display_name = g_filename_display_name (filepath);
+        g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv),
+                     _("Cannot create a temporary file for ‘%s’: %s"),
+                     display_name, g_strerror (errsv));
+        g_free (display_name);
+        g_free (tmp_filepath);
+
+        return NULL;
+    }
+
+    g_close (fd, NULL);
+
+    return tmp_filepath;
+}
+
+/*
+ * Move @from to @to on another filesystem, by copying it and then deleting
+ * it, as a rename cannot cross filesystems.
+ */
+static gboolean
+rename_move_across_filesystems (const gchar *from,
+                                const gchar *to,
+                                gboolean replace,
+                                GError **error)
+{
+    GFile *from_file;
+    GFile *to_file;
+    gboolean success;
+
+    from_file = g_file_new_for_path (from);
+    to_file = g_file_new_for_path (to);
+    success = g_file_move (from_file, to_file,
+                           G_FILE_COPY_NOFOLLOW_SYMLINKS
+                           | G_FILE_COPY_ALL_METADATA
+                           | (replace ? G_FILE_COPY_OVERWRITE : 0),
+                           NULL, NULL, NULL, error);
+    g_object_unref (to_file);
+    g_object_unref (from_file);
+
+    return success;
+}
+
+#ifdef G_OS_WIN32
+static gboolean
+rename_group_move (EtRenameGroup *group,
+                   const gchar *from,
+                   const gchar *to,
+                   gboolean replace,
+                   GError **error)
+{
+    /* Renaming does not replace an existing file on Windows, but may change
+     * the case of a name. */
+    if (replace)
+    {
+        g_unlink (to);
+    }
+
+    if (g_rename (from, to) != 0)
+    {
+        gint errsv = errno;
+
+        if (errsv == EXDEV)
+        {
+            return rename_move_across_filesystems (from, to, replace, error);
+        }
+
+        rename_set_error (error, errsv, from, to);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+#else /* !G_OS_WIN32 */
+/*
+ * Get the file descriptor of the directory @dirname, opening it the first
+ * time, so that files are moved relative to their directories rather than
+ * looking up their full paths each time.
+ */
+static gint
+rename_group_get_dir_fd (EtRenameGroup *group,
+                         const gchar *dirname)
+{
+    gpointer fd;
+    gint new_fd;
+
+    if (g_hash_table_lookup_extended (group->dir_fds, dirname, NULL, &fd))
+    {
+        return GPOINTER_TO_INT (fd);
+    }
+
+    new_fd = open (dirname, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    if (new_fd >= 0)
+    {
+        g_hash_table_insert (group->dir_fds, g_strdup (dirname),
+                             GINT_TO_POINTER (new_fd));
+    }
+
+    return new_fd;
+}
+
+/*
+ * Rename, failing with EEXIST rather than replacing an existing file.
+ */
+static gint
+rename_noreplace (gint from_fd,
+                  const gchar *from_name,
+                  gint to_fd,
+                  const gchar *to_name)
+{
+    struct stat st;
+
+#ifdef USE_RENAMEAT2
+    if (renameat2 (from_fd, from_name, to_fd, to_name, RENAME_NOREPLACE) == 0)
+    {
+        return 0;
+    }
+
+    /* Fall back if the kernel or the filesystem lacks support. */
+    if (errno != EINVAL && errno != ENOSYS)
+    {
+        return -1;
+    }
+#endif /* USE_RENAMEAT2 */
+
+    if (fstatat (to_fd, to_name, &st, AT_SYMLINK_NOFOLLOW) == 0)
+    {
+        errno = EEXIST;
+        return -1;
+    }
+    else if (errno != ENOENT)
+    {
+        return -1;
+    }
+
+    return renameat (from_fd, from_name, to_fd, to_name);
+}
+
+/*
+ * Whether @from_name and @to_name are the same file, such as names differing
+ * only by case on a case-insensitive filesystem.
+ */
+static gboolean
+rename_is_same_file (gint from_fd,
+                     const gchar *from_name,
+                     gint to_fd,
+                     const gchar *to_name)
+{
+    struct stat from_st;
+    struct stat to_st;
+
+    if (fstatat (from_fd, from_name, &from_st, AT_SYMLINK_NOFOLLOW) != 0
+        || fstatat (to_fd, to_name, &to_st, AT_SYMLINK_NOFOLLOW) != 0)
+    {
+        return FALSE;
+    }
+
+    return from_st.st_dev == to_st.st_dev && from_st.st_ino == to_st.st_ino;
+}
+
+/*
+ * rename_group_move:
+ * @group: the group of the move
+ * @from: the path to move from
+ * @to: the path to move to
+ * @replace: whether to replace an existing @to
+ * @error: a #GError to provide information on errors, or %NULL to ignore
+ *
+ * Move @from to @to, relative to the file descriptors of their directories.
+ * If they are on different filesystems, @from is copied and then deleted.
+ *
+ * Returns: %TRUE if the move was successful, %FALSE otherwise
+ */
+static gboolean
+rename_group_move (EtRenameGroup *group,
+                   const gchar *from,
+                   const gchar *to,
+                   gboolean replace,
+                   GError **error)
+{
+    gchar *from_dirname;
+    gchar *from_name;
+    gchar *to_dirname;
+    gchar *to_name;
+    gint from_fd;
+    gint to_fd;
+    gint res;
+    gint errsv = 0;
+
+    from_dirname = g_path_get_dirname (from);
+    from_name = g_path_get_basename (from);
+    to_dirname = g_path_get_dirname (to);
+    to_name = g_path_get_basename (to);
+
+    from_fd = rename_group_get_dir_fd (group, from_dirname);
+    to_fd = rename_group_get_dir_fd (group, to_dirname);
+
+    if (from_fd < 0 || to_fd < 0)
+    {
+        errsv = errno;
+        goto out;
+    }
+
+    if (replace)
+    {
+        res = renameat (from_fd, from_name, to_fd, to_name);
+    }
+    else
+    {
+        res = rename_noreplace (from_fd, from_name, to_fd, to_name);
+    }
+
+    if (res != 0)
+    {
+        errsv = errno;
+    }
+
+    if (errsv == EEXIST
+        && rename_is_same_file (from_fd, from_name, to_fd, to_name))
+    {
+        /* A change of case on a case-insensitive filesystem, so go through a
+         * temporary name. */
+        gchar *tmp_filepath;
+        gchar *tmp_name;
+
+        tmp_filepath = rename_make_temporary (from, NULL);
+
+        if (tmp_filepath == NULL)
+        {
+            goto out;
+        }
+
+        tmp_name = g_path_get_basename (tmp_filepath);
+
+        if (renameat (from_fd, from_name, from_fd, tmp_name) != 0)
+        {
+            unlinkat (from_fd, tmp_name, 0);
+        }
+        else if (rename_noreplace (from_fd, tmp_name, to_fd, to_name) != 0)
+        {
+            errsv = errno;
+            renameat (from_fd, tmp_name, from_fd, from_name);
+        }
+        else
+        {
+            errsv = 0;
+        }
+
+        g_free (tmp_name);
+        g_free (tmp_filepath);
+    }
+
+out:
+    if (errsv == EXDEV)
+    {
+        /* The directories are on different filesystems. */
+        if (rename_move_across_filesystems (from, to, replace, error))
+        {
+            errsv = 0;
+        }
+    }
+    else if (errsv != 0)
+    {
+        rename_set_error (error, errsv, from, to);
+    }
+
+    g_free (to_name);
+    g_free (to_dirname);
+    g_free (from_name);
+    g_free (from_dirname);
+
+    return errsv == 0;
+}
+#endif /* !G_OS_WIN32 */
+
+/*
+ * Run the chains of @group in order, recording each move in the journal,
+ * until a move fails here or in another group.
+ */
+static void
+rename_group_run (gpointer data,
+                  gpointer user_data)
+{
+    EtRenameGroup *group = data;
+    guint i;
+
+    for (i = 0; i < group->chains->len; i++)
+    {
+        EtRenameChain *chain = g_ptr_array_index (group->chains, i);
+        guint j;
+
+        for (j = 0; j < chain->steps->len; j++)
+        {
+            EtRenameStep step = g_array_index (chain->steps, EtRenameStep, j);
+            gboolean replace = FALSE;
+
+            if (g_atomic_int_get (&group->plan->failed))
+            {
+                return;
+            }
+
+            if (step.to == NULL)
+            {
+                /* Break a cycle by moving aside to a new temporary file. */
+                chain->tmp_filepath = rename_make_temporary (step.from,
+                                                             &group->error);
+
+                if (chain->tmp_filepath == NULL)
+                {
+                    g_atomic_int_set (&group->plan->failed, 1);
+                    return;
+                }
+
+                step.to = chain->tmp_filepath;
+                replace = TRUE;
+            }
+            else if (step.from == NULL)
+            {
+                step.from = chain->tmp_filepath;
+            }
+
+            if (!rename_group_move (group, step.from, step.to, replace,
+                                    &group->error))
+            {
+                if (replace)
+                {
+                    g_unlink (step.to);
+                }
+
+                g_atomic_int_set (&group->plan->failed, 1);
+                return;
+            }
+
+            g_array_append_val (group->journal, step);
+        }
+    }
+}
+
+/*
+ * Undo the moves of @group, in reverse order.
+ */
+static void
+rename_group_rollback (EtRenameGroup *group)
+{
+    guint i;
+
+    for (i = group->journal->len; i > 0; i--)
+    {
+        const EtRenameStep *step = &g_array_index (group->journal,
+                                                   EtRenameStep, i - 1);
+        GError *error = NULL;
+
+        if (!rename_group_move (group, step->to, step->from, FALSE, &error))
+        {
+            g_warning ("Error while undoing a rename: %s", error->message);
+            g_error_free (error);
+        }
+    }
+
+    g_array_set_size (group->journal, 0);
+}
+
+/*
+ * Create the directory @dirname and its missing parents, adding the ones
+ * which were created to @created.
+ */
+static gboolean
+rename_make_directory (const gchar *dirname,
+                       GPtrArray *created,
+                       GError **error)
+{
+    gchar *parent;
+
+    if (g_file_test (dirname, G_FILE_TEST_IS_DIR))
+    {
+        return TRUE;
+    }
+
+    parent = g_path_get_dirname (dirname);
+
+    if (strcmp (parent, dirname) != 0
+        && !rename_make_directory (parent, created, error))
+    {
+        g_free (parent);
+        return FALSE;
+    }
+
+    g_free (parent);
+
+    if (g_mkdir (dirname, 0777) != 0)
+    {
+        gint errsv = errno;
+        gchar *display_name;
+
+        if (errsv == EEXIST && g_file_test (dirname, G_FILE_TEST_IS_DIR))
+        {
+            return TRUE;
+        }
+
+        display_name = g_filename_display_name (dirname);
+        g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv),
+                     _("Cannot create directory ‘%s’: %s"), display_name,
+                     g_strerror (errsv));
+        g_free (display_name);
+
+        return FALSE;
+    }
+
+    g_ptr_array_add (created, g_strdup (dirname));
+
+    return TRUE;
+}
+
+/*
+ * Remove the directories which were created for the plan, in reverse order.
+ * Directories which are not empty are kept.
+ */
+static void
+rename_remove_directories (GPtrArray *created)
+{
+    guint i;
+
+    for (i = created->len; i > 0; i--)
+    {
+        g_rmdir (g_ptr_array_index (created, i - 1));
+    }
+}
+
+/*
+ * Check that the files of @plan have distinct paths, and link each entry to
+ * the one moving out of its destination. Entries which do not change name
+ * are left out of @moves.
+ */
+static gboolean
+rename_plan_link_entries (EtRenamePlan *plan,
+                          GPtrArray *moves,
+                          GError **error)
+{
+    GHashTable *by_old;
+    GHashTable *by_new;
+    guint i;
+    gboolean result = TRUE;
+
+    by_old = g_hash_table_new (g_str_hash, g_str_equal);
+    by_new = g_hash_table_new (g_str_hash, g_str_equal);
+
+    for (i = 0; i < plan->entries->len; i++)
+    {
+        EtRenameEntry *entry = g_ptr_array_index (plan->entries, i);
+
+        entry->next = NULL;
+        entry->prev = NULL;
+        entry->planned = FALSE;
+
+        if (strcmp (entry->old_filepath, entry->new_filepath) == 0)
+        {
+            continue;
+        }
+
+        if (g_hash_table_contains (by_old, entry->old_filepath))
+        {
+            gchar *display_name;
+
+            display_name = g_filename_display_name (entry->old_filepath);
+            g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+                         _("File ‘%s’ would be renamed several times"),
+                         display_name);
+            g_free (display_name);
+            result = FALSE;
+            goto out;
+        }
+
+        if (g_hash_table_contains (by_new, entry->new_filepath))
+        {
+            gchar *display_name;
+
+            display_name = g_filename_display_name (entry->new_filepath);
+            g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+                         _("Several files would be renamed to ‘%s’"),
+                         display_name);
+            g_free (display_name);
+            result = FALSE;
+            goto out;
+        }
+
+        g_hash_table_insert (by_old, entry->old_filepath, entry);
+        g_hash_table_insert (by_new, entry->new_filepath, entry);
+        g_ptr_array_add (moves, entry);
+    }
+
+    for (i = 0; i < moves->len; i++)
+    {
+        EtRenameEntry *entry = g_ptr_array_index (moves, i);
+
+        entry->next = g_hash_table_lookup (by_old, entry->new_filepath);
+
+        if (entry->next)
+        {
+            entry->next->prev = entry;
+        }
+    }
+
+out:
+    g_hash_table_destroy (by_new);
+    g_hash_table_destroy (by_old);
+
+    return result;
+}
+
+/*
+ * Check that the destinations which are not freed by another rename do not
+ * exist, before moving anything.
+ */
+static gboolean
+rename_plan_check_destinations (GPtrArray *moves,
+                                GError **error)
+{
+    guint i;
+
+    for (i = 0; i < moves->len; i++)
+    {
+        const EtRenameEntry *entry = g_ptr_array_index (moves, i);
+        GStatBuf old_st;
+        GStatBuf new_st;
+
+        if (entry->next != NULL
+            || g_lstat (entry->new_filepath, &new_st) != 0)
+        {
+            continue;
+        }
+
+        /* Names differing only by case on a case-insensitive filesystem. */
+        if (g_lstat (entry->old_filepath, &old_st) == 0
+            && old_st.st_dev == new_st.st_dev
+            && old_st.st_ino == new_st.st_ino)
+        {
+            continue;
+        }
+
+        rename_set_error (error, EEXIST, entry->old_filepath,
+                          entry->new_filepath);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static EtRenameChain *
+rename_chain_new (void)
+{
+    EtRenameChain *chain;
+
+    chain = g_slice_new0 (EtRenameChain);
+    chain->steps = g_array_new (FALSE, FALSE, sizeof (EtRenameStep));
+
+    return chain;
+}
+
+static void
+rename_chain_add_step (EtRenameChain *chain,
+                       const gchar *from,
+                       const gchar *to)
+{
+    EtRenameStep step;
+
+    step.from = from;
+    step.to = to;
+    g_array_append_val (chain->steps, step);
+}
+
+/*
+ * Order the moves into chains. A chain starts with a move to a free path,
+ * then moves each file to the path freed by the previous move. What remains
+ * are cycles, which start and end with a temporary file.
+ */
+static GPtrArray *
+rename_plan_build_chains (GPtrArray *moves)
+{
+    GPtrArray *chains;
+    guint i;
+
+    chains = g_ptr_array_new_with_free_func ((GDestroyNotify)rename_chain_free);
+
+    for (i = 0; i < moves->len; i++)
+    {
+        EtRenameEntry *entry = g_ptr_array_index (moves, i);
+        EtRenameChain *chain;
+
+        if (entry->next != NULL)
+        {
+            continue;
+        }
+
+        chain = rename_chain_new ();
+
+        for (; entry != NULL; entry = entry->prev)
+        {
+            rename_chain_add_step (chain, entry->old_filepath,
+                                   entry->new_filepath);
+            entry->planned = TRUE;
+        }
+
+        g_ptr_array_add (chains, chain);
+    }
+
+    for (i = 0; i < moves->len; i++)
+    {
+        EtRenameEntry *entry = g_ptr_array_index (moves, i);
+        EtRenameEntry *prev;
+        EtRenameChain *chain;
+
+        if (entry->planned)
+        {
+            continue;
+        }
+
+        chain = rename_chain_new ();
+        rename_chain_add_step (chain, entry->old_filepath, NULL);
+
+        for (prev = entry->prev; prev != entry; prev = prev->prev)
+        {
+            rename_chain_add_step (chain, prev->old_filepath,
+                                   prev->new_filepath);
+            prev->planned = TRUE;
+        }
+
+        rename_chain_add_step (chain, NULL, entry->new_filepath);
+        entry->planned = TRUE;
+
+        g_ptr_array_add (chains, chain);
+    }
+
+    return chains;
+}
+
+static guint
+rename_find_root (GArray *parents,
+                  guint i)
+{
+    while (g_array_index (parents, guint, i) != i)
+    {
+        i = g_array_index (parents, guint, i);
+    }
+
+    return i;
+}
+
+/*
+ * Split the chains into groups which share no directory, by joining the
+ * chains which touch a common directory.
+ */
+static GPtrArray *
+rename_plan_build_groups (EtRenamePlan *plan,
+                          GPtrArray *chains)
+{
+    GHashTable *owners;
+    GArray *parents;
+    GPtrArray *groups;
+    EtRenameGroup **root_groups;
+    guint i;
+
+    owners = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    parents = g_array_sized_new (FALSE, FALSE, sizeof (guint), chains->len);
+
+    for (i = 0; i < chains->len; i++)
+    {
+        const EtRenameChain *chain = g_ptr_array_index (chains, i);
+        guint j;
+
+        g_array_append_val (parents, i);
+
+        for (j = 0; j < chain->steps->len; j++)
+        {
+            const EtRenameStep *step = &g_array_index (chain->steps,
+                                                       EtRenameStep, j);
+            const gchar *paths[2];
+            guint k;
+
+            paths[0] = step->from;
+            paths[1] = step->to;
+
+            for (k = 0; k < G_N_ELEMENTS (paths); k++)
+            {
+                gchar *dirname;
+                gpointer owner;
+
+                if (paths[k] == NULL)
+                {
+                    continue;
+                }
+
+                dirname = g_path_get_dirname (paths[k]);
+
+                if (g_hash_table_lookup_extended (owners, dirname, NULL,
+                                                  &owner))
+                {
+                    guint owner_root;
+                    guint root;
+
+                    owner_root = rename_find_root (parents,
+                                                   GPOINTER_TO_UINT (owner));
+                    root = rename_find_root (parents, i);
+                    g_array_index (parents, guint, owner_root) = root;
+                    g_free (dirname);
+                }
+                else
+                {
+                    g_hash_table_insert (owners, dirname,
+                                         GUINT_TO_POINTER (i));
+                }
+            }
+        }
+    }
+
+    groups = g_ptr_array_new_with_free_func ((GDestroyNotify)rename_group_free);
+    root_groups = g_new0 (EtRenameGroup *, chains->len);
+
+    for (i = 0; i < chains->len; i++)
+    {
+        guint root = rename_find_root (parents, i);
+
+        if (root_groups[root] == NULL)
+        {
+            root_groups[root] = rename_group_new (plan);
+            g_ptr_array_add (groups, root_groups[root]);
+        }
+
+        g_ptr_array_add (root_groups[root]->chains,
+                         g_ptr_array_index (chains, i));
+    }
+
+    g_free (root_groups);
+    g_array_free (parents, TRUE);
+    g_hash_table_destroy (owners);
+
+    return groups;
+}
+
+/*
+ * et_rename_plan_execute:
+ * @plan: the plan to run
+ * @error: a #GError to provide information on errors, or %NULL to ignore
+ *
+ * Rename the files of @plan. Files may swap names, or move in a cycle, and
+ * the destination directories are created first. The renames in separate
+ * directories are run in parallel.
+ *
+ * If a rename fails, the renames which were done are undone, and the
+ * directories which were created are removed, so that either all or none of
+ * the files are renamed.
+ *
+ * Returns: %TRUE if all the files were renamed, %FALSE otherwise
+ */
+gboolean
+et_rename_plan_execute (EtRenamePlan *plan,
+                        GError **error)
+{
+    GPtrArray *moves;
+    GPtrArray *chains = NULL;
+    GPtrArray *groups = NULL;
+    GPtrArray *created;
+    GHashTable *dirnames;
+    guint i;
+    gboolean result = FALSE;
+
+    g_return_val_if_fail (plan != NULL, FALSE);
+    g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+    moves = g_ptr_array_new ();
+    created = g_ptr_array_new_with_free_func (g_free);
+    dirnames = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+    if (!rename_plan_link_entries (plan, moves, error)
+        || !rename_plan_check_destinations (moves, error))
+    {
+        goto out;
+    }
+
+    /* Create each destination directory once. */
+    for (i = 0; i < moves->len; i++)
+    {
+        const EtRenameEntry *entry = g_ptr_array_index (moves, i);
+        gchar *dirname;
+
+        dirname = g_path_get_dirname (entry->new_filepath);
+
+        if (g_hash_table_contains (dirnames, dirname))
+        {
+            g_free (dirname);
+            continue;
+        }
+
+        g_hash_table_add (dirnames, dirname);
+
+        if (!rename_make_directory (dirname, created, error))
+        {
+            rename_remove_directories (created);
+            goto out;
+        }
+    }
+
+    chains = rename_plan_build_chains (moves);
+    groups = rename_plan_build_groups (plan, chains);
+    plan->failed = 0;
+
+    if (groups->len == 1)
+    {
+        rename_group_run (g_ptr_array_index (groups, 0), NULL);
+    }
+    else if (groups->len > 1)
+    {
+        GThreadPool *pool;
+
+        pool = g_thread_pool_new (rename_group_run, NULL,
+                                  MIN (groups->len, g_get_num_processors ()),
+                                  FALSE, NULL);
+
+        for (i = 0; i < groups->len; i++)
+        {
+            g_thread_pool_push (pool, g_ptr_array_index (groups, i), NULL);
+        }
+
+        /* Wait for all the groups to finish. */
+        g_thread_pool_free (pool, FALSE, TRUE);
+    }
+
+    if (g_atomic_int_get (&plan->failed))
+    {
+        for (i = 0; i < groups->len; i++)
+        {
+            EtRenameGroup *group = g_ptr_array_index (groups, i);
+
+            rename_group_rollback (group);
+
+            if (group->error && (error == NULL || *error == NULL))
+            {
+                g_propagate_error (error, group->error);
+                group->error = NULL;
+            }
+        }
+
+        rename_remove_directories (created);
+        goto out;
+    }
+
+    result = TRUE;
+
+out:
+    if (groups)
+    {
+        g_ptr_array_free (groups, TRUE);
+    }
+
+    if (chains)
+    {
+        g_ptr_array_free (chains, TRUE);
+    }
+
+    g_hash_table_destroy (dirnames);
+    g_ptr_array_free (created, TRUE);
+    g_ptr_array_free (moves, TRUE);
+
+    return result;
+}
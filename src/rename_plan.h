@@ -0,0 +1,37 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ET_RENAME_PLAN_H_
+#define ET_RENAME_PLAN_H_
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef struct _EtRenamePlan EtRenamePlan;
+
+EtRenamePlan * et_rename_plan_new (void);
+void et_rename_plan_free (EtRenamePlan *plan);
+void et_rename_plan_add (EtRenamePlan *plan, const gchar *old_filepath, const gchar *new_filepath, gpointer data);
+guint et_rename_plan_get_length (const EtRenamePlan *plan);
+gboolean et_rename_plan_execute (EtRenamePlan *plan, GError **error);
+void et_rename_plan_foreach (EtRenamePlan *plan, GFunc func, gpointer user_data);
+
+G_END_DECLS
+
+#endif /* !ET_RENAME_PLAN_H_ */
@@ -354,32 +354,38 @@ et_scan_dialog_set_file_tag_for_mask_item (File_Tag *file_tag,
 }
 
 /*
- * Uses the filename and path to fill tag information
+ * et_scan_tag_with_mask:
+ * @ETFile: the file to scan
+ * @mask: the fill tag mask
+ *
+ * Use the filename and path of @ETFile to fill its tag, following the scanner
+ * preferences. This does not need the scanner dialog, so it is also used in
+ * batch mode.
  * Note: mask and source are read from the right to the left
+ *
+ * Returns: %TRUE if the tag of @ETFile was changed, %FALSE otherwise
  */
-static void
-Scan_Tag_With_Mask (EtScanDialog *self, ET_File *ETFile)
+gboolean
+et_scan_tag_with_mask (ET_File *ETFile, const gchar *mask)
 {
-    EtScanDialogPrivate *priv;
+    const EtSettingsSnapshot *snapshot;
     GList *fill_tag_list = NULL;
     GList *l;
-    gchar *mask; // The 'mask' in the entry
-    gchar *filename_utf8;
+    gchar *mask_copy;
     File_Tag *FileTag;
 
-    g_return_if_fail (ETFile != NULL);
-
-    priv = et_scan_dialog_get_instance_private (self);
+    g_return_val_if_fail (ETFile != NULL && mask != NULL, FALSE);
 
-    mask = g_strdup (gtk_entry_get_text (GTK_ENTRY (gtk_bin_get_child (GTK_BIN (priv->fill_combo)))));
-    if (!mask) return;
+    snapshot = et_settings_get_snapshot ();
 
     // Create a new File_Tag item
     FileTag = et_file_tag_new ();
     et_file_tag_copy_into (FileTag, ETFile->FileTag->data);
 
     // Process this mask with file
-    fill_tag_list = Scan_Generate_New_Tag_From_Mask(ETFile,mask);
+    mask_copy = g_strdup (mask);
+    fill_tag_list = Scan_Generate_New_Tag_From_Mask (ETFile, mask_copy);
+    g_free (mask_copy);
 
     for (l = fill_tag_list; l != NULL; l = g_list_next (l))
     {
@@ -387,27 +393,23 @@ Scan_Tag_With_Mask (EtScanDialog *self, ET_File *ETFile)
 
         /* We display the text affected to the code. */
         et_scan_dialog_set_file_tag_for_mask_item (FileTag, mask_item,
-                                                   g_settings_get_boolean (MainSettings,
-                                                                           "fill-overwrite-tag-fields"));
+                                                   snapshot->fill_overwrite_tag_fields);
 
     }
 
     Scan_Free_File_Fill_Tag_List(fill_tag_list);
 
     /* Set the default text to comment. */
-    if (g_settings_get_boolean (MainSettings, "fill-set-default-comment")
-        && (g_settings_get_boolean (MainSettings, "fill-overwrite-tag-fields")
+    if (snapshot->fill_set_default_comment
+        && (snapshot->fill_overwrite_tag_fields
             || et_str_empty (FileTag->comment)))
     {
-        gchar *default_comment = g_settings_get_string (MainSettings,
-                                                        "fill-default-comment");
-        et_file_tag_set_comment  (FileTag, default_comment);
-        g_free (default_comment);
+        et_file_tag_set_comment (FileTag, snapshot->fill_default_comment);
     }
 
     /* Set CRC-32 value as default comment (for files with ID3 tag only). */
-    if (g_settings_get_boolean (MainSettings, "fill-crc32-comment")
-        && (g_settings_get_boolean (MainSettings, "fill-overwrite-tag-fields")
+    if (snapshot->fill_crc32_comment
+        && (snapshot->fill_overwrite_tag_fields
             || et_str_empty (FileTag->comment)))
     {
         GFile *file;
@@ -417,7 +419,10 @@ Scan_Tag_With_Mask (EtScanDialog *self, ET_File *ETFile)
 
         if (ETFile->ETFileDescription == ID3_TAG)
         {
-            file = g_file_new_for_path (((File_Name *)((GList *)ETFile->FileNameNew)->data)->value);
+            gchar *path = et_file_name_get_path ((File_Name *)ETFile->FileNameNew->data);
+
+            file = g_file_new_for_path (path);
+            g_free (path);
 
             if (crc32_file_with_ID3_tag (file, &crc32_value, &error))
             {
@@ -440,15 +445,33 @@ Scan_Tag_With_Mask (EtScanDialog *self, ET_File *ETFile)
 
 
     // Save changes of the 'File_Tag' item
-    ET_Manage_Changes_Of_File_Data(ETFile,NULL,FileTag);
+    return ET_Manage_Changes_Of_File_Data (ETFile, NULL, FileTag);
+}
+
+/*
+ * Uses the filename and path to fill tag information, with the mask in the
+ * entry of the dialog.
+ */
+static void
+Scan_Tag_With_Mask (EtScanDialog *self, ET_File *ETFile)
+{
+    EtScanDialogPrivate *priv;
+    const gchar *mask; // The 'mask' in the entry
+
+    g_return_if_fail (ETFile != NULL);
+
+    priv = et_scan_dialog_get_instance_private (self);
+
+    mask = gtk_entry_get_text (GTK_ENTRY (gtk_bin_get_child (GTK_BIN (priv->fill_combo))));
+    if (!mask) return;
+
+    et_scan_tag_with_mask (ETFile, mask);
 
-    g_free(mask);
     et_application_window_status_bar_message (ET_APPLICATION_WINDOW (MainWindow),
                                               _("Tag successfully scanned"),
                                               TRUE);
-    filename_utf8 = g_path_get_basename( ((File_Name *)ETFile->FileNameNew->data)->value_utf8 );
-    Log_Print (LOG_OK, _("Tag successfully scanned ‘%s’"), filename_utf8);
-    g_free(filename_utf8);
+    Log_Print (LOG_OK, _("Tag successfully scanned ‘%s’"),
+               ((File_Name *)ETFile->FileNameNew->data)->name_utf8);
 }
 
 static GList *
@@ -472,7 +495,7 @@ Scan_Generate_New_Tag_From_Mask (ET_File *ETFile, gchar *mask)
 
     g_return_val_if_fail (ETFile != NULL && mask != NULL, NULL);
 
-    filename_utf8 = g_strdup(((File_Name *)((GList *)ETFile->FileNameNew)->data)->value_utf8);
+    filename_utf8 = et_file_name_get_path_utf8 ((File_Name *)ETFile->FileNameNew->data);
     if (!filename_utf8) return NULL;
 
     // Remove extension of file (if found)
@@ -496,7 +519,7 @@ Scan_Generate_New_Tag_From_Mask (ET_File *ETFile, gchar *mask)
     }
 
     /* Replace characters into mask and filename before parsing. */
-    convert_mode = g_settings_get_enum (MainSettings, "fill-convert-spaces");
+    convert_mode = et_settings_get_snapshot ()->fill_convert_spaces;
 
     switch (convert_mode)
     {
@@ -798,57 +821,54 @@ Scan_Free_File_Fill_Tag_List (GList *list)
  * Scanner To Rename File *
  **************************/
 /*
- * Uses tag information (displayed into tag entries) to rename file
+ * et_scan_rename_file_with_mask:
+ * @ETFile: the file to rename
+ * @mask: the rename file mask
+ * @error: a #GError to provide information on errors, or %NULL to ignore
+ *
+ * Use the tag of @ETFile to generate its new filename. The file on disk is
+ * renamed only when @ETFile is saved.
  * Note: mask and source are read from the right to the left.
  * Note1: a mask code may be used severals times...
+ *
+ * Returns: %TRUE on success, %FALSE if the new filename could not be
+ * converted to the filename encoding
  */
-static void
-Scan_Rename_File_With_Mask (EtScanDialog *self, ET_File *ETFile)
+gboolean
+et_scan_rename_file_with_mask (ET_File *ETFile,
+                               const gchar *mask,
+                               GError **error)
 {
-    EtScanDialogPrivate *priv;
     gchar *filename_generated_utf8 = NULL;
     gchar *filename_generated = NULL;
     gchar *filename_new_utf8 = NULL;
-    gchar *mask = NULL;
     File_Name *FileName;
 
-    g_return_if_fail (ETFile != NULL);
-
-    priv = et_scan_dialog_get_instance_private (self);
-
-    mask = g_strdup (gtk_entry_get_text (GTK_ENTRY (gtk_bin_get_child (GTK_BIN (priv->rename_combo)))));
-    if (!mask) return;
+    g_return_val_if_fail (ETFile != NULL && mask != NULL, FALSE);
+    g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
     // Note : if the first character is '/', we have a path with the filename,
     // else we have only the filename. The both are in UTF-8.
     filename_generated_utf8 = et_scan_generate_new_filename_from_mask (ETFile,
                                                                        mask,
                                                                        FALSE);
-    g_free(mask);
 
     if (et_str_empty (filename_generated_utf8))
     {
         g_free (filename_generated_utf8);
-        return;
+        return TRUE;
     }
 
     // Convert filename to file-system encoding
     filename_generated = filename_from_display(filename_generated_utf8);
     if (!filename_generated)
     {
-        GtkWidget *msgdialog;
-        msgdialog = gtk_message_dialog_new (GTK_WINDOW (self),
-                             GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
-                             GTK_MESSAGE_ERROR,
-                             GTK_BUTTONS_CLOSE,
-                             _("Could not convert filename ‘%s’ into system filename encoding"),
-                             filename_generated_utf8);
-        gtk_window_set_title(GTK_WINDOW(msgdialog),_("Filename translation"));
-
-        gtk_dialog_run(GTK_DIALOG(msgdialog));
-        gtk_widget_destroy(msgdialog);
+        g_set_error (error, G_CONVERT_ERROR,
+                     G_CONVERT_ERROR_ILLEGAL_SEQUENCE,
+                     _("Could not convert filename ‘%s’ into system filename encoding"),
+                     filename_generated_utf8);
         g_free(filename_generated_utf8);
-        return;
+        return FALSE;
     }
 
     /* Build the filename with the full path or relative to old path */
@@ -866,14 +886,49 @@ Scan_Rename_File_With_Mask (EtScanDialog *self, ET_File *ETFile)
     ET_Manage_Changes_Of_File_Data(ETFile,FileName,NULL);
     g_free(filename_new_utf8);
 
+    return TRUE;
+}
+
+/*
+ * Uses tag information (displayed into tag entries) to rename file, with the
+ * mask in the entry of the dialog.
+ */
+static void
+Scan_Rename_File_With_Mask (EtScanDialog *self, ET_File *ETFile)
+{
+    EtScanDialogPrivate *priv;
+    const gchar *mask;
+    GError *error = NULL;
+
+    g_return_if_fail (ETFile != NULL);
+
+    priv = et_scan_dialog_get_instance_private (self);
+
+    mask = gtk_entry_get_text (GTK_ENTRY (gtk_bin_get_child (GTK_BIN (priv->rename_combo))));
+    if (!mask) return;
+
+    if (!et_scan_rename_file_with_mask (ETFile, mask, &error))
+    {
+        GtkWidget *msgdialog;
+        msgdialog = gtk_message_dialog_new (GTK_WINDOW (self),
+                             GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+                             GTK_MESSAGE_ERROR,
+                             GTK_BUTTONS_CLOSE,
+                             "%s", error->message);
+        gtk_window_set_title(GTK_WINDOW(msgdialog),_("Filename translation"));
+
+        gtk_dialog_run(GTK_DIALOG(msgdialog));
+        gtk_widget_destroy(msgdialog);
+        g_error_free (error);
+        return;
+    }
+
     et_application_window_status_bar_message (ET_APPLICATION_WINDOW (MainWindow),
                                               _("New filename successfully scanned"),
                                               TRUE);
 
-    filename_new_utf8 = g_path_get_basename(((File_Name *)ETFile->FileNameNew->data)->value_utf8);
     Log_Print (LOG_OK, _("New filename successfully scanned ‘%s’"),
-               filename_new_utf8);
-    g_free(filename_new_utf8);
+               ((File_Name *)ETFile->FileNameNew->data)->name_utf8);
 
     return;
 }
@@ -918,7 +973,7 @@ et_scan_generate_new_filename_from_mask (const ET_File *ETFile,
         }else if (strrchr(mask,G_DIR_SEPARATOR)!=NULL) // This is '/' on UNIX machines and '\' under Windows
         {
             // Relative path => set beginning of the path
-            path_utf8_cur = g_path_get_dirname( ((File_Name *)ETFile->FileNameCur->data)->value_utf8 );
+            path_utf8_cur = et_file_name_get_dirname_utf8 ((File_Name *)ETFile->FileNameCur->data);
         }
     }
 
@@ -961,8 +1016,7 @@ et_scan_generate_new_filename_from_mask (const ET_File *ETFile,
             {
                 EtConvertSpaces convert_mode;
 
-                convert_mode = g_settings_get_enum (MainSettings,
-                                                    "rename-convert-spaces");
+                convert_mode = et_settings_get_snapshot ()->rename_convert_spaces;
 
                 switch (convert_mode)
                 {
@@ -986,8 +1040,7 @@ et_scan_generate_new_filename_from_mask (const ET_File *ETFile,
                  * trailing space cannot be present (if illegal characters are to be
                  * replaced). */
                 et_filename_prepare (mask_item->string,
-                                     g_settings_get_boolean (MainSettings,
-                                                             "rename-replace-illegal-chars"));
+                                     et_settings_get_snapshot ()->rename_replace_illegal_chars);
             }
         }else
         {
@@ -1146,7 +1199,6 @@ Scan_Rename_File_Prefix_Path (EtScanDialog *self)
     gchar *path_tmp;
     const gchar *combo_text;
     const ET_File *ETFile = ETCore->ETFileDisplayed;
-    const gchar *filename_utf8_cur;
     gchar *path_utf8_cur;
 
     if (!ETFile)
@@ -1154,11 +1206,10 @@ Scan_Rename_File_Prefix_Path (EtScanDialog *self)
         return;
     }
 
-    filename_utf8_cur = ((File_Name *)ETFile->FileNameCur->data)->value_utf8;
     priv = et_scan_dialog_get_instance_private (self);
 
     // The path to prefix
-    path_utf8_cur = g_path_get_dirname(filename_utf8_cur);
+    path_utf8_cur = et_file_name_get_dirname_utf8 ((File_Name *)ETFile->FileNameCur->data);
 
     /* The current text in the combobox. */
     combo_text = gtk_entry_get_text (GTK_ENTRY (gtk_bin_get_child (GTK_BIN (priv->rename_combo))));
@@ -1252,8 +1303,7 @@ static void
 Scan_Process_Fields_Functions (EtScanDialog *self,
                                gchar **string)
 {
-    const EtProcessFieldsConvert process = g_settings_get_enum (MainSettings,
-                                                                "process-convert");
+    const EtProcessFieldsConvert process = et_settings_get_snapshot ()->process_convert;
 
     switch (process)
     {
@@ -1274,7 +1324,7 @@ Scan_Process_Fields_Functions (EtScanDialog *self,
             break;
     }
 
-    if (g_settings_get_boolean (MainSettings, "process-insert-capital-spaces"))
+    if (et_settings_get_snapshot ()->process_insert_capital_spaces)
     {
         gchar *res;
         res = Scan_Process_Fields_Insert_Space (*string);
@@ -1282,13 +1332,12 @@ Scan_Process_Fields_Functions (EtScanDialog *self,
         *string = res;
     }
 
-    if (g_settings_get_boolean (MainSettings,
-        "process-remove-duplicate-spaces"))
+    if (et_settings_get_snapshot ()->process_remove_duplicate_spaces)
     {
         Scan_Process_Fields_Keep_One_Space (*string);
     }
 
-    if (g_settings_get_boolean (MainSettings, "process-uppercase-all"))
+    if (et_settings_get_snapshot ()->process_uppercase_all)
     {
         gchar *res;
         res = Scan_Process_Fields_All_Uppercase (*string);
@@ -1296,7 +1345,7 @@ Scan_Process_Fields_Functions (EtScanDialog *self,
         *string = res;
     }
 
-    if (g_settings_get_boolean (MainSettings, "process-lowercase-all"))
+    if (et_settings_get_snapshot ()->process_lowercase_all)
     {
         gchar *res;
         res = Scan_Process_Fields_All_Downcase (*string);
@@ -1304,8 +1353,7 @@ Scan_Process_Fields_Functions (EtScanDialog *self,
         *string = res;
     }
 
-    if (g_settings_get_boolean (MainSettings,
-                                "process-uppercase-first-letter"))
+    if (et_settings_get_snapshot ()->process_uppercase_first_letter)
     {
         gchar *res;
         res = Scan_Process_Fields_Letter_Uppercase (*string);
@@ -1313,21 +1361,18 @@ Scan_Process_Fields_Functions (EtScanDialog *self,
         *string = res;
     }
 
-    if (g_settings_get_boolean (MainSettings,
-                                "process-uppercase-first-letters"))
+    if (et_settings_get_snapshot ()->process_uppercase_first_letters)
     {
         gboolean uppercase_preps;
         gboolean handle_roman;
 
-        uppercase_preps = g_settings_get_boolean (MainSettings,
-                                                  "process-uppercase-prepositions");
-        handle_roman = g_settings_get_boolean (MainSettings,
-                                               "process-detect-roman-numerals");
+        uppercase_preps = et_settings_get_snapshot ()->process_uppercase_prepositions;
+        handle_roman = et_settings_get_snapshot ()->process_detect_roman_numerals;
         Scan_Process_Fields_First_Letters_Uppercase (string, uppercase_preps,
                                                      handle_roman);
     }
 
-    if (g_settings_get_boolean (MainSettings, "process-remove-spaces"))
+    if (et_settings_get_snapshot ()->process_remove_spaces)
     {
         Scan_Process_Fields_Remove_Space (*string);
     }
@@ -1347,30 +1392,27 @@ Scan_Process_Fields (EtScanDialog *self, ET_File *ETFile)
     File_Name *st_filename;
     File_Tag  *st_filetag;
     guint process_fields;
-    gchar     *filename_utf8;
     gchar     *string;
 
     g_return_if_fail (ETFile != NULL);
 
     st_filename = (File_Name *)ETFile->FileNameNew->data;
     st_filetag  = (File_Tag  *)ETFile->FileTag->data;
-    process_fields = g_settings_get_flags (MainSettings, "process-fields");
+    process_fields = et_settings_get_snapshot ()->process_fields;
 
     /* Process the filename */
     if (st_filename != NULL)
     {
-        if (st_filename->value_utf8 
+        if (st_filename->name_utf8
             && (process_fields & ET_PROCESS_FIELD_FILENAME))
         {
             gchar *string_utf8;
             gchar *pos;
 
-            filename_utf8 = st_filename->value_utf8;
-
             if (!FileName)
                 FileName = et_file_name_new ();
 
-            string = g_path_get_basename(filename_utf8);
+            string = g_strdup (st_filename->name_utf8);
             // Remove the extension to set it to lower case (to avoid problem with undo)
             if ((pos=strrchr(string,'.'))!=NULL) *pos = 0;
 
@@ -53,6 +53,8 @@ void et_scan_dialog_scan_selected_files (EtScanDialog *self);
 void et_scan_dialog_update_previews (EtScanDialog *self);
 
 void Scan_Select_Mode_And_Run_Scanner (EtScanDialog *self, ET_File *ETFile);
+gboolean et_scan_tag_with_mask (ET_File *ETFile, const gchar *mask);
+gboolean et_scan_rename_file_with_mask (ET_File *ETFile, const gchar *mask, GError **error);
 gchar * et_scan_generate_new_filename_from_mask (const ET_File *ETFile, const gchar *mask, gboolean no_dir_check_or_conversion);
 gchar * et_scan_generate_new_directory_name_from_mask (const ET_File *ETFile, const gchar *mask, gboolean no_dir_check_or_conversion);
 
@@ -0,0 +1,1450 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include "search.h"
+
+#include <glib/gi18n.h>
+#include <string.h>
+
+#include "file.h"
+
+/*
+ * The index keeps, for every item, the normalised and the casefolded text of
+ * each field in a single allocation, and a posting list of entry ids for each
+ * trigram (three consecutive code points) of the casefolded text. Trigrams
+ * are hashed to a guint, so that collisions only add false candidates, which
+ * are then removed by checking the stored text.
+ *
+ * Entry ids are allocated in increasing order, so that the posting lists stay
+ * sorted and can be intersected by merging. Updating an entry retires its old
+ * id instead of removing it from the posting lists, and the index is
+ * compacted once there are more retired ids than live ones.
+ *
+ * The index is reference counted and protected by a mutex, so that a query
+ * can run in a worker thread while the index is kept alive by the caller.
+ * Updates and queries only hold the mutex for a chunk of entries at a time.
+ */
+
+#define ET_SEARCH_NO_TEXT G_MAXUINT32
+#define ET_SEARCH_COMPACT_THRESHOLD 4096
+/* Number of entries to check between two checks for cancellation. */
+#define ET_SEARCH_CANCEL_INTERVAL 1024
+/* Number of entries to check between two progress reports. */
+#define ET_SEARCH_PROGRESS_INTERVAL 16384
+
+typedef struct
+{
+    gpointer item;
+    guint id;
+    guint position;
+    guint stamp;
+    /* Undo keys of the File_Name and File_Tag the text was built from. */
+    guint name_key;
+    guint tag_key;
+    /* Offsets into text, normalised fields first and then casefolded. */
+    guint32 offsets[ET_SEARCH_FIELD_COUNT * 2];
+    gchar *text;
+} EtSearchEntry;
+
+struct _EtSearchIndex
+{
+    volatile gint ref_count;
+    GMutex lock;
+    /* Entry by id, with NULL for retired ids. */
+    GPtrArray *entries;
+    /* Entry by item. */
+    GHashTable *items;
+    /* GArray of guint entry ids, by trigram hash. */
+    GHashTable *postings;
+    /* Live entries sorted by position, or NULL if it must be rebuilt. */
+    GPtrArray *by_position;
+    guint n_retired;
+    guint stamp;
+    /* Incremented whenever an entry is retired, and so may be freed. */
+    guint generation;
+};
+
+typedef struct
+{
+    guint fields;
+    gchar *normalized;
+    gchar *folded;
+    GRegex *regex;
+} EtSearchTerm;
+
+struct _EtSearchQuery
+{
+    gboolean case_sensitive;
+    /* GArray of EtSearchTerm, which must all match. */
+    GArray *terms;
+};
+
+static const struct
+{
+    const gchar *name;
+    EtSearchField field;
+} field_names[] =
+{
+    { "filename", ET_SEARCH_FIELD_FILENAME },
+    { "file", ET_SEARCH_FIELD_FILENAME },
+    { "title", ET_SEARCH_FIELD_TITLE },
+    { "artist", ET_SEARCH_FIELD_ARTIST },
+    { "album_artist", ET_SEARCH_FIELD_ALBUM_ARTIST },
+    { "albumartist", ET_SEARCH_FIELD_ALBUM_ARTIST },
+    { "album", ET_SEARCH_FIELD_ALBUM },
+    { "disc", ET_SEARCH_FIELD_DISC_NUMBER },
+    { "disc_number", ET_SEARCH_FIELD_DISC_NUMBER },
+    { "disc_total", ET_SEARCH_FIELD_DISC_TOTAL },
+    { "year", ET_SEARCH_FIELD_YEAR },
+    { "track", ET_SEARCH_FIELD_TRACK },
+    { "track_total", ET_SEARCH_FIELD_TRACK_TOTAL },
+    { "genre", ET_SEARCH_FIELD_GENRE },
+    { "comment", ET_SEARCH_FIELD_COMMENT },
+    { "composer", ET_SEARCH_FIELD_COMPOSER },
+    { "orig_artist", ET_SEARCH_FIELD_ORIG_ARTIST },
+    { "copyright", ET_SEARCH_FIELD_COPYRIGHT },
+    { "url", ET_SEARCH_FIELD_URL },
+    { "encoded_by", ET_SEARCH_FIELD_ENCODED_BY }
+};
+
+static void
+et_search_entry_free (EtSearchEntry *entry)
+{
+    g_free (entry->text);
+    g_slice_free (EtSearchEntry, entry);
+}
+
+static const gchar *
+et_search_entry_get_text (const EtSearchEntry *entry,
+                          EtSearchField field,
+                          gboolean folded)
+{
+    guint32 offset;
+
+    offset = entry->offsets[folded ? ET_SEARCH_FIELD_COUNT + field : field];
+
+    return offset == ET_SEARCH_NO_TEXT ? NULL : entry->text + offset;
+}
+
+static guint
+et_search_trigram_hash (gunichar a,
+                        gunichar b,
+                        gunichar c)
+{
+    return (a * 0x9e3779b1u) ^ (b * 0x85ebca6bu) ^ (c * 0xc2b2ae35u);
+}
+
+/*
+ * Call @func with the hash of every trigram in the UTF-8 string @text.
+ */
+static void
+et_search_foreach_trigram (const gchar *text,
+                           void (*func) (guint hash, gpointer user_data),
+                           gpointer user_data)
+{
+    gunichar window[3] = { 0, 0, 0 };
+    gsize n = 0;
+    const gchar *p;
+
+    for (p = text; *p != '\0'; p = g_utf8_next_char (p))
+    {
+        window[0] = window[1];
+        window[1] = window[2];
+        window[2] = g_utf8_get_char (p);
+
+        if (++n >= 3)
+        {
+            func (et_search_trigram_hash (window[0], window[1], window[2]),
+                  user_data);
+        }
+    }
+}
+
+typedef struct
+{
+    EtSearchIndex *search_index;
+    guint id;
+} EtSearchPostingData;
+
+static void
+et_search_add_posting (guint hash,
+                       gpointer user_data)
+{
+    EtSearchPostingData *data = user_data;
+    GArray *posting;
+
+    posting = g_hash_table_lookup (data->search_index->postings,
+                                   GUINT_TO_POINTER (hash));
+
+    if (posting == NULL)
+    {
+        posting = g_array_new (FALSE, FALSE, sizeof (guint));
+        g_hash_table_insert (data->search_index->postings,
+                             GUINT_TO_POINTER (hash), posting);
+    }
+
+    /* The entry being added always has the highest id, so a trigram which
+     * occurs several times in the entry is only stored once. */
+    if (posting->len == 0
+        || g_array_index (posting, guint, posting->len - 1) != data->id)
+    {
+        g_array_append_val (posting, data->id);
+    }
+}
+
+static void
+et_search_index_invalidate_order (EtSearchIndex *search_index)
+{
+    if (search_index->by_position)
+    {
+        /* A query which runs without the lock may still hold a reference. */
+        g_ptr_array_unref (search_index->by_position);
+        search_index->by_position = NULL;
+    }
+}
+
+static void
+et_search_index_add_entry (EtSearchIndex *search_index,
+                           EtSearchEntry *entry)
+{
+    EtSearchPostingData data;
+    gsize field;
+
+    entry->id = search_index->entries->len;
+    g_ptr_array_add (search_index->entries, entry);
+    et_search_index_invalidate_order (search_index);
+
+    data.search_index = search_index;
+    data.id = entry->id;
+
+    for (field = 0; field < ET_SEARCH_FIELD_COUNT; field++)
+    {
+        const gchar *text = et_search_entry_get_text (entry, field, TRUE);
+
+        if (text)
+        {
+            et_search_foreach_trigram (text, et_search_add_posting, &data);
+        }
+    }
+}
+
+static void
+et_search_index_retire_entry (EtSearchIndex *search_index,
+                              EtSearchEntry *entry)
+{
+    g_ptr_array_index (search_index->entries, entry->id) = NULL;
+    search_index->n_retired++;
+    search_index->generation++;
+    et_search_index_invalidate_order (search_index);
+}
+
+/*
+ * Rebuild the posting lists from the live entries only, once enough entries
+ * have been retired.
+ */
+static void
+et_search_index_compact (EtSearchIndex *search_index)
+{
+    GPtrArray *old_entries;
+    guint i;
+
+    if (search_index->n_retired < ET_SEARCH_COMPACT_THRESHOLD
+        || search_index->n_retired < g_hash_table_size (search_index->items))
+    {
+        return;
+    }
+
+    old_entries = search_index->entries;
+    search_index->entries = g_ptr_array_sized_new (g_hash_table_size (search_index->items));
+    g_hash_table_remove_all (search_index->postings);
+    search_index->n_retired = 0;
+
+    for (i = 0; i < old_entries->len; i++)
+    {
+        EtSearchEntry *entry = g_ptr_array_index (old_entries, i);
+
+        if (entry)
+        {
+            et_search_index_add_entry (search_index, entry);
+        }
+    }
+
+    g_ptr_array_free (old_entries, TRUE);
+}
+
+/*
+ * et_search_index_new:
+ *
+ * Create a new, empty, search index.
+ *
+ * Returns: a new #EtSearchIndex, free with et_search_index_unref()
+ */
+EtSearchIndex *
+et_search_index_new (void)
+{
+    EtSearchIndex *search_index;
+
+    search_index = g_slice_new0 (EtSearchIndex);
+    search_index->ref_count = 1;
+    g_mutex_init (&search_index->lock);
+    search_index->entries = g_ptr_array_new ();
+    search_index->items = g_hash_table_new_full (NULL, NULL, NULL,
+                                                 (GDestroyNotify)et_search_entry_free);
+    search_index->postings = g_hash_table_new_full (NULL, NULL, NULL,
+                                                    (GDestroyNotify)g_array_unref);
+
+    return search_index;
+}
+
+EtSearchIndex *
+et_search_index_ref (EtSearchIndex *search_index)
+{
+    g_return_val_if_fail (search_index != NULL, NULL);
+
+    g_atomic_int_inc (&search_index->ref_count);
+
+    return search_index;
+}
+
+void
+et_search_index_unref (EtSearchIndex *search_index)
+{
+    g_return_if_fail (search_index != NULL);
+
+    if (!g_atomic_int_dec_and_test (&search_index->ref_count))
+    {
+        return;
+    }
+
+    et_search_index_invalidate_order (search_index);
+    g_hash_table_unref (search_index->postings);
+    g_ptr_array_free (search_index->entries, TRUE);
+    g_hash_table_unref (search_index->items);
+    g_mutex_clear (&search_index->lock);
+    g_slice_free (EtSearchIndex, search_index);
+}
+
+/*
+ * Create an entry for @item, with the normalised and casefolded text of
+ * @fields. This does not use the index, so it is done without the lock.
+ */
+static EtSearchEntry *
+et_search_entry_new (gpointer item,
+                     guint position,
+                     const gchar * const *fields)
+{
+    EtSearchEntry *entry;
+    gchar *normalized[ET_SEARCH_FIELD_COUNT];
+    gchar *folded[ET_SEARCH_FIELD_COUNT];
+    gsize lengths[ET_SEARCH_FIELD_COUNT * 2];
+    gsize size = 0;
+    gchar *p;
+    gsize i;
+
+    entry = g_slice_new0 (EtSearchEntry);
+    entry->item = item;
+    entry->position = position;
+
+    for (i = 0; i < ET_SEARCH_FIELD_COUNT; i++)
+    {
+        if (fields[i])
+        {
+            normalized[i] = g_utf8_normalize (fields[i], -1,
+                                              G_NORMALIZE_DEFAULT);
+        }
+        else
+        {
+            normalized[i] = NULL;
+        }
+
+        if (normalized[i])
+        {
+            folded[i] = g_utf8_casefold (normalized[i], -1);
+            lengths[i] = strlen (normalized[i]) + 1;
+            lengths[ET_SEARCH_FIELD_COUNT + i] = strlen (folded[i]) + 1;
+        }
+        else
+        {
+            folded[i] = NULL;
+            lengths[i] = 0;
+            lengths[ET_SEARCH_FIELD_COUNT + i] = 0;
+        }
+
+        size += lengths[i] + lengths[ET_SEARCH_FIELD_COUNT + i];
+    }
+
+    entry->text = p = g_malloc (size > 0 ? size : 1);
+
+    for (i = 0; i < ET_SEARCH_FIELD_COUNT * 2; i++)
+    {
+        const gchar *src;
+
+        src = i < ET_SEARCH_FIELD_COUNT ? normalized[i]
+                                        : folded[i - ET_SEARCH_FIELD_COUNT];
+
+        if (src)
+        {
+            entry->offsets[i] = p - entry->text;
+            memcpy (p, src, lengths[i]);
+            p += lengths[i];
+        }
+        else
+        {
+            entry->offsets[i] = ET_SEARCH_NO_TEXT;
+        }
+    }
+
+    for (i = 0; i < ET_SEARCH_FIELD_COUNT; i++)
+    {
+        g_free (normalized[i]);
+        g_free (folded[i]);
+    }
+
+    return entry;
+}
+
+/*
+ * Add @entry to @search_index, replacing the entry of the same item. Must be
+ * called with the lock held.
+ */
+static void
+et_search_index_insert_entry (EtSearchIndex *search_index,
+                              EtSearchEntry *entry)
+{
+    EtSearchEntry *old_entry;
+
+    old_entry = g_hash_table_lookup (search_index->items, entry->item);
+
+    if (old_entry)
+    {
+        et_search_index_retire_entry (search_index, old_entry);
+    }
+
+    entry->stamp = search_index->stamp;
+    /* Frees the old entry. */
+    g_hash_table_insert (search_index->items, entry->item, entry);
+    et_search_index_add_entry (search_index, entry);
+}
+
+/*
+ * et_search_index_update:
+ * @search_index: the search index
+ * @item: the item to add or update
+ * @position: the position of @item, used to sort the query results
+ * @fields: an array of %ET_SEARCH_FIELD_COUNT UTF-8 strings, each of which
+ * may be %NULL
+ *
+ * Add @item to @search_index, or replace the text which is stored for it.
+ */
+void
+et_search_index_update (EtSearchIndex *search_index,
+                        gpointer item,
+                        guint position,
+                        const gchar * const *fields)
+{
+    EtSearchEntry *entry;
+
+    g_return_if_fail (search_index != NULL);
+    g_return_if_fail (fields != NULL);
+
+    entry = et_search_entry_new (item, position, fields);
+
+    g_mutex_lock (&search_index->lock);
+    et_search_index_insert_entry (search_index, entry);
+    et_search_index_compact (search_index);
+    g_mutex_unlock (&search_index->lock);
+}
+
+/*
+ * et_search_index_remove:
+ * @search_index: the search index
+ * @item: the item to remove
+ *
+ * Remove @item from @search_index, if it was present.
+ */
+void
+et_search_index_remove (EtSearchIndex *search_index,
+                        gpointer item)
+{
+    EtSearchEntry *entry;
+
+    g_return_if_fail (search_index != NULL);
+
+    g_mutex_lock (&search_index->lock);
+
+    entry = g_hash_table_lookup (search_index->items, item);
+
+    if (entry)
+    {
+        et_search_index_retire_entry (search_index, entry);
+        g_hash_table_remove (search_index->items, item);
+        et_search_index_compact (search_index);
+    }
+
+    g_mutex_unlock (&search_index->lock);
+}
+
+guint
+et_search_index_get_n_items (EtSearchIndex *search_index)
+{
+    guint n_items;
+
+    g_return_val_if_fail (search_index != NULL, 0);
+
+    g_mutex_lock (&search_index->lock);
+    n_items = g_hash_table_size (search_index->items);
+    g_mutex_unlock (&search_index->lock);
+
+    return n_items;
+}
+
+static gboolean
+et_search_entry_is_stale (gpointer key,
+                          gpointer value,
+                          gpointer user_data)
+{
+    EtSearchEntry *entry = value;
+    EtSearchIndex *search_index = user_data;
+
+    if (entry->stamp != search_index->stamp)
+    {
+        et_search_index_retire_entry (search_index, entry);
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+typedef struct
+{
+    gpointer item;
+    guint position;
+    guint name_key;
+    guint tag_key;
+    gchar *fields[ET_SEARCH_FIELD_COUNT];
+} EtSearchUpdateItem;
+
+struct _EtSearchUpdate
+{
+    guint stamp;
+    guint n_files;
+    /* GArray of EtSearchUpdateItem, for the files which must be indexed. */
+    GArray *items;
+};
+
+static void
+et_search_update_item_clear (EtSearchUpdateItem *update_item)
+{
+    gsize i;
+
+    for (i = 0; i < ET_SEARCH_FIELD_COUNT; i++)
+    {
+        g_free (update_item->fields[i]);
+    }
+}
+
+/*
+ * et_search_index_prepare_file_list:
+ * @search_index: the search index
+ * @file_list: (element-type ET_File): the list of files to index
+ *
+ * Find the files in @file_list for which the current filename or tag changed
+ * since they were last indexed, and copy their text, so that the update can
+ * be applied from another thread with et_search_index_apply_update(). This
+ * must be called from the thread which owns @file_list.
+ *
+ * Returns: a new #EtSearchUpdate, free with et_search_update_free()
+ */
+EtSearchUpdate *
+et_search_index_prepare_file_list (EtSearchIndex *search_index,
+                                   GList *file_list)
+{
+    EtSearchUpdate *update;
+    GList *l;
+    guint position = 0;
+
+    g_return_val_if_fail (search_index != NULL, NULL);
+
+    update = g_slice_new (EtSearchUpdate);
+    update->items = g_array_new (FALSE, FALSE, sizeof (EtSearchUpdateItem));
+    g_array_set_clear_func (update->items,
+                            (GDestroyNotify)et_search_update_item_clear);
+
+    g_mutex_lock (&search_index->lock);
+
+    update->stamp = ++search_index->stamp;
+
+    for (l = file_list; l != NULL; l = g_list_next (l), position++)
+    {
+        const ET_File *ETFile = (ET_File *)l->data;
+        const File_Name *FileName = (File_Name *)ETFile->FileNameNew->data;
+        const File_Tag *FileTag = (File_Tag *)ETFile->FileTag->data;
+        EtSearchEntry *entry;
+        EtSearchUpdateItem update_item;
+
+        entry = g_hash_table_lookup (search_index->items, ETFile);
+
+        if (entry && entry->name_key == FileName->key
+            && entry->tag_key == FileTag->key)
+        {
+            if (entry->position != position)
+            {
+                entry->position = position;
+                et_search_index_invalidate_order (search_index);
+            }
+
+            entry->stamp = update->stamp;
+            continue;
+        }
+
+        update_item.item = (gpointer)ETFile;
+        update_item.position = position;
+        update_item.name_key = FileName->key;
+        update_item.tag_key = FileTag->key;
+
+        update_item.fields[ET_SEARCH_FIELD_FILENAME] = g_strdup (FileName->name_utf8);
+        update_item.fields[ET_SEARCH_FIELD_TITLE] = g_strdup (FileTag->title);
+        update_item.fields[ET_SEARCH_FIELD_ARTIST] = g_strdup (FileTag->artist);
+        update_item.fields[ET_SEARCH_FIELD_ALBUM_ARTIST] = g_strdup (FileTag->album_artist);
+        update_item.fields[ET_SEARCH_FIELD_ALBUM] = g_strdup (FileTag->album);
+        update_item.fields[ET_SEARCH_FIELD_DISC_NUMBER] = g_strdup (FileTag->disc_number);
+        update_item.fields[ET_SEARCH_FIELD_DISC_TOTAL] = g_strdup (FileTag->disc_total);
+        update_item.fields[ET_SEARCH_FIELD_YEAR] = g_strdup (FileTag->year);
+        update_item.fields[ET_SEARCH_FIELD_TRACK] = g_strdup (FileTag->track);
+        update_item.fields[ET_SEARCH_FIELD_TRACK_TOTAL] = g_strdup (FileTag->track_total);
+        update_item.fields[ET_SEARCH_FIELD_GENRE] = g_strdup (FileTag->genre);
+        update_item.fields[ET_SEARCH_FIELD_COMMENT] = g_strdup (FileTag->comment);
+        update_item.fields[ET_SEARCH_FIELD_COMPOSER] = g_strdup (FileTag->composer);
+        update_item.fields[ET_SEARCH_FIELD_ORIG_ARTIST] = g_strdup (FileTag->orig_artist);
+        update_item.fields[ET_SEARCH_FIELD_COPYRIGHT] = g_strdup (FileTag->copyright);
+        update_item.fields[ET_SEARCH_FIELD_URL] = g_strdup (FileTag->url);
+        update_item.fields[ET_SEARCH_FIELD_ENCODED_BY] = g_strdup (FileTag->encoded_by);
+
+        g_array_append_val (update->items, update_item);
+    }
+
+    update->n_files = position;
+
+    g_mutex_unlock (&search_index->lock);
+
+    return update;
+}
+
+/*
+ * et_search_index_apply_update:
+ * @search_index: the search index
+ * @update: an update from et_search_index_prepare_file_list()
+ * @cancellable: a #GCancellable, or %NULL
+ *
+ * Index the changed files in @update, and remove the files which were no
+ * longer in the list from @search_index. Normalising and casefolding the
+ * text is the expensive part of indexing, so this may be called from a
+ * worker thread. The text is prepared without the lock, which is only taken
+ * to add each chunk of entries, so that the thread which owns the file list
+ * is never blocked for long. An update which was superseded by a later call
+ * to et_search_index_prepare_file_list() is not applied further.
+ *
+ * Returns: %TRUE if the whole update was applied, %FALSE if it was cancelled
+ * or superseded
+ */
+gboolean
+et_search_index_apply_update (EtSearchIndex *search_index,
+                              const EtSearchUpdate *update,
+                              GCancellable *cancellable)
+{
+    EtSearchEntry *chunk[ET_SEARCH_CANCEL_INTERVAL];
+    guint i;
+    guint j;
+
+    g_return_val_if_fail (search_index != NULL, FALSE);
+    g_return_val_if_fail (update != NULL, FALSE);
+
+    for (i = 0; i < update->items->len; i += ET_SEARCH_CANCEL_INTERVAL)
+    {
+        const guint n = MIN (ET_SEARCH_CANCEL_INTERVAL,
+                             update->items->len - i);
+
+        if (g_cancellable_is_cancelled (cancellable))
+        {
+            return FALSE;
+        }
+
+        for (j = 0; j < n; j++)
+        {
+            const EtSearchUpdateItem *update_item;
+
+            update_item = &g_array_index (update->items, EtSearchUpdateItem,
+                                          i + j);
+            chunk[j] = et_search_entry_new (update_item->item,
+                                            update_item->position,
+                                            (const gchar * const *)update_item->fields);
+            chunk[j]->name_key = update_item->name_key;
+            chunk[j]->tag_key = update_item->tag_key;
+        }
+
+        g_mutex_lock (&search_index->lock);
+
+        if (update->stamp != search_index->stamp)
+        {
+            g_mutex_unlock (&search_index->lock);
+
+            for (j = 0; j < n; j++)
+            {
+                et_search_entry_free (chunk[j]);
+            }
+
+            return FALSE;
+        }
+
+        for (j = 0; j < n; j++)
+        {
+            et_search_index_insert_entry (search_index, chunk[j]);
+        }
+
+        g_mutex_unlock (&search_index->lock);
+    }
+
+    g_mutex_lock (&search_index->lock);
+
+    if (update->stamp != search_index->stamp)
+    {
+        g_mutex_unlock (&search_index->lock);
+        return FALSE;
+    }
+
+    if (update->n_files != g_hash_table_size (search_index->items))
+    {
+        g_hash_table_foreach_remove (search_index->items,
+                                     et_search_entry_is_stale, search_index);
+    }
+
+    et_search_index_compact (search_index);
+
+    g_mutex_unlock (&search_index->lock);
+
+    return TRUE;
+}
+
+void
+et_search_update_free (EtSearchUpdate *update)
+{
+    g_return_if_fail (update != NULL);
+
+    g_array_unref (update->items);
+    g_slice_free (EtSearchUpdate, update);
+}
+
+/*
+ * et_search_index_sync_file_list:
+ * @search_index: the search index
+ * @file_list: (element-type ET_File): the list of files to index
+ *
+ * Bring @search_index up to date with @file_list. Only files for which the
+ * current filename or tag changed since the last call are indexed again, and
+ * files which are no longer in @file_list are removed.
+ */
+void
+et_search_index_sync_file_list (EtSearchIndex *search_index,
+                                GList *file_list)
+{
+    EtSearchUpdate *update;
+
+    g_return_if_fail (search_index != NULL);
+
+    update = et_search_index_prepare_file_list (search_index, file_list);
+    et_search_index_apply_update (search_index, update, NULL);
+    et_search_update_free (update);
+}
+
+static void
+et_search_term_clear (EtSearchTerm *term)
+{
+    g_free (term->normalized);
+    g_free (term->folded);
+
+    if (term->regex)
+    {
+        g_regex_unref (term->regex);
+    }
+}
+
+static gboolean
+et_search_query_add_term (EtSearchQuery *query,
+                          const gchar *value,
+                          guint fields,
+                          GError **error)
+{
+    EtSearchTerm term = { 0, };
+    gsize length;
+    gboolean regex;
+    gchar *normalized;
+
+    term.fields = fields;
+    length = strlen (value);
+
+    /* "/pattern/" is a regular expression. */
+    regex = length >= 2 && value[0] == '/' && value[length - 1] == '/';
+
+    /* The pattern is normalized as the text it is matched against. */
+    normalized = regex ? g_utf8_normalize (value + 1, length - 2,
+                                           G_NORMALIZE_DEFAULT)
+                       : g_utf8_normalize (value, -1, G_NORMALIZE_DEFAULT);
+
+    if (normalized == NULL)
+    {
+        g_set_error (error, G_CONVERT_ERROR, G_CONVERT_ERROR_ILLEGAL_SEQUENCE,
+                     _("The search string is not valid UTF-8"));
+        return FALSE;
+    }
+
+    if (regex)
+    {
+        term.regex = g_regex_new (normalized,
+                                  G_REGEX_OPTIMIZE
+                                  | (query->case_sensitive ? 0
+                                                           : G_REGEX_CASELESS),
+                                  0, error);
+        g_free (normalized);
+
+        if (term.regex == NULL)
+        {
+            return FALSE;
+        }
+    }
+    else
+    {
+        term.normalized = normalized;
+        term.folded = g_utf8_casefold (term.normalized, -1);
+    }
+
+    g_array_append_val (query->terms, term);
+
+    return TRUE;
+}
+
+/*
+ * Split @string into whitespace-separated words, keeping double-quoted
+ * parts together and removing the quotes.
+ */
+static gchar **
+et_search_query_tokenize (const gchar *string)
+{
+    GPtrArray *tokens;
+    GString *token;
+    gboolean quoted = FALSE;
+    const gchar *p;
+
+    tokens = g_ptr_array_new ();
+    token = g_string_new (NULL);
+
+    for (p = string; *p != '\0'; p++)
+    {
+        if (*p == '"')
+        {
+            quoted = !quoted;
+        }
+        else if (!quoted && g_ascii_isspace (*p))
+        {
+            if (token->len > 0)
+            {
+                g_ptr_array_add (tokens, g_strndup (token->str, token->len));
+                g_string_truncate (token, 0);
+            }
+        }
+        else
+        {
+            g_string_append_c (token, *p);
+        }
+    }
+
+    if (token->len > 0)
+    {
+        g_ptr_array_add (tokens, g_strndup (token->str, token->len));
+    }
+
+    g_string_free (token, TRUE);
+    g_ptr_array_add (tokens, NULL);
+
+    return (gchar **)g_ptr_array_free (tokens, FALSE);
+}
+
+/*
+ * Check if @token is of the form "field:value", and return the field mask
+ * and a pointer to the value if so.
+ */
+static gboolean
+et_search_query_parse_field (const gchar *token,
+                             guint *fields,
+                             const gchar **value)
+{
+    const gchar *colon;
+    gsize i;
+
+    colon = strchr (token, ':');
+
+    if (colon == NULL || colon == token)
+    {
+        return FALSE;
+    }
+
+    for (i = 0; i < G_N_ELEMENTS (field_names); i++)
+    {
+        if (strlen (field_names[i].name) == (gsize)(colon - token)
+            && g_ascii_strncasecmp (token, field_names[i].name,
+                                    colon - token) == 0)
+        {
+            *fields = ET_SEARCH_FIELD_MASK (field_names[i].field);
+            *value = colon + 1;
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+static gboolean
+et_search_token_is_regex (const gchar *token)
+{
+    gsize length = strlen (token);
+
+    return length >= 2 && token[0] == '/' && token[length - 1] == '/';
+}
+
+/*
+ * et_search_query_new:
+ * @string: the search string, in UTF-8
+ * @fields: mask of #EtSearchField values to search in by default
+ * @case_sensitive: whether to match case-sensitively
+ * @error: a #GError to provide information on errors, or %NULL to ignore
+ *
+ * Parse @string into a search query. A plain string is matched as a
+ * substring of any of @fields. If the string contains "field:value" words or
+ * "/pattern/" regular expressions, it is instead split into words, all of
+ * which must match. A word may be restricted to a single field, such as
+ * "artist:foo" or "album:\"foo bar\"", and may be a regular expression, such
+ * as "title:/^foo/".
+ *
+ * Returns: a new #EtSearchQuery, or %NULL on error
+ */
+EtSearchQuery *
+et_search_query_new (const gchar *string,
+                     guint fields,
+                     gboolean case_sensitive,
+                     GError **error)
+{
+    EtSearchQuery *query;
+    gchar **tokens;
+    gboolean structured = FALSE;
+    gsize i;
+
+    g_return_val_if_fail (string != NULL, NULL);
+    g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+    query = g_slice_new (EtSearchQuery);
+    query->case_sensitive = case_sensitive;
+    query->terms = g_array_new (FALSE, FALSE, sizeof (EtSearchTerm));
+    g_array_set_clear_func (query->terms, (GDestroyNotify)et_search_term_clear);
+
+    tokens = et_search_query_tokenize (string);
+
+    for (i = 0; tokens[i] != NULL; i++)
+    {
+        guint token_fields;
+        const gchar *value;
+
+        if (et_search_token_is_regex (tokens[i])
+            || et_search_query_parse_field (tokens[i], &token_fields, &value))
+        {
+            structured = TRUE;
+            break;
+        }
+    }
+
+    if (!structured)
+    {
+        /* Match the whole string, including any spaces. */
+        if (!et_search_query_add_term (query, string, fields, error))
+        {
+            goto err;
+        }
+    }
+    else
+    {
+        for (i = 0; tokens[i] != NULL; i++)
+        {
+            guint token_fields = fields;
+            const gchar *value = tokens[i];
+
+            et_search_query_parse_field (tokens[i], &token_fields, &value);
+
+            if (!et_search_query_add_term (query, value, token_fields, error))
+            {
+                goto err;
+            }
+        }
+    }
+
+    g_strfreev (tokens);
+
+    return query;
+
+err:
+    g_strfreev (tokens);
+    et_search_query_free (query);
+
+    return NULL;
+}
+
+void
+et_search_query_free (EtSearchQuery *query)
+{
+    g_return_if_fail (query != NULL);
+
+    g_array_unref (query->terms);
+    g_slice_free (EtSearchQuery, query);
+}
+
+/*
+ * Check @entry against all the terms of @query, and return the mask of the
+ * fields which matched. An empty term matches without adding to the mask.
+ */
+static gboolean
+et_search_entry_match (const EtSearchEntry *entry,
+                       const EtSearchQuery *query,
+                       guint *matched_fields)
+{
+    guint i;
+
+    *matched_fields = 0;
+
+    for (i = 0; i < query->terms->len; i++)
+    {
+        const EtSearchTerm *term;
+        gboolean matched = FALSE;
+        gsize field;
+
+        term = &g_array_index (query->terms, EtSearchTerm, i);
+
+        if (term->regex == NULL && *term->folded == '\0')
+        {
+            continue;
+        }
+
+        for (field = 0; field < ET_SEARCH_FIELD_COUNT; field++)
+        {
+            const gchar *text;
+
+            if (!(term->fields & ET_SEARCH_FIELD_MASK (field)))
+            {
+                continue;
+            }
+
+            if (term->regex)
+            {
+                /* Caseless matching is handled by the regex itself. */
+                text = et_search_entry_get_text (entry, field, FALSE);
+
+                if (text && g_regex_match (term->regex, text, 0, NULL))
+                {
+                    *matched_fields |= ET_SEARCH_FIELD_MASK (field);
+                    matched = TRUE;
+                }
+            }
+            else
+            {
+                text = et_search_entry_get_text (entry, field,
+                                                 !query->case_sensitive);
+
+                if (text
+                    && strstr (text, query->case_sensitive ? term->normalized
+                                                           : term->folded))
+                {
+                    *matched_fields |= ET_SEARCH_FIELD_MASK (field);
+                    matched = TRUE;
+                }
+            }
+        }
+
+        if (!matched)
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+static void
+et_search_collect_trigram (guint hash,
+                           gpointer user_data)
+{
+    GHashTable *trigrams = user_data;
+
+    g_hash_table_add (trigrams, GUINT_TO_POINTER (hash));
+}
+
+static gint
+et_search_compare_posting_length (gconstpointer a,
+                                  gconstpointer b)
+{
+    const GArray *posting_a = *(GArray * const *)a;
+    const GArray *posting_b = *(GArray * const *)b;
+
+    return (posting_a->len > posting_b->len) - (posting_a->len < posting_b->len);
+}
+
+/*
+ * Intersect the sorted id arrays @candidates and @posting into @candidates.
+ */
+static void
+et_search_intersect (GArray *candidates,
+                     const GArray *posting)
+{
+    guint i = 0;
+    guint j = 0;
+    guint n = 0;
+
+    while (i < candidates->len && j < posting->len)
+    {
+        guint a = g_array_index (candidates, guint, i);
+        guint b = g_array_index (posting, guint, j);
+
+        if (a < b)
+        {
+            i++;
+        }
+        else if (a > b)
+        {
+            j++;
+        }
+        else
+        {
+            g_array_index (candidates, guint, n++) = a;
+            i++;
+            j++;
+        }
+    }
+
+    g_array_set_size (candidates, n);
+}
+
+/*
+ * Find the ids of the entries which contain all the trigrams of the literal
+ * terms of @query. Returns %NULL if the query has no trigrams, in which case
+ * every entry is a candidate.
+ */
+static GArray *
+et_search_index_get_candidates (EtSearchIndex *search_index,
+                                const EtSearchQuery *query)
+{
+    GHashTable *trigrams;
+    GPtrArray *postings;
+    GHashTableIter iter;
+    gpointer key;
+    GArray *candidates;
+    guint i;
+
+    trigrams = g_hash_table_new (NULL, NULL);
+
+    for (i = 0; i < query->terms->len; i++)
+    {
+        const EtSearchTerm *term = &g_array_index (query->terms, EtSearchTerm,
+                                                   i);
+
+        /* Trigrams are taken from the casefolded text, which is also valid
+         * for case-sensitive matching, as casefolding is done per
+         * character. */
+        if (term->folded)
+        {
+            et_search_foreach_trigram (term->folded, et_search_collect_trigram,
+                                       trigrams);
+        }
+    }
+
+    if (g_hash_table_size (trigrams) == 0)
+    {
+        g_hash_table_unref (trigrams);
+        return NULL;
+    }
+
+    postings = g_ptr_array_sized_new (g_hash_table_size (trigrams));
+    g_hash_table_iter_init (&iter, trigrams);
+
+    while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+        GArray *posting = g_hash_table_lookup (search_index->postings, key);
+
+        if (posting == NULL)
+        {
+            /* No entry contains this trigram. */
+            g_ptr_array_set_size (postings, 0);
+            break;
+        }
+
+        g_ptr_array_add (postings, posting);
+    }
+
+    g_hash_table_unref (trigrams);
+
+    candidates = g_array_new (FALSE, FALSE, sizeof (guint));
+
+    if (postings->len > 0)
+    {
+        const GArray *shortest;
+
+        /* Start from the shortest list, so that the intermediate results are
+         * as small as possible. */
+        g_ptr_array_sort (postings, et_search_compare_posting_length);
+        shortest = g_ptr_array_index (postings, 0);
+        g_array_append_vals (candidates, shortest->data, shortest->len);
+
+        for (i = 1; i < postings->len && candidates->len > 0; i++)
+        {
+            et_search_intersect (candidates, g_ptr_array_index (postings, i));
+        }
+    }
+
+    g_ptr_array_free (postings, TRUE);
+
+    return candidates;
+}
+
+static gint
+et_search_compare_entry_position (gconstpointer a,
+                                  gconstpointer b)
+{
+    const EtSearchEntry *entry_a = *(EtSearchEntry * const *)a;
+    const EtSearchEntry *entry_b = *(EtSearchEntry * const *)b;
+
+    return (entry_a->position > entry_b->position)
+           - (entry_a->position < entry_b->position);
+}
+
+/*
+ * Get the live entries sorted by position, rebuilding the array if the index
+ * changed since the last query.
+ */
+static GPtrArray *
+et_search_index_get_by_position (EtSearchIndex *search_index)
+{
+    guint i;
+
+    if (search_index->by_position)
+    {
+        return search_index->by_position;
+    }
+
+    search_index->by_position = g_ptr_array_sized_new (g_hash_table_size (search_index->items));
+
+    for (i = 0; i < search_index->entries->len; i++)
+    {
+        EtSearchEntry *entry = g_ptr_array_index (search_index->entries, i);
+
+        if (entry)
+        {
+            g_ptr_array_add (search_index->by_position, entry);
+        }
+    }
+
+    g_ptr_array_sort (search_index->by_position,
+                      et_search_compare_entry_position);
+
+    return search_index->by_position;
+}
+
+/*
+ * et_search_index_query_batched:
+ * @search_index: the search index
+ * @query: the query to run
+ * @batch_size: the maximum number of results to pass to @func at once
+ * @func: function to call with each batch of results
+ * @user_data: user data to pass to @func
+ * @cancellable: a #GCancellable, or %NULL
+ *
+ * Find the items in @search_index which match @query, in order of position.
+ * Candidates are taken from the trigram posting lists where the query allows
+ * it, and are then checked against the stored text of each field. @func is
+ * called with each batch of results, and periodically with an empty batch to
+ * report progress, in the thread which called this function, without the
+ * lock held. The lock is also released between chunks of entries, so that
+ * other threads may prepare an update meanwhile. The query stops if an entry
+ * was retired in between, as the entries which it was checking may be
+ * freed.
+ *
+ * Returns: %TRUE if the query ran to completion, %FALSE if it was cancelled
+ * or the index changed
+ */
+gboolean
+et_search_index_query_batched (EtSearchIndex *search_index,
+                               const EtSearchQuery *query,
+                               guint batch_size,
+                               EtSearchResultsFunc func,
+                               gpointer user_data,
+                               GCancellable *cancellable)
+{
+    GArray *candidates;
+    GPtrArray *entries;
+    GArray *batch;
+    guint n_items;
+    guint generation;
+    guint i;
+    gboolean completed = TRUE;
+
+    g_return_val_if_fail (search_index != NULL, FALSE);
+    g_return_val_if_fail (query != NULL, FALSE);
+    g_return_val_if_fail (batch_size > 0, FALSE);
+    g_return_val_if_fail (func != NULL, FALSE);
+
+    g_mutex_lock (&search_index->lock);
+
+    generation = search_index->generation;
+    n_items = g_hash_table_size (search_index->items);
+    candidates = et_search_index_get_candidates (search_index, query);
+
+    if (candidates)
+    {
+        entries = g_ptr_array_sized_new (candidates->len);
+
+        for (i = 0; i < candidates->len; i++)
+        {
+            EtSearchEntry *entry;
+
+            entry = g_ptr_array_index (search_index->entries,
+                                       g_array_index (candidates, guint, i));
+
+            /* Retired ids are still in the posting lists. */
+            if (entry)
+            {
+                g_ptr_array_add (entries, entry);
+            }
+        }
+
+        g_array_unref (candidates);
+        g_ptr_array_sort (entries, et_search_compare_entry_position);
+    }
+    else
+    {
+        entries = g_ptr_array_ref (et_search_index_get_by_position (search_index));
+    }
+
+    batch = g_array_sized_new (FALSE, FALSE, sizeof (EtSearchResult),
+                               batch_size);
+
+    for (i = 0; i < entries->len; i++)
+    {
+        const EtSearchEntry *entry = g_ptr_array_index (entries, i);
+        guint fields;
+
+        if (i % ET_SEARCH_CANCEL_INTERVAL == 0)
+        {
+            if (i > 0)
+            {
+                g_mutex_unlock (&search_index->lock);
+                g_thread_yield ();
+                g_mutex_lock (&search_index->lock);
+            }
+
+            if (g_cancellable_is_cancelled (cancellable)
+                || search_index->generation != generation)
+            {
+                completed = FALSE;
+                break;
+            }
+        }
+
+        if (et_search_entry_match (entry, query, &fields))
+        {
+            EtSearchResult result;
+
+            result.item = entry->item;
+            result.position = entry->position;
+            result.fields = fields;
+            g_array_append_val (batch, result);
+        }
+
+        if (batch->len == batch_size
+            || (i + 1) % ET_SEARCH_PROGRESS_INTERVAL == 0)
+        {
+            /* Candidates stand for the whole index, as all the other entries
+             * are already known not to match. */
+            g_mutex_unlock (&search_index->lock);
+            func ((EtSearchResult *)batch->data, batch->len,
+                  (guint)((guint64)n_items * (i + 1) / entries->len),
+                  user_data);
+            g_mutex_lock (&search_index->lock);
+            g_array_set_size (batch, 0);
+
+            if (g_cancellable_is_cancelled (cancellable)
+                || search_index->generation != generation)
+            {
+                completed = FALSE;
+                break;
+            }
+        }
+    }
+
+    g_mutex_unlock (&search_index->lock);
+
+    if (completed)
+    {
+        func ((EtSearchResult *)batch->data, batch->len, n_items, user_data);
+    }
+
+    g_array_unref (batch);
+    g_ptr_array_unref (entries);
+
+    return completed;
+}
+
+static void
+et_search_append_results (const EtSearchResult *results,
+                          guint n_results,
+                          guint n_searched,
+                          gpointer user_data)
+{
+    g_array_append_vals ((GArray *)user_data, results, n_results);
+}
+
+/*
+ * et_search_index_query:
+ * @search_index: the search index
+ * @query: the query to run
+ *
+ * Find the items in @search_index which match @query. See
+ * et_search_index_query_batched().
+ *
+ * Returns: (element-type EtSearchResult): the results, sorted by position.
+ * Free with g_array_unref()
+ */
+GArray *
+et_search_index_query (EtSearchIndex *search_index,
+                       const EtSearchQuery *query)
+{
+    GArray *results;
+
+    g_return_val_if_fail (search_index != NULL, NULL);
+    g_return_val_if_fail (query != NULL, NULL);
+
+    results = g_array_new (FALSE, FALSE, sizeof (EtSearchResult));
+    et_search_index_query_batched (search_index, query, 1024,
+                                   et_search_append_results, results, NULL);
+
+    return results;
+}
@@ -0,0 +1,105 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ET_SEARCH_H_
+#define ET_SEARCH_H_
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/*
+ * EtSearchField:
+ * @ET_SEARCH_FIELD_FILENAME: basename of the file
+ * @ET_SEARCH_FIELD_TITLE: title tag field
+ *
+ * The fields which are stored in an #EtSearchIndex, in the order in which
+ * they are passed to et_search_index_update().
+ */
+typedef enum
+{
+    ET_SEARCH_FIELD_FILENAME = 0,
+    ET_SEARCH_FIELD_TITLE,
+    ET_SEARCH_FIELD_ARTIST,
+    ET_SEARCH_FIELD_ALBUM_ARTIST,
+    ET_SEARCH_FIELD_ALBUM,
+    ET_SEARCH_FIELD_DISC_NUMBER,
+    ET_SEARCH_FIELD_DISC_TOTAL,
+    ET_SEARCH_FIELD_YEAR,
+    ET_SEARCH_FIELD_TRACK,
+    ET_SEARCH_FIELD_TRACK_TOTAL,
+    ET_SEARCH_FIELD_GENRE,
+    ET_SEARCH_FIELD_COMMENT,
+    ET_SEARCH_FIELD_COMPOSER,
+    ET_SEARCH_FIELD_ORIG_ARTIST,
+    ET_SEARCH_FIELD_COPYRIGHT,
+    ET_SEARCH_FIELD_URL,
+    ET_SEARCH_FIELD_ENCODED_BY,
+    ET_SEARCH_FIELD_COUNT
+} EtSearchField;
+
+#define ET_SEARCH_FIELD_MASK(field) (1u << (field))
+#define ET_SEARCH_FIELD_MASK_FILENAME ET_SEARCH_FIELD_MASK (ET_SEARCH_FIELD_FILENAME)
+#define ET_SEARCH_FIELD_MASK_ALL ((1u << ET_SEARCH_FIELD_COUNT) - 1)
+#define ET_SEARCH_FIELD_MASK_TAG (ET_SEARCH_FIELD_MASK_ALL & ~ET_SEARCH_FIELD_MASK_FILENAME)
+
+typedef struct _EtSearchIndex EtSearchIndex;
+typedef struct _EtSearchQuery EtSearchQuery;
+typedef struct _EtSearchUpdate EtSearchUpdate;
+
+/*
+ * EtSearchResult:
+ * @item: the item which matched, as passed to et_search_index_update()
+ * @position: the position of @item, used to order the results
+ * @fields: mask of the #EtSearchField values in which the query matched
+ */
+typedef struct
+{
+    gpointer item;
+    guint position;
+    guint fields;
+} EtSearchResult;
+
+/*
+ * EtSearchResultsFunc:
+ * @results: a batch of results
+ * @n_results: the number of results in @results, which may be zero
+ * @n_searched: the number of items in the index which were searched so far
+ * @user_data: user data passed to et_search_index_query_batched()
+ */
+typedef void (*EtSearchResultsFunc) (const EtSearchResult *results, guint n_results, guint n_searched, gpointer user_data);
+
+EtSearchIndex * et_search_index_new (void);
+EtSearchIndex * et_search_index_ref (EtSearchIndex *search_index);
+void et_search_index_unref (EtSearchIndex *search_index);
+void et_search_index_update (EtSearchIndex *search_index, gpointer item, guint position, const gchar * const *fields);
+void et_search_index_remove (EtSearchIndex *search_index, gpointer item);
+guint et_search_index_get_n_items (EtSearchIndex *search_index);
+void et_search_index_sync_file_list (EtSearchIndex *search_index, GList *file_list);
+EtSearchUpdate * et_search_index_prepare_file_list (EtSearchIndex *search_index, GList *file_list);
+gboolean et_search_index_apply_update (EtSearchIndex *search_index, const EtSearchUpdate *update, GCancellable *cancellable);
+void et_search_update_free (EtSearchUpdate *update);
+GArray * et_search_index_query (EtSearchIndex *search_index, const EtSearchQuery *query);
+gboolean et_search_index_query_batched (EtSearchIndex *search_index, const EtSearchQuery *query, guint batch_size, EtSearchResultsFunc func, gpointer user_data, GCancellable *cancellable);
+
+EtSearchQuery * et_search_query_new (const gchar *string, guint fields, gboolean case_sensitive, GError **error);
+void et_search_query_free (EtSearchQuery *query);
+
+G_END_DECLS
+
+#endif /* !ET_SEARCH_H_ */
@@ -30,6 +30,7 @@
 #include "misc.h"
 #include "picture.h"
 #include "scan_dialog.h"
+#include "search.h"
 #include "setting.h"
 
 typedef struct
@@ -44,8 +45,54 @@ typedef struct
     GtkListStore *search_results_model;
     GtkWidget *status_bar;
     guint status_bar_context;
+    EtSearchIndex *search_index;
+    struct _EtSearchRun *search_run;
 } EtSearchDialogPrivate;
 
+/* Number of results sent from the search thread to the dialog at once. */
+#define SEARCH_BATCH_SIZE 256
+
+/*
+ * EtSearchRun:
+ * @dialog: the dialog showing the results, or %NULL if it was destroyed
+ * @files: set of the files which were searched, or %NULL once the search was
+ *         cancelled. The search is cancelled before any file is removed from
+ *         the list of files, so the results never point to a freed file
+ * @n_found: number of rows added to the results list
+ *
+ * The state of one search, shared between the dialog and the search thread.
+ * Only @search_index, @query, @update and @cancellable are used from the
+ * search thread; the other fields are only used from the main thread.
+ */
+typedef struct _EtSearchRun
+{
+    volatile gint ref_count;
+    EtSearchDialog *dialog;
+    EtSearchIndex *search_index;
+    EtSearchQuery *query;
+    EtSearchUpdate *update;
+    GCancellable *cancellable;
+    GHashTable *files;
+    gint64 start_time;
+    guint n_found;
+} EtSearchRun;
+
+/*
+ * EtSearchBatch:
+ * @results: the results found since the previous batch
+ * @n_searched: number of files searched so far
+ * @n_items: number of files in the index
+ * @done: whether the search completed
+ */
+typedef struct
+{
+    EtSearchRun *run;
+    GArray *results;
+    guint n_searched;
+    guint n_items;
+    gboolean done;
+} EtSearchBatch;
+
 G_DEFINE_TYPE_WITH_PRIVATE (EtSearchDialog, et_search_dialog, GTK_TYPE_DIALOG)
 
 enum
@@ -158,17 +205,16 @@ Search_Result_List_Row_Selected (GtkTreeSelection *selection,
 /*
  * Add_Row_To_Search_Result_List:
  * @self: an #EtSearchDialog
- * @ETFile: a file with tags in which to search
- * @string_to_search: the search term
+ * @ETFile: a file which matched the search
+ * @fields: mask of the #EtSearchField values which matched
  *
- * Search for the given @string_to_search in tags and the filename from
- * @ETFile. Add the result row, corresctly-formatted to highlight matches, to
- * the tree view in @self.
+ * Add the result row for @ETFile, correctly-formatted to highlight the
+ * @fields which matched, to the tree view in @self.
  */
 static void
 Add_Row_To_Search_Result_List (EtSearchDialog *self,
                                const ET_File *ETFile,
-                               const gchar *string_to_search)
+                               guint fields)
 {
     EtSearchDialogPrivate *priv;
     const gchar *haystacks[15]; /* 15 columns to display. */
@@ -182,6 +228,27 @@ Add_Row_To_Search_Result_List (EtSearchDialog *self,
                          PANGO_WEIGHT_NORMAL };
     GdkRGBA *colors[15] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
                             NULL, NULL, NULL, NULL, NULL, NULL, NULL};
+    /* The search fields shown in each column. */
+    static const guint column_fields[15] =
+    {
+        ET_SEARCH_FIELD_MASK (ET_SEARCH_FIELD_FILENAME),
+        ET_SEARCH_FIELD_MASK (ET_SEARCH_FIELD_TITLE),
+        ET_SEARCH_FIELD_MASK (ET_SEARCH_FIELD_ARTIST),
+        ET_SEARCH_FIELD_MASK (ET_SEARCH_FIELD_ALBUM_ARTIST),
+        ET_SEARCH_FIELD_MASK (ET_SEARCH_FIELD_ALBUM),
+        ET_SEARCH_FIELD_MASK (ET_SEARCH_FIELD_DISC_NUMBER)
+        | ET_SEARCH_FIELD_MASK (ET_SEARCH_FIELD_DISC_TOTAL),
+        ET_SEARCH_FIELD_MASK (ET_SEARCH_FIELD_YEAR),
+        ET_SEARCH_FIELD_MASK (ET_SEARCH_FIELD_TRACK)
+        | ET_SEARCH_FIELD_MASK (ET_SEARCH_FIELD_TRACK_TOTAL),
+        ET_SEARCH_FIELD_MASK (ET_SEARCH_FIELD_GENRE),
+        ET_SEARCH_FIELD_MASK (ET_SEARCH_FIELD_COMMENT),
+        ET_SEARCH_FIELD_MASK (ET_SEARCH_FIELD_COMPOSER),
+        ET_SEARCH_FIELD_MASK (ET_SEARCH_FIELD_ORIG_ARTIST),
+        ET_SEARCH_FIELD_MASK (ET_SEARCH_FIELD_COPYRIGHT),
+        ET_SEARCH_FIELD_MASK (ET_SEARCH_FIELD_URL),
+        ET_SEARCH_FIELD_MASK (ET_SEARCH_FIELD_ENCODED_BY)
+    };
     gchar *display_basename;
     const gchar *track;
     const gchar *track_total;
@@ -189,15 +256,15 @@ Add_Row_To_Search_Result_List (EtSearchDialog *self,
     const gchar *disc_total;
     gchar *discs = NULL;
     gchar *tracks = NULL;
-    gboolean case_sensitive;
+    gboolean changed_bold;
     gsize column;
 
     priv = et_search_dialog_get_instance_private (self);
 
-    if (!ETFile || !string_to_search)
+    if (!ETFile)
         return;
 
-    case_sensitive = g_settings_get_boolean (MainSettings, "search-case-sensitive");
+    changed_bold = g_settings_get_boolean (MainSettings, "file-changed-bold");
 
     /* Most fields can be taken from the tag as-is. */
     haystacks[SEARCH_RESULT_TITLE] = ((File_Tag *)ETFile->FileTag->data)->title;
@@ -214,7 +281,7 @@ Add_Row_To_Search_Result_List (EtSearchDialog *self,
     haystacks[SEARCH_RESULT_ENCODED_BY] = ((File_Tag *)ETFile->FileTag->data)->encoded_by;
 
     /* Some fields need extra allocations. */
-    display_basename = g_path_get_basename (((File_Name *)ETFile->FileNameNew->data)->value_utf8);
+    display_basename = g_strdup (((File_Name *)ETFile->FileNameNew->data)->name_utf8);
     haystacks[SEARCH_RESULT_FILENAME] = display_basename;
 
     /* Disc Number. */
@@ -259,69 +326,21 @@ Add_Row_To_Search_Result_List (EtSearchDialog *self,
         haystacks[SEARCH_RESULT_TRACK] = NULL;
     }
 
-    /* Highlight the keywords in the result list. Don't display files in red if
-     * the searched string is '' (to display all files). */
+    /* Highlight the fields which matched in the result list. The mask is
+     * empty if the searched string is '' (to display all files). */
     for (column = 0; column < G_N_ELEMENTS (haystacks); column++)
     {
-        gchar *needle;
-        gchar *haystack;
-
-        /* Already checked if string_to_search is NULL. */
-        needle = g_utf8_normalize (string_to_search, -1, G_NORMALIZE_DEFAULT);
-        haystack = haystacks[column] ? g_utf8_normalize (haystacks[column], -1,
-                                                         G_NORMALIZE_DEFAULT)
-                                     : NULL;
-
-        if (case_sensitive)
+        if (fields & column_fields[column])
         {
-            if (haystack && !et_str_empty (needle)
-                && strstr (haystack, needle))
+            if (changed_bold)
             {
-
-                if (g_settings_get_boolean (MainSettings, "file-changed-bold"))
-                {
-                    weights[column] = PANGO_WEIGHT_BOLD;
-                }
-                else
-                {
-                    colors[column] = &RED;
-                }
+                weights[column] = PANGO_WEIGHT_BOLD;
             }
-        }
-        else
-        {
-            /* Search wasn't case-sensitive. */
-            gchar *list_text;
-            gchar *string_to_search2;
-
-            if (!haystack)
-            {
-                g_free (needle);
-                continue;
-            }
-
-            string_to_search2 = g_utf8_casefold (needle, -1);
-            list_text = g_utf8_casefold (haystack, -1);
-
-            if (!et_str_empty (string_to_search2)
-                && strstr (list_text, string_to_search2))
+            else
             {
-                if (g_settings_get_boolean (MainSettings, "file-changed-bold"))
-                {
-                    weights[column] = PANGO_WEIGHT_BOLD;
-                }
-                else
-                {
-                    colors[column] = &RED;
-                }
+                colors[column] = &RED;
             }
-
-            g_free(list_text);
-            g_free(string_to_search2);
         }
-
-        g_free (haystack);
-        g_free (needle);
     }
 
     /* Load the row in the list. */
@@ -382,17 +401,237 @@ Add_Row_To_Search_Result_List (EtSearchDialog *self,
     g_free (tracks);
 }
 
+static EtSearchRun *
+et_search_run_ref (EtSearchRun *run)
+{
+    g_atomic_int_inc (&run->ref_count);
+
+    return run;
+}
+
+static void
+et_search_run_unref (EtSearchRun *run)
+{
+    if (!g_atomic_int_dec_and_test (&run->ref_count))
+    {
+        return;
+    }
+
+    et_search_index_unref (run->search_index);
+    et_search_query_free (run->query);
+    et_search_update_free (run->update);
+    g_object_unref (run->cancellable);
+
+    if (run->files)
+    {
+        g_hash_table_unref (run->files);
+    }
+
+    g_slice_free (EtSearchRun, run);
+}
+
 /*
- * This function and the one below could do with improving
- * as we are looking up tag data twice (once when searching, once when adding to list)
+ * et_search_run_cancel:
+ * @run: (transfer full): the search to stop
+ *
+ * Stop @run, and detach it from its dialog, so that batches which are already
+ * queued in the main loop are dropped. The set of files which were searched
+ * is dropped too, as they may be freed once the search is cancelled.
  */
+static void
+et_search_run_cancel (EtSearchRun *run)
+{
+    g_cancellable_cancel (run->cancellable);
+    run->dialog = NULL;
+    g_hash_table_unref (run->files);
+    run->files = NULL;
+    et_search_run_unref (run);
+}
+
+static void
+et_search_batch_free (gpointer data)
+{
+    EtSearchBatch *batch = data;
+
+    et_search_run_unref (batch->run);
+    g_array_unref (batch->results);
+    g_slice_free (EtSearchBatch, batch);
+}
+
+/*
+ * on_search_batch:
+ * @user_data: an #EtSearchBatch
+ *
+ * Add a batch of results from the search thread to the results list, and
+ * show the progress of the search in the statusbar.
+ *
+ * Returns: %G_SOURCE_REMOVE
+ */
+static gboolean
+on_search_batch (gpointer user_data)
+{
+    EtSearchBatch *batch = user_data;
+    EtSearchRun *run = batch->run;
+    EtSearchDialogPrivate *priv;
+    gdouble seconds;
+    gdouble rate;
+    gchar *msg;
+    guint i;
+
+    if (run->dialog == NULL || g_cancellable_is_cancelled (run->cancellable))
+    {
+        return G_SOURCE_REMOVE;
+    }
+
+    priv = et_search_dialog_get_instance_private (run->dialog);
+
+    for (i = 0; i < batch->results->len; i++)
+    {
+        const EtSearchResult *result = &g_array_index (batch->results,
+                                                       EtSearchResult, i);
+
+        if (!g_hash_table_contains (run->files, result->item))
+        {
+            continue;
+        }
+
+        Add_Row_To_Search_Result_List (run->dialog, (ET_File *)result->item,
+                                       result->fields);
+        run->n_found++;
+    }
+
+    gtk_widget_set_sensitive (GTK_WIDGET (priv->search_results_view),
+                              run->n_found > 0);
+
+    seconds = (g_get_monotonic_time () - run->start_time) / (gdouble)G_USEC_PER_SEC;
+    rate = seconds > 0 ? batch->n_searched / seconds : 0;
+
+    if (batch->done)
+    {
+        gchar *found;
+
+        found = g_strdup_printf (ngettext ("Found one file", "Found %u files",
+                                           run->n_found), run->n_found);
+        msg = g_strdup_printf (_("%s (%.0f files/s)"), found, rate);
+        g_free (found);
+    }
+    else
+    {
+        msg = g_strdup_printf (_("Searching… %u of %u files (%.0f files/s)"),
+                               batch->n_searched, batch->n_items, rate);
+    }
+
+    gtk_statusbar_remove_all (GTK_STATUSBAR (priv->status_bar),
+                              priv->status_bar_context);
+    gtk_statusbar_push (GTK_STATUSBAR (priv->status_bar),
+                        priv->status_bar_context, msg);
+    g_free (msg);
+
+    if (batch->done && priv->search_run == run)
+    {
+        priv->search_run = NULL;
+        et_search_run_unref (run);
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+/*
+ * et_search_run_post_batch:
+ *
+ * Send a batch of results from the search thread to the main loop.
+ */
+static void
+et_search_run_post_batch (EtSearchRun *run,
+                          const EtSearchResult *results,
+                          guint n_results,
+                          guint n_searched,
+                          guint n_items,
+                          gboolean done)
+{
+    EtSearchBatch *batch;
+
+    batch = g_slice_new (EtSearchBatch);
+    batch->run = et_search_run_ref (run);
+    batch->results = g_array_sized_new (FALSE, FALSE, sizeof (EtSearchResult),
+                                        n_results);
+    g_array_append_vals (batch->results, results, n_results);
+    batch->n_searched = n_searched;
+    batch->n_items = n_items;
+    batch->done = done;
+
+    g_main_context_invoke_full (NULL, G_PRIORITY_DEFAULT_IDLE, on_search_batch,
+                                batch, et_search_batch_free);
+}
+
+typedef struct
+{
+    EtSearchRun *run;
+    guint n_items;
+} EtSearchThreadData;
+
+static void
+on_search_results (const EtSearchResult *results,
+                   guint n_results,
+                   guint n_searched,
+                   gpointer user_data)
+{
+    EtSearchThreadData *data = user_data;
+
+    et_search_run_post_batch (data->run, results, n_results, n_searched,
+                              data->n_items, FALSE);
+}
+
+/*
+ * search_thread_func:
+ *
+ * Index the files which changed since the previous search and run the query,
+ * streaming the results back to the main loop in batches.
+ */
+static void
+search_thread_func (GTask *task,
+                    gpointer source_object,
+                    gpointer task_data,
+                    GCancellable *cancellable)
+{
+    EtSearchRun *run = task_data;
+    EtSearchThreadData data;
+    gboolean completed;
+
+    if (!et_search_index_apply_update (run->search_index, run->update,
+                                       cancellable))
+    {
+        /* Cancelled, or superseded by a newer search. */
+        g_task_return_boolean (task, FALSE);
+        return;
+    }
+
+    data.run = run;
+    data.n_items = et_search_index_get_n_items (run->search_index);
+
+    completed = et_search_index_query_batched (run->search_index, run->query,
+                                               SEARCH_BATCH_SIZE,
+                                               on_search_results, &data,
+                                               cancellable);
+
+    if (completed)
+    {
+        et_search_run_post_batch (run, NULL, 0, data.n_items, data.n_items,
+                                  TRUE);
+    }
+
+    g_task_return_boolean (task, completed);
+}
+
 /*
  * Search_File:
  * @search_button: the search button which was clicked
  * @user_data: the #EtSearchDialog which contains @search_button
  *
  * Search for the search term (in the search entry of @user_data) in the list
- * of open files.
+ * of open files. Only the files which changed since the previous search are
+ * indexed again, in a thread which then streams the results back to the
+ * dialog. Starting a new search cancels the previous one.
  */
 static void
 Search_File (GtkWidget *search_button,
@@ -401,10 +640,14 @@ Search_File (GtkWidget *search_button,
     EtSearchDialog *self;
     EtSearchDialogPrivate *priv;
     const gchar *string_to_search = NULL;
+    const EtSettingsSnapshot *settings;
+    EtSearchQuery *query;
+    EtSearchRun *run;
+    GTask *task;
     GList *l;
-    const ET_File *ETFile;
+    guint fields = 0;
     gchar *msg;
-    gint resultCount = 0;
+    GError *error = NULL;
 
     self = ET_SEARCH_DIALOG (user_data);
     priv = et_search_dialog_get_instance_private (self);
@@ -419,237 +662,70 @@ Search_File (GtkWidget *search_button,
 
     Add_String_To_Combo_List (priv->search_string_model, string_to_search);
 
-    gtk_widget_set_sensitive (GTK_WIDGET (search_button), FALSE);
-    gtk_list_store_clear (priv->search_results_model);
-    gtk_statusbar_push (GTK_STATUSBAR (priv->status_bar),
-                        priv->status_bar_context, "");
-
-    for (l = ETCore->ETFileList; l != NULL; l = g_list_next (l))
+    if (priv->search_run)
     {
-        ETFile = (ET_File *)l->data;
-
-        /* Search in the filename. */
-        if (g_settings_get_boolean (MainSettings, "search-filename"))
-        {
-            const gchar *filename_utf8 = ((File_Name *)ETFile->FileNameNew->data)->value_utf8;
-            gchar *basename;
-            gchar *haystack;
-            gchar *needle;
+        et_search_run_cancel (priv->search_run);
+        priv->search_run = NULL;
+    }
 
-            basename = g_path_get_basename (filename_utf8);
+    gtk_list_store_clear (priv->search_results_model);
+    gtk_widget_set_sensitive (GTK_WIDGET (priv->search_results_view), FALSE);
+    gtk_statusbar_remove_all (GTK_STATUSBAR (priv->status_bar),
+                              priv->status_bar_context);
 
-            /* To search without case sensitivity. */
-            if (!g_settings_get_boolean (MainSettings, "search-case-sensitive"))
-            {
-                haystack = g_utf8_casefold (basename, -1);
-                needle = g_utf8_casefold (string_to_search, -1);
-            }
-            else
-            {
-                haystack = g_utf8_normalize (basename, -1, G_NORMALIZE_DEFAULT);
-                needle = g_utf8_normalize (string_to_search, -1,
-                                           G_NORMALIZE_DEFAULT);
-            }
+    settings = et_settings_get_snapshot ();
 
-            g_free (basename);
+    if (settings->search_filename)
+    {
+        fields |= ET_SEARCH_FIELD_MASK_FILENAME;
+    }
 
-            if (haystack && strstr (haystack, needle))
-            {
-                Add_Row_To_Search_Result_List (self, ETFile, needle);
-                g_free (haystack);
-                g_free (needle);
-                continue;
-            }
+    if (settings->search_tag)
+    {
+        fields |= ET_SEARCH_FIELD_MASK_TAG;
+    }
 
-            g_free (haystack);
-            g_free (needle);
-        }
+    query = et_search_query_new (string_to_search, fields,
+                                 settings->search_case_sensitive, &error);
 
-        /* Search in the tag. */
-        if (g_settings_get_boolean (MainSettings, "search-tag"))
-        {
-            gchar *title2, *artist2, *album_artist2, *album2, *disc_number2,
-                  *disc_total2, *year2, *track2, *track_total2, *genre2,
-                  *comment2, *composer2, *orig_artist2, *copyright2, *url2,
-                  *encoded_by2;
-            gchar *needle;
-            const File_Tag *FileTag = (File_Tag *)ETFile->FileTag->data;
-
-            if (!g_settings_get_boolean (MainSettings, "search-case-sensitive"))
-            {
-                /* To search without case sensitivity. */
-                title2 = FileTag->title ? g_utf8_casefold (FileTag->title, -1)
-                                        : NULL;
-                artist2 = FileTag->artist ? g_utf8_casefold (FileTag->artist,
-                                                             -1)
-                                          : NULL;
-                album_artist2 = FileTag->album_artist ? g_utf8_casefold (FileTag->album_artist,
-                                                                         -1)
-                                          : NULL;
-                album2 = FileTag->album ? g_utf8_casefold (FileTag->album, -1)
-                                          : NULL;
-                disc_number2 = FileTag->disc_number ? g_utf8_casefold (FileTag->disc_number,
-                                                                       -1)
-                                                    : NULL;
-                disc_total2 = FileTag->disc_total ? g_utf8_casefold (FileTag->disc_total,
-                                                                     -1)
-                                                  : NULL;
-                year2 = FileTag->year ? g_utf8_casefold (FileTag->year, -1)
-                                      : NULL;
-                track2 = FileTag->track ? g_utf8_casefold (FileTag->track, -1)
-                                        : NULL;
-                track_total2 = FileTag->track_total ? g_utf8_casefold (FileTag->track_total,
-                                                                       -1)
-                                                    : NULL;
-                genre2 = FileTag->genre ? g_utf8_casefold (FileTag->genre, -1)
-                                        : NULL;
-                comment2 = FileTag->comment ? g_utf8_casefold (FileTag->comment,
-                                                               -1)
-                                            : NULL;
-                composer2 = FileTag->composer ? g_utf8_casefold (FileTag->composer,
-                                                                 -1)
-                                              : NULL;
-                orig_artist2 = FileTag->orig_artist ? g_utf8_casefold (FileTag->orig_artist,
-                                                                       -1)
-                                                    : NULL;
-                copyright2 = FileTag->copyright ? g_utf8_casefold (FileTag->copyright,
-                                                                   -1)
-                                                : NULL;
-                url2 = FileTag->url ? g_utf8_casefold (FileTag->url, -1)
-                                    : NULL;
-                encoded_by2 = FileTag->encoded_by ? g_utf8_casefold (FileTag->encoded_by,
-                                                                     -1)
-                                                  : NULL;
-                needle = g_utf8_casefold (string_to_search, -1);
-            }
-            else
-            {
-                /* To search with case-sensitivity. */
-                title2 = FileTag->disc_number ? g_utf8_normalize (FileTag->title,
-                                                                  -1,
-                                                                  G_NORMALIZE_DEFAULT)
-                                              : NULL;
-                artist2 = FileTag->artist ? g_utf8_normalize (FileTag->artist,
-                                                              -1,
-                                                              G_NORMALIZE_DEFAULT)
-                                          : NULL;
-                album_artist2 = FileTag->album_artist ? g_utf8_normalize (FileTag->album_artist,
-                                                                          -1,
-                                                                          G_NORMALIZE_DEFAULT)
-                                                      : NULL;
-                album2 = FileTag->album ? g_utf8_normalize (FileTag->album, -1,
-                                                            G_NORMALIZE_DEFAULT)
-                                        : NULL;
-                disc_number2 = FileTag->disc_number ? g_utf8_normalize (FileTag->disc_number,
-                                                                        -1,
-                                                                        G_NORMALIZE_DEFAULT)
-                                                     : NULL;
-                disc_total2 = FileTag->disc_total ? g_utf8_normalize (FileTag->disc_total,
-                                                                      -1,
-                                                                      G_NORMALIZE_DEFAULT)
-                                                  : NULL;
-                year2 = FileTag->year ? g_utf8_normalize (FileTag->year, -1,
-                                                          G_NORMALIZE_DEFAULT)
-                                      : NULL;
-                track2 = FileTag->track ? g_utf8_normalize (FileTag->track, -1,
-                                                            G_NORMALIZE_DEFAULT)
-                                        : NULL;
-                track_total2 = FileTag->track_total ? g_utf8_normalize (FileTag->track_total,
-                                                                        -1,
-                                                                        G_NORMALIZE_DEFAULT)
-                                                    : NULL;
-                genre2 = FileTag->genre ? g_utf8_normalize (FileTag->genre, -1,
-                                                            G_NORMALIZE_DEFAULT)
-                                        : NULL;
-                comment2 = FileTag->comment ? g_utf8_normalize (FileTag->comment,
-                                                                -1,
-                                                                G_NORMALIZE_DEFAULT)
-                                            : NULL;
-                composer2 = FileTag->composer ? g_utf8_normalize (FileTag->composer,
-                                                                  -1,
-                                                                  G_NORMALIZE_DEFAULT)
-                                              : NULL;
-                orig_artist2 = FileTag->orig_artist ? g_utf8_normalize (FileTag->orig_artist,
-                                                                        -1,
-                                                                        G_NORMALIZE_DEFAULT)
-                                                    : NULL;
-                copyright2 = FileTag->copyright ? g_utf8_normalize (FileTag->copyright,
-                                                                    -1,
-                                                                    G_NORMALIZE_DEFAULT)
-                                                : NULL;
-                url2 = FileTag->url ? g_utf8_normalize (FileTag->url, -1,
-                                                        G_NORMALIZE_DEFAULT)
-                                    : NULL;
-                encoded_by2 = FileTag->encoded_by ? g_utf8_normalize (FileTag->encoded_by,
-                                                                      -1,
-                                                                      G_NORMALIZE_DEFAULT)
-                                                  : NULL;
-                needle = g_utf8_normalize (string_to_search, -1,
-                                           G_NORMALIZE_DEFAULT);
-            }
+    if (query == NULL)
+    {
+        msg = g_strdup_printf (_("Invalid search: %s"), error->message);
+        gtk_statusbar_push (GTK_STATUSBAR (priv->status_bar),
+                            priv->status_bar_context, msg);
+        g_free (msg);
+        g_error_free (error);
+        return;
+    }
 
-            if ((title2 && strstr (title2, needle))
-                || (artist2 && strstr (artist2, needle))
-                || (album_artist2 && strstr (album_artist2, needle))
-                || (album2 && strstr (album2, needle))
-                || (disc_number2 && strstr (disc_number2, needle))
-                || (disc_total2 && strstr (disc_total2, needle))
-                || (year2 && strstr (year2, needle))
-                || (track2 && strstr (track2, needle))
-                || (track_total2 && strstr (track_total2, needle))
-                || (genre2 && strstr (genre2, needle))
-                || (comment2 && strstr (comment2, needle))
-                || (composer2 && strstr (composer2, needle))
-                || (orig_artist2 && strstr (orig_artist2, needle))
-                || (copyright2 && strstr (copyright2, needle))
-                || (url2 && strstr (url2, needle))
-                || (encoded_by2 && strstr (encoded_by2, needle)))
-            {
-                Add_Row_To_Search_Result_List (self, ETFile, string_to_search);
-            }
+    run = g_slice_new0 (EtSearchRun);
+    run->ref_count = 1;
+    run->dialog = self;
+    run->search_index = et_search_index_ref (priv->search_index);
+    run->query = query;
+    run->cancellable = g_cancellable_new ();
+    run->files = g_hash_table_new (NULL, NULL);
+    run->start_time = g_get_monotonic_time ();
 
-            g_free (title2);
-            g_free (artist2);
-            g_free (album_artist2);
-            g_free (album2);
-            g_free (disc_number2);
-            g_free (disc_total2);
-            g_free (year2);
-            g_free (track2);
-            g_free (track_total2);
-            g_free (genre2);
-            g_free (comment2);
-            g_free (composer2);
-            g_free (orig_artist2);
-            g_free (copyright2);
-            g_free (url2);
-            g_free (encoded_by2);
-            g_free (needle);
-        }
+    for (l = ETCore->ETFileList; l != NULL; l = g_list_next (l))
+    {
+        g_hash_table_add (run->files, l->data);
     }
 
-    gtk_widget_set_sensitive (GTK_WIDGET (search_button), TRUE);
+    /* The text of the changed files is copied here, as the files must only
+     * be accessed from the main thread. */
+    run->update = et_search_index_prepare_file_list (priv->search_index,
+                                                     ETCore->ETFileList);
+    priv->search_run = run;
 
-    /* Display the number of matches in the statusbar. */
-    resultCount = gtk_tree_model_iter_n_children (GTK_TREE_MODEL (priv->search_results_model),
-                                                  NULL);
-    msg = g_strdup_printf (ngettext ("Found one file", "Found %d files",
-                           resultCount), resultCount);
     gtk_statusbar_push (GTK_STATUSBAR (priv->status_bar),
-                        priv->status_bar_context, msg);
-    g_free (msg);
+                        priv->status_bar_context, _("Searching…"));
 
-    /* Disable result list if no row inserted. */
-    if (resultCount > 0)
-    {
-        gtk_widget_set_sensitive (GTK_WIDGET (priv->search_results_view),
-                                  TRUE);
-    }
-    else
-    {
-        gtk_widget_set_sensitive (GTK_WIDGET (priv->search_results_view),
-                                  FALSE);
-    }
+    task = g_task_new (NULL, run->cancellable, NULL, NULL);
+    g_task_set_task_data (task, et_search_run_ref (run),
+                          (GDestroyNotify)et_search_run_unref);
+    g_task_run_in_thread (task, search_thread_func);
+    g_object_unref (task);
 }
 
 static void
@@ -718,6 +794,100 @@ create_search_dialog (EtSearchDialog *self)
                         priv->status_bar_context, _("Ready to search…"));
 }
 
+/*
+ * et_search_dialog_clear:
+ * @self: an #EtSearchDialog
+ *
+ * Stop the running search and remove all the results, before the list of
+ * files is freed.
+ */
+void
+et_search_dialog_clear (EtSearchDialog *self)
+{
+    EtSearchDialogPrivate *priv;
+
+    g_return_if_fail (ET_SEARCH_DIALOG (self));
+
+    priv = et_search_dialog_get_instance_private (self);
+
+    if (priv->search_run)
+    {
+        et_search_run_cancel (priv->search_run);
+        priv->search_run = NULL;
+    }
+
+    gtk_list_store_clear (priv->search_results_model);
+    gtk_widget_set_sensitive (GTK_WIDGET (priv->search_results_view), FALSE);
+    gtk_statusbar_remove_all (GTK_STATUSBAR (priv->status_bar),
+                              priv->status_bar_context);
+}
+
+/*
+ * et_search_dialog_remove_file:
+ * @self: an #EtSearchDialog
+ * @ETFile: the file which is about to be removed from the list of files
+ *
+ * Stop the running search, which may still find @ETFile, and remove the
+ * result row of @ETFile, before @ETFile is freed.
+ */
+void
+et_search_dialog_remove_file (EtSearchDialog *self,
+                              const ET_File *ETFile)
+{
+    EtSearchDialogPrivate *priv;
+    GtkTreeModel *model;
+    GtkTreeSelection *selection;
+    GtkTreeIter iter;
+    gboolean valid;
+
+    g_return_if_fail (ET_SEARCH_DIALOG (self));
+    g_return_if_fail (ETFile != NULL);
+
+    priv = et_search_dialog_get_instance_private (self);
+
+    if (priv->search_run)
+    {
+        et_search_run_cancel (priv->search_run);
+        priv->search_run = NULL;
+
+        gtk_statusbar_remove_all (GTK_STATUSBAR (priv->status_bar),
+                                  priv->status_bar_context);
+        gtk_statusbar_push (GTK_STATUSBAR (priv->status_bar),
+                            priv->status_bar_context,
+                            _("Search stopped, as the list of files changed"));
+    }
+
+    model = GTK_TREE_MODEL (priv->search_results_model);
+    selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (priv->search_results_view));
+
+    /* Removing a selected row must not select the files of the other rows in
+     * the browser, while the file list is being changed. */
+    g_signal_handlers_block_by_func (selection,
+                                     Search_Result_List_Row_Selected, self);
+
+    valid = gtk_tree_model_get_iter_first (model, &iter);
+
+    while (valid)
+    {
+        ET_File *row_file;
+
+        gtk_tree_model_get (model, &iter, SEARCH_RESULT_POINTER, &row_file,
+                            -1);
+
+        if (row_file == ETFile)
+        {
+            valid = gtk_list_store_remove (priv->search_results_model, &iter);
+        }
+        else
+        {
+            valid = gtk_tree_model_iter_next (model, &iter);
+        }
+    }
+
+    g_signal_handlers_unblock_by_func (selection,
+                                       Search_Result_List_Row_Selected, self);
+}
+
 /*
  * For the configuration file...
  */
@@ -733,9 +903,32 @@ et_search_dialog_apply_changes (EtSearchDialog *self)
     Save_Search_File_List (priv->search_string_model, MISC_COMBO_TEXT);
 }
 
+static void
+et_search_dialog_finalize (GObject *object)
+{
+    EtSearchDialogPrivate *priv;
+
+    priv = et_search_dialog_get_instance_private (ET_SEARCH_DIALOG (object));
+
+    if (priv->search_run)
+    {
+        et_search_run_cancel (priv->search_run);
+        priv->search_run = NULL;
+    }
+
+    et_search_index_unref (priv->search_index);
+
+    G_OBJECT_CLASS (et_search_dialog_parent_class)->finalize (object);
+}
+
 static void
 et_search_dialog_init (EtSearchDialog *self)
 {
+    EtSearchDialogPrivate *priv;
+
+    priv = et_search_dialog_get_instance_private (self);
+    priv->search_index = et_search_index_new ();
+
     gtk_widget_init_template (GTK_WIDGET (self));
     create_search_dialog (self);
 }
@@ -745,6 +938,8 @@ et_search_dialog_class_init (EtSearchDialogClass *klass)
 {
     GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
 
+    G_OBJECT_CLASS (klass)->finalize = et_search_dialog_finalize;
+
     gtk_widget_class_set_template_from_resource (widget_class,
                                                  "/org/gnome/EasyTAG/search_dialog.ui");
     gtk_widget_class_bind_template_child_private (widget_class, EtSearchDialog,
@@ -46,6 +46,8 @@ struct _EtSearchDialogClass
 GType et_search_dialog_get_type (void);
 EtSearchDialog *et_search_dialog_new (GtkWindow *parent);
 void et_search_dialog_apply_changes (EtSearchDialog *self);
+void et_search_dialog_clear (EtSearchDialog *self);
+void et_search_dialog_remove_file (EtSearchDialog *self, const ET_File *ETFile);
 
 G_END_DECLS
 
@@ -47,6 +47,15 @@
 /* Referenced in the header. */
 GSettings *MainSettings;
 
+/* The current snapshot of MainSettings, which holds a reference to it. It
+ * is only replaced from the main thread, with settings_snapshot_lock held so
+ * that other threads can take a reference to it. */
+static EtSettingsSnapshot *settings_snapshot = NULL;
+static GMutex settings_snapshot_lock;
+/* The snapshot which et_settings_get_snapshot() returns in a worker thread,
+ * set with et_settings_set_thread_snapshot(). */
+static GPrivate thread_snapshot;
+
 /***************
  * Declaration *
  ***************/
@@ -102,6 +111,120 @@ check_default_path (void)
     g_variant_unref (default_path);
 }
 
+static EtSettingsSnapshot *
+settings_snapshot_new (GSettings *settings)
+{
+    EtSettingsSnapshot *snapshot;
+
+    snapshot = g_slice_new (EtSettingsSnapshot);
+    snapshot->ref_count = 1;
+
+    snapshot->browse_show_hidden = g_settings_get_boolean (settings,
+                                                           "browse-show-hidden");
+    snapshot->browse_subdir = g_settings_get_boolean (settings,
+                                                      "browse-subdir");
+    snapshot->sort_case_sensitive = g_settings_get_boolean (settings,
+                                                            "sort-case-sensitive");
+
+    snapshot->search_filename = g_settings_get_boolean (settings,
+                                                        "search-filename");
+    snapshot->search_tag = g_settings_get_boolean (settings, "search-tag");
+    snapshot->search_case_sensitive = g_settings_get_boolean (settings,
+                                                              "search-case-sensitive");
+
+    snapshot->fill_overwrite_tag_fields = g_settings_get_boolean (settings,
+                                                                  "fill-overwrite-tag-fields");
+    snapshot->fill_set_default_comment = g_settings_get_boolean (settings,
+                                                                 "fill-set-default-comment");
+    snapshot->fill_default_comment = g_settings_get_string (settings,
+                                                            "fill-default-comment");
+    snapshot->fill_crc32_comment = g_settings_get_boolean (settings,
+                                                           "fill-crc32-comment");
+    snapshot->fill_convert_spaces = g_settings_get_enum (settings,
+                                                         "fill-convert-spaces");
+    snapshot->rename_convert_spaces = g_settings_get_enum (settings,
+                                                           "rename-convert-spaces");
+    snapshot->rename_replace_illegal_chars = g_settings_get_boolean (settings,
+                                                                     "rename-replace-illegal-chars");
+    snapshot->process_fields = g_settings_get_flags (settings,
+                                                     "process-fields");
+    snapshot->process_convert = g_settings_get_enum (settings,
+                                                     "process-convert");
+    snapshot->process_insert_capital_spaces = g_settings_get_boolean (settings,
+                                                                      "process-insert-capital-spaces");
+    snapshot->process_remove_duplicate_spaces = g_settings_get_boolean (settings,
+                                                                        "process-remove-duplicate-spaces");
+    snapshot->process_uppercase_all = g_settings_get_boolean (settings,
+                                                              "process-uppercase-all");
+    snapshot->process_lowercase_all = g_settings_get_boolean (settings,
+                                                              "process-lowercase-all");
+    snapshot->process_uppercase_first_letter = g_settings_get_boolean (settings,
+                                                                       "process-uppercase-first-letter");
+    snapshot->process_uppercase_first_letters = g_settings_get_boolean (settings,
+                                                                        "process-uppercase-first-letters");
+    snapshot->process_uppercase_prepositions = g_settings_get_boolean (settings,
+                                                                       "process-uppercase-prepositions");
+    snapshot->process_detect_roman_numerals = g_settings_get_boolean (settings,
+                                                                      "process-detect-roman-numerals");
+    snapshot->process_remove_spaces = g_settings_get_boolean (settings,
+                                                              "process-remove-spaces");
+
+    snapshot->tag_disc_padded = g_settings_get_boolean (settings,
+                                                        "tag-disc-padded");
+    snapshot->tag_disc_length = g_settings_get_uint (settings,
+                                                     "tag-disc-length");
+    snapshot->tag_number_padded = g_settings_get_boolean (settings,
+                                                          "tag-number-padded");
+    snapshot->tag_number_length = g_settings_get_uint (settings,
+                                                       "tag-number-length");
+    snapshot->ogg_split_title = g_settings_get_boolean (settings,
+                                                        "ogg-split-title");
+    snapshot->ogg_split_artist = g_settings_get_boolean (settings,
+                                                         "ogg-split-artist");
+    snapshot->ogg_split_album = g_settings_get_boolean (settings,
+                                                        "ogg-split-album");
+    snapshot->ogg_split_genre = g_settings_get_boolean (settings,
+                                                        "ogg-split-genre");
+    snapshot->ogg_split_comment = g_settings_get_boolean (settings,
+                                                          "ogg-split-comment");
+    snapshot->ogg_split_composer = g_settings_get_boolean (settings,
+                                                           "ogg-split-composer");
+    snapshot->ogg_split_original_artist = g_settings_get_boolean (settings,
+                                                                  "ogg-split-original-artist");
+
+    return snapshot;
+}
+
+/*
+ * on_main_settings_changed:
+ * @settings: the settings
+ * @key: the key which changed
+ * @user_data: user data set when the signal handler was connected
+ *
+ * Replace the settings snapshot when any of the settings changes.
+ */
+static void
+on_main_settings_changed (GSettings *settings,
+                          const gchar *key,
+                          gpointer user_data)
+{
+    EtSettingsSnapshot *old_snapshot;
+    EtSettingsSnapshot *new_snapshot;
+
+    new_snapshot = settings_snapshot_new (settings);
+
+    g_mutex_lock (&settings_snapshot_lock);
+    old_snapshot = settings_snapshot;
+    g_atomic_pointer_set (&settings_snapshot, new_snapshot);
+    g_mutex_unlock (&settings_snapshot_lock);
+
+    /* Threads which hold a reference keep using the previous snapshot. */
+    if (old_snapshot)
+    {
+        et_settings_snapshot_unref (old_snapshot);
+    }
+}
+
 /*
  * Define and Load default values into config variables
  */
@@ -113,6 +236,95 @@ void Init_Config_Variables (void)
      * Common
      */
     check_default_path ();
+
+    g_atomic_pointer_set (&settings_snapshot,
+                          settings_snapshot_new (MainSettings));
+    g_signal_connect (MainSettings, "changed",
+                      G_CALLBACK (on_main_settings_changed), NULL);
+}
+
+/*
+ * et_settings_get_snapshot:
+ *
+ * Get the current values of the settings which are read in loops, without
+ * querying GSettings. In the main thread, the snapshot must not be kept after
+ * returning to the main loop, as it is replaced when the settings change. In
+ * a worker thread, the snapshot set with et_settings_set_thread_snapshot() is
+ * returned instead.
+ *
+ * Returns: (transfer none): the settings snapshot of the calling thread
+ */
+const EtSettingsSnapshot *
+et_settings_get_snapshot (void)
+{
+    const EtSettingsSnapshot *snapshot;
+
+    snapshot = g_private_get (&thread_snapshot);
+
+    if (snapshot)
+    {
+        return snapshot;
+    }
+
+    return g_atomic_pointer_get (&settings_snapshot);
+}
+
+/*
+ * et_settings_snapshot_ref:
+ *
+ * Get a reference to the current settings snapshot. This may be called from
+ * any thread, and the snapshot, which is never modified, stays valid until
+ * it is unreferenced.
+ *
+ * Returns: (transfer full): the current settings snapshot, free with
+ * et_settings_snapshot_unref()
+ */
+const EtSettingsSnapshot *
+et_settings_snapshot_ref (void)
+{
+    EtSettingsSnapshot *snapshot;
+
+    g_mutex_lock (&settings_snapshot_lock);
+    snapshot = settings_snapshot;
+    g_atomic_int_inc (&snapshot->ref_count);
+    g_mutex_unlock (&settings_snapshot_lock);
+
+    return snapshot;
+}
+
+/*
+ * et_settings_snapshot_unref:
+ * @snapshot: a settings snapshot
+ *
+ * Release a reference to @snapshot, freeing it if it was the last one.
+ */
+void
+et_settings_snapshot_unref (const EtSettingsSnapshot *snapshot)
+{
+    EtSettingsSnapshot *self = (EtSettingsSnapshot *)snapshot;
+
+    g_return_if_fail (snapshot != NULL);
+
+    if (g_atomic_int_dec_and_test (&self->ref_count))
+    {
+        g_free (self->fill_default_comment);
+        g_slice_free (EtSettingsSnapshot, self);
+    }
+}
+
+/*
+ * et_settings_set_thread_snapshot:
+ * @snapshot: (allow-none): a settings snapshot, or %NULL
+ *
+ * Make et_settings_get_snapshot() return @snapshot in the calling worker
+ * thread, such as for the code which reads the settings while loading and
+ * saving files. The caller keeps its reference to @snapshot, and must unset
+ * it with %NULL before releasing it.
+ */
+void
+et_settings_set_thread_snapshot (const EtSettingsSnapshot *snapshot)
+{
+    g_private_set (&thread_snapshot, (gpointer)snapshot);
 }
 
 /*
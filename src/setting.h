@@ -168,6 +168,15 @@ typedef enum
     ET_PLAYLIST_CONTENT_EXTENDED_MASK
 } EtPlaylistContent;
 
+/* Files of each generated playlist. */
+typedef enum
+{
+    ET_PLAYLIST_GROUP_NONE,
+    ET_PLAYLIST_GROUP_DIRECTORY,
+    ET_PLAYLIST_GROUP_ALBUM,
+    ET_PLAYLIST_GROUP_ARTIST
+} EtPlaylistGroup;
+
 /* Encoding options when renaming files. */
 typedef enum
 {
@@ -247,8 +256,71 @@ typedef enum
 
 extern GSettings *MainSettings;
 
+/*
+ * EtSettingsSnapshot:
+ *
+ * A copy of the values of the settings which are read in loops over files.
+ * A snapshot is never modified: a new one is created whenever one of the
+ * settings changes, and the previous one is freed once the threads which
+ * hold a reference to it release it.
+ */
+typedef struct
+{
+    /*< private >*/
+    gint ref_count;
+
+    /*< public >*/
+    /* Browser. */
+    gboolean browse_show_hidden;
+    gboolean browse_subdir;
+    gboolean sort_case_sensitive;
+
+    /* Search. */
+    gboolean search_filename;
+    gboolean search_tag;
+    gboolean search_case_sensitive;
+
+    /* Scanner. */
+    gboolean fill_overwrite_tag_fields;
+    gboolean fill_set_default_comment;
+    gchar *fill_default_comment;
+    gboolean fill_crc32_comment;
+    EtConvertSpaces fill_convert_spaces;
+    EtConvertSpaces rename_convert_spaces;
+    gboolean rename_replace_illegal_chars;
+    guint process_fields;
+    EtProcessFieldsConvert process_convert;
+    gboolean process_insert_capital_spaces;
+    gboolean process_remove_duplicate_spaces;
+    gboolean process_uppercase_all;
+    gboolean process_lowercase_all;
+    gboolean process_uppercase_first_letter;
+    gboolean process_uppercase_first_letters;
+    gboolean process_uppercase_prepositions;
+    gboolean process_detect_roman_numerals;
+    gboolean process_remove_spaces;
+
+    /* Tags. */
+    gboolean tag_disc_padded;
+    guint tag_disc_length;
+    gboolean tag_number_padded;
+    guint tag_number_length;
+    gboolean ogg_split_title;
+    gboolean ogg_split_artist;
+    gboolean ogg_split_album;
+    gboolean ogg_split_genre;
+    gboolean ogg_split_comment;
+    gboolean ogg_split_composer;
+    gboolean ogg_split_original_artist;
+} EtSettingsSnapshot;
+
 void Init_Config_Variables (void);
 
+const EtSettingsSnapshot * et_settings_get_snapshot (void);
+const EtSettingsSnapshot * et_settings_snapshot_ref (void);
+void et_settings_snapshot_unref (const EtSettingsSnapshot *snapshot);
+void et_settings_set_thread_snapshot (const EtSettingsSnapshot *snapshot);
+
 gboolean Setting_Create_Files     (void);
 
 
@@ -32,6 +32,13 @@
 #include "picture.h"
 #include "scan.h"
 #include "scan_dialog.h"
+#include "thumbnail_cache.h"
+
+/* The size of the thumbnails of the images, in pixels. */
+#define THUMBNAIL_SIZE 96
+
+/* The maximum size of the pixel data of the thumbnails cache, in bytes. */
+#define THUMBNAIL_CACHE_SIZE (8 * 1024 * 1024)
 
 typedef struct
 {
@@ -86,6 +93,8 @@ typedef struct
 
     /* Image treeview model. */
     GtkListStore *images_model;
+    EtThumbnailCache *thumbnail_cache;
+    GCancellable *thumbnail_cancellable;
 
     /* Mini buttons. */
     GtkWidget *track_sequence_button;
@@ -386,7 +395,7 @@ on_apply_to_selection (GObject *object,
 
             // Restart counter when entering a new directory
             g_free(path1);
-            path1 = g_path_get_dirname(FileNameCur->value);
+            path1 = et_file_name_get_dirname (FileNameCur);
             if ( path && path1 && strcmp(path,path1)!=0 )
                 i = 0;
 
@@ -422,16 +431,13 @@ on_apply_to_selection (GObject *object,
         /* Used of Track and Total Track values */
         for (l = etfilelist; l != NULL; l = g_list_next (l))
         {
-            const gchar *filename_utf8;
             gchar *path_utf8;
             gchar *track_string;
 
             etfile        = (ET_File *)l->data;
-            filename_utf8 = ((File_Name *)etfile->FileNameNew->data)->value_utf8;
-            path_utf8     = g_path_get_dirname(filename_utf8);
+            path_utf8     = et_file_name_get_dirname_utf8 ((File_Name *)etfile->FileNameNew->data);
 
             track_string = et_track_number_to_string (et_file_list_get_n_files_in_path (ETCore->ETFileList, path_utf8));
-
             g_free (path_utf8);
 
             if (!track_total)
@@ -1238,145 +1244,217 @@ PictureEntry_Clear (EtTagArea *self)
 
     priv = et_tag_area_get_instance_private (self);
 
+    /* Thumbnails which are still loading are cached, but not shown. */
+    g_cancellable_cancel (priv->thumbnail_cancellable);
+    g_object_unref (priv->thumbnail_cancellable);
+    priv->thumbnail_cancellable = g_cancellable_new ();
+
     gtk_list_store_clear (priv->images_model);
 }
 
+/*
+ * ThumbnailRequest:
+ * @self: the #EtTagArea
+ * @row: the row of the picture in the images model
+ * @scale_factor: the scale factor of the images view
+ */
+typedef struct
+{
+    EtTagArea *self;
+    GtkTreeRowReference *row;
+    gint scale_factor;
+} ThumbnailRequest;
+
+static void
+thumbnail_request_free (ThumbnailRequest *request)
+{
+    gtk_tree_row_reference_free (request->row);
+    g_object_unref (request->self);
+    g_slice_free (ThumbnailRequest, request);
+}
+
+static cairo_surface_t *
+create_thumbnail_surface (EtTagArea *self,
+                          GdkPixbuf *thumbnail,
+                          gint scale_factor)
+{
+    EtTagAreaPrivate *priv;
+    GdkWindow *view_window;
+
+    priv = et_tag_area_get_instance_private (self);
+
+    /* This ties the model to the view, so if the model is to be shared in
+     * the future, the surface should be per-view. */
+    view_window = gtk_widget_get_window (priv->images_view);
+
+    return gdk_cairo_surface_create_from_pixbuf (thumbnail, scale_factor,
+                                                 view_window);
+}
+
+static void
+on_thumbnail_loaded (GObject *source_object,
+                     GAsyncResult *result,
+                     gpointer user_data)
+{
+    ThumbnailRequest *request = user_data;
+    EtTagAreaPrivate *priv;
+    GdkPixbuf *thumbnail;
+    GError *error = NULL;
+
+    priv = et_tag_area_get_instance_private (request->self);
+
+    thumbnail = et_thumbnail_cache_load_finish (priv->thumbnail_cache, result,
+                                                &error);
+
+    if (!thumbnail)
+    {
+        if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+            Log_Print (LOG_ERROR, _("Error parsing image data ‘%s’"),
+                       error->message);
+        }
+
+        g_error_free (error);
+    }
+    else
+    {
+        /* The row is gone if another file was displayed meanwhile. */
+        if (gtk_tree_row_reference_valid (request->row))
+        {
+            GtkTreePath *path;
+            GtkTreeIter iter;
+            cairo_surface_t *surface;
+
+            path = gtk_tree_row_reference_get_path (request->row);
+            gtk_tree_model_get_iter (GTK_TREE_MODEL (priv->images_model),
+                                     &iter, path);
+            surface = create_thumbnail_surface (request->self, thumbnail,
+                                                request->scale_factor);
+            gtk_list_store_set (priv->images_model, &iter,
+                                PICTURE_COLUMN_SURFACE, surface, -1);
+
+            cairo_surface_destroy (surface);
+            gtk_tree_path_free (path);
+        }
+
+        g_object_unref (thumbnail);
+    }
+
+    thumbnail_request_free (request);
+}
+
+/*
+ * PictureEntry_Update:
+ * @self: the #EtTagArea
+ * @pic: the pictures to add to the images model
+ * @select_it: whether to select the added pictures
+ *
+ * Add @pic and the following pictures to the images model, after reading the
+ * size of their images. The thumbnails are taken from the thumbnail cache,
+ * or else loaded in a thread and shown once loaded.
+ */
 static void
 PictureEntry_Update (EtTagArea *self,
                      EtPicture *pic,
                      gboolean select_it)
 {
     EtTagAreaPrivate *priv;
-    GdkPixbufLoader *loader = 0;
-    GError *error = NULL;
-    
+    GtkTreeSelection *selection;
+    gint scale_factor;
+
     g_return_if_fail (pic != NULL);
 
     priv = et_tag_area_get_instance_private (self);
 
-    if (g_bytes_get_size (pic->bytes) == 0)
-    {
-        goto next;
-    }
-
-    loader = gdk_pixbuf_loader_new ();
+    selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (priv->images_view));
+    /* TODO: Connect to notify:scale-factor and update when the scale
+     * changes. */
+    scale_factor = gtk_widget_get_scale_factor (priv->images_view);
 
-    if (loader)
+    for (; pic != NULL; pic = pic->next)
     {
-        if (gdk_pixbuf_loader_write_bytes (loader, pic->bytes, &error))
+        GdkPixbuf *thumbnail;
+        cairo_surface_t *surface = NULL;
+        GtkTreeIter iter1;
+        gchar *pic_info;
+        GError *error = NULL;
+
+        if (g_bytes_get_size (pic->bytes) == 0)
         {
-            GtkTreeSelection *selection;
-            GdkPixbuf *pixbuf;
+            continue;
+        }
 
-            if (!gdk_pixbuf_loader_close(loader, &error))
+        thumbnail = et_thumbnail_cache_lookup (priv->thumbnail_cache, pic,
+                                               THUMBNAIL_SIZE * scale_factor,
+                                               &pic->width, &pic->height);
+
+        if (!thumbnail
+            && !et_thumbnail_get_image_size (pic->bytes, &pic->width,
+                                             &pic->height, &error))
+        {
+            if (g_error_matches (error, G_IO_ERROR,
+                                 G_IO_ERROR_PARTIAL_INPUT))
+            {
+                Log_Print (LOG_ERROR, "%s",
+                           _("Cannot display the image because not enough data has been read to determine how to create the image buffer"));
+            }
+            else
             {
                 Log_Print (LOG_ERROR, _("Error parsing image data ‘%s’"),
                            error->message);
-                g_error_free (error);
             }
 
-            selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (priv->images_view));
+            g_error_free (error);
+            continue;
+        }
 
-            pixbuf = gdk_pixbuf_loader_get_pixbuf(loader);
-            if (pixbuf)
-            {
-                GtkTreeIter iter1;
-                gint scale_factor;
-                GdkPixbuf *scaled_pixbuf;
-                cairo_surface_t *surface;
-                GdkWindow *view_window;
-                gint scaled_pixbuf_width;
-                gint scaled_pixbuf_height;
-                gchar *pic_info;
-
-                g_object_ref(pixbuf);
-                g_object_unref(loader);
-                
-                // Keep aspect ratio of the picture
-                pic->width  = gdk_pixbuf_get_width(pixbuf);
-                pic->height = gdk_pixbuf_get_height(pixbuf);
-                /* TODO: Connect to notify:scale-factor and update when the
-                 * scale changes. */
-                scale_factor = gtk_widget_get_scale_factor (priv->images_view);
-
-                if (pic->width > pic->height)
-                {
-                    scaled_pixbuf_width = 96 * scale_factor;
-                    scaled_pixbuf_height = 96 * scale_factor * pic->height
-                                           / pic->width;
-                }else
-                {
-                    scaled_pixbuf_width = 96 * scale_factor * pic->width
-                                          / pic->height;
-                    scaled_pixbuf_height = 96 * scale_factor;
-                }
+        if (thumbnail)
+        {
+            surface = create_thumbnail_surface (self, thumbnail,
+                                                scale_factor);
+        }
 
-                scaled_pixbuf = gdk_pixbuf_scale_simple (pixbuf,
-                                                         scaled_pixbuf_width,
-                                                         scaled_pixbuf_height,
-                                                         GDK_INTERP_BILINEAR);
-                g_object_unref (pixbuf);
-
-                /* This ties the model to the view, so if the model is to be
-                 * shared in the future, the surface should be per-view. */
-                view_window = gtk_widget_get_window (priv->images_view);
-                surface = gdk_cairo_surface_create_from_pixbuf (scaled_pixbuf,
-                                                                scale_factor,
-                                                                view_window);
-                pic_info = et_picture_format_info (pic,
-                                                   ETCore->ETFileDisplayed->ETFileDescription->TagType);
-                gtk_list_store_insert_with_values (priv->images_model, &iter1,
-                                                   G_MAXINT,
-                                                   PICTURE_COLUMN_SURFACE,
-                                                   surface,
-                                                   PICTURE_COLUMN_TEXT,
-                                                   pic_info,
-                                                   PICTURE_COLUMN_DATA,
-                                                   pic, -1);
-                g_free(pic_info);
-
-                if (select_it)
-                    gtk_tree_selection_select_iter(selection, &iter1);
-                g_object_unref(scaled_pixbuf);
-            }else
-            {
-                GtkWidget *msgdialog;
-                
-                g_object_unref(loader);
-                
-                Log_Print (LOG_ERROR, "%s",
-                           _("Cannot display the image because not enough data has been read to determine how to create the image buffer"));
+        pic_info = et_picture_format_info (pic,
+                                           ETCore->ETFileDisplayed->ETFileDescription->TagType);
+        gtk_list_store_insert_with_values (priv->images_model, &iter1,
+                                           G_MAXINT,
+                                           PICTURE_COLUMN_SURFACE, surface,
+                                           PICTURE_COLUMN_TEXT, pic_info,
+                                           PICTURE_COLUMN_DATA, pic, -1);
+        g_free (pic_info);
 
-                msgdialog = gtk_message_dialog_new(GTK_WINDOW(MainWindow),
-                                                   GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
-                                                   GTK_MESSAGE_ERROR,
-                                                   GTK_BUTTONS_CLOSE,
-                                                   "%s",
-                                                   _("Cannot display the image"));
-                gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (msgdialog),
-                                                          _("Not enough data has been read to determine how to create the image buffer."));
-                gtk_window_set_title (GTK_WINDOW (msgdialog),
-                                      _("Load Image File"));
-                gtk_dialog_run(GTK_DIALOG(msgdialog));
-                gtk_widget_destroy(msgdialog);
-            }
+        if (select_it)
+        {
+            gtk_tree_selection_select_iter (selection, &iter1);
         }
-        else
+
+        if (thumbnail)
         {
-            Log_Print (LOG_ERROR, _("Error parsing image data ‘%s’"),
-                       error->message);
-            g_error_free (error);
+            cairo_surface_destroy (surface);
+            g_object_unref (thumbnail);
         }
-    }
+        else
+        {
+            ThumbnailRequest *request;
+            GtkTreePath *path;
 
-next:
-    /* Do also for next picture. */
-    if (pic->next)
-    {
-        PictureEntry_Update (self, pic->next, select_it);
-    }
+            path = gtk_tree_model_get_path (GTK_TREE_MODEL (priv->images_model),
+                                            &iter1);
+
+            request = g_slice_new (ThumbnailRequest);
+            request->self = g_object_ref (self);
+            request->row = gtk_tree_row_reference_new (GTK_TREE_MODEL (priv->images_model),
+                                                       path);
+            request->scale_factor = scale_factor;
 
-    return;
+            et_thumbnail_cache_load_async (priv->thumbnail_cache, pic,
+                                           THUMBNAIL_SIZE * scale_factor,
+                                           priv->thumbnail_cancellable,
+                                           on_thumbnail_loaded, request);
+
+            gtk_tree_path_free (path);
+        }
+    }
 }
 
 
@@ -1560,7 +1638,7 @@ on_picture_add_button_clicked (GObject *object,
                                      FALSE);
 
     /* Starting directory (the same as the current file). */
-    init_dir = g_path_get_dirname (((File_Name *)((GList *)ETCore->ETFileDisplayed->FileNameCur)->data)->value);
+    init_dir = et_file_name_get_dirname ((File_Name *)ETCore->ETFileDisplayed->FileNameCur->data);
     gtk_file_chooser_set_current_folder (GTK_FILE_CHOOSER (FileSelectionWindow),
                                          init_dir);
     g_free (init_dir);
@@ -2212,9 +2290,28 @@ create_tag_area (EtTagArea *self)
                        GDK_ACTION_COPY);
 }
 
+static void
+et_tag_area_finalize (GObject *object)
+{
+    EtTagAreaPrivate *priv;
+
+    priv = et_tag_area_get_instance_private (ET_TAG_AREA (object));
+
+    g_clear_pointer (&priv->thumbnail_cache, et_thumbnail_cache_free);
+    g_clear_object (&priv->thumbnail_cancellable);
+
+    G_OBJECT_CLASS (et_tag_area_parent_class)->finalize (object);
+}
+
 static void
 et_tag_area_init (EtTagArea *self)
 {
+    EtTagAreaPrivate *priv;
+
+    priv = et_tag_area_get_instance_private (self);
+    priv->thumbnail_cache = et_thumbnail_cache_new (THUMBNAIL_CACHE_SIZE);
+    priv->thumbnail_cancellable = g_cancellable_new ();
+
     /* Ensure that the boxed type is registered before using it in
      * GtkBuilder. */
     et_picture_get_type ();
@@ -2228,6 +2325,8 @@ et_tag_area_class_init (EtTagAreaClass *klass)
 {
     GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
 
+    G_OBJECT_CLASS (klass)->finalize = et_tag_area_finalize;
+
     gtk_widget_class_set_template_from_resource (widget_class,
                                                  "/org/gnome/EasyTAG/tag_area.ui");
     gtk_widget_class_bind_template_child_private (widget_class, EtTagArea,
@@ -2988,13 +3087,18 @@ et_tag_area_display_et_file (EtTagArea *self,
 #endif
         case UNKNOWN_TAG:
         default:
+        {
+            gchar *filename_utf8 = et_file_name_get_path_utf8 ((File_Name *)ETFile->FileNameCur->data);
+
             gtk_label_set_text (GTK_LABEL (priv->tag_label), _("Tag"));
             /* FIXME: Translatable string. */
             Log_Print (LOG_ERROR,
                        "FileTag: Undefined tag type %d for file %s.",
                        (gint)ETFile->ETFileDescription->TagType,
-                       ((File_Name *)((GList *)ETFile->FileNameCur)->data)->value_utf8);
+                       filename_utf8);
+            g_free (filename_utf8);
             break;
+        }
     }
 
     //Tag_Area_Set_Sensitive(TRUE); // Causes displaying problem when saving files
@@ -0,0 +1,423 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include "ape_reader.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include "genres.h"
+
+/* Size of an APE tag header or footer. */
+#define APE_FOOTER_SIZE 32
+
+/* Size of an ID3v1 tag, which may follow the APE tag. */
+#define APE_ID3V1_SIZE 128
+
+/* Size of the value size and flags, at the start of each item. */
+#define APE_ITEM_HEADER_SIZE 8
+
+/* APE tag version of the original format, in which text values may end with
+ * a nul byte. */
+#define APE_VERSION_1 1000
+
+/* Number of slots in the key table. */
+#define APE_KEY_TABLE_SIZE 32
+
+/*
+ * ape_keys:
+ *
+ * Perfect hash table of the item keys which are read, indexed by
+ * ape_key_hash(). There are no collisions between these keys, so a key is
+ * found by comparing it with the single entry in its slot.
+ */
+static const struct
+{
+    const gchar *key;
+    EtApeField field;
+} ape_keys[APE_KEY_TABLE_SIZE] =
+{
+    { NULL, ET_APE_FIELD_UNKNOWN },
+    { NULL, ET_APE_FIELD_UNKNOWN },
+    { "Original Artist", ET_APE_FIELD_ORIG_ARTIST },
+    { "Track", ET_APE_FIELD_TRACK },
+    { NULL, ET_APE_FIELD_UNKNOWN },
+    { "Album Artist", ET_APE_FIELD_ALBUM_ARTIST },
+    { NULL, ET_APE_FIELD_UNKNOWN },
+    { "Artist", ET_APE_FIELD_ARTIST },
+    { NULL, ET_APE_FIELD_UNKNOWN },
+    { "Encoded By", ET_APE_FIELD_ENCODED_BY },
+    { "Genre", ET_APE_FIELD_GENRE },
+    { NULL, ET_APE_FIELD_UNKNOWN },
+    { "Part", ET_APE_FIELD_PART },
+    { NULL, ET_APE_FIELD_UNKNOWN },
+    { "Comment", ET_APE_FIELD_COMMENT },
+    { "Composer", ET_APE_FIELD_COMPOSER },
+    { NULL, ET_APE_FIELD_UNKNOWN },
+    { "Year", ET_APE_FIELD_YEAR },
+    { NULL, ET_APE_FIELD_UNKNOWN },
+    { NULL, ET_APE_FIELD_UNKNOWN },
+    { "Album", ET_APE_FIELD_ALBUM },
+    { NULL, ET_APE_FIELD_UNKNOWN },
+    { NULL, ET_APE_FIELD_UNKNOWN },
+    { "Title", ET_APE_FIELD_TITLE },
+    { "Copyright", ET_APE_FIELD_COPYRIGHT },
+    { NULL, ET_APE_FIELD_UNKNOWN },
+    { NULL, ET_APE_FIELD_UNKNOWN },
+    { NULL, ET_APE_FIELD_UNKNOWN },
+    { NULL, ET_APE_FIELD_UNKNOWN },
+    { "Related", ET_APE_FIELD_URL },
+    { NULL, ET_APE_FIELD_UNKNOWN },
+    { NULL, ET_APE_FIELD_UNKNOWN }
+};
+
+static guint
+ape_key_hash (const gchar *key,
+              gsize length)
+{
+    return (g_ascii_tolower (key[0]) + 2 * g_ascii_tolower (key[length - 1])
+            + 5 * length) & (APE_KEY_TABLE_SIZE - 1);
+}
+
+/*
+ * et_ape_field_from_key:
+ * @key: an APE item key, which need not be nul-terminated
+ * @length: the length of @key
+ *
+ * Look up the field for an item key. As for libapetag, keys are compared
+ * without case sensitivity.
+ *
+ * Returns: the field, or %ET_APE_FIELD_UNKNOWN if the item is not read
+ */
+EtApeField
+et_ape_field_from_key (const gchar *key,
+                       gsize length)
+{
+    guint hash;
+
+    g_return_val_if_fail (key != NULL, ET_APE_FIELD_UNKNOWN);
+
+    if (length == 0)
+    {
+        return ET_APE_FIELD_UNKNOWN;
+    }
+
+    hash = ape_key_hash (key, length);
+
+    if (ape_keys[hash].key != NULL
+        && ape_keys[hash].key[length] == '\0'
+        && g_ascii_strncasecmp (ape_keys[hash].key, key, length) == 0)
+    {
+        return ape_keys[hash].field;
+    }
+
+    return ET_APE_FIELD_UNKNOWN;
+}
+
+static guint32
+read_uint32_le (const guchar *data)
+{
+    return ((guint32)data[3] << 24) | ((guint32)data[2] << 16)
+           | ((guint32)data[1] << 8) | (guint32)data[0];
+}
+
+static gssize
+read_at (GInputStream *istream,
+         goffset offset,
+         guchar *buffer,
+         gsize count,
+         GError **error)
+{
+    gsize bytes_read;
+
+    if (!g_seekable_seek (G_SEEKABLE (istream), offset, G_SEEK_SET, NULL,
+                          error)
+        || !g_input_stream_read_all (istream, buffer, count, &bytes_read, NULL,
+                                     error))
+    {
+        return -1;
+    }
+
+    return bytes_read;
+}
+
+/*
+ * parse_items:
+ * @data: the items of the tag
+ * @length: the number of bytes in @data
+ * @n_items: the number of items given in the footer
+ * @version: the tag version given in the footer
+ * @values: the field values to fill
+ *
+ * Walk the items of the tag once, storing the value of each known item in
+ * its slot. The first item with a key is used, as by libapetag.
+ */
+static void
+parse_items (const guchar *data,
+             gsize length,
+             guint32 n_items,
+             guint32 version,
+             gchar **values)
+{
+    const guchar *p = data;
+    const guchar *end = data + length;
+
+    while (n_items-- > 0 && end - p > APE_ITEM_HEADER_SIZE)
+    {
+        const gchar *key = (const gchar *)p + APE_ITEM_HEADER_SIZE;
+        const gchar *key_end;
+        const gchar *value;
+        gsize value_size;
+        EtApeField field;
+
+        value_size = read_uint32_le (p);
+        key_end = memchr (key, '\0', (const gchar *)end - key);
+
+        if (key_end == NULL)
+        {
+            break;
+        }
+
+        value = key_end + 1;
+
+        if (value_size > (gsize)((const gchar *)end - value))
+        {
+            break;
+        }
+
+        p = (const guchar *)value + value_size;
+
+        if (version == APE_VERSION_1 && value_size > 0
+            && value[value_size - 1] == '\0')
+        {
+            value_size--;
+        }
+
+        field = et_ape_field_from_key (key, key_end - key);
+
+        if (field != ET_APE_FIELD_UNKNOWN && values[field] == NULL
+            && value_size > 0)
+        {
+            values[field] = g_strndup (value, value_size);
+        }
+    }
+}
+
+/*
+ * set_id3v1_field:
+ * @values: the field values
+ * @field: the field to set, if it is not set already
+ * @data: the ID3v1 field
+ * @length: the size of the ID3v1 field
+ *
+ * Set a field from an ID3v1 tag, without the trailing spaces, nul bytes and
+ * newlines, as by libapetag.
+ */
+static void
+set_id3v1_field (gchar **values,
+                 EtApeField field,
+                 const guchar *data,
+                 gsize length)
+{
+    if (values[field] != NULL || data[0] == '\0')
+    {
+        return;
+    }
+
+    while (length > 0 && (data[length - 1] == ' ' || data[length - 1] == '\0'
+                          || data[length - 1] == '\n'))
+    {
+        length--;
+    }
+
+    if (length > 0)
+    {
+        values[field] = g_strndup ((const gchar *)data, length);
+    }
+}
+
+/*
+ * parse_id3v1:
+ * @data: an ID3v1 tag
+ * @values: the field values to fill
+ *
+ * Fill the fields which were not set by the APE tag from an ID3v1 tag.
+ */
+static void
+parse_id3v1 (const guchar *data,
+             gchar **values)
+{
+    const guchar *comment = data + 97;
+
+    set_id3v1_field (values, ET_APE_FIELD_TITLE, data + 3, 30);
+    set_id3v1_field (values, ET_APE_FIELD_ARTIST, data + 33, 30);
+    set_id3v1_field (values, ET_APE_FIELD_ALBUM, data + 63, 30);
+    set_id3v1_field (values, ET_APE_FIELD_YEAR, data + 93, 4);
+
+    /* ID3v1.1 track number, at the end of the comment. */
+    if (comment[28] == '\0' && comment[29] != '\0')
+    {
+        if (values[ET_APE_FIELD_TRACK] == NULL)
+        {
+            values[ET_APE_FIELD_TRACK] = g_strdup_printf ("%u", comment[29]);
+        }
+
+        set_id3v1_field (values, ET_APE_FIELD_COMMENT, comment, 28);
+    }
+    else
+    {
+        set_id3v1_field (values, ET_APE_FIELD_COMMENT, comment, 30);
+    }
+
+    if (values[ET_APE_FIELD_GENRE] == NULL && *genre_no (data[127]) != '\0')
+    {
+        values[ET_APE_FIELD_GENRE] = g_strdup (genre_no (data[127]));
+    }
+}
+
+/*
+ * et_ape_reader_read_file:
+ * @file: the file to read
+ * @values: an array of %ET_APE_FIELD_COUNT strings, initially %NULL, to fill
+ *          with newly-allocated values
+ * @error: a #GError to provide information on errors, or %NULL to ignore
+ *
+ * Read the APE tag at the end of @file, and any ID3v1 tag which follows it,
+ * in a single pass. The footer and ID3v1 tag are read together, then the
+ * items of the APE tag are read with a second read, and walked once. Fields
+ * which are not in the APE tag are taken from the ID3v1 tag, if there is
+ * one. The values are not converted, and may not be valid UTF-8.
+ *
+ * Returns: %TRUE on success, %FALSE and with @error set otherwise
+ */
+gboolean
+et_ape_reader_read_file (GFile *file,
+                         gchar **values,
+                         GError **error)
+{
+    GFileInputStream *istream;
+    GFileInfo *info;
+    guchar tail[APE_FOOTER_SIZE + APE_ID3V1_SIZE];
+    const guchar *footer = NULL;
+    const guchar *id3v1 = NULL;
+    goffset size;
+    goffset tag_end;
+    gssize tail_size;
+
+    g_return_val_if_fail (file != NULL && values != NULL, FALSE);
+    g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+    istream = g_file_read (file, NULL, error);
+
+    if (!istream)
+    {
+        return FALSE;
+    }
+
+    info = g_file_input_stream_query_info (istream,
+                                           G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                                           NULL, error);
+
+    if (!info)
+    {
+        g_object_unref (istream);
+        return FALSE;
+    }
+
+    size = g_file_info_get_size (info);
+    g_object_unref (info);
+
+    /* First read: the APE footer, and the ID3v1 tag after it. */
+    tail_size = read_at (G_INPUT_STREAM (istream),
+                         size - MIN (size, (goffset)sizeof (tail)), tail,
+                         MIN (size, (goffset)sizeof (tail)), error);
+
+    if (tail_size < 0)
+    {
+        g_object_unref (istream);
+        return FALSE;
+    }
+
+    tag_end = size;
+
+    if (tail_size >= APE_ID3V1_SIZE
+        && memcmp (tail + tail_size - APE_ID3V1_SIZE, "TAG", 3) == 0)
+    {
+        id3v1 = tail + tail_size - APE_ID3V1_SIZE;
+        tag_end -= APE_ID3V1_SIZE;
+    }
+
+    if (tail_size >= size - tag_end + APE_FOOTER_SIZE
+        && memcmp (tail + tail_size - (size - tag_end) - APE_FOOTER_SIZE,
+                   "APETAGEX", 8) == 0)
+    {
+        footer = tail + tail_size - (size - tag_end) - APE_FOOTER_SIZE;
+    }
+
+    /* Second read: the items of the APE tag. The size in the footer includes
+     * the footer, but not the header. */
+    if (footer)
+    {
+        const guint32 version = read_uint32_le (footer + 8);
+        const guint32 length = read_uint32_le (footer + 12);
+        const guint32 n_items = read_uint32_le (footer + 16);
+        const goffset items_end = tag_end - APE_FOOTER_SIZE;
+
+        if (length > APE_FOOTER_SIZE && length - APE_FOOTER_SIZE <= items_end)
+        {
+            const gsize items_size = length - APE_FOOTER_SIZE;
+            guchar *items;
+            gssize bytes_read;
+
+            items = g_try_malloc (items_size);
+
+            if (!items)
+            {
+                g_object_unref (istream);
+                g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_NOMEM, "%s",
+                             g_strerror (ENOMEM));
+                return FALSE;
+            }
+
+            bytes_read = read_at (G_INPUT_STREAM (istream),
+                                  items_end - items_size, items, items_size,
+                                  error);
+
+            if (bytes_read < 0)
+            {
+                g_free (items);
+                g_object_unref (istream);
+                return FALSE;
+            }
+
+            parse_items (items, bytes_read, n_items, version, values);
+            g_free (items);
+        }
+    }
+
+    g_object_unref (istream);
+
+    if (id3v1)
+    {
+        parse_id3v1 (id3v1, values);
+    }
+
+    return TRUE;
+}
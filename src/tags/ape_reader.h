@@ -0,0 +1,60 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ET_APE_READER_H_
+#define ET_APE_READER_H_
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/*
+ * EtApeField:
+ * @ET_APE_FIELD_UNKNOWN: an item which is not read into the tag
+ * @ET_APE_FIELD_PART: disc number and total, as "Part"
+ * @ET_APE_FIELD_URL: URL, as "Related"
+ *
+ * The APE tag items which are read into a #File_Tag. The other values are
+ * named after the item key.
+ */
+typedef enum
+{
+    ET_APE_FIELD_UNKNOWN = -1,
+    ET_APE_FIELD_TITLE,
+    ET_APE_FIELD_ARTIST,
+    ET_APE_FIELD_ALBUM_ARTIST,
+    ET_APE_FIELD_ALBUM,
+    ET_APE_FIELD_PART,
+    ET_APE_FIELD_YEAR,
+    ET_APE_FIELD_TRACK,
+    ET_APE_FIELD_GENRE,
+    ET_APE_FIELD_COMMENT,
+    ET_APE_FIELD_COMPOSER,
+    ET_APE_FIELD_ORIG_ARTIST,
+    ET_APE_FIELD_COPYRIGHT,
+    ET_APE_FIELD_URL,
+    ET_APE_FIELD_ENCODED_BY,
+    ET_APE_FIELD_COUNT
+} EtApeField;
+
+EtApeField et_ape_field_from_key (const gchar *key, gsize length);
+gboolean et_ape_reader_read_file (GFile *file, gchar **values, GError **error);
+
+G_END_DECLS
+
+#endif /* ET_APE_READER_H_ */
@@ -24,6 +24,7 @@
 #include <glib/gstdio.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <errno.h>
 
 #include "ape_tag.h"
@@ -31,6 +32,7 @@
 #include "misc.h"
 #include "setting.h"
 #include "charset.h"
+#include "ape_reader.h"
 #include "libapetag/apetaglib.h"
 
 /*************
@@ -64,6 +66,37 @@ set_string_field (gchar **field,
     }
 }
 
+/*
+ * set_number_fields:
+ * @string: (transfer none): a number, optionally followed by a slash and the
+ *          total
+ * @number: (out): location in which to store the number
+ * @total: (out): location in which to store the total
+ * @to_string: function to format the numbers
+ */
+static void
+set_number_fields (const gchar *string,
+                   gchar **number,
+                   gchar **total,
+                   gchar * (*to_string) (guint))
+{
+    gchar *string1;
+    gchar *separator;
+
+    string1 = Try_To_Validate_Utf8_String (string);
+    separator = strchr (string1, '/');
+
+    if (separator)
+    {
+        *total = to_string (atoi (separator + 1));
+        *separator = '\0';
+    }
+
+    *number = to_string (atoi (string1));
+
+    g_free (string1);
+}
+
 /*
  * Note:
  *  - if field is found but contains no info (strlen(str)==0), we don't read it
@@ -73,130 +106,55 @@ ape_tag_read_file_tag (GFile *file,
                        File_Tag *FileTag,
                        GError **error)
 {
-    FILE *fp;
-    gchar *filename;
-    gchar *string = NULL;
-    gchar *string1 = NULL;
-    apetag *ape_cnt;
+    gchar *values[ET_APE_FIELD_COUNT] = { NULL, };
+    gsize i;
 
     g_return_val_if_fail (file != NULL && FileTag != NULL, FALSE);
     g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-    filename = g_file_get_path (file);
-
-    if ((fp = g_fopen (filename, "rb")) == NULL)
+    /* Read all the items at once, with the values of the ID3v1 tag for the
+     * missing ones. */
+    if (!et_ape_reader_read_file (file, values, error))
     {
-        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
-                     _("Error while opening file: %s"),
-                     g_strerror (errno));
-        g_free (filename);
         return FALSE;
     }
 
-    ape_cnt = apetag_init();
-    apetag_read_fp (ape_cnt, fp, filename, 0); /* read all tags ape,id3v[12]*/
-
-    g_free (filename);
-
-    /* Title */
-    string = apefrm_getstr (ape_cnt, APE_TAG_FIELD_TITLE);
-    set_string_field (&FileTag->title, string);
-
-    /* Artist */
-    string = apefrm_getstr (ape_cnt, APE_TAG_FIELD_ARTIST);
-    set_string_field (&FileTag->artist, string);
-
-    /* Album artist. */
-    string = apefrm_getstr (ape_cnt, APE_TAG_FIELD_ALBUMARTIST);
-    set_string_field (&FileTag->album_artist, string);
-
-    /* Album */
-    string = apefrm_getstr (ape_cnt, APE_TAG_FIELD_ALBUM);
-    set_string_field (&FileTag->album, string);
+    set_string_field (&FileTag->title, values[ET_APE_FIELD_TITLE]);
+    set_string_field (&FileTag->artist, values[ET_APE_FIELD_ARTIST]);
+    set_string_field (&FileTag->album_artist,
+                      values[ET_APE_FIELD_ALBUM_ARTIST]);
+    set_string_field (&FileTag->album, values[ET_APE_FIELD_ALBUM]);
 
     /* Disc Number and Disc Total */
-    string = apefrm_getstr (ape_cnt, APE_TAG_FIELD_PART);
-
-    if (string)
-    {
-        string = Try_To_Validate_Utf8_String (string);
-
-        string1 = strchr (string, '/');
-
-        if (string1)
-        {
-            FileTag->disc_total = et_disc_number_to_string (atoi (string1
-                                                                  + 1));
-            *string1 = '\0';
-        }
-
-        FileTag->disc_number = et_disc_number_to_string (atoi (string));
-
-        g_free (string);
-    }
-    else
+    if (values[ET_APE_FIELD_PART])
     {
-        FileTag->disc_number = FileTag->disc_total = NULL;
+        set_number_fields (values[ET_APE_FIELD_PART], &FileTag->disc_number,
+                           &FileTag->disc_total, et_disc_number_to_string);
     }
 
-    /* Year */
-    string = apefrm_getstr (ape_cnt, APE_TAG_FIELD_YEAR);
-    set_string_field (&FileTag->year, string);
+    set_string_field (&FileTag->year, values[ET_APE_FIELD_YEAR]);
 
     /* Track and Total Track */
-    string = apefrm_getstr (ape_cnt, APE_TAG_FIELD_TRACK);
-
-    if (string)
+    if (values[ET_APE_FIELD_TRACK])
     {
-        string = Try_To_Validate_Utf8_String(string);
-
-        string1 = strchr (string, '/');
+        set_number_fields (values[ET_APE_FIELD_TRACK], &FileTag->track,
+                           &FileTag->track_total, et_track_number_to_string);
+    }
 
-        if (string1)
-        {
-            FileTag->track_total = et_track_number_to_string (atoi (string1
-                                                                    + 1));
-            *string1 = '\0';
-        }
-        FileTag->track = et_track_number_to_string (atoi (string));
+    set_string_field (&FileTag->genre, values[ET_APE_FIELD_GENRE]);
+    set_string_field (&FileTag->comment, values[ET_APE_FIELD_COMMENT]);
+    set_string_field (&FileTag->composer, values[ET_APE_FIELD_COMPOSER]);
+    set_string_field (&FileTag->orig_artist,
+                      values[ET_APE_FIELD_ORIG_ARTIST]);
+    set_string_field (&FileTag->copyright, values[ET_APE_FIELD_COPYRIGHT]);
+    set_string_field (&FileTag->url, values[ET_APE_FIELD_URL]);
+    set_string_field (&FileTag->encoded_by, values[ET_APE_FIELD_ENCODED_BY]);
 
-        g_free(string);
-    } else
+    for (i = 0; i < G_N_ELEMENTS (values); i++)
     {
-        FileTag->track = FileTag->track_total = NULL;
+        g_free (values[i]);
     }
 
-    /* Genre */
-    string = apefrm_getstr (ape_cnt, APE_TAG_FIELD_GENRE);
-    set_string_field (&FileTag->genre, string);
-
-    /* Comment */
-    string = apefrm_getstr (ape_cnt, APE_TAG_FIELD_COMMENT);
-    set_string_field (&FileTag->comment, string);
-
-    /* Composer */
-    string = apefrm_getstr (ape_cnt, APE_TAG_FIELD_COMPOSER);
-    set_string_field (&FileTag->composer, string);
-
-    /* Original artist */
-    string = apefrm_getstr (ape_cnt, "Original Artist");
-    set_string_field (&FileTag->orig_artist, string);
-
-    /* Copyright */
-    string = apefrm_getstr (ape_cnt, APE_TAG_FIELD_COPYRIGHT);
-    set_string_field (&FileTag->copyright, string);
-
-    /* URL */
-    string = apefrm_getstr (ape_cnt, APE_TAG_FIELD_RELATED_URL);
-    set_string_field (&FileTag->url, string);
-
-    /* Encoded by */
-    string = apefrm_getstr (ape_cnt, "Encoded By");
-    set_string_field (&FileTag->encoded_by, string);
-
-    apetag_free (ape_cnt);
-    fclose (fp);
-
     return TRUE;
 }
 
@@ -205,7 +163,7 @@ ape_tag_write_file_tag (const ET_File *ETFile,
                         GError **error)
 {
     const File_Tag *FileTag;
-    const gchar *filename_in;
+    gchar *filename_in;
     //FILE     *file_in;
     gchar    *string;
     //GList    *list;
@@ -215,7 +173,6 @@ ape_tag_write_file_tag (const ET_File *ETFile,
     g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
     FileTag     = (File_Tag *)ETFile->FileTag->data;
-    filename_in = ((File_Name *)ETFile->FileNameCur->data)->value;
 
     ape_mem = apetag_init ();
 
@@ -364,16 +321,22 @@ ape_tag_write_file_tag (const ET_File *ETFile,
     else
         apefrm_remove(ape_mem,"Encoded By");
 
-    /* reread all tag-type again  excl. changed frames by apefrm_remove() */
-    if (apetag_save (filename_in, ape_mem, APE_TAG_V2 + SAVE_NEW_OLD_APE_TAG)
+    /* reread all tag-type again  excl. changed frames by apefrm_remove(),
+     * and leave room for later edits to be written in place. */
+    filename_in = et_file_name_get_path ((File_Name *)ETFile->FileNameCur->data);
+
+    if (apetag_save (filename_in, ape_mem,
+                     APE_TAG_V2 + SAVE_NEW_OLD_APE_TAG + SAVE_RESERVE_PADDING)
         != 0)
     {
         g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED, "%s",
                      _("Failed to write APE tag"));
+        g_free (filename_in);
         apetag_free (ape_mem);
         return FALSE;
     }
 
+    g_free (filename_in);
     apetag_free(ape_mem);
 
     return TRUE;
@@ -733,8 +733,8 @@ flac_tag_write_file_tag (const ET_File *ETFile,
                                     et_flac_seek_func, et_flac_tell_func,
                                     et_flac_eof_func,
                                     et_flac_write_close_func };
-    const gchar *filename;
-    const gchar *filename_utf8;
+    gchar *filename;
+    gchar *filename_utf8;
     const gchar *flac_error_msg;
     FLAC__Metadata_Chain *chain;
     FLAC__Metadata_Iterator *iter;
@@ -745,8 +745,8 @@ flac_tag_write_file_tag (const ET_File *ETFile,
     g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
     FileTag       = (File_Tag *)ETFile->FileTag->data;
-    filename      = ((File_Name *)ETFile->FileNameCur->data)->value;
-    filename_utf8 = ((File_Name *)ETFile->FileNameCur->data)->value_utf8;
+    filename      = et_file_name_get_path ((File_Name *)ETFile->FileNameCur->data);
+    filename_utf8 = et_file_name_get_path_utf8 ((File_Name *)ETFile->FileNameCur->data);
 
     /* libFLAC is able to detect (and skip) ID3v2 tags by itself */
     
@@ -760,6 +760,8 @@ flac_tag_write_file_tag (const ET_File *ETFile,
         g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
                      _("Error while opening file ‘%s’ as FLAC: %s"),
                      filename_utf8, flac_error_msg);
+        g_free (filename_utf8);
+        g_free (filename);
         return FALSE;
     }
 
@@ -776,6 +778,8 @@ flac_tag_write_file_tag (const ET_File *ETFile,
         FLAC__metadata_chain_delete (chain);
         g_propagate_error (error, state.error);
         g_object_unref (file);
+        g_free (filename_utf8);
+        g_free (filename);
         return FALSE;
     }
 
@@ -794,6 +798,8 @@ flac_tag_write_file_tag (const ET_File *ETFile,
                      _("Error while opening file ‘%s’ as FLAC: %s"),
                      filename_utf8, flac_error_msg);
         et_flac_write_close_func (&state);
+        g_free (filename_utf8);
+        g_free (filename);
         return FALSE;
     }
     
@@ -809,6 +815,8 @@ flac_tag_write_file_tag (const ET_File *ETFile,
                      filename_utf8, flac_error_msg);
         FLAC__metadata_chain_delete (chain);
         et_flac_write_close_func (&state);
+        g_free (filename_utf8);
+        g_free (filename);
         return FALSE;
     }
     
@@ -871,32 +879,28 @@ flac_tag_write_file_tag (const ET_File *ETFile,
          *********/
         vc_block_append_tag (vc_block, ET_VORBIS_COMMENT_FIELD_TITLE,
                              FileTag->title,
-                             g_settings_get_boolean (MainSettings,
-                                                     "ogg-split-title"));
+                             et_settings_get_snapshot ()->ogg_split_title);
 
         /**********
          * Artist *
          **********/
         vc_block_append_tag (vc_block, ET_VORBIS_COMMENT_FIELD_ARTIST,
                              FileTag->artist,
-                             g_settings_get_boolean (MainSettings,
-                                                     "ogg-split-artist"));
+                             et_settings_get_snapshot ()->ogg_split_artist);
 
         /****************
          * Album Artist *
          ****************/
         vc_block_append_tag (vc_block, ET_VORBIS_COMMENT_FIELD_ALBUM_ARTIST,
                              FileTag->album_artist,
-                             g_settings_get_boolean (MainSettings,
-                                                     "ogg-split-artist"));
+                             et_settings_get_snapshot ()->ogg_split_artist);
 
         /*********
          * Album *
          *********/
         vc_block_append_tag (vc_block, ET_VORBIS_COMMENT_FIELD_ALBUM,
                              FileTag->album,
-                             g_settings_get_boolean (MainSettings,
-                                                     "ogg-split-album"));
+                             et_settings_get_snapshot ()->ogg_split_album);
 
         /******************************
          * Disc Number and Disc Total *
@@ -925,32 +929,28 @@ flac_tag_write_file_tag (const ET_File *ETFile,
          *********/
         vc_block_append_tag (vc_block, ET_VORBIS_COMMENT_FIELD_GENRE,
                              FileTag->genre,
-                             g_settings_get_boolean (MainSettings,
-                                                     "ogg-split-genre"));
+                             et_settings_get_snapshot ()->ogg_split_genre);
 
         /***********
          * Comment *
          ***********/
         vc_block_append_tag (vc_block, ET_VORBIS_COMMENT_FIELD_DESCRIPTION,
                              FileTag->comment,
-                             g_settings_get_boolean (MainSettings,
-                                                     "ogg-split-comment"));
+                             et_settings_get_snapshot ()->ogg_split_comment);
 
         /************
          * Composer *
          ************/
         vc_block_append_tag (vc_block, ET_VORBIS_COMMENT_FIELD_COMPOSER,
                              FileTag->composer,
-                             g_settings_get_boolean (MainSettings,
-                                                     "ogg-split-composer"));
+                             et_settings_get_snapshot ()->ogg_split_composer);
 
         /*******************
          * Original artist *
          *******************/
         vc_block_append_tag (vc_block, ET_VORBIS_COMMENT_FIELD_PERFORMER,
                              FileTag->orig_artist,
-                             g_settings_get_boolean (MainSettings,
-                                                     "ogg-split-original-artist"));
+                             et_settings_get_snapshot ()->ogg_split_original_artist);
 
         /*************
          * Copyright *
@@ -1080,6 +1080,8 @@ flac_tag_write_file_tag (const ET_File *ETFile,
             FLAC__metadata_chain_delete (chain);
             g_propagate_error (error, temp_error);
             et_flac_write_close_func (&state);
+            g_free (filename_utf8);
+            g_free (filename);
             return FALSE;
         }
 
@@ -1107,6 +1109,8 @@ flac_tag_write_file_tag (const ET_File *ETFile,
             g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
                          _("Failed to write comments to file ‘%s’: %s"),
                          filename_utf8, flac_error_msg);
+            g_free (filename_utf8);
+            g_free (filename);
             return FALSE;
         }
 
@@ -1120,6 +1124,8 @@ flac_tag_write_file_tag (const ET_File *ETFile,
                          _("Failed to write comments to file ‘%s’: %s"),
                          filename_utf8, state.error->message);
             et_flac_write_close_func (&state);
+            g_free (filename_utf8);
+            g_free (filename);
             return FALSE;
         }
 
@@ -1139,6 +1145,8 @@ flac_tag_write_file_tag (const ET_File *ETFile,
             g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
                          _("Failed to write comments to file ‘%s’: %s"),
                          filename_utf8, flac_error_msg);
+            g_free (filename_utf8);
+            g_free (filename);
             return FALSE;
         }
     }
@@ -1153,8 +1161,7 @@ flac_tag_write_file_tag (const ET_File *ETFile,
         File_Name *FileName_tmp = et_file_name_new ();
         File_Tag  *FileTag_tmp = et_file_tag_new ();
         // Same file...
-        FileName_tmp->value      = g_strdup(filename);
-        FileName_tmp->value_utf8 = g_strdup(filename_utf8); // Not necessary to fill 'value_ck'
+        ET_Set_Filename_File_Name_Item (FileName_tmp, filename_utf8, filename);
         ETFile_tmp->FileNameList = g_list_append(NULL,FileName_tmp);
         ETFile_tmp->FileNameCur  = ETFile_tmp->FileNameList;
         // With empty tag...
@@ -1164,7 +1171,10 @@ flac_tag_write_file_tag (const ET_File *ETFile,
         ET_Free_File_List_Item(ETFile_tmp);
     }
 #endif
-    
+
+    g_free (filename_utf8);
+    g_free (filename);
+
     return TRUE;
 }
 
@@ -25,6 +25,7 @@
 
 #include "id3_tag.h"
 #include "ape_tag.h"
+#include "mpeg_probe.h"
 #include "picture.h"
 #include "easytag.h"
 #include "genres.h"
@@ -148,8 +149,8 @@ id3tag_write_file_v23tag (const ET_File *ETFile,
                           GError **error)
 {
     const File_Tag *FileTag;
-    const gchar *filename;
-    const gchar *filename_utf8;
+    gchar *filename;
+    gchar *filename_utf8;
     gchar    *basename_utf8;
     GFile *file;
     ID3Tag   *id3_tag = NULL;
@@ -197,14 +198,14 @@ id3tag_write_file_v23tag (const ET_File *ETFile,
     }
 
     FileTag  = (File_Tag *)ETFile->FileTag->data;
-    filename      = ((File_Name *)ETFile->FileNameCur->data)->value;
-    filename_utf8 = ((File_Name *)ETFile->FileNameCur->data)->value_utf8;
+    filename      = et_file_name_get_path ((File_Name *)ETFile->FileNameCur->data);
+    filename_utf8 = et_file_name_get_path_utf8 ((File_Name *)ETFile->FileNameCur->data);
 
     file = g_file_new_for_path (filename);
 
     /* This is a protection against a bug in id3lib that enters an infinite
      * loop with corrupted MP3 files (files containing only zeroes) */
-    if (!et_id3tag_check_if_file_is_valid (file, error))
+    if (!et_mpeg_probe_file (file, error))
     {
         if (error)
         {
@@ -216,6 +217,8 @@ id3tag_write_file_v23tag (const ET_File *ETFile,
         g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "%s",
                      _("Corrupted file"));
         g_object_unref (file);
+        g_free (filename_utf8);
+        g_free (filename);
         return FALSE;
     }
 
@@ -226,6 +229,8 @@ id3tag_write_file_v23tag (const ET_File *ETFile,
         g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_NOMEM, "%s",
                      g_strerror (ENOMEM));
         g_object_unref (file);
+        g_free (filename_utf8);
+        g_free (filename);
         return FALSE;
     }
 
@@ -242,6 +247,8 @@ id3tag_write_file_v23tag (const ET_File *ETFile,
                          g_strerror (EINVAL));
             ID3Tag_Delete (id3_tag);
             g_object_unref (file);
+            g_free (filename_utf8);
+            g_free (filename);
             return FALSE;
         }
 
@@ -600,8 +607,7 @@ id3tag_write_file_v23tag (const ET_File *ETFile,
         File_Name *FileName_tmp = et_file_name_new ();
         File_Tag  *FileTag_tmp = et_file_tag_new();
         // Same file...
-        FileName_tmp->value      = g_strdup(filename);
-        FileName_tmp->value_utf8 = g_strdup(filename_utf8);  // Not necessary to fill 'value_ck'
+        ET_Set_Filename_File_Name_Item (FileName_tmp, filename_utf8, filename);
         ETFile_tmp->FileNameList = g_list_append(NULL,FileName_tmp);
         ETFile_tmp->FileNameCur  = ETFile_tmp->FileNameList;
         // With empty tag...
@@ -768,6 +774,8 @@ id3tag_write_file_v23tag (const ET_File *ETFile,
     ID3Tag_Delete(id3_tag);
     g_object_unref (file);
     g_free(basename_utf8);
+    g_free (filename_utf8);
+    g_free (filename);
 
     return success;
 }
@@ -1460,65 +1468,6 @@ Id3tag_Rules_For_ISO_Fields (const gchar *string,
     return string_converted;
 }
 
-/*
- * Some files which contains only zeroes create an infinite loop in id3lib...
- * To generate a file with zeroes : dd if=/dev/zero bs=1M count=6 of=test-corrupted-mp3-zero-contend.mp3
- */
-gboolean
-et_id3tag_check_if_file_is_valid (GFile *file, GError **error)
-{
-    unsigned char tmp[256];
-    unsigned char tmp0[256];
-    gssize bytes_read;
-    gboolean valid = FALSE;
-    GFileInputStream *file_istream;
-
-    g_return_val_if_fail (file != NULL, FALSE);
-
-    file_istream = g_file_read (file, NULL, error);
-
-    if (!file_istream)
-    {
-        g_assert (error == NULL || *error != NULL);
-        return valid;
-    }
-
-    memset (&tmp0, 0, 256);
-
-    /* Keep reading until EOF. */
-    while ((bytes_read = g_input_stream_read (G_INPUT_STREAM (file_istream),
-                                              tmp, 256, NULL, error)) != 0)
-    {
-        if (bytes_read == -1)
-        {
-            /* Error in reading file. */
-            g_assert (error == NULL || *error != NULL);
-            g_object_unref (file_istream);
-            return valid;
-        }
-
-        /* Break out of the loop if there is a non-zero byte in the file. */
-        if (memcmp (tmp, tmp0, bytes_read) != 0)
-        {
-            valid = TRUE;
-            break;
-        }
-    }
-
-    g_object_unref (file_istream);
-
-    /* The error was not set by g_input_stream_read(), so the file must be
-     * empty. */
-    if (!valid)
-    {
-        g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED, "%s",
-                     _("Input truncated or empty"));
-    }
-
-    return valid;
-}
-
-
 /*
  * Function to detect if id3lib isn't bugged when writting to Unicode
  * Returns TRUE if bugged, else FALSE
@@ -47,6 +47,7 @@ typedef enum
 } EtID3Error;
 
 gboolean id3tag_read_file_tag (GFile *file, File_Tag *FileTag, GError **error);
+gboolean et_id3tag_read_file (GFile *file, File_Tag *FileTag, goffset *audio_offset, GError **error);
 gboolean id3tag_write_file_v24tag (const ET_File *ETFile, GError **error);
 gboolean id3tag_write_file_tag (const ET_File *ETFile, GError **error);
 
@@ -54,7 +55,6 @@ const gchar * Id3tag_Genre_To_String (unsigned char genre_code);
 guchar Id3tag_String_To_Genre (const gchar *genre);
 
 gchar *et_id3tag_get_tpos_from_file_tag (const File_Tag *file_tag);
-gboolean et_id3tag_check_if_file_is_valid (GFile *file, GError **error);
 
 G_END_DECLS
 
@@ -91,20 +91,148 @@ id3tag_read_file_tag (GFile *gfile,
                       File_Tag *FileTag,
                       GError **error)
 {
-    GInputStream *istream;
+    return et_id3tag_read_file (gfile, FileTag, NULL, error);
+}
+
+/*
+ * read_id3v2_tag:
+ * @istream: a stream, at the start of the file
+ * @v2tag: return location for the ID3v2 tag, or %NULL if there is none
+ * @error: a #GError to provide information on errors, or %NULL to ignore
+ *
+ * Read the whole ID3v2 tag at the start of the file into a single buffer,
+ * and parse it.
+ *
+ * Returns: the size of the ID3v2 tag, which is the offset of the audio data,
+ *          or -1 on error
+ */
+static goffset
+read_id3v2_tag (GInputStream *istream,
+                struct id3_tag **v2tag,
+                GError **error)
+{
+    id3_byte_t query[ID3_TAG_QUERYSIZE];
+    id3_byte_t *buffer;
     gsize bytes_read;
-    GSeekable *seekable;
-    gchar *filename;
-    int fd;
-    struct id3_file *file;
+    long tagsize;
+
+    *v2tag = NULL;
+
+    if (!g_input_stream_read_all (istream, query, ID3_TAG_QUERYSIZE,
+                                  &bytes_read, NULL, error))
+    {
+        return -1;
+    }
+    else if (bytes_read != ID3_TAG_QUERYSIZE)
+    {
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_PARTIAL_INPUT, "%s",
+                     _("Error reading tags from file"));
+        return -1;
+    }
+
+    tagsize = id3_tag_query (query, ID3_TAG_QUERYSIZE);
+
+    if (tagsize <= ID3_TAG_QUERYSIZE)
+    {
+        /* ID3v2 tag not found. */
+        return 0;
+    }
+
+    buffer = g_try_malloc (tagsize);
+
+    if (!buffer)
+    {
+        g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_NOMEM, "%s",
+                     g_strerror (ENOMEM));
+        return -1;
+    }
+
+    memcpy (buffer, query, ID3_TAG_QUERYSIZE);
+
+    if (!g_input_stream_read_all (istream, buffer + ID3_TAG_QUERYSIZE,
+                                  tagsize - ID3_TAG_QUERYSIZE, &bytes_read,
+                                  NULL, error))
+    {
+        g_free (buffer);
+        return -1;
+    }
+
+    /* A truncated tag is ignored, as by libid3tag. */
+    if (bytes_read == (gsize)(tagsize - ID3_TAG_QUERYSIZE))
+    {
+        *v2tag = id3_tag_parse (buffer, tagsize);
+    }
+
+    g_free (buffer);
+
+    return tagsize;
+}
+
+/*
+ * read_id3v1_tag:
+ * @istream: a seekable stream
+ *
+ * Returns: the ID3v1 tag at the end of the file, or %NULL if there is none
+ */
+static struct id3_tag *
+read_id3v1_tag (GInputStream *istream)
+{
+    id3_byte_t buffer[ID3V1_TAG_SIZE];
+    gsize bytes_read;
+
+    /* Errors are ignored, as the file may be smaller than a tag. */
+    if (!g_seekable_seek (G_SEEKABLE (istream), -ID3V1_TAG_SIZE, G_SEEK_END,
+                          NULL, NULL)
+        || !g_input_stream_read_all (istream, buffer, ID3V1_TAG_SIZE,
+                                     &bytes_read, NULL, NULL)
+        || bytes_read != ID3V1_TAG_SIZE
+        || memcmp (buffer, "TAG", 3) != 0)
+    {
+        return NULL;
+    }
+
+    return id3_tag_parse (buffer, ID3V1_TAG_SIZE);
+}
+
+static void
+picture_frame_free (gpointer frame)
+{
+    id3_frame_delete (frame);
+}
+
+/*
+ * et_id3tag_read_file:
+ * @gfile: the file to read
+ * @FileTag: the tag to fill
+ * @audio_offset: return location for the offset of the audio data, which
+ *                follows the ID3v2 tag, or %NULL
+ * @error: a #GError to provide information on errors, or %NULL to ignore
+ *
+ * Read the ID3v2 and ID3v1 tags of the file. Each tag is read once into a
+ * buffer and parsed by libid3tag, and the frames of the ID3v2 tag are used if
+ * there are any, otherwise those of the ID3v1 tag, as with id3_file_open().
+ * The image data of APIC frames is given to the pictures without being
+ * copied, and is only decoded as an image when it is displayed.
+ *
+ * Returns: %TRUE on success, %FALSE and with @error set otherwise
+ */
+gboolean
+et_id3tag_read_file (GFile *gfile,
+                     File_Tag *FileTag,
+                     goffset *audio_offset,
+                     GError **error)
+{
+    GInputStream *istream;
+    struct id3_tag *v1tag;
+    struct id3_tag *v2tag;
     struct id3_tag *tag;
     struct id3_frame *frame;
     union id3_field *field;
     gchar *string1, *string2;
     EtPicture *prev_pic = NULL;
+    goffset v2size;
     int i, j;
     unsigned tmpupdate, update = 0;
-    long tagsize;
 
     g_return_val_if_fail (gfile != NULL && FileTag != NULL, FALSE);
     g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
@@ -116,27 +244,22 @@ id3tag_read_file_tag (GFile *gfile,
         return FALSE;
     }
 
-    string1 = g_malloc0 (ID3_TAG_QUERYSIZE);
-
     /* Check if the file has an ID3v2 tag or/and an ID3v1 tags.
      * 1) ID3v2 tag. */
-    if (!g_input_stream_read_all (istream, string1, ID3_TAG_QUERYSIZE,
-                                  &bytes_read, NULL, error))
+    v2size = read_id3v2_tag (istream, &v2tag, error);
+
+    if (v2size < 0)
     {
         g_object_unref (istream);
-        g_free (string1);
         return FALSE;
     }
-    else if (bytes_read != ID3_TAG_QUERYSIZE)
+
+    if (audio_offset)
     {
-        g_object_unref (istream);
-        g_free (string1);
-        g_set_error (error, G_IO_ERROR, G_IO_ERROR_PARTIAL_INPUT, "%s",
-                     _("Error reading tags from file"));
-        return FALSE;
+        *audio_offset = v2size;
     }
 
-    if ((tagsize = id3_tag_query((id3_byte_t const *)string1, ID3_TAG_QUERYSIZE)) <= ID3_TAG_QUERYSIZE)
+    if (v2size == 0)
     {
         /* ID3v2 tag not found! */
         update = g_settings_get_boolean (MainSettings, "id3v2-enabled");
@@ -151,16 +274,9 @@ id3tag_read_file_tag (GFile *gfile,
         {
             /* Determine version if user want to upgrade old tags */
             if (g_settings_get_boolean (MainSettings, "id3v2-convert-old")
-            && (string1 = g_realloc (string1, tagsize))
-                && g_input_stream_read_all (istream,
-                                            &string1[ID3_TAG_QUERYSIZE],
-                                            tagsize - ID3_TAG_QUERYSIZE,
-                                            &bytes_read, NULL, error)
-                && bytes_read == (gsize)(tagsize - ID3_TAG_QUERYSIZE)
-            && (tag = id3_tag_parse((id3_byte_t const *)string1, tagsize))
-               )
+                && v2tag)
             {
-                unsigned version = id3_tag_version(tag);
+                unsigned version = id3_tag_version (v2tag);
 #ifdef ENABLE_ID3LIB
                 /* Besides upgrade old tags we will downgrade id3v2.4 to id3v2.3 */
                 if (g_settings_get_boolean (MainSettings, "id3v2-version-4"))
@@ -174,33 +290,27 @@ id3tag_read_file_tag (GFile *gfile,
 #else
                 update = (ID3_TAG_VERSION_MAJOR(version) < 4);
 #endif
-                id3_tag_delete(tag);
             }
         }
     }
 
     /* 2) ID3v1 tag. */
-    seekable = G_SEEKABLE (istream);
-
-    if (!g_seekable_can_seek (seekable))
+    if (!g_seekable_can_seek (G_SEEKABLE (istream)))
     {
+        if (v2tag)
+        {
+            id3_tag_delete (v2tag);
+        }
+
         g_object_unref (istream);
-        g_free (string1);
         g_set_error (error, G_IO_ERROR, G_IO_ERROR_PARTIAL_INPUT, "%s",
                      _("Error reading tags from file"));
         return FALSE;
     }
 
-    /* Go to the beginning of ID3v1 tag. */
-    if (g_seekable_seek (seekable, -ID3V1_TAG_SIZE, G_SEEK_END, NULL, error)
-    && (string1)
-        && g_input_stream_read_all (istream, string1, 3, &bytes_read, NULL,
-                                    NULL /* Ignore errors. */)
-        && bytes_read == 3
-    && (string1[0] == 'T')
-    && (string1[1] == 'A')
-    && (string1[2] == 'G')
-       )
+    v1tag = read_id3v1_tag (istream);
+
+    if (v1tag)
     {
         /* ID3v1 tag found! */
         if (!g_settings_get_boolean (MainSettings, "id3v1-enabled"))
@@ -216,33 +326,23 @@ id3tag_read_file_tag (GFile *gfile,
         }
     }
 
-    g_free (string1);
     g_object_unref (istream);
 
-    filename = g_file_get_path (gfile);
+    /* The ID3v2 tag replaces the ID3v1 tag. */
+    tag = v2tag && v2tag->nframes > 0 ? v2tag : v1tag;
 
-    if ((fd = g_open (filename, O_RDONLY, 0)) == -1)
+    if (!tag || tag->nframes == 0)
     {
-        g_free (filename);
-        g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED, "%s",
-                     _("Error reading tags from file"));
-        return FALSE;
-    }
-
-    g_free (filename);
+        if (v1tag)
+        {
+            id3_tag_delete (v1tag);
+        }
 
-    /* The fd ownership is transferred to id3tag. */
-    if ((file = id3_file_fdopen (fd, ID3_FILE_MODE_READONLY)) == NULL)
-    {
-        g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED, "%s",
-                     _("Error reading tags from file"));
-        return FALSE;
-    }
+        if (v2tag)
+        {
+            id3_tag_delete (v2tag);
+        }
 
-    if ( ((tag = id3_file_tag(file)) == NULL)
-    ||   (tag->nframes == 0))
-    {
-        id3_file_close(file);
         g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED, "%s",
                      _("Error reading tags from file"));
         return FALSE;
@@ -463,8 +563,10 @@ id3tag_read_file_tag (GFile *gfile,
     /******************
      * Picture (APIC) *
      ******************/
-    for (i = 0; (frame = id3_tag_findframe(tag, "APIC", i)); i++)
+    while ((frame = id3_tag_findframe (tag, "APIC", 0)))
     {
+        id3_length_t size = 0;
+        id3_byte_t const *data = NULL;
         GBytes *bytes = NULL;
         EtPictureType type = ET_PICTURE_TYPE_FRONT_COVER;
         gchar *description;
@@ -479,19 +581,15 @@ id3tag_read_file_tag (GFile *gfile,
 
             if (field_type == ID3_FIELD_TYPE_BINARYDATA)
             {
-                id3_length_t size;
-                id3_byte_t const *data;
+                id3_length_t field_size;
+                id3_byte_t const *field_data;
 
-                data = id3_field_getbinarydata (field, &size);
+                field_data = id3_field_getbinarydata (field, &field_size);
 
-                if (data)
+                if (field_data)
                 {
-                    if (bytes)
-                    {
-                        g_bytes_unref (bytes);
-                    }
-
-                    bytes = g_bytes_new (data, size);
+                    data = field_data;
+                    size = field_size;
                 }
             }
             else if (field_type == ID3_FIELD_TYPE_INT8)
@@ -506,6 +604,20 @@ id3tag_read_file_tag (GFile *gfile,
         update |= libid3tag_Get_Frame_Str (frame, EASYTAG_ID3_FIELD_STRING,
                                            &description);
 
+        /* The picture keeps the frame which holds the image data, instead of
+         * a copy of the data. */
+        id3_tag_detachframe (tag, frame);
+
+        if (data)
+        {
+            bytes = g_bytes_new_with_free_func (data, size, picture_frame_free,
+                                                frame);
+        }
+        else
+        {
+            id3_frame_delete (frame);
+        }
+
         pic = et_picture_new (type, description ? description : "", 0, 0,
                               bytes);
         g_bytes_unref (bytes);
@@ -597,7 +709,15 @@ id3tag_read_file_tag (GFile *gfile,
         FileTag->saved = FALSE;
 
     /* Free allocated data */
-    id3_file_close(file);
+    if (v1tag)
+    {
+        id3_tag_delete (v1tag);
+    }
+
+    if (v2tag)
+    {
+        id3_tag_delete (v2tag);
+    }
 
     return TRUE;
 }
@@ -940,7 +1060,7 @@ id3tag_write_file_v24tag (const ET_File *ETFile,
                           GError **error)
 {
     const File_Tag *FileTag;
-    const gchar *filename;
+    gchar *filename;
     struct id3_tag   *v1tag, *v2tag;
     struct id3_frame *frame;
     union id3_field  *field;
@@ -954,7 +1074,7 @@ id3tag_write_file_v24tag (const ET_File *ETFile,
     g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
     FileTag       = (File_Tag *)ETFile->FileTag->data;
-    filename      = ((File_Name *)ETFile->FileNameCur->data)->value;
+    filename      = et_file_name_get_path ((File_Name *)ETFile->FileNameCur->data);
 
     v1tag = v2tag = NULL;
 
@@ -971,6 +1091,7 @@ id3tag_write_file_v24tag (const ET_File *ETFile,
         {
             g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED, "%s",
                          _("Error reading tags from file"));
+            g_free (filename);
             return FALSE;
         }
 
@@ -979,6 +1100,7 @@ id3tag_write_file_v24tag (const ET_File *ETFile,
         {
             g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED, "%s",
                          _("Error reading tags from file"));
+            g_free (filename);
             return FALSE;
         }
 
@@ -987,6 +1109,7 @@ id3tag_write_file_v24tag (const ET_File *ETFile,
             g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED, "%s",
                          _("Error reading tags from file"));
             id3_file_close(file);
+            g_free (filename);
             return FALSE;
         }
 
@@ -1013,6 +1136,7 @@ id3tag_write_file_v24tag (const ET_File *ETFile,
                 g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED, "%s",
                              _("Error reading tags from file"));
                 id3_file_close(file);
+                g_free (filename);
                 return FALSE;
             }
         }
@@ -1052,6 +1176,7 @@ id3tag_write_file_v24tag (const ET_File *ETFile,
         {
             g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED, "%s",
                          _("Error reading tags from file"));
+            g_free (filename);
             return FALSE;
         }
         
@@ -1238,6 +1363,7 @@ id3tag_write_file_v24tag (const ET_File *ETFile,
         id3_tag_delete(v1tag);
     if (v2tag)
         id3_tag_delete(v2tag);
+    g_free (filename);
 
     return success;
 }
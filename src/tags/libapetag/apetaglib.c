@@ -897,6 +897,8 @@ apetag_save (const char *filename, apetag *mem_cnt, int flag)
     unsigned char *buff, *p;
     struct tag **mTag;
     size_t tagSSize = 32;
+    size_t tagLength;
+    size_t padding = 0;
     int n;
     unsigned char temp[4];
     
@@ -950,20 +952,35 @@ apetag_save (const char *filename, apetag *mem_cnt, int flag)
     }
     //PRINT_D4 (">apetaglib>SAVE>>: size %li %i %i %i\n", tagSSize,
     //    mem_cnt->countTag, flag, saveApe2);
-    buff = (unsigned char *) malloc (tagSSize + (saveApe2 ? 32 : 0));
+    tagLength = tagSSize + (saveApe2 ? 32 : 0);
+    
+    /* If the new tag fits in the region of the old tags (APE and ID3v1), the
+     * rest of the region becomes padding, so that the file size does not
+     * change. If the tag grows, reserve padding for the next saves. */
+    if (realCountTag != 0) {
+        if (tagLength <= (size_t) skipBytes
+            && (size_t) skipBytes - tagLength <= APE_TAG_MAX_PADDING_SIZE) {
+            padding = skipBytes - tagLength;
+        } else if (flag & SAVE_RESERVE_PADDING) {
+            padding = APE_TAG_PADDING_SIZE;
+        }
+    }
+    
+    buff = (unsigned char *) malloc (tagLength + padding);
     p = buff;
     
     if (buff == NULL) {
         PRINT_ERR ("ERROR->libapetag->apetag_save::malloc");
+        fclose (fp);
         return ATL_MALOC;
     }
     memset (ape_footer.id, 0, sizeof (ape_footer));
     memcpy (ape_footer.id, "APETAGEX", sizeof (ape_footer.id));
     long2ape (ape_footer.flags, 0l);
     if (!!(flag & SAVE_CREATE_ID3V1_TAG ))
-        long2ape (ape_footer.length, tagSSize - ID3V1_TAG_SIZE);
+        long2ape (ape_footer.length, tagSSize - ID3V1_TAG_SIZE + padding);
     else
-        long2ape (ape_footer.length, tagSSize);
+        long2ape (ape_footer.length, tagSSize + padding);
     //long2ape(ape_footer.tagCount, mem_cnt->countTag);
     long2ape(ape_footer.tagCount, realCountTag);
     long2ape (ape_footer.version, (saveApe2 ? 2000 : 1000));
@@ -1004,6 +1021,10 @@ apetag_save (const char *filename, apetag *mem_cnt, int flag)
         }
     } /* for */
     
+    /* Padding, after the last item. */
+    memset (p, 0, padding);
+    p += padding;
+    
     if (saveApe2)
         long2ape (ape_footer.flags, FOOTER_THIS_IS + FOOTER_IS + HEADER_IS);
         
@@ -1014,47 +1035,59 @@ apetag_save (const char *filename, apetag *mem_cnt, int flag)
          memcpy (p, &id3v1_tag , sizeof (struct _id3v1Tag));
     }
     
-    /* write tag to file and truncate */
+    /* write tag to file with a single positioned write, and truncate only
+     * if the file became shorter */
     if (!(flag & SAVE_FAKE_SAVE)) {
-        size_t fileSize;
-        size_t newFileSize;
+        off_t fileSize;
+        off_t tagOffset;
+        size_t writeSize;
         size_t writedBytes;
         int fd;
         
         fseek (fp, 0, SEEK_END);
         fileSize = ftell (fp);
-        fseek (fp, fileSize - skipBytes, SEEK_SET);
-        if (tagCount != 0) {
-            newFileSize = (fileSize - skipBytes + tagSSize + (saveApe2 ? 32 : 0));
-            writedBytes = fwrite (buff, 1, tagSSize + (saveApe2 ? 32 : 0), fp);
-            if (writedBytes != tagSSize + (saveApe2 ? 32 : 0)) {
-                PRINT_ERR ("FATAL_ERROR->libapetag->apetag_save::fwrite [data lost]");
-                fclose (fp);
-                free (buff);
-                return ATL_FWRITE;
-            }
-            fseek (fp, newFileSize, SEEK_SET);
-            PRINT_D4 (">apetaglib>SAVE>> write:%zu == tag:%zu file: %zu->%zu\n",
-                writedBytes, tagSSize + (saveApe2 ? 32 : 0), fileSize, newFileSize);
-        } else {
-            newFileSize = (fileSize - skipBytes);
-        }
+        tagOffset = fileSize - skipBytes;
+        writeSize = (tagCount != 0) ? tagLength + padding : 0;
         fflush (fp);
 
         if ((fd = fileno (fp)) == -1)
         {
-            PRINT_ERR ("FATAL_ERROR->libapetag->apetag_save::fileno [file not truncated]");
+            PRINT_ERR ("FATAL_ERROR->libapetag->apetag_save::fileno [tag not written]");
             fclose (fp);
+            free (buff);
             return ATL_FWRITE;
         }
 
+        if (writeSize != 0) {
 #ifdef G_OS_WIN32
-        if (_chsize (fd, newFileSize) == -1)
+            if (lseek (fd, tagOffset, SEEK_SET) == -1) {
+                writedBytes = 0;
+            } else {
+                writedBytes = write (fd, buff, writeSize);
+            }
 #else
-        if (ftruncate (fd, newFileSize) == -1)
+            writedBytes = pwrite (fd, buff, writeSize, tagOffset);
 #endif
-        {
-            PRINT_ERR ("FATAL_ERROR->libapetag->apetag_save::fwrite [file not truncated]");
+            if (writedBytes != writeSize) {
+                PRINT_ERR ("FATAL_ERROR->libapetag->apetag_save::fwrite [data lost]");
+                fclose (fp);
+                free (buff);
+                return ATL_FWRITE;
+            }
+            PRINT_D4 (">apetaglib>SAVE>> write:%zu == tag:%zu file: %li->%li\n",
+                writedBytes, writeSize, (long) fileSize,
+                (long) (tagOffset + writeSize));
+        }
+
+        if (tagOffset + (off_t) writeSize < fileSize) {
+#ifdef G_OS_WIN32
+            if (_chsize (fd, tagOffset + writeSize) == -1)
+#else
+            if (ftruncate (fd, tagOffset + writeSize) == -1)
+#endif
+            {
+                PRINT_ERR ("FATAL_ERROR->libapetag->apetag_save::fwrite [file not truncated]");
+            }
         }
 
         fclose (fp);
@@ -125,6 +125,8 @@
 #define SAVE_REMOVE_ID3V1     (1 <<  5)
 #define SAVE_CREATE_ID3V1_TAG (1 <<  6)
 #define SAVE_FAKE_SAVE        (1 <<  7)
+/* reserve #APE_TAG_PADDING_SIZE bytes of padding when the tag grows */
+#define SAVE_RESERVE_PADDING  (1 << 11)
 /* apetag_read(_fp) flags - default read all (ape,id3v1,id3v2(if compiled)) */
 #define DONT_READ_TAG_APE     (1 <<  8)
 #define DONT_READ_TAG_ID3V1   (1 <<  9)
@@ -132,6 +134,18 @@
 /**\}*/
 
 
+/**
+    \name padding
+    \brief zero bytes between the last item and the footer, counted in the
+    tag size but not in the item count, so that later saves can update the
+    tag in place
+    \{
+*/
+#define APE_TAG_PADDING_SIZE     1024     /**< padding added by #SAVE_RESERVE_PADDING */
+#define APE_TAG_MAX_PADDING_SIZE 65536    /**< largest padding kept when the tag shrinks */
+/** \} */
+
+
 /**
     \name #atl_return
     \brief return codes from all functions
@@ -21,10 +21,70 @@
 
 /* This file is intended to be included directly in mp4_tag.cc */
 
+/*
+ * mp4_header_read_properties:
+ * @mp4file: an open MP4 file
+ * @ETFileInfo: the file information to fill
+ * @error: a #GError, or %NULL
+ *
+ * Fill @ETFileInfo from the audio properties of @mp4file, which have already
+ * been parsed together with the tag. The size is not set.
+ *
+ * Returns: %TRUE on success, %FALSE and with @error set otherwise
+ */
+static gboolean
+mp4_header_read_properties (TagLib::MP4::File &mp4file,
+                            ET_File_Info *ETFileInfo,
+                            GError **error)
+{
+    const TagLib::MP4::Properties *properties;
+
+    properties = mp4file.audioProperties ();
+
+    if (properties == NULL)
+    {
+        g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED, "%s",
+                     _("Error reading properties from file"));
+        return FALSE;
+    }
+
+    /* Get format/subformat */
+    {
+        ETFileInfo->mpc_version = g_strdup ("MPEG");
+
+        switch (properties->codec ())
+        {
+            case TagLib::MP4::Properties::AAC:
+                ETFileInfo->mpc_profile = g_strdup ("4, AAC");
+                break;
+            case TagLib::MP4::Properties::ALAC:
+                ETFileInfo->mpc_profile = g_strdup ("4, ALAC");
+                break;
+            case TagLib::MP4::Properties::Unknown:
+            default:
+                ETFileInfo->mpc_profile = g_strdup ("4, Unknown");
+                break;
+        };
+    }
+
+    ETFileInfo->version = 4;
+    ETFileInfo->mpeg25 = 0;
+    ETFileInfo->layer = 14;
+
+    ETFileInfo->variable_bitrate = TRUE;
+    ETFileInfo->bitrate = properties->bitrate ();
+    ETFileInfo->samplerate = properties->sampleRate ();
+    ETFileInfo->mode = properties->channels ();
+    ETFileInfo->duration = properties->length ();
+
+    return TRUE;
+}
+
 /*
  * et_mp4_header_read_file_info:
  *
- * Get header info into the ETFileInfo structure
+ * Get header info into the ETFileInfo structure. When the tag is read as
+ * well, use mp4tag_read_file_tag() instead, which parses the file only once.
  */
 gboolean
 et_mp4_header_read_file_info (GFile *file,
@@ -32,7 +92,6 @@ et_mp4_header_read_file_info (GFile *file,
                               GError **error)
 {
     GFileInfo *info;
-    const TagLib::MP4::Properties *properties;
 
     g_return_val_if_fail (file != NULL && ETFileInfo != NULL, FALSE);
 
@@ -69,45 +128,7 @@ et_mp4_header_read_file_info (GFile *file,
         return FALSE;
     }
 
-    properties = mp4file.audioProperties ();
-
-    if (properties == NULL)
-    {
-        g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED, "%s",
-                     _("Error reading properties from file"));
-        return FALSE;
-    }
-
-    /* Get format/subformat */
-    {
-        ETFileInfo->mpc_version = g_strdup ("MPEG");
-
-        switch (properties->codec ())
-        {
-            case TagLib::MP4::Properties::AAC:
-                ETFileInfo->mpc_profile = g_strdup ("4, AAC");
-                break;
-            case TagLib::MP4::Properties::ALAC:
-                ETFileInfo->mpc_profile = g_strdup ("4, ALAC");
-                break;
-            case TagLib::MP4::Properties::Unknown:
-            default:
-                ETFileInfo->mpc_profile = g_strdup ("4, Unknown");
-                break;
-        };
-    }
-
-    ETFileInfo->version = 4;
-    ETFileInfo->mpeg25 = 0;
-    ETFileInfo->layer = 14;
-
-    ETFileInfo->variable_bitrate = TRUE;
-    ETFileInfo->bitrate = properties->bitrate ();
-    ETFileInfo->samplerate = properties->sampleRate ();
-    ETFileInfo->mode = properties->channels ();
-    ETFileInfo->duration = properties->length ();
-
-    return TRUE;
+    return mp4_header_read_properties (mp4file, ETFileInfo, error);
 }
 
 /*
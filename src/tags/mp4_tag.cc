@@ -32,6 +32,7 @@
 #include "et_core.h"
 #include "charset.h"
 #include "gio_wrapper.h"
+#include "log.h"
 
 /* Shadow warning in public TagLib headers. */
 #pragma GCC diagnostic push
@@ -49,12 +50,23 @@
 
 /*
  * Mp4_Tag_Read_File_Tag:
+ * @file: the file to read
+ * @FileTag: the tag to fill
+ * @ETFileInfo: (allow-none): the file information to fill, or %NULL
+ * @error: a #GError, or %NULL
  *
- * Read tag data into an Mp4 file.
+ * Read tag data from an Mp4 file. If @ETFileInfo is not %NULL, the audio
+ * properties are read from the same parse of the atom tree, so that
+ * et_mp4_header_read_file_info() does not have to open the file again. If
+ * the properties cannot be read, the error is logged and @ETFileInfo is left
+ * without them.
+ *
+ * Returns: %TRUE on success, %FALSE and with @error set otherwise
  */
 gboolean
 mp4tag_read_file_tag (GFile *file,
                       File_Tag *FileTag,
+                      ET_File_Info *ETFileInfo,
                       GError **error)
 {
     TagLib::MP4::Tag *tag;
@@ -103,6 +115,27 @@ mp4tag_read_file_tag (GFile *file,
         return FALSE;
     }
 
+    /* Audio properties, only filled in if the tag could be read. Missing
+     * properties leave the file information empty, but the tag is still
+     * read. */
+    if (ETFileInfo != NULL)
+    {
+        GError *props_error = NULL;
+
+        ETFileInfo->size = stream.length ();
+
+        if (!mp4_header_read_properties (mp4file, ETFileInfo, &props_error))
+        {
+            gchar *display_path = g_file_get_parse_name (file);
+
+            Log_Print (LOG_ERROR,
+                       _("Error reading header of MP4 file ‘%s’: %s"),
+                       display_path, props_error->message);
+            g_free (display_path);
+            g_error_free (props_error);
+        }
+    }
+
     /*********
      * Title *
      *********/
@@ -276,19 +309,20 @@ mp4tag_write_file_tag (const ET_File *ETFile,
                        GError **error)
 {
     const File_Tag *FileTag;
-    const gchar *filename;
-    const gchar *filename_utf8;
+    gchar *filename;
+    gchar *filename_utf8;
     TagLib::MP4::Tag *tag;
     gboolean success;
 
     g_return_val_if_fail (ETFile != NULL && ETFile->FileTag != NULL, FALSE);
 
     FileTag = (File_Tag *)ETFile->FileTag->data;
-    filename      = ((File_Name *)ETFile->FileNameCur->data)->value;
-    filename_utf8 = ((File_Name *)ETFile->FileNameCur->data)->value_utf8;
+    filename      = et_file_name_get_path ((File_Name *)ETFile->FileNameCur->data);
+    filename_utf8 = et_file_name_get_path_utf8 ((File_Name *)ETFile->FileNameCur->data);
 
     /* Open file for writing */
     GFile *file = g_file_new_for_path (filename);
+    g_free (filename);
     GIO_IOStream stream (file);
 
     if (!stream.isOpen ())
@@ -297,6 +331,7 @@ mp4tag_write_file_tag (const ET_File *ETFile,
         g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
                      _("Error while opening file ‘%s’: %s"), filename_utf8,
                      tmp_error->message);
+        g_free (filename_utf8);
         return FALSE;
     }
 
@@ -322,6 +357,7 @@ mp4tag_write_file_tag (const ET_File *ETFile,
         }
 
 
+        g_free (filename_utf8);
         return FALSE;
     }
 
@@ -329,6 +365,7 @@ mp4tag_write_file_tag (const ET_File *ETFile,
     {
         g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
                      _("Error reading tags from file ‘%s’"), filename_utf8);
+        g_free (filename_utf8);
         return FALSE;
     }
 
@@ -500,8 +537,14 @@ mp4tag_write_file_tag (const ET_File *ETFile,
     }
 
     tag->setProperties (fields);
+
+    /* TagLib rewrites the ilst atom in place, using an adjacent free atom as
+     * padding when the new tag fits, so that mdat is only moved (and the
+     * chunk offsets updated) when the tag grows beyond the padding. */
     success = mp4file.save () ? TRUE : FALSE;
 
+    g_free (filename_utf8);
+
     return success;
 }
 
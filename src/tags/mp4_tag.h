@@ -25,7 +25,7 @@
 
 G_BEGIN_DECLS
 
-gboolean mp4tag_read_file_tag (GFile *file, File_Tag *FileTag, GError **error);
+gboolean mp4tag_read_file_tag (GFile *file, File_Tag *FileTag, ET_File_Info *ETFileInfo, GError **error);
 gboolean mp4tag_write_file_tag (const ET_File *ETFile, GError **error);
 
 G_END_DECLS
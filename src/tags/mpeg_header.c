@@ -19,18 +19,14 @@
 
 #include "config.h"
 
-#if defined ENABLE_MP3 && defined ENABLE_ID3LIB
+#ifdef ENABLE_MP3
 
 #include <glib/gi18n.h>
-#include <errno.h>
 
-#include "id3_tag.h"
 #include "mpeg_header.h"
+#include "mpeg_probe.h"
 #include "misc.h"
 
-#include <id3.h>
-#include "id3lib/id3_bugfix.h"
-
 
 
 /****************
@@ -63,30 +59,30 @@ channel_mode_name (int mode)
 }
 
 /*
- * Read infos into header of first frame
+ * et_mpeg_header_read_file_info:
+ * @file: the file to read
+ * @audio_offset: the size of the ID3v2 tag, as found by
+ *                et_id3tag_read_file(), or -1 if it is unknown
+ * @ETFileInfo: the file information to fill
+ * @error: a #GError to provide information on errors, or %NULL to ignore
+ *
+ * Read the properties of the audio stream, from the first frames and the
+ * Xing, Info or VBRI header if there is one.
+ *
+ * Returns: %TRUE on success, %FALSE and with @error set otherwise
  */
 gboolean
 et_mpeg_header_read_file_info (GFile *file,
+                               goffset audio_offset,
                                ET_File_Info *ETFileInfo,
                                GError **error)
 {
     GFileInfo *info;
-    gchar *filename;
-    /*
-     * With id3lib, the header frame couldn't be read if the file contains an ID3v2 tag with an APIC frame
-     */
-    ID3Tag *id3_tag = NULL;    /* Tag defined by the id3lib */
-    const Mp3_Headerinfo* headerInfo = NULL;
+    EtMpegAudioInfo audio;
 
     g_return_val_if_fail (file != NULL || ETFileInfo != NULL, FALSE);
     g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-    /* Check if the file is corrupt. */
-    if (!et_id3tag_check_if_file_is_valid (file, error))
-    {
-        return FALSE;
-    }
-
     /* Get size of file */
     info = g_file_query_info (file, G_FILE_ATTRIBUTE_STANDARD_SIZE,
                               G_FILE_QUERY_INFO_NONE, NULL, error);
@@ -99,121 +95,19 @@ et_mpeg_header_read_file_info (GFile *file,
     ETFileInfo->size = g_file_info_get_size (info);
     g_object_unref (info);
 
-    /* Get data from tag */
-    if ((id3_tag = ID3Tag_New()) == NULL)
+    if (!et_mpeg_probe_read_info (file, audio_offset, &audio, error))
     {
-        g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_NOMEM, "%s",
-                     g_strerror (ENOMEM));
-        g_object_unref (info);
         return FALSE;
     }
 
-    /* Link the file to the tag (uses ID3TT_ID3V2 to get header if APIC is present in Tag) */
-    filename = g_file_get_path (file);
-#ifdef G_OS_WIN32
-    /* On Windows, id3lib expects filenames to be in the system codepage. */
-    {
-        gchar *locale_filename;
-
-        locale_filename = g_win32_locale_filename_from_utf8 (filename);
-
-        if (!locale_filename)
-        {
-            g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "%s",
-                         g_strerror (EINVAL));
-            g_free (filename);
-            return FALSE;
-        }
-
-        ID3Tag_LinkWithFlags (id3_tag, locale_filename, ID3TT_ID3V2);
-
-        g_free (locale_filename);
-    }
-#else
-    ID3Tag_LinkWithFlags (id3_tag, filename, ID3TT_ID3V2);
-#endif
-
-    g_free (filename);
-
-    if ( (headerInfo = ID3Tag_GetMp3HeaderInfo(id3_tag)) )
-    {
-        switch (headerInfo->version)
-        {
-            case MPEGVERSION_1:
-                ETFileInfo->version = 1;
-                ETFileInfo->mpeg25 = FALSE;
-                break;
-            case MPEGVERSION_2:
-                ETFileInfo->version = 2;
-                ETFileInfo->mpeg25 = FALSE;
-                break;
-            case MPEGVERSION_2_5:
-                ETFileInfo->version = 2;
-                ETFileInfo->mpeg25 = TRUE;
-                break;
-            case MPEGVERSION_FALSE:
-            case MPEGVERSION_Reserved:
-            default:
-                break;
-        }
-
-        switch (headerInfo->layer)
-        {
-            case MPEGLAYER_I:
-                ETFileInfo->layer = 1;
-                break;
-            case MPEGLAYER_II:
-                ETFileInfo->layer = 2;
-                break;
-            case MPEGLAYER_III:
-                ETFileInfo->layer = 3;
-                break;
-            case MPEGLAYER_FALSE:
-            case MPEGLAYER_UNDEFINED:
-            default:
-                break;
-        }
-
-        // Samplerate
-        ETFileInfo->samplerate = headerInfo->frequency;
-
-        // Mode -> Seems to be detected but incorrect?!
-        switch (headerInfo->modeext)
-        {
-            case MP3CHANNELMODE_STEREO:
-                ETFileInfo->mode = 0;
-                break;
-            case MP3CHANNELMODE_JOINT_STEREO:
-                ETFileInfo->mode = 1;
-                break;
-            case MP3CHANNELMODE_DUAL_CHANNEL:
-                ETFileInfo->mode = 2;
-                break;
-            case MP3CHANNELMODE_SINGLE_CHANNEL:
-                ETFileInfo->mode = 3;
-                break;
-            case MP3CHANNELMODE_FALSE:
-            default:
-                break;
-        }
-
-        // Bitrate
-        if (headerInfo->vbr_bitrate <= 0)
-        {
-            ETFileInfo->variable_bitrate = FALSE;
-            ETFileInfo->bitrate = headerInfo->bitrate/1000;
-        }else
-        {
-            ETFileInfo->variable_bitrate = TRUE;
-            ETFileInfo->bitrate = headerInfo->vbr_bitrate/1000;
-        }
-
-        // Duration
-        ETFileInfo->duration = headerInfo->time;
-    }
-
-    /* Free allocated data */
-    ID3Tag_Delete(id3_tag);
+    ETFileInfo->version = audio.version;
+    ETFileInfo->mpeg25 = audio.mpeg25;
+    ETFileInfo->layer = audio.layer;
+    ETFileInfo->bitrate = audio.bitrate;
+    ETFileInfo->variable_bitrate = audio.variable_bitrate;
+    ETFileInfo->samplerate = audio.samplerate;
+    ETFileInfo->mode = audio.mode;
+    ETFileInfo->duration = audio.duration;
 
     return TRUE;
 }
@@ -312,4 +206,4 @@ et_mpeg_file_header_fields_free (EtFileHeaderFields *fields)
     g_slice_free (EtFileHeaderFields, fields);
 }
 
-#endif /* defined ENABLE_MP3 && defined ENABLE_ID3LIB */
+#endif /* ENABLE_MP3 */
@@ -0,0 +1,998 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include "mpeg_probe.h"
+
+#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Number of bytes read at the start and at the end of the file. */
+#define MPEG_PROBE_SIZE 8192
+
+/* Size of an ID3v1 tag, at the end of the file. */
+#define MPEG_PROBE_ID3V1_SIZE 128
+
+/* Size of an ID3v2 tag header or footer. */
+#define MPEG_PROBE_ID3V2_HEADER_SIZE 10
+
+/* Size of an APE tag header or footer. */
+#define MPEG_PROBE_APE_FOOTER_SIZE 32
+
+/* Number of bytes scanned at the start of the audio data, to find the first
+ * frame and to estimate the bitrate of streams without a VBR header. */
+#define MPEG_INFO_SCAN_SIZE 65536
+
+/* Number of bytes of the audio data read at a time, enough for the longest
+ * frame and the header of the next one. */
+#define MPEG_INFO_WINDOW_SIZE 8192
+
+/* Maximum number of frames used to estimate the bitrate. */
+#define MPEG_INFO_MAX_FRAMES 100
+
+/* Offset of the LAME tag from the start of a Xing or Info header. */
+#define MPEG_INFO_LAME_OFFSET 120
+
+/* Offset of the VBRI header from the start of the frame. */
+#define MPEG_INFO_VBRI_OFFSET 36
+
+/*
+ * MpegFrame:
+ * @version_index: version bits of the header: 3 for MPEG 1, 2 for MPEG 2 and
+ *                 0 for MPEG 2.5
+ * @layer: layer, from 1 to 3
+ * @bitrate: bitrate of the frame, in kb/s
+ * @samplerate: sampling rate, in Hz
+ * @mode: channel mode bits of the header
+ * @samples: number of samples per channel in the frame
+ * @length: length of the frame in bytes, including the header
+ *
+ * A decoded MPEG audio frame header.
+ */
+typedef struct
+{
+    gint version_index;
+    gint layer;
+    gint bitrate;
+    gint samplerate;
+    gint mode;
+    gint samples;
+    gsize length;
+} MpegFrame;
+
+/*
+ * MpegWindow:
+ * @istream: the stream of the file
+ * @start: the offset in the file of the first byte of @data
+ * @end: the offset of the end of the audio data
+ * @length: the number of bytes in @data
+ * @data: the audio data from @start
+ *
+ * A window on the audio data, which slides along the stream while it is
+ * scanned, so that no buffer needs to be allocated for the scanned bytes.
+ */
+typedef struct
+{
+    GFileInputStream *istream;
+    goffset start;
+    goffset end;
+    gsize length;
+    guchar data[MPEG_INFO_WINDOW_SIZE];
+} MpegWindow;
+
+/* Bitrates in kb/s, indexed by MPEG 2 or 2.5, the layer and the bitrate index
+ * of the header. */
+static const guint16 mpeg_bitrates[2][3][15] =
+{
+    {
+        { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416,
+          448 },
+        { 0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384 },
+        { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 }
+    },
+    {
+        { 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256 },
+        { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 },
+        { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 }
+    }
+};
+
+/* Sampling rates of MPEG 1 streams, halved for MPEG 2 and quartered for
+ * MPEG 2.5. */
+static const gint mpeg_samplerates[3] = { 44100, 48000, 32000 };
+
+/*
+ * is_frame_header:
+ * @data: at least 3 bytes
+ *
+ * Check for an MPEG audio frame sync word, followed by a version, layer,
+ * bitrate and sampling rate which are not reserved values.
+ *
+ * Returns: %TRUE if @data could be the start of an MPEG audio frame
+ */
+static gboolean
+is_frame_header (const guchar *data)
+{
+    return data[0] == 0xFF
+           && (data[1] & 0xE0) == 0xE0
+           && (data[1] & 0x18) != 0x08
+           && (data[1] & 0x06) != 0x00
+           && (data[2] & 0xF0) != 0xF0
+           && (data[2] & 0x0C) != 0x0C;
+}
+
+static gboolean
+find_frame_header (const guchar *data,
+                   gsize length)
+{
+    const guchar *p = data;
+    const guchar *end = data + length;
+
+    while (end - p >= 3
+           && (p = memchr (p, 0xFF, end - p - 2)) != NULL)
+    {
+        if (is_frame_header (p))
+        {
+            return TRUE;
+        }
+
+        p++;
+    }
+
+    return FALSE;
+}
+
+static gboolean
+find_bytes (const guchar *data,
+            gsize length,
+            const gchar *needle)
+{
+    const gsize needle_length = strlen (needle);
+    gsize i;
+
+    for (i = 0; i + needle_length <= length; i++)
+    {
+        if (data[i] == (guchar)needle[0]
+            && memcmp (data + i, needle, needle_length) == 0)
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/*
+ * has_trailing_tag:
+ * @data: the last bytes of a file
+ * @length: the number of bytes in @data
+ *
+ * Returns: %TRUE if the file ends with an ID3v1 tag, or contains an APE tag
+ *          footer in @data
+ */
+static gboolean
+has_trailing_tag (const guchar *data,
+                  gsize length)
+{
+    return (length >= MPEG_PROBE_ID3V1_SIZE
+            && memcmp (data + length - MPEG_PROBE_ID3V1_SIZE, "TAG", 3) == 0)
+           || find_bytes (data, length, "APETAGEX");
+}
+
+static gboolean
+is_all_zeroes (const guchar *data,
+               gsize length)
+{
+    return length == 0 || (data[0] == 0
+                           && memcmp (data, data + 1, length - 1) == 0);
+}
+
+/*
+ * find_data_start:
+ * @file: the file to check
+ *
+ * Find the offset of the first byte of @file which is not in a hole, for
+ * files on a filesystem which supports sparse files.
+ *
+ * Returns: the offset of the first data in @file, or -1 if the whole file
+ *          is a hole
+ */
+static goffset
+find_data_start (GFile *file)
+{
+    goffset offset = 0;
+#ifdef SEEK_DATA
+    gchar *path;
+    gint fd;
+
+    path = g_file_get_path (file);
+
+    if (!path)
+    {
+        return 0;
+    }
+
+    fd = g_open (path, O_RDONLY, 0);
+    g_free (path);
+
+    if (fd == -1)
+    {
+        return 0;
+    }
+
+    offset = lseek (fd, 0, SEEK_DATA);
+
+    if (offset == -1)
+    {
+        /* ENXIO means that there is no data after the offset. Other errors
+         * mean that holes cannot be detected. */
+        offset = errno == ENXIO ? -1 : 0;
+    }
+
+    close (fd);
+#endif /* SEEK_DATA */
+
+    return offset;
+}
+
+static gssize
+read_at (GFileInputStream *istream,
+         goffset offset,
+         guchar *buffer,
+         gsize count,
+         GError **error)
+{
+    gsize bytes_read;
+
+    if (!g_seekable_seek (G_SEEKABLE (istream), offset, G_SEEK_SET, NULL,
+                          error)
+        || !g_input_stream_read_all (G_INPUT_STREAM (istream), buffer, count,
+                                     &bytes_read, NULL, error))
+    {
+        return -1;
+    }
+
+    return bytes_read;
+}
+
+/*
+ * et_mpeg_probe_file:
+ * @file: the file to check
+ * @error: a #GError to provide information on errors, or %NULL to ignore
+ *
+ * Check that @file could be an MPEG audio file: it must start with an ID3v2
+ * tag or contain an MPEG audio frame header in the first few kilobytes, or
+ * end with an ID3v1 or APE tag or an MPEG audio frame. Only the start and
+ * the end of the file are read, and holes in sparse files are skipped. This
+ * protects id3lib against files which contain only zeroes, on which it
+ * enters an infinite loop.
+ *
+ * To generate such a file: dd if=/dev/zero bs=1M count=6 of=zero.mp3
+ *
+ * Returns: %TRUE if the file could be an MPEG audio file, %FALSE and with
+ *          @error set otherwise
+ */
+gboolean
+et_mpeg_probe_file (GFile *file,
+                    GError **error)
+{
+    GFileInputStream *istream;
+    GFileInfo *info;
+    guchar buffer[MPEG_PROBE_SIZE];
+    goffset size;
+    goffset data_start;
+    goffset tail_start;
+    gssize bytes_read;
+    gboolean valid = FALSE;
+    gboolean zeroes;
+
+    g_return_val_if_fail (file != NULL, FALSE);
+    g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+    istream = g_file_read (file, NULL, error);
+
+    if (!istream)
+    {
+        return FALSE;
+    }
+
+    info = g_file_input_stream_query_info (istream,
+                                           G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                                           NULL, error);
+
+    if (!info)
+    {
+        g_object_unref (istream);
+        return FALSE;
+    }
+
+    size = g_file_info_get_size (info);
+    g_object_unref (info);
+
+    data_start = size > 0 ? find_data_start (file) : -1;
+
+    if (data_start < 0 || data_start >= size)
+    {
+        g_object_unref (istream);
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED, "%s",
+                     _("Input truncated or empty"));
+        return FALSE;
+    }
+
+    /* Start of the file. */
+    bytes_read = read_at (istream, data_start, buffer,
+                          MIN (MPEG_PROBE_SIZE, size - data_start), error);
+
+    if (bytes_read < 0)
+    {
+        g_object_unref (istream);
+        return FALSE;
+    }
+
+    if ((data_start == 0 && bytes_read >= 3
+         && memcmp (buffer, "ID3", 3) == 0)
+        || find_frame_header (buffer, bytes_read)
+        || (data_start + bytes_read == size
+            && has_trailing_tag (buffer, bytes_read)))
+    {
+        g_object_unref (istream);
+        return TRUE;
+    }
+
+    zeroes = is_all_zeroes (buffer, bytes_read);
+
+    /* End of the file, if it was not read already. */
+    tail_start = MAX (data_start + bytes_read, size - MPEG_PROBE_SIZE);
+
+    if (tail_start < size)
+    {
+        bytes_read = read_at (istream, tail_start, buffer, size - tail_start,
+                              error);
+
+        if (bytes_read < 0)
+        {
+            g_object_unref (istream);
+            return FALSE;
+        }
+
+        if (has_trailing_tag (buffer, bytes_read)
+            || find_frame_header (buffer, bytes_read))
+        {
+            valid = TRUE;
+        }
+
+        zeroes = zeroes && is_all_zeroes (buffer, bytes_read);
+    }
+
+    g_object_unref (istream);
+
+    if (!valid)
+    {
+        if (zeroes)
+        {
+            g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED, "%s",
+                         _("Input truncated or empty"));
+        }
+        else
+        {
+            g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED, "%s",
+                         _("No MPEG audio frame or tag was found"));
+        }
+    }
+
+    return valid;
+}
+
+/*
+ * decode_frame_header:
+ * @data: at least 4 bytes
+ * @frame: the frame to fill
+ *
+ * Decode an MPEG audio frame header. Free-format frames are rejected, as
+ * their length cannot be computed from the header.
+ *
+ * Returns: %TRUE if @data is a valid frame header, %FALSE otherwise
+ */
+static gboolean
+decode_frame_header (const guchar *data,
+                     MpegFrame *frame)
+{
+    gint bitrate_index;
+    gint padding;
+    gboolean lsf;
+
+    if (!is_frame_header (data))
+    {
+        return FALSE;
+    }
+
+    bitrate_index = data[2] >> 4;
+
+    if (bitrate_index == 0)
+    {
+        return FALSE;
+    }
+
+    frame->version_index = (data[1] >> 3) & 0x03;
+    frame->layer = 4 - ((data[1] >> 1) & 0x03);
+    lsf = frame->version_index != 3;
+    frame->bitrate = mpeg_bitrates[lsf][frame->layer - 1][bitrate_index];
+    frame->samplerate = mpeg_samplerates[(data[2] >> 2) & 0x03];
+    frame->mode = data[3] >> 6;
+    padding = (data[2] >> 1) & 0x01;
+
+    if (frame->version_index == 2)
+    {
+        frame->samplerate /= 2;
+    }
+    else if (frame->version_index == 0)
+    {
+        frame->samplerate /= 4;
+    }
+
+    switch (frame->layer)
+    {
+        case 1:
+            frame->samples = 384;
+            frame->length = (12000 * frame->bitrate / frame->samplerate
+                             + padding) * 4;
+            break;
+        case 2:
+            frame->samples = 1152;
+            frame->length = 144000 * frame->bitrate / frame->samplerate
+                            + padding;
+            break;
+        case 3:
+        default:
+            frame->samples = lsf ? 576 : 1152;
+            frame->length = (lsf ? 72000 : 144000) * frame->bitrate
+                            / frame->samplerate + padding;
+            break;
+    }
+
+    return TRUE;
+}
+
+static gboolean
+is_same_stream (const MpegFrame *a,
+                const MpegFrame *b)
+{
+    return a->version_index == b->version_index
+           && a->layer == b->layer
+           && a->samplerate == b->samplerate;
+}
+
+/*
+ * window_move:
+ * @window: the window
+ * @offset: the new start of the window
+ * @error: a #GError to provide information on errors, or %NULL to ignore
+ *
+ * Move @window to @offset, keeping the bytes which were already read and
+ * filling the rest of the window up to the end of the audio data.
+ *
+ * Returns: %TRUE on success, %FALSE and with @error set otherwise
+ */
+static gboolean
+window_move (MpegWindow *window,
+             goffset offset,
+             GError **error)
+{
+    gsize kept = 0;
+    gssize bytes_read = 0;
+    goffset read_offset;
+
+    if (offset >= window->start
+        && offset < window->start + (goffset)window->length)
+    {
+        kept = window->start + window->length - offset;
+        memmove (window->data, window->data + (offset - window->start), kept);
+    }
+
+    read_offset = offset + kept;
+
+    if (read_offset < window->end && kept < sizeof (window->data))
+    {
+        bytes_read = read_at (window->istream, read_offset,
+                              window->data + kept,
+                              MIN (sizeof (window->data) - kept,
+                                   window->end - read_offset),
+                              error);
+
+        if (bytes_read < 0)
+        {
+            return FALSE;
+        }
+    }
+
+    window->start = offset;
+    window->length = kept + bytes_read;
+
+    return TRUE;
+}
+
+/*
+ * find_first_frame:
+ * @window: the window, at the start of the audio data
+ * @scan_end: the offset after which no frame is searched for
+ * @frame: the frame to fill
+ * @error: a #GError to provide information on errors, or %NULL to ignore
+ *
+ * Find the first frame header before @scan_end which is followed by a
+ * header of the same stream, or by the end of the audio data, and move
+ * @window to it.
+ *
+ * Returns: %TRUE if a frame was found, %FALSE and with @error set otherwise
+ */
+static gboolean
+find_first_frame (MpegWindow *window,
+                  goffset scan_end,
+                  MpegFrame *frame,
+                  GError **error)
+{
+    while (window->length >= 4 && window->start < scan_end)
+    {
+        const guchar *data = window->data;
+        const guchar *end = data + window->length;
+        /* Also true after a short read, at the end of the file. */
+        const gboolean at_end = window->length < sizeof (window->data);
+        const gsize limit = MIN (window->length - 3,
+                                 (gsize)(scan_end - window->start));
+        const guchar *p;
+
+        for (p = data; (p = memchr (p, 0xFF, data + limit - p)) != NULL; p++)
+        {
+            MpegFrame next;
+
+            if (!decode_frame_header (p, frame))
+            {
+                continue;
+            }
+
+            /* The next header is not in the window yet. */
+            if (frame->length + 4 > (gsize)(end - p) && !at_end)
+            {
+                break;
+            }
+
+            if (frame->length + 4 > (gsize)(end - p)
+                || (decode_frame_header (p + frame->length, &next)
+                    && is_same_stream (frame, &next)))
+            {
+                return window_move (window, window->start + (p - data),
+                                    error);
+            }
+        }
+
+        if (p == NULL && at_end)
+        {
+            break;
+        }
+
+        /* Continue from the candidate frame, or from the last bytes which
+         * could start a header. */
+        if (!window_move (window, window->start + (p ? p - data : limit),
+                          error))
+        {
+            return FALSE;
+        }
+    }
+
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED, "%s",
+                 _("No MPEG audio frame was found"));
+    return FALSE;
+}
+
+static guint32
+read_uint32_be (const guchar *data)
+{
+    return ((guint32)data[0] << 24) | ((guint32)data[1] << 16)
+           | ((guint32)data[2] << 8) | (guint32)data[3];
+}
+
+static guint32
+read_uint32_le (const guchar *data)
+{
+    return ((guint32)data[3] << 24) | ((guint32)data[2] << 16)
+           | ((guint32)data[1] << 8) | (guint32)data[0];
+}
+
+/*
+ * read_vbr_header:
+ * @data: the first frame of the stream
+ * @length: the number of bytes available in @data
+ * @frame: the decoded header of @data
+ * @info: the information to fill
+ *
+ * Read a Xing, Info or VBRI header, and the LAME tag which may follow a
+ * Xing or Info header, from the first frame of the stream. The duration
+ * computed from the number of frames takes the encoder delay and padding
+ * into account.
+ *
+ * Returns: %TRUE if a header with a frame count was found, %FALSE otherwise
+ */
+static gboolean
+read_vbr_header (const guchar *data,
+                 gsize length,
+                 const MpegFrame *frame,
+                 EtMpegAudioInfo *info)
+{
+    const gboolean lsf = frame->version_index != 3;
+    const gboolean mono = frame->mode == 3;
+    const guchar *xing;
+    guint32 frames = 0;
+    guint32 bytes = 0;
+    gint delay = 0;
+    gint padding = 0;
+    gboolean variable;
+    gint64 samples;
+    gdouble seconds;
+
+    length = MIN (length, frame->length);
+
+    if (frame->layer != 3)
+    {
+        return FALSE;
+    }
+
+    /* The Xing header follows the side information. */
+    xing = data + 4 + (lsf ? (mono ? 9 : 17) : (mono ? 17 : 32));
+
+    if (xing + 8 <= data + length
+        && (memcmp (xing, "Xing", 4) == 0 || memcmp (xing, "Info", 4) == 0))
+    {
+        const guint32 flags = read_uint32_be (xing + 4);
+        const guchar *p = xing + 8;
+        const guchar *lame = xing + MPEG_INFO_LAME_OFFSET;
+
+        variable = xing[0] == 'X';
+
+        if (flags & 0x01)
+        {
+            if (p + 4 > data + length)
+            {
+                return FALSE;
+            }
+
+            frames = read_uint32_be (p);
+            p += 4;
+        }
+
+        if ((flags & 0x02) && p + 4 <= data + length)
+        {
+            bytes = read_uint32_be (p);
+        }
+
+        /* The LAME tag starts with the name of the encoder, followed by
+         * the encoder delay and padding at offset 21, as two 12-bit
+         * values. */
+        if (lame + 24 <= data + length
+            && g_ascii_isalpha (lame[0]) && g_ascii_isalpha (lame[1])
+            && g_ascii_isalpha (lame[2]) && g_ascii_isalpha (lame[3]))
+        {
+            delay = (lame[21] << 4) | (lame[22] >> 4);
+            padding = ((lame[22] & 0x0F) << 8) | lame[23];
+        }
+    }
+    else if (data + MPEG_INFO_VBRI_OFFSET + 18 <= data + length
+             && memcmp (data + MPEG_INFO_VBRI_OFFSET, "VBRI", 4) == 0)
+    {
+        const guchar *vbri = data + MPEG_INFO_VBRI_OFFSET;
+
+        variable = TRUE;
+        bytes = read_uint32_be (vbri + 10);
+        frames = read_uint32_be (vbri + 14);
+    }
+    else
+    {
+        return FALSE;
+    }
+
+    if (frames == 0)
+    {
+        return FALSE;
+    }
+
+    samples = (gint64)frames * frame->samples;
+
+    if (samples > delay + padding)
+    {
+        samples -= delay + padding;
+    }
+
+    seconds = (gdouble)samples / frame->samplerate;
+
+    /* The header frame does not contain audio data. */
+    if (bytes == 0)
+    {
+        bytes = info->audio_size;
+    }
+
+    if (bytes > frame->length)
+    {
+        bytes -= frame->length;
+    }
+
+    info->variable_bitrate = variable;
+    info->duration = seconds;
+
+    if (variable)
+    {
+        info->bitrate = bytes * 8 / seconds / 1000 + 0.5;
+    }
+    else
+    {
+        info->bitrate = frame->bitrate;
+    }
+
+    return TRUE;
+}
+
+/*
+ * estimate_bitrate:
+ * @window: the window, at the first frame of the stream
+ * @scan_end: the offset after which no frame is read
+ * @frame: the decoded header of the first frame
+ * @info: the information to fill
+ * @error: a #GError to provide information on errors, or %NULL to ignore
+ *
+ * Estimate the bitrate and the duration of a stream without a VBR header,
+ * from the first frames of the stream.
+ *
+ * Returns: %TRUE on success, %FALSE and with @error set otherwise
+ */
+static gboolean
+estimate_bitrate (MpegWindow *window,
+                  goffset scan_end,
+                  const MpegFrame *frame,
+                  EtMpegAudioInfo *info,
+                  GError **error)
+{
+    MpegFrame next;
+    goffset offset = window->start;
+    guint64 total = 0;
+    guint n_frames = 0;
+    gboolean variable = FALSE;
+
+    while (n_frames < MPEG_INFO_MAX_FRAMES && offset + 4 <= scan_end)
+    {
+        if (offset + 4 > window->start + (goffset)window->length)
+        {
+            if (!window_move (window, offset, error))
+            {
+                return FALSE;
+            }
+
+            if (window->length < 4)
+            {
+                break;
+            }
+        }
+
+        if (!decode_frame_header (window->data + (offset - window->start),
+                                  &next)
+            || !is_same_stream (frame, &next))
+        {
+            break;
+        }
+
+        if (next.bitrate != frame->bitrate)
+        {
+            variable = TRUE;
+        }
+
+        total += next.bitrate;
+        n_frames++;
+        offset += next.length;
+    }
+
+    info->variable_bitrate = variable;
+    info->bitrate = n_frames > 1 ? (total + n_frames / 2) / n_frames
+                                 : frame->bitrate;
+    info->duration = info->audio_size * 8 / ((gint64)info->bitrate * 1000);
+
+    return TRUE;
+}
+
+/*
+ * find_audio_end:
+ * @data: the last bytes of the file
+ * @length: the number of bytes in @data
+ *
+ * Returns: the number of bytes at the end of the file which are used by an
+ *          ID3v1 tag and an APE tag
+ */
+static gsize
+find_audio_end (const guchar *data,
+                gsize length)
+{
+    gsize tags = 0;
+
+    if (length >= MPEG_PROBE_ID3V1_SIZE
+        && memcmp (data + length - MPEG_PROBE_ID3V1_SIZE, "TAG", 3) == 0)
+    {
+        tags += MPEG_PROBE_ID3V1_SIZE;
+    }
+
+    if (length >= tags + MPEG_PROBE_APE_FOOTER_SIZE)
+    {
+        const guchar *footer = data + length - tags
+                               - MPEG_PROBE_APE_FOOTER_SIZE;
+
+        if (memcmp (footer, "APETAGEX", 8) == 0)
+        {
+            /* The size includes the footer, but not the header. */
+            tags += read_uint32_le (footer + 12);
+
+            if (read_uint32_le (footer + 20) & 0x80000000)
+            {
+                tags += MPEG_PROBE_APE_FOOTER_SIZE;
+            }
+        }
+    }
+
+    return tags;
+}
+
+/*
+ * et_mpeg_probe_read_info:
+ * @file: the file to read
+ * @audio_offset: the offset of the end of the ID3v2 tag, if it is already
+ *                known, or -1
+ * @info: the information to fill
+ * @error: a #GError to provide information on errors, or %NULL to ignore
+ *
+ * Read the properties of the audio stream of an MPEG audio file. Leading
+ * ID3v2 tags are skipped using the size in their headers, starting from
+ * @audio_offset if a tag reader already found it, and only the first
+ * frames of the stream are read. If the first frame contains a Xing, Info or
+ * VBRI header, the duration is computed from the number of frames, otherwise
+ * it is estimated from the bitrate of the first frames.
+ *
+ * Returns: %TRUE on success, %FALSE and with @error set otherwise
+ */
+gboolean
+et_mpeg_probe_read_info (GFile *file,
+                         goffset audio_offset,
+                         EtMpegAudioInfo *info,
+                         GError **error)
+{
+    GFileInputStream *istream;
+    GFileInfo *file_info;
+    guchar header[MPEG_PROBE_ID3V1_SIZE + MPEG_PROBE_APE_FOOTER_SIZE];
+    MpegWindow window;
+    goffset size;
+    goffset offset;
+    goffset audio_end;
+    goffset scan_end;
+    gssize bytes_read;
+    MpegFrame frame;
+
+    g_return_val_if_fail (file != NULL && info != NULL, FALSE);
+    g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+    memset (info, 0, sizeof (*info));
+
+    istream = g_file_read (file, NULL, error);
+
+    if (!istream)
+    {
+        return FALSE;
+    }
+
+    file_info = g_file_input_stream_query_info (istream,
+                                                G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                                                NULL, error);
+
+    if (!file_info)
+    {
+        g_object_unref (istream);
+        return FALSE;
+    }
+
+    size = g_file_info_get_size (file_info);
+    g_object_unref (file_info);
+
+    /* Skip the ID3v2 tags, of which there may be several. */
+    offset = MAX (audio_offset, 0);
+
+    for (;;)
+    {
+        bytes_read = read_at (istream, offset, header,
+                              MPEG_PROBE_ID3V2_HEADER_SIZE, error);
+
+        if (bytes_read < 0)
+        {
+            g_object_unref (istream);
+            return FALSE;
+        }
+
+        if (bytes_read < MPEG_PROBE_ID3V2_HEADER_SIZE
+            || memcmp (header, "ID3", 3) != 0
+            || ((header[6] | header[7] | header[8] | header[9]) & 0x80))
+        {
+            break;
+        }
+
+        offset += MPEG_PROBE_ID3V2_HEADER_SIZE
+                  + ((header[6] << 21) | (header[7] << 14) | (header[8] << 7)
+                     | header[9]);
+
+        /* Footer present. */
+        if (header[5] & 0x10)
+        {
+            offset += MPEG_PROBE_ID3V2_HEADER_SIZE;
+        }
+    }
+
+    /* Trailing ID3v1 and APE tags. */
+    audio_end = size;
+
+    if (size - offset > 0)
+    {
+        const gsize tail_size = MIN (sizeof (header), size - offset);
+
+        bytes_read = read_at (istream, size - tail_size, header, tail_size,
+                              error);
+
+        if (bytes_read < 0)
+        {
+            g_object_unref (istream);
+            return FALSE;
+        }
+
+        audio_end -= MIN (find_audio_end (header, bytes_read), size - offset);
+    }
+
+    window.istream = istream;
+    window.start = offset;
+    window.end = audio_end;
+    window.length = 0;
+    scan_end = offset + MPEG_INFO_SCAN_SIZE;
+
+    if (!window_move (&window, offset, error)
+        || !find_first_frame (&window, scan_end, &frame, error))
+    {
+        g_object_unref (istream);
+        return FALSE;
+    }
+
+    info->version = frame.version_index == 3 ? 1 : 2;
+    info->mpeg25 = frame.version_index == 0;
+    info->layer = frame.layer;
+    info->samplerate = frame.samplerate;
+    info->mode = frame.mode;
+    info->audio_offset = window.start;
+    info->audio_size = audio_end - info->audio_offset;
+
+    if (!read_vbr_header (window.data, window.length, &frame, info)
+        && !estimate_bitrate (&window, scan_end, &frame, info, error))
+    {
+        g_object_unref (istream);
+        return FALSE;
+    }
+
+    g_object_unref (istream);
+
+    return TRUE;
+}
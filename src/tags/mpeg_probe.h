@@ -0,0 +1,61 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ET_MPEG_PROBE_H_
+#define ET_MPEG_PROBE_H_
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/*
+ * EtMpegAudioInfo:
+ * @version: MPEG version, 1 or 2 (also 2 for MPEG 2.5)
+ * @mpeg25: whether the stream is MPEG 2.5
+ * @layer: layer, from 1 to 3
+ * @bitrate: bitrate, or average bitrate for VBR streams, in kb/s
+ * @variable_bitrate: whether the bitrate of the stream is variable
+ * @samplerate: sampling rate, in Hz
+ * @mode: channel mode: 0 for stereo, 1 for joint stereo, 2 for dual channel
+ *        and 3 for single channel
+ * @duration: duration of the stream, in seconds
+ * @audio_offset: offset of the first audio frame in the file
+ * @audio_size: size of the audio data, excluding tags
+ *
+ * Information about the audio stream in an MPEG audio file.
+ */
+typedef struct
+{
+    gint version;
+    gboolean mpeg25;
+    gint layer;
+    gint bitrate;
+    gboolean variable_bitrate;
+    gint samplerate;
+    gint mode;
+    gint duration;
+    goffset audio_offset;
+    goffset audio_size;
+} EtMpegAudioInfo;
+
+gboolean et_mpeg_probe_file (GFile *file, GError **error);
+gboolean et_mpeg_probe_read_info (GFile *file, goffset audio_offset, EtMpegAudioInfo *info, GError **error);
+
+G_END_DECLS
+
+#endif /* ET_MPEG_PROBE_H_ */
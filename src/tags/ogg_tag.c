@@ -876,7 +876,7 @@ ogg_tag_write_file_tag (const ET_File *ETFile,
                         GError **error)
 {
     const File_Tag *FileTag;
-    const gchar *filename;
+    gchar *filename;
     GFile           *file;
     EtOggState *state;
     vorbis_comment *vc;
@@ -887,9 +887,10 @@ ogg_tag_write_file_tag (const ET_File *ETFile,
     g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
     FileTag       = (File_Tag *)ETFile->FileTag->data;
-    filename      = ((File_Name *)ETFile->FileNameCur->data)->value;
+    filename      = et_file_name_get_path ((File_Name *)ETFile->FileNameCur->data);
 
     file = g_file_new_for_path (filename);
+    g_free (filename);
 
     state = vcedit_new_state();    // Allocate memory for 'state'
 
@@ -912,26 +913,26 @@ ogg_tag_write_file_tag (const ET_File *ETFile,
      * Title *
      *********/
     et_ogg_set_tag (vc, ET_VORBIS_COMMENT_FIELD_TITLE, FileTag->title,
-                    g_settings_get_boolean (MainSettings, "ogg-split-title"));
+                    et_settings_get_snapshot ()->ogg_split_title);
 
     /**********
      * Artist *
      **********/
     et_ogg_set_tag (vc, ET_VORBIS_COMMENT_FIELD_ARTIST, FileTag->artist,
-                    g_settings_get_boolean (MainSettings, "ogg-split-artist"));
+                    et_settings_get_snapshot ()->ogg_split_artist);
 
     /****************
      * Album Artist *
      ****************/
     et_ogg_set_tag (vc, ET_VORBIS_COMMENT_FIELD_ALBUM_ARTIST,
                     FileTag->album_artist,
-                    g_settings_get_boolean (MainSettings, "ogg-split-artist"));
+                    et_settings_get_snapshot ()->ogg_split_artist);
 
     /*********
      * Album *
      *********/
     et_ogg_set_tag (vc, ET_VORBIS_COMMENT_FIELD_ALBUM, FileTag->album,
-                    g_settings_get_boolean (MainSettings, "ogg-split-album"));
+                    et_settings_get_snapshot ()->ogg_split_album);
 
     /***************
      * Disc Number *
@@ -958,30 +959,27 @@ ogg_tag_write_file_tag (const ET_File *ETFile,
      * Genre *
      *********/
     et_ogg_set_tag (vc, ET_VORBIS_COMMENT_FIELD_GENRE, FileTag->genre,
-                    g_settings_get_boolean (MainSettings, "ogg-split-genre"));
+                    et_settings_get_snapshot ()->ogg_split_genre);
 
     /***********
      * Comment *
      ***********/
     /* Format of new specification. */
     et_ogg_set_tag (vc, ET_VORBIS_COMMENT_FIELD_DESCRIPTION, FileTag->comment,
-                    g_settings_get_boolean (MainSettings,
-                                            "ogg-split-comment"));
+                    et_settings_get_snapshot ()->ogg_split_comment);
 
     /************
      * Composer *
      ************/
     et_ogg_set_tag (vc, ET_VORBIS_COMMENT_FIELD_COMPOSER, FileTag->composer,
-                    g_settings_get_boolean (MainSettings,
-                                            "ogg-split-composer"));
+                    et_settings_get_snapshot ()->ogg_split_composer);
 
     /*******************
      * Original artist *
      *******************/
     et_ogg_set_tag (vc, ET_VORBIS_COMMENT_FIELD_PERFORMER,
                     FileTag->orig_artist,
-                    g_settings_get_boolean (MainSettings,
-                                            "ogg-split-original-artist"));
+                    et_settings_get_snapshot ()->ogg_split_original_artist);
 
     /*************
      * Copyright *
@@ -1038,6 +1036,7 @@ ogg_tag_write_file_tag (const ET_File *ETFile,
                 GdkPixbuf *pixbuf;
                 gchar *buffer;
                 gsize buffer_size;
+                GBytes *png_bytes;
 
                 if (!gdk_pixbuf_loader_close (loader, &loader_error))
                 {
@@ -1073,8 +1072,9 @@ ogg_tag_write_file_tag (const ET_File *ETFile,
 
                 g_object_unref (pixbuf);
 
-                g_bytes_unref (pic->bytes);
-                pic->bytes = g_bytes_new_take (buffer, buffer_size);
+                png_bytes = g_bytes_new_take (buffer, buffer_size);
+                et_picture_set_bytes (pic, png_bytes);
+                g_bytes_unref (png_bytes);
 
                 /* Set the picture format to reflect the new data. */
                 format = Picture_Format_From_Data (pic);
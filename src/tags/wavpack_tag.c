@@ -350,7 +350,7 @@ wavpack_tag_write_file_tag (const ET_File *ETFile,
                                    wavpack_can_seek, wavpack_write_bytes };
     GFile *file;
     EtWavpackWriteState state;
-    const gchar *filename;
+    gchar *filename;
     const File_Tag *FileTag;
     WavpackContext *wpc;
     gchar message[80];
@@ -359,10 +359,11 @@ wavpack_tag_write_file_tag (const ET_File *ETFile,
     g_return_val_if_fail (ETFile != NULL && ETFile->FileTag != NULL, FALSE);
     g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-    filename = ((File_Name *)((GList *)ETFile->FileNameCur)->data)->value;
+    filename = et_file_name_get_path ((File_Name *)((GList *)ETFile->FileNameCur)->data);
     FileTag = (File_Tag *)ETFile->FileTag->data;
 
     file = g_file_new_for_path (filename);
+    g_free (filename);
     state.error = NULL;
     state.iostream = g_file_open_readwrite (file, NULL, &state.error);
     g_object_unref (file);
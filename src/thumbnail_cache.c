@@ -0,0 +1,556 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include "thumbnail_cache.h"
+
+#include <glib/gi18n.h>
+
+/* The image data given to a loader at a time, while only reading the size of
+ * the image. */
+#define PROBE_CHUNK_SIZE 4096
+
+/*
+ * EtThumbnailKey:
+ * @bytes: the image data, shared by the pictures with the same contents
+ * @hash: the hash of @bytes
+ * @size: the size of the thumbnail, in pixels
+ *
+ * The image data and size of a thumbnail. The keys in the cache hold a
+ * reference to @bytes.
+ */
+typedef struct
+{
+    GBytes *bytes;
+    guint hash;
+    gint size;
+} EtThumbnailKey;
+
+/*
+ * EtThumbnailEntry:
+ * @key: the key of the thumbnail in the cache
+ * @link: the link of the entry in the least recently used queue
+ * @thumbnail: the thumbnail
+ * @width: the width of the original image
+ * @height: the height of the original image
+ * @memory: the size of the pixel data of @thumbnail, in bytes
+ */
+typedef struct
+{
+    EtThumbnailKey key;
+    GList link;
+    GdkPixbuf *thumbnail;
+    gint width;
+    gint height;
+    gsize memory;
+} EtThumbnailEntry;
+
+/*
+ * EtThumbnailCache:
+ * @entries: the #EtThumbnailEntry of each thumbnail, by #EtThumbnailKey
+ * @lru: the entries, from the least to the most recently used
+ * @memory: the size of the pixel data of all the thumbnails, in bytes
+ * @max_memory: the maximum of @memory
+ *
+ * Thumbnails of pictures, kept until the least recently used ones must make
+ * room for new ones.
+ */
+struct _EtThumbnailCache
+{
+    GHashTable *entries;
+    GQueue lru;
+    gsize memory;
+    gsize max_memory;
+};
+
+static guint
+thumbnail_key_hash (gconstpointer key)
+{
+    const EtThumbnailKey *thumbnail_key = key;
+
+    return thumbnail_key->hash ^ ((guint)thumbnail_key->size << 16);
+}
+
+static gboolean
+thumbnail_key_equal (gconstpointer a,
+                     gconstpointer b)
+{
+    const EtThumbnailKey *key_a = a;
+    const EtThumbnailKey *key_b = b;
+
+    if (key_a->size != key_b->size)
+    {
+        return FALSE;
+    }
+
+    /* The image data of pictures is shared, so the contents only need to be
+     * compared if the data was not shared, such as after a conversion. */
+    return key_a->bytes == key_b->bytes
+           || (key_a->hash == key_b->hash
+               && g_bytes_equal (key_a->bytes, key_b->bytes));
+}
+
+/* The key borrows the image data of @pic, until it is inserted. */
+static void
+thumbnail_key_init (EtThumbnailKey *key,
+                    const EtPicture *pic,
+                    gint size)
+{
+    key->bytes = pic->bytes;
+    key->hash = et_picture_get_hash (pic);
+    key->size = size;
+}
+
+static void
+thumbnail_entry_free (EtThumbnailEntry *entry)
+{
+    g_bytes_unref (entry->key.bytes);
+    g_object_unref (entry->thumbnail);
+    g_slice_free (EtThumbnailEntry, entry);
+}
+
+static void
+thumbnail_cache_remove (EtThumbnailCache *cache,
+                        EtThumbnailEntry *entry)
+{
+    g_queue_unlink (&cache->lru, &entry->link);
+    cache->memory -= entry->memory;
+
+    /* Frees the entry. */
+    g_hash_table_remove (cache->entries, &entry->key);
+}
+
+static void
+thumbnail_cache_insert (EtThumbnailCache *cache,
+                        const EtThumbnailKey *key,
+                        GdkPixbuf *thumbnail,
+                        gint width,
+                        gint height)
+{
+    EtThumbnailEntry *entry;
+    gsize memory;
+
+    entry = g_hash_table_lookup (cache->entries, key);
+
+    if (entry)
+    {
+        thumbnail_cache_remove (cache, entry);
+    }
+
+    memory = (gsize)gdk_pixbuf_get_rowstride (thumbnail)
+             * gdk_pixbuf_get_height (thumbnail);
+
+    if (memory > cache->max_memory)
+    {
+        return;
+    }
+
+    while (cache->memory + memory > cache->max_memory)
+    {
+        thumbnail_cache_remove (cache, cache->lru.head->data);
+    }
+
+    entry = g_slice_new (EtThumbnailEntry);
+    entry->key = *key;
+    g_bytes_ref (entry->key.bytes);
+    entry->link.data = entry;
+    entry->link.prev = entry->link.next = NULL;
+    entry->thumbnail = g_object_ref (thumbnail);
+    entry->width = width;
+    entry->height = height;
+    entry->memory = memory;
+
+    g_hash_table_insert (cache->entries, &entry->key, entry);
+    g_queue_push_tail_link (&cache->lru, &entry->link);
+    cache->memory += memory;
+}
+
+/*
+ * Get the size of the thumbnail of an image of @width by @height, which
+ * keeps the aspect ratio of the image and fits in a square of @size.
+ */
+static void
+thumbnail_get_scaled_size (gint width,
+                           gint height,
+                           gint size,
+                           gint *scaled_width,
+                           gint *scaled_height)
+{
+    if (width > height)
+    {
+        *scaled_width = size;
+        *scaled_height = size * height / width;
+    }
+    else
+    {
+        *scaled_width = size * width / height;
+        *scaled_height = size;
+    }
+
+    *scaled_width = MAX (*scaled_width, 1);
+    *scaled_height = MAX (*scaled_height, 1);
+}
+
+/*
+ * et_thumbnail_cache_new:
+ * @max_size: the maximum size of the pixel data of the cached thumbnails, in
+ * bytes
+ *
+ * Create a new cache of thumbnails. The cache must be used from the thread
+ * which created it.
+ *
+ * Returns: a new cache, free with et_thumbnail_cache_free()
+ */
+EtThumbnailCache *
+et_thumbnail_cache_new (gsize max_size)
+{
+    EtThumbnailCache *cache;
+
+    cache = g_slice_new (EtThumbnailCache);
+    cache->entries = g_hash_table_new_full (thumbnail_key_hash,
+                                            thumbnail_key_equal, NULL,
+                                            (GDestroyNotify)thumbnail_entry_free);
+    g_queue_init (&cache->lru);
+    cache->memory = 0;
+    cache->max_memory = max_size;
+
+    return cache;
+}
+
+/*
+ * et_thumbnail_cache_free:
+ * @cache: the cache to free
+ *
+ * Free @cache and its thumbnails.
+ */
+void
+et_thumbnail_cache_free (EtThumbnailCache *cache)
+{
+    g_return_if_fail (cache != NULL);
+
+    /* The links of the queue are part of the entries. */
+    g_hash_table_destroy (cache->entries);
+    g_slice_free (EtThumbnailCache, cache);
+}
+
+/*
+ * et_thumbnail_cache_lookup:
+ * @cache: the cache
+ * @pic: the picture to look up
+ * @size: the size of the thumbnail, in pixels
+ * @width: (out): the width of the original image
+ * @height: (out): the height of the original image
+ *
+ * Get the cached thumbnail of the image data of @pic, which fits in a square
+ * of @size, without loading it.
+ *
+ * Returns: (transfer full): the thumbnail, or %NULL if it is not cached
+ */
+GdkPixbuf *
+et_thumbnail_cache_lookup (EtThumbnailCache *cache,
+                           const EtPicture *pic,
+                           gint size,
+                           gint *width,
+                           gint *height)
+{
+    EtThumbnailKey key;
+    EtThumbnailEntry *entry;
+
+    g_return_val_if_fail (cache != NULL, NULL);
+    g_return_val_if_fail (pic != NULL, NULL);
+
+    thumbnail_key_init (&key, pic, size);
+    entry = g_hash_table_lookup (cache->entries, &key);
+
+    if (entry == NULL)
+    {
+        return NULL;
+    }
+
+    g_queue_unlink (&cache->lru, &entry->link);
+    g_queue_push_tail_link (&cache->lru, &entry->link);
+
+    *width = entry->width;
+    *height = entry->height;
+
+    return g_object_ref (entry->thumbnail);
+}
+
+/*
+ * LoadData:
+ * @key: the key of the thumbnail in the cache, with a reference to the image
+ *       data to load
+ * @width: the width of the original image, once known
+ * @height: the height of the original image, once known
+ */
+typedef struct
+{
+    EtThumbnailKey key;
+    gint width;
+    gint height;
+} LoadData;
+
+static void
+load_data_free (LoadData *data)
+{
+    g_bytes_unref (data->key.bytes);
+    g_slice_free (LoadData, data);
+}
+
+/* Scale the image while loading, instead of loading it at full size. */
+static void
+on_load_size_prepared (GdkPixbufLoader *loader,
+                       gint width,
+                       gint height,
+                       LoadData *data)
+{
+    gint scaled_width;
+    gint scaled_height;
+
+    data->width = width;
+    data->height = height;
+
+    thumbnail_get_scaled_size (width, height, data->key.size, &scaled_width,
+                               &scaled_height);
+    gdk_pixbuf_loader_set_size (loader, scaled_width, scaled_height);
+}
+
+static void
+load_thread (GTask *task,
+             gpointer source_object,
+             gpointer task_data,
+             GCancellable *cancellable)
+{
+    LoadData *data = task_data;
+    GdkPixbufLoader *loader;
+    GdkPixbuf *pixbuf;
+    GdkPixbuf *thumbnail;
+    gint scaled_width;
+    gint scaled_height;
+    GError *error = NULL;
+
+    /* A thumbnail which is no longer needed is not loaded. */
+    if (g_cancellable_set_error_if_cancelled (cancellable, &error))
+    {
+        g_task_return_error (task, error);
+        return;
+    }
+
+    loader = gdk_pixbuf_loader_new ();
+    g_signal_connect (loader, "size-prepared",
+                      G_CALLBACK (on_load_size_prepared), data);
+
+    if (!gdk_pixbuf_loader_write_bytes (loader, data->key.bytes, &error))
+    {
+        g_object_unref (loader);
+        g_task_return_error (task, error);
+        return;
+    }
+
+    /* The part of a truncated image which was read is still shown. */
+    if (!gdk_pixbuf_loader_close (loader, &error))
+    {
+        g_debug ("Error while closing image loader: %s", error->message);
+        g_clear_error (&error);
+    }
+
+    pixbuf = gdk_pixbuf_loader_get_pixbuf (loader);
+
+    if (pixbuf == NULL)
+    {
+        g_object_unref (loader);
+        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_PARTIAL_INPUT,
+                                 "%s",
+                                 _("Not enough data has been read to determine how to create the image buffer."));
+        return;
+    }
+
+    thumbnail_get_scaled_size (data->width, data->height, data->key.size,
+                               &scaled_width, &scaled_height);
+
+    /* Not all image loaders can scale while loading. */
+    if (gdk_pixbuf_get_width (pixbuf) != scaled_width
+        || gdk_pixbuf_get_height (pixbuf) != scaled_height)
+    {
+        thumbnail = gdk_pixbuf_scale_simple (pixbuf, scaled_width,
+                                             scaled_height,
+                                             GDK_INTERP_BILINEAR);
+    }
+    else
+    {
+        thumbnail = g_object_ref (pixbuf);
+    }
+
+    g_object_unref (loader);
+    g_task_return_pointer (task, thumbnail, g_object_unref);
+}
+
+/*
+ * et_thumbnail_cache_load_async:
+ * @cache: the cache
+ * @pic: the picture to load
+ * @size: the size of the thumbnail, in pixels
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @callback: called when the thumbnail was loaded
+ * @user_data: user data for @callback
+ *
+ * Load the thumbnail of the image data of @pic, which fits in a square of
+ * @size, in a thread. Call et_thumbnail_cache_load_finish() from @callback
+ * to get the thumbnail, which is then cached. If @cancellable is cancelled
+ * after the thumbnail was loaded, it is still returned and cached.
+ */
+void
+et_thumbnail_cache_load_async (EtThumbnailCache *cache,
+                               const EtPicture *pic,
+                               gint size,
+                               GCancellable *cancellable,
+                               GAsyncReadyCallback callback,
+                               gpointer user_data)
+{
+    GTask *task;
+    LoadData *data;
+
+    g_return_if_fail (cache != NULL);
+    g_return_if_fail (pic != NULL);
+
+    task = g_task_new (NULL, cancellable, callback, user_data);
+    g_task_set_source_tag (task, et_thumbnail_cache_load_async);
+    g_task_set_check_cancellable (task, FALSE);
+
+    data = g_slice_new (LoadData);
+    thumbnail_key_init (&data->key, pic, size);
+    g_bytes_ref (data->key.bytes);
+    data->width = 0;
+    data->height = 0;
+
+    g_task_set_task_data (task, data, (GDestroyNotify)load_data_free);
+    g_task_run_in_thread (task, load_thread);
+    g_object_unref (task);
+}
+
+/*
+ * et_thumbnail_cache_load_finish:
+ * @cache: the cache
+ * @result: the result passed to the callback
+ * @error: a #GError, or %NULL
+ *
+ * Finish loading a thumbnail, and cache it.
+ *
+ * Returns: (transfer full): the thumbnail, or %NULL with @error set on
+ * failure
+ */
+GdkPixbuf *
+et_thumbnail_cache_load_finish (EtThumbnailCache *cache,
+                                GAsyncResult *result,
+                                GError **error)
+{
+    GdkPixbuf *thumbnail;
+
+    g_return_val_if_fail (cache != NULL, NULL);
+    g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
+    g_return_val_if_fail (g_task_get_source_tag (G_TASK (result))
+                          == et_thumbnail_cache_load_async, NULL);
+
+    thumbnail = g_task_propagate_pointer (G_TASK (result), error);
+
+    if (thumbnail)
+    {
+        const LoadData *data = g_task_get_task_data (G_TASK (result));
+
+        thumbnail_cache_insert (cache, &data->key, thumbnail, data->width,
+                                data->height);
+    }
+
+    return thumbnail;
+}
+
+static void
+on_probe_size_prepared (GdkPixbufLoader *loader,
+                        gint width,
+                        gint height,
+                        gint *image_size)
+{
+    image_size[0] = width;
+    image_size[1] = height;
+
+    /* Avoid allocating the image at full size. */
+    gdk_pixbuf_loader_set_size (loader, 1, 1);
+}
+
+/*
+ * et_thumbnail_get_image_size:
+ * @bytes: image data
+ * @width: (out): the width of the image
+ * @height: (out): the height of the image
+ * @error: a #GError, or %NULL
+ *
+ * Get the size of the image in @bytes, by only reading as much of the image
+ * data as needed.
+ *
+ * Returns: %TRUE on success, %FALSE with @error set otherwise
+ */
+gboolean
+et_thumbnail_get_image_size (GBytes *bytes,
+                             gint *width,
+                             gint *height,
+                             GError **error)
+{
+    GdkPixbufLoader *loader;
+    const guchar *data;
+    gsize size;
+    gsize offset;
+    gint image_size[2] = { 0, 0 };
+
+    g_return_val_if_fail (bytes != NULL, FALSE);
+    g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+    loader = gdk_pixbuf_loader_new ();
+    g_signal_connect (loader, "size-prepared",
+                      G_CALLBACK (on_probe_size_prepared), image_size);
+    data = g_bytes_get_data (bytes, &size);
+
+    for (offset = 0; offset < size && image_size[0] == 0;
+         offset += PROBE_CHUNK_SIZE)
+    {
+        /* The loader is closed on failure. */
+        if (!gdk_pixbuf_loader_write (loader, data + offset,
+                                      MIN (PROBE_CHUNK_SIZE, size - offset),
+                                      error))
+        {
+            g_object_unref (loader);
+            return FALSE;
+        }
+    }
+
+    /* The rest of the image data was not read. */
+    gdk_pixbuf_loader_close (loader, NULL);
+    g_object_unref (loader);
+
+    if (image_size[0] == 0)
+    {
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_PARTIAL_INPUT, "%s",
+                     _("Not enough data has been read to determine how to create the image buffer."));
+        return FALSE;
+    }
+
+    *width = image_size[0];
+    *height = image_size[1];
+
+    return TRUE;
+}
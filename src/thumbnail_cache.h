@@ -0,0 +1,40 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ET_THUMBNAIL_CACHE_H_
+#define ET_THUMBNAIL_CACHE_H_
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+G_BEGIN_DECLS
+
+#include "picture.h"
+
+typedef struct _EtThumbnailCache EtThumbnailCache;
+
+EtThumbnailCache * et_thumbnail_cache_new (gsize max_size);
+void et_thumbnail_cache_free (EtThumbnailCache *cache);
+GdkPixbuf * et_thumbnail_cache_lookup (EtThumbnailCache *cache, const EtPicture *pic, gint size, gint *width, gint *height);
+void et_thumbnail_cache_load_async (EtThumbnailCache *cache, const EtPicture *pic, gint size, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data);
+GdkPixbuf * et_thumbnail_cache_load_finish (EtThumbnailCache *cache, GAsyncResult *result, GError **error);
+
+gboolean et_thumbnail_get_image_size (GBytes *bytes, gint *width, gint *height, GError **error);
+
+G_END_DECLS
+
+#endif /* !ET_THUMBNAIL_CACHE_H_ */
@@ -0,0 +1,919 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include "corpus.h"
+
+#include <errno.h>
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef ENABLE_FLAC
+#include <FLAC/stream_encoder.h>
+#endif
+
+#ifdef ENABLE_OPUS
+#include <ogg/ogg.h>
+#include <opus/opus.h>
+#endif
+
+#ifdef ENABLE_WAVPACK
+#include <wavpack/wavpack.h>
+#endif
+
+/* Each generated file holds one second of stereo silence. */
+#define CORPUS_SAMPLE_RATE 44100
+#define CORPUS_CHANNELS 2
+
+static const struct
+{
+    const gchar *name;
+    const gchar *extension;
+} corpus_formats[ET_CORPUS_FORMAT_COUNT] =
+{
+    { "mp3", ".mp3" },
+    { "flac", ".flac" },
+    { "opus", ".opus" },
+    { "mp4", ".m4a" },
+    { "wavpack", ".wv" },
+    { "ape", ".ape" }
+};
+
+/*
+ * et_corpus_format_get_name:
+ * @format: the format of a corpus file
+ *
+ * Get a short name of @format, suitable for a test path.
+ *
+ * Returns: the name of @format
+ */
+const gchar *
+et_corpus_format_get_name (EtCorpusFormat format)
+{
+    g_return_val_if_fail (format < ET_CORPUS_FORMAT_COUNT, NULL);
+
+    return corpus_formats[format].name;
+}
+
+/*
+ * et_corpus_format_get_extension:
+ * @format: the format of a corpus file
+ *
+ * Get the filename extension, including the dot, with which EasyTAG
+ * recognises @format.
+ *
+ * Returns: the extension of @format
+ */
+const gchar *
+et_corpus_format_get_extension (EtCorpusFormat format)
+{
+    g_return_val_if_fail (format < ET_CORPUS_FORMAT_COUNT, NULL);
+
+    return corpus_formats[format].extension;
+}
+
+/*
+ * et_corpus_format_is_supported:
+ * @format: the format of a corpus file
+ *
+ * Check whether files of @format can be both generated and tagged by this
+ * build.
+ *
+ * Returns: %TRUE if @format is supported, %FALSE otherwise
+ */
+gboolean
+et_corpus_format_is_supported (EtCorpusFormat format)
+{
+    switch (format)
+    {
+#ifdef ENABLE_MP3
+        case ET_CORPUS_FORMAT_MP3:
+#endif
+#ifdef ENABLE_FLAC
+        case ET_CORPUS_FORMAT_FLAC:
+#endif
+#ifdef ENABLE_OPUS
+        case ET_CORPUS_FORMAT_OPUS:
+#endif
+#ifdef ENABLE_MP4
+        case ET_CORPUS_FORMAT_MP4:
+#endif
+#ifdef ENABLE_WAVPACK
+        case ET_CORPUS_FORMAT_WAVPACK:
+#endif
+        case ET_CORPUS_FORMAT_MONKEYS_AUDIO:
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+static void
+append_be16 (GByteArray *array,
+             guint16 value)
+{
+    guint8 bytes[2];
+
+    bytes[0] = (value >> 8) & 0xff;
+    bytes[1] = value & 0xff;
+    g_byte_array_append (array, bytes, sizeof (bytes));
+}
+
+static void
+append_be32 (GByteArray *array,
+             guint32 value)
+{
+    guint8 bytes[4];
+
+    bytes[0] = (value >> 24) & 0xff;
+    bytes[1] = (value >> 16) & 0xff;
+    bytes[2] = (value >> 8) & 0xff;
+    bytes[3] = value & 0xff;
+    g_byte_array_append (array, bytes, sizeof (bytes));
+}
+
+static void
+append_le16 (GByteArray *array,
+             guint16 value)
+{
+    guint8 bytes[2];
+
+    bytes[0] = value & 0xff;
+    bytes[1] = (value >> 8) & 0xff;
+    g_byte_array_append (array, bytes, sizeof (bytes));
+}
+
+static void
+append_le32 (GByteArray *array,
+             guint32 value)
+{
+    guint8 bytes[4];
+
+    bytes[0] = value & 0xff;
+    bytes[1] = (value >> 8) & 0xff;
+    bytes[2] = (value >> 16) & 0xff;
+    bytes[3] = (value >> 24) & 0xff;
+    g_byte_array_append (array, bytes, sizeof (bytes));
+}
+
+static void
+append_zeros (GByteArray *array,
+              gsize length)
+{
+    gsize offset = array->len;
+
+    g_byte_array_set_size (array, offset + length);
+    memset (array->data + offset, 0, length);
+}
+
+static void
+put_be32 (GByteArray *array,
+          gsize offset,
+          guint32 value)
+{
+    array->data[offset] = (value >> 24) & 0xff;
+    array->data[offset + 1] = (value >> 16) & 0xff;
+    array->data[offset + 2] = (value >> 8) & 0xff;
+    array->data[offset + 3] = value & 0xff;
+}
+
+static gboolean
+write_byte_array (const gchar *filename,
+                  GByteArray *array,
+                  GError **error)
+{
+    gboolean success;
+
+    success = g_file_set_contents (filename, (const gchar *)array->data,
+                                   array->len, error);
+    g_byte_array_unref (array);
+
+    return success;
+}
+
+/*
+ * An MPEG-1 layer III stream of silent frames at 128 kb/s and 44.1 kHz.
+ */
+static gboolean
+write_mp3 (const gchar *filename,
+           GError **error)
+{
+    /* Sync, MPEG-1, layer III, no CRC, 128 kb/s, 44.1 kHz, joint stereo. */
+    static const guint8 frame_header[] = { 0xff, 0xfb, 0x90, 0x44 };
+    /* 144 * bit rate / sample rate, without padding. */
+    const gsize frame_length = 144 * 128000 / CORPUS_SAMPLE_RATE;
+    const guint n_frames = CORPUS_SAMPLE_RATE / 1152 + 1;
+    GByteArray *array;
+    guint i;
+
+    array = g_byte_array_sized_new (frame_length * n_frames);
+
+    for (i = 0; i < n_frames; i++)
+    {
+        g_byte_array_append (array, frame_header, sizeof (frame_header));
+        append_zeros (array, frame_length - sizeof (frame_header));
+    }
+
+    return write_byte_array (filename, array, error);
+}
+
+#ifdef ENABLE_FLAC
+static gboolean
+write_flac (const gchar *filename,
+            GError **error)
+{
+    FLAC__StreamEncoder *encoder;
+    FLAC__int32 samples[1024 * CORPUS_CHANNELS];
+    guint remaining;
+    gboolean success = TRUE;
+
+    encoder = FLAC__stream_encoder_new ();
+
+    if (encoder == NULL)
+    {
+        g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_NOMEM, "%s",
+                     g_strerror (ENOMEM));
+        return FALSE;
+    }
+
+    FLAC__stream_encoder_set_channels (encoder, CORPUS_CHANNELS);
+    FLAC__stream_encoder_set_bits_per_sample (encoder, 16);
+    FLAC__stream_encoder_set_sample_rate (encoder, CORPUS_SAMPLE_RATE);
+    FLAC__stream_encoder_set_total_samples_estimate (encoder,
+                                                     CORPUS_SAMPLE_RATE);
+
+    if (FLAC__stream_encoder_init_file (encoder, filename, NULL, NULL)
+        != FLAC__STREAM_ENCODER_INIT_STATUS_OK)
+    {
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                     "Error initializing FLAC encoder for ‘%s’", filename);
+        FLAC__stream_encoder_delete (encoder);
+        return FALSE;
+    }
+
+    memset (samples, 0, sizeof (samples));
+
+    for (remaining = CORPUS_SAMPLE_RATE; remaining > 0 && success;)
+    {
+        const guint n = MIN (remaining, G_N_ELEMENTS (samples)
+                                        / CORPUS_CHANNELS);
+
+        success = FLAC__stream_encoder_process_interleaved (encoder, samples,
+                                                            n);
+        remaining -= n;
+    }
+
+    if (!FLAC__stream_encoder_finish (encoder))
+    {
+        success = FALSE;
+    }
+
+    FLAC__stream_encoder_delete (encoder);
+
+    if (!success)
+    {
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                     "Error encoding FLAC stream to ‘%s’", filename);
+    }
+
+    return success;
+}
+#endif /* ENABLE_FLAC */
+
+#ifdef ENABLE_OPUS
+static gboolean
+write_ogg_page (FILE *fp,
+                const ogg_page *page)
+{
+    return fwrite (page->header, 1, page->header_len, fp)
+           == (size_t)page->header_len
+           && fwrite (page->body, 1, page->body_len, fp)
+              == (size_t)page->body_len;
+}
+
+static gboolean
+flush_ogg_stream (FILE *fp,
+                  ogg_stream_state *stream)
+{
+    ogg_page page;
+
+    while (ogg_stream_flush (stream, &page) != 0)
+    {
+        if (!write_ogg_page (fp, &page))
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/*
+ * An Ogg Opus stream with an empty OpusTags header, as written by opusenc
+ * with no comments.
+ */
+static gboolean
+write_opus (const gchar *filename,
+            GError **error)
+{
+    /* 20 ms frames, at the 48 kHz rate used by all Opus streams. */
+    enum { FRAME_SIZE = 960, N_FRAMES = 50 };
+    static const gchar vendor[] = "EasyTAG corpus";
+    OpusEncoder *encoder;
+    ogg_stream_state stream;
+    ogg_packet packet;
+    ogg_page page;
+    GByteArray *header;
+    opus_int16 pcm[FRAME_SIZE * CORPUS_CHANNELS];
+    guchar data[1275];
+    opus_int32 pre_skip;
+    gint err;
+    guint i;
+    FILE *fp;
+    gboolean success = TRUE;
+
+    encoder = opus_encoder_create (48000, CORPUS_CHANNELS,
+                                   OPUS_APPLICATION_AUDIO, &err);
+
+    if (err != OPUS_OK)
+    {
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                     "Error creating Opus encoder: %s", opus_strerror (err));
+        return FALSE;
+    }
+
+    opus_encoder_ctl (encoder, OPUS_GET_LOOKAHEAD (&pre_skip));
+
+    fp = g_fopen (filename, "wb");
+
+    if (fp == NULL)
+    {
+        err = errno;
+        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (err),
+                     "Error opening ‘%s’: %s", filename, g_strerror (err));
+        opus_encoder_destroy (encoder);
+        return FALSE;
+    }
+
+    ogg_stream_init (&stream, g_str_hash (filename));
+
+    header = g_byte_array_new ();
+    g_byte_array_append (header, (const guint8 *)"OpusHead", 8);
+    g_byte_array_append (header, (const guint8 *)"\1", 1);
+    g_byte_array_append (header, (const guint8 *)"\2", 1);
+    append_le16 (header, pre_skip);
+    append_le32 (header, CORPUS_SAMPLE_RATE);
+    append_le16 (header, 0);
+    g_byte_array_append (header, (const guint8 *)"\0", 1);
+
+    memset (&packet, 0, sizeof (packet));
+    packet.packet = header->data;
+    packet.bytes = header->len;
+    packet.b_o_s = 1;
+    ogg_stream_packetin (&stream, &packet);
+    success = flush_ogg_stream (fp, &stream);
+
+    g_byte_array_set_size (header, 0);
+    g_byte_array_append (header, (const guint8 *)"OpusTags", 8);
+    append_le32 (header, strlen (vendor));
+    g_byte_array_append (header, (const guint8 *)vendor, strlen (vendor));
+    append_le32 (header, 0);
+
+    packet.packet = header->data;
+    packet.bytes = header->len;
+    packet.b_o_s = 0;
+    packet.packetno = 1;
+    ogg_stream_packetin (&stream, &packet);
+    success = success && flush_ogg_stream (fp, &stream);
+
+    memset (pcm, 0, sizeof (pcm));
+
+    for (i = 0; i < N_FRAMES && success; i++)
+    {
+        const opus_int32 length = opus_encode (encoder, pcm, FRAME_SIZE, data,
+                                               sizeof (data));
+
+        if (length < 0)
+        {
+            success = FALSE;
+            break;
+        }
+
+        packet.packet = data;
+        packet.bytes = length;
+        packet.granulepos = (ogg_int64_t)(i + 1) * FRAME_SIZE;
+        packet.packetno = i + 2;
+        packet.e_o_s = (i == N_FRAMES - 1);
+        ogg_stream_packetin (&stream, &packet);
+
+        while (success && ogg_stream_pageout (&stream, &page) != 0)
+        {
+            success = write_ogg_page (fp, &page);
+        }
+    }
+
+    success = success && flush_ogg_stream (fp, &stream);
+
+    if (fclose (fp) != 0)
+    {
+        success = FALSE;
+    }
+
+    ogg_stream_clear (&stream);
+    g_byte_array_unref (header);
+    opus_encoder_destroy (encoder);
+
+    if (!success)
+    {
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                     "Error encoding Opus stream to ‘%s’", filename);
+    }
+
+    return success;
+}
+#endif /* ENABLE_OPUS */
+
+static gsize
+mp4_box_begin (GByteArray *array,
+               const gchar *type)
+{
+    const gsize offset = array->len;
+
+    append_be32 (array, 0);
+    g_byte_array_append (array, (const guint8 *)type, 4);
+
+    return offset;
+}
+
+static void
+mp4_box_end (GByteArray *array,
+             gsize offset)
+{
+    put_be32 (array, offset, array->len - offset);
+}
+
+static gsize
+mp4_full_box_begin (GByteArray *array,
+                    const gchar *type,
+                    guint32 flags)
+{
+    const gsize offset = mp4_box_begin (array, type);
+
+    /* Version 0, followed by 24 bits of flags. */
+    append_be32 (array, flags & 0xffffff);
+
+    return offset;
+}
+
+static gsize
+mp4_descriptor_begin (GByteArray *array,
+                      guint8 tag)
+{
+    const guint8 bytes[] = { tag, 0 };
+
+    g_byte_array_append (array, bytes, sizeof (bytes));
+
+    return array->len - 1;
+}
+
+static void
+mp4_descriptor_end (GByteArray *array,
+                    gsize offset)
+{
+    array->data[offset] = array->len - offset - 1;
+}
+
+/*
+ * An MPEG-4 file with a single AAC track, the sample data of which is all
+ * zeros. It is not decodable, but has all the boxes that TagLib needs to read
+ * the audio properties and to write an ilst box.
+ */
+static gboolean
+write_mp4 (const gchar *filename,
+           GError **error)
+{
+    /* AAC frames of 1024 samples, of constant size. */
+    enum { N_SAMPLES = CORPUS_SAMPLE_RATE / 1024 + 1, SAMPLE_SIZE = 372 };
+    static const guint32 matrix[9] = { 0x10000, 0, 0, 0, 0x10000, 0, 0, 0,
+                                       0x40000000 };
+    GByteArray *array;
+    gsize ftyp, moov, trak, mdia, minf, dinf, stbl, box, entry, desc, sub;
+    gsize stco_offset;
+    guint i;
+
+    array = g_byte_array_new ();
+
+    ftyp = mp4_box_begin (array, "ftyp");
+    g_byte_array_append (array, (const guint8 *)"M4A ", 4);
+    append_be32 (array, 0);
+    g_byte_array_append (array, (const guint8 *)"M4A mp42isom", 12);
+    mp4_box_end (array, ftyp);
+
+    moov = mp4_box_begin (array, "moov");
+
+    box = mp4_full_box_begin (array, "mvhd", 0);
+    append_be32 (array, 0);
+    append_be32 (array, 0);
+    append_be32 (array, CORPUS_SAMPLE_RATE);
+    append_be32 (array, N_SAMPLES * 1024);
+    append_be32 (array, 0x10000);
+    append_be16 (array, 0x100);
+    append_zeros (array, 10);
+
+    for (i = 0; i < G_N_ELEMENTS (matrix); i++)
+    {
+        append_be32 (array, matrix[i]);
+    }
+
+    append_zeros (array, 24);
+    append_be32 (array, 2);
+    mp4_box_end (array, box);
+
+    trak = mp4_box_begin (array, "trak");
+
+    /* Enabled, in movie and in preview. */
+    box = mp4_full_box_begin (array, "tkhd", 7);
+    append_be32 (array, 0);
+    append_be32 (array, 0);
+    append_be32 (array, 1);
+    append_be32 (array, 0);
+    append_be32 (array, N_SAMPLES * 1024);
+    append_zeros (array, 8);
+    append_be16 (array, 0);
+    append_be16 (array, 0);
+    append_be16 (array, 0x100);
+    append_be16 (array, 0);
+
+    for (i = 0; i < G_N_ELEMENTS (matrix); i++)
+    {
+        append_be32 (array, matrix[i]);
+    }
+
+    append_be32 (array, 0);
+    append_be32 (array, 0);
+    mp4_box_end (array, box);
+
+    mdia = mp4_box_begin (array, "mdia");
+
+    box = mp4_full_box_begin (array, "mdhd", 0);
+    append_be32 (array, 0);
+    append_be32 (array, 0);
+    append_be32 (array, CORPUS_SAMPLE_RATE);
+    append_be32 (array, N_SAMPLES * 1024);
+    /* Packed ISO-639-2 “und”. */
+    append_be16 (array, 0x55c4);
+    append_be16 (array, 0);
+    mp4_box_end (array, box);
+
+    box = mp4_full_box_begin (array, "hdlr", 0);
+    append_be32 (array, 0);
+    g_byte_array_append (array, (const guint8 *)"soun", 4);
+    append_zeros (array, 12);
+    g_byte_array_append (array, (const guint8 *)"", 1);
+    mp4_box_end (array, box);
+
+    minf = mp4_box_begin (array, "minf");
+
+    box = mp4_full_box_begin (array, "smhd", 0);
+    append_be16 (array, 0);
+    append_be16 (array, 0);
+    mp4_box_end (array, box);
+
+    dinf = mp4_box_begin (array, "dinf");
+    box = mp4_full_box_begin (array, "dref", 0);
+    append_be32 (array, 1);
+    /* Self-contained: the media data is in this file. */
+    sub = mp4_full_box_begin (array, "url ", 1);
+    mp4_box_end (array, sub);
+    mp4_box_end (array, box);
+    mp4_box_end (array, dinf);
+
+    stbl = mp4_box_begin (array, "stbl");
+
+    box = mp4_full_box_begin (array, "stsd", 0);
+    append_be32 (array, 1);
+
+    entry = mp4_box_begin (array, "mp4a");
+    append_zeros (array, 6);
+    append_be16 (array, 1);
+    append_zeros (array, 8);
+    append_be16 (array, CORPUS_CHANNELS);
+    append_be16 (array, 16);
+    append_be32 (array, 0);
+    append_be32 (array, (guint32)CORPUS_SAMPLE_RATE << 16);
+
+    {
+        const gsize esds = mp4_full_box_begin (array, "esds", 0);
+        gsize dec;
+
+        /* ES_Descriptor, with ES_ID 1 and no flags. */
+        desc = mp4_descriptor_begin (array, 0x03);
+        append_be16 (array, 1);
+        g_byte_array_append (array, (const guint8 *)"\0", 1);
+
+        /* DecoderConfigDescriptor: MPEG-4 audio, audio stream. */
+        dec = mp4_descriptor_begin (array, 0x04);
+        g_byte_array_append (array, (const guint8 *)"\x40\x15", 2);
+        append_zeros (array, 3);
+        append_be32 (array, 128000);
+        append_be32 (array, 128000);
+
+        /* DecoderSpecificInfo: AAC LC, 44.1 kHz, stereo. */
+        sub = mp4_descriptor_begin (array, 0x05);
+        g_byte_array_append (array, (const guint8 *)"\x12\x10", 2);
+        mp4_descriptor_end (array, sub);
+        mp4_descriptor_end (array, dec);
+
+        /* SLConfigDescriptor, predefined for MP4 files. */
+        sub = mp4_descriptor_begin (array, 0x06);
+        g_byte_array_append (array, (const guint8 *)"\x02", 1);
+        mp4_descriptor_end (array, sub);
+        mp4_descriptor_end (array, desc);
+
+        mp4_box_end (array, esds);
+    }
+
+    mp4_box_end (array, entry);
+    mp4_box_end (array, box);
+
+    box = mp4_full_box_begin (array, "stts", 0);
+    append_be32 (array, 1);
+    append_be32 (array, N_SAMPLES);
+    append_be32 (array, 1024);
+    mp4_box_end (array, box);
+
+    box = mp4_full_box_begin (array, "stsc", 0);
+    append_be32 (array, 1);
+    append_be32 (array, 1);
+    append_be32 (array, N_SAMPLES);
+    append_be32 (array, 1);
+    mp4_box_end (array, box);
+
+    box = mp4_full_box_begin (array, "stsz", 0);
+    append_be32 (array, SAMPLE_SIZE);
+    append_be32 (array, N_SAMPLES);
+    mp4_box_end (array, box);
+
+    box = mp4_full_box_begin (array, "stco", 0);
+    append_be32 (array, 1);
+    stco_offset = array->len;
+    append_be32 (array, 0);
+    mp4_box_end (array, box);
+
+    mp4_box_end (array, stbl);
+    mp4_box_end (array, minf);
+    mp4_box_end (array, mdia);
+    mp4_box_end (array, trak);
+    mp4_box_end (array, moov);
+
+    /* The single chunk starts after the mdat box header. */
+    put_be32 (array, stco_offset, array->len + 8);
+
+    box = mp4_box_begin (array, "mdat");
+    append_zeros (array, N_SAMPLES * SAMPLE_SIZE);
+    mp4_box_end (array, box);
+
+    return write_byte_array (filename, array, error);
+}
+
+#ifdef ENABLE_WAVPACK
+static int
+wavpack_block_output (void *id,
+                      void *data,
+                      int32_t length)
+{
+    return fwrite (data, 1, length, id) == (size_t)length;
+}
+
+static gboolean
+write_wavpack (const gchar *filename,
+               GError **error)
+{
+    WavpackContext *context;
+    WavpackConfig config;
+    int32_t samples[1024 * CORPUS_CHANNELS];
+    guint remaining;
+    gint err;
+    FILE *fp;
+    gboolean success;
+
+    fp = g_fopen (filename, "wb");
+
+    if (fp == NULL)
+    {
+        err = errno;
+        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (err),
+                     "Error opening ‘%s’: %s", filename, g_strerror (err));
+        return FALSE;
+    }
+
+    context = WavpackOpenFileOutput (wavpack_block_output, fp, NULL);
+
+    memset (&config, 0, sizeof (config));
+    config.bytes_per_sample = 2;
+    config.bits_per_sample = 16;
+    config.channel_mask = 0x3;
+    config.num_channels = CORPUS_CHANNELS;
+    config.sample_rate = CORPUS_SAMPLE_RATE;
+
+    success = context != NULL
+              && WavpackSetConfiguration (context, &config,
+                                          CORPUS_SAMPLE_RATE)
+              && WavpackPackInit (context);
+
+    memset (samples, 0, sizeof (samples));
+
+    for (remaining = CORPUS_SAMPLE_RATE; remaining > 0 && success;)
+    {
+        const guint n = MIN (remaining, G_N_ELEMENTS (samples)
+                                        / CORPUS_CHANNELS);
+
+        success = WavpackPackSamples (context, samples, n);
+        remaining -= n;
+    }
+
+    success = success && WavpackFlushSamples (context);
+
+    if (context != NULL)
+    {
+        WavpackCloseFile (context);
+    }
+
+    if (fclose (fp) != 0)
+    {
+        success = FALSE;
+    }
+
+    if (!success)
+    {
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                     "Error encoding WavPack stream to ‘%s’", filename);
+    }
+
+    return success;
+}
+#endif /* ENABLE_WAVPACK */
+
+/*
+ * A Monkey's Audio file with an old-style (before 3.98) header, followed by
+ * zeros in place of the compressed frames. Only the header is read by
+ * EasyTAG.
+ */
+static gboolean
+write_monkeys_audio (const gchar *filename,
+                     GError **error)
+{
+    GByteArray *array;
+
+    array = g_byte_array_new ();
+    g_byte_array_append (array, (const guint8 *)"MAC ", 4);
+    append_le16 (array, 3970);
+    /* Normal compression. */
+    append_le16 (array, 2000);
+    append_le16 (array, 0);
+    append_le16 (array, CORPUS_CHANNELS);
+    append_le32 (array, CORPUS_SAMPLE_RATE);
+    append_le32 (array, 0);
+    append_le32 (array, 0);
+    append_le32 (array, 1);
+    append_le32 (array, CORPUS_SAMPLE_RATE);
+    append_zeros (array, 16 * 1024);
+
+    return write_byte_array (filename, array, error);
+}
+
+/*
+ * et_corpus_write_audio:
+ * @format: the format of the file to write
+ * @filename: the path of the file to write, in the GLib filename encoding
+ * @error: a #GError, or %NULL
+ *
+ * Write a short, untagged audio file of @format to @filename, overwriting
+ * any existing file.
+ *
+ * Returns: %TRUE on success, %FALSE and with @error set otherwise
+ */
+gboolean
+et_corpus_write_audio (EtCorpusFormat format,
+                       const gchar *filename,
+                       GError **error)
+{
+    g_return_val_if_fail (filename != NULL, FALSE);
+    g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+    switch (format)
+    {
+        case ET_CORPUS_FORMAT_MP3:
+            return write_mp3 (filename, error);
+#ifdef ENABLE_FLAC
+        case ET_CORPUS_FORMAT_FLAC:
+            return write_flac (filename, error);
+#endif
+#ifdef ENABLE_OPUS
+        case ET_CORPUS_FORMAT_OPUS:
+            return write_opus (filename, error);
+#endif
+        case ET_CORPUS_FORMAT_MP4:
+            return write_mp4 (filename, error);
+#ifdef ENABLE_WAVPACK
+        case ET_CORPUS_FORMAT_WAVPACK:
+            return write_wavpack (filename, error);
+#endif
+        case ET_CORPUS_FORMAT_MONKEYS_AUDIO:
+            return write_monkeys_audio (filename, error);
+        default:
+            g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                         "Corpus format ‘%s’ is not supported by this build",
+                         et_corpus_format_get_name (format));
+            return FALSE;
+    }
+}
+
+/*
+ * et_corpus_new_picture_data:
+ * @size: the size of the picture, in bytes
+ *
+ * Create the data of a cover picture of @size bytes. The data has JPEG start
+ * and end markers, so that it is recognised as a JPEG image, and is filled
+ * with pseudo-random bytes, so that it does not compress well. The same
+ * @size always gives the same data.
+ *
+ * Returns: the picture data, free with g_bytes_unref()
+ */
+GBytes *
+et_corpus_new_picture_data (gsize size)
+{
+    static const guint8 start[] = { 0xff, 0xd8, 0xff, 0xe0, 0x00, 0x10, 'J',
+                                    'F', 'I', 'F', 0x00 };
+    static const guint8 end[] = { 0xff, 0xd9 };
+    guint8 *data;
+    GRand *rand;
+    gsize i;
+
+    size = MAX (size, sizeof (start) + sizeof (end));
+    data = g_malloc (size);
+    memcpy (data, start, sizeof (start));
+
+    rand = g_rand_new_with_seed (size);
+
+    for (i = sizeof (start); i < size - sizeof (end); i++)
+    {
+        /* Avoid 0xff, which could be read as a marker. */
+        data[i] = g_rand_int_range (rand, 0, 0xff);
+    }
+
+    g_rand_free (rand);
+    memcpy (data + size - sizeof (end), end, sizeof (end));
+
+    return g_bytes_new_take (data, size);
+}
+
+/*
+ * et_corpus_remove_recursive:
+ * @path: the file or directory to remove
+ *
+ * Remove @path and, if it is a directory, everything in it, failing the
+ * test if anything cannot be removed.
+ */
+void
+et_corpus_remove_recursive (const gchar *path)
+{
+    GDir *dir;
+    const gchar *name;
+
+    if ((dir = g_dir_open (path, 0, NULL)))
+    {
+        while ((name = g_dir_read_name (dir)) != NULL)
+        {
+            gchar *child = g_build_filename (path, name, NULL);
+
+            et_corpus_remove_recursive (child);
+            g_free (child);
+        }
+
+        g_dir_close (dir);
+        g_assert_cmpint (g_rmdir (path), ==, 0);
+    }
+    else
+    {
+        g_assert_cmpint (g_unlink (path), ==, 0);
+    }
+}
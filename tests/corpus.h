@@ -0,0 +1,59 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ET_CORPUS_H_
+#define ET_CORPUS_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * EtCorpusFormat:
+ * @ET_CORPUS_FORMAT_MP3: MPEG-1 layer III, tagged with ID3
+ * @ET_CORPUS_FORMAT_FLAC: FLAC, tagged with Vorbis comments
+ * @ET_CORPUS_FORMAT_OPUS: Ogg Opus, tagged with Vorbis comments
+ * @ET_CORPUS_FORMAT_MP4: MPEG-4 audio, tagged with iTunes metadata
+ * @ET_CORPUS_FORMAT_WAVPACK: WavPack, tagged with APEv2
+ * @ET_CORPUS_FORMAT_MONKEYS_AUDIO: Monkey's Audio, tagged with APEv2
+ *
+ * The formats of the synthetic audio files of the corpus.
+ */
+typedef enum
+{
+    ET_CORPUS_FORMAT_MP3,
+    ET_CORPUS_FORMAT_FLAC,
+    ET_CORPUS_FORMAT_OPUS,
+    ET_CORPUS_FORMAT_MP4,
+    ET_CORPUS_FORMAT_WAVPACK,
+    ET_CORPUS_FORMAT_MONKEYS_AUDIO,
+    ET_CORPUS_FORMAT_COUNT
+} EtCorpusFormat;
+
+const gchar * et_corpus_format_get_name (EtCorpusFormat format);
+const gchar * et_corpus_format_get_extension (EtCorpusFormat format);
+gboolean et_corpus_format_is_supported (EtCorpusFormat format);
+
+gboolean et_corpus_write_audio (EtCorpusFormat format, const gchar *filename, GError **error);
+GBytes * et_corpus_new_picture_data (gsize size);
+
+void et_corpus_remove_recursive (const gchar *path);
+
+G_END_DECLS
+
+#endif /* !ET_CORPUS_H_ */
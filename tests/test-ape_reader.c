@@ -0,0 +1,471 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "ape_reader.h"
+#include "libapetag/apetaglib.h"
+
+#include <glib/gstdio.h>
+#include <string.h>
+
+/* Flags of an APEv2 header or footer. */
+#define APE_FLAG_HAS_HEADER 0x80000000
+#define APE_FLAG_IS_HEADER 0x20000000
+
+static void
+append_uint32_le (GByteArray *data,
+                  guint32 value)
+{
+    const guint8 bytes[4] = { value & 0xFF, (value >> 8) & 0xFF,
+                              (value >> 16) & 0xFF, value >> 24 };
+
+    g_byte_array_append (data, bytes, sizeof (bytes));
+}
+
+static void
+append_item (GByteArray *items,
+             const gchar *key,
+             const gchar *value,
+             gsize value_size)
+{
+    append_uint32_le (items, value_size);
+    append_uint32_le (items, 0);
+    g_byte_array_append (items, (const guint8 *)key, strlen (key) + 1);
+    g_byte_array_append (items, (const guint8 *)value, value_size);
+}
+
+static void
+append_header (GByteArray *data,
+               guint32 version,
+               guint32 items_size,
+               guint32 n_items,
+               guint32 flags)
+{
+    static const guint8 reserved[8] = { 0, };
+
+    g_byte_array_append (data, (const guint8 *)"APETAGEX", 8);
+    append_uint32_le (data, version);
+    append_uint32_le (data, items_size + 32);
+    append_uint32_le (data, n_items);
+    append_uint32_le (data, flags);
+    g_byte_array_append (data, reserved, sizeof (reserved));
+}
+
+/*
+ * create_fixture:
+ * @name: the name of the file
+ * @magic: the first bytes of the audio data, identifying the format
+ * @items: the items of the APE tag, or %NULL for no APE tag
+ * @n_items: the number of items in @items
+ * @version: the APE tag version, 1000 or 2000
+ * @id3v1: an ID3v1 tag to append, or %NULL
+ *
+ * Returns: the path of a file with a fake audio stream followed by an APE
+ *          tag and an ID3v1 tag
+ */
+static gchar *
+create_fixture (const gchar *name,
+                const gchar *magic,
+                GByteArray *items,
+                guint n_items,
+                guint32 version,
+                const guint8 *id3v1)
+{
+    GByteArray *data;
+    gchar *path;
+    GError *error = NULL;
+
+    data = g_byte_array_new ();
+    g_byte_array_append (data, (const guint8 *)magic, strlen (magic));
+    g_byte_array_set_size (data, 4096);
+    memset (data->data + strlen (magic), 0x55, 4096 - strlen (magic));
+
+    if (items)
+    {
+        if (version == 2000)
+        {
+            append_header (data, version, items->len, n_items,
+                           APE_FLAG_HAS_HEADER | APE_FLAG_IS_HEADER);
+        }
+
+        g_byte_array_append (data, items->data, items->len);
+        append_header (data, version, items->len, n_items,
+                       version == 2000 ? APE_FLAG_HAS_HEADER : 0);
+    }
+
+    if (id3v1)
+    {
+        g_byte_array_append (data, id3v1, 128);
+    }
+
+    path = g_build_filename (g_get_tmp_dir (), name, NULL);
+    g_file_set_contents (path, (const gchar *)data->data, data->len, &error);
+    g_assert_no_error (error);
+    g_byte_array_unref (data);
+
+    return path;
+}
+
+static void
+read_fixture (const gchar *path,
+              gchar **values)
+{
+    GFile *file;
+    GError *error = NULL;
+
+    memset (values, 0, sizeof (gchar *) * ET_APE_FIELD_COUNT);
+    file = g_file_new_for_path (path);
+    g_assert (et_ape_reader_read_file (file, values, &error));
+    g_assert_no_error (error);
+    g_object_unref (file);
+    g_unlink (path);
+}
+
+static void
+free_values (gchar **values)
+{
+    gsize i;
+
+    for (i = 0; i < ET_APE_FIELD_COUNT; i++)
+    {
+        g_free (values[i]);
+        values[i] = NULL;
+    }
+}
+
+/* An ID3v1.1 tag: title, artist, album, year, comment and track 7, genre
+ * 17 (Rock). */
+static void
+fill_id3v1 (guint8 *id3v1)
+{
+    memset (id3v1, 0, 128);
+    memcpy (id3v1, "TAG", 3);
+    memcpy (id3v1 + 3, "ID3 title   ", 12);
+    memcpy (id3v1 + 33, "ID3 artist", 10);
+    memcpy (id3v1 + 63, "ID3 album\n", 10);
+    memcpy (id3v1 + 93, "1999", 4);
+    memcpy (id3v1 + 97, "ID3 comment", 11);
+    id3v1[97 + 29] = 7;
+    id3v1[127] = 17;
+}
+
+static void
+ape_reader_keys (void)
+{
+    static const struct
+    {
+        const gchar *key;
+        EtApeField field;
+    } keys[] =
+    {
+        { "Title", ET_APE_FIELD_TITLE },
+        { "Artist", ET_APE_FIELD_ARTIST },
+        { "Album Artist", ET_APE_FIELD_ALBUM_ARTIST },
+        { "Album", ET_APE_FIELD_ALBUM },
+        { "Part", ET_APE_FIELD_PART },
+        { "Year", ET_APE_FIELD_YEAR },
+        { "Track", ET_APE_FIELD_TRACK },
+        { "Genre", ET_APE_FIELD_GENRE },
+        { "Comment", ET_APE_FIELD_COMMENT },
+        { "Composer", ET_APE_FIELD_COMPOSER },
+        { "Original Artist", ET_APE_FIELD_ORIG_ARTIST },
+        { "Copyright", ET_APE_FIELD_COPYRIGHT },
+        { "Related", ET_APE_FIELD_URL },
+        { "Encoded By", ET_APE_FIELD_ENCODED_BY },
+        { "TITLE", ET_APE_FIELD_TITLE },
+        { "album artist", ET_APE_FIELD_ALBUM_ARTIST },
+        { "eNcOdEd bY", ET_APE_FIELD_ENCODED_BY },
+        { "", ET_APE_FIELD_UNKNOWN },
+        { "Titles", ET_APE_FIELD_UNKNOWN },
+        { "Titel", ET_APE_FIELD_UNKNOWN },
+        { "Tit", ET_APE_FIELD_UNKNOWN },
+        { "Subtitle", ET_APE_FIELD_UNKNOWN },
+        { "Lyrics", ET_APE_FIELD_UNKNOWN },
+        { "Cover Art (front)", ET_APE_FIELD_UNKNOWN },
+        { "Record Date", ET_APE_FIELD_UNKNOWN },
+        { "Publisher", ET_APE_FIELD_UNKNOWN },
+        { "Conductor", ET_APE_FIELD_UNKNOWN },
+        { "Debut Album", ET_APE_FIELD_UNKNOWN }
+    };
+    gsize i;
+
+    for (i = 0; i < G_N_ELEMENTS (keys); i++)
+    {
+        g_assert_cmpint (et_ape_field_from_key (keys[i].key,
+                                                strlen (keys[i].key)), ==,
+                         keys[i].field);
+    }
+
+    /* Keys which are not nul-terminated. */
+    g_assert_cmpint (et_ape_field_from_key ("Album Artist", 5), ==,
+                     ET_APE_FIELD_ALBUM);
+    g_assert_cmpint (et_ape_field_from_key ("Yearly", 4), ==,
+                     ET_APE_FIELD_YEAR);
+}
+
+/* Musepack file with an APEv2 tag. */
+static void
+ape_reader_mpc (void)
+{
+    GByteArray *items;
+    gchar *values[ET_APE_FIELD_COUNT];
+    gchar *path;
+
+    items = g_byte_array_new ();
+    append_item (items, "Title", "Title", 5);
+    append_item (items, "ARTIST", "Artist", 6);
+    append_item (items, "Album Artist", "Album artist", 12);
+    append_item (items, "Lyrics", "Not read", 8);
+    /* Empty items are skipped, and the first other item is used. */
+    append_item (items, "Genre", "", 0);
+    append_item (items, "genre", "Rock", 4);
+    append_item (items, "Genre", "Pop", 3);
+    append_item (items, "Track", "3/12", 4);
+    append_item (items, "Part", "1/2", 3);
+    /* Multiple values, separated by a nul byte. */
+    append_item (items, "Composer", "A\0B", 3);
+    append_item (items, "Related", "http://example.org", 18);
+    append_item (items, "Encoded By", "EasyTAG", 7);
+    append_item (items, "Original Artist", "Original", 8);
+    append_item (items, "Copyright", "None", 4);
+    append_item (items, "Year", "2001", 4);
+
+    path = create_fixture ("test-ape-reader.mpc", "MPCK", items, 15, 2000,
+                           NULL);
+    read_fixture (path, values);
+    g_free (path);
+
+    g_assert_cmpstr (values[ET_APE_FIELD_TITLE], ==, "Title");
+    g_assert_cmpstr (values[ET_APE_FIELD_ARTIST], ==, "Artist");
+    g_assert_cmpstr (values[ET_APE_FIELD_ALBUM_ARTIST], ==, "Album artist");
+    g_assert_cmpstr (values[ET_APE_FIELD_ALBUM], ==, NULL);
+    g_assert_cmpstr (values[ET_APE_FIELD_GENRE], ==, "Rock");
+    g_assert_cmpstr (values[ET_APE_FIELD_TRACK], ==, "3/12");
+    g_assert_cmpstr (values[ET_APE_FIELD_PART], ==, "1/2");
+    g_assert_cmpstr (values[ET_APE_FIELD_COMPOSER], ==, "A");
+    g_assert_cmpstr (values[ET_APE_FIELD_URL], ==, "http://example.org");
+    g_assert_cmpstr (values[ET_APE_FIELD_ENCODED_BY], ==, "EasyTAG");
+    g_assert_cmpstr (values[ET_APE_FIELD_ORIG_ARTIST], ==, "Original");
+    g_assert_cmpstr (values[ET_APE_FIELD_COPYRIGHT], ==, "None");
+    g_assert_cmpstr (values[ET_APE_FIELD_YEAR], ==, "2001");
+    g_assert_cmpstr (values[ET_APE_FIELD_COMMENT], ==, NULL);
+    free_values (values);
+
+    /* Fewer items than given in the footer, and a truncated item. */
+    g_byte_array_set_size (items, 0);
+    append_item (items, "Title", "Title", 5);
+    append_uint32_le (items, 1000);
+    append_uint32_le (items, 0);
+    g_byte_array_append (items, (const guint8 *)"Artist\0abc", 10);
+
+    path = create_fixture ("test-ape-reader.mpc", "MP+", items, 10, 2000,
+                           NULL);
+    read_fixture (path, values);
+    g_free (path);
+
+    g_assert_cmpstr (values[ET_APE_FIELD_TITLE], ==, "Title");
+    g_assert_cmpstr (values[ET_APE_FIELD_ARTIST], ==, NULL);
+    free_values (values);
+
+    g_byte_array_unref (items);
+}
+
+/* Monkey's Audio file with an APEv1 tag, followed by an ID3v1 tag. */
+static void
+ape_reader_ape (void)
+{
+    GByteArray *items;
+    guint8 id3v1[128];
+    gchar *values[ET_APE_FIELD_COUNT];
+    gchar *path;
+
+    fill_id3v1 (id3v1);
+    items = g_byte_array_new ();
+    /* Values in APEv1 tags may include a trailing nul byte. */
+    append_item (items, "Title", "APE title", 10);
+    append_item (items, "Comment", "APE comment", 11);
+
+    path = create_fixture ("test-ape-reader.ape", "MAC ", items, 2, 1000,
+                           id3v1);
+    read_fixture (path, values);
+    g_free (path);
+
+    /* The APE tag is used first, then the ID3v1 tag. */
+    g_assert_cmpstr (values[ET_APE_FIELD_TITLE], ==, "APE title");
+    g_assert_cmpstr (values[ET_APE_FIELD_COMMENT], ==, "APE comment");
+    g_assert_cmpstr (values[ET_APE_FIELD_ARTIST], ==, "ID3 artist");
+    g_assert_cmpstr (values[ET_APE_FIELD_ALBUM], ==, "ID3 album");
+    g_assert_cmpstr (values[ET_APE_FIELD_YEAR], ==, "1999");
+    g_assert_cmpstr (values[ET_APE_FIELD_TRACK], ==, "7");
+    g_assert_cmpstr (values[ET_APE_FIELD_GENRE], ==, "Rock");
+    g_assert_cmpstr (values[ET_APE_FIELD_ALBUM_ARTIST], ==, NULL);
+    free_values (values);
+
+    g_byte_array_unref (items);
+}
+
+/* OptimFROG files, with only an ID3v1 tag, no tag or a broken APE tag. */
+static void
+ape_reader_ofr (void)
+{
+    GByteArray *items;
+    guint8 id3v1[128];
+    gchar *values[ET_APE_FIELD_COUNT];
+    gchar *path;
+    gsize i;
+
+    fill_id3v1 (id3v1);
+    path = create_fixture ("test-ape-reader.ofr", "OFR ", NULL, 0, 2000,
+                           id3v1);
+    read_fixture (path, values);
+    g_free (path);
+
+    g_assert_cmpstr (values[ET_APE_FIELD_TITLE], ==, "ID3 title");
+    g_assert_cmpstr (values[ET_APE_FIELD_COMMENT], ==, "ID3 comment");
+    g_assert_cmpstr (values[ET_APE_FIELD_TRACK], ==, "7");
+    free_values (values);
+
+    path = create_fixture ("test-ape-reader.ofr", "OFR ", NULL, 0, 2000,
+                           NULL);
+    read_fixture (path, values);
+
+    for (i = 0; i < ET_APE_FIELD_COUNT; i++)
+    {
+        g_assert (values[i] == NULL);
+    }
+
+    /* A tag size larger than the file. */
+    items = g_byte_array_new ();
+    append_header (items, 2000, 1024 * 1024, 1, 0);
+    g_file_set_contents (path, (const gchar *)items->data, items->len, NULL);
+    g_byte_array_unref (items);
+    read_fixture (path, values);
+    g_free (path);
+
+    for (i = 0; i < ET_APE_FIELD_COUNT; i++)
+    {
+        g_assert (values[i] == NULL);
+    }
+}
+
+static goffset
+get_file_size (const gchar *path)
+{
+    GStatBuf statbuf;
+
+    g_assert_cmpint (g_stat (path, &statbuf), ==, 0);
+
+    return statbuf.st_size;
+}
+
+/* Saving a tag which fits in the previous one keeps the file size, and the
+ * audio data is never touched. */
+static void
+ape_reader_save (void)
+{
+    GByteArray *items;
+    apetag *ape_mem;
+    gchar *values[ET_APE_FIELD_COUNT];
+    gchar *path;
+    gchar *contents;
+    gsize length;
+    goffset size;
+    GError *error = NULL;
+
+    items = g_byte_array_new ();
+    append_item (items, "Title", "Long title of the track", 23);
+    append_item (items, "Artist", "Artist", 6);
+
+    path = create_fixture ("test-ape-reader.ape", "MAC ", items, 2, 2000,
+                           NULL);
+    g_byte_array_unref (items);
+    size = get_file_size (path);
+
+    /* A shorter title: the rest of the previous tag is used as padding. */
+    ape_mem = apetag_init ();
+    apefrm_add (ape_mem, 0, "Title", "Title");
+    g_assert_cmpint (apetag_save (path, ape_mem,
+                                  APE_TAG_V2 + SAVE_NEW_OLD_APE_TAG
+                                  + SAVE_RESERVE_PADDING), ==, 0);
+    apetag_free (ape_mem);
+    g_assert_cmpint (get_file_size (path), ==, size);
+
+    g_file_get_contents (path, &contents, &length, &error);
+    g_assert_no_error (error);
+    g_assert (memcmp (contents, "MAC ", 4) == 0);
+    g_assert_cmpint (contents[4095], ==, 0x55);
+    g_assert (memcmp (contents + 4096, "APETAGEX", 8) == 0);
+    g_assert (memcmp (contents + length - 32, "APETAGEX", 8) == 0);
+    g_free (contents);
+
+    memset (values, 0, sizeof (values));
+    {
+        GFile *file = g_file_new_for_path (path);
+
+        g_assert (et_ape_reader_read_file (file, values, &error));
+        g_assert_no_error (error);
+        g_object_unref (file);
+    }
+
+    g_assert_cmpstr (values[ET_APE_FIELD_TITLE], ==, "Title");
+    g_assert_cmpstr (values[ET_APE_FIELD_ARTIST], ==, "Artist");
+    g_assert_cmpstr (values[ET_APE_FIELD_ALBUM], ==, NULL);
+    free_values (values);
+
+    /* A tag which does not fit grows the file, with padding reserved for the
+     * next save. */
+    ape_mem = apetag_init ();
+    apefrm_add (ape_mem, 0, "Comment", "A comment which is much longer than "
+                "the padding which was left by the previous save, so that "
+                "the tag has to grow beyond the end of the file, with some "
+                "padding reserved for the next time that it is saved");
+    g_assert_cmpint (apetag_save (path, ape_mem,
+                                  APE_TAG_V2 + SAVE_NEW_OLD_APE_TAG
+                                  + SAVE_RESERVE_PADDING), ==, 0);
+    apetag_free (ape_mem);
+    size = get_file_size (path);
+
+    ape_mem = apetag_init ();
+    apefrm_add (ape_mem, 0, "Album", "Album");
+    g_assert_cmpint (apetag_save (path, ape_mem,
+                                  APE_TAG_V2 + SAVE_NEW_OLD_APE_TAG
+                                  + SAVE_RESERVE_PADDING), ==, 0);
+    apetag_free (ape_mem);
+    g_assert_cmpint (get_file_size (path), ==, size);
+
+    read_fixture (path, values);
+    g_assert_cmpstr (values[ET_APE_FIELD_TITLE], ==, "Title");
+    g_assert_cmpstr (values[ET_APE_FIELD_ALBUM], ==, "Album");
+    g_assert (g_str_has_prefix (values[ET_APE_FIELD_COMMENT], "A comment"));
+    free_values (values);
+
+    g_free (path);
+}
+
+int
+main (int argc, char** argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/ape_reader/keys", ape_reader_keys);
+    g_test_add_func ("/ape_reader/mpc", ape_reader_mpc);
+    g_test_add_func ("/ape_reader/ape", ape_reader_ape);
+    g_test_add_func ("/ape_reader/ofr", ape_reader_ofr);
+    g_test_add_func ("/ape_reader/save", ape_reader_save);
+
+    return g_test_run ();
+}
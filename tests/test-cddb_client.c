@@ -0,0 +1,533 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "cddb_client.h"
+
+#include <glib/gstdio.h>
+#include <string.h>
+
+/* soup_server_listen_local() is only available since libsoup 2.48. */
+#if SOUP_CHECK_VERSION (2, 48, 0)
+
+/* A local stand-in for a CDDB server. Requests below /slow/ are answered
+ * after a short delay, so that several of them are in flight at once. */
+typedef struct
+{
+    SoupServer *server;
+    gchar *base_uri;
+    GPtrArray *paths;
+    guint n_requests;
+    guint n_in_flight;
+    guint max_in_flight;
+} Fixture;
+
+typedef struct
+{
+    Fixture *fixture;
+    SoupServer *server;
+    SoupMessage *message;
+} DelayedResponse;
+
+typedef struct
+{
+    GMainLoop *loop;
+    guint n_pending;
+    guint n_succeeded;
+    GError *error;
+    GBytes *bytes;
+} FetchResults;
+
+static const gchar album_response[] = "210 rock 8f0dc00b CD database entry follows\n"
+                                      "DTITLE=Archive / Noise\n"
+                                      ".\n";
+
+static gboolean
+send_delayed_response (gpointer user_data)
+{
+    DelayedResponse *response = user_data;
+
+    soup_message_set_status (response->message, SOUP_STATUS_OK);
+    soup_message_set_response (response->message, "text/plain",
+                               SOUP_MEMORY_STATIC, album_response,
+                               strlen (album_response));
+    soup_server_unpause_message (response->server, response->message);
+    response->fixture->n_in_flight--;
+
+    g_slice_free (DelayedResponse, response);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+server_callback (SoupServer *server,
+                 SoupMessage *message,
+                 const gchar *path,
+                 GHashTable *query,
+                 SoupClientContext *context,
+                 gpointer user_data)
+{
+    Fixture *fixture = user_data;
+
+    fixture->n_requests++;
+    g_ptr_array_add (fixture->paths, g_strdup (path));
+
+    if (g_str_has_prefix (path, "/slow/"))
+    {
+        DelayedResponse *response;
+
+        fixture->n_in_flight++;
+        fixture->max_in_flight = MAX (fixture->max_in_flight,
+                                      fixture->n_in_flight);
+
+        response = g_slice_new (DelayedResponse);
+        response->fixture = fixture;
+        response->server = server;
+        response->message = message;
+
+        soup_server_pause_message (server, message);
+        g_timeout_add (20, send_delayed_response, response);
+    }
+    else if (strcmp (path, "/album") == 0)
+    {
+        soup_message_set_status (message, SOUP_STATUS_OK);
+        soup_message_set_response (message, "text/plain", SOUP_MEMORY_STATIC,
+                                   album_response, strlen (album_response));
+    }
+    else
+    {
+        soup_message_set_status (message, SOUP_STATUS_NOT_FOUND);
+    }
+}
+
+static void
+fixture_setup (Fixture *fixture,
+               gconstpointer user_data)
+{
+    GSList *uris;
+    GError *error = NULL;
+
+    memset (fixture, 0, sizeof (*fixture));
+    fixture->paths = g_ptr_array_new_with_free_func (g_free);
+
+    fixture->server = soup_server_new (NULL, NULL);
+    soup_server_add_handler (fixture->server, NULL, server_callback, fixture,
+                             NULL);
+    soup_server_listen_local (fixture->server, 0, 0, &error);
+    g_assert_no_error (error);
+
+    uris = soup_server_get_uris (fixture->server);
+    g_assert (uris != NULL);
+    fixture->base_uri = soup_uri_to_string (uris->data, FALSE);
+    g_slist_free_full (uris, (GDestroyNotify)soup_uri_free);
+}
+
+static void
+fixture_teardown (Fixture *fixture,
+                  gconstpointer user_data)
+{
+    /* Let the delayed responses of cancelled requests run. */
+    while (fixture->n_in_flight > 0)
+    {
+        g_main_context_iteration (NULL, TRUE);
+    }
+
+    soup_server_disconnect (fixture->server);
+    g_object_unref (fixture->server);
+    g_free (fixture->base_uri);
+    g_ptr_array_unref (fixture->paths);
+}
+
+static gchar *
+fixture_get_uri (Fixture *fixture,
+                 const gchar *path)
+{
+    /* The base URI ends with a slash. */
+    return g_strconcat (fixture->base_uri, path + 1, NULL);
+}
+
+static void
+on_fetched (GObject *source_object,
+            GAsyncResult *result,
+            gpointer user_data)
+{
+    FetchResults *results = user_data;
+    GBytes *bytes;
+    GError *error = NULL;
+
+    bytes = et_cddb_client_fetch_finish (result, &error);
+
+    if (bytes != NULL)
+    {
+        results->n_succeeded++;
+
+        if (results->bytes != NULL)
+        {
+            g_bytes_unref (results->bytes);
+        }
+
+        results->bytes = bytes;
+    }
+    else
+    {
+        g_clear_error (&results->error);
+        results->error = error;
+    }
+
+    if (--results->n_pending == 0)
+    {
+        g_main_loop_quit (results->loop);
+    }
+}
+
+static void
+fetch_with_priority (EtCddbClient *client,
+                     Fixture *fixture,
+                     const gchar *path,
+                     gint io_priority,
+                     GCancellable *cancellable,
+                     FetchResults *results)
+{
+    gchar *uri;
+
+    uri = fixture_get_uri (fixture, path);
+    results->n_pending++;
+    et_cddb_client_fetch_async (client, uri, io_priority, cancellable,
+                                on_fetched, results);
+    g_free (uri);
+}
+
+static void
+fetch (EtCddbClient *client,
+       Fixture *fixture,
+       const gchar *path,
+       GCancellable *cancellable,
+       FetchResults *results)
+{
+    fetch_with_priority (client, fixture, path, G_PRIORITY_DEFAULT,
+                         cancellable, results);
+}
+
+static void
+results_init (FetchResults *results)
+{
+    memset (results, 0, sizeof (*results));
+    results->loop = g_main_loop_new (NULL, FALSE);
+}
+
+static void
+results_clear (FetchResults *results)
+{
+    g_main_loop_unref (results->loop);
+    g_clear_error (&results->error);
+
+    if (results->bytes != NULL)
+    {
+        g_bytes_unref (results->bytes);
+    }
+}
+
+static void
+results_wait (FetchResults *results)
+{
+    if (results->n_pending > 0)
+    {
+        g_main_loop_run (results->loop);
+    }
+}
+
+static void
+assert_album_response (GBytes *bytes)
+{
+    gconstpointer data;
+    gsize size;
+
+    g_assert (bytes != NULL);
+    data = g_bytes_get_data (bytes, &size);
+    g_assert_cmpuint (size, ==, strlen (album_response));
+    g_assert (memcmp (data, album_response, size) == 0);
+}
+
+static void
+cddb_client_fetch (Fixture *fixture,
+                   gconstpointer user_data)
+{
+    SoupSession *session;
+    EtCddbClient *client;
+    FetchResults results;
+
+    session = soup_session_new ();
+    client = et_cddb_client_new (session, NULL, 2);
+    results_init (&results);
+
+    fetch (client, fixture, "/album", NULL, &results);
+    results_wait (&results);
+
+    g_assert_no_error (results.error);
+    assert_album_response (results.bytes);
+    g_assert_cmpuint (fixture->n_requests, ==, 1);
+
+    /* Without a cache, every fetch is sent to the server. */
+    fetch (client, fixture, "/album", NULL, &results);
+    results_wait (&results);
+    g_assert_cmpuint (fixture->n_requests, ==, 2);
+
+    /* HTTP errors are reported. */
+    fetch (client, fixture, "/missing", NULL, &results);
+    results_wait (&results);
+    g_assert_error (results.error, G_IO_ERROR, G_IO_ERROR_FAILED);
+    g_assert_cmpuint (results.n_succeeded, ==, 2);
+
+    results_clear (&results);
+    et_cddb_client_free (client);
+    g_object_unref (session);
+}
+
+static void
+cddb_client_cache (Fixture *fixture,
+                   gconstpointer user_data)
+{
+    SoupSession *session;
+    EtCddbClient *client;
+    FetchResults results;
+    gchar *cache_path;
+    gchar *uri;
+    gchar *cache_file;
+    GDir *dir;
+    const gchar *name;
+    GError *error = NULL;
+
+    cache_path = g_dir_make_tmp ("easytag-cddb-XXXXXX", &error);
+    g_assert_no_error (error);
+
+    session = soup_session_new ();
+    client = et_cddb_client_new (session, cache_path, 2);
+    results_init (&results);
+
+    fetch (client, fixture, "/album", NULL, &results);
+    results_wait (&results);
+    g_assert_no_error (results.error);
+    g_assert_cmpuint (fixture->n_requests, ==, 1);
+
+    /* The second fetch is served from the cache. */
+    fetch (client, fixture, "/album", NULL, &results);
+    results_wait (&results);
+    g_assert_no_error (results.error);
+    assert_album_response (results.bytes);
+    g_assert_cmpuint (fixture->n_requests, ==, 1);
+
+    /* Failed requests are not cached. */
+    fetch (client, fixture, "/missing", NULL, &results);
+    results_wait (&results);
+    fetch (client, fixture, "/missing", NULL, &results);
+    results_wait (&results);
+    g_assert_cmpuint (fixture->n_requests, ==, 3);
+
+    /* Invalidated responses are fetched again. */
+    uri = fixture_get_uri (fixture, "/album");
+    et_cddb_client_invalidate (client, uri);
+    g_free (uri);
+
+    fetch (client, fixture, "/album", NULL, &results);
+    results_wait (&results);
+    g_assert_cmpuint (fixture->n_requests, ==, 4);
+
+    /* The cache survives the client. */
+    et_cddb_client_free (client);
+    client = et_cddb_client_new (session, cache_path, 2);
+
+    fetch (client, fixture, "/album", NULL, &results);
+    results_wait (&results);
+    assert_album_response (results.bytes);
+    g_assert_cmpuint (fixture->n_requests, ==, 4);
+
+    results_clear (&results);
+    et_cddb_client_free (client);
+    g_object_unref (session);
+
+    dir = g_dir_open (cache_path, 0, &error);
+    g_assert_no_error (error);
+
+    while ((name = g_dir_read_name (dir)) != NULL)
+    {
+        cache_file = g_build_filename (cache_path, name, NULL);
+        g_assert_cmpint (g_unlink (cache_file), ==, 0);
+        g_free (cache_file);
+    }
+
+    g_dir_close (dir);
+    g_assert_cmpint (g_rmdir (cache_path), ==, 0);
+    g_free (cache_path);
+}
+
+static void
+cddb_client_concurrency (Fixture *fixture,
+                         gconstpointer user_data)
+{
+    SoupSession *session;
+    EtCddbClient *client;
+    FetchResults results;
+    gsize i;
+
+    session = soup_session_new_with_options (SOUP_SESSION_MAX_CONNS_PER_HOST,
+                                             8, NULL);
+    client = et_cddb_client_new (session, NULL, 3);
+    results_init (&results);
+
+    for (i = 0; i < 10; i++)
+    {
+        gchar *path;
+
+        path = g_strdup_printf ("/slow/%" G_GSIZE_FORMAT, i);
+        fetch (client, fixture, path, NULL, &results);
+        g_free (path);
+    }
+
+    g_assert_cmpuint (et_cddb_client_get_n_active (client), ==, 3);
+    results_wait (&results);
+
+    g_assert_no_error (results.error);
+    g_assert_cmpuint (results.n_succeeded, ==, 10);
+    g_assert_cmpuint (fixture->n_requests, ==, 10);
+    g_assert_cmpuint (fixture->max_in_flight, ==, 3);
+    g_assert_cmpuint (et_cddb_client_get_n_active (client), ==, 0);
+
+    results_clear (&results);
+    et_cddb_client_free (client);
+    g_object_unref (session);
+}
+
+static void
+cddb_client_priority (Fixture *fixture,
+                      gconstpointer user_data)
+{
+    SoupSession *session;
+    EtCddbClient *client;
+    FetchResults results;
+
+    session = soup_session_new ();
+    client = et_cddb_client_new (session, NULL, 1);
+    results_init (&results);
+
+    /* The first request is sent at once, the others are queued, and sent
+     * in the order of their priority. */
+    fetch (client, fixture, "/slow/first", NULL, &results);
+    fetch_with_priority (client, fixture, "/slow/prefetch", G_PRIORITY_LOW,
+                         NULL, &results);
+    fetch (client, fixture, "/slow/selected", NULL, &results);
+    fetch_with_priority (client, fixture, "/slow/urgent", G_PRIORITY_HIGH,
+                         NULL, &results);
+    results_wait (&results);
+
+    g_assert_cmpuint (results.n_succeeded, ==, 4);
+    g_assert_cmpuint (fixture->paths->len, ==, 4);
+    g_assert_cmpstr (g_ptr_array_index (fixture->paths, 0), ==, "/slow/first");
+    g_assert_cmpstr (g_ptr_array_index (fixture->paths, 1), ==,
+                     "/slow/urgent");
+    g_assert_cmpstr (g_ptr_array_index (fixture->paths, 2), ==,
+                     "/slow/selected");
+    g_assert_cmpstr (g_ptr_array_index (fixture->paths, 3), ==,
+                     "/slow/prefetch");
+
+    results_clear (&results);
+    et_cddb_client_free (client);
+    g_object_unref (session);
+}
+
+static void
+cddb_client_cancel (Fixture *fixture,
+                    gconstpointer user_data)
+{
+    SoupSession *session;
+    EtCddbClient *client;
+    FetchResults results;
+    FetchResults queued;
+    GCancellable *cancellable;
+
+    session = soup_session_new ();
+    client = et_cddb_client_new (session, NULL, 1);
+    results_init (&results);
+    cancellable = g_cancellable_new ();
+
+    /* One active and one queued request. */
+    fetch (client, fixture, "/slow/1", cancellable, &results);
+    fetch (client, fixture, "/slow/2", cancellable, &results);
+    g_cancellable_cancel (cancellable);
+    results_wait (&results);
+
+    g_assert_error (results.error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+    g_assert_cmpuint (results.n_succeeded, ==, 0);
+    g_assert_cmpuint (et_cddb_client_get_n_active (client), ==, 0);
+
+    /* A queued request completes as soon as it is cancelled, while the
+     * active one is still in flight. */
+    g_clear_error (&results.error);
+    g_cancellable_reset (cancellable);
+    results_init (&queued);
+    fetch (client, fixture, "/slow/active", NULL, &results);
+    fetch (client, fixture, "/slow/queued", cancellable, &queued);
+    g_cancellable_cancel (cancellable);
+    results_wait (&queued);
+
+    g_assert_error (queued.error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+    g_assert_cmpuint (et_cddb_client_get_n_active (client), ==, 1);
+    results_clear (&queued);
+
+    results_wait (&results);
+    g_assert_no_error (results.error);
+    g_assert_cmpuint (results.n_succeeded, ==, 1);
+    g_assert_cmpstr (g_ptr_array_index (fixture->paths,
+                                        fixture->paths->len - 1), ==,
+                     "/slow/active");
+
+    /* Freeing the client cancels the remaining requests. */
+    results.n_succeeded = 0;
+    fetch (client, fixture, "/slow/3", NULL, &results);
+    fetch (client, fixture, "/slow/4", NULL, &results);
+    et_cddb_client_free (client);
+    results_wait (&results);
+
+    g_assert_error (results.error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+    g_assert_cmpuint (results.n_succeeded, ==, 0);
+
+    g_object_unref (cancellable);
+    results_clear (&results);
+    g_object_unref (session);
+}
+
+#endif /* SOUP_CHECK_VERSION (2, 48, 0) */
+
+int
+main (int argc, char** argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+#if SOUP_CHECK_VERSION (2, 48, 0)
+    g_test_add ("/cddb_client/fetch", Fixture, NULL, fixture_setup,
+                cddb_client_fetch, fixture_teardown);
+    g_test_add ("/cddb_client/cache", Fixture, NULL, fixture_setup,
+                cddb_client_cache, fixture_teardown);
+    g_test_add ("/cddb_client/concurrency", Fixture, NULL, fixture_setup,
+                cddb_client_concurrency, fixture_teardown);
+    g_test_add ("/cddb_client/priority", Fixture, NULL, fixture_setup,
+                cddb_client_priority, fixture_teardown);
+    g_test_add ("/cddb_client/cancel", Fixture, NULL, fixture_setup,
+                cddb_client_cancel, fixture_teardown);
+#endif /* SOUP_CHECK_VERSION (2, 48, 0) */
+
+    return g_test_run ();
+}
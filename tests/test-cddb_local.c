@@ -0,0 +1,318 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "cddb_local.h"
+
+#include <glib/gstdio.h>
+#include <string.h>
+
+#include "corpus.h"
+
+static const gchar noise_record[] = "# xmcd\n"
+                                    "#\n"
+                                    "DISCID=8f0dc00b\n"
+                                    "DTITLE=Archive / Noise\n"
+                                    "TTITLE0=Fool\n";
+
+static const gchar bjork_record[] = "# xmcd\n"
+                                    "DISCID=5a0b2c07,5a0b2c08\n"
+                                    "DTITLE=Bj\xc3\xb6rk / Homogenic (Limited \n"
+                                    "DTITLE=Edition)\n";
+
+static const gchar latin1_record[] = "# xmcd\n"
+                                     "DISCID=11223344\n"
+                                     "DTITLE=Mot\xf6rhead / Ace of Spades\n";
+
+static const gchar noise_live_record[] = "# xmcd\n"
+                                         "DISCID=9a0dc00b\n"
+                                         "DTITLE=Archive / Noise (Live)\n";
+
+static void
+write_record (const gchar *dump_path,
+              const gchar *category,
+              const gchar *name,
+              const gchar *contents)
+{
+    gchar *path;
+    GError *error = NULL;
+
+    path = g_build_filename (dump_path, category, NULL);
+    g_assert_cmpint (g_mkdir_with_parents (path, 0700), ==, 0);
+    g_free (path);
+
+    path = g_build_filename (dump_path, category, name, NULL);
+    g_file_set_contents (path, contents, -1, &error);
+    g_assert_no_error (error);
+    g_free (path);
+}
+
+static void
+remove_record (const gchar *dump_path,
+               const gchar *category,
+               const gchar *name)
+{
+    gchar *path;
+
+    path = g_build_filename (dump_path, category, name, NULL);
+    g_assert_cmpint (g_unlink (path), ==, 0);
+    g_free (path);
+}
+
+static void
+update_index (const gchar *dump_path,
+              const gchar *index_path)
+{
+    GError *error = NULL;
+
+    g_assert_true (et_cddb_local_update (dump_path, index_path, NULL,
+                                         &error));
+    g_assert_no_error (error);
+}
+
+static EtCddbLocal *
+open_index (const gchar *index_path)
+{
+    EtCddbLocal *local;
+    GError *error = NULL;
+
+    local = et_cddb_local_open (index_path, &error);
+    g_assert_no_error (error);
+    g_assert_nonnull (local);
+
+    return local;
+}
+
+static void
+assert_single_match (GList *matches,
+                     const gchar *category,
+                     guint32 disc_id,
+                     const gchar *title)
+{
+    EtCddbLocalMatch *match;
+
+    g_assert_cmpuint (g_list_length (matches), ==, 1);
+
+    match = matches->data;
+    g_assert_cmpstr (match->category, ==, category);
+    g_assert_cmphex (match->disc_id, ==, disc_id);
+    g_assert_cmpstr (match->title, ==, title);
+
+    g_list_free_full (matches, (GDestroyNotify)et_cddb_local_match_free);
+}
+
+static void
+cddb_local_directory (void)
+{
+    gchar *tmp_path;
+    gchar *dump_path;
+    gchar *index_path;
+    EtCddbLocal *local;
+    GList *matches;
+    GBytes *bytes;
+    GStatBuf statbuf;
+    ino_t inode;
+    const gchar * const jazz[] = { "jazz", NULL };
+    GError *error = NULL;
+
+    tmp_path = g_dir_make_tmp ("easytag-cddb-local-XXXXXX", &error);
+    g_assert_no_error (error);
+    dump_path = g_build_filename (tmp_path, "freedb", NULL);
+    index_path = g_build_filename (tmp_path, "cache", "cddb-local.index",
+                                   NULL);
+
+    write_record (dump_path, "rock", "8f0dc00b", noise_record);
+    write_record (dump_path, "misc", "5a0b2c07", bjork_record);
+    write_record (dump_path, "rock", "11223344", latin1_record);
+    /* The same album may be in several categories. */
+    write_record (dump_path, "jazz", "8f0dc00b", noise_record);
+    /* Files without a disc ID are skipped. */
+    write_record (dump_path, "rock", "README", "Not a record\n");
+
+    update_index (dump_path, index_path);
+    local = open_index (index_path);
+
+    g_assert_cmpstr (et_cddb_local_get_dump_path (local), ==, dump_path);
+    g_assert_cmpuint (et_cddb_local_get_n_records (local), ==, 4);
+
+    matches = et_cddb_local_lookup (local, 0x8f0dc00b);
+    g_assert_cmpuint (g_list_length (matches), ==, 2);
+    g_list_free_full (matches, (GDestroyNotify)et_cddb_local_match_free);
+
+    /* Each of the disc IDs of a record is indexed. */
+    assert_single_match (et_cddb_local_lookup (local, 0x5a0b2c08), "misc",
+                         0x5a0b2c08,
+                         "Bj\xc3\xb6rk / Homogenic (Limited Edition)");
+    g_assert_null (et_cddb_local_lookup (local, 0x12345678));
+
+    /* Searches ignore case and accents, and need all the words. */
+    assert_single_match (et_cddb_local_search (local, "BJORK+edition", NULL),
+                         "misc", 0x5a0b2c07,
+                         "Bj\xc3\xb6rk / Homogenic (Limited Edition)");
+    assert_single_match (et_cddb_local_search (local, "motorhead", NULL),
+                         "rock", 0x11223344,
+                         "Mot\xc3\xb6rhead / Ace of Spades");
+    assert_single_match (et_cddb_local_search (local, "archive noise", jazz),
+                         "jazz", 0x8f0dc00b, "Archive / Noise");
+    g_assert_null (et_cddb_local_search (local, "archive spades", NULL));
+    g_assert_null (et_cddb_local_search (local, "", NULL));
+
+    bytes = et_cddb_local_read (local, "rock", 0x8f0dc00b, &error);
+    g_assert_no_error (error);
+    g_assert_cmpuint (g_bytes_get_size (bytes), ==, strlen (noise_record));
+    g_assert_true (memcmp (g_bytes_get_data (bytes, NULL), noise_record,
+                           strlen (noise_record)) == 0);
+    g_bytes_unref (bytes);
+
+    g_assert_null (et_cddb_local_read (local, "blues", 0x8f0dc00b, &error));
+    g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+    g_clear_error (&error);
+
+    et_cddb_local_free (local);
+
+    /* The index is not rewritten if the dump did not change. */
+    g_assert_cmpint (g_stat (index_path, &statbuf), ==, 0);
+    inode = statbuf.st_ino;
+    update_index (dump_path, index_path);
+    g_assert_cmpint (g_stat (index_path, &statbuf), ==, 0);
+    g_assert_cmpuint (statbuf.st_ino, ==, inode);
+
+    /* Added, changed and removed files are picked up. */
+    write_record (dump_path, "rock", "9a0dc00b", noise_live_record);
+    write_record (dump_path, "misc", "5a0b2c07", latin1_record);
+    remove_record (dump_path, "jazz", "8f0dc00b");
+    update_index (dump_path, index_path);
+    local = open_index (index_path);
+
+    g_assert_cmpuint (et_cddb_local_get_n_records (local), ==, 4);
+    assert_single_match (et_cddb_local_lookup (local, 0x8f0dc00b), "rock",
+                         0x8f0dc00b, "Archive / Noise");
+    assert_single_match (et_cddb_local_lookup (local, 0x9a0dc00b), "rock",
+                         0x9a0dc00b, "Archive / Noise (Live)");
+    g_assert_null (et_cddb_local_lookup (local, 0x5a0b2c07));
+    matches = et_cddb_local_lookup (local, 0x11223344);
+    g_assert_cmpuint (g_list_length (matches), ==, 2);
+    g_list_free_full (matches, (GDestroyNotify)et_cddb_local_match_free);
+    g_assert_null (et_cddb_local_search (local, "bjork", NULL));
+
+    et_cddb_local_free (local);
+
+    et_corpus_remove_recursive (tmp_path);
+    g_free (index_path);
+    g_free (dump_path);
+    g_free (tmp_path);
+}
+
+static void
+write_tar_member (GString *tar,
+                  const gchar *name,
+                  const gchar *contents)
+{
+    gchar header[512];
+    gsize length = strlen (contents);
+    guint checksum = 0;
+    gsize i;
+
+    memset (header, 0, sizeof (header));
+    g_strlcpy (header, name, 100);
+    g_snprintf (header + 100, 8, "%07o", 0644);
+    g_snprintf (header + 124, 12, "%011o", (guint)length);
+    header[156] = '0';
+    memcpy (header + 257, "ustar", 6);
+    memcpy (header + 263, "00", 2);
+
+    /* The checksum is computed with the checksum field as spaces. */
+    memset (header + 148, ' ', 8);
+
+    for (i = 0; i < sizeof (header); i++)
+    {
+        checksum += (guchar)header[i];
+    }
+
+    g_snprintf (header + 148, 8, "%06o", checksum);
+
+    g_string_append_len (tar, header, sizeof (header));
+    g_string_append_len (tar, contents, length);
+
+    /* Pad to the next block. */
+    while (tar->len % 512 != 0)
+    {
+        g_string_append_c (tar, '\0');
+    }
+}
+
+static void
+cddb_local_tar (void)
+{
+    gchar *tmp_path;
+    gchar *dump_path;
+    gchar *index_path;
+    GString *tar;
+    EtCddbLocal *local;
+    GBytes *bytes;
+    GError *error = NULL;
+
+    tmp_path = g_dir_make_tmp ("easytag-cddb-local-XXXXXX", &error);
+    g_assert_no_error (error);
+    dump_path = g_build_filename (tmp_path, "freedb.tar", NULL);
+    index_path = g_build_filename (tmp_path, "cddb-local.index", NULL);
+
+    tar = g_string_new (NULL);
+    write_tar_member (tar, "freedb/rock/8f0dc00b", noise_record);
+    write_tar_member (tar, "freedb/misc/5a0b2c07", bjork_record);
+    write_tar_member (tar, "freedb/COPYING", "Not a record\n");
+    g_string_append_len (tar, "", 1);
+    g_string_set_size (tar, tar->len + 1023);
+    g_file_set_contents (dump_path, tar->str, tar->len, &error);
+    g_assert_no_error (error);
+    g_string_free (tar, TRUE);
+
+    update_index (dump_path, index_path);
+    local = open_index (index_path);
+
+    g_assert_cmpuint (et_cddb_local_get_n_records (local), ==, 2);
+    assert_single_match (et_cddb_local_lookup (local, 0x5a0b2c07), "misc",
+                         0x5a0b2c07,
+                         "Bj\xc3\xb6rk / Homogenic (Limited Edition)");
+    assert_single_match (et_cddb_local_search (local, "noise", NULL), "rock",
+                         0x8f0dc00b, "Archive / Noise");
+
+    bytes = et_cddb_local_read (local, "misc", 0x5a0b2c07, &error);
+    g_assert_no_error (error);
+    g_assert_cmpuint (g_bytes_get_size (bytes), ==, strlen (bjork_record));
+    g_assert_true (memcmp (g_bytes_get_data (bytes, NULL), bjork_record,
+                           strlen (bjork_record)) == 0);
+    g_bytes_unref (bytes);
+
+    et_cddb_local_free (local);
+
+    et_corpus_remove_recursive (tmp_path);
+    g_free (index_path);
+    g_free (dump_path);
+    g_free (tmp_path);
+}
+
+int
+main (int argc, char** argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/cddb_local/directory", cddb_local_directory);
+    g_test_add_func ("/cddb_local/tar", cddb_local_tar);
+
+    return g_test_run ();
+}
@@ -0,0 +1,314 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "directory_cache.h"
+
+#include <glib/gstdio.h>
+#include <string.h>
+
+#include "corpus.h"
+
+static gchar *
+create_tree (void)
+{
+    static const gchar * const dirs[] = { "b", "a", ".hidden", "c/child",
+                                          "a-hidden/.child" };
+    gchar *tmp_path;
+    gchar *path;
+    gsize i;
+    GError *error = NULL;
+
+    tmp_path = g_dir_make_tmp ("easytag-directory-cache-XXXXXX", &error);
+    g_assert_no_error (error);
+
+    for (i = 0; i < G_N_ELEMENTS (dirs); i++)
+    {
+        path = g_build_filename (tmp_path, dirs[i], NULL);
+        g_assert_cmpint (g_mkdir_with_parents (path, 0700), ==, 0);
+        g_free (path);
+    }
+
+    /* Files are not listed. */
+    path = g_build_filename (tmp_path, "file.mp3", NULL);
+    g_file_set_contents (path, "", 0, &error);
+    g_assert_no_error (error);
+    g_free (path);
+
+    return tmp_path;
+}
+
+static const EtDirectoryEntry *
+find_entry (GPtrArray *listing,
+            const gchar *name)
+{
+    guint i;
+
+    for (i = 0; i < listing->len; i++)
+    {
+        const EtDirectoryEntry *entry = g_ptr_array_index (listing, i);
+
+        if (strcmp (entry->name, name) == 0)
+        {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+static gint
+find_position (GPtrArray *listing,
+               const gchar *name)
+{
+    guint i;
+
+    for (i = 0; i < listing->len; i++)
+    {
+        const EtDirectoryEntry *entry = g_ptr_array_index (listing, i);
+
+        if (strcmp (entry->name, name) == 0)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static void
+directory_cache_list (void)
+{
+    gchar *tmp_path;
+    GFile *directory;
+    EtDirectoryCache *cache;
+    GPtrArray *listing;
+    GPtrArray *cached;
+    const EtDirectoryEntry *entry;
+    GError *error = NULL;
+
+    tmp_path = create_tree ();
+    directory = g_file_new_for_path (tmp_path);
+    cache = et_directory_cache_new ();
+
+    g_assert_null (et_directory_cache_lookup (cache, directory));
+
+    listing = et_directory_cache_list (cache, directory, NULL, &error);
+    g_assert_no_error (error);
+    g_assert_cmpuint (listing->len, ==, 5);
+
+    g_assert_cmpint (find_position (listing, "a"), <,
+                     find_position (listing, "b"));
+    g_assert_cmpint (find_position (listing, "b"), <,
+                     find_position (listing, "c"));
+
+    entry = find_entry (listing, ".hidden");
+    g_assert_nonnull (entry);
+    g_assert_true (entry->is_hidden);
+    g_assert_true (entry->can_read);
+
+    /* The link count may not be known, but must not be wrong. */
+    entry = find_entry (listing, "a");
+    g_assert_false (entry->is_hidden);
+    g_assert_cmpint (entry->subdirs, !=, ET_DIRECTORY_SUBDIRS_SOME);
+    entry = find_entry (listing, "c");
+    g_assert_cmpint (entry->subdirs, !=, ET_DIRECTORY_SUBDIRS_NONE);
+
+    cached = et_directory_cache_lookup (cache, directory);
+    g_assert_true (cached == listing);
+    g_ptr_array_unref (cached);
+    g_ptr_array_unref (listing);
+
+    et_directory_cache_clear (cache);
+    g_assert_null (et_directory_cache_lookup (cache, directory));
+
+    et_directory_cache_free (cache);
+    g_object_unref (directory);
+    et_corpus_remove_recursive (tmp_path);
+    g_free (tmp_path);
+}
+
+static void
+on_list_ready (GObject *source_object,
+               GAsyncResult *result,
+               gpointer user_data)
+{
+    GPtrArray **listing = user_data;
+    GError *error = NULL;
+
+    *listing = et_directory_cache_list_finish (result, &error);
+    g_assert_no_error (error);
+}
+
+static gboolean
+on_timeout (gpointer user_data)
+{
+    gboolean *timed_out = user_data;
+
+    *timed_out = TRUE;
+
+    return FALSE;
+}
+
+static void
+directory_cache_monitor (void)
+{
+    gchar *tmp_path;
+    gchar *path;
+    GFile *directory;
+    EtDirectoryCache *cache;
+    GPtrArray *listing = NULL;
+    GPtrArray *cached;
+    gboolean timed_out = FALSE;
+    guint timeout_id;
+
+    tmp_path = create_tree ();
+    directory = g_file_new_for_path (tmp_path);
+    cache = et_directory_cache_new ();
+
+    et_directory_cache_list_async (cache, directory, NULL, on_list_ready,
+                                   &listing);
+
+    while (listing == NULL)
+    {
+        g_main_context_iteration (NULL, TRUE);
+    }
+
+    g_assert_cmpuint (listing->len, ==, 5);
+
+    cached = et_directory_cache_lookup (cache, directory);
+    g_assert_true (cached == listing);
+    g_ptr_array_unref (cached);
+    g_ptr_array_unref (listing);
+
+    /* A new subdirectory invalidates the listing. */
+    path = g_build_filename (tmp_path, "d", NULL);
+    g_assert_cmpint (g_mkdir (path, 0700), ==, 0);
+    g_free (path);
+
+    timeout_id = g_timeout_add (5000, on_timeout, &timed_out);
+
+    while (!timed_out
+           && (cached = et_directory_cache_lookup (cache, directory)) != NULL)
+    {
+        g_ptr_array_unref (cached);
+        g_main_context_iteration (NULL, TRUE);
+    }
+
+    g_assert_false (timed_out);
+    g_source_remove (timeout_id);
+
+    listing = NULL;
+    et_directory_cache_list_async (cache, directory, NULL, on_list_ready,
+                                   &listing);
+
+    while (listing == NULL)
+    {
+        g_main_context_iteration (NULL, TRUE);
+    }
+
+    g_assert_cmpuint (listing->len, ==, 6);
+    g_assert_nonnull (find_entry (listing, "d"));
+    g_ptr_array_unref (listing);
+
+    et_directory_cache_free (cache);
+    g_object_unref (directory);
+    et_corpus_remove_recursive (tmp_path);
+    g_free (tmp_path);
+}
+
+static void
+on_probe_ready (GObject *source_object,
+                GAsyncResult *result,
+                gpointer user_data)
+{
+    GArray **results = user_data;
+    GError *error = NULL;
+
+    *results = et_directory_probe_finish (result, &error);
+    g_assert_no_error (error);
+}
+
+static GArray *
+probe (GPtrArray *directories,
+       gboolean show_hidden)
+{
+    GArray *results = NULL;
+
+    et_directory_probe_async (directories, show_hidden, NULL, on_probe_ready,
+                              &results);
+
+    while (results == NULL)
+    {
+        g_main_context_iteration (NULL, TRUE);
+    }
+
+    g_assert_cmpuint (results->len, ==, directories->len);
+
+    return results;
+}
+
+static void
+directory_cache_probe (void)
+{
+    static const gchar * const names[] = { "a", "c", "a-hidden", "missing" };
+    gchar *tmp_path;
+    GFile *directory;
+    GPtrArray *directories;
+    GArray *results;
+    gsize i;
+
+    tmp_path = create_tree ();
+    directory = g_file_new_for_path (tmp_path);
+    directories = g_ptr_array_new_with_free_func (g_object_unref);
+
+    for (i = 0; i < G_N_ELEMENTS (names); i++)
+    {
+        g_ptr_array_add (directories, g_file_get_child (directory, names[i]));
+    }
+
+    results = probe (directories, FALSE);
+    g_assert_false (g_array_index (results, gboolean, 0));
+    g_assert_true (g_array_index (results, gboolean, 1));
+    g_assert_false (g_array_index (results, gboolean, 2));
+    g_assert_false (g_array_index (results, gboolean, 3));
+    g_array_unref (results);
+
+    results = probe (directories, TRUE);
+    g_assert_false (g_array_index (results, gboolean, 0));
+    g_assert_true (g_array_index (results, gboolean, 1));
+    g_assert_true (g_array_index (results, gboolean, 2));
+    g_assert_false (g_array_index (results, gboolean, 3));
+    g_array_unref (results);
+
+    g_ptr_array_unref (directories);
+    g_object_unref (directory);
+    et_corpus_remove_recursive (tmp_path);
+    g_free (tmp_path);
+}
+
+int
+main (int argc, char** argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/directory_cache/list", directory_cache_list);
+    g_test_add_func ("/directory_cache/monitor", directory_cache_monitor);
+    g_test_add_func ("/directory_cache/probe", directory_cache_probe);
+
+    return g_test_run ();
+}
@@ -0,0 +1,190 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "directory_watch.h"
+
+#include <glib/gstdio.h>
+
+static gboolean
+on_timeout (gpointer user_data)
+{
+    gboolean *timed_out = user_data;
+
+    *timed_out = TRUE;
+
+    return FALSE;
+}
+
+static gboolean
+contains_file (GPtrArray *changes,
+               GFile *file)
+{
+    guint i;
+
+    for (i = 0; i < changes->len; i++)
+    {
+        if (g_file_equal (g_ptr_array_index (changes, i), file))
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/* Wait until both @first and @second were reported as changed. */
+static void
+wait_for_changes (EtDirectoryWatch *watch,
+                  GFile *first,
+                  GFile *second)
+{
+    GPtrArray *changes;
+    gboolean found_first = FALSE;
+    gboolean found_second = FALSE;
+    gboolean timed_out = FALSE;
+    guint timeout_id;
+
+    timeout_id = g_timeout_add (5000, on_timeout, &timed_out);
+
+    while (!timed_out && !(found_first && found_second))
+    {
+        g_main_context_iteration (NULL, TRUE);
+
+        changes = et_directory_watch_take_changes (watch);
+        found_first |= contains_file (changes, first);
+        found_second |= contains_file (changes, second);
+        g_ptr_array_unref (changes);
+    }
+
+    g_assert_false (timed_out);
+    g_source_remove (timeout_id);
+}
+
+static void
+directory_watch_changes (void)
+{
+    gchar *tmp_path;
+    gchar *path;
+    GFile *directory;
+    GFile *subdir;
+    GFile *added;
+    GFile *modified;
+    EtDirectoryWatch *watch;
+    GPtrArray *changes;
+    GError *error = NULL;
+
+    tmp_path = g_dir_make_tmp ("easytag-directory-watch-XXXXXX", &error);
+    g_assert_no_error (error);
+    directory = g_file_new_for_path (tmp_path);
+    subdir = g_file_get_child (directory, "subdir");
+    added = g_file_get_child (subdir, "added.mp3");
+    modified = g_file_get_child (directory, "modified.mp3");
+
+    path = g_file_get_path (subdir);
+    g_assert_cmpint (g_mkdir (path, 0700), ==, 0);
+    g_free (path);
+
+    path = g_file_get_path (modified);
+    g_file_set_contents (path, "", 0, &error);
+    g_assert_no_error (error);
+    g_free (path);
+
+    watch = et_directory_watch_new ();
+    et_directory_watch_add (watch, directory);
+    et_directory_watch_add (watch, subdir);
+    g_assert_true (et_directory_watch_is_valid (watch));
+
+    changes = et_directory_watch_take_changes (watch);
+    g_assert_cmpuint (changes->len, ==, 0);
+    g_ptr_array_unref (changes);
+
+    /* A file added to a subdirectory, and a file changed in the loaded
+     * directory. */
+    path = g_file_get_path (added);
+    g_file_set_contents (path, "", 0, &error);
+    g_assert_no_error (error);
+    g_free (path);
+
+    path = g_file_get_path (modified);
+    g_file_set_contents (path, "ID3", 3, &error);
+    g_assert_no_error (error);
+    g_free (path);
+
+    wait_for_changes (watch, added, modified);
+
+    /* Removed files are reported too, and the files of a removed directory
+     * may only be reported as the directory itself. */
+    path = g_file_get_path (added);
+    g_assert_cmpint (g_unlink (path), ==, 0);
+    g_free (path);
+
+    path = g_file_get_path (subdir);
+    g_assert_cmpint (g_rmdir (path), ==, 0);
+    g_free (path);
+
+    path = g_file_get_path (modified);
+    g_assert_cmpint (g_unlink (path), ==, 0);
+    g_free (path);
+
+    wait_for_changes (watch, subdir, modified);
+
+    et_directory_watch_free (watch);
+    g_assert_cmpint (g_rmdir (tmp_path), ==, 0);
+
+    g_object_unref (modified);
+    g_object_unref (added);
+    g_object_unref (subdir);
+    g_object_unref (directory);
+    g_free (tmp_path);
+}
+
+static void
+directory_watch_unwatched (void)
+{
+    GFile *missing;
+    EtDirectoryWatch *watch;
+    GPtrArray *changes;
+
+    /* A directory which cannot be monitored is always reported. */
+    missing = g_file_new_for_uri ("resource:///missing");
+    watch = et_directory_watch_new ();
+    et_directory_watch_add (watch, missing);
+
+    changes = et_directory_watch_take_changes (watch);
+    g_assert_cmpuint (changes->len, ==, 1);
+    g_assert_true (contains_file (changes, missing));
+    g_ptr_array_unref (changes);
+
+    changes = et_directory_watch_take_changes (watch);
+    g_assert_cmpuint (changes->len, ==, 1);
+    g_ptr_array_unref (changes);
+
+    et_directory_watch_free (watch);
+    g_object_unref (missing);
+}
+
+int
+main (int argc, char** argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/directory_watch/changes", directory_watch_changes);
+    g_test_add_func ("/directory_watch/unwatched", directory_watch_unwatched);
+
+    return g_test_run ();
+}
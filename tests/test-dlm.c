@@ -18,6 +18,90 @@
 
 #include "dlm.h"
 
+#include <string.h>
+
+/* Straightforward dynamic programming version of the optimal string
+ * alignment distance, to check the bit-parallel version against. */
+static gint
+reference_distance (const gchar *s,
+                    const gchar *t)
+{
+    gunichar *a;
+    gunichar *b;
+    glong n;
+    glong m;
+    gint *d;
+    glong i;
+    glong j;
+    gint result;
+
+    a = g_utf8_to_ucs4_fast (s, -1, &n);
+    b = g_utf8_to_ucs4_fast (t, -1, &m);
+    d = g_new (gint, (n + 1) * (m + 1));
+
+#define D(i, j) d[(i) * (m + 1) + (j)]
+    for (i = 0; i <= n; i++)
+    {
+        D (i, 0) = i;
+    }
+
+    for (j = 0; j <= m; j++)
+    {
+        D (0, j) = j;
+    }
+
+    for (i = 1; i <= n; i++)
+    {
+        for (j = 1; j <= m; j++)
+        {
+            gint value;
+
+            value = MIN (D (i - 1, j) + 1, D (i, j - 1) + 1);
+            value = MIN (value, D (i - 1, j - 1) + (a[i - 1] != b[j - 1]));
+
+            if (i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1])
+            {
+                value = MIN (value, D (i - 2, j - 2) + 1);
+            }
+
+            D (i, j) = value;
+        }
+    }
+
+    result = D (n, m);
+#undef D
+
+    g_free (d);
+    g_free (b);
+    g_free (a);
+
+    return result;
+}
+
+static gchar *
+random_string (GRand *rand,
+               gint max_length)
+{
+    /* A small alphabet, to have many matches and transpositions, with
+     * characters outside of Latin-1. */
+    static const gchar * const alphabet[] = { "a", "b", "c", "é", "ж", "€" };
+    GString *string;
+    gint length;
+    gint i;
+
+    string = g_string_new (NULL);
+    length = g_rand_int_range (rand, 0, max_length + 1);
+
+    for (i = 0; i < length; i++)
+    {
+        g_string_append (string,
+                         alphabet[g_rand_int_range (rand, 0,
+                                                    G_N_ELEMENTS (alphabet))]);
+    }
+
+    return g_string_free (string, FALSE);
+}
+
 static void
 dlm_dlm (void)
 {
@@ -55,6 +139,100 @@ dlm_dlm (void)
     }
 }
 
+static void
+dlm_distance (void)
+{
+    GRand *rand;
+    gsize i;
+
+    static const struct
+    {
+        const gchar *str1;
+        const gchar *str2;
+        const gint distance;
+    } strings[] =
+    {
+        { "foo", "foo", 0 },
+        { "FOO", "foo", 0 },
+        { "bar", "bra", 1 },
+        { "ca", "abc", 3 },
+        { "", "abc", 3 },
+        { "Straße", "STRASSE", 0 },
+        /* One character each, not one per byte. */
+        { "été", "ete", 2 },
+    };
+
+    for (i = 0; i < G_N_ELEMENTS (strings); i++)
+    {
+        g_assert_cmpint (et_dlm_distance (strings[i].str1, strings[i].str2,
+                                          -1), ==, strings[i].distance);
+    }
+
+    /* Beyond the threshold, the search stops. */
+    g_assert_cmpint (et_dlm_distance ("foobarbaz", "zabraboof", 7), ==, 7);
+    g_assert_cmpint (et_dlm_distance ("foobarbaz", "zabraboof", 6), ==, -1);
+    g_assert_cmpint (et_dlm_distance ("foo", "foobarbaz", 5), ==, -1);
+
+    rand = g_rand_new_with_seed (42);
+
+    /* Cover patterns of several words. */
+    for (i = 0; i < 2000; i++)
+    {
+        gchar *str1 = random_string (rand, i < 1000 ? 10 : 200);
+        gchar *str2 = random_string (rand, i < 1000 ? 10 : 200);
+        const gint expected = reference_distance (str1, str2);
+
+        g_assert_cmpint (et_dlm_distance (str1, str2, -1), ==, expected);
+        g_assert_cmpint (et_dlm_distance (str1, str2, expected), ==,
+                         expected);
+
+        if (expected > 0)
+        {
+            g_assert_cmpint (et_dlm_distance (str1, str2, expected - 1), ==,
+                             -1);
+        }
+
+        g_free (str2);
+        g_free (str1);
+    }
+
+    g_rand_free (rand);
+}
+
+static void
+dlm_corpus (void)
+{
+    EtDlmCorpus *corpus;
+    gint metric;
+
+    corpus = et_dlm_corpus_new ();
+
+    et_dlm_corpus_set (corpus, 0, "01 - Intro.mp3");
+    et_dlm_corpus_set (corpus, 1, "Foobarbaz");
+    et_dlm_corpus_set (corpus, 3, "Foobazbar");
+    g_assert_cmpuint (et_dlm_corpus_get_size (corpus), ==, 4);
+
+    g_assert_cmpint (et_dlm_corpus_find_best (corpus, "foobarbaz", &metric),
+                     ==, 1);
+    g_assert_cmpint (metric, ==, 1000);
+    g_assert_cmpint (et_dlm_corpus_find_best (corpus, "foobazbaz", &metric),
+                     ==, 1);
+    g_assert_cmpint (metric, ==, dlm ("foobazbaz", "Foobarbaz"));
+    g_assert_cmpint (et_dlm_corpus_find_best (corpus, "xyz", &metric), ==,
+                     -1);
+    g_assert_cmpint (et_dlm_corpus_find_best (corpus, "", NULL), ==, -1);
+
+    et_dlm_corpus_set (corpus, 1, NULL);
+    g_assert_cmpint (et_dlm_corpus_find_best (corpus, "foobarbaz", NULL), ==,
+                     3);
+
+    et_dlm_corpus_set_size (corpus, 1);
+    g_assert_cmpint (et_dlm_corpus_find_best (corpus, "foobarbaz", NULL), ==,
+                     -1);
+
+    et_dlm_corpus_free (corpus);
+}
+
 static void
 dlm_perf_dlm (void)
 {
@@ -74,16 +252,77 @@ dlm_perf_dlm (void)
     g_test_minimized_result (time, "%6.1f seconds", time);
 }
 
+static void
+dlm_perf_corpus (void)
+{
+    EtDlmCorpus *corpus;
+    gchar **titles;
+    const guint N_TITLES = 20000;
+    const guint N_QUERIES = 20;
+    GRand *rand;
+    gdouble time;
+    guint i;
+
+    static const gchar * const words[] = { "love", "night", "the", "blue",
+                                           "song", "of", "a", "river",
+                                           "summer", "heart", "Straße",
+                                           "été", "ночь" };
+
+    rand = g_rand_new_with_seed (42);
+    titles = g_new0 (gchar *, N_TITLES + 1);
+    corpus = et_dlm_corpus_new ();
+
+    for (i = 0; i < N_TITLES; i++)
+    {
+        GString *title = g_string_new (NULL);
+        gint n_words = g_rand_int_range (rand, 1, 6);
+
+        while (n_words--)
+        {
+            g_string_append (title,
+                             words[g_rand_int_range (rand, 0,
+                                                     G_N_ELEMENTS (words))]);
+            g_string_append_c (title, ' ');
+        }
+
+        g_string_append_printf (title, "%u", i);
+        titles[i] = g_string_free (title, FALSE);
+        et_dlm_corpus_set (corpus, i, titles[i]);
+    }
+
+    g_test_timer_start ();
+
+    for (i = 0; i < N_QUERIES; i++)
+    {
+        const guint target = g_rand_int_range (rand, 0, N_TITLES);
+
+        g_assert_cmpint (et_dlm_corpus_find_best (corpus, titles[target],
+                                                  NULL), ==, target);
+    }
+
+    time = g_test_timer_elapsed ();
+
+    g_test_minimized_result (time, "%6.3f seconds for %u queries against %u strings",
+                             time, N_QUERIES, N_TITLES);
+
+    et_dlm_corpus_free (corpus);
+    g_strfreev (titles);
+    g_rand_free (rand);
+}
+
 int
 main (int argc, char** argv)
 {
     g_test_init (&argc, &argv, NULL);
 
     g_test_add_func ("/dlm/dlm", dlm_dlm);
+    g_test_add_func ("/dlm/distance", dlm_distance);
+    g_test_add_func ("/dlm/corpus", dlm_corpus);
 
     if (g_test_perf ())
     {
         g_test_add_func ("/dlm/perf/dlm", dlm_perf_dlm);
+        g_test_add_func ("/dlm/perf/corpus", dlm_perf_corpus);
     }
 
     return g_test_run ();
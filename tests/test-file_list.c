@@ -0,0 +1,379 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "file_list_changes.h"
+
+#include <glib/gstdio.h>
+
+#include "corpus.h"
+#include "et_core.h"
+#include "file.h"
+#include "file_list.h"
+#include "file_tag.h"
+#include "setting.h"
+
+/* Create the file @name in @dirname, containing @contents. */
+static gchar *
+create_file (const gchar *dirname,
+             const gchar *name,
+             const gchar *contents)
+{
+    gchar *filepath;
+    GError *error = NULL;
+
+    filepath = g_build_filename (dirname, name, NULL);
+    g_file_set_contents (filepath, contents, -1, &error);
+    g_assert_no_error (error);
+
+    return filepath;
+}
+
+/* A loaded file for @filepath, with its modification time and size, as
+ * et_file_list_add() stores them. */
+static ET_File *
+load_file (const gchar *filepath)
+{
+    ET_File *ETFile;
+    File_Name *file_name;
+    GFile *file;
+    GFileInfo *info;
+    GError *error = NULL;
+
+    file = g_file_new_for_path (filepath);
+    info = g_file_query_info (file,
+                              G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                              G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                              G_FILE_QUERY_INFO_NONE, NULL, &error);
+    g_assert_no_error (error);
+
+    file_name = et_file_name_new ();
+    ET_Set_Filename_File_Name_Item (file_name, NULL, filepath);
+
+    ETFile = g_slice_new0 (ET_File);
+    ETFile->FileModificationTime = g_file_info_get_attribute_uint64 (info,
+                                                                     G_FILE_ATTRIBUTE_TIME_MODIFIED);
+    ETFile->ETFileInfo = et_file_info_new ();
+    ETFile->ETFileInfo->size = g_file_info_get_size (info);
+    ETFile->FileNameList = g_list_append (NULL, file_name);
+    ETFile->FileNameCur = ETFile->FileNameList;
+    ETFile->FileNameNew = ETFile->FileNameList;
+
+    g_object_unref (info);
+    g_object_unref (file);
+
+    return ETFile;
+}
+
+static void
+free_file (ET_File *ETFile)
+{
+    g_list_free_full (ETFile->FileNameList, (GDestroyNotify)et_file_name_free);
+    et_file_info_free (ETFile->ETFileInfo);
+    g_slice_free (ET_File, ETFile);
+}
+
+static gboolean
+contains_path (GList *files,
+               const gchar *filepath)
+{
+    GList *l;
+
+    for (l = files; l != NULL; l = g_list_next (l))
+    {
+        gchar *path = g_file_get_path (l->data);
+        gboolean found = g_strcmp0 (path, filepath) == 0;
+
+        g_free (path);
+
+        if (found)
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+static void
+file_list_find_changes (void)
+{
+    gchar *dirname;
+    gchar *unchanged_path;
+    gchar *modified_path;
+    gchar *removed_path;
+    gchar *renamed_path;
+    gchar *renamed_new_path;
+    gchar *added_path;
+    gchar *ignored_path;
+    ET_File *unchanged;
+    ET_File *modified;
+    ET_File *removed;
+    ET_File *renamed;
+    GList *file_list = NULL;
+    GFile *root;
+    GPtrArray *changes;
+    GList *removed_files;
+    GList *added_files;
+    GError *error = NULL;
+
+    dirname = g_dir_make_tmp ("easytag-file-list-XXXXXX", &error);
+    g_assert_no_error (error);
+
+    unchanged_path = create_file (dirname, "unchanged.mpc", "unchanged");
+    modified_path = create_file (dirname, "modified.mpc", "modified");
+    removed_path = create_file (dirname, "removed.mpc", "removed");
+    renamed_path = create_file (dirname, "renamed.mpc", "renamed");
+    renamed_new_path = g_build_filename (dirname, "renamed-new.mpc", NULL);
+
+    unchanged = load_file (unchanged_path);
+    modified = load_file (modified_path);
+    removed = load_file (removed_path);
+    renamed = load_file (renamed_path);
+    file_list = g_list_append (file_list, unchanged);
+    file_list = g_list_append (file_list, modified);
+    file_list = g_list_append (file_list, removed);
+    file_list = g_list_append (file_list, renamed);
+
+    /* The size changes even if the modification time does not, within the
+     * same second. */
+    g_free (create_file (dirname, "modified.mpc", "modified again"));
+    g_assert_cmpint (g_remove (removed_path), ==, 0);
+    g_assert_cmpint (g_rename (renamed_path, renamed_new_path), ==, 0);
+    added_path = create_file (dirname, "added.mpc", "added");
+    /* Not a supported file. */
+    ignored_path = create_file (dirname, "ignored.txt", "ignored");
+
+    root = g_file_new_for_path (dirname);
+    changes = g_ptr_array_new_with_free_func (g_object_unref);
+
+    /* Only the unchanged file changed. */
+    g_ptr_array_add (changes, g_file_new_for_path (unchanged_path));
+    et_file_list_find_changes (file_list, root, changes, FALSE, FALSE, NULL,
+                               &removed_files, &added_files);
+    g_assert_null (removed_files);
+    g_assert_null (added_files);
+
+    /* The whole directory changed. */
+    g_ptr_array_set_size (changes, 0);
+    g_ptr_array_add (changes, g_object_ref (root));
+    et_file_list_find_changes (file_list, root, changes, FALSE, FALSE, NULL,
+                               &removed_files, &added_files);
+
+    g_assert_cmpuint (g_list_length (removed_files), ==, 3);
+    g_assert_nonnull (g_list_find (removed_files, modified));
+    g_assert_nonnull (g_list_find (removed_files, removed));
+    g_assert_nonnull (g_list_find (removed_files, renamed));
+    g_assert_null (g_list_find (removed_files, unchanged));
+
+    g_assert_cmpuint (g_list_length (added_files), ==, 3);
+    g_assert_true (contains_path (added_files, modified_path));
+    g_assert_true (contains_path (added_files, renamed_new_path));
+    g_assert_true (contains_path (added_files, added_path));
+
+    g_list_free (removed_files);
+    g_list_free_full (added_files, g_object_unref);
+
+    g_ptr_array_unref (changes);
+    g_object_unref (root);
+    g_list_free_full (file_list, (GDestroyNotify)free_file);
+
+    g_assert_cmpint (g_remove (unchanged_path), ==, 0);
+    g_assert_cmpint (g_remove (modified_path), ==, 0);
+    g_assert_cmpint (g_remove (renamed_new_path), ==, 0);
+    g_assert_cmpint (g_remove (added_path), ==, 0);
+    g_assert_cmpint (g_remove (ignored_path), ==, 0);
+    g_assert_cmpint (g_rmdir (dirname), ==, 0);
+
+    g_free (ignored_path);
+    g_free (added_path);
+    g_free (renamed_new_path);
+    g_free (renamed_path);
+    g_free (removed_path);
+    g_free (modified_path);
+    g_free (unchanged_path);
+    g_free (dirname);
+}
+
+static GList *
+history_append (GList *history_list,
+                ET_File *ETFile)
+{
+    ET_History_File *item;
+
+    item = g_slice_new0 (ET_History_File);
+    item->ETFile = ETFile;
+
+    return g_list_append (history_list, item);
+}
+
+static void
+history_list_remove_file (void)
+{
+    ET_File *first;
+    ET_File *second;
+    ET_File *third;
+    GList *history_list;
+    GList *current;
+
+    first = g_slice_new0 (ET_File);
+    second = g_slice_new0 (ET_File);
+    third = g_slice_new0 (ET_File);
+
+    /* The first item has no file. */
+    history_list = history_append (NULL, NULL);
+    history_list = history_append (history_list, first);
+    history_list = history_append (history_list, second);
+    history_list = history_append (history_list, first);
+    history_list = history_append (history_list, third);
+
+    /* The current item is kept if it does not refer to the file. */
+    current = g_list_nth (history_list, 2);
+    current = et_history_list_remove_file (current, first);
+    g_assert_cmpuint (g_list_length (history_list), ==, 3);
+    g_assert_true (((ET_History_File *)current->data)->ETFile == second);
+    g_assert_true (g_list_first (current) == history_list);
+    g_assert_true (((ET_History_File *)history_list->next->next->data)->ETFile
+                   == third);
+
+    /* Otherwise, it is moved back. */
+    current = et_history_list_remove_file (current, second);
+    g_assert_cmpuint (g_list_length (history_list), ==, 2);
+    g_assert_true (current == history_list);
+
+    current = g_list_last (history_list);
+    current = et_history_list_remove_file (current, third);
+    g_assert_cmpuint (g_list_length (history_list), ==, 1);
+    g_assert_true (current == history_list);
+    g_assert_null (((ET_History_File *)current->data)->ETFile);
+
+    /* An empty list stays empty. */
+    g_assert_null (et_history_list_remove_file (NULL, first));
+
+    g_list_free_full (history_list, (GDestroyNotify)et_history_file_free);
+    g_slice_free (ET_File, third);
+    g_slice_free (ET_File, second);
+    g_slice_free (ET_File, first);
+}
+
+static gboolean
+is_marked_changed (const ET_File *ETFile)
+{
+    return g_hash_table_contains (ETCore->ETFileChangedKeys,
+                                  GUINT_TO_POINTER (ETFile->ETFileKey));
+}
+
+static void
+core_mark_file_changed (void)
+{
+    gchar *dirname;
+    gchar *filepath;
+    GFile *file;
+    GList *file_list;
+    ET_File *ETFile;
+    File_Tag *FileTag;
+    GError *error = NULL;
+
+    dirname = g_dir_make_tmp ("easytag-file-list-XXXXXX", &error);
+    g_assert_no_error (error);
+    filepath = g_build_filename (dirname, "file.ape", NULL);
+    et_corpus_write_audio (ET_CORPUS_FORMAT_MONKEYS_AUDIO, filepath, &error);
+    g_assert_no_error (error);
+
+    file = g_file_new_for_path (filepath);
+    file_list = et_file_list_add (NULL, file);
+    g_object_unref (file);
+    g_assert_cmpuint (g_list_length (file_list), ==, 1);
+    ETFile = file_list->data;
+
+    ET_Core_Create ();
+    g_assert_cmpuint (g_hash_table_size (ETCore->ETFileChangedKeys), ==, 0);
+
+    /* A tag without changes does not mark the file. */
+    FileTag = et_file_tag_new ();
+    et_file_tag_copy_into (FileTag, ETFile->FileTag->data);
+    g_assert_false (ET_Manage_Changes_Of_File_Data (ETFile, NULL, FileTag));
+    g_assert_cmpuint (g_hash_table_size (ETCore->ETFileChangedKeys), ==, 0);
+
+    FileTag = et_file_tag_new ();
+    et_file_tag_copy_into (FileTag, ETFile->FileTag->data);
+    et_file_tag_set_title (FileTag, "Edited");
+    g_assert_true (ET_Manage_Changes_Of_File_Data (ETFile, NULL, FileTag));
+    g_assert_cmpuint (g_hash_table_size (ETCore->ETFileChangedKeys), ==, 1);
+    g_assert_true (is_marked_changed (ETFile));
+
+    /* As after refreshing the browser list. */
+    g_hash_table_remove_all (ETCore->ETFileChangedKeys);
+
+    g_assert_true (ET_Undo_File_Data (ETFile));
+    g_assert_true (is_marked_changed (ETFile));
+    g_hash_table_remove_all (ETCore->ETFileChangedKeys);
+
+    /* There is nothing left to undo. */
+    g_assert_false (ET_Undo_File_Data (ETFile));
+    g_assert_cmpuint (g_hash_table_size (ETCore->ETFileChangedKeys), ==, 0);
+
+    g_assert_true (ET_Redo_File_Data (ETFile));
+    g_assert_true (is_marked_changed (ETFile));
+    g_hash_table_remove_all (ETCore->ETFileChangedKeys);
+
+    g_assert_true (ET_Save_File_Tag_To_HD (ETFile, &error));
+    g_assert_no_error (error);
+    g_assert_cmpuint (g_hash_table_size (ETCore->ETFileChangedKeys), ==, 1);
+    g_assert_true (is_marked_changed (ETFile));
+    g_hash_table_remove_all (ETCore->ETFileChangedKeys);
+
+    ET_Mark_File_Name_As_Saved (ETFile);
+    g_assert_true (is_marked_changed (ETFile));
+
+    ET_Core_Free ();
+    et_file_list_free (file_list);
+
+    et_corpus_remove_recursive (dirname);
+    g_free (filepath);
+    g_free (dirname);
+}
+
+int
+main (int argc, char** argv)
+{
+    gchar *config_path;
+    gint status;
+    GError *error = NULL;
+
+    /* Keep the log and settings of the user out of the tests. */
+    config_path = g_dir_make_tmp ("easytag-file-list-config-XXXXXX", &error);
+    g_assert_no_error (error);
+    g_setenv ("XDG_CONFIG_HOME", config_path, TRUE);
+    g_setenv ("GSETTINGS_BACKEND", "memory", TRUE);
+    g_setenv ("GSETTINGS_SCHEMA_DIR", TEST_SCHEMA_DIR, TRUE);
+
+    g_test_init (&argc, &argv, NULL);
+
+    Init_Config_Variables ();
+
+    g_test_add_func ("/file_list/find_changes", file_list_find_changes);
+    g_test_add_func ("/history_list/remove_file", history_list_remove_file);
+    g_test_add_func ("/core/mark_file_changed", core_mark_file_changed);
+
+    status = g_test_run ();
+
+    et_corpus_remove_recursive (config_path);
+    g_free (config_path);
+
+    return status;
+}
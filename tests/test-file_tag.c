@@ -20,6 +20,7 @@
 
 #include "misc.h"
 #include "picture.h"
+#include "setting.h"
 
 GtkWidget *MainWindow;
 GSettings *MainSettings;
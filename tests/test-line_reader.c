@@ -0,0 +1,140 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "line_reader.h"
+
+#include <string.h>
+
+static EtLineReader *
+create_reader (const gchar *data,
+               gsize length)
+{
+    GInputStream *stream;
+    EtLineReader *reader;
+
+    stream = g_memory_input_stream_new_from_data (data, length, NULL);
+    reader = et_line_reader_new (stream);
+    g_object_unref (stream);
+
+    return reader;
+}
+
+static void
+check_line (EtLineReader *reader,
+            const gchar *expected)
+{
+    const gchar *line;
+    gsize length;
+    GError *error = NULL;
+
+    line = et_line_reader_next (reader, &length, NULL, &error);
+    g_assert_no_error (error);
+
+    if (expected == NULL)
+    {
+        g_assert (line == NULL);
+    }
+    else
+    {
+        g_assert_cmpstr (line, ==, expected);
+        g_assert_cmpuint (length, ==, strlen (expected));
+    }
+}
+
+static void
+line_reader_endings (void)
+{
+    static const gchar data[] = "one\ntwo\r\nthree\rfour\n\n\r\r\nfive";
+    EtLineReader *reader;
+
+    reader = create_reader (data, strlen (data));
+    check_line (reader, "one");
+    check_line (reader, "two");
+    check_line (reader, "three");
+    check_line (reader, "four");
+    check_line (reader, "");
+    check_line (reader, "");
+    check_line (reader, "");
+    check_line (reader, "five");
+    check_line (reader, NULL);
+    check_line (reader, NULL);
+    et_line_reader_free (reader);
+
+    reader = create_reader ("last\r\n", 6);
+    check_line (reader, "last");
+    check_line (reader, NULL);
+    et_line_reader_free (reader);
+
+    reader = create_reader ("", 0);
+    check_line (reader, NULL);
+    et_line_reader_free (reader);
+}
+
+static void
+line_reader_long (void)
+{
+    GString *data;
+    gchar *long_line;
+    EtLineReader *reader;
+    guint i;
+
+    /* Enough lines, with each line ending, to cross the buffer boundaries,
+     * and a line longer than the buffer. */
+    data = g_string_new (NULL);
+
+    for (i = 0; i < 20000; i++)
+    {
+        static const gchar * const endings[] = { "\n", "\r\n", "\r" };
+
+        g_string_append_printf (data, "line %u%s", i, endings[i % 3]);
+    }
+
+    long_line = g_strnfill (100000, 'a');
+    g_string_append (data, long_line);
+    g_string_append (data, "\r\nend");
+
+    reader = create_reader (data->str, data->len);
+
+    for (i = 0; i < 20000; i++)
+    {
+        gchar *expected;
+
+        expected = g_strdup_printf ("line %u", i);
+        check_line (reader, expected);
+        g_free (expected);
+    }
+
+    check_line (reader, long_line);
+    check_line (reader, "end");
+    check_line (reader, NULL);
+
+    et_line_reader_free (reader);
+    g_free (long_line);
+    g_string_free (data, TRUE);
+}
+
+int
+main (int argc, char** argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/line_reader/endings", line_reader_endings);
+    g_test_add_func ("/line_reader/long", line_reader_long);
+
+    return g_test_run ();
+}
@@ -17,6 +17,7 @@
  */
 
 #include "misc.h"
+#include "setting.h"
 
 #include <glib/gstdio.h>
 
@@ -0,0 +1,443 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "mpeg_probe.h"
+
+#include <fcntl.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/* An MPEG-1 Layer III frame header, 128 kb/s, 44.1 kHz. */
+static const guchar frame_header[] = { 0xFF, 0xFB, 0x90, 0x00 };
+
+static gchar *
+create_fixture (const gchar *name,
+                const guchar *data,
+                gsize length)
+{
+    gchar *path;
+    GError *error = NULL;
+
+    path = g_build_filename (g_get_tmp_dir (), name, NULL);
+    g_file_set_contents (path, (const gchar *)data, length, &error);
+    g_assert_no_error (error);
+
+    return path;
+}
+
+static gboolean
+probe_path (const gchar *path,
+            GError **error)
+{
+    GFile *file;
+    gboolean result;
+
+    file = g_file_new_for_path (path);
+    result = et_mpeg_probe_file (file, error);
+    g_object_unref (file);
+
+    return result;
+}
+
+/* Files containing only zeroes make id3lib enter an infinite loop, so they
+ * must be rejected. Equivalent to:
+ * dd if=/dev/zero bs=1M count=6 of=test-corrupted-mp3-zero-contend.mp3 */
+static void
+mpeg_probe_zeroes (void)
+{
+    guchar *data;
+    gchar *path;
+    GError *error = NULL;
+
+    data = g_malloc0 (6 * 1024 * 1024);
+    path = create_fixture ("test-corrupted-mp3-zero-contend.mp3", data,
+                           6 * 1024 * 1024);
+
+    g_assert (!probe_path (path, &error));
+    g_assert_error (error, G_IO_ERROR, G_IO_ERROR_FAILED);
+    g_clear_error (&error);
+
+    /* Empty file. */
+    g_file_set_contents (path, "", 0, &error);
+    g_assert_no_error (error);
+    g_assert (!probe_path (path, &error));
+    g_assert_error (error, G_IO_ERROR, G_IO_ERROR_FAILED);
+    g_clear_error (&error);
+
+    g_unlink (path);
+    g_free (path);
+    g_free (data);
+}
+
+/* A sparse file, with no data at all. */
+static void
+mpeg_probe_sparse (void)
+{
+    gchar *path;
+    gint fd;
+    GError *error = NULL;
+
+    path = create_fixture ("test-mpeg-probe-sparse.mp3", NULL, 0);
+    fd = g_open (path, O_WRONLY, 0);
+    g_assert_cmpint (fd, !=, -1);
+    g_assert_cmpint (ftruncate (fd, 64 * 1024 * 1024), ==, 0);
+    g_close (fd, NULL);
+
+    g_assert (!probe_path (path, &error));
+    g_assert_error (error, G_IO_ERROR, G_IO_ERROR_FAILED);
+    g_clear_error (&error);
+
+    /* Audio data after the hole. */
+    fd = g_open (path, O_WRONLY | O_APPEND, 0);
+    g_assert_cmpint (fd, !=, -1);
+    g_assert_cmpint (write (fd, frame_header, sizeof (frame_header)), ==,
+                     sizeof (frame_header));
+    g_close (fd, NULL);
+
+    g_assert (probe_path (path, &error));
+    g_assert_no_error (error);
+
+    g_unlink (path);
+    g_free (path);
+}
+
+static void
+mpeg_probe_structure (void)
+{
+    const gsize length = 256 * 1024;
+    guchar *data;
+    gchar *path;
+    GError *error = NULL;
+
+    data = g_malloc0 (length);
+
+    /* ID3v2 tag at the start. */
+    memcpy (data, "ID3\x04\x00", 5);
+    path = create_fixture ("test-mpeg-probe.mp3", data, length);
+    g_assert (probe_path (path, &error));
+    g_assert_no_error (error);
+    g_unlink (path);
+    g_free (path);
+    memset (data, 0, 5);
+
+    /* Frame header near the start. */
+    memcpy (data + 1000, frame_header, sizeof (frame_header));
+    path = create_fixture ("test-mpeg-probe.mp3", data, length);
+    g_assert (probe_path (path, &error));
+    g_assert_no_error (error);
+    g_unlink (path);
+    g_free (path);
+    memset (data + 1000, 0, sizeof (frame_header));
+
+    /* ID3v1 tag at the end. */
+    memcpy (data + length - 128, "TAG", 3);
+    path = create_fixture ("test-mpeg-probe.mp3", data, length);
+    g_assert (probe_path (path, &error));
+    g_assert_no_error (error);
+    g_unlink (path);
+    g_free (path);
+    memset (data + length - 128, 0, 3);
+
+    /* APE tag footer near the end. */
+    memcpy (data + length - 32, "APETAGEX", 8);
+    path = create_fixture ("test-mpeg-probe.mp3", data, length);
+    g_assert (probe_path (path, &error));
+    g_assert_no_error (error);
+    g_unlink (path);
+    g_free (path);
+    memset (data + length - 32, 0, 8);
+
+    /* Reserved values after the sync word. */
+    data[1000] = 0xFF;
+    data[1001] = 0xE9;
+    data[1002] = 0x90;
+    path = create_fixture ("test-mpeg-probe.mp3", data, length);
+    g_assert (!probe_path (path, &error));
+    g_assert_error (error, G_IO_ERROR, G_IO_ERROR_FAILED);
+    g_clear_error (&error);
+    g_unlink (path);
+    g_free (path);
+
+    /* Text, with no frame header or tag. */
+    memset (data, 'a', length);
+    path = create_fixture ("test-mpeg-probe.mp3", data, length);
+    g_assert (!probe_path (path, &error));
+    g_assert_error (error, G_IO_ERROR, G_IO_ERROR_FAILED);
+    g_clear_error (&error);
+    g_unlink (path);
+    g_free (path);
+
+    /* Small file with a single frame header. */
+    path = create_fixture ("test-mpeg-probe.mp3", frame_header,
+                           sizeof (frame_header));
+    g_assert (probe_path (path, &error));
+    g_assert_no_error (error);
+    g_unlink (path);
+    g_free (path);
+
+    g_free (data);
+}
+
+/* Append @count frames of @length bytes, starting with @header. */
+static void
+append_frames (GByteArray *data,
+               const guchar *header,
+               gsize length,
+               guint count)
+{
+    guint i;
+
+    for (i = 0; i < count; i++)
+    {
+        const guint offset = data->len;
+
+        g_byte_array_set_size (data, offset + length);
+        memset (data->data + offset, 0, length);
+        memcpy (data->data + offset, header, 4);
+    }
+}
+
+static void
+write_uint32_be (guchar *data,
+                 guint32 value)
+{
+    data[0] = value >> 24;
+    data[1] = value >> 16;
+    data[2] = value >> 8;
+    data[3] = value;
+}
+
+static gboolean
+read_info (GByteArray *data,
+           EtMpegAudioInfo *info,
+           GError **error)
+{
+    GFile *file;
+    gchar *path;
+    gboolean result;
+
+    path = create_fixture ("test-mpeg-probe-info.mp3", data->data, data->len);
+    file = g_file_new_for_path (path);
+    result = et_mpeg_probe_read_info (file, -1, info, error);
+    g_object_unref (file);
+    g_unlink (path);
+    g_free (path);
+
+    return result;
+}
+
+/* MPEG 1 Layer III, 128 kb/s, 44.1 kHz, joint stereo: 417 bytes. */
+static const guchar frame_128[] = { 0xFF, 0xFB, 0x90, 0x40 };
+/* MPEG 1 Layer III, 160 kb/s, 44.1 kHz, joint stereo: 522 bytes. */
+static const guchar frame_160[] = { 0xFF, 0xFB, 0xA0, 0x40 };
+
+static void
+mpeg_probe_info_cbr (void)
+{
+    static const guchar id3v2[] = { 'I', 'D', '3', 0x04, 0x00, 0x00,
+                                    0x00, 0x00, 0x01, 0x00 };
+    GByteArray *data;
+    EtMpegAudioInfo info;
+    GError *error = NULL;
+
+    /* ID3v2 tag with 128 bytes of padding, then junk. */
+    data = g_byte_array_new ();
+    g_byte_array_append (data, id3v2, sizeof (id3v2));
+    g_byte_array_set_size (data, sizeof (id3v2) + 128 + 3);
+    memset (data->data + sizeof (id3v2), 0, 128 + 3);
+    append_frames (data, frame_128, 417, 200);
+
+    /* ID3v1 tag. */
+    g_byte_array_set_size (data, data->len + 128);
+    memset (data->data + data->len - 128, 0, 128);
+    memcpy (data->data + data->len - 128, "TAG", 3);
+
+    g_assert (read_info (data, &info, &error));
+    g_assert_no_error (error);
+    g_assert_cmpint (info.version, ==, 1);
+    g_assert (!info.mpeg25);
+    g_assert_cmpint (info.layer, ==, 3);
+    g_assert_cmpint (info.bitrate, ==, 128);
+    g_assert (!info.variable_bitrate);
+    g_assert_cmpint (info.samplerate, ==, 44100);
+    g_assert_cmpint (info.mode, ==, 1);
+    g_assert_cmpint (info.audio_offset, ==, sizeof (id3v2) + 128 + 3);
+    g_assert_cmpint (info.audio_size, ==, 417 * 200);
+    /* 83400 bytes at 128 kb/s. */
+    g_assert_cmpint (info.duration, ==, 5);
+
+    /* Variable bitrate, without a VBR header. */
+    g_byte_array_set_size (data, 0);
+    append_frames (data, frame_128, 417, 1);
+    append_frames (data, frame_160, 522, 1);
+    append_frames (data, frame_128, 417, 1);
+    append_frames (data, frame_160, 522, 1);
+
+    g_assert (read_info (data, &info, &error));
+    g_assert_no_error (error);
+    g_assert (info.variable_bitrate);
+    g_assert_cmpint (info.bitrate, ==, 144);
+
+    /* More junk before the first frame than is read at a time. */
+    g_byte_array_set_size (data, 10000);
+    memset (data->data, 0, data->len);
+    append_frames (data, frame_128, 417, 100);
+
+    g_assert (read_info (data, &info, &error));
+    g_assert_no_error (error);
+    g_assert_cmpint (info.bitrate, ==, 128);
+    g_assert (!info.variable_bitrate);
+    g_assert_cmpint (info.audio_offset, ==, 10000);
+    g_assert_cmpint (info.audio_size, ==, 417 * 100);
+
+    /* Frames after the scanned part of the file are not found. */
+    g_byte_array_set_size (data, 70000);
+    memset (data->data, 0, data->len);
+    append_frames (data, frame_128, 417, 10);
+
+    g_assert (!read_info (data, &info, &error));
+    g_assert_error (error, G_IO_ERROR, G_IO_ERROR_FAILED);
+    g_clear_error (&error);
+
+    /* No frames at all. */
+    g_byte_array_set_size (data, 4096);
+    memset (data->data, 0, data->len);
+
+    g_assert (!read_info (data, &info, &error));
+    g_assert_error (error, G_IO_ERROR, G_IO_ERROR_FAILED);
+    g_clear_error (&error);
+
+    g_byte_array_unref (data);
+}
+
+static void
+mpeg_probe_info_versions (void)
+{
+    /* MPEG 2 Layer III, 64 kb/s, 22.05 kHz, mono: 208 bytes. */
+    static const guchar mpeg2[] = { 0xFF, 0xF3, 0x80, 0xC0 };
+    /* MPEG 2.5 Layer III, 64 kb/s, 11.025 kHz, mono: 417 bytes. */
+    static const guchar mpeg25[] = { 0xFF, 0xE3, 0x80, 0xC0 };
+    /* MPEG 1 Layer II, 192 kb/s, 48 kHz, stereo: 576 bytes. */
+    static const guchar layer2[] = { 0xFF, 0xFD, 0xA4, 0x00 };
+    GByteArray *data;
+    EtMpegAudioInfo info;
+    GError *error = NULL;
+
+    data = g_byte_array_new ();
+    append_frames (data, mpeg2, 208, 10);
+    g_assert (read_info (data, &info, &error));
+    g_assert_no_error (error);
+    g_assert_cmpint (info.version, ==, 2);
+    g_assert (!info.mpeg25);
+    g_assert_cmpint (info.samplerate, ==, 22050);
+    g_assert_cmpint (info.bitrate, ==, 64);
+    g_assert_cmpint (info.mode, ==, 3);
+
+    g_byte_array_set_size (data, 0);
+    append_frames (data, mpeg25, 417, 10);
+    g_assert (read_info (data, &info, &error));
+    g_assert_no_error (error);
+    g_assert_cmpint (info.version, ==, 2);
+    g_assert (info.mpeg25);
+    g_assert_cmpint (info.samplerate, ==, 11025);
+
+    g_byte_array_set_size (data, 0);
+    append_frames (data, layer2, 576, 10);
+    g_assert (read_info (data, &info, &error));
+    g_assert_no_error (error);
+    g_assert_cmpint (info.version, ==, 1);
+    g_assert_cmpint (info.layer, ==, 2);
+    g_assert_cmpint (info.samplerate, ==, 48000);
+    g_assert_cmpint (info.bitrate, ==, 192);
+    g_assert_cmpint (info.mode, ==, 0);
+
+    g_byte_array_unref (data);
+}
+
+static void
+mpeg_probe_info_vbr (void)
+{
+    GByteArray *data;
+    guchar *xing;
+    guchar *lame;
+    EtMpegAudioInfo info;
+    GError *error = NULL;
+
+    /* Xing header after 32 bytes of side information, with 1000 frames and
+     * 600000 bytes of audio, and a LAME tag with a delay of 576 samples and
+     * 1000 samples of padding. */
+    data = g_byte_array_new ();
+    append_frames (data, frame_128, 417, 1);
+    append_frames (data, frame_160, 522, 4);
+    xing = data->data + 4 + 32;
+    memcpy (xing, "Xing", 4);
+    write_uint32_be (xing + 4, 0x03);
+    write_uint32_be (xing + 8, 1000);
+    write_uint32_be (xing + 12, 417 + 600000);
+    lame = xing + 120;
+    memcpy (lame, "LAME3.100", 9);
+    lame[21] = 576 >> 4;
+    lame[22] = ((576 & 0x0F) << 4) | (1000 >> 8);
+    lame[23] = 1000 & 0xFF;
+
+    g_assert (read_info (data, &info, &error));
+    g_assert_no_error (error);
+    g_assert (info.variable_bitrate);
+    /* (1000 * 1152 - 1576) / 44100 s. */
+    g_assert_cmpint (info.duration, ==, 26);
+    g_assert_cmpint (info.bitrate, ==, 184);
+
+    /* Info header, for a CBR stream. */
+    memcpy (xing, "Info", 4);
+    g_assert (read_info (data, &info, &error));
+    g_assert_no_error (error);
+    g_assert (!info.variable_bitrate);
+    g_assert_cmpint (info.duration, ==, 26);
+    g_assert_cmpint (info.bitrate, ==, 128);
+
+    /* VBRI header, with 500 frames. */
+    memset (xing, 0, 160);
+    memcpy (data->data + 36, "VBRI", 4);
+    write_uint32_be (data->data + 36 + 10, 417 + 300000);
+    write_uint32_be (data->data + 36 + 14, 500);
+
+    g_assert (read_info (data, &info, &error));
+    g_assert_no_error (error);
+    g_assert (info.variable_bitrate);
+    g_assert_cmpint (info.duration, ==, 13);
+    /* 300000 bytes in 500 * 1152 / 44100 s. */
+    g_assert_cmpint (info.bitrate, ==, 184);
+
+    g_byte_array_unref (data);
+}
+
+int
+main (int argc, char** argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/mpeg_probe/zeroes", mpeg_probe_zeroes);
+    g_test_add_func ("/mpeg_probe/sparse", mpeg_probe_sparse);
+    g_test_add_func ("/mpeg_probe/structure", mpeg_probe_structure);
+    g_test_add_func ("/mpeg_probe/info/cbr", mpeg_probe_info_cbr);
+    g_test_add_func ("/mpeg_probe/info/versions", mpeg_probe_info_versions);
+    g_test_add_func ("/mpeg_probe/info/vbr", mpeg_probe_info_vbr);
+
+    return g_test_run ();
+}
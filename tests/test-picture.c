@@ -17,6 +17,7 @@
  */
 
 #include "picture.h"
+#include "setting.h"
 
 #include <gtk/gtk.h>
 #include <string.h>
@@ -152,6 +153,48 @@ picture_difference (void)
     et_picture_free (pic1);
 }
 
+static void
+picture_shared_data (void)
+{
+    gchar *data;
+    GBytes *bytes;
+    EtPicture *pic1;
+    EtPicture *pic2;
+    EtPicture *pic3;
+
+    bytes = g_bytes_new_static ("cover", 5);
+    pic1 = et_picture_new (ET_PICTURE_TYPE_FRONT_COVER, "", 0, 0, bytes);
+    g_bytes_unref (bytes);
+
+    /* The same contents, in another buffer. */
+    data = g_strdup ("cover");
+    bytes = g_bytes_new_take (data, 5);
+    pic2 = et_picture_new (ET_PICTURE_TYPE_FRONT_COVER, "", 0, 0, bytes);
+    g_bytes_unref (bytes);
+
+    g_assert (pic1->bytes == pic2->bytes);
+    g_assert (!et_picture_detect_difference (pic1, pic2));
+
+    bytes = g_bytes_new_static ("back cover", 10);
+    pic3 = et_picture_new (ET_PICTURE_TYPE_FRONT_COVER, "", 0, 0, bytes);
+    g_bytes_unref (bytes);
+
+    g_assert (pic1->bytes != pic3->bytes);
+    g_assert (et_picture_detect_difference (pic1, pic3));
+
+    et_picture_set_bytes (pic3, pic2->bytes);
+
+    g_assert (pic1->bytes == pic3->bytes);
+    g_assert (!et_picture_detect_difference (pic1, pic3));
+
+    et_picture_free (pic1);
+    et_picture_free (pic2);
+
+    g_assert_cmpuint (g_bytes_get_size (pic3->bytes), ==, 5);
+
+    et_picture_free (pic3);
+}
+
 static void
 picture_type_from_filename (void)
 {
@@ -241,6 +284,7 @@ main (int argc, char** argv)
     g_test_add_func ("/picture/copy", picture_copy);
     g_test_add_func ("/picture/difference", picture_difference);
     g_test_add_func ("/picture/format-from-data", picture_format_from_data);
+    g_test_add_func ("/picture/shared-data", picture_shared_data);
     g_test_add_func ("/picture/type-from-filename",
                      picture_type_from_filename);
 
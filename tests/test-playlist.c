@@ -0,0 +1,194 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "playlist.h"
+
+#include <glib/gstdio.h>
+
+/* Create a playlist, to be written to @name in @dirname. */
+static EtPlaylist *
+create_playlist (EtPlaylistFlags flags,
+                 const gchar *dirname,
+                 const gchar *name)
+{
+    EtPlaylist *playlist;
+    gchar *filename;
+    GFile *file;
+
+    playlist = et_playlist_new (flags);
+    filename = g_build_filename (dirname, name, NULL);
+    file = g_file_new_for_path (filename);
+    et_playlist_set_file (playlist, file);
+    g_object_unref (file);
+    g_free (filename);
+
+    return playlist;
+}
+
+/* Check that @playlist was written with @contents, and remove it. */
+static void
+check_playlist (const EtPlaylist *playlist,
+                const gchar *contents)
+{
+    gchar *filename;
+    gchar *file_contents;
+    GError *error = NULL;
+
+    filename = g_file_get_path (et_playlist_get_file (playlist));
+    g_file_get_contents (filename, &file_contents, NULL, &error);
+    g_assert_no_error (error);
+    g_assert_cmpstr (file_contents, ==, contents);
+    g_assert_cmpint (g_remove (filename), ==, 0);
+
+    g_free (file_contents);
+    g_free (filename);
+}
+
+static void
+playlist_write (void)
+{
+    gchar *dirname;
+    gchar *filename;
+    EtPlaylist *playlist;
+    GError *error = NULL;
+
+    dirname = g_dir_make_tmp ("EasyTAG-test-XXXXXX", &error);
+    g_assert_no_error (error);
+
+    playlist = create_playlist (ET_PLAYLIST_EXTENDED, dirname, "a.m3u");
+    et_playlist_add (playlist, "/music/a/01.mp3", 61, "One");
+    et_playlist_add (playlist, "/music/b/02.mp3", 125, NULL);
+    g_assert_cmpuint (et_playlist_get_length (playlist), ==, 2);
+    g_assert_true (et_playlist_write (playlist, NULL, &error));
+    g_assert_no_error (error);
+    check_playlist (playlist, "#EXTM3U\r\n"
+                              "#EXTINF:61,One\r\n"
+                              "/music/a/01.mp3\r\n"
+                              "/music/b/02.mp3\r\n");
+    et_playlist_free (playlist);
+
+    /* Files outside of the directory of the playlist are left out. */
+    playlist = create_playlist (ET_PLAYLIST_RELATIVE
+                                | ET_PLAYLIST_DOS_SEPARATOR, dirname,
+                                "b.m3u");
+    filename = g_build_filename (dirname, "a", "01.mp3", NULL);
+    et_playlist_add (playlist, filename, 61, "One");
+    g_free (filename);
+    filename = g_strconcat (dirname, "2", G_DIR_SEPARATOR_S, "02.mp3", NULL);
+    et_playlist_add (playlist, filename, 125, "Two");
+    g_free (filename);
+    g_assert_true (et_playlist_write (playlist, NULL, &error));
+    g_assert_no_error (error);
+    check_playlist (playlist, "a\\01.mp3\r\n");
+    et_playlist_free (playlist);
+
+    /* An empty playlist. */
+    playlist = create_playlist (ET_PLAYLIST_EXTENDED, dirname, "c.m3u");
+    g_assert_true (et_playlist_write (playlist, NULL, &error));
+    g_assert_no_error (error);
+    check_playlist (playlist, "#EXTM3U\r\n");
+    et_playlist_free (playlist);
+
+    g_assert_cmpint (g_rmdir (dirname), ==, 0);
+    g_free (dirname);
+}
+
+static void
+on_write_all (GObject *source_object,
+              GAsyncResult *result,
+              gpointer user_data)
+{
+    GAsyncResult **write_result = user_data;
+
+    *write_result = g_object_ref (result);
+}
+
+static void
+playlist_write_all (void)
+{
+    gchar *dirname;
+    GPtrArray *playlists;
+    EtPlaylist *playlist;
+    GAsyncResult *result = NULL;
+    guint n_written;
+    guint i;
+    GError *error = NULL;
+
+    dirname = g_dir_make_tmp ("EasyTAG-test-XXXXXX", &error);
+    g_assert_no_error (error);
+
+    playlists = g_ptr_array_new_with_free_func ((GDestroyNotify)et_playlist_free);
+
+    for (i = 0; i < 3; i++)
+    {
+        gchar *name;
+
+        name = g_strdup_printf ("%u.m3u", i);
+        playlist = create_playlist (0, dirname, name);
+        et_playlist_add (playlist, name, 0, NULL);
+        g_ptr_array_add (playlists, playlist);
+        g_free (name);
+    }
+
+    /* A playlist in a missing directory fails, but not the others. */
+    playlist = create_playlist (0, dirname, "missing/3.m3u");
+    g_ptr_array_insert (playlists, 1, playlist);
+
+    et_playlist_write_all_async (playlists, NULL, on_write_all, &result);
+
+    while (result == NULL)
+    {
+        g_main_context_iteration (NULL, TRUE);
+    }
+
+    g_assert_false (et_playlist_write_all_finish (result, &n_written,
+                                                  &error));
+    g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+    g_clear_error (&error);
+    g_object_unref (result);
+    g_assert_cmpuint (n_written, ==, 3);
+
+    g_assert (et_playlist_get_error (playlist) != NULL);
+    g_ptr_array_remove_index (playlists, 1);
+
+    for (i = 0; i < playlists->len; i++)
+    {
+        gchar *contents;
+
+        playlist = g_ptr_array_index (playlists, i);
+        g_assert (et_playlist_get_error (playlist) == NULL);
+        contents = g_strdup_printf ("%u.m3u\r\n", i);
+        check_playlist (playlist, contents);
+        g_free (contents);
+    }
+
+    g_ptr_array_unref (playlists);
+    g_assert_cmpint (g_rmdir (dirname), ==, 0);
+    g_free (dirname);
+}
+
+int
+main (int argc, char** argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/playlist/write", playlist_write);
+    g_test_add_func ("/playlist/write-all", playlist_write_all);
+
+    return g_test_run ();
+}
@@ -0,0 +1,447 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "rename_plan.h"
+
+#include <glib/gstdio.h>
+
+/* Create the file @name in @dirname, containing its own name. */
+static gchar *
+create_file (const gchar *dirname,
+             const gchar *name)
+{
+    gchar *filepath;
+    GError *error = NULL;
+
+    filepath = g_build_filename (dirname, name, NULL);
+    g_file_set_contents (filepath, name, -1, &error);
+    g_assert_no_error (error);
+
+    return filepath;
+}
+
+/* Check that @name in @dirname contains @contents, or does not exist if
+ * @contents is %NULL. */
+static void
+check_file (const gchar *dirname,
+            const gchar *name,
+            const gchar *contents)
+{
+    gchar *filepath;
+    gchar *file_contents;
+
+    filepath = g_build_filename (dirname, name, NULL);
+
+    if (contents == NULL)
+    {
+        g_assert_false (g_file_test (filepath, G_FILE_TEST_EXISTS));
+    }
+    else
+    {
+        GError *error = NULL;
+
+        g_file_get_contents (filepath, &file_contents, NULL, &error);
+        g_assert_no_error (error);
+        g_assert_cmpstr (file_contents, ==, contents);
+        g_free (file_contents);
+    }
+
+    g_free (filepath);
+}
+
+static void
+add_rename (EtRenamePlan *plan,
+            const gchar *dirname,
+            const gchar *old_name,
+            const gchar *new_name)
+{
+    gchar *old_filepath;
+    gchar *new_filepath;
+
+    old_filepath = g_build_filename (dirname, old_name, NULL);
+    new_filepath = g_build_filename (dirname, new_name, NULL);
+    et_rename_plan_add (plan, old_filepath, new_filepath, NULL);
+    g_free (new_filepath);
+    g_free (old_filepath);
+}
+
+static void
+remove_file (const gchar *dirname,
+             const gchar *name)
+{
+    gchar *filepath;
+
+    filepath = g_build_filename (dirname, name, NULL);
+    g_assert_cmpint (g_remove (filepath), ==, 0);
+    g_free (filepath);
+}
+
+static gchar *
+make_tmp_dir (void)
+{
+    gchar *dirname;
+    GError *error = NULL;
+
+    dirname = g_dir_make_tmp ("EasyTAG-test-XXXXXX", &error);
+    g_assert_no_error (error);
+
+    return dirname;
+}
+
+static void
+count_data (gpointer data,
+            gpointer user_data)
+{
+    guint *count = user_data;
+
+    g_assert (data == GUINT_TO_POINTER (*count + 1));
+    (*count)++;
+}
+
+static void
+rename_plan_chain (void)
+{
+    gchar *dirname;
+    EtRenamePlan *plan;
+    guint count = 0;
+    GError *error = NULL;
+
+    dirname = make_tmp_dir ();
+    g_free (create_file (dirname, "a"));
+    g_free (create_file (dirname, "b"));
+
+    /* "b" must move out of the way before "a" can take its name. */
+    plan = et_rename_plan_new ();
+    add_rename (plan, dirname, "a", "b");
+    add_rename (plan, dirname, "b", "c");
+    g_assert_cmpuint (et_rename_plan_get_length (plan), ==, 2);
+
+    g_assert_true (et_rename_plan_execute (plan, &error));
+    g_assert_no_error (error);
+    et_rename_plan_free (plan);
+
+    check_file (dirname, "a", NULL);
+    check_file (dirname, "b", "a");
+    check_file (dirname, "c", "b");
+
+    plan = et_rename_plan_new ();
+    et_rename_plan_add (plan, "1", "1", GUINT_TO_POINTER (1));
+    et_rename_plan_add (plan, "2", "2", GUINT_TO_POINTER (2));
+    et_rename_plan_foreach (plan, count_data, &count);
+    g_assert_cmpuint (count, ==, 2);
+
+    /* Files which keep their names are not moved. */
+    g_assert_true (et_rename_plan_execute (plan, &error));
+    g_assert_no_error (error);
+    et_rename_plan_free (plan);
+
+    remove_file (dirname, "b");
+    remove_file (dirname, "c");
+    g_assert_cmpint (g_rmdir (dirname), ==, 0);
+    g_free (dirname);
+}
+
+static void
+rename_plan_cycle (void)
+{
+    gchar *dirname;
+    EtRenamePlan *plan;
+    GError *error = NULL;
+
+    dirname = make_tmp_dir ();
+    g_free (create_file (dirname, "a"));
+    g_free (create_file (dirname, "b"));
+    g_free (create_file (dirname, "c"));
+    g_free (create_file (dirname, "d"));
+
+    /* A swap, and a chain of two other files. */
+    plan = et_rename_plan_new ();
+    add_rename (plan, dirname, "a", "b");
+    add_rename (plan, dirname, "b", "a");
+    add_rename (plan, dirname, "c", "d");
+    add_rename (plan, dirname, "d", "e");
+    g_assert_true (et_rename_plan_execute (plan, &error));
+    g_assert_no_error (error);
+    et_rename_plan_free (plan);
+
+    check_file (dirname, "a", "b");
+    check_file (dirname, "b", "a");
+    check_file (dirname, "d", "c");
+    check_file (dirname, "e", "d");
+
+    plan = et_rename_plan_new ();
+    add_rename (plan, dirname, "a", "b");
+    add_rename (plan, dirname, "b", "d");
+    add_rename (plan, dirname, "d", "a");
+    g_assert_true (et_rename_plan_execute (plan, &error));
+    g_assert_no_error (error);
+    et_rename_plan_free (plan);
+
+    check_file (dirname, "a", "c");
+    check_file (dirname, "b", "b");
+    check_file (dirname, "d", "a");
+
+    remove_file (dirname, "a");
+    remove_file (dirname, "b");
+    remove_file (dirname, "d");
+    remove_file (dirname, "e");
+    g_assert_cmpint (g_rmdir (dirname), ==, 0);
+    g_free (dirname);
+}
+
+static void
+rename_plan_directories (void)
+{
+    gchar *dirname;
+    EtRenamePlan *plan;
+    guint i;
+    GError *error = NULL;
+
+    dirname = make_tmp_dir ();
+    plan = et_rename_plan_new ();
+
+    /* Files in separate directories, which are renamed in parallel, to new
+     * subdirectories. */
+    for (i = 0; i < 8; i++)
+    {
+        gchar *name;
+        gchar *subdirname;
+        gchar *filepath;
+        gchar *new_filepath;
+
+        name = g_strdup_printf ("%u", i);
+        subdirname = g_build_filename (dirname, name, NULL);
+        g_assert_cmpint (g_mkdir (subdirname, 0700), ==, 0);
+
+        filepath = create_file (subdirname, "a");
+        new_filepath = g_build_filename (subdirname, "x", "y", "a", NULL);
+        et_rename_plan_add (plan, filepath, new_filepath, NULL);
+
+        g_free (new_filepath);
+        g_free (filepath);
+        g_free (subdirname);
+        g_free (name);
+    }
+
+    g_assert_true (et_rename_plan_execute (plan, &error));
+    g_assert_no_error (error);
+    et_rename_plan_free (plan);
+
+    for (i = 0; i < 8; i++)
+    {
+        gchar *name;
+        gchar *subdirname;
+        gchar *newdirname;
+
+        name = g_strdup_printf ("%u", i);
+        subdirname = g_build_filename (dirname, name, NULL);
+        newdirname = g_build_filename (subdirname, "x", "y", NULL);
+
+        check_file (subdirname, "a", NULL);
+        check_file (newdirname, "a", "a");
+
+        remove_file (newdirname, "a");
+        g_assert_cmpint (g_rmdir (newdirname), ==, 0);
+        g_free (newdirname);
+        newdirname = g_build_filename (subdirname, "x", NULL);
+        g_assert_cmpint (g_rmdir (newdirname), ==, 0);
+        g_assert_cmpint (g_rmdir (subdirname), ==, 0);
+
+        g_free (newdirname);
+        g_free (subdirname);
+        g_free (name);
+    }
+
+    g_assert_cmpint (g_rmdir (dirname), ==, 0);
+    g_free (dirname);
+}
+
+static void
+rename_plan_rollback (void)
+{
+    gchar *dirname;
+    gchar *subdirname;
+    EtRenamePlan *plan;
+    GError *error = NULL;
+
+    dirname = make_tmp_dir ();
+    g_free (create_file (dirname, "a"));
+    g_free (create_file (dirname, "b"));
+    g_free (create_file (dirname, "c"));
+
+    /* Renaming to an existing file fails before moving anything. */
+    plan = et_rename_plan_new ();
+    add_rename (plan, dirname, "a", "b");
+    add_rename (plan, dirname, "c", "d");
+    g_assert_false (et_rename_plan_execute (plan, &error));
+    g_assert_error (error, G_IO_ERROR, G_IO_ERROR_EXISTS);
+    g_clear_error (&error);
+    et_rename_plan_free (plan);
+
+    check_file (dirname, "a", "a");
+    check_file (dirname, "b", "b");
+    check_file (dirname, "c", "c");
+    check_file (dirname, "d", NULL);
+
+    /* Several files to the same destination. */
+    plan = et_rename_plan_new ();
+    add_rename (plan, dirname, "a", "d");
+    add_rename (plan, dirname, "c", "d");
+    g_assert_false (et_rename_plan_execute (plan, &error));
+    g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT);
+    g_clear_error (&error);
+    et_rename_plan_free (plan);
+
+    /* A missing file fails while moving, so the moves which were done, and
+     * the new directory, are undone. */
+    plan = et_rename_plan_new ();
+    add_rename (plan, dirname, "a", "b");
+    add_rename (plan, dirname, "b", "x/a");
+    add_rename (plan, dirname, "c", "x/c");
+    add_rename (plan, dirname, "missing", "x/missing");
+    g_assert_false (et_rename_plan_execute (plan, &error));
+    g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+    g_clear_error (&error);
+    et_rename_plan_free (plan);
+
+    check_file (dirname, "a", "a");
+    check_file (dirname, "b", "b");
+    check_file (dirname, "c", "c");
+    subdirname = g_build_filename (dirname, "x", NULL);
+    g_assert_false (g_file_test (subdirname, G_FILE_TEST_EXISTS));
+    g_free (subdirname);
+
+    remove_file (dirname, "a");
+    remove_file (dirname, "b");
+    remove_file (dirname, "c");
+    g_assert_cmpint (g_rmdir (dirname), ==, 0);
+    g_free (dirname);
+}
+
+/* Find a directory on another filesystem than @dirname, or return %NULL. */
+static gchar *
+find_other_filesystem (const gchar *dirname)
+{
+    const gchar *candidates[3];
+    GStatBuf st;
+    dev_t dev;
+    gsize i;
+
+    candidates[0] = "/dev/shm";
+    candidates[1] = g_get_user_runtime_dir ();
+    candidates[2] = g_get_home_dir ();
+
+    g_assert_cmpint (g_stat (dirname, &st), ==, 0);
+    dev = st.st_dev;
+
+    for (i = 0; i < G_N_ELEMENTS (candidates); i++)
+    {
+        gchar *template;
+        gchar *other_dirname;
+
+        if (g_stat (candidates[i], &st) != 0 || st.st_dev == dev)
+        {
+            continue;
+        }
+
+        template = g_build_filename (candidates[i], "EasyTAG-test-XXXXXX",
+                                     NULL);
+        other_dirname = g_mkdtemp (template);
+
+        if (other_dirname)
+        {
+            return other_dirname;
+        }
+
+        g_free (template);
+    }
+
+    return NULL;
+}
+
+static void
+rename_plan_filesystems (void)
+{
+    gchar *dirname;
+    gchar *other_dirname;
+    gchar *filepath;
+    gchar *new_filepath;
+    EtRenamePlan *plan;
+    GError *error = NULL;
+
+    dirname = make_tmp_dir ();
+    other_dirname = find_other_filesystem (dirname);
+
+    if (other_dirname == NULL)
+    {
+        g_test_skip ("No other filesystem to move files to");
+        g_assert_cmpint (g_rmdir (dirname), ==, 0);
+        g_free (dirname);
+        return;
+    }
+
+    /* Moved by copying and deleting, as renaming fails with EXDEV. */
+    plan = et_rename_plan_new ();
+    filepath = create_file (dirname, "a");
+    new_filepath = g_build_filename (other_dirname, "b", NULL);
+    et_rename_plan_add (plan, filepath, new_filepath, NULL);
+    g_free (new_filepath);
+    g_free (filepath);
+    g_assert_true (et_rename_plan_execute (plan, &error));
+    g_assert_no_error (error);
+    et_rename_plan_free (plan);
+
+    check_file (dirname, "a", NULL);
+    check_file (other_dirname, "b", "a");
+
+    /* An existing file is not replaced. */
+    plan = et_rename_plan_new ();
+    filepath = create_file (dirname, "b");
+    new_filepath = g_build_filename (other_dirname, "b", NULL);
+    et_rename_plan_add (plan, filepath, new_filepath, NULL);
+    g_free (new_filepath);
+    g_free (filepath);
+    g_assert_false (et_rename_plan_execute (plan, &error));
+    g_assert_error (error, G_IO_ERROR, G_IO_ERROR_EXISTS);
+    g_clear_error (&error);
+    et_rename_plan_free (plan);
+
+    check_file (dirname, "b", "b");
+    check_file (other_dirname, "b", "a");
+
+    remove_file (dirname, "b");
+    remove_file (other_dirname, "b");
+    g_assert_cmpint (g_rmdir (other_dirname), ==, 0);
+    g_assert_cmpint (g_rmdir (dirname), ==, 0);
+    g_free (other_dirname);
+    g_free (dirname);
+}
+
+int
+main (int argc, char** argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/rename_plan/chain", rename_plan_chain);
+    g_test_add_func ("/rename_plan/cycle", rename_plan_cycle);
+    g_test_add_func ("/rename_plan/directories", rename_plan_directories);
+    g_test_add_func ("/rename_plan/filesystems", rename_plan_filesystems);
+    g_test_add_func ("/rename_plan/rollback", rename_plan_rollback);
+
+    return g_test_run ();
+}
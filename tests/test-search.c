@@ -0,0 +1,406 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "search.h"
+
+#include <string.h>
+
+static const gchar * const files[][ET_SEARCH_FIELD_COUNT] =
+{
+    { "01 Speak to Me.flac", "Speak to Me", "Pink Floyd", NULL,
+      "The Dark Side of the Moon", "1", "1", "1973", "1", "10",
+      "Progressive Rock" },
+    { "02 Breathe.flac", "Breathe", "Pink Floyd", NULL,
+      "The Dark Side of the Moon", "1", "1", "1973", "2", "10",
+      "Progressive Rock" },
+    { "01 Wish You Were Here.mp3", "Wish You Were Here", "Pink Floyd", NULL,
+      "Wish You Were Here", NULL, NULL, "1975", "4", NULL, "Rock" },
+    { "01 Blåbærsyltetøy.ogg", "Blåbærsyltetøy", "Kari Bremnes", NULL,
+      "Ävenyr", NULL, NULL, "2003", "1", NULL, NULL }
+};
+
+static EtSearchIndex *
+create_index (void)
+{
+    EtSearchIndex *search_index;
+    gsize i;
+
+    search_index = et_search_index_new ();
+
+    for (i = 0; i < G_N_ELEMENTS (files); i++)
+    {
+        et_search_index_update (search_index, GSIZE_TO_POINTER (i + 1), i,
+                                files[i]);
+    }
+
+    return search_index;
+}
+
+/* Return the 1-based item numbers matching @string, as a bit mask. */
+static guint
+run_query (EtSearchIndex *search_index,
+           const gchar *string,
+           guint fields,
+           gboolean case_sensitive)
+{
+    EtSearchQuery *query;
+    GArray *results;
+    guint matched = 0;
+    guint i;
+
+    query = et_search_query_new (string, fields, case_sensitive, NULL);
+    g_assert (query != NULL);
+
+    results = et_search_index_query (search_index, query);
+
+    for (i = 0; i < results->len; i++)
+    {
+        const EtSearchResult *result = &g_array_index (results, EtSearchResult,
+                                                       i);
+
+        /* Results are sorted by position. */
+        if (i > 0)
+        {
+            g_assert_cmpuint (g_array_index (results, EtSearchResult,
+                                             i - 1).position, <,
+                              result->position);
+        }
+
+        matched |= 1 << (GPOINTER_TO_SIZE (result->item) - 1);
+    }
+
+    g_array_unref (results);
+    et_search_query_free (query);
+
+    return matched;
+}
+
+static void
+search_substring (void)
+{
+    EtSearchIndex *search_index;
+
+    search_index = create_index ();
+
+    g_assert_cmpuint (run_query (search_index, "floyd",
+                                 ET_SEARCH_FIELD_MASK_ALL, FALSE), ==, 0x7);
+    g_assert_cmpuint (run_query (search_index, "floyd",
+                                 ET_SEARCH_FIELD_MASK_ALL, TRUE), ==, 0);
+    g_assert_cmpuint (run_query (search_index, "Dark Side",
+                                 ET_SEARCH_FIELD_MASK_TAG, TRUE), ==, 0x3);
+    g_assert_cmpuint (run_query (search_index, "BLÅBÆR",
+                                 ET_SEARCH_FIELD_MASK_ALL, FALSE), ==, 0x8);
+    g_assert_cmpuint (run_query (search_index, "mp3",
+                                 ET_SEARCH_FIELD_MASK_TAG, FALSE), ==, 0);
+    g_assert_cmpuint (run_query (search_index, "mp3",
+                                 ET_SEARCH_FIELD_MASK_FILENAME, FALSE), ==,
+                      0x4);
+    /* Shorter than a trigram, so every item is checked. */
+    g_assert_cmpuint (run_query (search_index, "4",
+                                 ET_SEARCH_FIELD_MASK_TAG, FALSE), ==, 0x4);
+    g_assert_cmpuint (run_query (search_index, "", ET_SEARCH_FIELD_MASK_ALL,
+                                 FALSE), ==, 0xf);
+    g_assert_cmpuint (run_query (search_index, "zzzz",
+                                 ET_SEARCH_FIELD_MASK_ALL, FALSE), ==, 0);
+
+    et_search_index_unref (search_index);
+}
+
+static void
+search_fields (void)
+{
+    EtSearchIndex *search_index;
+    EtSearchQuery *query;
+    GArray *results;
+    const EtSearchResult *result;
+
+    search_index = create_index ();
+
+    g_assert_cmpuint (run_query (search_index, "title:wish",
+                                 ET_SEARCH_FIELD_MASK_ALL, FALSE), ==, 0x4);
+    g_assert_cmpuint (run_query (search_index, "album:wish artist:floyd",
+                                 ET_SEARCH_FIELD_MASK_ALL, FALSE), ==, 0x4);
+    g_assert_cmpuint (run_query (search_index, "album:\"dark side\" breathe",
+                                 ET_SEARCH_FIELD_MASK_ALL, FALSE), ==, 0x2);
+    g_assert_cmpuint (run_query (search_index, "year:1973 track:2",
+                                 ET_SEARCH_FIELD_MASK_ALL, FALSE), ==, 0x2);
+    /* An explicit field overrides the default fields. */
+    g_assert_cmpuint (run_query (search_index, "filename:ogg",
+                                 ET_SEARCH_FIELD_MASK_TAG, FALSE), ==, 0x8);
+
+    query = et_search_query_new ("artist:bremnes", ET_SEARCH_FIELD_MASK_ALL,
+                                 FALSE, NULL);
+    results = et_search_index_query (search_index, query);
+    g_assert_cmpuint (results->len, ==, 1);
+    result = &g_array_index (results, EtSearchResult, 0);
+    g_assert_cmpuint (result->fields, ==,
+                      ET_SEARCH_FIELD_MASK (ET_SEARCH_FIELD_ARTIST));
+    g_array_unref (results);
+    et_search_query_free (query);
+
+    et_search_index_unref (search_index);
+}
+
+static void
+search_regex (void)
+{
+    EtSearchIndex *search_index;
+    GError *error = NULL;
+
+    search_index = create_index ();
+
+    g_assert_cmpuint (run_query (search_index, "/^0[12] /",
+                                 ET_SEARCH_FIELD_MASK_ALL, FALSE), ==, 0xf);
+    g_assert_cmpuint (run_query (search_index, "title:/^b/",
+                                 ET_SEARCH_FIELD_MASK_ALL, FALSE), ==, 0xa);
+    g_assert_cmpuint (run_query (search_index, "title:/^b/",
+                                 ET_SEARCH_FIELD_MASK_ALL, TRUE), ==, 0);
+    g_assert_cmpuint (run_query (search_index, "title:/^B/",
+                                 ET_SEARCH_FIELD_MASK_ALL, TRUE), ==, 0xa);
+    g_assert_cmpuint (run_query (search_index, "title:/^B/ year:/19[0-9]+/",
+                                 ET_SEARCH_FIELD_MASK_ALL, TRUE), ==, 0x2);
+    /* Precomposed characters match the normalized text. */
+    g_assert_cmpuint (run_query (search_index, "/blåbær/",
+                                 ET_SEARCH_FIELD_MASK_ALL, FALSE), ==, 0x8);
+    g_assert_cmpuint (run_query (search_index, "album:/^Äv/",
+                                 ET_SEARCH_FIELD_MASK_ALL, TRUE), ==, 0x8);
+
+    g_assert (et_search_query_new ("/(/", ET_SEARCH_FIELD_MASK_ALL, FALSE,
+                                   &error) == NULL);
+    g_assert (error != NULL);
+    g_assert (error->domain == G_REGEX_ERROR);
+    g_clear_error (&error);
+
+    et_search_index_unref (search_index);
+}
+
+static void
+search_update (void)
+{
+    EtSearchIndex *search_index;
+    const gchar *fields[ET_SEARCH_FIELD_COUNT] = { NULL, };
+    gsize i;
+
+    search_index = create_index ();
+
+    fields[ET_SEARCH_FIELD_FILENAME] = "01 Speak to Me.flac";
+    fields[ET_SEARCH_FIELD_TITLE] = "Speak to Me";
+    fields[ET_SEARCH_FIELD_ARTIST] = "Roger Waters";
+    et_search_index_update (search_index, GSIZE_TO_POINTER (1), 0, fields);
+
+    g_assert_cmpuint (et_search_index_get_n_items (search_index), ==, 4);
+    g_assert_cmpuint (run_query (search_index, "artist:floyd",
+                                 ET_SEARCH_FIELD_MASK_ALL, FALSE), ==, 0x6);
+    g_assert_cmpuint (run_query (search_index, "waters",
+                                 ET_SEARCH_FIELD_MASK_ALL, FALSE), ==, 0x1);
+
+    et_search_index_remove (search_index, GSIZE_TO_POINTER (2));
+    g_assert_cmpuint (et_search_index_get_n_items (search_index), ==, 3);
+    g_assert_cmpuint (run_query (search_index, "breathe",
+                                 ET_SEARCH_FIELD_MASK_ALL, FALSE), ==, 0);
+
+    /* Enough updates to trigger a compaction of the posting lists. */
+    for (i = 0; i < 10000; i++)
+    {
+        fields[ET_SEARCH_FIELD_ARTIST] = i % 2 ? "Roger Waters" : "Syd Barrett";
+        et_search_index_update (search_index, GSIZE_TO_POINTER (1), 0, fields);
+    }
+
+    g_assert_cmpuint (run_query (search_index, "waters",
+                                 ET_SEARCH_FIELD_MASK_ALL, FALSE), ==, 0x1);
+    g_assert_cmpuint (run_query (search_index, "barrett",
+                                 ET_SEARCH_FIELD_MASK_ALL, FALSE), ==, 0);
+    g_assert_cmpuint (run_query (search_index, "floyd",
+                                 ET_SEARCH_FIELD_MASK_ALL, FALSE), ==, 0x4);
+
+    et_search_index_unref (search_index);
+}
+
+typedef struct
+{
+    guint n_batches;
+    guint n_results;
+    guint last_position;
+    guint n_searched;
+    GCancellable *cancellable;
+    EtSearchIndex *search_index;
+} BatchData;
+
+static void
+count_batch (const EtSearchResult *results,
+             guint n_results,
+             guint n_searched,
+             gpointer user_data)
+{
+    BatchData *data = user_data;
+    guint i;
+
+    g_assert_cmpuint (n_results, <=, 16);
+    g_assert_cmpuint (n_searched, >=, data->n_searched);
+
+    for (i = 0; i < n_results; i++)
+    {
+        g_assert_cmpuint (results[i].position, >=, data->last_position);
+        data->last_position = results[i].position;
+    }
+
+    data->n_batches++;
+    data->n_results += n_results;
+    data->n_searched = n_searched;
+
+    if (data->cancellable && data->n_results >= 64)
+    {
+        g_cancellable_cancel (data->cancellable);
+    }
+
+    /* Remove an item which may still be checked by the query. */
+    if (data->search_index && data->n_results >= 64)
+    {
+        et_search_index_remove (data->search_index, GSIZE_TO_POINTER (1));
+        data->search_index = NULL;
+    }
+}
+
+static void
+search_batched (void)
+{
+    EtSearchIndex *search_index;
+    EtSearchQuery *query;
+    BatchData data = { 0, };
+    const gsize N_ITEMS = 50000;
+    gsize i;
+
+    search_index = et_search_index_new ();
+
+    /* Add the items in reverse order of position, so that the results must
+     * be reordered. */
+    for (i = N_ITEMS; i > 0; i--)
+    {
+        gchar *title;
+        const gchar *fields[ET_SEARCH_FIELD_COUNT] = { NULL, };
+
+        title = g_strdup_printf ("Title %" G_GSIZE_FORMAT, i % 100);
+        fields[ET_SEARCH_FIELD_TITLE] = title;
+        et_search_index_update (search_index, GSIZE_TO_POINTER (i), i, fields);
+        g_free (title);
+    }
+
+    query = et_search_query_new ("title 42", ET_SEARCH_FIELD_MASK_ALL, FALSE,
+                                 NULL);
+
+    g_assert (et_search_index_query_batched (search_index, query, 16,
+                                             count_batch, &data, NULL));
+    g_assert_cmpuint (data.n_results, ==, N_ITEMS / 100);
+    g_assert_cmpuint (data.n_searched, ==, N_ITEMS);
+
+    /* Cancelled from the callback. */
+    memset (&data, 0, sizeof (data));
+    data.cancellable = g_cancellable_new ();
+
+    et_search_query_free (query);
+    query = et_search_query_new ("title", ET_SEARCH_FIELD_MASK_ALL, FALSE,
+                                 NULL);
+
+    g_assert (!et_search_index_query_batched (search_index, query, 16,
+                                              count_batch, &data,
+                                              data.cancellable));
+    g_assert_cmpuint (data.n_results, <, N_ITEMS);
+    g_object_unref (data.cancellable);
+
+    /* Stopped by a change to the index from the callback. */
+    memset (&data, 0, sizeof (data));
+    data.search_index = search_index;
+
+    g_assert (!et_search_index_query_batched (search_index, query, 16,
+                                              count_batch, &data, NULL));
+    g_assert_cmpuint (data.n_results, <, N_ITEMS);
+    g_assert_cmpuint (et_search_index_get_n_items (search_index), ==,
+                      N_ITEMS - 1);
+
+    et_search_query_free (query);
+    et_search_index_unref (search_index);
+}
+
+static void
+search_perf (void)
+{
+    EtSearchIndex *search_index;
+    EtSearchQuery *query;
+    GArray *results;
+    const gsize PERF_ITEMS = 100000;
+    gdouble time;
+    gsize i;
+
+    search_index = et_search_index_new ();
+
+    for (i = 0; i < PERF_ITEMS; i++)
+    {
+        gchar *strings[4];
+        const gchar *fields[ET_SEARCH_FIELD_COUNT] = { NULL, };
+
+        strings[0] = g_strdup_printf ("%05" G_GSIZE_FORMAT " Track.mp3", i);
+        strings[1] = g_strdup_printf ("Title number %" G_GSIZE_FORMAT, i);
+        strings[2] = g_strdup_printf ("Artist %" G_GSIZE_FORMAT, i % 1000);
+        strings[3] = g_strdup_printf ("Album %" G_GSIZE_FORMAT, i % 10000);
+        fields[ET_SEARCH_FIELD_FILENAME] = strings[0];
+        fields[ET_SEARCH_FIELD_TITLE] = strings[1];
+        fields[ET_SEARCH_FIELD_ARTIST] = strings[2];
+        fields[ET_SEARCH_FIELD_ALBUM] = strings[3];
+
+        et_search_index_update (search_index, GSIZE_TO_POINTER (i + 1), i,
+                                fields);
+
+        g_free (strings[0]);
+        g_free (strings[1]);
+        g_free (strings[2]);
+        g_free (strings[3]);
+    }
+
+    query = et_search_query_new ("artist:\"artist 123\" album:4123",
+                                 ET_SEARCH_FIELD_MASK_ALL, FALSE, NULL);
+
+    g_test_timer_start ();
+    results = et_search_index_query (search_index, query);
+    time = g_test_timer_elapsed ();
+
+    g_assert_cmpuint (results->len, ==, 10);
+    g_test_minimized_result (time, "%6.4f seconds", time);
+
+    g_array_unref (results);
+    et_search_query_free (query);
+    et_search_index_unref (search_index);
+}
+
+int
+main (int argc, char** argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/search/substring", search_substring);
+    g_test_add_func ("/search/fields", search_fields);
+    g_test_add_func ("/search/regex", search_regex);
+    g_test_add_func ("/search/update", search_update);
+    g_test_add_func ("/search/batched", search_batched);
+
+    if (g_test_perf ())
+    {
+        g_test_add_func ("/search/perf/query", search_perf);
+    }
+
+    return g_test_run ();
+}
@@ -0,0 +1,568 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/* Benchmarks of reading and writing tags, and of the operations done on the
+ * list of loaded files, over a generated corpus. The benchmarks only run in
+ * performance mode, for example with "make benchmark", and report their
+ * results with g_test_maximized_result() (files per second) and
+ * g_test_minimized_result() (peak resident set size), which gtester records
+ * in its XML log. Otherwise, a single round trip of each format is tested. */
+
+#include "config.h"
+
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+#ifdef G_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+#include "corpus.h"
+#include "file.h"
+#include "file_list.h"
+#include "file_tag.h"
+#include "picture.h"
+#include "scan_dialog.h"
+#include "search.h"
+#include "setting.h"
+
+/* A mask matching the generated filenames. */
+#define CORPUS_SCAN_MASK "%n - %a - %t"
+
+static gint n_files = 200;
+static gint tag_size = 256;
+static gint picture_size = 64 * 1024;
+static gchar *corpus_dir = NULL;
+
+static const GOptionEntry entries[] =
+{
+    { "files", 0, 0, G_OPTION_ARG_INT, &n_files,
+      "Number of files of each format to benchmark", "N" },
+    { "tag-size", 0, 0, G_OPTION_ARG_INT, &tag_size,
+      "Size of the comment of each tag, in bytes", "BYTES" },
+    { "picture-size", 0, 0, G_OPTION_ARG_INT, &picture_size,
+      "Size of the cover picture of each tag, in bytes, or 0 for none",
+      "BYTES" },
+    { "corpus-dir", 0, 0, G_OPTION_ARG_FILENAME, &corpus_dir,
+      "Directory in which to keep the corpus, instead of a temporary one",
+      "DIR" },
+    { NULL }
+};
+
+/*
+ * Write @count untagged files of @format to a new subdirectory @name of the
+ * corpus directory, and load them.
+ */
+static GList *
+create_files (EtCorpusFormat format,
+              const gchar *name,
+              guint count)
+{
+    gchar *path;
+    GList *file_list = NULL;
+    guint i;
+
+    path = g_build_filename (corpus_dir, name, NULL);
+
+    if (g_file_test (path, G_FILE_TEST_EXISTS))
+    {
+        et_corpus_remove_recursive (path);
+    }
+
+    g_assert_cmpint (g_mkdir_with_parents (path, 0700), ==, 0);
+
+    for (i = 0; i < count; i++)
+    {
+        gchar *basename;
+        gchar *filename;
+        GFile *file;
+        GError *error = NULL;
+
+        basename = g_strdup_printf ("%03u - Artist %u - Title %u%s", i + 1,
+                                    i % 50, i,
+                                    et_corpus_format_get_extension (format));
+        filename = g_build_filename (path, basename, NULL);
+
+        et_corpus_write_audio (format, filename, &error);
+        g_assert_no_error (error);
+
+        file = g_file_new_for_path (filename);
+        file_list = et_file_list_add (file_list, file);
+        g_object_unref (file);
+
+        g_free (filename);
+        g_free (basename);
+    }
+
+    g_free (path);
+
+    g_assert_cmpuint (g_list_length (file_list), ==, count);
+
+    return file_list;
+}
+
+/*
+ * Set a synthetic tag on each file of @file_list, as a change to be saved.
+ * Artists and albums are shared between files, so that grouping the files
+ * is meaningful.
+ */
+static void
+set_tags (GList *file_list)
+{
+    GBytes *bytes = NULL;
+    EtPicture *picture = NULL;
+    gchar *comment;
+    GList *l;
+    guint i;
+
+    comment = g_malloc (tag_size + 1);
+    memset (comment, 'x', tag_size);
+    comment[tag_size] = '\0';
+
+    if (picture_size > 0)
+    {
+        bytes = et_corpus_new_picture_data (picture_size);
+        picture = et_picture_new (ET_PICTURE_TYPE_FRONT_COVER, "Cover", 0, 0,
+                                  bytes);
+    }
+
+    for (l = file_list, i = 0; l != NULL; l = g_list_next (l), i++)
+    {
+        ET_File *ETFile = l->data;
+        File_Tag *FileTag;
+        gchar *value;
+
+        FileTag = et_file_tag_new ();
+        et_file_tag_copy_into (FileTag, ETFile->FileTag->data);
+
+        value = g_strdup_printf ("Title %u", i);
+        et_file_tag_set_title (FileTag, value);
+        g_free (value);
+        value = g_strdup_printf ("Artist %u", i % 50);
+        et_file_tag_set_artist (FileTag, value);
+        g_free (value);
+        value = g_strdup_printf ("Album %u", i % 200);
+        et_file_tag_set_album (FileTag, value);
+        g_free (value);
+        value = g_strdup_printf ("%u", i % 20 + 1);
+        et_file_tag_set_track_number (FileTag, value);
+        g_free (value);
+        value = g_strdup_printf ("%u", 1960 + i % 60);
+        et_file_tag_set_year (FileTag, value);
+        g_free (value);
+        et_file_tag_set_genre (FileTag, "Rock");
+        et_file_tag_set_comment (FileTag, comment);
+        et_file_tag_set_picture (FileTag, picture);
+
+        ET_Manage_Changes_Of_File_Data (ETFile, NULL, FileTag);
+    }
+
+    if (picture)
+    {
+        et_picture_free (picture);
+        g_bytes_unref (bytes);
+    }
+
+    g_free (comment);
+}
+
+static void
+save_tags (GList *file_list)
+{
+    GList *l;
+
+    for (l = file_list; l != NULL; l = g_list_next (l))
+    {
+        GError *error = NULL;
+
+        ET_Save_File_Tag_To_HD (l->data, &error);
+        g_assert_no_error (error);
+    }
+}
+
+static gint
+compare_filenames (gconstpointer a,
+                   gconstpointer b)
+{
+    return strcmp (*(const gchar * const *)a, *(const gchar * const *)b);
+}
+
+/* Load the files of a subdirectory of the corpus directory, in name order. */
+static GList *
+load_files (const gchar *name)
+{
+    gchar *path;
+    GDir *dir;
+    GPtrArray *filenames;
+    const gchar *filename;
+    GList *file_list = NULL;
+    guint i;
+
+    path = g_build_filename (corpus_dir, name, NULL);
+    dir = g_dir_open (path, 0, NULL);
+    g_assert (dir != NULL);
+
+    filenames = g_ptr_array_new_with_free_func (g_free);
+
+    while ((filename = g_dir_read_name (dir)) != NULL)
+    {
+        g_ptr_array_add (filenames, g_build_filename (path, filename, NULL));
+    }
+
+    g_dir_close (dir);
+    g_ptr_array_sort (filenames, compare_filenames);
+
+    for (i = 0; i < filenames->len; i++)
+    {
+        GFile *file = g_file_new_for_path (g_ptr_array_index (filenames, i));
+
+        file_list = et_file_list_add (file_list, file);
+        g_object_unref (file);
+    }
+
+    g_ptr_array_unref (filenames);
+    g_free (path);
+
+    return file_list;
+}
+
+/*
+ * Report the rate at which @count files were processed since the test timer
+ * was started, and the peak memory use so far.
+ */
+static void
+report_results (guint count)
+{
+    const gdouble elapsed = g_test_timer_elapsed ();
+
+    g_test_maximized_result (count / MAX (elapsed, 1e-9),
+                             "%u files in %.3f s: %.1f files/s", count,
+                             elapsed, count / MAX (elapsed, 1e-9));
+
+#ifdef G_OS_UNIX
+    {
+        struct rusage usage;
+
+        /* The peak is over the whole process, so it includes the earlier
+         * tests. Run a single test with -p to isolate it. */
+        if (getrusage (RUSAGE_SELF, &usage) == 0)
+        {
+            g_test_minimized_result (usage.ru_maxrss,
+                                     "peak RSS: %ld KiB", usage.ru_maxrss);
+        }
+    }
+#endif /* G_OS_UNIX */
+}
+
+static void
+tag_io_round_trip (gconstpointer data)
+{
+    const EtCorpusFormat format = GPOINTER_TO_INT (data);
+    gchar *name;
+    GList *file_list;
+    const File_Tag *FileTag;
+
+    name = g_strconcat ("round-trip-", et_corpus_format_get_name (format),
+                        NULL);
+
+    file_list = create_files (format, name, 2);
+    set_tags (file_list);
+    save_tags (file_list);
+    et_file_list_free (file_list);
+
+    file_list = load_files (name);
+    g_assert_cmpuint (g_list_length (file_list), ==, 2);
+
+    FileTag = ((ET_File *)file_list->next->data)->FileTag->data;
+    g_assert_cmpstr (FileTag->title, ==, "Title 1");
+    g_assert_cmpstr (FileTag->artist, ==, "Artist 1");
+    g_assert_cmpstr (FileTag->album, ==, "Album 1");
+    g_assert_cmpuint (strlen (FileTag->comment), ==, tag_size);
+
+    et_file_list_free (file_list);
+    g_free (name);
+}
+
+static void
+tag_io_write (gconstpointer data)
+{
+    const EtCorpusFormat format = GPOINTER_TO_INT (data);
+    GList *file_list;
+
+    file_list = create_files (format, et_corpus_format_get_name (format),
+                              n_files);
+    set_tags (file_list);
+
+    g_test_timer_start ();
+    save_tags (file_list);
+    report_results (n_files);
+
+    et_file_list_free (file_list);
+}
+
+/* Read the files written by tag_io_write(). */
+static void
+tag_io_read (gconstpointer data)
+{
+    const EtCorpusFormat format = GPOINTER_TO_INT (data);
+    GList *file_list;
+
+    g_test_timer_start ();
+    file_list = load_files (et_corpus_format_get_name (format));
+    report_results (n_files);
+
+    g_assert_cmpuint (g_list_length (file_list), ==, n_files);
+    et_file_list_free (file_list);
+}
+
+/* A list of tagged files, in memory only, for the tests below. */
+static GList *
+create_tagged_list (void)
+{
+    GList *file_list;
+
+    file_list = create_files (ET_CORPUS_FORMAT_MONKEYS_AUDIO, "list",
+                              n_files);
+    set_tags (file_list);
+
+    return file_list;
+}
+
+static void
+tag_io_sort (void)
+{
+    static const GCompareFunc sorts[] =
+    {
+        (GCompareFunc)ET_Comp_Func_Sort_File_By_Ascending_Artist,
+        (GCompareFunc)ET_Comp_Func_Sort_File_By_Ascending_Album,
+        (GCompareFunc)ET_Comp_Func_Sort_File_By_Ascending_Title,
+        (GCompareFunc)ET_Comp_Func_Sort_File_By_Ascending_Track_Number,
+        (GCompareFunc)ET_Comp_Func_Sort_File_By_Ascending_Year,
+        (GCompareFunc)ET_Comp_Func_Sort_File_By_Ascending_Filename
+    };
+    GList *file_list;
+    gsize i;
+
+    file_list = create_tagged_list ();
+
+    /* ET_Sort_File_List() also updates the browser, so the comparison
+     * functions are used directly. */
+    g_test_timer_start ();
+
+    for (i = 0; i < G_N_ELEMENTS (sorts); i++)
+    {
+        file_list = g_list_sort (file_list, sorts[i]);
+    }
+
+    report_results (n_files * G_N_ELEMENTS (sorts));
+
+    et_file_list_free (file_list);
+}
+
+static void
+tag_io_group (void)
+{
+    GList *file_list;
+    GList *artist_list;
+    GList *l;
+
+    file_list = create_tagged_list ();
+
+    g_test_timer_start ();
+    artist_list = et_artist_album_list_new_from_file_list (file_list);
+    report_results (n_files);
+
+    g_assert_cmpuint (g_list_length (artist_list), ==, MIN (n_files, 50));
+
+    /* et_artist_album_file_list_free() also clears the browser. */
+    for (l = artist_list; l != NULL; l = g_list_next (l))
+    {
+        g_list_free_full (l->data, (GDestroyNotify)g_list_free);
+    }
+
+    g_list_free (artist_list);
+    et_file_list_free (file_list);
+}
+
+static void
+tag_io_search (void)
+{
+    static const gchar * const strings[] = { "artist 7", "title 1",
+                                             "album:\"album 12\"", "rock",
+                                             "zzz" };
+    GList *file_list;
+    EtSearchIndex *search_index;
+    gsize i;
+
+    file_list = create_tagged_list ();
+    search_index = et_search_index_new ();
+
+    g_test_timer_start ();
+    et_search_index_sync_file_list (search_index, file_list);
+
+    for (i = 0; i < G_N_ELEMENTS (strings); i++)
+    {
+        EtSearchQuery *query;
+        GError *error = NULL;
+
+        query = et_search_query_new (strings[i], ET_SEARCH_FIELD_MASK_ALL,
+                                     FALSE, &error);
+        g_assert_no_error (error);
+        g_array_unref (et_search_index_query (search_index, query));
+        et_search_query_free (query);
+    }
+
+    /* Indexing, then one pass over the index per query. */
+    report_results (n_files * (1 + G_N_ELEMENTS (strings)));
+
+    et_search_index_unref (search_index);
+    et_file_list_free (file_list);
+}
+
+static void
+tag_io_scan (void)
+{
+    GList *file_list;
+    GList *l;
+    const File_Tag *FileTag;
+
+    file_list = create_files (ET_CORPUS_FORMAT_MONKEYS_AUDIO, "scan",
+                              n_files);
+
+    g_test_timer_start ();
+
+    for (l = file_list; l != NULL; l = g_list_next (l))
+    {
+        et_scan_tag_with_mask (l->data, CORPUS_SCAN_MASK);
+    }
+
+    report_results (n_files);
+
+    FileTag = ((ET_File *)file_list->data)->FileTag->data;
+    g_assert_cmpstr (FileTag->artist, ==, "Artist 0");
+    g_assert_cmpstr (FileTag->title, ==, "Title 0");
+
+    et_file_list_free (file_list);
+}
+
+int
+main (int argc, char** argv)
+{
+    GOptionContext *context;
+    gchar *tmp_path = NULL;
+    gchar *config_path;
+    gint format;
+    gint status;
+    GError *error = NULL;
+
+    /* Keep the log and settings of the user out of the benchmark. */
+    config_path = g_dir_make_tmp ("easytag-tag-io-config-XXXXXX", &error);
+    g_assert_no_error (error);
+    g_setenv ("XDG_CONFIG_HOME", config_path, TRUE);
+    g_setenv ("GSETTINGS_BACKEND", "memory", TRUE);
+    g_setenv ("GSETTINGS_SCHEMA_DIR", TEST_SCHEMA_DIR, TRUE);
+
+    g_test_init (&argc, &argv, NULL);
+
+    context = g_option_context_new (NULL);
+    g_option_context_add_main_entries (context, entries, NULL);
+
+    if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+        g_printerr ("%s\n", error->message);
+        return 1;
+    }
+
+    g_option_context_free (context);
+
+    if (n_files < 1 || tag_size < 0 || picture_size < 0)
+    {
+        g_printerr ("Invalid corpus size\n");
+        return 1;
+    }
+
+    if (corpus_dir == NULL)
+    {
+        tmp_path = g_dir_make_tmp ("easytag-tag-io-XXXXXX", &error);
+        g_assert_no_error (error);
+        corpus_dir = g_strdup (tmp_path);
+    }
+
+    Init_Config_Variables ();
+
+    for (format = 0; format < ET_CORPUS_FORMAT_COUNT; format++)
+    {
+        gchar *path;
+
+        if (!et_corpus_format_is_supported (format))
+        {
+            continue;
+        }
+
+        path = g_strconcat ("/tag_io/round_trip/",
+                            et_corpus_format_get_name (format), NULL);
+        g_test_add_data_func (path, GINT_TO_POINTER (format),
+                              tag_io_round_trip);
+        g_free (path);
+    }
+
+    if (g_test_perf ())
+    {
+        for (format = 0; format < ET_CORPUS_FORMAT_COUNT; format++)
+        {
+            gchar *path;
+
+            if (!et_corpus_format_is_supported (format))
+            {
+                continue;
+            }
+
+            path = g_strconcat ("/tag_io/write/",
+                                et_corpus_format_get_name (format), NULL);
+            g_test_add_data_func (path, GINT_TO_POINTER (format),
+                                  tag_io_write);
+            g_free (path);
+
+            path = g_strconcat ("/tag_io/read/",
+                                et_corpus_format_get_name (format), NULL);
+            g_test_add_data_func (path, GINT_TO_POINTER (format),
+                                  tag_io_read);
+            g_free (path);
+        }
+
+        g_test_add_func ("/tag_io/sort", tag_io_sort);
+        g_test_add_func ("/tag_io/group", tag_io_group);
+        g_test_add_func ("/tag_io/search", tag_io_search);
+        g_test_add_func ("/tag_io/scan", tag_io_scan);
+    }
+
+    status = g_test_run ();
+
+    if (tmp_path)
+    {
+        et_corpus_remove_recursive (tmp_path);
+        g_free (tmp_path);
+    }
+
+    et_corpus_remove_recursive (config_path);
+    g_free (config_path);
+    g_free (corpus_dir);
+
+    return status;
+}
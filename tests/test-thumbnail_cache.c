@@ -0,0 +1,196 @@
+/* EasyTAG - tag editor for audio files
+ * Copyright (C) 2026  EasyTAG contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "thumbnail_cache.h"
+#include "setting.h"
+
+#include <gtk/gtk.h>
+
+GtkWidget *MainWindow;
+GSettings *MainSettings;
+
+/* Create a picture of a PNG image of @width by @height. */
+static EtPicture *
+create_picture (gint width,
+                gint height)
+{
+    GdkPixbuf *pixbuf;
+    gchar *buffer;
+    gsize buffer_size;
+    GBytes *bytes;
+    EtPicture *pic;
+    GError *error = NULL;
+
+    pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, width, height);
+    gdk_pixbuf_fill (pixbuf, 0x336699ff);
+    gdk_pixbuf_save_to_buffer (pixbuf, &buffer, &buffer_size, "png", &error,
+                               NULL);
+    g_assert_no_error (error);
+    g_object_unref (pixbuf);
+
+    bytes = g_bytes_new_take (buffer, buffer_size);
+    pic = et_picture_new (ET_PICTURE_TYPE_FRONT_COVER, "", 0, 0, bytes);
+    g_bytes_unref (bytes);
+
+    return pic;
+}
+
+static void
+on_load (GObject *source_object,
+         GAsyncResult *result,
+         gpointer user_data)
+{
+    GAsyncResult **load_result = user_data;
+
+    *load_result = g_object_ref (result);
+}
+
+static GdkPixbuf *
+load_thumbnail (EtThumbnailCache *cache,
+                const EtPicture *pic,
+                gint size)
+{
+    GAsyncResult *result = NULL;
+    GdkPixbuf *thumbnail;
+    GError *error = NULL;
+
+    et_thumbnail_cache_load_async (cache, pic, size, NULL, on_load, &result);
+
+    while (result == NULL)
+    {
+        g_main_context_iteration (NULL, TRUE);
+    }
+
+    thumbnail = et_thumbnail_cache_load_finish (cache, result, &error);
+    g_assert_no_error (error);
+    g_object_unref (result);
+
+    return thumbnail;
+}
+
+static void
+thumbnail_cache_image_size (void)
+{
+    EtPicture *pic;
+    GBytes *bytes;
+    gint width;
+    gint height;
+    GError *error = NULL;
+
+    pic = create_picture (200, 100);
+
+    g_assert_true (et_thumbnail_get_image_size (pic->bytes, &width, &height,
+                                                &error));
+    g_assert_no_error (error);
+    g_assert_cmpint (width, ==, 200);
+    g_assert_cmpint (height, ==, 100);
+
+    et_picture_free (pic);
+
+    bytes = g_bytes_new_static ("\x89PNG\x0d\x0a\x1a\x0a", 8);
+    g_assert_false (et_thumbnail_get_image_size (bytes, &width, &height,
+                                                 &error));
+    g_assert (error != NULL);
+    g_clear_error (&error);
+    g_bytes_unref (bytes);
+}
+
+static void
+thumbnail_cache_load (void)
+{
+    EtThumbnailCache *cache;
+    EtPicture *pic;
+    GdkPixbuf *thumbnail;
+    gint width = 0;
+    gint height = 0;
+
+    cache = et_thumbnail_cache_new (1024 * 1024);
+    pic = create_picture (200, 100);
+
+    g_assert (et_thumbnail_cache_lookup (cache, pic, 96, &width,
+                                         &height) == NULL);
+
+    thumbnail = load_thumbnail (cache, pic, 96);
+    g_assert_cmpint (gdk_pixbuf_get_width (thumbnail), ==, 96);
+    g_assert_cmpint (gdk_pixbuf_get_height (thumbnail), ==, 48);
+    g_object_unref (thumbnail);
+
+    thumbnail = et_thumbnail_cache_lookup (cache, pic, 96, &width, &height);
+    g_assert (thumbnail != NULL);
+    g_assert_cmpint (width, ==, 200);
+    g_assert_cmpint (height, ==, 100);
+    g_assert_cmpint (gdk_pixbuf_get_width (thumbnail), ==, 96);
+    g_object_unref (thumbnail);
+
+    /* Thumbnails of another size are cached separately. */
+    g_assert (et_thumbnail_cache_lookup (cache, pic, 192, &width,
+                                         &height) == NULL);
+
+    /* The cache keeps the image data, which is compared with that of a
+     * picture read again. */
+    et_picture_free (pic);
+    pic = create_picture (200, 100);
+    thumbnail = et_thumbnail_cache_lookup (cache, pic, 96, &width, &height);
+    g_assert (thumbnail != NULL);
+    g_object_unref (thumbnail);
+
+    et_picture_free (pic);
+    et_thumbnail_cache_free (cache);
+}
+
+static void
+thumbnail_cache_evict (void)
+{
+    EtThumbnailCache *cache;
+    EtPicture *pic1;
+    EtPicture *pic2;
+    GdkPixbuf *thumbnail;
+    gint width;
+    gint height;
+
+    /* Room for a single 96×96 RGB thumbnail. */
+    cache = et_thumbnail_cache_new (96 * 96 * 3 + 96 * 3);
+    pic1 = create_picture (100, 100);
+    pic2 = create_picture (120, 120);
+
+    g_object_unref (load_thumbnail (cache, pic1, 96));
+    g_object_unref (load_thumbnail (cache, pic2, 96));
+
+    g_assert (et_thumbnail_cache_lookup (cache, pic1, 96, &width,
+                                         &height) == NULL);
+    thumbnail = et_thumbnail_cache_lookup (cache, pic2, 96, &width, &height);
+    g_assert (thumbnail != NULL);
+    g_object_unref (thumbnail);
+
+    et_picture_free (pic2);
+    et_picture_free (pic1);
+    et_thumbnail_cache_free (cache);
+}
+
+int
+main (int argc, char** argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/thumbnail_cache/evict", thumbnail_cache_evict);
+    g_test_add_func ("/thumbnail_cache/image-size",
+                     thumbnail_cache_image_size);
+    g_test_add_func ("/thumbnail_cache/load", thumbnail_cache_load);
+
+    return g_test_run ();
+}